@@ -1,11 +1,19 @@
 #pragma once
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <atomic>
 
 #include "button_manager.h"
 #include "camera_config.h"
+#include "capture_pipeline.h"
 #include "display.h"
 #include "pixel_filter.h"
+#include "pxlcam_config.h"
 #include "storage.h"
 
 namespace pxlcam {
@@ -23,12 +31,62 @@ enum class AppState {
     Error
 };
 
+/// What wakes the controller; posted by the input and shot tasks
+enum class AppEvent : uint8_t {
+    Button,         ///< Press released: arg is the ButtonEvent, atUs the press
+    Hold,           ///< Still held past the preview threshold (once per press)
+    ShotDone,       ///< The shot task finished the requested capture
+    BurstProgress,  ///< Burst grab: arg is grabbed << 8 | total
+};
+
+struct AppMessage {
+    AppEvent event;
+    uint16_t arg;
+    uint32_t modal;     ///< Modal screens opened before it was posted (stale if behind)
+    int64_t atUs;       ///< esp_timer_get_time() clock
+};
+
+/**
+ * Event-driven controller. With PXLCAM_APP_TASKS each subsystem has a task:
+ *
+ *   app_input  samples the button every PXLCAM_INPUT_POLL_MS, posts events
+ *   app_shot   runs the capture call itself, so the progress screen is
+ *              drawn while the frame is taken instead of before it
+ *   app_net    services the WiFi server every PXLCAM_NET_POLL_MS, also
+ *              while a menu or the preview holds the controller
+ *   sd_writer  (storage.h) writes queued images; completions come back
+ *              through storage::pollWrites() on the controller
+ *
+ * tick() (Arduino loop task) waits on the event queue, at most
+ * PXLCAM_APP_TICK_MS, then applies the event, the timelapse and power
+ * decisions and one step of the AppState machine. Modal screens (menus,
+ * preview) still block the controller and read the pin themselves; input
+ * sampled around them is dropped.
+ */
 class AppController {
    public:
     void begin();
     void tick();
 
    private:
+    // Tasks and events
+    void startTasks();
+    bool postEvent(AppEvent event, uint16_t arg, int64_t atUs, TickType_t wait);
+    TickType_t waitTicks(uint32_t nowMs) const;
+    void handleEvent(const AppMessage &msg);
+    ButtonEvent takeButton();
+    void beginModal();
+    void endModal();
+    void pollInput(uint32_t nowMs);
+    static void inputTask(void *arg);
+    static void shotTask(void *arg);
+    static void netTask(void *arg);
+    static void onBurstProgress(uint8_t grabbed, uint8_t total, void *user);  // capture::BurstProgress
+    bool serviceTimelapse(uint32_t nowMs);
+    void serviceWifi();
+    void takeShot();
+    void finishShot();
+
     void transitionTo(AppState nextState);
     void enterError(const char *message);
     void showStatus(const char *message, bool clear = true);
@@ -42,12 +100,16 @@ class AppController {
     void handleCapture(uint32_t nowMs);
     void handleFilter();
     void handleSave();
+    static void onSaveComplete(const char *path, bool ok, void *user);  // storage::WriteCallback
+    void finishSave(const char *path, bool ok);
     void handleFeedback(uint32_t nowMs);
     void handleError();
     
     // v1.3.0: Timelapse handling
     void handleTimelapseMenu();
     void updateTimelapseDisplay();
+    bool saveTimelapseFrame();
+    void sleepUntilNextFrame(uint32_t sleepMs);  // Deep-sleep timelapse: never returns
     
     // v1.3.0: WiFi Preview handling
     void handleWifiMenu();
@@ -65,7 +127,7 @@ class AppController {
     CameraPins cameraPins_{};
     CameraSettings cameraSettings_{};
     display::DisplayConfig displayConfig_{128, 64, 0, -1, 0x3C, 14, 15, 400000};
-    storage::StorageConfig storageConfig_{"/sdcard", 0, true};
+    storage::StorageConfig storageConfig_{"/sdcard", 0, true, PXLCAM_SD_PROBE_BUS != 0, PXLCAM_SD_ALLOW_4BIT != 0, false};
     filter::FilterConfig filterConfig_{true, 8, 0};
 
     camera_fb_t *activeFrame_ = nullptr;
@@ -78,11 +140,15 @@ class AppController {
     uint32_t startupGuardExpiryMs_ = 0;
     uint32_t feedbackExpiryMs_ = 0;
     bool feedbackShown_ = false;
-    uint32_t fileCounter_ = 0;
 
     uint32_t captureDurationMs_ = 0;
     uint32_t filterDurationMs_ = 0;
     uint32_t saveDurationMs_ = 0;
+    int64_t shutterUs_ = 0;   ///< Button press behind the pending capture (0 = now)
+    uint8_t savesPending_ = 0;  ///< Images queued to the SD writer, not yet reported
+    bool deepSleepWake_ = false;  ///< Booted to continue a deep-sleep timelapse (fast boot, display off)
+    uint32_t bootCaptureMs_ = 0;  ///< Fast boot: millis() at its capture, until the frame is saved
+    bool burstGrabbed_ = false;  ///< Burst run: frames are in the ring, being developed
 
     char lastMessage_[64] = {0};
     
@@ -90,9 +156,29 @@ class AppController {
     uint8_t* processedImageData_ = nullptr;
     size_t processedImageLen_ = 0;
     const char* processedExtension_ = "raw";
+    const uint8_t* processedThumbnail_ = nullptr;  ///< Sidecar thumbnail, nullptr if none
+    uint16_t processedWidth_ = 0;
+    uint16_t processedHeight_ = 0;
     
-    // v1.3.0: WiFi Preview state
+    // v1.3.0: WiFi Preview state (under netLock_ once app_net runs)
     bool wifiPreviewActive_ = false;
+    
+    // Tasks and events (PXLCAM_APP_TASKS)
+    QueueHandle_t events_ = nullptr;
+    TaskHandle_t shotTask_ = nullptr;
+    SemaphoreHandle_t netLock_ = nullptr;
+    bool inputTaskRunning_ = false;
+    std::atomic<uint32_t> modalCount_{0};   ///< beginModal() calls; input inside one is dropped
+    std::atomic<bool> modalOpen_{false};
+    uint32_t inputModalSeen_ = 0;           ///< Input task: modalCount_ its button was last reset at
+    bool holdPosted_ = false;               ///< Input task: Hold sent for this press
+    ButtonEvent pendingButton_ = ButtonEvent::None;  ///< Latest press, taken like ButtonManager's
+    int64_t pendingPressUs_ = 0;
+    bool pendingHold_ = false;
+    bool shotBusy_ = false;                 ///< Capture requested, ShotDone not handled yet
+    bool shotDone_ = false;
+    uint32_t shotStartMs_ = 0;
+    pxlcam::capture::CaptureResult shotResult_ = pxlcam::capture::CaptureResult::Success;
 };
 
 }  // namespace pxlcam
@@ -0,0 +1,77 @@
+#pragma once
+/**
+ * @file button_irq.h
+ * @brief GPIO-interrupt button driver: timestamped, debounced edges
+ *
+ * An ANYEDGE interrupt on the button pin stamps each edge with
+ * esp_timer_get_time(). The first edge that changes the debounced level is
+ * a transition: it goes into the edge queue at once, with its interrupt
+ * time, and starts a lockout timer of the debounce length. Edges inside
+ * the lockout are contact bounce; when it ends the pin is read again and a
+ * level that changed under it is reported (stamped with its last edge)
+ * and locks out again.
+ *
+ * A press is therefore known the moment the contact closes, whatever the
+ * loop is doing, and its timestamp is on the same clock as the camera's
+ * frame stamps (zero shutter lag). Nothing polls: the input task blocks
+ * on wait().
+ *
+ * armWake()/disarmWake() make the pin a light-sleep wake source around
+ * esp_light_sleep_start(). The edge interrupt is off meanwhile (a level
+ * interrupt would fire without end once awake); disarmWake() reports the
+ * press that woke the chip.
+ *
+ * ButtonManager reads these edges when PXLCAM_BUTTON_IRQ is set and begin()
+ * succeeds, and samples the pin as before otherwise.
+ */
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include "pxlcam_config.h"
+
+namespace pxlcam::input {
+
+/// A debounced transition
+struct Edge {
+    int64_t atUs;       ///< Interrupt time (esp_timer_get_time())
+    bool pressed;       ///< True for press, false for release
+};
+
+/// Install the interrupt and the lockout timer (the pin is already configured)
+/// @return false if the driver could not start (callers poll the pin instead)
+bool begin(gpio_num_t pin, uint8_t activeLevel, uint32_t debounceMs);
+
+bool isActive();
+
+/// Debounced level, updated from the interrupt
+bool isPressed();
+
+/// Take the oldest transition
+/// @return false if none is waiting
+bool next(Edge& edge);
+
+/// Block until a transition is waiting (it is left in the queue)
+/// @return false on timeout
+bool wait(TickType_t ticks);
+
+/// Drop every waiting transition
+void flush();
+
+/// Make the pin wake the chip from light sleep (PXLCAM_BUTTON_WAKE)
+/// @return false if not armed (driver off, or the button is held)
+bool armWake();
+
+/// Back to edge interrupts after esp_light_sleep_start() returns
+void disarmWake();
+
+struct Stats {
+    uint32_t rawEdges;      ///< Interrupts, bounces included
+    uint32_t transitions;   ///< Edges queued
+    uint32_t dropped;       ///< Transitions lost to a full queue
+};
+
+Stats getStats();
+
+}  // namespace pxlcam::input
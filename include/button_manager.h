@@ -12,7 +12,8 @@ enum class ButtonEvent : uint8_t {
     VeryLongPress   ///< >= 2000ms hold (menu/mode cycle)
 };
 
-// Simple GPIO button handler with software debounce.
+// Simple GPIO button handler with software debounce, or the interrupt
+// driver's edges (button_irq.h) with PXLCAM_BUTTON_IRQ.
 // Note: avoid holding the capture button during boot (GPIO12 is a strapping pin).
 class ButtonManager {
    public:
@@ -38,15 +39,34 @@ class ButtonManager {
     
     /// Get current hold duration in ms (0 if not held)
     uint32_t getHoldDuration() const;
+    
+    /// Get time (millis()) the most recent press was latched
+    uint32_t getLastPressMs() const { return lastPressMs_; }
+    
+    /// Same press on the esp_timer clock (the interrupt's stamp when edges
+    /// come from button_irq.h): what the zero-shutter-lag ring matches
+    int64_t getLastPressUs() const { return lastPressUs_; }
+    
+    /// Forget the press in progress and any pending event
+    /// For input a modal screen read from the pin itself: a button still
+    /// down is latched without an event, so its release reports nothing.
+    void discard(uint32_t nowMs);
 
    private:
+    void latchPress(uint32_t atMs, int64_t atUs);
+    void latchRelease(uint32_t atMs);
+    
     gpio_num_t pin_;
     uint8_t activeLevel_;
     uint32_t debounceMs_;
     bool latched_ = false;
     bool pendingPress_ = false;
+    bool ignoreRelease_ = false;  ///< Latched by discard(), not by a press
+    bool irq_ = false;            ///< Edges from button_irq.h instead of sampling
     uint32_t lastTransitionMs_ = 0;
     uint32_t pressStartMs_ = 0;
+    uint32_t lastPressMs_ = 0;
+    int64_t lastPressUs_ = 0;
     ButtonEvent pendingEvent_ = ButtonEvent::None;
 };
 
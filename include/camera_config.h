@@ -2,6 +2,9 @@
 
 #include <driver/gpio.h>
 #include <esp_camera.h>
+#include <stddef.h>
+
+#include "luma_extract.h"
 
 namespace pxlcam {
 
@@ -37,12 +40,72 @@ struct CameraSettings {
     bool enableLedFlash;
 };
 
+// Byte distance between Y samples for formats whose luma can be read raw
+// (GRAYSCALE, YUV422); 0 for formats that need decoding or conversion.
+inline size_t lumaSampleStep(pixformat_t format) {
+    switch (format) {
+        case PIXFORMAT_GRAYSCALE: return luma::kGrayscaleStep;
+        case PIXFORMAT_YUV422:    return luma::kYuv422Step;
+        default:                  return 0;
+    }
+}
+
 CameraPins makeDefaultPins();
 CameraSettings makeDefaultSettings();
 camera_config_t buildCameraConfig(const CameraPins &pins, const CameraSettings &settings);
 bool initCamera(const CameraPins &pins, const CameraSettings &settings);
 camera_fb_t *captureFrame();
 void releaseFrame(camera_fb_t *frame);
+
+// Change sensor resolution at runtime. Only sizes up to the one used at
+// initCamera() fit the driver's frame buffers. Frames already queued with the
+// old size are drained (settleFrames).
+bool setFrameSize(framesize_t frameSize, uint8_t settleFrames = 2);
 void shutdownCamera();
 
+// Camera modes: geometry and JPEG quality precomputed at initCamera(). Every
+// mode shares the driver's frame buffers, so a switch is set_framesize()
+// (and set_quality() for JPEG), never esp_camera_deinit(); the pixel format
+// is the one the driver was initialized with.
+enum class CameraMode : uint8_t {
+    Capture = 0,    // initCamera() framesize and quality
+    Preview,        // PXLCAM_PREVIEW_SENSOR_FRAMESIZE, PXLCAM_PREVIEW_JPEG_QUALITY
+    Count
+};
+
+struct CameraModeProfile {
+    framesize_t frameSize;
+    pixformat_t pixelFormat;
+    uint8_t jpegQuality;    // 0 leaves the sensor's quality as it is
+};
+
+const CameraModeProfile &cameraModeProfile(CameraMode mode);
+
+// Switch to a mode; a no-op if the sensor already runs its settings. Only
+// the frames the sensor started before the switch are dropped (at most
+// PXLCAM_CAMERA_MODE_FLUSH_MAX). Call with no other task reading frames.
+bool setCameraMode(CameraMode mode);
+
+// Mode last switched to; Count after setFrameSize() or before initCamera()
+CameraMode getCameraMode();
+
+struct CameraModeStats {
+    uint32_t switches;      // setCameraMode() calls that changed the sensor
+    uint32_t lastSwitchUs;  // Register writes to the first frame in the new mode
+    uint32_t maxSwitchUs;
+    uint32_t framesDropped; // Stale frames flushed, all switches
+    uint8_t lastDropped;
+};
+
+CameraModeStats getCameraModeStats();
+
+// Keep the sensor powered down through a deep sleep: PWDN is driven high and
+// latched. initCamera() releases the latch.
+void holdCameraPowerDown(const CameraPins &pins);
+
+// PWDN standby with the driver still initialized (light sleep): the sensor
+// stops streaming and keeps its registers. Frames queued before standby are
+// stale afterwards.
+void setCameraStandby(const CameraPins &pins, bool standby);
+
 }  // namespace pxlcam
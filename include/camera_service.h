@@ -0,0 +1,105 @@
+#pragma once
+/**
+ * @file camera_service.h
+ * @brief One owner of camera readouts, shared by every frame consumer
+ *
+ * Preview, the WiFi stream and still, the capture paths, the ZSL ring and
+ * the motion watch each used to call esp_camera_fb_get() on their own and
+ * hold the buffer for as long as their work took. With two frame buffers
+ * and CAMERA_GRAB_LATEST they starved each other, and two features running
+ * at once read the sensor twice.
+ *
+ * The service task is now the only reader. A consumer registers once,
+ * saying what it needs, and calls acquire() when it wants a frame. Each
+ * readout goes to every consumer waiting at that moment. Frames are
+ * reference counted and the buffer returns to the driver once the last
+ * consumer calls release(). Nothing is read while nobody waits, so the
+ * driver's buffers stay free to refill.
+ *
+ *   Latest    the next frame read, or one read moments ago
+ *             (PXLCAM_FRAME_SHARE_MS) that another consumer still holds
+ *             and this one has not seen
+ *   EveryNth  every Nth frame read while it waits (a frame-rate divider)
+ *   NextFull  the next frame read at the capture framesize. If the sensor
+ *             is in another mode, the service switches for that frame and
+ *             switches back afterwards (setCameraMode())
+ *
+ * Latest and EveryNth frames come at whatever size the sensor is set to
+ * (a preview, motion watch or capture mode), but never one read during a
+ * switch for NextFull: those consumers wait until the sensor is back.
+ *
+ * One task at a time acquires through a consumer; a second one waits for
+ * the first acquire() to return. Without the service (PXLCAM_CAMERA_SERVICE
+ * 0, or before begin()) acquire() reads the driver directly.
+ *
+ * Exclusive readers (exposure warm-up and tuning, benchmark, bring-up, the
+ * framesize and mode-switch flushes) read the driver themselves inside a
+ * Pause: the service finishes the readout under way and reads nothing
+ * until the last Pause ends. Consumers keep waiting meanwhile.
+ */
+
+#include <esp_camera.h>
+#include <stdint.h>
+
+#include "pxlcam_config.h"
+
+namespace pxlcam::frames {
+
+enum class Need : uint8_t {
+    Latest = 0,
+    EveryNth,
+    NextFull
+};
+
+using ConsumerId = int8_t;
+constexpr ConsumerId kNoConsumer = -1;
+
+/// Start the service task (the camera may be initialized later)
+/// @return false if it could not start; acquire() then reads directly
+bool begin();
+
+/// @param everyN Frames per delivery for Need::EveryNth (1 = all)
+/// @return kNoConsumer when PXLCAM_FRAME_CONSUMERS are registered
+ConsumerId registerConsumer(const char* name, Need need, uint8_t everyN = 1);
+
+/// Not while it is inside acquire()
+void unregisterConsumer(ConsumerId id);
+
+/// Wait for a frame for this consumer
+/// @return nullptr on timeout or camera error; otherwise release() it
+camera_fb_t* acquire(ConsumerId id, uint32_t timeoutMs = PXLCAM_FRAME_WAIT_MS);
+
+/// Drop this consumer's reference; the last one returns the buffer
+void release(camera_fb_t* fb);
+
+/// Stop the service reading the driver (nests); returns once it has
+/// stopped. A no-op on the service task itself
+void pause();
+void resume();
+
+/// pause() for the life of a scope around direct esp_camera_fb_get() calls
+class Pause {
+   public:
+    Pause() { pause(); }
+    ~Pause() { resume(); }
+    Pause(const Pause&) = delete;
+    Pause& operator=(const Pause&) = delete;
+};
+
+struct Stats {
+    uint32_t reads;         ///< Sensor readouts
+    uint32_t deliveries;    ///< Frames handed to consumers (reads shared count more than once)
+    uint32_t shared;        ///< Deliveries beyond the first of a readout
+    uint32_t unused;        ///< Readouts nobody took (EveryNth skips, late waiters)
+    uint32_t failures;      ///< esp_camera_fb_get() returned nothing
+    uint32_t modeSwitches;  ///< Switches made for NextFull
+    uint8_t held;           ///< Frame buffers out with consumers now
+    uint8_t consumers;      ///< Registered
+};
+
+Stats getStats();
+
+/// One log line per consumer (frames taken and shared, wait)
+void logReport();
+
+}  // namespace pxlcam::frames
@@ -12,15 +12,42 @@
  * 3. Encode as BMP for easy viewing
  * 4. Return processed buffer ready for save
  * 
+ * Accepted camera formats: JPEG, RGB888, RGB565 (converted to luma row by
+ * row), and the native luma formats GRAYSCALE / YUV422 (Y read directly,
+ * no JPEG encode or decode).
+ * 
  * All heavy allocations use PSRAM when available.
+ * 
+ * With PXLCAM_CAPTURE_PIPELINED, steps 1 and 2 run as two FreeRTOS tasks
+ * pinned to different cores (grab/decode → filter/encode) connected by
+ * bounded queues, so consecutive captures overlap.
+ * 
+ * With PXLCAM_CAPTURE_ZSL, a background task keeps the latest frames already
+ * decoded to luma; captureZsl() only stylizes the one nearest the shutter.
+ * 
+ * Night captures average PXLCAM_NIGHT_STACK_FRAMES aligned frames
+ * (frame_stack.h) before the night tone curve.
+ * 
+ * With PXLCAM_CAPTURE_BURST, captureBurst() grabs a run of frames to luma at
+ * the sensor's rate; developBurstFrame() stylizes them one at a time later.
  */
 
 #include <stdint.h>
 #include <stddef.h>
 #include <esp_camera.h>
 
+#include "pxlcam_config.h"
 #include "mode_manager.h"
 
+#if PXLCAM_FEATURE_STYLIZED_CAPTURE
+// Forward declarations from filters namespace
+namespace pxlcam::filters {
+    enum class PaletteType : uint8_t;
+    enum class DitherAlgorithm : uint8_t;
+    struct DitherConfig;
+}
+#endif
+
 namespace pxlcam::capture {
 
 //==============================================================================
@@ -36,6 +63,49 @@ enum class CaptureResult : uint8_t {
     Cancelled
 };
 
+/// Output file format
+/// 
+/// Indexed formats store the 4 GameBoy tone indices directly (palette from
+/// palette_current()); they apply to GameBoy captures only, other modes fall
+/// back to Bmp8. With color output (palettes::setColorOutput()) the Bmp4 and
+/// PNG color tables hold the palette manager's colors instead, for the same
+/// indices and file size, and GameBoy Bmp8 captures are written as Bmp4.
+/// 
+/// .pxl layout (little endian, 16-byte header):
+///   0  char[4] "PXL2"      4  u16 width      6  u16 height
+///   8  u8 bitsPerPixel (2) 9  u8 toneCount (4)
+///  10  u8 tones[4] gray level per index (dark→light)
+///  14  u16 reserved
+///  16  rows of 4 px/byte, leftmost pixel in the top bits, rows byte-aligned
+/// 
+/// .png is a standard 2-bit indexed PNG (PLTE of the 4 tones or colors), deflated
+/// row by row during the capture pass (see png_indexed_writer.h).
+enum class OutputFormat : uint8_t {
+    Bmp8 = 0,   ///< 8-bit grayscale BMP, 256-entry palette (~76 KB QVGA)
+    Bmp4,       ///< 4-bit indexed BMP, 4-entry palette (~38 KB QVGA)
+    Pxl2,       ///< Raw 2-bit packed indices (~19 KB QVGA)
+    Png2,       ///< 2-bit indexed PNG (a few KB QVGA for dithered frames)
+    Count
+};
+
+/// Histogram bins in FrameStats (16 gray levels per bin)
+constexpr uint8_t kFrameStatsBins = 16;
+
+/// Luma statistics of a captured frame
+/// 
+/// Gathered on the source luma (before stylize) inside the capture's single
+/// pass over the frame, so no extra read of the image is needed.
+struct FrameStats {
+    uint32_t histogram[kFrameStatsBins];  ///< bin = luma >> 4
+    uint32_t pixels;        ///< Pixels counted
+    uint32_t lumaSum;       ///< Sum of luma (mean = lumaSum / pixels)
+    uint32_t clippedLow;    ///< Pixels at 0
+    uint32_t clippedHigh;   ///< Pixels at 255
+    uint8_t minLuma;
+    uint8_t maxLuma;
+    uint8_t meanLuma;
+};
+
 /// Processed image container
 struct ProcessedImage {
     uint8_t* data;          ///< Image data buffer (caller must NOT free - managed internally)
@@ -43,7 +113,43 @@ struct ProcessedImage {
     uint16_t width;         ///< Image width
     uint16_t height;        ///< Image height
     bool isProcessed;       ///< True if post-processing was applied
-    const char* extension;  ///< File extension ("bmp", "raw", "jpg")
+    const char* extension;  ///< File extension ("bmp", "pxl", "png", "raw", "jpg")
+    OutputFormat format;    ///< Encoding actually used for data
+    FrameStats stats;       ///< Source luma statistics
+    const uint8_t* thumbnail;   ///< 64x64 1-bit thumbnail, SSD1306 pages (thumbnail_index.h), or nullptr
+};
+
+/// Capture stages timed by the profiler
+enum class CaptureStage : uint8_t {
+    FbGet = 0,      ///< esp_camera_fb_get()
+    Decode,         ///< JPEG decode (includes the decoder's per-MCU luma conversion)
+    Gray,           ///< RGB888 / YUV422 → luma (and aligning/adding stacked Night frames)
+    PostProcess,    ///< Postprocess chain (filters/postprocess.h) on gray rows
+    Stylize,        ///< Dither / tone mapping, written straight into output rows
+    Encode,         ///< Output header, row clearing and BMP padding
+    Save,           ///< File write (SD)
+    Count
+};
+
+/// Per-stage duration of one capture in microseconds (esp_timer_get_time())
+/// 
+/// Single-pass paths interleave decode, gray and stylize per block/row;
+/// each stage is the sum of its own slices. Stages a frame skips stay 0.
+struct CaptureTimings {
+    uint32_t stageUs[static_cast<uint8_t>(CaptureStage::Count)];
+    uint32_t totalUs;       ///< Sum of all stages
+    
+    uint32_t& operator[](CaptureStage stage) { return stageUs[static_cast<uint8_t>(stage)]; }
+    uint32_t operator[](CaptureStage stage) const { return stageUs[static_cast<uint8_t>(stage)]; }
+};
+
+/// Rolling statistics for one stage over the last PXLCAM_CAPTURE_TIMING_WINDOW captures
+struct StageStats {
+    uint32_t minUs;
+    uint32_t avgUs;
+    uint32_t p95Us;
+    uint32_t lastUs;
+    uint16_t samples;       ///< Captures in the window (0 = no data)
 };
 
 //==============================================================================
@@ -68,10 +174,129 @@ CaptureResult captureFrame(ProcessedImage& outImage);
 /// @return Capture result status
 CaptureResult captureWithMode(pxlcam::mode::CaptureMode mode, ProcessedImage& outImage);
 
+/// Capture with specific mode and output format override
+/// @param mode Mode to use for this capture
+/// @param format Output format for this capture (see OutputFormat)
+/// @param outImage Output image container
+/// @return Capture result status
+CaptureResult captureWithMode(pxlcam::mode::CaptureMode mode, OutputFormat format,
+                              ProcessedImage& outImage);
+
+/// Capture at full sensor resolution and stream the result to a file
+/// 
+/// The frame is decoded, stylized and written in strips of PXLCAM_STRIP_ROWS
+/// rows, so the working set is one strip (~26 KB at UXGA) no matter the
+/// resolution: bigger frames cost time, not memory. Frames up to
+/// PXLCAM_STRIP_MAX_WIDTH x PXLCAM_STRIP_MAX_HEIGHT are accepted.
+/// Requires storage::initSD(). Bypasses the pipeline tasks.
+/// @param mode Mode to use for this capture
+/// @param format Output format (indexed formats apply to GameBoy only)
+/// @param path Destination file path
+/// @param outLength Bytes written (may be nullptr)
+/// @param outThumbnail Set to the thumbnail pages, valid until the next
+///        capture, or nullptr when there is none (may be nullptr)
+/// @return Capture result status
+CaptureResult captureToFile(pxlcam::mode::CaptureMode mode, OutputFormat format,
+                            const char* path, size_t* outLength = nullptr,
+                            const uint8_t** outThumbnail = nullptr);
+
 /// Release internal buffers after save is complete
 /// Must be called after each captureFrame() to free resources
 void releaseFrame();
 
+//==============================================================================
+// Pipelined Capture API
+//==============================================================================
+
+#if PXLCAM_CAPTURE_PIPELINED
+
+/// Check if the producer/consumer capture tasks are running
+/// @return true if captureFrame() is served by the pipeline
+bool isPipelineRunning();
+
+/// Queue captures ahead of time (burst / timelapse)
+/// 
+/// The producer starts grabbing immediately and runs ahead of the caller by
+/// up to PXLCAM_CAPTURE_QUEUE_DEPTH frames. Collect results, in order, with
+/// captureFrame()/captureWithMode() followed by releaseFrame(). The mode and
+/// output format are fixed at queue time; those passed when collecting are
+/// ignored.
+/// @param mode Mode to process these frames with
+/// @param count Number of frames to queue
+/// @return Number of captures actually queued
+uint8_t queueCaptures(pxlcam::mode::CaptureMode mode, uint8_t count);
+
+/// Get number of queued captures not yet collected
+uint8_t getPendingCaptures();
+
+#endif // PXLCAM_CAPTURE_PIPELINED
+
+//==============================================================================
+// Zero-Shutter-Lag API
+//==============================================================================
+
+#if PXLCAM_CAPTURE_ZSL
+
+/// Check if the ZSL ring filler is running
+bool isZslRunning();
+
+/// Pause or resume refilling the ring
+/// Ring frames older than PXLCAM_ZSL_MAX_AGE_MS are never served, so
+/// resuming needs no flush.
+void setZslArmed(bool armed);
+
+/// Get number of decoded frames currently in the ring
+uint8_t getZslFrameCount();
+
+/// Stylize the ring frame closest to the shutter press
+/// 
+/// Falls back to captureWithMode() when the ring is not running or holds no
+/// frame within PXLCAM_ZSL_MAX_AGE_MS of pressUs. Call releaseFrame() after
+/// saving, as with captureFrame().
+/// @param mode Mode to use for this capture
+/// @param pressUs Shutter press time (esp_timer_get_time() base)
+/// @param outImage Output image container
+/// @return Capture result status
+CaptureResult captureZsl(pxlcam::mode::CaptureMode mode, int64_t pressUs, ProcessedImage& outImage);
+
+#endif // PXLCAM_CAPTURE_ZSL
+
+//==============================================================================
+// Burst API
+//==============================================================================
+
+#if PXLCAM_CAPTURE_BURST && !PXLCAM_STRIP_CAPTURE
+
+/// Called after every grab attempt of a burst, on the capturing task
+using BurstProgress = void (*)(uint8_t grabbed, uint8_t total, void* user);
+
+/// Grab a burst into the luma ring
+/// 
+/// Frames are only decoded to luma while grabbing, so the rate is the
+/// sensor's; stylize and encode wait for developBurstFrame(). The ring is
+/// allocated here and held until releaseBurst() (an earlier burst is
+/// dropped). Blocks until the burst is over.
+/// @param count Frames to grab (at most PXLCAM_BURST_DEPTH)
+/// @param intervalMs Spacing from the first frame (0 = back to back)
+/// @param progress Optional progress callback
+/// @return Frames grabbed (0 on failure: nothing is held)
+uint8_t captureBurst(uint8_t count, uint16_t intervalMs, BurstProgress progress, void* user);
+
+/// Get number of grabbed burst frames not yet developed
+uint8_t getBurstPending();
+
+/// Stylize and encode the oldest undeveloped burst frame
+/// Call releaseFrame() after saving, as with captureFrame().
+/// @param mode Mode to use for this frame
+/// @param outImage Output image container
+/// @return Capture result status (CameraError when none is pending)
+CaptureResult developBurstFrame(pxlcam::mode::CaptureMode mode, ProcessedImage& outImage);
+
+/// Free the burst ring (pending frames are dropped)
+void releaseBurst();
+
+#endif // PXLCAM_CAPTURE_BURST
+
 //==============================================================================
 // Filter API
 //==============================================================================
@@ -117,11 +342,38 @@ bool encodeGrayscaleBmp(const uint8_t* gray, int w, int h,
 /// @return Required buffer size in bytes
 size_t getBmpSize(int w, int h);
 
+//==============================================================================
+// Output Format
+//==============================================================================
+
+/// Set default output format for captureFrame()/captureWithMode(mode, ...)
+void setOutputFormat(OutputFormat format);
+
+/// Get default output format
+OutputFormat getOutputFormat();
+
+/// Set the pixel-art block size of JPEG captures (PXLCAM_CAPTURE_PIXEL_BLOCK)
+/// @param block 2, 4 or 8; 1 (or any other size) = no pixelation
+void setPixelBlock(uint8_t block);
+
+/// Get the pixel-art block size
+uint8_t getPixelBlock();
+
+/// Get format a capture in this mode will actually use (Bmp8 unless GameBoy)
+OutputFormat getEffectiveOutputFormat(pxlcam::mode::CaptureMode mode);
+
+/// Get file extension for format ("bmp", "pxl" or "png")
+const char* getOutputExtension(OutputFormat format);
+
+/// Get display name for format
+const char* getOutputFormatName(OutputFormat format);
+
 //==============================================================================
 // Utilities
 //==============================================================================
 
-/// Get estimated output size for given dimensions and mode
+/// Get estimated output size for given dimensions and mode (current output format)
+/// Compressed formats (RLE BMP, PNG) report their worst case.
 size_t estimateOutputSize(uint16_t width, uint16_t height, pxlcam::mode::CaptureMode mode);
 
 /// Get last capture duration (ms)
@@ -130,6 +382,34 @@ uint32_t getLastCaptureDuration();
 /// Get last processing duration (ms)
 uint32_t getLastProcessDuration();
 
+//==============================================================================
+// Stage Profiler
+//==============================================================================
+
+/// Get per-stage timings of the last capture
+/// Save is filled by captureToFile(), or by recordSaveDuration() when the
+/// caller writes the buffer itself.
+const CaptureTimings& getLastTimings();
+
+/// Record the file write of the last captured buffer
+/// @param us Save duration in microseconds
+void recordSaveDuration(uint32_t us);
+
+/// Get rolling min/avg/p95 for one stage
+/// @param stage Stage to query
+/// @param outStats Filled with the window statistics
+/// @return true if the window holds at least one sample
+bool getStageStats(CaptureStage stage, StageStats& outStats);
+
+/// Clear the rolling windows
+void resetStageStats();
+
+/// Get short stage name ("fb_get", "decode", ...)
+const char* getStageName(CaptureStage stage);
+
+/// Log one line per stage (last / min / avg / p95)
+void logStageStats();
+
 /// Get result message for status
 const char* getResultMessage(CaptureResult result);
 
@@ -137,7 +417,14 @@ const char* getResultMessage(CaptureResult result);
 // Debug / Histogram
 //==============================================================================
 
-/// Log histogram of grayscale buffer (debug)
+/// Get luma statistics of the last capture (also in ProcessedImage::stats)
+const FrameStats& getLastFrameStats();
+
+/// Log frame statistics: histogram bars, min/max/mean, clipped pixels
+/// Captures only log these themselves with PXLCAM_CAPTURE_LOG_STATS.
+void logFrameStats(const FrameStats& stats);
+
+/// Log histogram of grayscale buffer (debug, full pass over the buffer)
 /// @param gray Grayscale buffer
 /// @param length Buffer length
 void logHistogram(const uint8_t* gray, size_t length);
@@ -146,7 +433,8 @@ void logHistogram(const uint8_t* gray, size_t length);
 /// @param gray Grayscale buffer  
 /// @param w Width
 /// @param h Height
-void logSampleTones(const uint8_t* gray, int w, int h);
+/// @param stride Bytes per row (0 = w; padded Bmp8 rows are wider)
+void logSampleTones(const uint8_t* gray, int w, int h, int stride = 0);
 
 //==============================================================================
 // v1.3.0 Stylized Capture API
@@ -154,12 +442,6 @@ void logSampleTones(const uint8_t* gray, int w, int h);
 
 #if PXLCAM_FEATURE_STYLIZED_CAPTURE
 
-// Forward declarations from filters namespace
-namespace pxlcam::filters {
-    enum class PaletteType : uint8_t;
-    enum class DitherAlgorithm : uint8_t;
-}
-
 /**
  * @brief Apply stylized capture using v1.3.0 filter pipeline
  * 
@@ -181,6 +463,22 @@ bool applyStylizedCapture(
     bool outputIndices = false
 );
 
+/**
+ * @brief Dither a raw camera frame straight from fb->buf
+ * 
+ * GRAYSCALE, YUV422, RGB565 and RGB888 frames go to apply_palette_dither_ex()
+ * as-is: luma is converted one row at a time into a stack (internal RAM)
+ * buffer, so the frame is never decoded or copied. JPEG frames are
+ * rejected; decode them to gray and use applyStylizedCapture().
+ * 
+ * @param fb Camera frame (up to DITHER_MAX_WIDTH × DITHER_MAX_HEIGHT)
+ * @param output dither_output_size(config.output, fb->width, fb->height) bytes
+ * @param config Algorithm, strength and output layout (palette as in applyStylizedCapture())
+ * @return true on success
+ */
+bool applyStylizedFrame(const camera_fb_t* fb, uint8_t* output,
+                        const pxlcam::filters::DitherConfig& config);
+
 /**
  * @brief Initialize stylized capture subsystem
  */
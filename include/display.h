@@ -31,12 +31,26 @@ void shutdownDisplay();
 
 // Low-level drawing for preview mode
 void drawPixel(int16_t x, int16_t y, uint16_t color);
+
+// Push the framebuffer to the panel. Only pages/columns that changed since the
+// last update are sent (page/column addressing against a shadow copy), so a
+// static screen costs no bus time. Use this instead of Adafruit_SSD1306::display().
 void updateDisplay();
 
+// Force the next updateDisplay() to resend the whole framebuffer
+void invalidateDisplay();
+
+// Framebuffer bytes sent by the last update (diagnostics)
+uint16_t getLastFlushBytes();
+
 // Renders a 64x64 grayscale image to the OLED (1-bit threshold)
 void drawGrayscale64x64(const uint8_t *gray64);
 
 // Get raw display pointer for advanced UI operations (v1.1.0)
 Adafruit_SSD1306* getDisplayPtr();
 
+// SSD1306 framebuffer in its native layout: byte x + (y / 8) * width, bit y % 8
+// (LSB on top). nullptr when rotated or uninitialized; use drawPixel() then.
+uint8_t* getPageBuffer();
+
 }  // namespace pxlcam::display
@@ -33,7 +33,8 @@ enum class IconId : uint8_t {
 enum class PreviewMode : uint8_t {
     Auto = 0,
     GameBoy = 1,
-    Night = 2
+    Night = 2,
+    BlueNoise = 3
 };
 
 /// UI Layout constants
@@ -64,7 +65,9 @@ void drawIcon(int16_t x, int16_t y, IconId iconId);
 /// @param sdPresent SD card detected
 /// @param batteryPct Battery percentage (0-100)
 /// @param mode Current preview mode
-void drawStatusBar(int fps, bool sdPresent, uint8_t batteryPct, PreviewMode mode);
+/// @param detail Short tag after the mode letter (e.g. Auto's dither level), may be nullptr
+void drawStatusBar(int fps, bool sdPresent, uint8_t batteryPct, PreviewMode mode,
+                   const char* detail = nullptr);
 
 /// Draw 1-bit preview bitmap (packed) into centered region
 /// @param packedBitmap 1-bit packed bitmap (row-major, MSB-first)
@@ -72,6 +75,13 @@ void drawStatusBar(int fps, bool sdPresent, uint8_t batteryPct, PreviewMode mode
 /// @param h Height (typically 64)
 void drawPreviewBitmap(const uint8_t* packedBitmap, int w, int h);
 
+/// Blit a page-major 1-bit bitmap into the centered region
+/// Writes the SSD1306 framebuffer directly (drawPixel only on a rotated display).
+/// @param pages Bitmap in SSD1306 page layout (byte (y/8)*w + x, bit y%8)
+/// @param w Width (typically 64)
+/// @param h Height (typically 64)
+void drawPreviewPages(const uint8_t* pages, int w, int h);
+
 /// Draw preview frame border
 void drawPreviewFrame();
 
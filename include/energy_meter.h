@@ -0,0 +1,90 @@
+#pragma once
+/**
+ * @file energy_meter.h
+ * @brief Where the battery goes: time per power state and charge estimates
+ *
+ * The CPU is in exactly one state at a time; setState() closes the time
+ * spent in the previous one. A Scope switches state for a block (an OLED
+ * refresh, a light sleep) and back. The radio is tracked apart: WiFi draws
+ * its current on top of whatever the CPU does, so time with the radio on
+ * is counted alongside the states, not instead of them.
+ *
+ * The ledger lives in RTC memory. A deep sleep is charged on the next boot
+ * from the RTC clock (the one the timelapse schedule uses), and the boot
+ * itself, up to begin(), as Idle. Any reset other than a deep-sleep wake
+ * starts from zero.
+ *
+ * Charge figures multiply each state's time by its current
+ * (PXLCAM_POWER_UA_*). They are as good as those currents: meant to compare
+ * runs and size batteries, not to replace a meter.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam::energy {
+
+enum class PowerState : uint8_t {
+    Idle = 0,       ///< Awake, nothing below (menus, waiting between frames)
+    Capture,        ///< Sensor grab and stylize
+    Save,           ///< Writing to the card
+    Display,        ///< OLED refresh
+    LightSleep,
+    DeepSleep,
+    Count
+};
+
+constexpr size_t kStateCount = static_cast<size_t>(PowerState::Count);
+
+/// Continue the ledger kept across a deep sleep, or start a new one
+/// Call once, early in boot.
+void begin();
+
+void setState(PowerState state);
+PowerState currentState();
+
+/// State for the lifetime of the object, then back to the one before
+class Scope {
+public:
+    explicit Scope(PowerState state) : previous_(currentState()) { setState(state); }
+    ~Scope() { setState(previous_); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    PowerState previous_;
+};
+
+/// Radio on or off (counted on top of the states)
+void setRadioOn(bool on);
+
+/// A frame reached the card (the per-frame figure divides by these)
+void noteFrame();
+
+/// Zero the ledger (a new run)
+void reset();
+
+/// Close the awake time before esp_deep_sleep_start(); begin() on the
+/// wake charges the sleep
+void prepareDeepSleep();
+
+struct Report {
+    uint32_t stateMs[kStateCount];
+    uint32_t radioMs;       ///< Radio on (overlaps the states)
+    uint32_t totalMs;       ///< Sum of the states
+    uint32_t frames;
+    float dutyCycle;        ///< Awake share of totalMs (0..1)
+    uint32_t chargeUah;     ///< Estimated charge drawn
+    uint32_t uahPerFrame;   ///< chargeUah / frames (0 before the first frame)
+    uint32_t averageUa;     ///< Mean current over totalMs
+};
+
+/// Figures up to now (the current state included)
+Report getReport();
+
+/// Current assumed for a state (µA)
+uint32_t stateCurrentUa(PowerState state);
+
+const char* stateName(PowerState state);
+
+}  // namespace pxlcam::energy
@@ -4,11 +4,21 @@
  * @brief Automatic exposure quick-tuning for OV2640 camera
  * 
  * Non-blocking exposure adjustment at boot and during preview
+ *
+ * Brightness is the centre-weighted mean luma of the frame (JPEG decoded at
+ * 1/8, raw formats sampled). Each step is predictive: the error is turned
+ * into EV through the sensor gamma and applied at once, as ae_level steps
+ * (AEC on; the EV per step is learnt from the previous step) or as a scaled
+ * exposure time (AEC off). The frame after a step is dropped, so a scene in
+ * range settles in 2-3 samples.
  */
 
 #include <stdint.h>
 #include <esp_camera.h>
 
+#include "pxlcam_config.h"
+#include "sensor_profile.h"
+
 namespace pxlcam::exposure {
 
 /// Exposure tuning state
@@ -26,7 +36,7 @@ struct ExposureConfig {
     int8_t exposureLevel = 0;          ///< Manual exposure level (-2 to +2)
     uint8_t targetBrightness = 128;    ///< Target average brightness
     uint8_t tolerance = 20;            ///< Acceptable deviation from target
-    uint16_t sampleIntervalMs = 500;   ///< Time between samples
+    uint16_t sampleIntervalMs = 300;   ///< Time between samples (lets the sensor loop follow a step)
     uint8_t maxIterations = 10;        ///< Max tuning iterations
 };
 
@@ -63,19 +73,40 @@ void setAutoGain(bool enable);
 /// Get current average brightness from last sample
 uint8_t getLastBrightness();
 
-/// Calculate average brightness of a frame
-/// @param fb Frame buffer
-/// @return Average brightness (0-255)
+/// Centre-weighted mean luma of a frame
+/// @param fb Frame buffer (JPEG, RGB565, YUV422 or grayscale)
+/// @return Brightness (0-255), 128 if the frame cannot be measured
 uint8_t calculateBrightness(const camera_fb_t* fb);
 
-/// Quick one-shot exposure adjustment based on frame
+/// Quick one-shot predictive exposure step based on frame
 /// @param fb Frame buffer to analyze
 void quickAdjust(const camera_fb_t* fb);
 
-/// Apply night mode exposure settings
+/// Outcome of a warm-up
+struct WarmupResult {
+    bool converged;        ///< Luma settled before the cap
+    uint32_t settleMs;     ///< Time spent, frame size restored
+    uint8_t frames;        ///< Frames measured
+    uint8_t meanLuma;      ///< Mean luma of the last frame measured
+};
+
+/// Let AEC/AGC settle after the sensor was powered down or in standby
+/// Grabs frames at PXLCAM_WARMUP_FRAMESIZE (JPEG decoded at 1/8) and stops
+/// once their mean luma is steady (PXLCAM_WARMUP_LUMA_DELTA over
+/// PXLCAM_WARMUP_STABLE_FRAMES frames) or maxMs have passed. The capture
+/// frame size is restored before returning. Blocks the caller.
+/// @param maxMs Cap on the warm-up
+WarmupResult warmUp(uint32_t maxMs = PXLCAM_WARMUP_MAX_MS);
+
+/// Stage a sensor profile, with the configured AEC/AGC and exposure level
+/// where the profile leaves them automatic; written at the next frame
+/// boundary (sensor::atFrameBoundary()), and only what differs
+void applyProfile(sensor::Profile profile);
+
+/// Apply night mode exposure settings (sensor::Profile::Night)
 void applyNightMode();
 
-/// Apply standard exposure settings
+/// Apply standard exposure settings (sensor::Profile::Standard)
 void applyStandardMode();
 
 }  // namespace pxlcam::exposure
@@ -0,0 +1,45 @@
+/**
+ * @file blue_noise.h
+ * @brief 64×64 blue-noise threshold tile for PXLcam
+ * 
+ * @details
+ * A void-and-cluster threshold array (Ulichney, 1993): each value 0-255
+ * appears exactly 16 times and equal thresholds are spread as far apart as
+ * possible, so thresholding a flat gray gives an even, pattern-free dot
+ * field instead of the Bayer crosshatch. The tile wraps seamlessly.
+ * 
+ * Used by DitherAlgorithm::BLUE_NOISE and the blue-noise preview mode.
+ * Platform independent; the tile is const data and stays in flash.
+ * 
+ * @author PXLcam Team
+ * @version 1.3.0
+ * @date 2024
+ * 
+ * @copyright MIT License
+ */
+
+#ifndef PXLCAM_FILTERS_BLUE_NOISE_H
+#define PXLCAM_FILTERS_BLUE_NOISE_H
+
+#include <stdint.h>
+
+namespace pxlcam {
+namespace filters {
+
+/**
+ * @brief Side of the blue-noise tile (power of two, index with & 63)
+ */
+constexpr uint8_t BLUE_NOISE_SIZE = 64;
+
+/**
+ * @brief One row of the tile
+ * 
+ * @param y Image row (wrapped to the tile)
+ * @return const uint8_t* BLUE_NOISE_SIZE thresholds (0-255), index with x & 63
+ */
+const uint8_t* blue_noise_row(int y);
+
+} // namespace filters
+} // namespace pxlcam
+
+#endif // PXLCAM_FILTERS_BLUE_NOISE_H
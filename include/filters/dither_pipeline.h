@@ -12,6 +12,7 @@
  * - Ordered Bayer 4×4 (balanced quality/speed)
  * - Floyd–Steinberg (error diffusion, highest quality)
  * - Atkinson (classic Macintosh style, fast diffusion)
+ * - Blue noise (ordered cost, no crosshatch)
  * 
  * All algorithms work with the palette system defined in palette.h,
  * quantizing grayscale images to 4-tone palettes.
@@ -42,8 +43,21 @@
  * |-----------------|---------|---------|-----------|
  * | ORDERED_8X8     | Fast    | Good    | None      |
  * | ORDERED_4X4     | Fastest | Fair    | None      |
- * | FLOYD_STEINBERG | Slow    | Best    | 2×width   |
- * | ATKINSON        | Medium  | Good    | 2×width   |
+ * | FLOYD_STEINBERG | Medium  | Best    | 2×width   |
+ * | ATKINSON        | Medium  | Good    | 3×width   |
+ * | BLUE_NOISE      | Fast    | Better  | 8 KB table|
+ * 
+ * Ordered kernels process 4 pixels per 32-bit word when src and dst are
+ * word aligned (see swar.h); keep row buffers 4-byte aligned to get it.
+ * With DitherConfig::parallel they also split the frame into two row bands,
+ * the second on a worker task pinned to the other core (~2× on ESP32).
+ * Floyd–Steinberg and Atkinson use the same worker as a row wavefront when
+ * serpentine is off, which makes them practical at full resolution.
+ * 
+ * Error-diffusion kernels keep their int16 error rows in a ring allocated
+ * once from internal RAM (dither_init()) and rotate it by pointer swap, so
+ * there is no per-row copy or clear. With PXLCAM_DITHER_IRAM the row
+ * kernels run from IRAM, fast enough for live preview resolutions.
  * 
  * @author PXLcam Team
  * @version 1.3.0
@@ -69,6 +83,31 @@
 #define PXLCAM_FEATURE_STYLIZED_CAPTURE 1
 #endif
 
+/// Place the ordered bands and error-diffusion spans in IRAM (needs PXLCAM_HOT_IRAM)
+#ifndef PXLCAM_DITHER_IRAM
+#define PXLCAM_DITHER_IRAM 1
+#endif
+
+/// Build the second-core worker behind DitherConfig::parallel (ESP32 only)
+#ifndef PXLCAM_DITHER_PARALLEL
+#define PXLCAM_DITHER_PARALLEL 1
+#endif
+
+/// Core running the dither worker (Arduino loopTask runs on core 1)
+#ifndef PXLCAM_DITHER_WORKER_CORE
+#define PXLCAM_DITHER_WORKER_CORE 0
+#endif
+
+/// Stack size for the dither worker (bytes)
+#ifndef PXLCAM_DITHER_WORKER_STACK
+#define PXLCAM_DITHER_WORKER_STACK 3072
+#endif
+
+/// FreeRTOS priority for the dither worker
+#ifndef PXLCAM_DITHER_WORKER_PRIORITY
+#define PXLCAM_DITHER_WORKER_PRIORITY 2
+#endif
+
 namespace pxlcam {
 namespace filters {
 
@@ -99,6 +138,15 @@ constexpr uint16_t DITHER_MAX_WIDTH = 640;
  */
 constexpr uint16_t DITHER_MAX_HEIGHT = 480;
 
+/**
+ * @brief Maximum row width for the streaming API (dither_begin())
+ * 
+ * Streams allocate their row buffers per width and hold no frame, so the
+ * limit follows the sensor's widest mode (UXGA) instead of DITHER_MAX_WIDTH.
+ * Height is unbounded.
+ */
+constexpr uint16_t DITHER_STREAM_MAX_WIDTH = 1600;
+
 // =============================================================================
 // Dither Algorithm Enumeration
 // =============================================================================
@@ -153,12 +201,57 @@ enum class DitherAlgorithm : uint8_t {
      */
     ATKINSON = 3,
     
+    /**
+     * @brief Blue-noise threshold dithering
+     * 
+     * Ordered dithering against a 64×64 void-and-cluster tile (see
+     * blue_noise.h). Same per-pixel cost as ORDERED_8X8 and no error
+     * buffers, but the dots are evenly spread with no crosshatch, close to
+     * error-diffusion quality. Good fit for latency-sensitive paths.
+     */
+    BLUE_NOISE = 4,
+    
     /**
      * @brief Sentinel value for algorithm count
      * 
      * @note Do not use as an algorithm index
      */
-    COUNT = 4
+    COUNT = 5
+};
+
+// =============================================================================
+// Output Layouts
+// =============================================================================
+
+/**
+ * @brief Destination layout for apply_palette_dither_ex()
+ * 
+ * @details
+ * The packed layouts are written row by row as the kernels finish each
+ * row, so consumers (OLED, file encoders, WiFi streaming) get their final
+ * format without an index frame or a separate conversion pass.
+ * 
+ * Packed rows start on a byte boundary; for widths that are a multiple of
+ * 8 this is the same as one continuous bit stream. Use dither_output_size()
+ * for the destination size.
+ * 
+ * The 1-bit layouts quantize against the palette's darkest and lightest
+ * tones (tones[0] / tones[3]) so the dither pattern is kept; bit = 1 is
+ * the light tone (lit pixel on an OLED).
+ * 
+ * | Layout        | Bytes              | Pixel (x, y)                          |
+ * |---------------|--------------------|---------------------------------------|
+ * | INDICES       | w × h              | byte y*w + x, value 0-3               |
+ * | PACKED_2BPP   | ((w+3)/4) × h      | 2 bits, leftmost pixel in top bits    |
+ * | PACKED_1BPP   | ((w+7)/8) × h      | 1 bit, MSB first                      |
+ * | SSD1306_PAGES | w × ((h+7)/8)      | byte (y/8)*w + x, bit y%8 (LSB = top) |
+ */
+enum class DitherOutput : uint8_t {
+    INDICES = 0,        ///< One tone index (0-3) per byte
+    PACKED_2BPP = 1,    ///< Four tone indices per byte, row-major
+    PACKED_1BPP = 2,    ///< Eight pixels per byte, MSB first, row-major
+    SSD1306_PAGES = 3,  ///< SSD1306 GDDRAM pages: 8 vertical pixels per byte
+    COUNT = 4           ///< Sentinel, not a layout
 };
 
 // =============================================================================
@@ -197,6 +290,30 @@ struct DitherConfig {
      */
     bool serpentine;
     
+    /**
+     * @brief Split the frame across both cores
+     * 
+     * Ordered dithering: the bottom half of the rows runs on the dither
+     * worker (PXLCAM_DITHER_WORKER_CORE) while the caller does the top half.
+     * Error diffusion with `serpentine` off: rows alternate between the two
+     * cores as a wavefront, each row trailing the previous one by a few
+     * pixels; output is bit-identical to the serial kernel. Serpentine
+     * error diffusion always runs serially.
+     * 
+     * The call returns once both cores are done. Silently serial when the
+     * worker is unavailable or already busy.
+     */
+    bool parallel;
+    
+    /**
+     * @brief Destination layout (apply_palette_dither_ex() only)
+     * 
+     * SSD1306_PAGES shares bytes between 8 rows, so error diffusion never
+     * runs it as a wavefront (ordered dithering still splits on a page
+     * boundary).
+     */
+    DitherOutput output;
+    
     /**
      * @brief Default constructor with sensible defaults
      */
@@ -204,6 +321,8 @@ struct DitherConfig {
         : algorithm(DitherAlgorithm::ORDERED_4X4)
         , strength(128)
         , serpentine(true)
+        , parallel(PXLCAM_DITHER_PARALLEL != 0)
+        , output(DitherOutput::INDICES)
     {}
     
     /**
@@ -215,6 +334,8 @@ struct DitherConfig {
         : algorithm(algo)
         , strength(128)
         , serpentine(true)
+        , parallel(PXLCAM_DITHER_PARALLEL != 0)
+        , output(DitherOutput::INDICES)
     {}
 };
 
@@ -286,6 +407,9 @@ void dither_shutdown();
  * @param palette Palette to quantize against
  * @param algo Dithering algorithm to use
  * 
+ * @note Splits ordered dithering across both cores when the global config
+ *       (dither_set_config()) has `parallel` set.
+ * 
  * @code
  * const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
  * apply_dither(frame, output, 160, 120, pal, DitherAlgorithm::ORDERED_8X8);
@@ -336,6 +460,10 @@ bool apply_dither_ex(
 /**
  * @brief Set the global default dithering configuration
  * 
+ * Also precomputes the Bayer and blue-noise offset tables for
+ * `config.strength`. Threshold kernels keep one cached table per matrix and
+ * rebuild it only when they are called with a different strength.
+ * 
  * @param config New default configuration
  */
 void dither_set_config(const DitherConfig& config);
@@ -448,6 +576,25 @@ void dither_ordered_4x4(
     uint8_t strength = 128
 );
 
+/**
+ * @brief Apply blue-noise threshold dithering
+ * 
+ * @param src Source buffer
+ * @param dst Destination buffer
+ * @param w Image width
+ * @param h Image height
+ * @param palette Palette for quantization
+ * @param strength Dither strength (0-255, 128 = normal)
+ */
+void dither_blue_noise(
+    const uint8_t* src,
+    uint8_t* dst,
+    int w,
+    int h,
+    const Palette& palette,
+    uint8_t strength = 128
+);
+
 /**
  * @brief Apply Floyd–Steinberg error diffusion
  * 
@@ -458,9 +605,11 @@ void dither_ordered_4x4(
  * @param palette Palette for quantization
  * @param serpentine Enable bidirectional scanning
  * 
- * @note Requires internal error buffer (2 × width × sizeof(int16_t))
+ * @return false if the internal-RAM error ring could not be allocated
+ * 
+ * @note Uses the internal error ring (2 × width × sizeof(int16_t))
  */
-void dither_floyd_steinberg(
+bool dither_floyd_steinberg(
     const uint8_t* src,
     uint8_t* dst,
     int w,
@@ -479,9 +628,11 @@ void dither_floyd_steinberg(
  * @param palette Palette for quantization
  * @param serpentine Enable bidirectional scanning
  * 
- * @note Requires internal error buffer (3 × width × sizeof(int16_t))
+ * @return false if the internal-RAM error ring could not be allocated
+ * 
+ * @note Uses the internal error ring (3 × width × sizeof(int16_t))
  */
-void dither_atkinson(
+bool dither_atkinson(
     const uint8_t* src,
     uint8_t* dst,
     int w,
@@ -522,9 +673,34 @@ enum class SourceFormat : uint8_t {
      * @brief RGB565 (2 bytes per pixel, packed)
      * 
      * Input buffer size: w × h × 2 bytes
-     * Common format for displays and ESP32-CAM.
+     * Native-endian uint16_t pixels, as used by display frame buffers.
+     * ESP32-CAM frames are byte-swapped: use RGB565_BE for fb->buf.
      */
-    RGB565 = 2
+    RGB565 = 2,
+    
+    /**
+     * @brief YUV422 (2 bytes per pixel, Y0-U-Y1-V interleaved)
+     * 
+     * Input buffer size: w × h × 2 bytes
+     * Native OV2640 output; luminance is the Y byte, no conversion needed.
+     */
+    YUV422 = 3,
+    
+    /**
+     * @brief RGB565 in sensor byte order (RRRRRGGG GGGBBBBB)
+     * 
+     * Input buffer size: w × h × 2 bytes
+     * What esp32-camera delivers for PIXFORMAT_RGB565, so fb->buf can be
+     * dithered directly. Converted row by row (see luma_extract.h).
+     */
+    RGB565_BE = 4,
+    
+    /**
+     * @brief Sentinel value for format count
+     * 
+     * @note Do not use as a source format
+     */
+    COUNT = 5
 };
 
 // =============================================================================
@@ -541,13 +717,15 @@ struct DitherResult {
     bool success;           ///< Operation completed successfully
     const char* errorMsg;   ///< Error message if !success (nullptr if success)
     uint32_t processedPixels; ///< Number of pixels processed
+    uint32_t outputBytes;   ///< Bytes written to dst (see dither_output_size())
     
-    DitherResult() : success(false), errorMsg(nullptr), processedPixels(0) {}
-    DitherResult(bool ok) : success(ok), errorMsg(nullptr), processedPixels(0) {}
+    DitherResult() : success(false), errorMsg(nullptr), processedPixels(0), outputBytes(0) {}
+    DitherResult(bool ok) : success(ok), errorMsg(nullptr), processedPixels(0), outputBytes(0) {}
     
-    static DitherResult Ok(uint32_t pixels = 0) {
+    static DitherResult Ok(uint32_t pixels = 0, uint32_t bytes = 0) {
         DitherResult r(true);
         r.processedPixels = pixels;
+        r.outputBytes = bytes;
         return r;
     }
     
@@ -588,7 +766,7 @@ struct DitherResult {
  * - Space: O(1) for ordered, O(w) for error diffusion
  * 
  * @param src Source image buffer
- * @param srcFormat Format of the source buffer (GRAYSCALE, RGB888, RGB565)
+ * @param srcFormat Format of the source buffer (GRAYSCALE, RGB888, RGB565, YUV422, RGB565_BE)
  * @param dst Destination buffer for tone indices (0-3 values)
  * @param w Image width in pixels
  * @param h Image height in pixels  
@@ -600,7 +778,7 @@ struct DitherResult {
  * @pre src != nullptr && dst != nullptr
  * @pre w > 0 && h > 0
  * @pre w <= DITHER_MAX_WIDTH && h <= DITHER_MAX_HEIGHT
- * @pre src buffer size >= w*h (grayscale), w*h*3 (RGB888), or w*h*2 (RGB565)
+ * @pre src buffer size >= w*h (grayscale), w*h*3 (RGB888), or w*h*2 (RGB565, YUV422, RGB565_BE)
  * @pre dst buffer size >= w*h
  * 
  * @warning Error diffusion algorithms modify internal static buffers.
@@ -648,11 +826,13 @@ DitherResult apply_palette_dither(
  * 
  * @details
  * Same as apply_palette_dither() but with additional configuration options
- * for dither strength and serpentine scanning.
+ * for dither strength, serpentine scanning and the destination layout
+ * (DitherConfig::output). Packed layouts need only
+ * dither_output_size(config.output, w, h) bytes of dst.
  * 
  * @param src Source image buffer
  * @param srcFormat Format of the source buffer
- * @param dst Destination buffer for tone indices
+ * @param dst Destination buffer in the config.output layout
  * @param w Image width
  * @param h Image height
  * @param palette Palette to quantize against
@@ -672,6 +852,94 @@ DitherResult apply_palette_dither_ex(
     const DitherConfig& config
 );
 
+// =============================================================================
+// Streaming API - dither_begin() / dither_push_row() / dither_end()
+// =============================================================================
+
+/**
+ * @brief Receives finished output from a dither stream
+ * 
+ * Called synchronously from dither_push_row() (or dither_end() for the last
+ * partial SSD1306 page). `data` is only valid during the call.
+ * 
+ * | Layout        | Called                 | y                 | bytes       |
+ * |---------------|------------------------|-------------------|-------------|
+ * | INDICES       | every row              | row               | w           |
+ * | PACKED_2BPP   | every row              | row               | (w + 3) / 4 |
+ * | PACKED_1BPP   | every row              | row               | (w + 7) / 8 |
+ * | SSD1306_PAGES | every 8th row, and end | first row of page | w           |
+ * 
+ * @param user Pointer given to dither_begin()
+ * @param y First image row the data covers
+ * @param data Output bytes in the stream's DitherConfig::output layout
+ * @param bytes Byte count
+ * @return false to abort the stream (later pushes fail, dither_end() reports it)
+ */
+typedef bool (*DitherRowSink)(void* user, int y, const uint8_t* data, size_t bytes);
+
+/**
+ * @brief Open an incremental dither stream
+ * 
+ * @details
+ * Rows are pushed one at a time as a decoder produces them and come back
+ * dithered through `sink`, so peak memory is a few rows instead of a whole
+ * frame. Error-diffusion state is carried between pushes; the output is
+ * byte-identical to apply_palette_dither_ex() on the same rows.
+ * 
+ * Only one stream can be open at a time. Whole-frame calls may run while
+ * it is open (the stream has its own error rows); DitherConfig::parallel
+ * is ignored.
+ * 
+ * @param w Row width (1 to DITHER_STREAM_MAX_WIDTH)
+ * @param srcFormat Format of the pushed rows
+ * @param palette Palette to quantize against (copied; need not outlive the call)
+ * @param config Algorithm, strength, serpentine and output layout
+ * @param sink Output callback
+ * @param user Passed through to sink
+ * @return DitherResult Error if a stream is open, a parameter is invalid or
+ *         the row buffers could not be allocated
+ * 
+ * @code
+ * dither_begin(w, SourceFormat::GRAYSCALE, pal, config, writeRow, &file);
+ * for (int y = 0; y < h; ++y) {
+ *     if (!dither_push_row(decodeNextRow())) break;
+ * }
+ * DitherResult r = dither_end();
+ * @endcode
+ */
+DitherResult dither_begin(
+    int w,
+    SourceFormat srcFormat,
+    const Palette& palette,
+    const DitherConfig& config,
+    DitherRowSink sink,
+    void* user
+);
+
+/**
+ * @brief Dither the next row of the open stream
+ * 
+ * @param row Source row: w pixels in the stream's source format
+ * @return false if no stream is open or the stream failed (sink abort)
+ */
+bool dither_push_row(const uint8_t* row);
+
+/**
+ * @brief Close the stream
+ * 
+ * Flushes a partial SSD1306 page and releases the row buffers. Always
+ * closes, including after a failure.
+ * 
+ * @return DitherResult Rows × width pixels and the bytes sent to the sink,
+ *         or the first error of the stream
+ */
+DitherResult dither_end();
+
+/**
+ * @brief True between dither_begin() and dither_end()
+ */
+bool dither_stream_active();
+
 // =============================================================================
 // Utility Functions
 // =============================================================================
@@ -700,6 +968,16 @@ void indices_to_grayscale(
     const Palette& palette
 );
 
+/**
+ * @brief Destination size of a dithered image in a given layout
+ * 
+ * @param output Output layout
+ * @param w Image width
+ * @param h Image height
+ * @return size_t Bytes apply_palette_dither_ex() writes (0 for an invalid layout)
+ */
+size_t dither_output_size(DitherOutput output, int w, int h);
+
 /**
  * @brief Get bytes per pixel for a source format
  * 
@@ -739,6 +1017,9 @@ void dither_debug_print_matrix(uint8_t size);
 /**
  * @brief Benchmark all algorithms and print results
  * 
+ * Quick serial check on a synthetic gradient; pipeline_bench.h times
+ * every capture stage on real frames, per resolution and memory.
+ * 
  * @param w Test image width
  * @param h Test image height
  */
@@ -777,6 +1058,23 @@ inline DitherResult apply_palette_dither_ex(
 
 inline void indices_to_grayscale(const uint8_t*, uint8_t*, size_t, const Palette&) {}
 
+inline DitherResult dither_begin(int, SourceFormat, const Palette&, const DitherConfig&,
+                                 DitherRowSink, void*) {
+    return DitherResult::Error("Feature disabled");
+}
+
+inline bool dither_push_row(const uint8_t*) {
+    return false;
+}
+
+inline DitherResult dither_end() {
+    return DitherResult::Error("Feature disabled");
+}
+
+inline bool dither_stream_active() {
+    return false;
+}
+
 } // namespace filters
 } // namespace pxlcam
 
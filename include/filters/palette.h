@@ -272,6 +272,23 @@ struct Palette {
     const char* name;
 };
 
+/**
+ * @brief Precomputed nearest-tone lookup for one palette
+ * 
+ * @details
+ * Maps every grayscale value (0-255) to its nearest palette tone so the
+ * dithering inner loops do a single table load instead of a 4-way
+ * distance search. Ties resolve to the lower index, exactly like
+ * palette_map_index().
+ * 
+ * Tables for registry palettes (built-in and custom slots) are cached by
+ * the palette system and rebuilt whenever a custom palette changes.
+ */
+struct PaletteLut {
+    uint8_t index[256];     ///< value → tone index (0-3)
+    uint8_t tone[256];      ///< value → tone value (tones[index[v]])
+};
+
 // =============================================================================
 // Custom Palette Slot Structure
 // =============================================================================
@@ -476,6 +493,35 @@ uint8_t palette_map_value(uint8_t value, const Palette& palette);
  */
 uint8_t palette_map_index(uint8_t value, const Palette& palette);
 
+/**
+ * @brief Build the nearest-tone lookup tables for a palette
+ * 
+ * @param palette Palette to tabulate
+ * @param outLut Destination tables
+ */
+void palette_build_lut(const Palette& palette, PaletteLut& outLut);
+
+/**
+ * @brief Get the nearest-tone lookup tables for a palette
+ * 
+ * @details
+ * Returns the cached tables when `palette` is one of the registry entries
+ * returned by palette_get() / palette_current(). Any other Palette (a local
+ * copy, a CustomPaletteSlot::data snapshot) is tabulated into `scratch`,
+ * so call this once per image, not per pixel.
+ * 
+ * @param palette Palette to look up
+ * @param scratch Storage used when no cached table exists
+ * @return const PaletteLut& Cached tables or `scratch`
+ * 
+ * @code
+ * PaletteLut scratch;
+ * const PaletteLut& lut = palette_lut(pal, scratch);
+ * dst[i] = lut.tone[src[i]];
+ * @endcode
+ */
+const PaletteLut& palette_lut(const Palette& palette, PaletteLut& scratch);
+
 // =============================================================================
 // Public API - Custom Palette Management
 // =============================================================================
@@ -609,6 +655,24 @@ bool palette_load_from_sd();
  */
 bool palette_save_to_sd();
 
+/**
+ * @brief Load custom palettes, from the NVS cache while it is current
+ * 
+ * @details
+ * palette_load_from_sd() and palette_save_to_sd() keep a versioned,
+ * checksummed binary snapshot of the custom slots in NVS, stamped with
+ * the size and mtime of /PXL/palettes.json. This restores the slots from
+ * that snapshot when the file still matches it, or when no SD card is
+ * mounted, and only reads and parses the JSON when the file changed (or
+ * there is no valid snapshot).
+ * 
+ * @return true if custom palettes came from the cache or the file
+ * @return false if neither was available
+ * 
+ * @see palette_load_from_sd()
+ */
+bool palette_load_cached();
+
 /**
  * @brief Load selected palette ID from NVS
  * 
@@ -708,6 +772,11 @@ inline bool palette_load_from_sd() { return false; }
  */
 inline bool palette_save_to_sd() { return false; }
 
+/**
+ * @brief Load from NVS cache or SD (no-op when disabled)
+ */
+inline bool palette_load_cached() { return false; }
+
 /**
  * @brief Load NVS selection (no-op when disabled)
  */
@@ -8,6 +8,13 @@
  * 
  * Filter chain: Gamma → Contrast → Brightness → Sharpen → Denoise → Dither
  * 
+ * Pointwise filters (gamma, contrast, brightness, histogram EQ, Night
+ * enhance) only map a value to a value. The chain compiler folds each run
+ * of consecutive pointwise filters into one 256-entry table, so the run
+ * costs one lookup pass however many filters it holds. Compiled chains are
+ * cached by a hash of the configuration; a run with histogram EQ finishes
+ * its table per frame from the run's input histogram.
+ * 
  * @version 1.3.0
  * @date 2024
  * 
@@ -17,7 +24,6 @@
 #ifndef PXLCAM_FILTERS_POSTPROCESS_H
 #define PXLCAM_FILTERS_POSTPROCESS_H
 
-#include <Arduino.h>
 #include <stdint.h>
 #include <functional>
 
@@ -41,6 +47,7 @@ enum class FilterType : uint8_t {
     VIGNETTE,               ///< Vignette effect
     GRAIN,                  ///< Film grain overlay
     DITHER,                 ///< Palette dithering (from dither_pipeline)
+    NIGHT_ENHANCE,          ///< Night mode gamma boost + contrast
     
     COUNT
 };
@@ -131,6 +138,228 @@ bool apply_postprocess_chain(uint8_t* buffer, int w, int h);
  */
 bool apply_filter(uint8_t* buffer, int w, int h, const FilterParams& params);
 
+// =============================================================================
+// Chain Compiler
+// =============================================================================
+
+/// Most table lookups a chain compiles to (pointwise runs alternate with
+/// other filters)
+constexpr uint8_t MAX_LUT_STEPS = (MAX_FILTER_CHAIN + 1) / 2;
+
+/**
+ * @brief One step of a compiled chain
+ */
+struct ChainStep {
+    uint8_t first;          ///< Index of the step's first filter in the config
+    uint8_t count;          ///< Filters folded into the step (1 unless lut)
+    bool lut;               ///< Pointwise run: one table lookup
+    bool needsHistogram;    ///< Run holds histogram EQ: table is per frame
+    uint8_t lutIndex;       ///< Table of a lut step in ChainProgram::luts
+};
+
+/**
+ * @brief Enabled filters of a configuration, compiled
+ */
+struct ChainProgram {
+    ChainStep steps[MAX_FILTER_CHAIN];
+    uint8_t stepCount;
+    uint8_t luts[MAX_LUT_STEPS][256];   ///< Tables of lut steps (static runs)
+    uint32_t hash;                      ///< Configuration compiled
+};
+
+/**
+ * @brief Filter maps a value to a value regardless of position
+ */
+bool filter_is_pointwise(FilterType type);
+
+/**
+ * @brief Compile a configuration, or return the cached program for it
+ * 
+ * @param config Configuration (enabled filters in order)
+ * @return Program, valid until the next compile of another configuration
+ */
+const ChainProgram& postprocess_compile(const PostProcessConfig& config);
+
+/**
+ * @brief Table of a lut step for one frame
+ * 
+ * @param config Configuration the program was compiled from
+ * @param step Lut step
+ * @param histogram 256-bin histogram of the step's input (used with
+ *        needsHistogram, may be null otherwise)
+ * @param pixels Pixels counted in histogram
+ * @param lut Output table
+ */
+void postprocess_build_lut(const PostProcessConfig& config, const ChainStep& step,
+                           const uint32_t* histogram, uint32_t pixels, uint8_t lut[256]);
+
+// =============================================================================
+// Neighborhood Filters (3x3, streamed by rows)
+// =============================================================================
+
+/**
+ * @brief Caller storage a RowWindow3 needs for rows of width w
+ * 
+ * Three source rows plus column scratch; the block must be 2-byte aligned.
+ */
+constexpr size_t row_window_bytes(int w) {
+    return (size_t)w * 6 + 6;
+}
+
+/**
+ * @brief Three-row window for the 3x3 filters (sharpen, denoise)
+ * 
+ * Rows are pushed top to bottom; each is copied into a ring of three, so
+ * an output row can overwrite the input row it came from (in place, no
+ * frame copy). Edges repeat the border pixels. Per pixel, sharpen costs a
+ * sliding box sum over column sums and denoise an exact 3x3 median (column
+ * triples sorted once, then max/median/min of three); strength is 8.8
+ * fixed point.
+ */
+class RowWindow3 {
+public:
+    /**
+     * @brief Start a frame
+     * 
+     * @param params SHARPEN or DENOISE
+     * @param w Row width
+     * @param storage row_window_bytes(w) bytes (owned by the caller)
+     * @return false for another filter type or no storage
+     */
+    bool begin(const FilterParams& params, int w, uint8_t* storage);
+    
+    /**
+     * @brief Add the next input row
+     * 
+     * @param row Input row (w pixels)
+     * @param out Receives the filtered row above it
+     * @return true if out was written (every row but the first)
+     */
+    bool push(const uint8_t* row, uint8_t* out);
+    
+    /**
+     * @brief Emit the last row, after the last push()
+     * 
+     * @return true if out was written
+     */
+    bool finish(uint8_t* out);
+
+private:
+    void filterRow(const uint8_t* top, const uint8_t* mid, const uint8_t* bot, uint8_t* out);
+    
+    FilterType type_ = FilterType::SHARPEN;
+    int16_t strength_ = 0;  ///< 8.8
+    int w_ = 0;
+    uint16_t* sums_ = nullptr;
+    uint8_t* rows_[3] = {nullptr, nullptr, nullptr};
+    uint32_t pushed_ = 0;
+};
+
+// =============================================================================
+// Row-Streamed Chain
+// =============================================================================
+
+/**
+ * @brief Whole chain applied to rows as a producer delivers them
+ * 
+ * Rows go in top to bottom and come out, in order, through a sink. A lut
+ * step is one lookup per pixel (the first one is fused with the input
+ * copy), vignette and grain work on the row in hand, and each 3x3 filter is
+ * a RowWindow3 that holds its output back one row: latency() rows in all.
+ * Storage is the caller's (storage_bytes()), a few rows per 3x3 filter and
+ * never a frame.
+ * 
+ * Histogram EQ needs its input histogram before the first row arrives, so
+ * begin() takes one (the previous frame's for a streamed source; null runs
+ * EQ as identity). The histogram of this frame's input rows is gathered
+ * into histogram() for the next begin(). Output matches
+ * apply_postprocess_chain() exactly for chains without EQ.
+ */
+class RowChain {
+public:
+    /// Receives output row y (w pixels); false aborts the frame
+    using RowSink = bool (*)(void* user, const uint8_t* row, int y);
+    
+    /**
+     * @brief Caller storage begin() needs
+     * 
+     * @param maxWindows 3x3 filters run at most (later ones are skipped)
+     */
+    static size_t storage_bytes(const PostProcessConfig& config, int w,
+                                uint8_t maxWindows = MAX_FILTER_CHAIN);
+    
+    /**
+     * @brief Most storage_bytes() can be for rows of width w
+     * 
+     * All maxWindows windows in use; for storage reserved up front.
+     */
+    static constexpr size_t storage_bytes_max(int w, uint8_t maxWindows) {
+        return (((size_t)w + 1) & ~(size_t)1) * (1 + (size_t)maxWindows) +
+               (size_t)maxWindows * row_window_bytes(w);
+    }
+    
+    /**
+     * @brief Start a frame
+     * 
+     * @param config Configuration (read here only)
+     * @param storage storage_bytes(config, w, maxWindows) bytes, 2-byte aligned
+     * @param histogram 256-bin histogram for histogram EQ (may be null)
+     * @param pixels Pixels counted in histogram
+     * @return false if the storage is missing or too small
+     */
+    bool begin(const PostProcessConfig& config, int w, int h, uint8_t* storage, size_t bytes,
+               const uint32_t* histogram, uint32_t pixels, RowSink sink, void* user,
+               uint8_t maxWindows = MAX_FILTER_CHAIN);
+    
+    /// Configuration has steps to run (false after begin() of an empty chain)
+    bool active() const { return stepCount_ > 0; }
+    
+    /// Rows an output lags its input
+    uint8_t latency() const { return windowCount_; }
+    
+    /// 3x3 filters skipped for maxWindows
+    uint8_t skipped() const { return skipped_; }
+    
+    /// Add the next input row; emits what became ready
+    /// @return false if the sink aborted
+    bool push(const uint8_t* row);
+    
+    /// Emit the rows still held, after the last push()
+    bool finish();
+    
+    /// Histogram of this frame's input rows (gathered when the chain has EQ)
+    const uint32_t* histogram() const { return histogram_; }
+    uint32_t histogramPixels() const { return countHistogram_ ? (uint32_t)pushed_ * w_ : 0; }
+    
+private:
+    enum class Kind : uint8_t { Lut, Window, Vignette, Grain };
+    
+    struct Step {
+        Kind kind;
+        uint8_t index;          ///< Table or window of the step
+        float strength;
+        float param1;
+    };
+    
+    bool run(uint8_t from, uint8_t* row, int y);
+    
+    Step steps_[MAX_FILTER_CHAIN];
+    uint8_t stepCount_ = 0;
+    uint8_t windowCount_ = 0;
+    uint8_t skipped_ = 0;
+    bool countHistogram_ = false;
+    uint8_t luts_[MAX_LUT_STEPS][256];
+    RowWindow3 windows_[MAX_FILTER_CHAIN];
+    uint8_t* windowOut_[MAX_FILTER_CHAIN];
+    uint8_t* row_ = nullptr;
+    uint32_t histogram_[256];
+    int w_ = 0;
+    int h_ = 0;
+    int pushed_ = 0;
+    RowSink sink_ = nullptr;
+    void* user_ = nullptr;
+};
+
 /**
  * @brief Set the filter chain configuration
  * 
@@ -204,7 +433,7 @@ void filter_gamma(uint8_t* buffer, int w, int h, float gamma);
  * @param buffer Image buffer
  * @param w Width
  * @param h Height
- * @param contrast Contrast multiplier (1.0 = no change)
+ * @param contrast Contrast multiplier around mid-gray (1.0 = no change)
  */
 void filter_contrast(uint8_t* buffer, int w, int h, float contrast);
 
@@ -247,9 +476,22 @@ void filter_denoise(uint8_t* buffer, int w, int h, float strength);
  */
 void filter_histogram_eq(uint8_t* buffer, int w, int h);
 
+/**
+ * @brief Apply Night mode enhancement (gamma 0.6, then contrast 1.4)
+ * 
+ * @param buffer Image buffer
+ * @param w Width
+ * @param h Height
+ */
+void filter_night_enhance(uint8_t* buffer, int w, int h);
+
 /**
  * @brief Apply vignette effect
  * 
+ * Gain comes from a table over squared distance, built with per-column
+ * and per-row terms for one quadrant (mirrored) whenever the size or the
+ * parameters change, and is applied in 8.8 fixed point.
+ * 
  * @param buffer Image buffer
  * @param w Width
  * @param h Height
@@ -258,9 +500,20 @@ void filter_histogram_eq(uint8_t* buffer, int w, int h);
  */
 void filter_vignette(uint8_t* buffer, int w, int h, float strength, float radius);
 
+/**
+ * @brief Apply vignette to a band of rows of a w x h image
+ * 
+ * @param rows Row y0 of the image, count rows of w pixels
+ */
+void filter_vignette_rows(uint8_t* rows, int y0, int count, int w, int h,
+                          float strength, float radius);
+
 /**
  * @brief Apply film grain overlay
  * 
+ * Noise from a xorshift32 generator, four samples per step, scaled to
+ * +/- amount * 50 without a division.
+ * 
  * @param buffer Image buffer
  * @param w Width
  * @param h Height
@@ -268,6 +521,11 @@ void filter_vignette(uint8_t* buffer, int w, int h, float strength, float radius
  */
 void filter_grain(uint8_t* buffer, int w, int h, float amount);
 
+/**
+ * @brief Apply film grain to count rows of w pixels (position independent)
+ */
+void filter_grain_rows(uint8_t* rows, int count, int w, float amount);
+
 // =============================================================================
 // Preset Configurations
 // =============================================================================
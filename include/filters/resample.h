@@ -0,0 +1,200 @@
+/**
+ * @file resample.h
+ * @brief Fixed-point area (box) downscaler for luma previews and thumbnails
+ *
+ * @details
+ * Every destination pixel is the exact area-weighted mean of the source
+ * pixels it covers, for any ratio (320 → 64, 240 → 64, 317 → 128, ...).
+ * Nothing is dropped: a source pixel that straddles two destination cells
+ * adds to both in proportion to its overlap.
+ *
+ * The filter is separable and row-streaming:
+ * - each source row is converted to luma once and box-filtered horizontally
+ *   into one accumulator per destination column
+ * - that row is then added, with its vertical coverage weight, to at most
+ *   two destination rows, which are written out as soon as they are complete
+ *
+ * Weights are integers: in units where one source pixel is dstW wide and one
+ * destination pixel is srcW wide, every overlap is exact. The final divide
+ * by srcW × srcH is a 32.32 reciprocal multiply.
+ *
+ * Only downscaling (or 1:1) is supported. State is ~1 KB (no allocation, no
+ * Arduino dependencies), so tasks can own one and host tests can share it.
+ *
+ * @section usage Usage Example
+ * @code
+ * using namespace pxlcam::filters;
+ *
+ * uint8_t thumb[64 * 64];
+ * resample_area(fb->buf, fb->width * 2, ResampleFormat::RGB565,
+ *               fb->width, fb->height, thumb, 64, 64, 64);
+ * @endcode
+ */
+
+#ifndef PXLCAM_FILTERS_RESAMPLE_H
+#define PXLCAM_FILTERS_RESAMPLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam {
+namespace filters {
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+/// Widest destination supported (QQVGA stream frames; an SSD1306 row is 128)
+#ifndef RESAMPLE_MAX_DST_WIDTH
+#define RESAMPLE_MAX_DST_WIDTH 160
+#endif
+
+/// Largest source dimension (keeps 255 × srcW × srcH inside 32 bits)
+#ifndef RESAMPLE_MAX_SRC_DIM
+#define RESAMPLE_MAX_SRC_DIM 2048
+#endif
+
+// =============================================================================
+// Types
+// =============================================================================
+
+/**
+ * @brief Source pixel layouts accepted by the resampler
+ *
+ * Luma uses the same BT.601 weights (77/150/29 >> 8) as the rest of the
+ * preview and capture paths.
+ */
+enum class ResampleFormat : uint8_t {
+    GRAY = 0,   ///< 8-bit luma, 1 byte per pixel
+    YUV422,     ///< YUYV, luma is every second byte
+    RGB565,     ///< 2 bytes per pixel, sensor byte order (RRRRRGGG GGGBBBBB)
+    RGB888,     ///< 3 bytes per pixel, R-G-B order
+
+    COUNT
+};
+
+/**
+ * @brief Bytes per source pixel for a format
+ */
+inline int resample_bytes_per_pixel(ResampleFormat format) {
+    switch (format) {
+        case ResampleFormat::GRAY:   return 1;
+        case ResampleFormat::YUV422: return 2;
+        case ResampleFormat::RGB565: return 2;
+        case ResampleFormat::RGB888: return 3;
+        default:                     return 0;
+    }
+}
+
+/**
+ * @brief Row-streaming area resampler
+ *
+ * Push the source rows top to bottom with push_row(); destination rows are
+ * written to the output buffer as they complete. After srcH rows the
+ * output is fully written and done() returns true.
+ *
+ * @code
+ * AreaResampler rs;
+ * rs.begin(srcW, srcH, ResampleFormat::GRAY, out, 64, 64, 64);
+ * for (int y = 0; y < srcH; y++) rs.push_row(src + y * srcW);
+ * @endcode
+ */
+class AreaResampler {
+public:
+    AreaResampler() = default;
+
+    /**
+     * @brief Start a new image
+     *
+     * @param srcW Source width in pixels (>= dstW)
+     * @param srcH Source height in pixels (>= dstH)
+     * @param format Layout of the rows passed to push_row()
+     * @param dst Output luma plane
+     * @param dstW Output width (<= RESAMPLE_MAX_DST_WIDTH)
+     * @param dstH Output height
+     * @param dstStride Bytes between output rows
+     * @return false if the sizes are out of range (nothing is written)
+     */
+    bool begin(int srcW, int srcH, ResampleFormat format,
+               uint8_t* dst, int dstW, int dstH, size_t dstStride);
+
+    /**
+     * @brief Add the next source row
+     * @param row srcW pixels in the format given to begin()
+     * @return false if no image is open or all rows were already pushed
+     */
+    bool push_row(const uint8_t* row);
+
+    /**
+     * @brief Add the next source row, already converted to luma
+     *
+     * For producers (like the JPEG MCU decoder) that have luma regardless
+     * of the begin() format.
+     */
+    bool push_luma_row(const uint8_t* luma);
+
+    /**
+     * @brief Count output values into a 256-bin histogram as rows are emitted
+     *
+     * Lets equalization skip its own pass over the image. The bins are
+     * zeroed by begin(); pass nullptr to stop counting.
+     */
+    void set_histogram(uint32_t* bins) { hist_ = bins; }
+
+    /// True once every source row was pushed
+    bool done() const { return active_ && srcY_ == srcH_; }
+
+    int src_width() const { return srcW_; }
+    int src_height() const { return srcH_; }
+
+private:
+    void accumulate_row();
+    void emit_row();
+
+    uint32_t colSum_[RESAMPLE_MAX_DST_WIDTH];  ///< Current source row, box-filtered
+    uint32_t acc_[RESAMPLE_MAX_DST_WIDTH];     ///< Destination row dstY_
+
+    uint8_t* dst_ = nullptr;
+    size_t dstStride_ = 0;
+    uint32_t* hist_ = nullptr;
+    uint64_t recip_ = 0;       ///< 2^32 / (srcW × srcH), rounded up
+    uint32_t area_ = 0;        ///< srcW × srcH (weight sum per output pixel)
+    int srcW_ = 0;
+    int srcH_ = 0;
+    int dstW_ = 0;
+    int dstH_ = 0;
+    int srcY_ = 0;             ///< Next source row
+    int dstY_ = 0;             ///< Destination row being accumulated
+    ResampleFormat format_ = ResampleFormat::GRAY;
+    bool active_ = false;
+};
+
+// =============================================================================
+// One-shot API
+// =============================================================================
+
+/**
+ * @brief Area-downscale a whole frame to luma
+ *
+ * @param src First source pixel
+ * @param srcStride Bytes between source rows
+ * @param format Source layout
+ * @param srcW Source width (>= dstW)
+ * @param srcH Source height (>= dstH)
+ * @param dst Output luma plane
+ * @param dstW Output width (<= RESAMPLE_MAX_DST_WIDTH)
+ * @param dstH Output height
+ * @param dstStride Bytes between output rows
+ * @return false on invalid arguments
+ *
+ * @note Uses an internal static resampler; not reentrant. Tasks that
+ *       resample concurrently should each own an AreaResampler.
+ */
+bool resample_area(const uint8_t* src, size_t srcStride, ResampleFormat format,
+                   int srcW, int srcH,
+                   uint8_t* dst, int dstW, int dstH, size_t dstStride);
+
+} // namespace filters
+} // namespace pxlcam
+
+#endif // PXLCAM_FILTERS_RESAMPLE_H
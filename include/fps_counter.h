@@ -1,38 +1,153 @@
 #pragma once
 /**
  * @file fps_counter.h
- * @brief FPS calculation utility for preview
+ * @brief FPS and frame-time telemetry for preview
+ *
+ * Besides the integer FPS shown in the status bar, FPSCounter records
+ * microsecond frame intervals and per-stage durations into fixed-bucket
+ * latency histograms, so p50/p95/p99 and jitter separate a preview that is
+ * uniformly slow from one that stalls now and then.
  */
 
 #include <stdint.h>
+#include <freertos/FreeRTOS.h>
 
 namespace pxlcam::util {
 
-/// Simple FPS counter with rolling average
+/// Preview frame stages with their own latency histogram
+enum class FrameStage : uint8_t {
+    Grab = 0,     ///< esp_camera_fb_get()
+    Decode,       ///< JPEG decode (includes the downscale it feeds)
+    Downscale,    ///< Raw frame resample + equalization
+    Dither,       ///< 64×64 gray → 1-bit
+    Blit,         ///< Preview and overlay into the display buffer
+    I2C,          ///< Display flush
+    Count
+};
+
+/// Short stage name ("grab", "decode", ...)
+const char* getFrameStageName(FrameStage stage);
+
+/// Percentile summary of one histogram (all values in microseconds)
+struct TimingSummary {
+    uint32_t samples;
+    uint32_t lastUs;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t avgUs;
+    uint32_t p50Us;
+    uint32_t p95Us;
+    uint32_t p99Us;
+};
+
+/// Fixed-bucket latency histogram, 4 buckets per octave (≤ 25% error)
+///
+/// 16 µs .. 4 s in 74 uint16 buckets. When a bucket would overflow all of
+/// them are halved, so old samples fade instead of saturating the counts.
+class LatencyHistogram {
+public:
+    static constexpr int kBuckets = 74;
+
+    void record(uint32_t us);
+    void reset();
+
+    /// Percentiles are reported as the upper edge of their bucket
+    void summarize(TimingSummary& out) const;
+
+    /// Bucket holding a duration, and that bucket's upper edge
+    static int bucketFor(uint32_t us);
+    static uint32_t bucketUpperUs(int bucket);
+
+private:
+    uint32_t percentile(uint32_t total, uint32_t pct) const;
+
+    uint16_t counts_[kBuckets] = {0};
+    uint32_t samples_ = 0;
+    uint64_t sumUs_ = 0;
+    uint32_t lastUs_ = 0;
+    uint32_t minUs_ = UINT32_MAX;
+    uint32_t maxUs_ = 0;
+};
+
+/// FPS counter with rolling average and frame-time telemetry
+///
+/// tick() is called by one task; recordStage() may be called from any task
+/// (the preview camera task records grab/decode/downscale). Summaries are
+/// snapshots taken under a spinlock.
 class FPSCounter {
 public:
     FPSCounter() = default;
-    
+
     /// Record a frame timestamp
     void tick();
-    
+
     /// Get current FPS (updated each tick)
     int getFPS() const { return currentFps_; }
-    
+
     /// Get frame time in ms
-    uint32_t getFrameTimeMs() const { return frameTimeMs_; }
-    
+    uint32_t getFrameTimeMs() const { return frameTimeUs_ / 1000; }
+
+    /// Last frame interval (µs)
+    uint32_t getFrameTimeUs() const { return frameTimeUs_; }
+
+    /// Smoothed |interval - previous interval| (µs, RFC 3550 style 1/16 gain)
+    uint32_t getJitterUs() const { return jitterUs_; }
+
+    /// Intervals longer than the stall threshold
+    uint32_t getStalls() const { return stalls_; }
+
+    /// Frame intervals above this count as stalls (0 = never)
+    void setStallThresholdUs(uint32_t us) { stallThresholdUs_ = us; }
+
+    /// Record how long a stage took for the current frame
+    void recordStage(FrameStage stage, uint32_t us);
+
+    /// Frame-interval percentiles
+    void getFrameSummary(TimingSummary& out) const;
+
+    /// Per-stage percentiles
+    void getStageSummary(FrameStage stage, TimingSummary& out) const;
+
+    /// Log frame and stage summaries (one line each)
+    void logSummary(const char* prefix) const;
+
+    /// Next tick() starts a new interval (idle gaps are not frame times)
+    void pause() { haveTick_ = false; }
+
     /// Reset counter
     void reset();
-    
+
 private:
     static constexpr int kSampleCount = 10;
-    
+    static constexpr int kStageCount = static_cast<int>(FrameStage::Count);
+
+    mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
     uint32_t frameTimes_[kSampleCount] = {0};
     int frameIndex_ = 0;
-    uint32_t lastTickMs_ = 0;
+    uint32_t lastTickUs_ = 0;
+    bool haveTick_ = false;
     int currentFps_ = 0;
-    uint32_t frameTimeMs_ = 0;
+    uint32_t frameTimeUs_ = 0;
+    uint32_t jitterUs_ = 0;
+    uint32_t stalls_ = 0;
+    uint32_t stallThresholdUs_ = 0;
+    LatencyHistogram frameHist_;
+    LatencyHistogram stageHist_[kStageCount];
+};
+
+/// Records the lifetime of a scope as one stage sample
+class StageTimer {
+public:
+    StageTimer(FPSCounter& counter, FrameStage stage);
+    ~StageTimer();
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    FPSCounter& counter_;
+    FrameStage stage_;
+    uint32_t startUs_;
 };
 
 }  // namespace pxlcam::util
@@ -0,0 +1,111 @@
+#pragma once
+/**
+ * @file frame_arena.h
+ * @brief One PSRAM block for the frame buffers, shared between phases
+ *
+ * The arena is reserved once at boot (PXLCAM_FRAME_ARENA_BYTES) and carved
+ * from both ends, so the PSRAM heap never sees frame-sized allocations come
+ * and go:
+ *
+ *   bottom: reserve()  buffers held for the life of the program (capture
+ *                      output and pipeline slots, encoder state)
+ *   top:    acquire()  leases of the current phase; all of them are released
+ *                      together when the next phase is entered
+ *
+ * Phases never overlap: the preview session and the capture step use the
+ * same top region in turn. A holder keeps its buffer in a Lease<T>, whose
+ * get() turns nullptr once the phase has ended, and acquires again at the
+ * start of its next session. Nothing is freed piecemeal, so there is no
+ * fragmentation to manage.
+ *
+ * Every block starts at a multiple of its alignment (kDefaultAlign unless
+ * asked for more). A request that does not fit, or is made outside its
+ * phase, returns nullptr and the caller falls back to its own heap
+ * allocation; requests that did not fit are counted in Stats::failures.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam::arena {
+
+enum class Phase : uint8_t {
+    None = 0,   ///< Between sessions: no phase leases
+    Preview,    ///< OLED preview session (MCU band, double buffer)
+    Capture,    ///< Capture step (strip buffer)
+    Count
+};
+
+constexpr size_t kDefaultAlign = 16;    ///< Word and SWAR access on any block
+
+/// Reserve the arena from PSRAM (once; later calls return the first result)
+/// @return false without PSRAM or when the block cannot be had
+bool begin(size_t bytes);
+
+bool isReady();
+
+/// Buffer for the life of the program, from the bottom of the arena
+/// @param align Power of two
+/// @return nullptr if it does not fit
+void* reserve(size_t bytes, const char* name, size_t align = kDefaultAlign);
+
+/// Release every lease of the current phase and start `phase`
+/// Entering the current phase again also releases its leases.
+void enterPhase(Phase phase);
+
+Phase currentPhase();
+
+/// Buffer until the current phase ends, from the top of the arena
+/// @param phase Must be the current phase
+/// @param align Power of two
+/// @return nullptr outside that phase or if it does not fit
+void* acquire(Phase phase, size_t bytes, const char* name, size_t align = kDefaultAlign);
+
+/// Changes every time phase leases are released
+uint32_t generation();
+
+/// True for memory handed out by the arena (never passed to free())
+bool owns(const void* ptr);
+
+/// Phase lease of `count` Ts
+/// get() returns nullptr once the phase it was taken in has ended.
+template <typename T>
+class Lease {
+public:
+    bool acquire(Phase phase, size_t count, const char* name, size_t align = kDefaultAlign) {
+        const size_t minAlign = alignof(T) > align ? alignof(T) : align;
+        generation_ = arena::generation();  // Before: a phase change in between voids the lease
+        ptr_ = static_cast<T*>(arena::acquire(phase, count * sizeof(T), name, minAlign));
+        count_ = ptr_ ? count : 0;
+        return ptr_ != nullptr;
+    }
+
+    T* get() const { return (ptr_ && generation_ == arena::generation()) ? ptr_ : nullptr; }
+    size_t count() const { return get() ? count_ : 0; }
+
+private:
+    T* ptr_ = nullptr;
+    size_t count_ = 0;
+    uint32_t generation_ = 0;
+};
+
+/// Arena telemetry; byte counts include alignment padding
+struct Stats {
+    size_t capacity;        ///< Arena size (0 = not reserved)
+    size_t resident;        ///< reserve() bytes, held for good
+    size_t phaseBytes;      ///< Leased in the current phase
+    size_t highWater;       ///< Peak resident + phase bytes
+    size_t phasePeak[static_cast<size_t>(Phase::Count)];  ///< Peak lease bytes per phase
+    uint32_t blocks;        ///< Successful reserve() and acquire() calls
+    uint32_t failures;      ///< Requests that did not fit (callers fell back)
+    Phase phase;
+};
+
+Stats getStats();
+
+/// One log line with the figures above
+void logStats();
+
+const char* phaseName(Phase phase);
+
+}  // namespace pxlcam::arena
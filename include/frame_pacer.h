@@ -0,0 +1,52 @@
+#pragma once
+/**
+ * @file frame_pacer.h
+ * @brief Deadline-based frame pacing for preview loops
+ */
+
+#include <stdint.h>
+
+namespace pxlcam::util {
+
+/// Paces a loop to a fixed frame period with vTaskDelayUntil()
+///
+/// Each endFrame() sleeps only the slack left before the frame's deadline,
+/// so work time no longer adds to the period. A frame that overruns is
+/// counted as missed and the schedule restarts from now instead of running
+/// catch-up frames back to back.
+class FramePacer {
+public:
+    FramePacer() = default;
+    
+    /// Start pacing from now
+    /// @param targetFps Frames per second; 0 = max fps (never sleeps)
+    void begin(uint16_t targetFps);
+    
+    /// Close the current frame and sleep until the next deadline
+    /// @return true if the frame finished before its deadline
+    bool endFrame();
+    
+    /// Start the next frame period now (after an idle wait that isn't a frame)
+    void resync();
+    
+    /// Ticks left until the current frame's deadline (0 if due or unpaced)
+    uint32_t ticksToDeadline() const;
+    
+    /// Frames closed / deadlines missed since begin()
+    uint32_t getFrames() const { return frames_; }
+    uint32_t getMissedDeadlines() const { return missed_; }
+    
+    /// Slack slept before the last deadline (ms)
+    uint32_t getLastSlackMs() const { return lastSlackMs_; }
+    
+    bool isUnpaced() const { return periodTicks_ == 0; }
+    
+private:
+    uint32_t periodTicks_ = 0;
+    uint32_t lastWake_ = 0;      // TickType_t of the current frame's start
+    uint32_t frames_ = 0;
+    uint32_t missed_ = 0;
+    uint32_t lastSlackMs_ = 0;
+};
+
+}  // namespace pxlcam::util
@@ -0,0 +1,83 @@
+#pragma once
+/**
+ * @file frame_stack.h
+ * @brief Multi-frame stacking of luma frames for low-light captures
+ *
+ * Averaging N frames of a still scene divides the sensor noise by about
+ * sqrt(N) without the smear and banding a long OV2640 exposure brings.
+ * Frames are added into a 16-bit accumulator, two pixels per 32-bit word
+ * (see swar.h for the word conventions), and divided back to 8 bits once
+ * at the end.
+ *
+ * A hand-held camera moves a few pixels between frames. With alignment on,
+ * each frame is matched to the first one by a global shift: its row and
+ * column means are compared with the reference's at every offset up to the
+ * radius (their own mean removed, so an exposure step does not count) and
+ * the best offset is used when it is added. Pixels shifted in from outside
+ * the frame repeat the edge, so every pixel always holds N samples.
+ *
+ * Platform independent so the capture pipeline and host tests can share it.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam::stack {
+
+/// Largest frame (capture pipeline size, QVGA)
+constexpr int kMaxWidth = 320;
+constexpr int kMaxHeight = 240;
+constexpr size_t kMaxPixels = static_cast<size_t>(kMaxWidth) * kMaxHeight;
+
+/// Most frames per stack; 16-bit lanes would overflow past 257
+constexpr uint8_t kMaxFrames = 64;
+
+/// Largest alignment radius in pixels
+constexpr uint8_t kMaxAlignRadius = 16;
+
+class FrameStacker {
+public:
+    FrameStacker() = default;
+
+    /// Start a stack
+    /// @param acc Accumulator of w*h entries, 4-byte aligned (owned by the caller)
+    /// @param alignRadius Largest shift searched (0 = frames added as they are)
+    /// @return false if the size or the accumulator is not usable
+    bool begin(uint16_t* acc, int w, int h, uint8_t alignRadius);
+
+    /// Add a frame; the first one is the alignment reference
+    /// @return false once kMaxFrames are in or before begin()
+    bool add(const uint8_t* gray);
+
+    /// Average of the frames added
+    /// @param out w*h bytes (may be a frame that was added)
+    void finish(uint8_t* out) const;
+
+    uint8_t getFrames() const { return frames_; }
+
+    /// Shift used for the last frame (source offset from the reference)
+    int8_t getShiftX() const { return shiftX_; }
+    int8_t getShiftY() const { return shiftY_; }
+
+    /// Largest |shift| used since begin()
+    uint8_t getMaxShift() const { return maxShift_; }
+
+private:
+    /// Row and column means of a frame, 3 fractional bits
+    void project(const uint8_t* gray, uint16_t* rows, uint16_t* cols) const;
+
+    uint16_t refRows_[kMaxHeight];
+    uint16_t refCols_[kMaxWidth];
+    uint16_t rows_[kMaxHeight];
+    uint16_t cols_[kMaxWidth];
+    uint16_t* acc_ = nullptr;
+    int w_ = 0;
+    int h_ = 0;
+    uint8_t radius_ = 0;
+    uint8_t frames_ = 0;
+    int8_t shiftX_ = 0;
+    int8_t shiftY_ = 0;
+    uint8_t maxShift_ = 0;
+};
+
+}  // namespace pxlcam::stack
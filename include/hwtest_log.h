@@ -7,6 +7,12 @@
  * - Event markers (boot, capture, wifi, etc.)
  * - Error conditions
  * 
+ * Logging never touches the card on the caller's task: records are
+ * formatted into a RAM ring and a low-priority task writes them out in
+ * batches (or logUpdate() does, if the task could not start). Records that
+ * find the ring full are dropped and counted; the count is noted in the
+ * file at the next drain. Rotation follows a tracked byte count.
+ * 
  * @version 1.3.0-HWTEST
  * @date 2024
  */
@@ -44,6 +50,8 @@ struct LogConfig {
     const char* logPath = "/PXL/hwtest.log";  ///< Log file path on SD
     uint32_t flushIntervalMs = 5000;          ///< Auto-flush interval
     uint32_t maxFileSizeKb = 1024;            ///< Max log size before rotate
+    uint32_t ringBytes = 16384;               ///< RAM ring for queued records (PSRAM first)
+    uint32_t batchBytes = 4096;               ///< Queued bytes that wake the drain early
     LogLevel minLevel = LogLevel::INFO;       ///< Minimum level to log
     bool logToSerial = true;                  ///< Also echo to serial
 };
@@ -91,6 +99,8 @@ void logEvent(const char* eventName, const char* detail = nullptr);
 
 /**
  * @brief Flush log buffer to SD
+ * 
+ * Asks the drain task to write and flush; without it, drains inline.
  */
 void logFlush();
 
@@ -102,14 +112,19 @@ bool logIsActive();
 
 /**
  * @brief Get log file size
- * @return File size in bytes
+ * @return Bytes written plus bytes still queued
  */
 uint32_t logGetSize();
 
+/**
+ * @brief Records lost to a full ring since logInit()
+ */
+uint32_t logDroppedCount();
+
 /**
  * @brief Periodic update (for auto-flush)
  * 
- * Call from main tick loop
+ * Call from main tick loop. Only writes when the drain task is not running.
  */
 void logUpdate();
 
@@ -23,8 +23,19 @@
 
 #if PXLCAM_HWTEST
 
+namespace pxlcam::capture {
+struct CaptureTimings;
+struct FrameStats;
+}
+
 namespace pxlcam::hwtest {
 
+/// Capture stages mirrored from pxlcam::capture::CaptureStage
+constexpr uint8_t kCaptureStageSlots = 7;
+
+/// Preview stages mirrored from pxlcam::util::FrameStage
+constexpr uint8_t kPreviewStageSlots = 6;
+
 //==============================================================================
 // Diagnostic Overlay Configuration
 //==============================================================================
@@ -56,6 +67,21 @@ struct SystemMetrics {
     uint32_t captureTimeMs;
     uint32_t filterTimeMs;
     uint32_t saveTimeMs;
+    uint32_t stageUs[kCaptureStageSlots];     ///< Last capture per stage (CaptureStage order)
+    uint32_t stageP95Us[kCaptureStageSlots];  ///< Rolling p95 per stage
+    uint8_t lumaMean;             ///< Last capture source luma mean
+    uint8_t lumaMin;
+    uint8_t lumaMax;
+    uint8_t clippedPct;           ///< Pixels at 0 or 255, percent
+    
+    // Preview frame timing (see preview::getFrameTelemetry())
+    uint32_t previewP50Us;        ///< Frame interval percentiles
+    uint32_t previewP95Us;
+    uint32_t previewP99Us;
+    uint32_t previewMaxUs;
+    uint32_t previewJitterUs;
+    uint32_t previewStalls;       ///< Intervals over PXLCAM_PREVIEW_STALL_MS
+    uint32_t previewStageP95Us[kPreviewStageSlots];  ///< FrameStage order
     
     // WiFi
     bool wifiActive;
@@ -121,8 +147,16 @@ SystemMetrics getMetrics();
  * @param captureMs Time for capture
  * @param filterMs Time for filter processing
  * @param saveMs Time for SD save
+ * @param stages Per-stage profiler timings (may be nullptr)
+ */
+void recordCaptureTiming(uint32_t captureMs, uint32_t filterMs, uint32_t saveMs,
+                         const pxlcam::capture::CaptureTimings* stages = nullptr);
+
+/**
+ * @brief Record source luma statistics of the last capture
+ * @param stats Frame statistics gathered by the capture pass
  */
-void recordCaptureTiming(uint32_t captureMs, uint32_t filterMs, uint32_t saveMs);
+void recordFrameStats(const pxlcam::capture::FrameStats& stats);
 
 /**
  * @brief Increment FPS counter (call once per frame)
@@ -0,0 +1,58 @@
+#pragma once
+/**
+ * @file jpeg_gray_encoder.h
+ * @brief Baseline grayscale JPEG encoder with fixed tables
+ *
+ * For streaming frames that are already 8-bit gray (dithered previews):
+ * one component, the Annex K luminance tables, quantization folded into
+ * the AAN DCT scale factors once in begin(). encode() writes straight into
+ * a caller buffer, so nothing is allocated per frame (frame2jpg() mallocs
+ * a worst-case RGB buffer every call).
+ *
+ * An optional integer upscale repeats source pixels (nearest neighbour)
+ * while blocks are gathered, so pixel art can be sent at 2× without a
+ * 4× larger staging image.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam::jpeg {
+
+class GrayJpegEncoder {
+public:
+    GrayJpegEncoder() = default;
+
+    /// Build the quantization and Huffman tables
+    /// @param quality 1-100 (IJG scaling of the Annex K table)
+    void begin(uint8_t quality);
+
+    bool isReady() const { return ready_; }
+
+    /// Encode a gray image
+    /// @param gray Source pixels (row-major)
+    /// @param width, height Source size
+    /// @param stride Bytes per source row
+    /// @param scale Integer upscale (1-4); the JPEG is width·scale × height·scale
+    /// @param out Output buffer
+    /// @param capacity Output buffer size
+    /// @return JPEG size in bytes, 0 if it did not fit (or bad input)
+    size_t encode(const uint8_t* gray, int width, int height, int stride, int scale,
+                  uint8_t* out, size_t capacity) const;
+
+    /// A capacity that fits any frame of the given output size at quality <= 95
+    static size_t worstCaseSize(int outWidth, int outHeight) {
+        return 1024 + static_cast<size_t>(outWidth) * outHeight;
+    }
+
+private:
+    uint8_t qtable_[64] = {};       ///< Quantizers, zigzag order (as in DQT)
+    float fdtbl_[64] = {};          ///< 1 / (q · AAN scale), natural order
+    uint16_t dcCode_[12] = {};
+    uint8_t dcSize_[12] = {};
+    uint16_t acCode_[256] = {};
+    uint8_t acSize_[256] = {};
+    bool ready_ = false;
+};
+
+}  // namespace pxlcam::jpeg
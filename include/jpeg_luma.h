@@ -0,0 +1,50 @@
+#pragma once
+/**
+ * @file jpeg_luma.h
+ * @brief JPEG → luminance decoder (no RGB888 staging buffer)
+ * 
+ * Wraps the esp32-camera TJpgDec decoder and converts each decoded MCU
+ * block to 8-bit luma as it arrives, so a full-frame RGB888 image is never
+ * materialized. Only one MCU (max 16x16) of RGB exists at a time.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_jpg_decode.h>
+
+namespace pxlcam::jpeg {
+
+/// Luma block sink
+/// Called once with luma == nullptr and (w, h) = output image size before
+/// any block, then once per decoded MCU with w*h row-major luma bytes.
+/// @return false to abort decoding
+using LumaBlockCallback = bool (*)(void* user, uint16_t x, uint16_t y,
+                                   uint16_t w, uint16_t h, const uint8_t* luma);
+
+/// Decode JPEG and stream luma blocks to a callback
+/// @param jpg JPEG data
+/// @param len JPEG length in bytes
+/// @param callback Block sink
+/// @param user Opaque pointer passed to callback
+/// @param scale Decoder downscale (1/1, 1/2, 1/4, 1/8)
+/// @return true if the whole image was decoded
+bool decodeLumaBlocks(const uint8_t* jpg, size_t len,
+                      LumaBlockCallback callback, void* user,
+                      jpg_scale_t scale = JPG_SCALE_NONE);
+
+/// Decode JPEG into a packed grayscale plane (stride = output width)
+/// @param jpg JPEG data
+/// @param len JPEG length in bytes
+/// @param outGray Output buffer (at least maxW * maxH bytes)
+/// @param maxW Maximum accepted output width
+/// @param maxH Maximum accepted output height
+/// @param outW Decoded width (may be nullptr)
+/// @param outH Decoded height (may be nullptr)
+/// @param scale Decoder downscale (1/1, 1/2, 1/4, 1/8)
+/// @return true on success, false on decode error or oversized image
+bool decodeToLuma(const uint8_t* jpg, size_t len, uint8_t* outGray,
+                  uint16_t maxW, uint16_t maxH,
+                  uint16_t* outW = nullptr, uint16_t* outH = nullptr,
+                  jpg_scale_t scale = JPG_SCALE_NONE);
+
+}  // namespace pxlcam::jpeg
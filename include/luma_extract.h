@@ -0,0 +1,84 @@
+#pragma once
+/**
+ * @file luma_extract.h
+ * @brief Stride-aware luma (Y) extraction for raw sensor formats
+ *
+ * GRAYSCALE frames are a packed Y plane. YUV422 frames from the OV2640 are
+ * interleaved Y0 U Y1 V, so luma is every second byte. Both are read as-is,
+ * with no JPEG decode and no color conversion.
+ *
+ * RGB565 frames need a per-pixel weighted sum, done one row at a time so
+ * callers never hold a converted copy of the frame.
+ *
+ * Platform independent (no camera driver types) so the filter pipeline and
+ * host tests can share it.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace pxlcam::luma {
+
+/// Byte distance between consecutive Y samples in a GRAYSCALE row
+constexpr size_t kGrayscaleStep = 1;
+
+/// Byte distance between consecutive Y samples in a YUV422 (YUYV) row
+constexpr size_t kYuv422Step = 2;
+
+/// Bytes per pixel in an RGB565 row
+constexpr size_t kRgb565Step = 2;
+
+/// Luma of one RGB565 pixel in sensor byte order (RRRRRGGG GGGBBBBB)
+/// Same BT.601 weights as the RGB888 paths, with 5/6-bit fields widened by shift.
+inline uint8_t rgb565Luma(uint8_t hi, uint8_t lo) {
+    const uint32_t r = hi & 0xF8;
+    const uint32_t g = ((hi & 0x07) << 5) | ((lo & 0xE0) >> 3);
+    const uint32_t b = (lo & 0x1F) << 3;
+    return static_cast<uint8_t>((77 * r + 150 * g + 29 * b) >> 8);
+}
+
+/// Convert n RGB565 pixels (sensor byte order, as in esp32-camera fb->buf) to luma
+/// @param srcRow First pixel of the row
+/// @param dst Output luma (n bytes, may not alias srcRow)
+/// @param n Number of pixels
+inline void rgb565Row(const uint8_t* srcRow, uint8_t* dst, int n) {
+    for (int i = 0; i < n; i++) {
+        dst[i] = rgb565Luma(srcRow[2 * i], srcRow[2 * i + 1]);
+    }
+}
+
+/// Copy n Y samples from one source row
+/// @param srcRow First Y sample of the row
+/// @param step Bytes between Y samples (kGrayscaleStep or kYuv422Step)
+/// @param dst Output luma (n bytes, must not alias srcRow unless step == 1)
+/// @param n Number of pixels
+inline void extractRow(const uint8_t* srcRow, size_t step, uint8_t* dst, int n) {
+    if (step == kGrayscaleStep) {
+        if (dst != srcRow) {
+            memcpy(dst, srcRow, n);
+        }
+        return;
+    }
+
+    for (int i = 0; i < n; i++) {
+        dst[i] = srcRow[i * step];
+    }
+}
+
+/// Copy a w x h luma plane out of a strided source
+/// @param src First Y sample of the image
+/// @param srcStride Bytes between source rows (w * step for packed frames)
+/// @param step Bytes between Y samples
+/// @param dst Output plane
+/// @param dstStride Bytes between output rows
+/// @param w Width in pixels
+/// @param h Height in pixels
+inline void extractPlane(const uint8_t* src, size_t srcStride, size_t step,
+                         uint8_t* dst, size_t dstStride, int w, int h) {
+    for (int y = 0; y < h; y++) {
+        extractRow(src + y * srcStride, step, dst + y * dstStride, w);
+    }
+}
+
+}  // namespace pxlcam::luma
@@ -0,0 +1,99 @@
+#pragma once
+/**
+ * @file mem_placement.h
+ * @brief Where hot code, tables and row buffers live (IRAM, DRAM, PSRAM)
+ *
+ * With -mfix-esp32-psram-cache-issue every PSRAM access in an inner loop
+ * risks a cache miss plus the workaround's memw, and code or const tables
+ * left in flash go through the same cache. The policy:
+ *
+ *   PXLCAM_HOT_CODE   inner row kernels (dither bands and spans with their
+ *                     inlined format conversion) run from IRAM
+ *   PXLCAM_HOT_DATA   small const tables read per pixel or per row (Bayer
+ *                     matrices) are copied to DRAM instead of flash rodata
+ *   scratch()         buffers with one owner that inner loops read again and
+ *                     again (error rows, 3x3 filter windows) come from a
+ *                     DRAM block reserved at link time, so they never end
+ *                     up in PSRAM or fail once the heap is fragmented
+ *
+ * Frame-sized buffers stay in PSRAM (frame_arena.h). Per-call row buffers
+ * stay on the task stack: every task stack is internal RAM and bands of
+ * the same kernel run on both cores at once, so one shared buffer would
+ * need a lock per row.
+ *
+ * Tables and buffers are registered with note() (scratch() does it) and
+ * logReport() prints where each one actually is. scripts/placement_report.py
+ * writes the link-time view of the same thing next to firmware.elf.
+ *
+ * Platform independent: without ESP32 the attributes are empty, scratch()
+ * uses a plain static block and regions read Unknown.
+ */
+
+#include "pxlcam_config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP32
+#include <esp_attr.h>
+#endif
+
+#if defined(ESP32) && PXLCAM_HOT_IRAM
+#define PXLCAM_HOT_CODE IRAM_ATTR
+#else
+#define PXLCAM_HOT_CODE
+#endif
+
+#ifdef ESP32
+#define PXLCAM_HOT_DATA DRAM_ATTR
+#else
+#define PXLCAM_HOT_DATA
+#endif
+
+namespace pxlcam::placement {
+
+enum class Region : uint8_t {
+    Iram = 0,   ///< Internal instruction RAM
+    Dram,       ///< Internal data RAM (static data, heap, task stacks)
+    Psram,      ///< External RAM behind the cache
+    Flash,      ///< Code or rodata mapped from flash
+    Unknown,    ///< Host build, or an address outside the known ranges
+    Count
+};
+
+const char* regionName(Region region);
+
+/// Memory region of an address
+Region regionOf(const void* ptr);
+
+constexpr size_t kDefaultAlign = 4;     ///< Word (SWAR) access on any block
+
+/// Buffer for the life of the program from the DRAM scratch block
+/// Registered with note(). Never freed.
+/// @param align Power of two
+/// @return nullptr if it does not fit (the caller falls back to the heap)
+void* scratch(size_t bytes, const char* name, size_t align = kDefaultAlign);
+
+/// True for memory handed out by scratch() (never passed to free())
+bool owns(const void* ptr);
+
+/// Register a table, buffer or function for logReport()
+/// Names are not copied. Noting the same pointer again updates its size.
+void note(const char* name, const void* ptr, size_t bytes);
+
+/// Scratch telemetry; byte counts include alignment padding
+struct Stats {
+    size_t capacity;        ///< PXLCAM_DRAM_SCRATCH_BYTES
+    size_t used;            ///< Handed out by scratch()
+    uint32_t blocks;        ///< Successful scratch() calls
+    uint32_t failures;      ///< Requests that did not fit (callers fell back)
+    uint16_t entries;       ///< note() entries held
+    uint16_t dropped;       ///< note() calls past PXLCAM_PLACEMENT_MAX_ENTRIES
+};
+
+Stats getStats();
+
+/// One log line per noted entry (name, region, size, address), then totals
+void logReport();
+
+}  // namespace pxlcam::placement
@@ -0,0 +1,154 @@
+#pragma once
+/**
+ * @file motion_detect.h
+ * @brief Cheap scene-change detector on small grayscale frames
+ *
+ * Compares each frame with a reference frame in 8×8 blocks, using the sum of
+ * absolute differences (SAD) per block. A frame counts as changed when
+ * enough blocks differ by more than a threshold. Round-off and noise spread
+ * evenly over the frame, so they stay under the per-block threshold, while
+ * real motion is concentrated in a few blocks.
+ *
+ * The reference is the last frame reported as changed, not the previous
+ * frame, so slow drift (a cloud, the AEC settling) adds up until it
+ * triggers instead of slipping through frame by frame.
+ *
+ * MotionDetector is the event detector behind motion-triggered timelapse
+ * runs: the same block SAD, but against a background that learns the
+ * scene, with a noise level learned per block, sensitivity zones and a
+ * cool-down between events.
+ *
+ * Platform independent (SWAR on plain words, see swar.h) so the preview,
+ * the timelapse trigger and host tests can share it.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam::motion {
+
+/// Block edge in pixels
+constexpr int kBlockSize = 8;
+
+/// Largest frame the detector keeps a reference for (preview size)
+constexpr int kMaxPixels = 64 * 64;
+
+/// Blocks in a kMaxPixels frame
+constexpr int kMaxBlocks = kMaxPixels / (kBlockSize * kBlockSize);
+
+/// Block SAD over a w×h frame pair
+/// @param a First frame (w*h bytes)
+/// @param b Second frame (w*h bytes)
+/// @param w Width (multiple of kBlockSize)
+/// @param h Height (multiple of kBlockSize)
+/// @param blockSad Output, (w/8)*(h/8) entries in row-major block order
+void blockSad(const uint8_t* a, const uint8_t* b, int w, int h, uint16_t* blockSad);
+
+class ChangeDetector {
+public:
+    struct Config {
+        uint16_t blockThreshold = 384;  ///< SAD above which a block changed (6 per pixel)
+        uint16_t minBlocks = 1;         ///< Changed blocks needed to report a change
+    };
+
+    ChangeDetector() = default;
+
+    /// Set frame size and thresholds; the next update() reports a change
+    /// @return false if w×h is not a block multiple or exceeds kMaxPixels
+    bool begin(int w, int h, const Config& config);
+
+    /// Forget the reference; the next update() reports a change
+    void reset() { primed_ = false; }
+
+    /// Compare a frame with the reference
+    /// @return true if the scene changed (the frame becomes the reference)
+    bool update(const uint8_t* gray);
+
+    /// Blocks over the threshold in the last update()
+    uint16_t getChangedBlocks() const { return changedBlocks_; }
+
+    /// Largest block SAD in the last update()
+    uint16_t getMaxBlockSad() const { return maxBlockSad_; }
+
+    /// Consecutive unchanged frames
+    uint32_t getStaticFrames() const { return staticFrames_; }
+
+private:
+    alignas(4) uint8_t ref_[kMaxPixels];
+    Config config_;
+    int w_ = 0;
+    int h_ = 0;
+    uint16_t changedBlocks_ = 0;
+    uint16_t maxBlockSad_ = 0;
+    uint32_t staticFrames_ = 0;
+    bool primed_ = false;
+};
+
+/// Motion events against an adaptive background
+///
+/// The background is a running average of the frames (4 fractional bits per
+/// pixel). Still blocks are blended in quickly, moving blocks slowly, so
+/// something that stops in the scene becomes background after a while
+/// instead of triggering forever. Each block also tracks its own noise: the
+/// average SAD it shows, learned mostly while it is still. A block moves when its SAD exceeds
+/// noiseFactor times that level (and at least noiseFloor), scaled by its
+/// zone's sensitivity; flickering areas thus need more to trigger than calm
+/// ones. An event is minBlocks moving blocks, at most one per cooldownMs.
+class MotionDetector {
+public:
+    struct Config {
+        uint16_t noiseFloor = 128;      ///< Least block SAD that counts as motion (2 per pixel)
+        uint8_t noiseFactor = 3;        ///< Motion above this multiple of the block noise
+        uint16_t minBlocks = 2;         ///< Moving blocks for an event
+        uint8_t stillShift = 4;         ///< Still blocks join the background at 1/16 per frame
+        uint8_t movingShift = 7;        ///< Moving blocks at 1/128 per frame
+        uint8_t learnFrames = 8;        ///< Frames after begin()/reset() without events
+        uint32_t cooldownMs = 5000;     ///< Quiet time after an event
+    };
+
+    /// Zone sensitivity: 0 ignores a block, 100 is the configured threshold,
+    /// 200 triggers at half of it
+    static constexpr uint8_t kDefaultSensitivity = 100;
+
+    MotionDetector() = default;
+
+    /// Set frame size and thresholds; every block at kDefaultSensitivity
+    /// @return false if w×h is not a block multiple or exceeds kMaxPixels
+    bool begin(int w, int h, const Config& config);
+
+    /// Sensitivity of the blocks [bx0, bx1) × [by0, by1) (block coordinates)
+    void setZone(int bx0, int by0, int bx1, int by1, uint8_t sensitivity);
+
+    /// Learn the background again from the next frame (scene or exposure changed)
+    void reset();
+
+    /// Add a frame
+    /// @param nowMs Time of the frame, for the cool-down
+    /// @return true on a motion event
+    bool update(const uint8_t* gray, uint32_t nowMs);
+
+    /// Moving blocks in the last update()
+    uint16_t getMovingBlocks() const { return movingBlocks_; }
+
+    /// Events reported since begin()
+    uint32_t getEvents() const { return events_; }
+
+    /// Events held back by the cool-down since begin()
+    uint32_t getSuppressed() const { return suppressed_; }
+
+private:
+    uint16_t background_[kMaxPixels];   ///< Q4 running average
+    alignas(4) uint8_t reference_[kMaxPixels];  ///< background_ rounded, for blockSad()
+    uint16_t noise_[kMaxBlocks];        ///< Q4 still-block SAD average
+    uint8_t sensitivity_[kMaxBlocks];
+    Config config_;
+    int w_ = 0;
+    int h_ = 0;
+    uint32_t frames_ = 0;               ///< Frames since the background was reset
+    uint32_t lastEventMs_ = 0;
+    uint32_t events_ = 0;
+    uint32_t suppressed_ = 0;
+    uint16_t movingBlocks_ = 0;
+};
+
+}  // namespace pxlcam::motion
@@ -13,6 +13,7 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 
 namespace pxlcam::nvs {
 
@@ -55,6 +56,7 @@ namespace keys {
     constexpr const char* kBrightness = "brightness";
     constexpr const char* kContrast = "contrast";
     constexpr const char* kFirstBoot = "first_boot";
+    constexpr const char* kWifiFastConnect = "wifi_fast";
 }
 
 //==============================================================================
@@ -121,6 +123,24 @@ bool writeI8(const char* key, int8_t value);
  */
 int8_t readI8(const char* key, int8_t defaultValue = 0);
 
+/**
+ * @brief Store a binary blob
+ * @param key NVS key
+ * @param data Bytes to store
+ * @param len Number of bytes
+ * @return true if stored successfully
+ */
+bool writeBytes(const char* key, const void* data, size_t len);
+
+/**
+ * @brief Read a binary blob
+ * @param key NVS key
+ * @param out Destination buffer
+ * @param len Expected size; a stored blob of any other size is not read
+ * @return true if exactly len bytes were read
+ */
+bool readBytes(const char* key, void* out, size_t len);
+
 /**
  * @brief Check if key exists in NVS
  * @param key NVS key to check
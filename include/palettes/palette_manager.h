@@ -49,6 +49,7 @@ struct Color {
     
     uint16_t toRGB565() const;
     uint32_t toRGB888() const;
+    uint8_t toLuma() const;             ///< BT.601 luma, as the capture's gray conversion
 };
 
 /**
@@ -130,6 +131,33 @@ uint16_t mapToPalette(uint8_t gray);
  */
 uint8_t getPaletteCount();
 
+/**
+ * @brief Enable color indexed output (PXLCAM_CAPTURE_COLOR_OUTPUT)
+ * 
+ * Tone indices stay as they are; only the color table of indexed files
+ * and of the stylized stream changes to the active palette's colors.
+ * @param enabled true for color, false for the gray tones
+ */
+void setColorOutput(bool enabled);
+
+/**
+ * @brief Check whether indexed output uses the active palette's colors
+ * @return true if color output is on
+ */
+bool isColorOutput();
+
+/**
+ * @brief Colors of the 4 tone indices in indexed output
+ * 
+ * With color output, index i takes the active palette's color i (spread
+ * over colorCount colors) and its tone becomes that color's luma, for
+ * grayscale views of the same indices (OLED, MJPEG). Otherwise the gray
+ * tones are repeated as RGB and left unchanged.
+ * @param tones Gray level per index (dark to light), updated in place
+ * @param rgb Output, 3 bytes (R, G, B) per index
+ */
+void indexColors(uint8_t tones[Palette::MAX_COLORS], uint8_t rgb[Palette::MAX_COLORS * 3]);
+
 } // namespace palettes
 } // namespace pxlcam
 
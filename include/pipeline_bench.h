@@ -0,0 +1,84 @@
+#pragma once
+/**
+ * @file pipeline_bench.h
+ * @brief On-device benchmark of every capture pipeline stage
+ *
+ * Times each stage on the real chip: camera grab, JPEG decode, RGB565 to
+ * gray, every postprocess filter, every dither algorithm, the BMP, PNG and
+ * gray JPEG encoders, an SD write and an OLED blit. Each stage runs at
+ * every resolution in PXLCAM_BENCH_FRAMESIZES, once with its working
+ * buffers in PSRAM and once in internal RAM, so the effect of the PSRAM
+ * cache shows up next to the kernel cost. A placement whose buffers do not
+ * fit is reported as one no_mem row.
+ *
+ * Results are CSV, one row per stage, resolution and placement:
+ *
+ *     width,height,memory,stage,runs,min_us,avg_us,max_us,ns_per_px,bytes,status
+ *
+ * (memory is psram, internal, or camera for fb_get; ns_per_px is from the
+ * fastest run; status is ok, no_mem, failed or skipped) kept in memory for
+ * results(), served as /bench by the WiFi preview, and written to
+ * PXLCAM_BENCH_CSV_PATH on the card.
+ *
+ * A sweep takes the camera (frame size changes, frames are grabbed) and
+ * the display for several seconds. requestRun() only flags one; poll(),
+ * from the loop task while nothing else uses the camera, runs it.
+ * filters::dither_debug_benchmark() remains as the quick serial check of
+ * the dither kernels alone.
+ */
+
+#include "pxlcam_config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pxlcam::bench {
+
+/// Where a sweep puts its working buffers
+enum class Placement : uint8_t {
+    Psram = 0,
+    Internal,
+    Count
+};
+
+const char* placementName(Placement placement);
+
+#if PXLCAM_FEATURE_BENCHMARK
+
+/// Run a whole sweep now (blocking); results() has the CSV afterwards
+/// @return false if the camera is not up or the CSV buffer is unavailable
+bool run();
+
+/// Ask for a sweep on the next poll()
+void requestRun();
+
+/// A sweep was requested and has not finished
+bool isPending();
+
+/// True while run() is executing
+bool isRunning();
+
+/// Run a requested sweep; call from the loop task when the camera is idle
+/// @return true if a sweep ran
+bool poll();
+
+/// CSV of the last sweep
+/// @param len Set to its length in bytes (may be nullptr)
+/// @return nullptr before the first sweep (or while one runs)
+const char* results(size_t* len = nullptr);
+
+#else
+
+inline bool run() { return false; }
+inline void requestRun() {}
+inline bool isPending() { return false; }
+inline bool isRunning() { return false; }
+inline bool poll() { return false; }
+inline const char* results(size_t* len = nullptr) {
+    if (len) *len = 0;
+    return nullptr;
+}
+
+#endif  // PXLCAM_FEATURE_BENCHMARK
+
+}  // namespace pxlcam::bench
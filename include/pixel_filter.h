@@ -3,6 +3,9 @@
 #include <cstddef>
 
 #include <esp_camera.h>
+#include <esp_jpg_decode.h>
+
+#include "jpeg_luma.h"
 
 namespace pxlcam::filter {
 
@@ -17,6 +20,44 @@ void init(const FilterConfig &config);
 void apply(camera_fb_t *frame);
 void reset();
 
+// Full-resolution pixelation, in place: every block is replaced by its average.
 void applyPixelFilter(uint8_t *rgbBuffer, size_t length, uint16_t width, uint16_t height, uint8_t blockSize, uint8_t brightnessOffset);
+void applyPixelFilterGray(uint8_t *grayBuffer, size_t length, uint16_t width, uint16_t height, uint8_t blockSize, uint8_t brightnessOffset);
+
+// Scaled-decode pixelation: for blocks of 2, 4 or 8 the JPEG decoder already
+// averages each block (1/2, 1/4, 1/8 output), so a frame is decoded small and
+// its pixels are only repeated back to full size where the output is written.
+
+// Decoder scale for a block size; JPG_SCALE_NONE when the decoder has none.
+jpg_scale_t decodeScaleFor(uint8_t blockSize);
+
+// One pixel per scale x scale block of the full-size frame.
+struct ScaledImage {
+    uint8_t *pixels;
+    uint16_t width;     // Scaled size; full size is width * scale x height * scale.
+    uint16_t height;
+    uint8_t channels;   // 1 (luma) or 3 (RGB888).
+    uint8_t scale;
+};
+
+// Decode a JPEG to luma at 1/blockSize into pixels (maxWidth * maxHeight bytes).
+bool decodeScaled(const uint8_t *jpg, size_t len, uint8_t blockSize, uint8_t brightnessOffset,
+                  uint8_t *pixels, uint16_t maxWidth, uint16_t maxHeight, ScaledImage &out);
+
+// Repeat full-size row y of a scaled image into out (width pixels, clipped to the frame).
+void expandRow(const ScaledImage &image, uint16_t y, uint8_t *out, uint16_t width);
+
+// Grow a scaled image to full size in place; pixels must hold the full-size image.
+void expandInPlace(const ScaledImage &image);
+
+// Luma block sink for jpeg::decodeLumaBlocks() at decodeScaleFor(scale): each
+// scaled block is repeated to full size before it reaches the wrapped sink.
+struct BlockExpander {
+    jpeg::LumaBlockCallback sink;
+    void *user;
+    uint8_t scale;
+};
+
+bool expandBlocks(void *expander, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t *luma);
 
 }  // namespace pxlcam::filter
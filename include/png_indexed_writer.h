@@ -0,0 +1,111 @@
+#pragma once
+/**
+ * @file png_indexed_writer.h
+ * @brief Streaming indexed-color PNG writer (fixed-Huffman deflate)
+ *
+ * For tone-index images (GameBoy captures): 1/2/4/8-bit palette PNG with
+ * a gray PLTE from the caller's tones, or a color one (beginRgb()) for
+ * color-palette captures of the same indices. Rows go in one at a time and file
+ * bytes come out through a sink as IDAT chunks fill, so neither the image
+ * nor the file is held: the writer's state is a fixed window and hash head
+ * table (~13 KB), whatever the image size.
+ *
+ * Compression is one fixed-Huffman deflate block with greedy LZ77 matching
+ * over a 4 KB window. Besides the hash candidate, the byte one row up and
+ * eight rows up (one Bayer period) are tried, which is where ordered
+ * dither repeats itself. Rows use filter type 0.
+ *
+ * Row layout matches filters::DitherOutput::PACKED_2BPP for bit depth 2
+ * (leftmost pixel in the top bits, rows byte-aligned); ditherSink() feeds
+ * a dither_begin() stream straight into the writer.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam::png {
+
+class IndexedPngWriter {
+public:
+    /// Receives file bytes in order; return false to abort the file
+    typedef bool (*Sink)(void* user, const uint8_t* data, size_t len);
+
+    IndexedPngWriter() = default;
+
+    /// Write the signature, IHDR and PLTE
+    /// @param width, height Image size
+    /// @param bitDepth 1, 2, 4 or 8
+    /// @param tones Gray level per palette index
+    /// @param colors Palette entries (1 to 2^bitDepth)
+    /// @param sink Output callback
+    /// @param user Passed through to sink
+    /// @return false on bad parameters or a sink failure
+    bool begin(int width, int height, uint8_t bitDepth, const uint8_t* tones, int colors,
+               Sink sink, void* user);
+
+    /// begin() with a color PLTE
+    /// @param rgb R, G, B per palette index
+    bool beginRgb(int width, int height, uint8_t bitDepth, const uint8_t* rgb, int colors,
+                  Sink sink, void* user);
+
+    /// Compress the next row (rowBytes() bytes)
+    /// @return false once any write failed or all rows were written
+    bool writeRow(const uint8_t* row);
+
+    /// Flush the deflate stream, write the last IDAT and IEND
+    /// @return true if the whole file reached the sink
+    bool finish();
+
+    /// Bytes passed to the sink so far
+    size_t bytesWritten() const { return written_; }
+
+    /// Bytes per packed input row
+    static size_t rowBytes(int width, uint8_t bitDepth) {
+        return (static_cast<size_t>(width) * bitDepth + 7) / 8;
+    }
+
+    /// Largest possible file (every byte a 9-bit literal)
+    static size_t maxSize(int width, int height, uint8_t bitDepth);
+
+    /// filters::DitherRowSink adapter; user is the writer
+    static bool ditherSink(void* user, int y, const uint8_t* data, size_t bytes);
+
+    static constexpr size_t kWindowSize = 8192;     ///< Input history ring
+    static constexpr size_t kMaxDistance = 4096;    ///< Farthest match
+    static constexpr size_t kHashSize = 1024;       ///< Hash heads (3-byte prefixes)
+    static constexpr size_t kChunkSize = 4096;      ///< IDAT payload per chunk
+
+private:
+    bool emit(const uint8_t* data, size_t len);
+    bool emitChunk(const char* type, const uint8_t* data, size_t len);
+    bool flushIdat();
+    void putBits(uint32_t value, uint8_t count);
+    void putCode(uint16_t code, uint8_t count);
+    void putLiteral(uint8_t value);
+    void putMatch(size_t length, size_t distance);
+    void feed(const uint8_t* data, size_t len);
+    void compress(bool final);
+    uint32_t hashAt(size_t pos) const;
+    size_t matchLength(size_t candidate, size_t pos, size_t limit) const;
+
+    Sink sink_ = nullptr;
+    void* user_ = nullptr;
+    size_t written_ = 0;
+    size_t rowBytes_ = 0;
+    int rowsLeft_ = 0;
+    bool ok_ = false;
+
+    uint32_t adler_ = 1;
+    uint32_t bitBuf_ = 0;
+    uint8_t bitCount_ = 0;
+    size_t chunkFill_ = 0;
+
+    size_t inPos_ = 0;      ///< Bytes fed (absolute)
+    size_t encPos_ = 0;     ///< Bytes coded (absolute)
+
+    uint8_t window_[kWindowSize];
+    uint32_t head_[kHashSize];      ///< Last position + 1 per hash, 0 = none
+    uint8_t chunk_[kChunkSize];     ///< IDAT payload being filled
+};
+
+}  // namespace pxlcam::png
@@ -2,16 +2,28 @@
 
 #include <Arduino.h>
 
+#include "fps_counter.h"
+
 namespace pxlcam::preview {
 
 /// Initializes preview system (buffers only)
 void begin();
 
-/// Runs one preview frame: capture, convert, draw
+/// Runs one preview frame on the calling task: capture, convert, draw
 /// Returns true on success
 bool frame();
 
 /// Continuous preview loop (blocking until button press)
+/// With PXLCAM_DOUBLE_BUFFER_PREVIEW a camera task fills the double buffer
+/// while this loop dithers and blits; frames it cannot keep up with are dropped.
 void runPreviewLoop();
 
+/// Preview frame-time telemetry (frame intervals, per-stage histograms)
+/// Summaries are safe to read from any task while the preview runs.
+const pxlcam::util::FPSCounter& getFrameTelemetry();
+
+/// Frames the camera task overwrote before the preview drew them, in the
+/// current (or last) preview session; 0 without PXLCAM_DOUBLE_BUFFER_PREVIEW
+uint32_t getDroppedFrames();
+
 }  // namespace pxlcam::preview
@@ -10,15 +10,24 @@
 #include <stddef.h>
 #include <atomic>
 
+#include "frame_arena.h"
+
 namespace pxlcam::preview {
 
-/// Buffer state flags
-struct BufferState {
-    std::atomic<bool> ready{false};
-    std::atomic<bool> inUse{false};
+/// Buffer slot states
+/// The producer owns the slot at writeIdx_ (never READY or READING); the
+/// consumer owns a slot only while it is READING.
+enum class SlotState : uint8_t {
+    Free = 0,   ///< Producer may write it
+    Ready,      ///< Holds the newest committed frame
+    Reading     ///< Lent to the consumer
 };
 
 /// Double buffer manager for 64x64 grayscale preview
+///
+/// Single producer (camera task), single consumer (display task), no locks.
+/// The newest frame wins: if the consumer has not taken the previous frame
+/// by the next commit, that frame is dropped and counted.
 class DoubleBuffer {
 public:
     static constexpr int kBufferSize = 64 * 64;
@@ -27,28 +36,32 @@ public:
     DoubleBuffer() = default;
     ~DoubleBuffer();
     
-    /// Allocate buffers (PSRAM if available)
+    /// Allocate buffers for a preview session
+    /// A frame arena lease of the Preview phase (call after entering it),
+    /// else one PSRAM/heap block kept until deallocate(). Call again at the
+    /// start of each session: a lease ends with the phase.
     /// @return true if allocation successful
     bool allocate();
     
     /// Free all buffers
     void deallocate();
     
-    /// Check if buffers are allocated
-    bool isAllocated() const { return buffers_[0] != nullptr; }
+    /// Check if buffers are allocated (and their lease still holds)
+    bool isAllocated() const;
     
-    /// Get write buffer (for producer/camera)
+    /// Get write buffer (producer only; never the buffer being read)
     /// @return Pointer to current write buffer
     uint8_t* getWriteBuffer();
     
-    /// Mark write buffer as ready and swap
+    /// Publish the write buffer and move to the other one (producer only)
+    /// Drops the unread frame, or reclaims this one if the consumer is busy.
     void commitWrite();
     
-    /// Get read buffer (for consumer/display)
-    /// @return Pointer to current read buffer, or nullptr if none ready
+    /// Take the newest committed frame (consumer only)
+    /// @return Pointer to the frame, or nullptr if none ready
     uint8_t* getReadBuffer();
     
-    /// Release read buffer
+    /// Give the frame from getReadBuffer() back (consumer only)
     void releaseRead();
     
     /// Check if a buffer is ready for reading
@@ -61,16 +74,28 @@ public:
     int getWriteIndex() const { return writeIdx_; }
     int getReadIndex() const { return readIdx_; }
     
+    /// Frames committed / dropped unread since allocate() or resetStats()
+    uint32_t getCommittedFrames() const { return committed_.load(std::memory_order_relaxed); }
+    uint32_t getDroppedFrames() const { return dropped_.load(std::memory_order_relaxed); }
+    void resetStats();
+    
     /// Get allocation info
     bool isInPSRAM() const { return inPsram_; }
     size_t getTotalAllocation() const;
 
 private:
-    uint8_t* buffers_[2] = {nullptr, nullptr};
+    /// Claim `idx` for writing if it holds an unread frame; counts the drop
+    bool reclaim(int idx);
+    
+    uint8_t* buffers_[2] = {nullptr, nullptr};   ///< Both slots and the bitmap share one block
     uint8_t* bitmapBuffer_ = nullptr;
-    BufferState state_[2];
-    int writeIdx_ = 0;
-    int readIdx_ = 1;
+    uint8_t* heapBlock_ = nullptr;               ///< Heap fallback (owned)
+    arena::Lease<uint8_t> lease_;                ///< Or this session's arena lease
+    std::atomic<SlotState> state_[2] = {{SlotState::Free}, {SlotState::Free}};
+    int writeIdx_ = 0;   // Producer side
+    int readIdx_ = 1;    // Consumer side
+    std::atomic<uint32_t> committed_{0};
+    std::atomic<uint32_t> dropped_{0};
     bool inPsram_ = false;
 };
 
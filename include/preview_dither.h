@@ -7,11 +7,14 @@
  * - Histogram equalization (optional via PXLCAM_ENABLE_HISTEQ)
  * - GameBoy 4-tone LUT + Bayer 8x8 ordered dithering
  * - Floyd-Steinberg error diffusion fallback
+ * - Blue-noise threshold (64x64 void-and-cluster tile, no crosshatch)
  * - Night vision mode (gamma boost + contrast)
  */
 
 #include <stdint.h>
 
+#include "quality_governor.h"
+
 namespace pxlcam::dither {
 
 /// Dithering mode selection
@@ -19,9 +22,19 @@ enum class DitherMode : uint8_t {
     Threshold = 0,      ///< Simple threshold (fastest)
     GameBoy = 1,        ///< GB-style LUT + Bayer ordered dither
     FloydSteinberg = 2, ///< Error diffusion (best quality, slower)
-    Night = 3           ///< Night vision enhanced + threshold
+    Night = 3,          ///< Night vision enhanced + threshold
+    BlueNoise = 4       ///< Blue-noise threshold (ordered cost, no pattern)
+};
+
+/// 1-bit bitmap layouts produced by the dither functions
+enum class BitmapLayout : uint8_t {
+    RowMajor = 0,   ///< Row-major, MSB-first ((w*h+7)/8 bytes)
+    Pages = 1       ///< SSD1306 pages: byte (y/8)*w + x, bit y%8 (w*((h+7)/8) bytes)
 };
 
+/// Bytes of a w×h bitmap in a layout
+int bitmapBytes(int w, int h, BitmapLayout layout);
+
 /// Initialize LUTs and PSRAM buffers. Call once in preview::begin()
 /// @param useGameBoyLUT Enable GameBoy palette remapping
 void initDitherModule(bool useGameBoyLUT = true);
@@ -41,19 +54,72 @@ DitherMode getDitherMode();
 /// @param h Height
 void histogramEqualize(uint8_t* gray, int w, int h);
 
+/// Histogram equalization for a stream of preview frames
+///
+/// The remap LUT is an IIR blend of the per-frame equalization curves, so
+/// it settles instead of flickering. The curve itself (CDF) is recomputed
+/// only every PXLCAM_HISTEQ_REBUILD_FRAMES frames, or sooner when the coarse
+/// histogram has moved by PXLCAM_HISTEQ_CHANGE_PCT. Callers supply the
+/// histogram (e.g. from the downscale pass), so a frame costs one LUT pass.
+class TemporalEqualizer {
+public:
+    TemporalEqualizer() { reset(); }
+    
+    /// Forget history; the next update() snaps to that frame's curve
+    void reset();
+    
+    /// Feed the next frame's histogram
+    /// @param hist 256 bins
+    /// @param pixels Sum of the bins
+    void update(const uint32_t* hist, uint32_t pixels);
+    
+    /// Remap n pixels in place with the current LUT
+    void apply(uint8_t* gray, int n) const;
+    
+    /// Current remap (256 entries)
+    const uint8_t* getLut() const { return lut_; }
+    
+    /// CDFs computed since reset()
+    uint32_t getRebuilds() const { return rebuilds_; }
+    
+private:
+    static constexpr int kCoarseBins = 16;
+    
+    uint16_t target_[256];          ///< Last equalization curve (8.8 fixed point)
+    uint16_t blend_[256];           ///< IIR-smoothed curve (8.8 fixed point)
+    uint8_t lut_[256];              ///< Rounded blend_
+    uint32_t coarse_[kCoarseBins];  ///< Coarse histogram at the last rebuild
+    uint32_t framesSinceRebuild_ = 0;
+    uint32_t rebuilds_ = 0;
+    bool primed_ = false;
+};
+
 /// Apply GameBoy-style remap + ordered Bayer 8x8 dithering
 /// @param gray Input grayscale (w*h bytes, 8-bit)
 /// @param w Width
 /// @param h Height  
-/// @param outBitmap Output 1-bit packed bitmap ((w*h+7)/8 bytes, row-major, MSB-first)
-void applyGameBoyDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap);
+/// @param outBitmap Output 1-bit packed bitmap (bitmapBytes(w, h, layout))
+/// @param layout Bitmap layout
+void applyGameBoyDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap,
+                        BitmapLayout layout = BitmapLayout::RowMajor);
 
 /// Floyd-Steinberg error-diffusion fallback
 /// @param gray Input grayscale (w*h bytes)
 /// @param w Width
 /// @param h Height
 /// @param outBitmap Output 1-bit packed bitmap
-void applyFloydSteinbergDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap);
+/// @param layout Bitmap layout
+void applyFloydSteinbergDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap,
+                               BitmapLayout layout = BitmapLayout::RowMajor);
+
+/// Blue-noise threshold dithering (same cost as the Bayer path)
+/// @param gray Input grayscale (w*h bytes)
+/// @param w Width
+/// @param h Height
+/// @param outBitmap Output 1-bit packed bitmap
+/// @param layout Bitmap layout
+void applyBlueNoiseDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap,
+                          BitmapLayout layout = BitmapLayout::RowMajor);
 
 /// Simple threshold conversion (fastest)
 /// @param gray Input grayscale (w*h bytes)
@@ -61,7 +127,9 @@ void applyFloydSteinbergDither(const uint8_t* gray, int w, int h, uint8_t* outBi
 /// @param h Height
 /// @param outBitmap Output 1-bit packed bitmap
 /// @param threshold Threshold value (default 128)
-void convertTo1bitThreshold(const uint8_t* gray, int w, int h, uint8_t* outBitmap, uint8_t threshold = 128);
+/// @param layout Bitmap layout
+void convertTo1bitThreshold(const uint8_t* gray, int w, int h, uint8_t* outBitmap, uint8_t threshold = 128,
+                            BitmapLayout layout = BitmapLayout::RowMajor);
 
 /// Apply night vision enhancement (gamma boost + contrast)
 /// @param gray Grayscale buffer (modified in-place)
@@ -77,7 +145,21 @@ void applyNightVision(uint8_t* gray, int w, int h, float gammaBoost = 0.6f, floa
 /// @param h Height
 /// @param outBitmap Output 1-bit packed bitmap
 /// @param enableHistEq Apply histogram equalization first
-void processDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap, bool enableHistEq = false);
+/// @param layout Bitmap layout (Pages feeds display::drawPreviewPages())
+void processDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap, bool enableHistEq = false,
+                   BitmapLayout layout = BitmapLayout::RowMajor);
+
+/// Dither at a governor quality level (see quality_governor.h)
+/// Error diffusion, blue-noise and Bayer levels run on filters::dither_pipeline
+/// (falls back to a threshold when PXLCAM_FEATURE_STYLIZED_CAPTURE is off)
+/// @param gray Input grayscale (w*h bytes)
+/// @param w Width
+/// @param h Height
+/// @param outBitmap Output 1-bit bitmap
+/// @param level Quality level
+/// @param layout Bitmap layout
+void ditherAtLevel(const uint8_t* gray, int w, int h, uint8_t* outBitmap, QualityLevel level,
+                   BitmapLayout layout = BitmapLayout::RowMajor);
 
 /// Self-test for dither module (returns true if passed)
 bool selfTest();
@@ -91,6 +91,49 @@
 #define PXLCAM_FEATURE_RGB888_EXPERIMENTAL 0
 #endif
 
+/**
+ * @brief Enable Native Sensor Luma Capture
+ * 
+ * Boot the OV2640 in PIXFORMAT_GRAYSCALE (or YUV422) instead of JPEG.
+ * The capture pipeline and preview read Y directly from the frame, skipping
+ * JPEG encode on the sensor and decode on the CPU. Falls back to JPEG if
+ * init fails. Saved legacy frames become .raw; the WiFi preview re-encodes
+ * frames to JPEG on the fly.
+ * 
+ * Memory impact: QVGA frame buffers grow to 75KB (GRAYSCALE) / 150KB (YUV422)
+ * Default: 0 (disabled - JPEG safe mode)
+ */
+#ifndef PXLCAM_FEATURE_SENSOR_LUMA
+#define PXLCAM_FEATURE_SENSOR_LUMA 0
+#endif
+
+/**
+ * @brief Use YUV422 instead of GRAYSCALE for native luma capture
+ * 
+ * Some OV2640 modules produce unstable GRAYSCALE output; YUV422 carries
+ * the same Y samples interleaved with chroma at twice the frame size.
+ * 
+ * Default: 0 (GRAYSCALE)
+ */
+#ifndef PXLCAM_SENSOR_LUMA_YUV422
+#define PXLCAM_SENSOR_LUMA_YUV422 0
+#endif
+
+/**
+ * @brief Enable Native Sensor RGB565 Capture
+ * 
+ * Boot the OV2640 in PIXFORMAT_RGB565. Capture, preview and the stylized
+ * dither hook (applyStylizedFrame) convert fb->buf to luma one row at a
+ * time; the frame is never decoded or copied. Tried after native luma
+ * (if enabled), before RGB888 / JPEG fallback.
+ * 
+ * Memory impact: QVGA frame buffers are 150KB (RGB888 needs 225KB)
+ * Default: 0 (disabled - JPEG safe mode)
+ */
+#ifndef PXLCAM_FEATURE_SENSOR_RGB565
+#define PXLCAM_FEATURE_SENSOR_RGB565 0
+#endif
+
 // =============================================================================
 // LEGACY FEATURE FLAGS (v1.2.0 and earlier)
 // =============================================================================
@@ -100,6 +143,21 @@
 #define PXLCAM_ENABLE_HISTEQ 0
 #endif
 
+/// Preview HE: recompute the equalization curve at least every N frames
+#ifndef PXLCAM_HISTEQ_REBUILD_FRAMES
+#define PXLCAM_HISTEQ_REBUILD_FRAMES 8
+#endif
+
+/// Preview HE: recompute early when this % of pixels changed 16-level bin
+#ifndef PXLCAM_HISTEQ_CHANGE_PCT
+#define PXLCAM_HISTEQ_CHANGE_PCT 15
+#endif
+
+/// Preview HE: LUT smoothing, each frame moves 1/2^shift toward the curve
+#ifndef PXLCAM_HISTEQ_IIR_SHIFT
+#define PXLCAM_HISTEQ_IIR_SHIFT 2
+#endif
+
 /// Enable night vision mode
 #ifndef PXLCAM_ENABLE_NIGHT
 #define PXLCAM_ENABLE_NIGHT 1
@@ -120,6 +178,17 @@
 #define PXLCAM_AUTO_EXPOSURE 1
 #endif
 
+/// Live view sensor profile (sensor_profile.h): contrast (-2..2) and AGC
+/// gain ceiling. The defaults match the capture profile, so entering and
+/// leaving the preview writes nothing
+#ifndef PXLCAM_SENSOR_PREVIEW_CONTRAST
+#define PXLCAM_SENSOR_PREVIEW_CONTRAST 0
+#endif
+
+#ifndef PXLCAM_SENSOR_PREVIEW_GAINCEILING
+#define PXLCAM_SENSOR_PREVIEW_GAINCEILING GAINCEILING_2X
+#endif
+
 /// Enable UI overlay (status bar, icons)
 #ifndef PXLCAM_UI_OVERLAY
 #define PXLCAM_UI_OVERLAY 1
@@ -143,8 +212,93 @@
 #define PXLCAM_PREVIEW_W 64
 #define PXLCAM_PREVIEW_H 64
 
-/// Target preview FPS
+/// Preview frame sources
+#define PXLCAM_PREVIEW_SOURCE_FULL   0  ///< Decode the capture framesize at full scale
+#define PXLCAM_PREVIEW_SOURCE_SCALED 1  ///< JPEG decoder downscale (1/2, 1/4, 1/8) that still covers the preview
+#define PXLCAM_PREVIEW_SOURCE_SENSOR 2  ///< Sensor at PXLCAM_PREVIEW_SENSOR_FRAMESIZE while previewing (plus scaled decode)
+
+/// Where preview frames come from; only the 64×64 result reaches the display either way
+#ifndef PXLCAM_PREVIEW_SOURCE
+#define PXLCAM_PREVIEW_SOURCE PXLCAM_PREVIEW_SOURCE_SENSOR
+#endif
+
+/**
+ * @brief Preview camera mode (camera_config.h, setCameraMode())
+ * 
+ * With PXLCAM_PREVIEW_SOURCE_SENSOR the preview loop switches the sensor
+ * to this framesize and JPEG quality and back to the capture mode when it
+ * exits: a set_framesize() and the frames begun before it, no driver
+ * restart. Clamped to the capture framesize. Quality 0 keeps the
+ * capture quality.
+ */
+#ifndef PXLCAM_PREVIEW_SENSOR_FRAMESIZE
+#define PXLCAM_PREVIEW_SENSOR_FRAMESIZE FRAMESIZE_QQVGA
+#endif
+#ifndef PXLCAM_PREVIEW_JPEG_QUALITY
+#define PXLCAM_PREVIEW_JPEG_QUALITY 20
+#endif
+
+/// Most frames a mode switch drops waiting for one begun after it (frame
+/// buffers plus the one being read out)
+#ifndef PXLCAM_CAMERA_MODE_FLUSH_MAX
+#define PXLCAM_CAMERA_MODE_FLUSH_MAX 4
+#endif
+
+/// Core running the preview camera task (fb_get + downscale) with
+/// PXLCAM_DOUBLE_BUFFER_PREVIEW; the preview loop dithers and blits on its own core
+#ifndef PXLCAM_PREVIEW_CAMERA_CORE
+#define PXLCAM_PREVIEW_CAMERA_CORE 0
+#endif
+
+/// Stack size for the preview camera task (bytes)
+#ifndef PXLCAM_PREVIEW_TASK_STACK
+#define PXLCAM_PREVIEW_TASK_STACK 4096
+#endif
+
+/// FreeRTOS priority for the preview camera task (Arduino loopTask runs at 1)
+#ifndef PXLCAM_PREVIEW_TASK_PRIORITY
+#define PXLCAM_PREVIEW_TASK_PRIORITY 2
+#endif
+
+/// Target preview FPS (frame deadlines are paced with vTaskDelayUntil)
+#ifndef PXLCAM_TARGET_FPS
 #define PXLCAM_TARGET_FPS 20
+#endif
+
+/// Preview frame intervals above this count as stalls in the telemetry (ms)
+#ifndef PXLCAM_PREVIEW_STALL_MS
+#define PXLCAM_PREVIEW_STALL_MS 150
+#endif
+
+/// Skip dither/blit/flush while the 64x64 preview frame is unchanged
+#ifndef PXLCAM_PREVIEW_MOTION_SKIP
+#define PXLCAM_PREVIEW_MOTION_SKIP 1
+#endif
+
+/// Preview change detector: 8x8 block SAD above this marks the block changed
+#ifndef PXLCAM_MOTION_BLOCK_SAD
+#define PXLCAM_MOTION_BLOCK_SAD 384
+#endif
+
+/// Preview change detector: changed blocks needed to redraw
+#ifndef PXLCAM_MOTION_MIN_BLOCKS
+#define PXLCAM_MOTION_MIN_BLOCKS 1
+#endif
+
+/// Capture interval while the preview scene is static (ms)
+#ifndef PXLCAM_PREVIEW_IDLE_MS
+#define PXLCAM_PREVIEW_IDLE_MS 100
+#endif
+
+/// Auto preview mode picks the dither algorithm that fits the frame budget
+#ifndef PXLCAM_PREVIEW_GOVERNOR
+#define PXLCAM_PREVIEW_GOVERNOR PXLCAM_GAMEBOY_DITHER
+#endif
+
+/// 1 = run the preview loop unpaced (no sleep, as fast as capture allows)
+#ifndef PXLCAM_PREVIEW_MAX_FPS
+#define PXLCAM_PREVIEW_MAX_FPS 0
+#endif
 
 /// Frame delay for target FPS (ms)
 #define PXLCAM_FRAME_DELAY_MS (1000 / PXLCAM_TARGET_FPS)
@@ -156,7 +310,7 @@
 // DITHERING CONFIGURATION
 // =============================================================================
 
-/// Default dither mode (0=Threshold, 1=GameBoy, 2=FloydSteinberg, 3=Night)
+/// Default dither mode (0=Threshold, 1=GameBoy, 2=FloydSteinberg, 3=Night, 4=BlueNoise)
 #define PXLCAM_DEFAULT_DITHER_MODE 1
 
 /// Histogram equalization default state
@@ -188,6 +342,27 @@
 /// Button debounce time (ms)
 #define PXLCAM_DEBOUNCE_MS 50
 
+/**
+ * @brief Read the button through a GPIO interrupt (button_irq.h)
+ * 
+ * Edges are timestamped in the interrupt and debounced by a lockout timer,
+ * so a press is seen at once whatever the loop is doing. 0 samples the
+ * pin from the input task instead.
+ */
+#ifndef PXLCAM_BUTTON_IRQ
+#define PXLCAM_BUTTON_IRQ 1
+#endif
+
+/// Debounced button transitions that can wait for the input task
+#ifndef PXLCAM_BUTTON_EDGE_QUEUE
+#define PXLCAM_BUTTON_EDGE_QUEUE 16
+#endif
+
+/// Let the button wake the chip from a timelapse light sleep (needs PXLCAM_BUTTON_IRQ)
+#ifndef PXLCAM_BUTTON_WAKE
+#define PXLCAM_BUTTON_WAKE 1
+#endif
+
 // =============================================================================
 // NVS CONFIGURATION (v1.2.0)
 // =============================================================================
@@ -207,6 +382,589 @@
 #define PXLCAM_ENABLE_MENU 1
 #endif
 
+// =============================================================================
+// CAPTURE PIPELINE CONFIGURATION
+// =============================================================================
+
+/**
+ * @brief Enable dual-core pipelined capture engine
+ * 
+ * When enabled, capture::init() starts a producer task (frame grab + decode)
+ * and a consumer task (filter + encode) pinned to different cores, connected
+ * by bounded queues. Consecutive captures (burst, timelapse) overlap decode
+ * and stylization instead of running back to back on the caller's thread.
+ * 
+ * Memory impact: (QUEUE_DEPTH - 1) extra BMP buffers + QUEUE_DEPTH grayscale
+ * slots in PSRAM (~77KB each at QVGA)
+ * Default: 1 (enabled)
+ */
+#ifndef PXLCAM_CAPTURE_PIPELINED
+#define PXLCAM_CAPTURE_PIPELINED 1
+#endif
+
+/// Frames in flight between producer and consumer (grayscale and output slots)
+#ifndef PXLCAM_CAPTURE_QUEUE_DEPTH
+#define PXLCAM_CAPTURE_QUEUE_DEPTH 2
+#endif
+
+/// Core running the producer task (esp_camera_fb_get + JPEG decode)
+#ifndef PXLCAM_CAPTURE_PRODUCER_CORE
+#define PXLCAM_CAPTURE_PRODUCER_CORE 0
+#endif
+
+/// Core running the consumer task (mode filter + BMP encode)
+#ifndef PXLCAM_CAPTURE_CONSUMER_CORE
+#define PXLCAM_CAPTURE_CONSUMER_CORE 1
+#endif
+
+/// Stack size for each pipeline task (bytes)
+#ifndef PXLCAM_CAPTURE_TASK_STACK
+#define PXLCAM_CAPTURE_TASK_STACK 6144
+#endif
+
+/// FreeRTOS priority for pipeline tasks (Arduino loopTask runs at 1)
+#ifndef PXLCAM_CAPTURE_TASK_PRIORITY
+#define PXLCAM_CAPTURE_TASK_PRIORITY 2
+#endif
+
+/// Default capture output format (pxlcam::capture::OutputFormat)
+/// 0 = 8-bit BMP, 1 = 4-bit indexed BMP, 2 = 2-bit .pxl, 3 = 2-bit indexed PNG
+/// Indexed formats apply to GameBoy captures; other modes save 8-bit BMP.
+#ifndef PXLCAM_CAPTURE_OUTPUT_FORMAT
+#define PXLCAM_CAPTURE_OUTPUT_FORMAT 0
+#endif
+
+/// Run-length encode GameBoy BMP captures (8-bit → BI_RLE8, 4-bit → BI_RLE4)
+/// RLE4 codes the period-2 Bayer patterns, so 4-bit frames shrink to a
+/// fraction of their size (shorter SD writes and WiFi downloads); RLE8 only
+/// gains on flat areas. Rows are packed during the capture pass. Strip
+/// captures stay uncompressed; RLE frames are saved one file each in timelapse.
+#ifndef PXLCAM_CAPTURE_BMP_RLE
+#define PXLCAM_CAPTURE_BMP_RLE 0
+#endif
+
+/// Thumbnail sidecar: a 64x64 1-bit thumbnail (SSD1306 page layout, 512
+/// bytes) is downscaled from the finished output rows during the capture
+/// pass and appended to the folder's THUMBS.IDX (see thumbnail_index.h)
+#ifndef PXLCAM_CAPTURE_THUMBNAILS
+#define PXLCAM_CAPTURE_THUMBNAILS 1
+#endif
+
+/// Strip capture: stylized captures at full sensor resolution streamed to SD
+/// The camera is initialised at PXLCAM_STRIP_CAPTURE_FRAMESIZE, preview runs
+/// at QVGA, and each capture switches up, streams strips, and switches back.
+#ifndef PXLCAM_STRIP_CAPTURE
+#define PXLCAM_STRIP_CAPTURE 0
+#endif
+
+/// Sensor resolution used for strip captures
+#ifndef PXLCAM_STRIP_CAPTURE_FRAMESIZE
+#define PXLCAM_STRIP_CAPTURE_FRAMESIZE FRAMESIZE_UXGA
+#endif
+
+/// Largest frame accepted by strip capture (UXGA)
+#ifndef PXLCAM_STRIP_MAX_WIDTH
+#define PXLCAM_STRIP_MAX_WIDTH 1600
+#endif
+
+#ifndef PXLCAM_STRIP_MAX_HEIGHT
+#define PXLCAM_STRIP_MAX_HEIGHT 1200
+#endif
+
+/// Rows per strip (must hold one JPEG MCU row: 16)
+#ifndef PXLCAM_STRIP_ROWS
+#define PXLCAM_STRIP_ROWS 16
+#endif
+
+/**
+ * @brief Zero-shutter-lag capture from a ring of pre-decoded frames
+ * 
+ * When enabled, capture::init() starts a low-priority task that keeps the
+ * latest PXLCAM_ZSL_DEPTH frames decoded to luma while the camera is idle or
+ * previewing. A shutter press stylizes the ring frame closest to the press
+ * time, so neither sensor exposure nor fb_get/decode sits between button and
+ * shutter.
+ * 
+ * Memory impact: PXLCAM_ZSL_DEPTH luma slots in PSRAM (~77KB each at QVGA),
+ * plus one BMP buffer when the pipelined engine owns the default one.
+ * Not started with PXLCAM_STRIP_CAPTURE (the ring runs at preview resolution).
+ * Default: 0 (disabled)
+ */
+#ifndef PXLCAM_CAPTURE_ZSL
+#define PXLCAM_CAPTURE_ZSL 0
+#endif
+
+/// Decoded frames kept in the ZSL ring (>= 2: one refills while one is read)
+#ifndef PXLCAM_ZSL_DEPTH
+#define PXLCAM_ZSL_DEPTH 3
+#endif
+
+/// Delay between ring refills (ms); bounds the filler's share of its core
+#ifndef PXLCAM_ZSL_INTERVAL_MS
+#define PXLCAM_ZSL_INTERVAL_MS 100
+#endif
+
+/// Ring frames further than this from the press are never used (ms)
+/// A capture with no frame in range falls back to a fresh fb_get.
+#ifndef PXLCAM_ZSL_MAX_AGE_MS
+#define PXLCAM_ZSL_MAX_AGE_MS 300
+#endif
+
+/// Core running the ZSL ring filler (WiFi also lives on core 0)
+#ifndef PXLCAM_ZSL_CORE
+#define PXLCAM_ZSL_CORE 0
+#endif
+
+/// FreeRTOS priority for the ZSL filler (below the pipeline tasks)
+#ifndef PXLCAM_ZSL_TASK_PRIORITY
+#define PXLCAM_ZSL_TASK_PRIORITY 1
+#endif
+
+/**
+ * @brief Burst capture into a ring of luma frames (TimelapseMode::BURST)
+ * 
+ * capture::captureBurst() grabs frames back to back, decoding each to luma
+ * into a PSRAM ring and nothing more; stylize and encode run afterwards, one
+ * frame per developBurstFrame(), while the SD writer drains the results.
+ * The grab rate is then set by the sensor and the decode, not by the card.
+ * 
+ * Memory impact: PXLCAM_BURST_DEPTH luma frames (~77KB each at QVGA),
+ * allocated from the PSRAM heap for the run and freed by releaseBurst().
+ * Not built with PXLCAM_STRIP_CAPTURE (the ring holds whole frames).
+ * Default: 1 (enabled)
+ */
+#ifndef PXLCAM_CAPTURE_BURST
+#define PXLCAM_CAPTURE_BURST 1
+#endif
+
+/// Most frames a single burst holds
+#ifndef PXLCAM_BURST_DEPTH
+#define PXLCAM_BURST_DEPTH 12
+#endif
+
+/// Default spacing of burst frames (ms); 0 = as fast as the sensor delivers
+#ifndef PXLCAM_BURST_INTERVAL_MS
+#define PXLCAM_BURST_INTERVAL_MS 0
+#endif
+
+/**
+ * @brief Night captures average several frames (frame_stack.h)
+ * 
+ * CaptureMode::Night grabs this many consecutive frames, aligns each to the
+ * first by a global shift and averages them before the night tone curve.
+ * Noise drops by about sqrt(N); the shot takes N frame times.
+ * 
+ * Memory impact: a 16-bit accumulator and one luma frame (~230KB at QVGA),
+ * leased from the capture phase of the frame arena, else the PSRAM heap.
+ * Not used with PXLCAM_STRIP_CAPTURE. 1 = single frame.
+ * Default: 8
+ */
+#ifndef PXLCAM_NIGHT_STACK_FRAMES
+#define PXLCAM_NIGHT_STACK_FRAMES 8
+#endif
+
+/// Largest shift (pixels) searched when aligning stacked frames; 0 = no alignment
+#ifndef PXLCAM_NIGHT_STACK_ALIGN
+#define PXLCAM_NIGHT_STACK_ALIGN 8
+#endif
+
+/**
+ * @brief Postprocess chain in captures (filters/postprocess.h)
+ * 
+ * The chain set with postprocess_set_config() / postprocess_load_preset()
+ * runs on every capture's gray rows, after the gray conversion and before
+ * the stylize, and is timed as the "postprocess" profiler stage. Pointwise
+ * runs cost one table lookup per pixel; each 3x3 filter delays the rows by
+ * one. Histogram EQ uses the previous capture's histogram. JPEG luma is
+ * first collected one MCU row (16 rows) at a time.
+ * 
+ * Memory impact: a few rows per 3x3 filter plus the 16-row band, kept in
+ * PSRAM once a chain ran; no frame buffer. An empty chain costs nothing.
+ * Default: 1 (enabled)
+ */
+#ifndef PXLCAM_CAPTURE_POSTPROCESS
+#define PXLCAM_CAPTURE_POSTPROCESS 1
+#endif
+
+/// 3x3 filters (sharpen, denoise) a capture runs at most; later ones are skipped
+#ifndef PXLCAM_CAPTURE_POSTPROCESS_WINDOWS
+#define PXLCAM_CAPTURE_POSTPROCESS_WINDOWS 2
+#endif
+
+/// Chain loaded at boot (filters::PostProcessPreset, 0 = none)
+#ifndef PXLCAM_CAPTURE_POSTPROCESS_PRESET
+#define PXLCAM_CAPTURE_POSTPROCESS_PRESET 0
+#endif
+
+/**
+ * @brief Pixel-art block size of captures (capture::setPixelBlock())
+ * 
+ * With 2, 4 or 8 a JPEG frame is decoded at 1/2, 1/4 or 1/8 scale, where
+ * each decoded pixel is the average of its block, and the pixels are only
+ * repeated back to full size as the output is written: larger blocks make
+ * captures cheaper. Frames whose size is not a multiple of the block, raw
+ * sensor formats and night stacks are not pixelated.
+ * 
+ * Memory impact: none (one 16x16 block on the stack)
+ * Default: 1 (off)
+ */
+#ifndef PXLCAM_CAPTURE_PIXEL_BLOCK
+#define PXLCAM_CAPTURE_PIXEL_BLOCK 1
+#endif
+
+/**
+ * @brief Color indexed output at boot (palettes::setColorOutput())
+ * 
+ * GameBoy captures keep their 4 dither indices, but the Bmp4 / PNG color
+ * table and the stylized stream carry the active palettes::Palette colors
+ * (GameBoy green, CGA, synthwave, thermal...) instead of gray tones. Bmp8
+ * GameBoy captures are written as Bmp4. Same size and cost as the gray
+ * indexed path; gray views (OLED thumbnail, MJPEG) show the colors' luma.
+ * Needs PXL_V13_EXPERIMENTAL (palette manager).
+ * Default: 0 (gray tones)
+ */
+#ifndef PXLCAM_CAPTURE_COLOR_OUTPUT
+#define PXLCAM_CAPTURE_COLOR_OUTPUT 0
+#endif
+
+/// Log frame statistics and sample tones after every capture (debug)
+/// Statistics are always gathered; this only controls the formatted logging.
+#ifndef PXLCAM_CAPTURE_LOG_STATS
+#define PXLCAM_CAPTURE_LOG_STATS 0
+#endif
+
+/// Captures kept per stage by the capture profiler (min/avg/p95 window)
+#ifndef PXLCAM_CAPTURE_TIMING_WINDOW
+#define PXLCAM_CAPTURE_TIMING_WINDOW 32
+#endif
+
+// =============================================================================
+// STORAGE CONFIGURATION
+// =============================================================================
+
+/// initSD() tries faster SD_MMC bus settings first and keeps the first
+/// one that passes a write/read-back benchmark (1-bit 40 MHz, then 20 MHz)
+#ifndef PXLCAM_SD_PROBE_BUS
+#define PXLCAM_SD_PROBE_BUS 1
+#endif
+
+/// Let the probe try 4-bit mode first. On the ESP32-CAM, D1-D3 are GPIO 4
+/// (flash LED), 12 (the shutter button here) and 13: enable only on boards
+/// that leave those pins to the card.
+#ifndef PXLCAM_SD_ALLOW_4BIT
+#define PXLCAM_SD_ALLOW_4BIT 0
+#endif
+
+/// Bytes written and read back per bus candidate at mount
+#ifndef PXLCAM_SD_BENCH_BYTES
+#define PXLCAM_SD_BENCH_BYTES (64 * 1024)
+#endif
+
+/// Images queued for the background SD writer (each owns a PSRAM copy)
+/// When every slot is taken the next save waits for one (backpressure).
+#ifndef PXLCAM_SD_WRITE_QUEUE_DEPTH
+#define PXLCAM_SD_WRITE_QUEUE_DEPTH 3
+#endif
+
+/// Longest a save waits for a free queue slot before writing inline (ms)
+#ifndef PXLCAM_SD_WRITE_WAIT_MS
+#define PXLCAM_SD_WRITE_WAIT_MS 3000
+#endif
+
+/// Bytes per card write: files leave a DMA-capable buffer in pieces of this
+/// size, each starting on a multiple of it (sector aligned; must be a
+/// multiple of 512). Two buffers are kept in internal RAM while mounted.
+#ifndef PXLCAM_SD_WRITE_CHUNK
+#define PXLCAM_SD_WRITE_CHUNK 8192
+#endif
+
+/// Timelapse frames go into one AVI per run instead of a BMP each
+/// (see timelapse_sequence.h); 0 keeps one file per frame
+#ifndef PXLCAM_TIMELAPSE_CONTAINER
+#define PXLCAM_TIMELAPSE_CONTAINER 1
+#endif
+
+/// Playback rate written into timelapse AVIs (frames per second)
+#ifndef PXLCAM_TIMELAPSE_AVI_FPS
+#define PXLCAM_TIMELAPSE_AVI_FPS 10
+#endif
+
+/// Frames preallocated for a timelapse without a frame limit
+#ifndef PXLCAM_TIMELAPSE_PREALLOC_FRAMES
+#define PXLCAM_TIMELAPSE_PREALLOC_FRAMES 240
+#endif
+
+/// Timelapse intervals from this long (ms) sleep in deep sleep between
+/// frames: state kept in RTC memory, one capture per wake, one file per
+/// frame (the AVI needs the card stream open across frames). 0 = light
+/// sleep only
+#ifndef PXLCAM_TIMELAPSE_DEEP_SLEEP_MS
+#define PXLCAM_TIMELAPSE_DEEP_SLEEP_MS 60000
+#endif
+
+/// Camera warm-up after a timelapse sleep (exposure::warmUp()): frames at
+/// PXLCAM_WARMUP_FRAMESIZE until the mean luma moves by at most
+/// PXLCAM_WARMUP_LUMA_DELTA for PXLCAM_WARMUP_STABLE_FRAMES frames in a row,
+/// for no longer than PXLCAM_WARMUP_MAX_MS
+#ifndef PXLCAM_WARMUP_MAX_MS
+#define PXLCAM_WARMUP_MAX_MS 1500
+#endif
+
+#ifndef PXLCAM_WARMUP_FRAMESIZE
+#define PXLCAM_WARMUP_FRAMESIZE FRAMESIZE_QQVGA
+#endif
+
+#ifndef PXLCAM_WARMUP_LUMA_DELTA
+#define PXLCAM_WARMUP_LUMA_DELTA 3
+#endif
+
+#ifndef PXLCAM_WARMUP_STABLE_FRAMES
+#define PXLCAM_WARMUP_STABLE_FRAMES 2
+#endif
+
+/// Timelapse runs started from the menu wait for motion instead of a timer
+/// (TimelapseMode::MOTION_TRIGGERED); the interval setting is not used
+#ifndef PXLCAM_TIMELAPSE_MOTION_TRIGGER
+#define PXLCAM_TIMELAPSE_MOTION_TRIGGER 0
+#endif
+
+/// Timelapse runs started from the menu shoot one burst of this many frames
+/// (TimelapseMode::BURST, PXLCAM_BURST_INTERVAL_MS apart); 0 = off
+#ifndef PXLCAM_TIMELAPSE_BURST_FRAMES
+#define PXLCAM_TIMELAPSE_BURST_FRAMES 0
+#endif
+
+/// Motion trigger: sensor framesize while watching (downscaled to 64x64)
+#ifndef PXLCAM_MOTION_FRAMESIZE
+#define PXLCAM_MOTION_FRAMESIZE FRAMESIZE_96X96
+#endif
+
+/// Motion trigger: least 8x8 block SAD that counts as motion
+#ifndef PXLCAM_MOTION_NOISE_FLOOR
+#define PXLCAM_MOTION_NOISE_FLOOR 128
+#endif
+
+/// Motion trigger: a block moves above this multiple of its learned noise
+#ifndef PXLCAM_MOTION_NOISE_FACTOR
+#define PXLCAM_MOTION_NOISE_FACTOR 3
+#endif
+
+/// Motion trigger: moving blocks (of 64) for an event
+#ifndef PXLCAM_MOTION_EVENT_BLOCKS
+#define PXLCAM_MOTION_EVENT_BLOCKS 2
+#endif
+
+/// Motion trigger: least time between two triggered captures (ms)
+#ifndef PXLCAM_MOTION_COOLDOWN_MS
+#define PXLCAM_MOTION_COOLDOWN_MS 5000
+#endif
+
+/**
+ * @brief Current drawn in each energy_meter state (µA)
+ * 
+ * Turn the time per state into the charge estimates of energy::getReport()
+ * (mAh per frame, average current). Defaults are ESP32-CAM bench figures
+ * (OV2640, SSD1306, 240 MHz); measure a board and override them before
+ * sizing a battery. WIFI is the radio's share, on top of the CPU state.
+ */
+#ifndef PXLCAM_POWER_UA_IDLE
+#define PXLCAM_POWER_UA_IDLE 75000
+#endif
+
+#ifndef PXLCAM_POWER_UA_CAPTURE
+#define PXLCAM_POWER_UA_CAPTURE 150000
+#endif
+
+#ifndef PXLCAM_POWER_UA_SAVE
+#define PXLCAM_POWER_UA_SAVE 180000
+#endif
+
+#ifndef PXLCAM_POWER_UA_DISPLAY
+#define PXLCAM_POWER_UA_DISPLAY 90000
+#endif
+
+/// Sensor in standby, PSRAM kept
+#ifndef PXLCAM_POWER_UA_LIGHT_SLEEP
+#define PXLCAM_POWER_UA_LIGHT_SLEEP 6000
+#endif
+
+/// Board regulator and PSRAM leakage; the chip alone draws ~10 µA
+#ifndef PXLCAM_POWER_UA_DEEP_SLEEP
+#define PXLCAM_POWER_UA_DEEP_SLEEP 4000
+#endif
+
+#ifndef PXLCAM_POWER_UA_WIFI
+#define PXLCAM_POWER_UA_WIFI 100000
+#endif
+
+/// Captures per DCIM subfolder (/DCIM/100PXLCM, 101PXLCM, ...), so no
+/// directory grows long enough to slow FAT lookups down
+#ifndef PXLCAM_FILES_PER_FOLDER
+#define PXLCAM_FILES_PER_FOLDER 999
+#endif
+
+/// File numbers reserved per NVS write; a reset skips at most this many
+#ifndef PXLCAM_FILE_NUMBER_BATCH
+#define PXLCAM_FILE_NUMBER_BATCH 32
+#endif
+
+/// Core and priority of the SD writer task (below the capture pipeline)
+#ifndef PXLCAM_SD_WRITER_CORE
+#define PXLCAM_SD_WRITER_CORE 0
+#endif
+#ifndef PXLCAM_SD_WRITER_PRIORITY
+#define PXLCAM_SD_WRITER_PRIORITY 1
+#endif
+
+/// Stack for the SD writer task (FatFs + SDMMC driver)
+#ifndef PXLCAM_SD_WRITER_STACK
+#define PXLCAM_SD_WRITER_STACK 4096
+#endif
+
+// =============================================================================
+// WIFI STREAMING
+// =============================================================================
+
+/// JPEG slots shared by the stream clients (>= 2: one fills while one is read)
+/// One capture task publishes into the ring; each client sends the newest
+/// slot and skips the ones it was too slow for.
+#ifndef PXLCAM_STREAM_SLOTS
+#define PXLCAM_STREAM_SLOTS 3
+#endif
+
+/// Core running the stream capture task (the WiFi stack lives on core 0)
+#ifndef PXLCAM_STREAM_CAPTURE_CORE
+#define PXLCAM_STREAM_CAPTURE_CORE 0
+#endif
+
+/// FreeRTOS priority for the stream capture task
+#ifndef PXLCAM_STREAM_TASK_PRIORITY
+#define PXLCAM_STREAM_TASK_PRIORITY 1
+#endif
+
+/// Stack for the stream capture task (frame2jpg and the JPEG luma decode)
+#ifndef PXLCAM_STREAM_TASK_STACK
+#define PXLCAM_STREAM_TASK_STACK 6144
+#endif
+
+/// WebSocket stream frame size (palette-dithered, 2 bits per pixel)
+#ifndef PXLCAM_WS_STREAM_W
+#define PXLCAM_WS_STREAM_W 160
+#endif
+#ifndef PXLCAM_WS_STREAM_H
+#define PXLCAM_WS_STREAM_H 120
+#endif
+
+/// /stylized MJPEG: the WebSocket frame as a grayscale JPEG of the palette
+/// tones, at this quality (1-100) and integer upscale (1-4; the page scales
+/// it with pixelated rendering, so 1 keeps the frames small)
+#ifndef PXLCAM_STYLIZED_MJPEG_QUALITY
+#define PXLCAM_STYLIZED_MJPEG_QUALITY 85
+#endif
+#ifndef PXLCAM_STYLIZED_MJPEG_SCALE
+#define PXLCAM_STYLIZED_MJPEG_SCALE 1
+#endif
+
+/// Keep the stream capture pipeline this long after the last stream
+/// client leaves, so a page reload doesn't rebuild it (ms)
+#ifndef PXLCAM_WIFI_PIPELINE_IDLE_MS
+#define PXLCAM_WIFI_PIPELINE_IDLE_MS 5000
+#endif
+
+/// Default WifiPreviewConfig::autoOffMs: WiFi off after this long without
+/// clients (ms, 0 = never)
+#ifndef PXLCAM_WIFI_AUTO_OFF_MS
+#define PXLCAM_WIFI_AUTO_OFF_MS 600000
+#endif
+
+/// Fast-reconnect attempt (cached BSSID/channel/IP) before a full scan (ms)
+#ifndef PXLCAM_WIFI_FAST_CONNECT_MS
+#define PXLCAM_WIFI_FAST_CONNECT_MS 1500
+#endif
+
+/// Full STA connect (scan + DHCP) timeout (ms)
+#ifndef PXLCAM_WIFI_CONNECT_TIMEOUT_MS
+#define PXLCAM_WIFI_CONNECT_TIMEOUT_MS 10000
+#endif
+
+/// Priority of /files listing and download tasks (below the live stream)
+#ifndef PXLCAM_FILES_TASK_PRIORITY
+#define PXLCAM_FILES_TASK_PRIORITY 0
+#endif
+
+/// Entries per /files page
+#ifndef PXLCAM_FILES_PAGE_SIZE
+#define PXLCAM_FILES_PAGE_SIZE 50
+#endif
+
+/// Per-client MJPEG latency target: a client whose frame writes take longer
+/// gets a lower JPEG quality vote and slower pacing (ms)
+#ifndef PXLCAM_STREAM_LATENCY_MS
+#define PXLCAM_STREAM_LATENCY_MS 200
+#endif
+
+/// Lowest JPEG quality (0-100) the rate control may pick
+#ifndef PXLCAM_STREAM_MIN_QUALITY
+#define PXLCAM_STREAM_MIN_QUALITY 10
+#endif
+
+/// WebSocket frames between forced keyframes (others are delta + RLE coded)
+#ifndef PXLCAM_WS_KEYFRAME_INTERVAL
+#define PXLCAM_WS_KEYFRAME_INTERVAL 60
+#endif
+
+/// Stack for each client sender task (/stream, /capture and WebSocket)
+#ifndef PXLCAM_STREAM_SENDER_STACK
+#define PXLCAM_STREAM_SENDER_STACK 4096
+#endif
+
+/// A client whose socket accepts nothing for this long is dropped (ms)
+#ifndef PXLCAM_STREAM_SEND_TIMEOUT_MS
+#define PXLCAM_STREAM_SEND_TIMEOUT_MS 2000
+#endif
+
+// =============================================================================
+// BENCHMARK
+// =============================================================================
+
+/**
+ * @brief On-device pipeline benchmark (pipeline_bench.h)
+ * 
+ * Times every capture stage per resolution with buffers in PSRAM and in
+ * internal RAM. Started by 'b' on the serial console in HWTEST builds, at
+ * the end of the self-test, or from /bench?run=1 on the WiFi preview.
+ * 
+ * Default: on in HWTEST and self-test builds
+ */
+#ifndef PXLCAM_FEATURE_BENCHMARK
+#if defined(PXLCAM_SELFTEST) || (defined(PXLCAM_HWTEST) && PXLCAM_HWTEST)
+#define PXLCAM_FEATURE_BENCHMARK 1
+#else
+#define PXLCAM_FEATURE_BENCHMARK 0
+#endif
+#endif
+
+/// Sensor sizes a sweep covers (each must fit the size the camera was
+/// initialized with; larger ones are skipped)
+#ifndef PXLCAM_BENCH_FRAMESIZES
+#define PXLCAM_BENCH_FRAMESIZES FRAMESIZE_QQVGA, FRAMESIZE_QVGA, FRAMESIZE_VGA
+#endif
+
+/// Timed runs per stage (min / avg / max are over these)
+#ifndef PXLCAM_BENCH_RUNS
+#define PXLCAM_BENCH_RUNS 5
+#endif
+
+/// CSV kept for /bench (PSRAM); rows that do not fit are dropped
+#ifndef PXLCAM_BENCH_CSV_BYTES
+#define PXLCAM_BENCH_CSV_BYTES (16 * 1024)
+#endif
+
+/// Where a sweep's CSV is written on the card
+#ifndef PXLCAM_BENCH_CSV_PATH
+#define PXLCAM_BENCH_CSV_PATH "/bench/results.csv"
+#endif
+
 // =============================================================================
 // PSRAM CONFIGURATION
 // =============================================================================
@@ -216,3 +974,195 @@
 
 /// Fallback to single buffer if PSRAM below this
 #define PXLCAM_PSRAM_LOW_THRESHOLD (1 * 1024 * 1024)
+
+/**
+ * @brief Frame arena size (bytes), reserved from PSRAM at boot
+ *
+ * Capture output, pipeline and ZSL slots and encoder state live at the
+ * bottom for good; preview and capture buffers share the top in turn
+ * (frame_arena.h). Buffers that do not fit fall back to the PSRAM heap.
+ * The default covers QVGA with PXLCAM_CAPTURE_QUEUE_DEPTH 2 plus the
+ * ZSL ring when enabled. 0 disables the arena.
+ */
+#ifndef PXLCAM_FRAME_ARENA_BYTES
+#define PXLCAM_FRAME_ARENA_BYTES \
+    ((416 + (PXLCAM_CAPTURE_ZSL ? 75 * PXLCAM_ZSL_DEPTH + 79 : 0)) * 1024)
+#endif
+
+// =============================================================================
+// MEMORY PLACEMENT
+// =============================================================================
+
+/**
+ * @brief Run the inner row kernels from IRAM (ESP32 only)
+ * 
+ * PXLCAM_HOT_CODE (mem_placement.h): the ordered-dither bands and the
+ * error-diffusion spans, each with its format conversion inlined (one
+ * band per source format and kernel, see the build's placement report for
+ * the IRAM they take). 0 leaves them in flash behind the cache.
+ */
+#ifndef PXLCAM_HOT_IRAM
+#define PXLCAM_HOT_IRAM 1
+#endif
+
+/**
+ * @brief DRAM scratch block (bytes), reserved at link time
+ * 
+ * Kept buffers that inner loops read per pixel: the dither error ring
+ * (5 KB) and the capture chain's 3x3 filter windows (4.7 KB at 320
+ * wide with PXLCAM_CAPTURE_POSTPROCESS_WINDOWS 2). Requests that do not
+ * fit fall back to the heap. 0 disables the block.
+ */
+#ifndef PXLCAM_DRAM_SCRATCH_BYTES
+#define PXLCAM_DRAM_SCRATCH_BYTES (10 * 1024)
+#endif
+
+/// Tables and buffers placement::logReport() can list
+#ifndef PXLCAM_PLACEMENT_MAX_ENTRIES
+#define PXLCAM_PLACEMENT_MAX_ENTRIES 28
+#endif
+
+// =============================================================================
+// APP TASKS
+// =============================================================================
+
+/**
+ * @brief Run the app as FreeRTOS tasks talking through a queue
+ * 
+ * Input sampling, the capture itself and the WiFi server each get a task;
+ * the AppController state machine stays on the Arduino loop task and
+ * sleeps on its event queue between events (app_controller.h). 0 goes
+ * back to one polling loop doing all of it in turn.
+ */
+#ifndef PXLCAM_APP_TASKS
+#define PXLCAM_APP_TASKS 1
+#endif
+
+/// Events the controller can have waiting (button, capture done, burst progress)
+#ifndef PXLCAM_APP_EVENT_QUEUE
+#define PXLCAM_APP_EVENT_QUEUE 16
+#endif
+
+/// Longest the controller sleeps without an event (timelapse deadlines, SD completions)
+#ifndef PXLCAM_APP_TICK_MS
+#define PXLCAM_APP_TICK_MS 10
+#endif
+
+/// Priority of the controller (loop task): draws and menus may be slow
+#ifndef PXLCAM_APP_CONTROLLER_PRIORITY
+#define PXLCAM_APP_CONTROLLER_PRIORITY 1
+#endif
+
+/// Button sampling period (ms) and its task: above everything it reports to
+/// With PXLCAM_BUTTON_IRQ the task sleeps until an edge comes; the period
+/// then only paces hold detection, and PXLCAM_INPUT_IDLE_MS the rest
+/// (console keys, modal screens closing).
+#ifndef PXLCAM_INPUT_POLL_MS
+#define PXLCAM_INPUT_POLL_MS 5
+#endif
+#ifndef PXLCAM_INPUT_IDLE_MS
+#define PXLCAM_INPUT_IDLE_MS 100
+#endif
+#ifndef PXLCAM_INPUT_TASK_CORE
+#define PXLCAM_INPUT_TASK_CORE 1
+#endif
+#ifndef PXLCAM_INPUT_TASK_PRIORITY
+#define PXLCAM_INPUT_TASK_PRIORITY 4
+#endif
+#ifndef PXLCAM_INPUT_TASK_STACK
+#define PXLCAM_INPUT_TASK_STACK 3072
+#endif
+
+/// Shutter task: takes the shot while the controller draws; above the
+/// controller so a draw never delays the grab. Stack as the loop task's,
+/// which ran the same capture calls before.
+#ifndef PXLCAM_SHOT_TASK_CORE
+#define PXLCAM_SHOT_TASK_CORE 1
+#endif
+#ifndef PXLCAM_SHOT_TASK_PRIORITY
+#define PXLCAM_SHOT_TASK_PRIORITY 3
+#endif
+#ifndef PXLCAM_SHOT_TASK_STACK
+#define PXLCAM_SHOT_TASK_STACK 8192
+#endif
+
+/// WiFi server task (HTTP handlers, WebSocket accepts) and its poll period (ms)
+/// On the WiFi stack's core, at the stream tasks' priority.
+#ifndef PXLCAM_NET_POLL_MS
+#define PXLCAM_NET_POLL_MS 5
+#endif
+#ifndef PXLCAM_NET_TASK_CORE
+#define PXLCAM_NET_TASK_CORE 0
+#endif
+#ifndef PXLCAM_NET_TASK_PRIORITY
+#define PXLCAM_NET_TASK_PRIORITY 1
+#endif
+#ifndef PXLCAM_NET_TASK_STACK
+#define PXLCAM_NET_TASK_STACK 6144
+#endif
+
+// =============================================================================
+// TRACE
+// =============================================================================
+
+/**
+ * @brief Event trace of capture, stream, SD and display spans (trace.h)
+ * 
+ * Rings of 16-byte events, one per core, exported as Chrome trace JSON
+ * at /trace.json and to the card ('t' on the HWTEST console). Off, the
+ * instrumentation compiles away.
+ */
+#ifndef PXLCAM_TRACE
+#define PXLCAM_TRACE 1
+#endif
+
+/// Events each core's ring keeps (power of two; 1024 is 16 KB per core, in PSRAM)
+#ifndef PXLCAM_TRACE_EVENTS
+#define PXLCAM_TRACE_EVENTS 1024
+#endif
+
+/// Tasks named in the export; events of any further task go to one "other" row
+#ifndef PXLCAM_TRACE_TASKS
+#define PXLCAM_TRACE_TASKS 16
+#endif
+
+// =============================================================================
+// CAMERA SERVICE
+// =============================================================================
+
+/**
+ * @brief One task reads the camera for every frame consumer (camera_service.h)
+ * 
+ * Preview, WiFi stream and still, capture, ZSL and motion watch register
+ * as consumers; a readout goes to everyone waiting and is reference
+ * counted. Above each consumer's priority so deliveries are not delayed,
+ * on the core where the camera driver runs. 0 lets each consumer read
+ * the driver directly again.
+ */
+#ifndef PXLCAM_CAMERA_SERVICE
+#define PXLCAM_CAMERA_SERVICE 1
+#endif
+#ifndef PXLCAM_CAMERA_SERVICE_CORE
+#define PXLCAM_CAMERA_SERVICE_CORE 0
+#endif
+#ifndef PXLCAM_CAMERA_SERVICE_PRIORITY
+#define PXLCAM_CAMERA_SERVICE_PRIORITY 3
+#endif
+#ifndef PXLCAM_CAMERA_SERVICE_STACK
+#define PXLCAM_CAMERA_SERVICE_STACK 4096
+#endif
+
+/// Consumers that can be registered at once
+#ifndef PXLCAM_FRAME_CONSUMERS
+#define PXLCAM_FRAME_CONSUMERS 8
+#endif
+
+/// Longest acquire() waits by default (ms); above the driver's own timeout
+#ifndef PXLCAM_FRAME_WAIT_MS
+#define PXLCAM_FRAME_WAIT_MS 5000
+#endif
+
+/// A Latest consumer takes a frame another one holds if read this recently (ms)
+#ifndef PXLCAM_FRAME_SHARE_MS
+#define PXLCAM_FRAME_SHARE_MS 40
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+/**
+ * @file quality_governor.h
+ * @brief Picks the best preview dither level that fits the frame budget
+ *
+ * Levels are ordered from best looking (and most expensive) to cheapest.
+ * The governor learns what each level costs on this device (EWMA of the
+ * measured dither time) and watches the frame work time:
+ * - when frames overrun the budget for a few frames in a row it steps down
+ *   to the next cheaper level
+ * - when the better level's measured cost fits in the current slack for a
+ *   while it steps back up; a level that had to be abandoned is retried
+ *   with an exponentially growing cooldown so the choice doesn't oscillate
+ *
+ * Pure logic: callers pass measured microseconds, so host tests can drive it.
+ */
+
+#include <stdint.h>
+
+namespace pxlcam::dither {
+
+/// Preview dither levels, best first
+enum class QualityLevel : uint8_t {
+    FloydSteinberg = 0,  ///< Error diffusion, 4 neighbours
+    Atkinson,            ///< Error diffusion, 6 neighbours, 3/4 of the error
+    BlueNoise,           ///< 64x64 void-and-cluster threshold
+    Bayer8,              ///< Ordered 8x8
+    Bayer4,              ///< Ordered 4x4
+    Threshold,           ///< Plain threshold (always fits)
+    Count
+};
+
+/// Three-letter tag for the status bar ("FS", "ATK", "BN", ...)
+const char* getQualityTag(QualityLevel level);
+
+class QualityGovernor {
+public:
+    struct Config {
+        uint32_t budgetUs = 50000;    ///< Frame work time to stay under
+        uint8_t headroomPct = 85;     ///< Step up only if the estimate fits this % of budget
+        uint8_t overrunFrames = 3;    ///< Consecutive overruns before stepping down
+        uint8_t calmFrames = 30;      ///< Consecutive calm frames before stepping up
+        uint16_t cooldownFrames = 60; ///< First retry delay for an abandoned level
+    };
+
+    QualityGovernor() = default;
+
+    /// Start at the best level with no cost history
+    void begin(const Config& config);
+
+    /// Level to use for the next frame
+    QualityLevel current() const { return level_; }
+
+    /// Report one frame
+    /// @param ditherUs Time the current level's dither took
+    /// @param workUs Whole frame work time (excluding pacing sleep)
+    /// @return true if the level changed
+    bool update(uint32_t ditherUs, uint32_t workUs);
+
+    /// Learned cost of a level (0 = never measured)
+    uint32_t getCostUs(QualityLevel level) const;
+
+    /// Level changes since begin()
+    uint32_t getSwitches() const { return switches_; }
+
+private:
+    static constexpr int kLevels = static_cast<int>(QualityLevel::Count);
+
+    void setLevel(int level);
+
+    Config config_;
+    uint32_t costUs_[kLevels] = {0};        ///< EWMA, 1/8 gain
+    uint32_t retryAfter_[kLevels] = {0};    ///< Frame number a level may be retried
+    uint16_t cooldown_[kLevels] = {0};      ///< Current retry delay per level
+    QualityLevel level_ = QualityLevel::FloydSteinberg;
+    uint32_t frame_ = 0;
+    uint32_t switches_ = 0;
+    uint8_t overruns_ = 0;
+    uint8_t calm_ = 0;
+};
+
+}  // namespace pxlcam::dither
@@ -0,0 +1,64 @@
+#pragma once
+/**
+ * @file rate_controller.h
+ * @brief Per-client MJPEG rate control against a latency target
+ *
+ * Each stream client measures how long writing a frame blocks (the socket
+ * send buffer is full, so the time is queueing on the link) and how many
+ * bytes per second actually leave. From that it picks:
+ *
+ * - A frame interval: never send faster than the link drains, with 25%
+ *   headroom, so frames don't pile up in the TCP buffer and arrive late
+ * - A JPEG quality wish: cut by a quarter when a frame takes longer than
+ *   the latency target, raised slowly while frames take under half of it
+ *
+ * A slow viewer therefore gets fewer, smaller frames instead of lag, and
+ * never slows down anyone else's stream.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam::stream {
+
+struct RateConfig {
+    uint16_t latencyMs = 200;       ///< Longest acceptable frame write
+    uint16_t minIntervalMs = 0;     ///< Fastest pacing (capture rate)
+    uint16_t maxIntervalMs = 2000;  ///< Slowest pacing
+    uint8_t minQuality = 10;        ///< Quality floor (0-100)
+    uint8_t maxQuality = 100;       ///< Quality ceiling (0-100)
+};
+
+class RateController {
+public:
+    RateController() = default;
+
+    /// Start at the ceiling quality and the fastest interval
+    void begin(const RateConfig& config);
+
+    /// Record one frame
+    /// @param bytes Bytes written for the frame (headers included)
+    /// @param sendUs Time the write took
+    void onFrameSent(size_t bytes, uint32_t sendUs);
+
+    /// Minimum time between this client's frames
+    uint32_t intervalMs() const { return intervalMs_; }
+
+    /// JPEG quality this client can take (0-100)
+    uint8_t quality() const { return quality_; }
+
+    /// Smoothed write time (µs) and link throughput (bytes/s)
+    uint32_t sendUsAvg() const { return sendUsAvg_; }
+    uint32_t throughputBps() const { return throughputBps_; }
+
+private:
+    RateConfig config_;
+    uint32_t intervalMs_ = 0;
+    uint32_t sendUsAvg_ = 0;
+    uint32_t throughputBps_ = 0;
+    uint8_t quality_ = 100;
+    uint8_t holdFrames_ = 0;        ///< Frames left before the next quality change
+    bool primed_ = false;
+};
+
+}  // namespace pxlcam::stream
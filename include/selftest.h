@@ -3,7 +3,8 @@
 namespace pxlcam::selftest {
 
 /// Executa rotina completa de diagnóstico do hardware.
-/// Testa: Serial, PSRAM, Display, Botão (GPIO12), Heap.
+/// Testa: Serial, PSRAM, Display, Botão (GPIO12), Heap e, com
+/// PXLCAM_FEATURE_BENCHMARK, mede o pipeline (CSV na serial).
 /// Após finalizar, entra em loop infinito.
 /// Só é compilado quando -DPXLCAM_SELFTEST está definido.
 void run();
@@ -0,0 +1,90 @@
+#pragma once
+/**
+ * @file sensor_profile.h
+ * @brief Shadow of the OV2640 settings and named profiles
+ *
+ * Every esp32-camera setter is one or more SCCB transactions, whether or not
+ * the value changes, and a write that lands while a frame is being read out
+ * can tear it. Settings therefore go through a shadow: callers stage the
+ * settings they want (a whole profile, or a profile with a field changed)
+ * and the difference from what the sensor holds is written in one batch,
+ * right after the frame owner has dequeued a frame (atFrameBoundary()).
+ * A value the sensor already holds is never written again.
+ *
+ * The shadow starts empty after initCamera() (markUnknown()); the first
+ * batch then writes every field. Standby keeps the registers and the shadow.
+ * The manual exposure and gain values are only written, and only known,
+ * while the matching automatic control is off.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam::sensor {
+
+/// Sensor settings the firmware changes at run time
+struct Settings {
+    int8_t brightness;      ///< -2..2
+    int8_t contrast;        ///< -2..2
+    int8_t saturation;      ///< -2..2
+    bool autoExposure;      ///< AEC
+    bool autoGain;          ///< AGC
+    int8_t aeLevel;         ///< AEC target offset -2..2 (AEC on)
+    uint16_t aecValue;      ///< Exposure time 0..1200 (AEC off)
+    uint8_t agcGain;        ///< Gain 0..30 (AGC off)
+    uint8_t gainCeiling;    ///< gainceiling_t, AGC limit
+};
+
+enum class Profile : uint8_t {
+    Standard = 0,   ///< Sensor defaults, AEC/AGC on
+    Night,          ///< Long manual exposure, high gain
+    Preview,        ///< Live view (PXLCAM_SENSOR_PREVIEW_*)
+    Capture,        ///< Still capture
+    Count
+};
+
+/// Built-in settings of a profile
+Settings profileSettings(Profile profile);
+const char* profileName(Profile profile);
+
+/// Settings to reach at the next frame boundary (replaces anything staged)
+/// @param profile Profile they are based on (Count keeps the current name:
+///                one field of it changed)
+void stage(const Settings& settings, Profile profile = Profile::Count);
+void stageProfile(Profile profile);
+
+/// What was last staged (or applied): the base for changing one field
+Settings target();
+
+/// Profile the staged settings are based on
+Profile currentProfile();
+
+/// Something is staged that the sensor does not hold yet
+bool pending();
+
+/// Write what is staged now; call where no frame is being read out (before
+/// streaming starts, or right after a frame was dequeued)
+/// @return Registers written (setter calls)
+uint8_t apply();
+
+/// Frame owners call this right after esp_camera_fb_get() returned a frame;
+/// applies a pending batch, otherwise costs a flag test
+inline void atFrameBoundary() {
+    if (pending()) {
+        apply();
+    }
+}
+
+/// The sensor was (re)initialized: its registers are the driver defaults
+void markUnknown();
+
+struct Stats {
+    uint32_t batches;   ///< apply() calls that wrote something
+    uint32_t writes;    ///< Setter calls made
+    uint32_t skipped;   ///< Staged fields the sensor already held
+    uint32_t failed;    ///< Setter calls that returned an error
+};
+
+Stats getStats();
+
+}  // namespace pxlcam::sensor
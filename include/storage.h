@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 #include <esp_camera.h>
 
@@ -11,11 +12,84 @@ struct StorageConfig {
     const char *mountPoint;          // e.g. "/sdcard"
     size_t maxFileSizeBytes;         // Optional sanity guard, 0 disables the check.
     bool enableTimestampedFolders;   // Reserved for higher-level session management.
+    bool probeBus;                   // Try faster bus settings first (PXLCAM_SD_PROBE_BUS)
+    bool allow4Bit;                  // Include 4-bit mode in the probe (PXLCAM_SD_ALLOW_4BIT)
+    bool quickMount;                 // Reuse the bus setting of the last probe, no benchmark
+};
+
+// What initSD() settled on. The mount benchmark writes and reads back
+// PXLCAM_SD_BENCH_BYTES; a candidate that fails either is dropped. The
+// setting that passed is kept in RTC memory: with quickMount, a boot out of
+// deep sleep mounts with it straight away (candidatesTried 1, speeds 0) and
+// only probes again if that mount fails.
+struct StorageStatus {
+    bool mounted;
+    bool mode1Bit;       // Bus width in use
+    int frequencyKHz;    // SDMMC clock in use
+    float writeMBps;     // Sequential write speed measured at mount
+    float readMBps;      // Read-back speed measured at mount
+    uint8_t candidatesTried;
 };
 
 bool initSD(const StorageConfig &config);
+StorageStatus getStorageStatus();
 bool saveFile(const char *relativePath, const uint8_t *data, size_t length);
 bool saveFile(const char *relativePath, const camera_fb_t *frame);
+
+// Incremental file writing for data produced in strips (no full-frame buffer).
+// One stream may be open at a time; endStream() reports whether every append
+// succeeded and removes the partial file otherwise (unless keepOnError: a
+// container synced with syncStream() is still valid up to that point). Appends are gathered into
+// PXLCAM_SD_WRITE_CHUNK card writes. A non-zero expectedSize preallocates the
+// file at open (FAT work off the hot path); a shorter file is trimmed at end.
+bool beginStream(const char *relativePath, size_t expectedSize = 0);
+bool appendStream(const uint8_t *data, size_t length);
+bool patchStream(size_t offset, const uint8_t *data, size_t length);  // Rewrite appended bytes
+bool syncStream();  // Everything appended so far survives a power cut
+bool endStream(bool keepOnError = false);
+size_t streamBytesWritten();
+
+// Cumulative SD write counters since boot (saveFile and stream appends).
+struct WriteStats {
+    uint32_t bytes;      // Bytes written
+    uint32_t writeUs;    // Time spent inside file writes (µs)
+    uint32_t files;      // Files completed
+    uint32_t failures;   // Failed or short writes
+};
+WriteStats getWriteStats();
+
+// Capture numbering without touching the card: a counter in NVS, reserved in
+// batches of PXLCAM_FILE_NUMBER_BATCH (one flash write per batch). Numbers
+// only grow; a reset skips the rest of the batch instead of reusing any.
+uint32_t nextFileNumber();
+
+// Folder a capture number is saved in: /DCIM/100PXLCM for the first
+// PXLCAM_FILES_PER_FOLDER numbers, then 101PXLCM, ...
+void captureFolder(uint32_t number, char *out, size_t size);
+
+// Background writer: saveFileAsync() copies the image into an owned PSRAM
+// buffer and returns; a writer task puts it on the card. At most
+// PXLCAM_SD_WRITE_QUEUE_DEPTH images are in flight; when all are taken the
+// call waits up to waitMs for one (backpressure) and then returns false.
+// Callbacks run inside pollWrites(), on the task that calls it, so they may
+// touch the caller's state. Started by initSD(), drained by shutdownSD().
+using WriteCallback = void (*)(const char *path, bool ok, void *user);
+bool saveFileAsync(const char *relativePath, const uint8_t *data, size_t length,
+                   WriteCallback callback, void *user, uint32_t waitMs);
+void pollWrites();                     // Run callbacks of finished writes
+bool flushWrites(uint32_t timeoutMs);  // Wait for (and report) everything queued
+uint8_t pendingWrites();               // Queued, being written or not yet reported
+bool isWriterRunning();
+
+// Fixed-size records added to the end of an index file (the thumbnail
+// sidecar). A file that ends in a partial record, left by a power loss
+// mid-append, is first trimmed back to its last whole record, so record i
+// is always at i * length. The async form queues behind saveFileAsync()
+// images (FIFO) and takes a job slot like one.
+bool appendRecord(const char *relativePath, const uint8_t *record, size_t length);
+bool appendRecordAsync(const char *relativePath, const uint8_t *record, size_t length,
+                       WriteCallback callback, void *user, uint32_t waitMs);
+
 void shutdownSD();
 
 }  // namespace pxlcam::storage
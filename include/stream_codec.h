@@ -0,0 +1,101 @@
+#pragma once
+/**
+ * @file stream_codec.h
+ * @brief Per-client delta + RLE coding of stylized stream packets
+ *
+ * Dithered 4-tone frames are mostly identical from one frame to the next,
+ * and what does change comes in runs. Each client gets its own codec that
+ * remembers the last frame it sent to that client (what the browser has on
+ * screen) and sends the XOR against it, run-length encoded:
+ * a static scene costs ~80 bytes per frame instead of 4.8 KB.
+ *
+ * Keyframes (the frame itself, RLE or raw, whichever is smaller) are sent
+ * when the client joins, when the palette or size changes, every
+ * keyframeInterval frames, when a delta would not be smaller than a
+ * keyframe (scene cut), and on request (a client that fell behind).
+ *
+ * Wire message (little endian):
+ * | Offset | Size | Field                                             |
+ * |--------|------|---------------------------------------------------|
+ * | 0      | 20   | Stylized packet header (tones[4], width, height,  |
+ * |        |      | colors[12])                                       |
+ * | 20     | 1    | Flags: kFlagDelta, kFlagRle                       |
+ * | 21     | 1    | Reserved (0)                                      |
+ * | 22     | n    | Payload: 2bpp indices, or their XOR with the      |
+ * |        |      | previous frame; RLE coded when kFlagRle is set    |
+ *
+ * RLE control byte c: c < 128 → c + 1 literal bytes follow;
+ * c >= 128 → the next byte repeats c - 125 times (3..130).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stylized_stream.h"
+
+namespace pxlcam::stream {
+
+/// Wire header bytes (stylized header + flags + reserved)
+constexpr size_t kCodecHeaderBytes = kStylizedHeaderBytes + 2;
+
+/// Payload is the XOR with the previous frame
+constexpr uint8_t kFlagDelta = 0x01;
+/// Payload is RLE coded
+constexpr uint8_t kFlagRle = 0x02;
+
+/// Worst-case RLE size of n bytes (all literals)
+constexpr size_t rleMaxSize(size_t n) {
+    return n + (n + 127) / 128;
+}
+
+/// RLE-code src, or (src XOR ref) when ref is not null
+/// @param out At least rleMaxSize(len) bytes
+/// @return Bytes written
+size_t rleEncode(const uint8_t* src, const uint8_t* ref, size_t len, uint8_t* out);
+
+/// Decode RLE data, XORing into dst when xorInto is set
+/// @return false if the data is malformed or does not fill exactly dstLen bytes
+bool rleDecode(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen, bool xorInto);
+
+class StreamCodec {
+public:
+    StreamCodec() = default;
+    ~StreamCodec() { end(); }
+
+    StreamCodec(const StreamCodec&) = delete;
+    StreamCodec& operator=(const StreamCodec&) = delete;
+
+    /// Allocate the reference frame and output buffer
+    /// @param maxPacket Largest stylized packet (header + indices)
+    /// @param keyframeInterval Frames between forced keyframes (0 = never)
+    bool begin(size_t maxPacket, uint16_t keyframeInterval);
+    void end();
+
+    /// Next frame is a keyframe
+    void requestKeyframe() { keyPending_ = true; }
+
+    /// Code one stylized packet for this client
+    /// @param out Set to the wire message (valid until the next encode())
+    /// @return Wire message length (0 on bad input)
+    size_t encode(const uint8_t* packet, size_t len, const uint8_t*& out);
+
+    uint32_t getKeyframes() const { return keyframes_; }
+    uint32_t getDeltas() const { return deltas_; }
+    uint32_t getBytesIn() const { return bytesIn_; }
+    uint32_t getBytesOut() const { return bytesOut_; }
+
+private:
+    uint8_t* ref_ = nullptr;        ///< Last packet sent (header + indices)
+    uint8_t* out_ = nullptr;        ///< Wire message being built
+    size_t maxPacket_ = 0;
+    size_t refLen_ = 0;             ///< 0 = nothing sent yet
+    uint16_t keyframeInterval_ = 0;
+    uint16_t sinceKey_ = 0;
+    bool keyPending_ = true;
+    uint32_t keyframes_ = 0;
+    uint32_t deltas_ = 0;
+    uint32_t bytesIn_ = 0;
+    uint32_t bytesOut_ = 0;
+};
+
+}  // namespace pxlcam::stream
@@ -0,0 +1,108 @@
+#pragma once
+/**
+ * @file stream_ring.h
+ * @brief Reference-counted frame slots shared by one producer and many readers
+ *
+ * One capture task encodes each frame once and publishes it into a slot;
+ * every stream client reads the newest published slot, so N viewers cost one
+ * capture instead of N, and the camera framebuffer is only held for the copy
+ * into the slot rather than for a whole network write.
+ *
+ * - The producer reserves a slot nobody holds (never the newest one, so a
+ *   client arriving mid-write still gets a frame), fills it and publishes it
+ * - Readers acquire the newest frame, send it and release it; frames that
+ *   were published while a slow reader was busy are skipped, not queued
+ * - When every slot is held the producer drops its frame instead of blocking
+ *
+ * Slot buffers live in PSRAM (heap fallback) and grow to the largest frame.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+namespace pxlcam::stream {
+
+/// Most slots a ring can have
+constexpr uint8_t kMaxSlots = 6;
+
+/// One acquired frame (valid until release())
+struct FrameRef {
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    uint32_t seq = 0;           ///< Publish sequence, 1-based (0 = none)
+    uint32_t captureMs = 0;     ///< millis() when the frame was published
+    int8_t slot = -1;
+};
+
+class FrameRing {
+public:
+    FrameRing() = default;
+    ~FrameRing() { end(); }
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    /// Create the slots (buffers are allocated on first use)
+    /// @param slots 2..kMaxSlots
+    bool begin(uint8_t slots);
+
+    /// Free the slots; no frame may still be acquired
+    void end();
+
+    bool isReady() const { return slotCount_ > 0; }
+
+    // --- Producer (one frame in flight) ---
+
+    /// Buffer for the next frame, or nullptr if every slot is held
+    /// (or another frame is still being written)
+    /// @param len Frame size; the slot grows if needed
+    uint8_t* reserve(size_t len);
+
+    /// Make the reserved frame the newest and wake waiting readers
+    void publish(size_t len, uint32_t captureMs);
+
+    /// Give back a reserved slot without publishing it
+    void cancel();
+
+    // --- Readers (any task) ---
+
+    /// Acquire the newest frame if it is newer than afterSeq
+    bool acquireLatest(uint32_t afterSeq, FrameRef& out);
+
+    /// Like acquireLatest(), waiting up to timeoutMs for a newer frame
+    bool waitNewer(uint32_t afterSeq, FrameRef& out, uint32_t timeoutMs);
+
+    /// Release an acquired frame (out is cleared)
+    void release(FrameRef& ref);
+
+    /// Sequence of the newest frame (0 = none yet)
+    uint32_t getLatestSeq() const;
+
+    /// Frames published / dropped because every slot was held
+    uint32_t getPublished() const { return published_; }
+    uint32_t getDropped() const { return dropped_; }
+
+private:
+    struct Slot {
+        uint8_t* buf = nullptr;
+        size_t capacity = 0;
+        size_t len = 0;
+        uint32_t seq = 0;
+        uint32_t captureMs = 0;
+        uint8_t refs = 0;
+    };
+
+    mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+    Slot slots_[kMaxSlots];
+    EventGroupHandle_t events_ = nullptr;
+    uint8_t slotCount_ = 0;
+    int8_t latest_ = -1;
+    int8_t writing_ = -1;
+    uint32_t seq_ = 0;
+    uint32_t published_ = 0;
+    uint32_t dropped_ = 0;
+};
+
+}  // namespace pxlcam::stream
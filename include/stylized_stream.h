@@ -0,0 +1,101 @@
+#pragma once
+/**
+ * @file stylized_stream.h
+ * @brief Dithered preview frames for the WebSocket stream
+ *
+ * Turns a camera frame into the same palette/dither output the stylized
+ * capture saves, at stream resolution, packed 2 bits per pixel. No JPEG is
+ * encoded: a 160×120 frame is 4.8 KB of tone indices plus a small header,
+ * and the browser maps the indices through the palette onto a canvas.
+ * The colors are those of a capture's color table: the gray tones, or the
+ * palette manager's colors with color output (palettes::indexColors()).
+ *
+ * Packet layout (little endian):
+ * | Offset | Size            | Field                                   |
+ * |--------|-----------------|-----------------------------------------|
+ * | 0      | 4               | Palette tones, dark → light (0-255)     |
+ * | 4      | 2               | Width in pixels                         |
+ * | 6      | 2               | Height in pixels                        |
+ * | 8      | 12              | R, G, B per tone index                  |
+ * | 20     | ((w+3)/4) × h   | Tone indices, 2 bpp, leftmost pixel in  |
+ * |        |                 | the top bits (DitherOutput::PACKED_2BPP) |
+ *
+ * /stylized serves the same packets as MJPEG for viewers without the page
+ * (VLC, a browser tab, a recorder): packetToJpeg() maps the indices back
+ * to palette tones and runs the fixed-table gray encoder over them, reusing
+ * the encoder's own scratch, so a frame costs one dither and one small
+ * JPEG encode and nothing is allocated.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_camera.h>
+
+#include "filters/resample.h"
+#include "jpeg_gray_encoder.h"
+
+namespace pxlcam::stream {
+
+/// Bytes before the packed indices
+constexpr size_t kStylizedHeaderBytes = 20;
+
+/// Packet size for a w×h frame
+constexpr size_t stylizedPacketSize(int w, int h) {
+    return kStylizedHeaderBytes + static_cast<size_t>((w + 3) / 4) * h;
+}
+
+/// Camera frame → 2bpp stylized packet (owns its scratch buffers)
+///
+/// JPEG frames are decoded at the largest TJpgDec downscale that still
+/// covers the stream size; every format is then area-resampled to it.
+class StylizedEncoder {
+public:
+    StylizedEncoder() = default;
+    ~StylizedEncoder() { end(); }
+
+    StylizedEncoder(const StylizedEncoder&) = delete;
+    StylizedEncoder& operator=(const StylizedEncoder&) = delete;
+
+    /// Allocate scratch for w×h packets (PSRAM, heap fallback)
+    /// @param jpegQuality Quality of the packetToJpeg() output (1-100)
+    bool begin(int w, int h, uint8_t jpegQuality);
+    void end();
+
+    int width() const { return w_; }
+    int height() const { return h_; }
+    size_t packetSize() const { return stylizedPacketSize(w_, h_); }
+
+    /// Encode one frame with the current palette and dither configuration
+    /// @param out packetSize() bytes
+    bool encode(const camera_fb_t* fb, uint8_t* out);
+
+    /// Packet buffer for callers with nowhere else to put one
+    uint8_t* packetScratch() { return packet_; }
+
+    /// Packet → grayscale JPEG of the palette tones
+    ///
+    /// Overwrites the luma scratch, so call it after encode(), not between.
+    /// @param packet An encode() result of this encoder's size
+    /// @param scale Nearest-neighbour upscale (1-4)
+    /// @param out jpegCapacity(scale) bytes
+    /// @return JPEG size, 0 on failure
+    size_t packetToJpeg(const uint8_t* packet, int scale, uint8_t* out, size_t capacity);
+
+    /// Output buffer size that fits any packetToJpeg() result
+    size_t jpegCapacity(int scale) const {
+        return jpeg::GrayJpegEncoder::worstCaseSize(w_ * scale, h_ * scale);
+    }
+
+private:
+    bool frameToLuma(const camera_fb_t* fb);
+
+    filters::AreaResampler resampler_;
+    uint8_t* decode_ = nullptr;     ///< Scaled JPEG decode (up to 2w × 2h)
+    uint8_t* luma_ = nullptr;       ///< w × h stream luma (then JPEG tones)
+    uint8_t* packet_ = nullptr;     ///< packetScratch()
+    jpeg::GrayJpegEncoder jpeg_;
+    int w_ = 0;
+    int h_ = 0;
+};
+
+}  // namespace pxlcam::stream
@@ -0,0 +1,110 @@
+#pragma once
+/**
+ * @file swar.h
+ * @brief SIMD-within-a-register helpers: 4 pixels per 32-bit word
+ *
+ * The ESP32's Xtensa LX6 core has no packed-byte instructions, so these do
+ * per-byte saturating math with masks on plain 32-bit words. Pixel x of a
+ * word sits in byte (x & 3) (little endian, as on the ESP32 and host tests).
+ *
+ * Word loads/stores must be 4-byte aligned: an unaligned l32i/s32i faults on
+ * the ESP32. Callers check aligned4() and keep a scalar loop for the rest.
+ *
+ * Platform independent so the filter pipeline and host tests can share it.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace pxlcam::swar {
+
+constexpr uint32_t kHighBits = 0x80808080u;
+constexpr uint32_t kLow7Bits = 0x7F7F7F7Fu;
+constexpr uint32_t kLow2Bits = 0x03030303u;
+
+/// True if p can be used with load4()/store4()
+inline bool aligned4(const void* p) {
+    return (reinterpret_cast<uintptr_t>(p) & 3) == 0;
+}
+
+/// Load 4 pixels (p must be 4-byte aligned)
+inline uint32_t load4(const uint8_t* p) {
+    uint32_t w;
+    memcpy(&w, __builtin_assume_aligned(p, 4), sizeof(w));
+    return w;
+}
+
+/// Store 4 pixels (p must be 4-byte aligned)
+inline void store4(uint8_t* p, uint32_t w) {
+    memcpy(__builtin_assume_aligned(p, 4), &w, sizeof(w));
+}
+
+/// Pack 4 bytes into a word, b0 = leftmost pixel
+inline uint32_t pack4(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3) {
+    return static_cast<uint32_t>(b0) | (static_cast<uint32_t>(b1) << 8) |
+           (static_cast<uint32_t>(b2) << 16) | (static_cast<uint32_t>(b3) << 24);
+}
+
+/// Per-byte min(a + b, 255)
+inline uint32_t addSat(uint32_t a, uint32_t b) {
+    const uint32_t low = (a & kLow7Bits) + (b & kLow7Bits);  // Carries stop at bit 7
+    const uint32_t sum = low ^ ((a ^ b) & kHighBits);         // a + b mod 256 per byte
+    const uint32_t carry = ((a & b) | ((a | b) & low)) & kHighBits;
+    return sum | ((carry >> 7) * 0xFFu);
+}
+
+/// Per-byte max(a - b, 0)
+inline uint32_t subSat(uint32_t a, uint32_t b) {
+    return ~addSat(~a, b);
+}
+
+/// Per-byte table lookup (lut must cover every byte value present in w)
+inline uint32_t lookup4(uint32_t w, const uint8_t* lut) {
+    return pack4(lut[w & 0xFF], lut[(w >> 8) & 0xFF], lut[(w >> 16) & 0xFF], lut[w >> 24]);
+}
+
+/// Four 2-bit values (one per byte) → one byte, leftmost pixel in the top bits
+inline uint8_t packPairs(uint32_t w) {
+    return static_cast<uint8_t>(((w & 0x03) << 6) | ((w >> 4) & 0x30) |
+                                ((w >> 14) & 0x0C) | ((w >> 24) & 0x03));
+}
+
+/// Four 0/1 bytes → one nibble, leftmost pixel in bit 3 (one multiply, no carries)
+inline uint8_t packBits(uint32_t w) {
+    return static_cast<uint8_t>(((w & 0x01010101u) * 0x08040201u) >> 24) & 0x0F;
+}
+
+/// Four 4-bit values (one per byte) → two bytes, leftmost pixel in the high nibble
+inline void packNibbles(uint32_t w, uint8_t* out) {
+    out[0] = static_cast<uint8_t>(((w << 4) & 0xF0) | ((w >> 8) & 0x0F));
+    out[1] = static_cast<uint8_t>(((w >> 12) & 0xF0) | ((w >> 24) & 0x0F));
+}
+
+/// Signed per-pixel offsets split for saturating word math
+///
+/// clamp(pixel + offset[i]) == subSat(addSat(pixel, pos), neg), since only one
+/// of the two parts is non-zero per byte.
+struct OffsetWord {
+    uint32_t pos;
+    uint32_t neg;
+};
+
+/// Build an OffsetWord from 4 offsets in [-255, 255]
+inline OffsetWord makeOffsetWord(const int16_t offsets[4]) {
+    uint8_t pos[4];
+    uint8_t neg[4];
+    for (int i = 0; i < 4; i++) {
+        const int o = offsets[i];
+        pos[i] = static_cast<uint8_t>(o > 0 ? (o > 255 ? 255 : o) : 0);
+        neg[i] = static_cast<uint8_t>(o < 0 ? (o < -255 ? 255 : -o) : 0);
+    }
+    return { pack4(pos[0], pos[1], pos[2], pos[3]), pack4(neg[0], neg[1], neg[2], neg[3]) };
+}
+
+/// Apply an OffsetWord to 4 pixels with clamping to [0, 255]
+inline uint32_t applyOffset(uint32_t w, const OffsetWord& off) {
+    return subSat(addSat(w, off.pos), off.neg);
+}
+
+}  // namespace pxlcam::swar
@@ -0,0 +1,73 @@
+#pragma once
+/**
+ * @file thumbnail_index.h
+ * @brief Per-folder thumbnail sidecar (THUMBS.IDX) for gallery browsing
+ *
+ * Every stylized capture comes with a 64x64 1-bit thumbnail, downscaled
+ * from its output rows during the capture pass (ProcessedImage::thumbnail).
+ * After the image is queued for the card, the thumbnail is appended to its
+ * folder's index as one fixed-size record. A gallery then shows a folder by
+ * reading one record per image instead of opening and decoding each file,
+ * and record i is at i * kRecordSize, so a page of images is one seek and
+ * one read. Over WiFi the index is served like any other file
+ * (/files/100PXLCM/THUMBS.IDX, Range requests fetch a slice).
+ *
+ * Record layout (little endian, 544 bytes):
+ *   0  char[4] "PXT1"           4  char[20] file name in the folder (NUL padded)
+ *  24  u32 file size           28  u16 image width     30  u16 image height
+ *  32  u8[512] SSD1306 pages: byte (y/8)*64 + x, bit y%8 (display::drawPreviewPages())
+ *
+ * Records are only ever appended: an image deleted later keeps its record,
+ * so a gallery that cares checks the name still exists.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam::thumbs {
+
+constexpr int kThumbWidth = 64;                                         ///< OLED preview size
+constexpr int kThumbHeight = 64;
+constexpr size_t kThumbBytes = kThumbWidth * kThumbHeight / 8;          ///< 512
+constexpr size_t kNameMax = 20;                                         ///< Name bytes incl. NUL
+constexpr const char* kIndexName = "THUMBS.IDX";
+
+#pragma pack(push, 1)
+struct Record {
+    char     magic[4];              ///< "PXT1"
+    char     name[kNameMax];        ///< File name inside the folder
+    uint32_t fileSize;
+    uint16_t width;                 ///< Image size (0 = not recorded)
+    uint16_t height;
+    uint8_t  pages[kThumbBytes];    ///< Thumbnail, SSD1306 page layout
+};
+#pragma pack(pop)
+
+static_assert(sizeof(Record) == 544, "Thumbnail record must be 544 bytes");
+
+constexpr size_t kRecordSize = sizeof(Record);
+
+/// Index file of a folder ("/DCIM/100PXLCM" -> "/DCIM/100PXLCM/THUMBS.IDX")
+void indexPath(const char* folder, char* out, size_t size);
+
+/// Append a capture's thumbnail to the index of the folder it was saved in
+/// Queued behind the image on the background writer; written inline when
+/// the writer is not running or its queue stays full for waitMs.
+/// @param path Image path ("/DCIM/100PXLCM/PXL_G0042.png")
+/// @param fileSize, width, height Image file size and dimensions (0 x 0
+///        when not known, as for strip captures)
+/// @param pages kThumbBytes thumbnail in SSD1306 page layout
+/// @return false if the name does not fit or the append failed
+bool append(const char* path, size_t fileSize, uint16_t width, uint16_t height,
+            const uint8_t* pages, uint32_t waitMs);
+
+/// Records in a folder's index (0 when it has none)
+uint32_t count(const char* folder);
+
+/// Read consecutive records of a folder's index
+/// @param first Index of the first record
+/// @param out Room for max records
+/// @return Records read; stops early at the end or at a damaged record
+size_t read(const char* folder, uint32_t first, Record* out, size_t max);
+
+}  // namespace pxlcam::thumbs
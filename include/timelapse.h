@@ -43,8 +43,8 @@ namespace pxlcam {
 enum class TimelapseMode : uint8_t {
     INTERVAL,           ///< Fixed interval between captures
     SUNRISE_SUNSET,     ///< Capture during daylight (requires RTC)
-    BURST,              ///< Rapid burst capture
-    MOTION_TRIGGERED    ///< Capture on motion detection
+    BURST,              ///< One burst of burstFrames, as fast as the sensor allows
+    MOTION_TRIGGERED    ///< Capture on motion detection (timelapse_motion.h)
 };
 
 /**
@@ -56,6 +56,19 @@ enum class TimelapsePowerMode : uint8_t {
     DEEP_SLEEP          ///< Deep sleep (maximum power savings, slower wake)
 };
 
+/**
+ * @brief What to do with deadlines that passed while a frame was late
+ *
+ * Frames are scheduled on a fixed grid (start + n * interval), so a slow
+ * capture or save never pushes the later frames back. When a frame starts
+ * after the next deadline has already passed as well, the policy decides
+ * whether those deadlines are still owed.
+ */
+enum class TimelapseLatePolicy : uint8_t {
+    SKIP,               ///< Drop missed deadlines; the next frame is the latest one
+    CATCH_UP            ///< Take every missed frame, back to back
+};
+
 /**
  * @brief Timelapse configuration
  */
@@ -65,6 +78,9 @@ struct TimelapseConfig {
     uint32_t maxFrames;             ///< Maximum frames (0 = unlimited)
     uint32_t durationMs;            ///< Total duration (0 = unlimited)
     TimelapsePowerMode powerMode;   ///< Power mode between captures
+    TimelapseLatePolicy latePolicy; ///< Missed deadlines
+    uint8_t burstFrames;            ///< BURST: frames in the burst (the whole run)
+    uint16_t burstIntervalMs;       ///< BURST: spacing of burst frames (0 = sensor rate)
     bool applyStyleFilter;          ///< Apply stylized capture
     bool showCountdown;             ///< Show countdown on display
     bool beepOnCapture;             ///< Beep when capturing
@@ -76,6 +92,9 @@ struct TimelapseConfig {
         , maxFrames(0)
         , durationMs(0)
         , powerMode(TimelapsePowerMode::ACTIVE)
+        , latePolicy(TimelapseLatePolicy::SKIP)
+        , burstFrames(0)
+        , burstIntervalMs(0)
         , applyStyleFilter(true)
         , showCountdown(true)
         , beepOnCapture(false) {}
@@ -94,6 +113,10 @@ struct TimelapseStatus {
     uint32_t nextCaptureMs;     ///< Time until next capture
     uint32_t lastCaptureMs;     ///< Time since last capture
     bool lastCaptureOk;         ///< Last capture succeeded
+    uint32_t lastLatenessMs;    ///< Last frame: capture start after its deadline
+    uint32_t maxLatenessMs;     ///< Worst lateness of the run
+    uint32_t meanLatenessMs;    ///< Mean lateness of the run
+    uint32_t deadlinesSkipped;  ///< Deadlines dropped by TimelapseLatePolicy::SKIP
 };
 
 // =============================================================================
@@ -143,6 +166,8 @@ public:
     /**
      * @brief Set configuration
      * 
+     * A BURST run is the burst itself: maxFrames becomes burstFrames.
+     * 
      * @param config Configuration structure
      */
     void setConfig(const TimelapseConfig& config);
@@ -158,7 +183,8 @@ public:
      * @brief Begin timelapse sequence
      * 
      * Starts the timelapse with current configuration.
-     * First capture is immediate.
+     * The first deadline is the start itself: the first capture is due
+     * at once, frame n at start + n * interval.
      * 
      * @return true on success
      */
@@ -176,6 +202,8 @@ public:
     
     /**
      * @brief Resume paused timelapse
+     * 
+     * The grid moves on by the time spent paused.
      */
     void resume();
     
@@ -204,14 +232,26 @@ public:
     /**
      * @brief Check if capture should happen now
      * 
-     * @return true if time to capture
+     * @return true once the next deadline has passed (never for
+     *         MOTION_TRIGGERED runs: the caller polls the motion trigger;
+     *         only at the start of a BURST run, whose frames the caller
+     *         grabs and develops on its own)
      */
     bool shouldCapture() const;
     
+    /**
+     * @brief Notify that a due capture is starting
+     * 
+     * Takes the deadline (applying the late policy first), records how late
+     * the frame is, and moves on to the next deadline. tick() calls it before
+     * the capture callback; a caller polling shouldCapture() calls it itself.
+     */
+    void onCaptureStart();
+    
     /**
      * @brief Notify that capture completed
      * 
-     * Call this after capture is done to update timing.
+     * Counts the frame; the schedule itself moved on in onCaptureStart().
      * 
      * @param success true if capture succeeded
      */
@@ -234,7 +274,7 @@ public:
     /**
      * @brief Get time until next capture
      * 
-     * @return Milliseconds until next capture
+     * @return Milliseconds until the next deadline (0 when due)
      */
     uint32_t getTimeToNextCapture() const;
     
@@ -255,6 +295,26 @@ public:
     using CaptureCallback = void(*)(void);
     void onCapture(CaptureCallback callback);
     
+    /**
+     * @brief Keep the run in RTC memory across a deep sleep
+     * 
+     * Saves the configuration, the schedule and its statistics, with the
+     * RTC clock reading; resumeFromRtc() measures the time asleep from it,
+     * so the deadline grid survives however long the sleep and boot took.
+     */
+    void suspendToRtc();
+    
+    /**
+     * @brief Continue a run kept by suspendToRtc()
+     * 
+     * Call once at boot, after init(), on a deep-sleep timer wake. The
+     * restored run keeps its deadlines; the wake comes a little before the
+     * next one.
+     * 
+     * @return true if a run was restored
+     */
+    bool resumeFromRtc();
+    
 private:
     TimelapseController();
     ~TimelapseController();
@@ -263,11 +323,18 @@ private:
     TimelapseController(const TimelapseController&) = delete;
     TimelapseController& operator=(const TimelapseController&) = delete;
     
+    /// millis() at which frame `index` is due
+    uint32_t deadline(uint32_t index) const;
+    
     // Private implementation
     TimelapseConfig m_config;
     TimelapseStatus m_status;
-    uint32_t m_startTime;
+    uint32_t m_startTime;           ///< Deadline of frame 0
+    uint32_t m_nextIndex;           ///< Frame whose deadline is next
     uint32_t m_lastCaptureTime;
+    uint32_t m_pausedAt;
+    uint64_t m_latenessSumMs;
+    uint32_t m_latenessFrames;
     CaptureCallback m_captureCallback;
 };
 
@@ -321,11 +388,8 @@ namespace TimelapsePresets {
 // =============================================================================
 
 // TODO: Implement basic interval timelapse
-// TODO: Add deep sleep support for long intervals
 // TODO: Implement progress bar on OLED
 // TODO: Add estimated completion time display
-// TODO: Implement burst mode
-// TODO: Add motion detection trigger
 // TODO: Store timelapse progress in NVS for resume after power loss
 // TODO: Add battery level monitoring and auto-stop
 
@@ -0,0 +1,74 @@
+/**
+ * @file timelapse_motion.h
+ * @brief Motion trigger for TimelapseMode::MOTION_TRIGGERED runs
+ *
+ * While a motion run waits, the sensor streams PXLCAM_MOTION_FRAMESIZE
+ * frames (96x96 by default). Each one is decoded and area-downscaled to
+ * 64x64 luma on the fly (one 16-row MCU band, no frame buffer) and fed to a
+ * motion::MotionDetector. At that size a frame costs a few milliseconds, so
+ * detection runs on every frame and an event is seen within one frame.
+ *
+ * On an event the capture frame size comes back (motionEnd()) and the run
+ * takes a normal full-size stylized capture; watching resumes with a fresh
+ * background afterwards (the cool-down carries on).
+ *
+ * @version 1.3.0
+ */
+
+#ifndef PXLCAM_TIMELAPSE_MOTION_H
+#define PXLCAM_TIMELAPSE_MOTION_H
+
+#include <stdint.h>
+#include "pxlcam_config.h"
+
+#if PXLCAM_FEATURE_TIMELAPSE
+
+namespace pxlcam::timelapse {
+
+/**
+ * @brief Start watching: sensor to PXLCAM_MOTION_FRAMESIZE
+ *
+ * The detector (about 12 KB, PSRAM first) is made on the first call.
+ *
+ * @return false if the sensor or the detector is not available
+ */
+bool motionBegin();
+
+/**
+ * @brief Grab and check one frame
+ * @return true on a motion event
+ */
+bool motionPoll();
+
+/**
+ * @brief Stop watching and restore the capture frame size
+ */
+void motionEnd();
+
+/// Watching (between motionBegin() and motionEnd())
+bool motionIsActive();
+
+/**
+ * @brief Sensitivity of a zone, in 8x8 blocks of the 64x64 frame
+ *
+ * [bx0, bx1) x [by0, by1), 0..8 each. 0 ignores the zone, 100 is the
+ * configured threshold, 200 twice as sensitive. Kept across runs.
+ */
+void motionSetZone(int bx0, int by0, int bx1, int by1, uint8_t sensitivity);
+
+/// Motion trigger telemetry
+struct MotionStats {
+    uint32_t frames;        ///< Frames checked
+    uint32_t events;        ///< Motion events (captures triggered)
+    uint32_t suppressed;    ///< Events held back by the cool-down
+    uint16_t movingBlocks;  ///< Moving blocks in the last frame
+    uint32_t lastFrameUs;   ///< Grab + decode + detect of the last frame
+};
+
+MotionStats motionGetStats();
+
+} // namespace pxlcam::timelapse
+
+#endif // PXLCAM_FEATURE_TIMELAPSE
+
+#endif // PXLCAM_TIMELAPSE_MOTION_H
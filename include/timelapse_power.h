@@ -2,8 +2,19 @@
  * @file timelapse_power.h
  * @brief Power management for timelapse mode
  * 
- * Provides light sleep support for long intervals to conserve power.
+ * Provides light sleep support for long intervals to conserve power, and
+ * deep sleep for intervals of minutes (TimelapsePowerMode::DEEP_SLEEP).
  * Uses ESP32 timer wakeup for scheduled captures.
+ *
+ * A deep sleep powers everything but the RTC down; the wake is a fresh
+ * boot. The run itself is kept in RTC memory
+ * (TimelapseController::suspendToRtc()), so the boot continues it with one
+ * capture and goes back to sleep. Any other reset ends the run.
+ *
+ * Both sleeps wake ahead of the deadline by a margin learned from the
+ * wakes before: the time from waking to a camera that is ready to shoot
+ * (exposure::warmUp() settled), which depends on the scene. The fixed
+ * margins below are used until a wake has been measured.
  * 
  * @version 1.3.0
  * @date 2024
@@ -26,9 +37,29 @@ namespace pxlcam::timelapse {
 /// Minimum interval for light sleep (30 seconds)
 constexpr uint32_t kMinSleepIntervalMs = 30000;
 
-/// Wake margin before capture (2 seconds for camera warmup)
+/// Light sleep wake margin before the first measured wake (camera warm-up)
 constexpr uint32_t kWakeMarginMs = 2000;
 
+/// Deep sleep wake margin before the first measured wake: boot, camera and
+/// SD bring-up, warm-up
+constexpr uint32_t kDeepWakeMarginMs = 3000;
+
+/// Added to a learned margin (ROM boot, timer jitter)
+constexpr uint32_t kWakeSlackMs = 250;
+
+/// Learned margins are kept below this
+constexpr uint32_t kMaxWakeMarginMs = 8000;
+
+/// Sleep kinds with a wake margin of their own
+enum class WakeKind : uint8_t {
+    Light = 0,
+    Deep,
+    Count
+};
+
+/// Shortest wait worth a deep sleep (the wake costs a full boot)
+constexpr uint32_t kMinDeepSleepMs = 15000;
+
 // =============================================================================
 // Public API
 // =============================================================================
@@ -49,11 +80,56 @@ bool shouldUseSleep(uint32_t intervalMs);
  * @brief Prepare and enter light sleep
  * 
  * Configures timer wakeup and enters light sleep.
- * Camera and peripherals remain powered but CPU sleeps.
+ * Camera and peripherals remain powered but CPU sleeps; the caller puts the
+ * sensor in standby first.
  * 
- * @param sleepMs Duration to sleep (will subtract wake margin)
+ * @param sleepMs Time to the deadline (the wake margin is subtracted)
+ * @return true if it slept
+ */
+bool enterLightSleep(uint32_t sleepMs);
+
+/**
+ * @brief Record how long a wake took until the camera was ready
+ * 
+ * Feeds the wake margin of that sleep kind (a moving average, kept in RTC
+ * memory across deep sleeps).
+ * 
+ * @param readyMs Light: from the end of the sleep; deep: since boot
+ */
+void recordWakeToReady(WakeKind kind, uint32_t readyMs);
+
+/**
+ * @brief Time to wake ahead of a deadline
+ */
+uint32_t wakeMarginMs(WakeKind kind);
+
+/**
+ * @brief Forget the learned margins (a new run, a new scene)
+ */
+void resetWakeModel();
+
+/**
+ * @brief Check if a wait is long enough for a deep sleep
+ * @param sleepMs Time until the next capture
+ */
+bool shouldUseDeepSleep(uint32_t sleepMs);
+
+/**
+ * @brief Enter deep sleep until the next capture is due
+ *
+ * Wakes wakeMarginMs(WakeKind::Deep) early to cover the boot. The wake restarts the
+ * firmware; the caller saves its state to RTC memory and powers
+ * peripherals down first.
+ *
+ * @param sleepMs Time until the next capture
+ * @return false (only returns if the wake timer could not be set)
+ */
+bool enterDeepSleep(uint32_t sleepMs);
+
+/**
+ * @brief Check if this boot is a timer wake from deep sleep
  */
-void enterLightSleep(uint32_t sleepMs);
+bool wasDeepSleepWakeup();
 
 /**
  * @brief Handle wakeup from sleep
@@ -0,0 +1,73 @@
+/**
+ * @file timelapse_sequence.h
+ * @brief Single-file container for timelapse frames (uncompressed AVI)
+ *
+ * A timelapse used to leave one BMP per frame, each costing a directory
+ * entry, a cluster chain and a metadata flush. Frames now go into one AVI
+ * with a single video stream of uncompressed DIB frames: the palette and
+ * bitmap header come from the first frame, every frame chunk is that
+ * frame's pixel rows, unchanged. Any PC player opens the file directly.
+ *
+ * Crash safety: after every frame the RIFF/movi sizes and frame counts in
+ * the header are patched and the file is synced, so a power cut leaves a
+ * valid AVI of all completed frames (players index it by scanning the
+ * movi list). The idx1 index is only written when the sequence is closed;
+ * frames are all the same size, so it is computed then, not kept in RAM.
+ *
+ * Only BMP frames (8-bit and 4-bit) fit; other outputs keep one file each.
+ *
+ * @version 1.3.0
+ */
+
+#ifndef PXLCAM_TIMELAPSE_SEQUENCE_H
+#define PXLCAM_TIMELAPSE_SEQUENCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "pxlcam_config.h"
+
+#if PXLCAM_FEATURE_TIMELAPSE
+
+namespace pxlcam::timelapse {
+
+/**
+ * @brief Create a sequence file shaped after a BMP frame
+ *
+ * Holds the storage stream until sequenceClose().
+ *
+ * @param path File path on the card ("/DCIM/100PXLCM/PXL_T0042.avi")
+ * @param bmp First frame as a complete BMP file (not appended)
+ * @param bmpLength Its size
+ * @param expectedFrames Frames to preallocate space for (0 = PXLCAM_TIMELAPSE_PREALLOC_FRAMES)
+ * @return false if the frame is not a BMP or the file could not be created
+ */
+bool sequenceOpen(const char* path, const uint8_t* bmp, size_t bmpLength, uint32_t expectedFrames);
+
+/**
+ * @brief Append one frame and checkpoint the file
+ * @param bmp Complete BMP file with the same header as the first frame
+ * @param bmpLength Its size
+ * @return false on a write error or a frame of another shape
+ */
+bool sequenceAppend(const uint8_t* bmp, size_t bmpLength);
+
+/**
+ * @brief Write the index and close
+ * @return true if every frame and the index were written
+ */
+bool sequenceClose();
+
+/// A sequence is open
+bool sequenceIsOpen();
+
+/// Frames in the open (or last closed) sequence
+uint32_t sequenceFrames();
+
+/// Path of the open (or last closed) sequence
+const char* sequencePath();
+
+} // namespace pxlcam::timelapse
+
+#endif // PXLCAM_FEATURE_TIMELAPSE
+
+#endif // PXLCAM_TIMELAPSE_SEQUENCE_H
@@ -0,0 +1,170 @@
+#pragma once
+/**
+ * @file trace.h
+ * @brief Timeline of capture, stream, SD and display spans on both cores
+ *
+ * Each core has a ring of PXLCAM_TRACE_EVENTS compact events (16 bytes:
+ * start, duration, argument, id, task, core). Recording is lock-free: a
+ * slot is reserved with one atomic add on the ring of the core the caller
+ * runs on, then filled. Oldest events are overwritten. A span records a
+ * single complete event when it ends, so a task moved to the other core
+ * mid-span still pairs up; it keeps the core it began on.
+ *
+ * Cheap enough to stay in release builds: with recording off a macro is a
+ * load and a branch; on, it adds two esp_timer_get_time() reads, the atomic
+ * add and a store of 16 bytes (rings prefer PSRAM). PXLCAM_TRACE 0
+ * compiles every macro away.
+ *
+ *   PXLCAM_TRACE_SCOPE(Display, bytes);        // span to the end of the scope
+ *   PXLCAM_TRACE_SPAN(span, SdWrite, 0);       // named: span.setArg(), span.end()
+ *   PXLCAM_TRACE_INSTANT(AppEvent, event);
+ *   PXLCAM_TRACE_COUNTER(SdQueue, pending);
+ *
+ * writeJson() renders the rings as Chrome trace_event JSON
+ * (chrome://tracing, ui.perfetto.dev): one process per core, one thread per
+ * task. Served as /trace.json by the WiFi preview and written to the card
+ * by dumpToSd() ('t' on the HWTEST console). Recording pauses while a dump
+ * reads the rings.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "pxlcam_config.h"
+
+namespace pxlcam::trace {
+
+/// What an event is; names in trace.cpp (kNames) follow this order
+enum class Id : uint8_t {
+    Shot = 0,       ///< AppController capture call (arg: result)
+    FbGet,          ///< One camera readout (camera service or a direct read)
+    Save,           ///< AppController save step
+    SdWrite,        ///< One write() to the card (arg: bytes)
+    SdQueue,        ///< Counter: background writes in flight
+    Display,        ///< OLED flush (arg: bytes sent)
+    PreviewFrame,   ///< One preview loop frame
+    StreamGrab,     ///< WiFi capture task: frame into the rings (arg: bytes)
+    StreamSend,     ///< Sender task: one frame to one client (arg: bytes)
+    AppEvent,       ///< Instant: controller event handled (arg: AppEvent)
+    AppState,       ///< Instant: state machine transition (arg: AppState)
+    Count
+};
+
+/// Allocate the rings and start recording
+/// @return false without memory (every macro stays a no-op)
+bool begin();
+
+void setEnabled(bool on);
+
+#if PXLCAM_TRACE
+namespace detail {
+extern std::atomic<bool> g_recording;   ///< Enabled, rings allocated, no dump reading them
+}
+
+inline bool isEnabled() {
+    return detail::g_recording.load(std::memory_order_relaxed);
+}
+#else
+inline bool isEnabled() {
+    return false;
+}
+#endif
+
+/// Forget everything recorded so far
+void clear();
+
+/// Start stamp of a span (low 32 bits of esp_timer_get_time())
+uint32_t now();
+
+/// Span from startUs to now
+void complete(Id id, uint32_t startUs, uint32_t arg, uint8_t startCore);
+
+void instant(Id id, uint32_t arg);
+void counter(Id id, uint32_t value);
+
+/// RAII span; records one complete event on destruction
+class Span {
+   public:
+#if PXLCAM_TRACE
+    Span(Id id, uint32_t arg) : arg_(arg), id_(id), active_(isEnabled()) {
+        if (active_) {
+            start();
+        }
+    }
+    ~Span() { end(); }
+    void setArg(uint32_t arg) { arg_ = arg; }
+
+    /// Record it now rather than at the end of the scope
+    void end() {
+        if (active_) {
+            active_ = false;
+            complete(id_, startUs_, arg_, core_);
+        }
+    }
+
+   private:
+    void start();
+
+    uint32_t startUs_ = 0;
+    uint32_t arg_;
+    Id id_;
+    uint8_t core_ = 0;
+    bool active_;
+#else
+    Span(Id, uint32_t) {}
+    void setArg(uint32_t) {}
+    void end() {}
+#endif
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+};
+
+/// Receives the JSON in pieces; false aborts the dump
+using Writer = bool (*)(const char* data, size_t length, void* user);
+
+/// Render both rings as Chrome trace_event JSON
+/// @return false if the writer gave up
+bool writeJson(Writer writer, void* user);
+
+/// Write the JSON to /trace_<millis>.json on the card
+bool dumpToSd();
+
+/// Ask for dumpToSd() from the controller (input task, console)
+void requestDump();
+bool takeDumpRequest();
+
+struct Stats {
+    uint32_t recorded[2];       ///< Events per core since clear()
+    uint32_t capacity;          ///< Events each ring holds
+    uint8_t tasks;              ///< Tasks seen (PXLCAM_TRACE_TASKS at most)
+};
+
+Stats getStats();
+
+}  // namespace pxlcam::trace
+
+#define PXLCAM_TRACE_CAT2(a, b) a##b
+#define PXLCAM_TRACE_CAT(a, b) PXLCAM_TRACE_CAT2(a, b)
+
+#define PXLCAM_TRACE_SPAN(name, id, arg) ::pxlcam::trace::Span name(::pxlcam::trace::Id::id, (arg))
+#define PXLCAM_TRACE_SCOPE(id, arg) PXLCAM_TRACE_SPAN(PXLCAM_TRACE_CAT(pxlcamTrace_, __LINE__), id, arg)
+
+#if PXLCAM_TRACE
+#define PXLCAM_TRACE_INSTANT(id, arg)                                        \
+    do {                                                                     \
+        if (::pxlcam::trace::isEnabled()) {                                  \
+            ::pxlcam::trace::instant(::pxlcam::trace::Id::id, (arg));        \
+        }                                                                    \
+    } while (0)
+#define PXLCAM_TRACE_COUNTER(id, value)                                      \
+    do {                                                                     \
+        if (::pxlcam::trace::isEnabled()) {                                  \
+            ::pxlcam::trace::counter(::pxlcam::trace::Id::id, (value));      \
+        }                                                                    \
+    } while (0)
+#else
+#define PXLCAM_TRACE_INSTANT(id, arg) ((void)0)
+#define PXLCAM_TRACE_COUNTER(id, value) ((void)0)
+#endif
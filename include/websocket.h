@@ -0,0 +1,55 @@
+#pragma once
+/**
+ * @file websocket.h
+ * @brief Minimal RFC 6455 helpers for the preview WebSocket stream
+ *
+ * Just enough of the protocol for a server that pushes binary frames:
+ * the handshake accept key, server frame headers (never masked) and
+ * parsing of the small control frames a browser sends back.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pxlcam::ws {
+
+/// Frame opcodes
+enum Opcode : uint8_t {
+    kOpContinuation = 0x0,
+    kOpText = 0x1,
+    kOpBinary = 0x2,
+    kOpClose = 0x8,
+    kOpPing = 0x9,
+    kOpPong = 0xA,
+};
+
+/// Longest server frame header (2 + 8 byte length)
+constexpr size_t kMaxHeaderBytes = 10;
+
+/// Sec-WebSocket-Accept value: base64(SHA-1(key + RFC 6455 GUID))
+/// @param key Sec-WebSocket-Key sent by the client (surrounding spaces ignored)
+/// @param out At least 29 bytes (28 characters + terminator)
+bool acceptKey(const char* key, char* out, size_t outSize);
+
+/// Header of a final, unmasked server frame
+/// @return Header length (2, 4 or 10 bytes)
+size_t frameHeader(uint8_t* out, uint8_t opcode, size_t payloadLen);
+
+/// Decoded client frame header
+struct ClientFrame {
+    uint8_t opcode;
+    bool fin;
+    bool masked;
+    uint8_t mask[4];
+    uint64_t payloadLen;
+    size_t headerLen;       ///< Bytes consumed, mask included
+};
+
+/// Parse a client frame header from buf
+/// @return false if len bytes are not enough yet
+bool parseClientHeader(const uint8_t* buf, size_t len, ClientFrame& out);
+
+/// Unmask payload bytes in place (offset = position within the payload)
+void unmask(uint8_t* data, size_t len, const uint8_t mask[4], size_t offset = 0);
+
+}  // namespace pxlcam::ws
@@ -8,9 +8,12 @@
  * Features:
  * - Access Point (AP) mode for direct connection
  * - Station (STA) mode for existing network
- * - MJPEG streaming for compatibility
- * - WebSocket binary frames for low latency
+ * - MJPEG streaming for compatibility (/stream raw, /stylized palette dithered)
+ * - WebSocket binary frames for low latency (dithered 2bpp, no JPEG)
  * - Multiple simultaneous clients
+ * - SD gallery: /files (paged DCIM listing) and /files/<name> (Range aware)
+ * - Prometheus /metrics (capture, preview, stream, memory, SD, timelapse)
+ * - /trace.json timeline of both cores (trace.h, Chrome trace format)
  * 
  * @version 1.3.0
  * @date 2024
@@ -22,8 +25,11 @@
 #define PXLCAM_WIFI_PREVIEW_H
 
 #include <Arduino.h>
+#include <WiFiClient.h>
 #include <stdint.h>
 
+#include "pxlcam_config.h"
+
 // Feature gate - disabled by default for memory savings
 #ifndef PXLCAM_FEATURE_WIFI_PREVIEW
 #define PXLCAM_FEATURE_WIFI_PREVIEW 0
@@ -52,8 +58,8 @@ enum class WifiMode : uint8_t {
  */
 enum class StreamFormat : uint8_t {
     MJPEG,          ///< Motion JPEG (HTTP multipart)
-    WEBSOCKET_BIN,  ///< WebSocket binary frames (low latency)
-    WEBSOCKET_B64   ///< WebSocket base64 (more compatible)
+    WEBSOCKET_BIN,  ///< WebSocket 2bpp stylized frames (see stylized_stream.h)
+    WEBSOCKET_B64   ///< WebSocket base64 (not implemented, page uses WEBSOCKET_BIN)
 };
 
 /**
@@ -71,11 +77,14 @@ struct WifiPreviewConfig {
     uint16_t wsPort;                ///< WebSocket port (default: 81)
     
     // Stream settings
-    StreamFormat format;            ///< Stream format
+    StreamFormat format;            ///< Stream the web page opens first (both are served)
     uint8_t quality;                ///< JPEG quality (0-100)
     uint8_t targetFps;              ///< Target frame rate
     uint8_t maxClients;             ///< Maximum simultaneous clients
     
+    // Power
+    uint32_t autoOffMs;             ///< Turn WiFi off after this long with no clients (0 = never)
+    
     // Defaults
     WifiPreviewConfig()
         : mode(WifiMode::AP)
@@ -86,6 +95,7 @@ struct WifiPreviewConfig {
         , quality(50)
         , targetFps(15)
         , maxClients(4)
+        , autoOffMs(PXLCAM_WIFI_AUTO_OFF_MS)
     {
         strncpy(ssid, "PXLcam", sizeof(ssid));
         strncpy(password, "pxlcam1234", sizeof(password));
@@ -102,6 +112,12 @@ struct WifiPreviewStatus {
     uint8_t clientCount;    ///< Connected clients
     uint32_t framesServed;  ///< Total frames sent
     uint32_t bytesServed;   ///< Total bytes sent
+    uint32_t framesCaptured;///< Frames encoded by the stream capture task
+    uint32_t framesSkipped; ///< Frames clients were too slow to send
+    uint32_t framesDropped; ///< Frames lost because every slot was held
+    uint8_t streamClients;  ///< Open MJPEG, /stylized and WebSocket streams
+    uint32_t tickMaxUs;     ///< Longest tick() so far (µs)
+    bool idle;              ///< Nobody to serve: pipeline down, modem sleep on
     float currentFps;       ///< Current streaming FPS
     char ipAddress[16];     ///< IP address string
 };
@@ -164,7 +180,9 @@ public:
     /**
      * @brief Process WiFi events (call in loop)
      * 
-     * Handles client connections, disconnections, and requests.
+     * Handles client connections, disconnections, and requests. Streams and
+     * captures are written by per-client sender tasks, so this returns as
+     * soon as pending requests are parsed.
      */
     void tick();
     
@@ -192,10 +210,22 @@ public:
     /**
      * @brief Set stream quality
      * 
+     * Ceiling for the per-client rate control: each MJPEG client lowers its
+     * quality vote while its link misses PXLCAM_STREAM_LATENCY_MS, and the
+     * stream is encoded at the best vote. Applies to clients that connect
+     * after the call.
+     * 
      * @param quality JPEG quality (0-100)
      */
     void setQuality(uint8_t quality);
     
+    /**
+     * @brief Set the no-client auto-off timeout
+     * 
+     * @param ms Idle time before stop() (0 = stay on)
+     */
+    void setAutoOffTimeout(uint32_t ms);
+    
     /**
      * @brief Set target FPS
      * 
@@ -211,10 +241,43 @@ private:
     WifiPreview(const WifiPreview&) = delete;
     WifiPreview& operator=(const WifiPreview&) = delete;
     
+    // AP and/or STA bring-up; fills status.ipAddress
+    bool startNetwork();
+    
+    // Power policy: capture pipeline on demand, modem sleep and auto-off
+    bool startPipeline();
+    void stopPipeline();
+    void updatePower(uint32_t now);
+    
+    // Stream capture task (one producer for all clients)
+    static void captureTaskEntry(void* arg);
+    void captureLoop();
+    uint8_t streamQualityVote() const;
+    void applySensorQuality(uint8_t quality);
+    void restoreSensorQuality();
+    
     // HTTP handlers
-    void handleStream();
+    void handleStream(bool stylized);
     void handleCapture();
     void handleStatus();
+    void handleFiles();
+    void handleFile(const char* name);
+    void handleBench();
+    
+    // Per-client sender tasks
+    struct Session;
+    struct FileRequest;
+    enum class SessionKind : uint8_t;
+    bool startSession(SessionKind kind, const WiFiClient& client,
+                      const FileRequest* file = nullptr);
+    static void senderTaskEntry(void* arg);
+    void serveStream(WiFiClient& client, bool stylized);
+    void serveCapture(WiFiClient& client);
+    void serveWebSocket(WiFiClient& client);
+    void serveFileList(WiFiClient& client, const FileRequest& request);
+    void serveFile(WiFiClient& client, const FileRequest& request);
+    void serveMetrics(WiFiClient& client);
+    void serveTrace(WiFiClient& client);
     
     // Private implementation
     struct Impl;
@@ -0,0 +1,52 @@
+#pragma once
+/**
+ * @file wifi_sta.h
+ * @brief Station mode bring-up with a fast-reconnect cache
+ *
+ * A full association scans every channel and waits for DHCP, which takes
+ * seconds. After the first successful join the BSSID, channel and IP lease
+ * are stored in NVS; the next connect to the same SSID goes straight to
+ * that access point on that channel with a static IP, which takes a few
+ * hundred ms. This is what a deep-sleep timelapse upload pays on every wake.
+ *
+ * If the fast path does not associate within PXLCAM_WIFI_FAST_CONNECT_MS
+ * (AP moved channel, router replaced, password changed) the cache is
+ * dropped and a normal scan + DHCP connect runs, which refreshes it.
+ *
+ * The cached IP is reused without asking the DHCP server, so routers that
+ * hand the address to someone else while the camera sleeps can cause a
+ * conflict; a full connect on the next failure resolves it.
+ */
+
+#include <stdint.h>
+
+namespace pxlcam::sta {
+
+enum class ConnectResult : uint8_t {
+    Failed = 0,
+    FastReconnect,      ///< Joined with the cached BSSID/channel/IP
+    FullConnect         ///< Scanned and used DHCP (cache refreshed)
+};
+
+/**
+ * @brief Join a network, trying the fast-reconnect cache first
+ *
+ * Puts the radio in STA mode unless it is already in AP+STA mode.
+ * NVS must be initialized for the cache to be used.
+ *
+ * @param ssid Network name
+ * @param password Passphrase ("" for open networks)
+ * @return How the connection was made, or Failed
+ */
+ConnectResult connect(const char* ssid, const char* password);
+
+/// Drop the fast-reconnect cache (next connect scans)
+void forgetCache();
+
+/// Duration of the last connect() (ms)
+uint32_t getLastConnectMs();
+
+/// Name for logs ("fast", "full", "failed")
+const char* getResultName(ConnectResult result);
+
+}  // namespace pxlcam::sta
@@ -0,0 +1,110 @@
+"""
+Link-time placement report: where the firmware's own code and data ended up.
+
+After firmware.elf is linked, lists every pxlcam:: symbol by memory region
+(IRAM, DRAM, flash code, flash rodata, RTC) with its size, and checks the
+hot kernels and tables of mem_placement.h against the region they are
+meant to be in. Written to $BUILD_DIR/placement.txt; totals and any
+misplaced hot symbol are printed with the build.
+
+    extra_scripts = post:scripts/placement_report.py
+
+The runtime side (heap and scratch buffers, which the linker cannot see) is
+placement::logReport(), 'p' on the HWTEST console.
+"""
+
+import os
+import re
+import subprocess
+
+Import("env")  # noqa: F821  (SCons)
+
+# ESP32 address map (technical reference manual, "Address Mapping")
+REGIONS = [
+    ("IRAM", 0x40070000, 0x400C0000),
+    ("RTC", 0x400C0000, 0x400C2000),
+    ("flash code", 0x400C2000, 0x40C00000),
+    ("flash rodata", 0x3F400000, 0x3F800000),
+    ("PSRAM", 0x3F800000, 0x3FC00000),
+    ("DRAM", 0x3FFAE000, 0x40000000),
+    ("RTC", 0x3FF80000, 0x3FF82000),
+    ("RTC", 0x50000000, 0x50002000),
+]
+
+# Hot symbols (demangled name pattern) and the region mem_placement.h puts them in
+HOT = [
+    (r"pxlcam::filters::ordered_band<", "IRAM"),
+    (r"pxlcam::filters::diffusion_span<", "IRAM"),
+    (r"stylizeSpan\(", "IRAM"),
+    (r"pxlcam::filters::s_bayer(4x4|8x8)$", "DRAM"),
+    (r"kBayer8x8$", "DRAM"),
+    (r"kGameBoyPalette$", "DRAM"),
+    (r"pxlcam::filters::s_(ordered8x8|ordered4x4|blueNoise)$", "DRAM"),
+    (r"pxlcam::placement::.*g_scratch$", "DRAM"),
+]
+
+
+def region_of(addr):
+    for name, low, high in REGIONS:
+        if low <= addr < high:
+            return name
+    return "other"
+
+
+def tool(name):
+    cc = env.subst("$CC")  # noqa: F821
+    return re.sub(r"(gcc|g\+\+|cc)$", name, cc) if cc else name
+
+
+def symbols(elf):
+    out = subprocess.run([tool("nm"), "-C", "-S", "--defined-only", elf],
+                         capture_output=True, text=True, check=True).stdout
+    for line in out.splitlines():
+        # address size type name (symbols without a size are skipped)
+        parts = line.split(None, 3)
+        if len(parts) != 4:
+            continue
+        addr, size, _, name = parts
+        yield int(addr, 16), int(size, 16), name
+
+
+def report(target, source, env):
+    elf = str(target[0])
+    try:
+        syms = [s for s in symbols(elf) if "pxlcam" in s[2]]
+    except (OSError, subprocess.CalledProcessError) as err:
+        print("placement report: nm failed (%s)" % err)
+        return
+
+    hot_iram = "-DPXLCAM_HOT_IRAM=0" not in env.subst("$_CPPDEFFLAGS")
+    totals = {}
+    rows = []
+    misplaced = []
+    for addr, size, name in syms:
+        region = region_of(addr)
+        totals[region] = totals.get(region, 0) + size
+        rows.append((region, size, addr, name))
+        for pattern, expected in HOT:
+            if re.search(pattern, name) and region != expected:
+                if expected == "IRAM" and not hot_iram:
+                    continue
+                misplaced.append("%s in %s, expected %s" % (name, region, expected))
+
+    path = os.path.join(env.subst("$BUILD_DIR"), "placement.txt")
+    with open(path, "w") as f:
+        f.write("# pxlcam symbols by region (bytes)\n")
+        for region, total in sorted(totals.items()):
+            f.write("%-12s %8d\n" % (region, total))
+        for line in misplaced:
+            f.write("MISPLACED %s\n" % line)
+        f.write("\n# region size address symbol\n")
+        for region, size, addr, name in sorted(rows, key=lambda r: (r[0], -r[1])):
+            f.write("%-12s %6d 0x%08x %s\n" % (region, size, addr, name))
+
+    print("placement: " + ", ".join("%s %d" % item for item in sorted(totals.items())) +
+          " bytes (%s)" % path)
+    for line in misplaced:
+        print("placement: WARNING %s" % line)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report)  # noqa: F821
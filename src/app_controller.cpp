@@ -3,12 +3,22 @@
 #include <cstdio>
 #include <cstring>
 
+#include <esp_attr.h>
 #include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <esp_timer.h>
 #include <esp32-hal-psram.h>
 
+#include "button_irq.h"
+#include "camera_service.h"
+#include "energy_meter.h"
+#include "frame_arena.h"
 #include "logging.h"
+#include "mem_placement.h"
+#include "pipeline_bench.h"
 #include "preview.h"
 #include "pxlcam_config.h"
+#include "trace.h"
 
 #if PXLCAM_AUTO_EXPOSURE
 #include "exposure_ctrl.h"
@@ -17,6 +27,7 @@
 // v1.2.0 modules
 #include "mode_manager.h"
 #include "capture_pipeline.h"
+#include "thumbnail_index.h"
 #include "ui_menu.h"
 #include "nvs_store.h"
 #include "display_menu.h"
@@ -31,6 +42,10 @@
 #include "filters/postprocess.h"
 #endif
 
+#ifdef PXL_V13_EXPERIMENTAL
+#include "palettes/palette_manager.h"
+#endif
+
 #if PXLCAM_FEATURE_WIFI_PREVIEW
 #include "wifi_preview.h"
 #include "wifi_menu.h"
@@ -42,6 +57,8 @@
 #include "timelapse_settings.h"
 #include "timelapse_menu.h"
 #include "timelapse_power.h"
+#include "timelapse_sequence.h"
+#include "timelapse_motion.h"
 #endif
 
 // =============================================================================
@@ -58,15 +75,63 @@ namespace pxlcam {
 
 namespace {
 constexpr uint32_t kFeedbackDurationMs = 1500;
+
+// Pixel format configureCamera() last came up in, so a deep-sleep wake
+// starts the camera once instead of working down the fallback list
+struct CameraFormatCache {
+    bool valid;
+    pixformat_t pixelFormat;
+    bool usesRgb;
+    bool fallbackToJpeg;
+};
+RTC_DATA_ATTR CameraFormatCache g_cameraFormat;
 #ifdef PXLCAM_ENABLE_METRICS
 constexpr bool kEnableMetrics = true;
 #else
 constexpr bool kEnableMetrics = false;
 #endif
+
+#if PXLCAM_FEATURE_TIMELAPSE && PXLCAM_CAPTURE_BURST && PXLCAM_STYLIZED_CAPTURE && !PXLCAM_STRIP_CAPTURE
+constexpr uint32_t kBurstProgressMs = 250;
+
+void drawBurstProgress(uint8_t grabbed, uint8_t total) {
+#if PXLCAM_ENABLE_MENU
+    char label[24];
+    snprintf(label, sizeof(label), "Burst %u/%u", grabbed, total);
+    pxlcam::ui::drawProgressScreen(label, static_cast<uint8_t>(grabbed * 100 / total));
+#else
+    (void)grabbed;
+    (void)total;
+#endif
+}
+#endif
+
+// Holds netLock_ (WiFi server state) when app_net runs; no-op without it
+class NetGuard {
+   public:
+    explicit NetGuard(SemaphoreHandle_t lock) : lock_(lock) {
+        if (lock_) {
+            xSemaphoreTake(lock_, portMAX_DELAY);
+        }
+    }
+    ~NetGuard() {
+        if (lock_) {
+            xSemaphoreGive(lock_);
+        }
+    }
+    NetGuard(const NetGuard&) = delete;
+    NetGuard& operator=(const NetGuard&) = delete;
+
+   private:
+    SemaphoreHandle_t lock_;
+};
 }  // namespace
 
 void AppController::begin() {
     PXLCAM_LOGI("AppController begin (v1.3.0)");
+    pxlcam::energy::begin();  // Charges a deep sleep that just ended to the ledger
+    pxlcam::trace::begin();   // Before the tasks it names start
+    pxlcam::frames::begin();  // Consumers register as their features start
     cameraPins_ = makeDefaultPins();
     cameraSettings_ = makeDefaultSettings();
     fallbackToJpeg_ = false;
@@ -74,6 +139,10 @@ void AppController::begin() {
     button_.begin();
     startupGuardExpiryMs_ = millis() + 1000;  // Mitigate GPIO12 boot strap risk.
 
+    // Frame buffers for preview and capture come out of one PSRAM block; it
+    // is reserved before the camera driver takes its frame buffers
+    pxlcam::arena::begin(PXLCAM_FRAME_ARENA_BYTES);
+
     // Initialize v1.2.0 subsystems
     pxlcam::nvs::init();
     pxlcam::mode::init();
@@ -88,10 +157,18 @@ void AppController::begin() {
     // TODO v1.3.0: Initialize stylized capture pipeline
     // pxlcam::filters::palette_init();
     // pxlcam::filters::dither_init();
-    // pxlcam::filters::postprocess_init();
+    // Captures run this chain on their gray rows (capture_pipeline.cpp)
+    pxlcam::filters::postprocess_init();
+    pxlcam::filters::postprocess_load_preset(
+        static_cast<pxlcam::filters::PostProcessPreset>(PXLCAM_CAPTURE_POSTPROCESS_PRESET));
     // PXLCAM_LOGI("v1.3.0: Stylized capture initialized");
 #endif
 
+#ifdef PXL_V13_EXPERIMENTAL
+    // Colors of indexed captures and the stylized stream (color output)
+    pxlcam::palettes::init();
+#endif
+
 #if PXLCAM_FEATURE_WIFI_PREVIEW
     // TODO v1.3.0: WiFi preview init (only when enabled via menu)
     // WiFi is NOT initialized at boot to save power
@@ -105,7 +182,10 @@ void AppController::begin() {
     pxlcam::timelapse::settingsInit();
     pxlcam::timelapse::menuInit();
     pxlcam::timelapse::powerInit();
-    PXLCAM_LOGI("v1.3.0: Timelapse subsystem ready");
+    // A deep-sleep run goes on without display or menu: capture, save, sleep
+    deepSleepWake_ = pxlcam::timelapse::wasDeepSleepWakeup() &&
+                     pxlcam::TimelapseController::instance().resumeFromRtc();
+    PXLCAM_LOGI("v1.3.0: Timelapse subsystem ready%s", deepSleepWake_ ? " (deep sleep run)" : "");
 #endif
 
     // ==========================================================================
@@ -116,15 +196,266 @@ void AppController::begin() {
     diagCfg.updateIntervalMs = 500;
     pxlcam::hwtest::init(&diagCfg);
     PXLCAM_LOGI("=== HWTEST DIAGNOSTIC MODE ACTIVE ===");
+    pxlcam::placement::logReport();
 #endif
 
+    startTasks();
     transitionTo(AppState::InitDisplay);
 }
 
+// =============================================================================
+// Tasks and events
+// =============================================================================
+
+void AppController::startTasks() {
+#if PXLCAM_APP_TASKS
+    events_ = xQueueCreate(PXLCAM_APP_EVENT_QUEUE, sizeof(AppMessage));
+    netLock_ = xSemaphoreCreateMutex();
+    if (!events_ || !netLock_) {
+        PXLCAM_LOGE("App tasks: no memory for the event queue, polling in tick()");
+        if (events_) {
+            vQueueDelete(events_);
+            events_ = nullptr;
+        }
+        if (netLock_) {
+            vSemaphoreDelete(netLock_);
+            netLock_ = nullptr;
+        }
+        return;
+    }
+    
+    // Above idle so a sleeping tick() wakes as soon as an event is posted
+    vTaskPrioritySet(nullptr, PXLCAM_APP_CONTROLLER_PRIORITY);
+    
+    inputTaskRunning_ = xTaskCreatePinnedToCore(inputTask, "app_input", PXLCAM_INPUT_TASK_STACK, this,
+                                                PXLCAM_INPUT_TASK_PRIORITY, nullptr,
+                                                PXLCAM_INPUT_TASK_CORE) == pdPASS;
+    if (xTaskCreatePinnedToCore(shotTask, "app_shot", PXLCAM_SHOT_TASK_STACK, this,
+                                PXLCAM_SHOT_TASK_PRIORITY, &shotTask_, PXLCAM_SHOT_TASK_CORE) != pdPASS) {
+        shotTask_ = nullptr;
+    }
+    bool netRunning = false;
+#if PXLCAM_FEATURE_WIFI_PREVIEW
+    netRunning = xTaskCreatePinnedToCore(netTask, "app_net", PXLCAM_NET_TASK_STACK, this,
+                                         PXLCAM_NET_TASK_PRIORITY, nullptr, PXLCAM_NET_TASK_CORE) == pdPASS;
+#endif
+    if (!netRunning) {
+        // tick() services the server itself
+        vSemaphoreDelete(netLock_);
+        netLock_ = nullptr;
+    }
+    // Whatever failed to start runs inline in tick(), as without PXLCAM_APP_TASKS
+    PXLCAM_LOGI("App tasks: input %s, shot %s, net %s", inputTaskRunning_ ? "task" : "inline",
+                shotTask_ ? "task" : "inline", netRunning ? "task" : "inline");
+#endif
+}
+
+bool AppController::postEvent(AppEvent event, uint16_t arg, int64_t atUs, TickType_t wait) {
+    const AppMessage msg = {event, arg, modalCount_.load(), atUs};
+    if (!events_) {
+        // No queue: only the controller itself posts
+        handleEvent(msg);
+        return true;
+    }
+    if (xQueueSend(events_, &msg, wait) != pdTRUE) {
+        PXLCAM_LOGW("App event %u dropped (queue full)", static_cast<unsigned>(event));
+        return false;
+    }
+    return true;
+}
+
+TickType_t AppController::waitTicks(uint32_t nowMs) const {
+    switch (state_) {
+        case AppState::Idle:
+            if (pendingButton_ != ButtonEvent::None || pendingHold_) {
+                return 0;
+            }
+            break;
+        case AppState::Error:
+            break;
+        case AppState::Capture:
+            // Only the wait for the shot task is idle time
+            if (!shotBusy_ || shotDone_) {
+                return 0;
+            }
+            break;
+        case AppState::Feedback:
+            if (static_cast<int32_t>(feedbackExpiryMs_ - nowMs) <= 0) {
+                return 0;
+            }
+            if (feedbackExpiryMs_ - nowMs < PXLCAM_APP_TICK_MS) {
+                return pdMS_TO_TICKS(feedbackExpiryMs_ - nowMs);
+            }
+            break;
+        default:
+            // Boot, init, filter and save steps follow each other right away
+            return 0;
+    }
+    return pdMS_TO_TICKS(PXLCAM_APP_TICK_MS);
+}
+
+void AppController::handleEvent(const AppMessage &msg) {
+    PXLCAM_TRACE_INSTANT(AppEvent, static_cast<uint32_t>(msg.event));
+    switch (msg.event) {
+        case AppEvent::Button:
+        case AppEvent::Hold:
+            // Sampled while a modal screen was reading the pin itself
+            if (msg.modal != modalCount_.load()) {
+                break;
+            }
+            if (msg.event == AppEvent::Button) {
+                pendingButton_ = static_cast<ButtonEvent>(msg.arg);
+                pendingPressUs_ = msg.atUs;
+                pendingHold_ = false;
+            } else {
+                pendingHold_ = true;
+            }
+            break;
+        case AppEvent::ShotDone:
+            shotDone_ = true;
+            break;
+        case AppEvent::BurstProgress:
+#if PXLCAM_FEATURE_TIMELAPSE && PXLCAM_CAPTURE_BURST && PXLCAM_STYLIZED_CAPTURE && !PXLCAM_STRIP_CAPTURE
+            drawBurstProgress(static_cast<uint8_t>(msg.arg >> 8), static_cast<uint8_t>(msg.arg & 0xFF));
+#endif
+            break;
+    }
+}
+
+ButtonEvent AppController::takeButton() {
+    const ButtonEvent event = pendingButton_;
+    pendingButton_ = ButtonEvent::None;
+    return event;
+}
+
+void AppController::beginModal() {
+    // Counted on both edges: anything posted in between is stale either way
+    modalOpen_.store(true);
+    modalCount_.fetch_add(1);
+    pendingButton_ = ButtonEvent::None;
+    pendingHold_ = false;
+}
+
+void AppController::endModal() {
+    modalCount_.fetch_add(1);
+    modalOpen_.store(false);
+}
+
+void AppController::pollInput(uint32_t nowMs) {
+    if (nowMs < startupGuardExpiryMs_ || modalOpen_.load()) {
+        return;
+    }
+    
+    const uint32_t modal = modalCount_.load();
+    if (modal != inputModalSeen_) {
+        // The press that opened or closed the modal screen is not a new one
+        inputModalSeen_ = modal;
+        button_.discard(nowMs);
+        holdPosted_ = false;
+    }
+    
+    button_.update(nowMs);
+    const ButtonEvent event = button_.consumeEvent();
+    if (event != ButtonEvent::None) {
+        holdPosted_ = false;
+        postEvent(AppEvent::Button, static_cast<uint16_t>(event), button_.getLastPressUs(), 0);
+    } else if (!holdPosted_ && button_.held(1000)) {
+        holdPosted_ = true;
+        postEvent(AppEvent::Hold, 0, button_.getLastPressUs(), 0);
+    }
+    
+#if PXLCAM_HWTEST
+    // Console keys: 'b' pipeline benchmark (runs once the camera is free),
+    // 'p' where the hot tables and buffers live, 't' trace to the card,
+    // 'f' camera service consumers
+    if (Serial.available() > 0) {
+        const int key = Serial.read();
+        if (key == 'b') {
+            pxlcam::bench::requestRun();
+            PXLCAM_LOGI("HWTEST: benchmark requested");
+        } else if (key == 'p') {
+            pxlcam::placement::logReport();
+        } else if (key == 't') {
+            pxlcam::trace::requestDump();
+            PXLCAM_LOGI("HWTEST: trace dump requested");
+        } else if (key == 'f') {
+            pxlcam::frames::logReport();
+        }
+    }
+#endif
+}
+
+void AppController::inputTask(void *arg) {
+    AppController* self = static_cast<AppController*>(arg);
+    for (;;) {
+        if (!pxlcam::input::isActive()) {
+            vTaskDelay(pdMS_TO_TICKS(PXLCAM_INPUT_POLL_MS));
+        } else if (self->modalOpen_.load()) {
+            // Its edges stay queued for discard(); waiting on them would spin
+            vTaskDelay(pdMS_TO_TICKS(PXLCAM_INPUT_IDLE_MS));
+        } else {
+            // Woken by the next edge; the short period only while held (Hold)
+            pxlcam::input::wait(pdMS_TO_TICKS(self->button_.isPressed() ? PXLCAM_INPUT_POLL_MS
+                                                                           : PXLCAM_INPUT_IDLE_MS));
+        }
+        self->pollInput(millis());
+    }
+}
+
+void AppController::shotTask(void *arg) {
+    AppController* self = static_cast<AppController*>(arg);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->takeShot();
+        // Never dropped: the controller waits in Capture for it
+        self->postEvent(AppEvent::ShotDone, 0, esp_timer_get_time(), portMAX_DELAY);
+    }
+}
+
+void AppController::netTask(void *arg) {
+    AppController* self = static_cast<AppController*>(arg);
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(PXLCAM_NET_POLL_MS));
+        NetGuard guard(self->netLock_);
+        self->serviceWifi();
+    }
+}
+
+void AppController::onBurstProgress(uint8_t grabbed, uint8_t total, void *user) {
+#if PXLCAM_FEATURE_TIMELAPSE && PXLCAM_CAPTURE_BURST && PXLCAM_STYLIZED_CAPTURE && !PXLCAM_STRIP_CAPTURE
+    // The OLED takes ~25ms a screen; redrawing on every frame would halve the burst rate
+    static uint32_t lastDraw = 0;
+    const uint32_t now = millis();
+    if (grabbed != total && now - lastDraw < kBurstProgressMs) {
+        return;
+    }
+    lastDraw = now;
+    
+    AppController* self = static_cast<AppController*>(user);
+    if (self) {
+        // On app_shot: the display belongs to the controller
+        self->postEvent(AppEvent::BurstProgress, static_cast<uint16_t>(grabbed << 8 | total),
+                        esp_timer_get_time(), 0);
+    } else {
+        drawBurstProgress(grabbed, total);
+    }
+#else
+    (void)grabbed;
+    (void)total;
+    (void)user;
+#endif
+}
+
 void AppController::tick() {
+    // Sleeps here until an event comes, or for as long as the state allows
+    AppMessage msg;
+    const bool received = events_ && xQueueReceive(events_, &msg, waitTicks(millis())) == pdTRUE;
     const uint32_t now = millis();
-    if (now >= startupGuardExpiryMs_) {
-        button_.update(now);
+    if (!inputTaskRunning_) {
+        pollInput(now);
+    }
+    if (received) {
+        handleEvent(msg);
     }
 
     // ==========================================================================
@@ -147,45 +478,47 @@ void AppController::tick() {
     // v1.3.0 Background Tasks
     // ==========================================================================
     
-#if PXLCAM_FEATURE_TIMELAPSE
-    // v1.3.0: Process timelapse tick
-    if (pxlcam::TimelapseController::instance().isRunning()) {
-        pxlcam::TimelapseController::instance().tick();
-        
-        // Update display periodically during timelapse (every 500ms)
-        static uint32_t lastDisplayUpdate = 0;
-        if (now - lastDisplayUpdate >= 500) {
-            updateTimelapseDisplay();
-            lastDisplayUpdate = now;
-        }
-        
-        if (pxlcam::TimelapseController::instance().shouldCapture()) {
-            // Trigger capture and mark complete
-            transitionTo(AppState::Capture);
-            return;
-        }
-        
-        // Check for light sleep opportunity
-        uint32_t nextCapture = pxlcam::TimelapseController::instance().getTimeToNextCapture();
-        if (pxlcam::timelapse::shouldUseSleep(nextCapture) && nextCapture > 5000) {
-            pxlcam::timelapse::enterLightSleep(nextCapture);
-            pxlcam::timelapse::handleWakeup();
-        }
+    // Finished background SD writes report here, on the loop task
+    storage::pollWrites();
+    
+    if (serviceTimelapse(now)) {
+        return;
+    }
+    
+#if PXLCAM_FEATURE_WIFI_PREVIEW
+    if (!netLock_) {
+        serviceWifi();  // No app_net
+    }
+    
+    // Update WiFi status display periodically
+    static uint32_t lastWifiUpdate = 0;
+    if (wifiPreviewActive_ && now - lastWifiUpdate >= 1000) {
+        updateWifiPreviewDisplay();
+        lastWifiUpdate = now;
     }
 #endif
 
-#if PXLCAM_FEATURE_WIFI_PREVIEW
-    // v1.3.0: Process WiFi events if active
-    if (wifiPreviewActive_ && pxlcam::WifiPreview::instance().isActive()) {
-        pxlcam::WifiPreview::instance().tick();
-        
-        // Update WiFi status display periodically
-        static uint32_t lastWifiUpdate = 0;
-        if (now - lastWifiUpdate >= 1000) {
-            updateWifiPreviewDisplay();
-            lastWifiUpdate = now;
+    // The dump pauses recording and writes to the card: between shots only
+    if (pxlcam::trace::takeDumpRequest()) {
+        if (state_ == AppState::Idle && savesPending_ == 0) {
+            pxlcam::trace::dumpToSd();
+        } else {
+            pxlcam::trace::requestDump();
         }
     }
+
+#if PXLCAM_FEATURE_BENCHMARK
+    // A requested benchmark takes the camera and display while nothing else does
+    if (pxlcam::bench::isPending() && state_ == AppState::Idle && savesPending_ == 0
+#if PXLCAM_FEATURE_TIMELAPSE
+        && !pxlcam::TimelapseController::instance().isRunning()
+#endif
+        ) {
+        showStatus("BENCHMARK\nrunning...", true);
+        pxlcam::bench::poll();
+        showIdleScreen();
+        return;
+    }
 #endif
 
     // Handle menu if visible (v1.2.0)
@@ -197,75 +530,6 @@ void AppController::tick() {
     }
 #endif
 
-    // Check for button events in Idle state
-    if (state_ == AppState::Idle) {
-        ButtonEvent event = button_.consumeEvent();
-        
-        switch (event) {
-            case ButtonEvent::ShortPress:
-                // Short press: capture with current mode
-                captureDurationMs_ = filterDurationMs_ = saveDurationMs_ = 0;
-                feedbackShown_ = false;
-                transitionTo(AppState::Capture);
-                return;
-                
-            case ButtonEvent::LongPress:
-                // Long press (500ms-2s): enter preview mode
-                pxlcam::preview::runPreviewLoop();
-                showIdleScreen();
-                return;
-                
-            case ButtonEvent::VeryLongPress:
-                // Very long press (2s+): open mode menu (modal)
-#if PXLCAM_ENABLE_MENU
-                {
-                    // Convert current mode to menu index
-                    uint8_t currentModeVal = static_cast<uint8_t>(pxlcam::mode::getCurrentMode());
-                    uint8_t menuIdx = pxlcam::menu::fromCaptureModeValue(currentModeVal);
-                    
-                    // Show modal menu - blocks until selection
-                    pxlcam::menu::MenuResult result = pxlcam::menu::showModalAt(menuIdx);
-                    
-                    // Handle selection
-                    if (result == pxlcam::menu::MODE_CANCELLED) {
-                        // Do nothing
-                    }
-#if PXLCAM_FEATURE_TIMELAPSE
-                    else if (result == pxlcam::menu::MODE_TIMELAPSE) {
-                        // v1.3.0: Open timelapse submenu
-                        handleTimelapseMenu();
-                    }
-#endif
-#if PXLCAM_FEATURE_WIFI_PREVIEW
-                    else if (result == pxlcam::menu::MODE_WIFI) {
-                        // v1.3.0: Open WiFi Preview submenu
-                        handleWifiMenu();
-                    }
-#endif
-                    else {
-                        // Mode change
-                        uint8_t newModeVal = pxlcam::menu::toCaptureModeValue(result);
-                        pxlcam::mode::setMode(static_cast<pxlcam::mode::CaptureMode>(newModeVal), true);
-                        PXLCAM_LOGI("Mode changed to: %s", pxlcam::menu::getResultName(result));
-                    }
-                    
-                    showIdleScreen();
-                }
-#endif
-                return;
-                
-            default:
-                break;
-        }
-        
-        // Legacy: also support held() for preview
-        if (button_.held(1000) && event == ButtonEvent::None) {
-            pxlcam::preview::runPreviewLoop();
-            showIdleScreen();
-            return;
-        }
-    }
-
     switch (state_) {
         case AppState::Boot:
             transitionTo(AppState::InitDisplay);
@@ -302,7 +566,147 @@ void AppController::tick() {
     }
 }
 
+/// Timelapse and power decisions; true when tick() has nothing more to do
+bool AppController::serviceTimelapse(uint32_t nowMs) {
+#if PXLCAM_FEATURE_TIMELAPSE
+    // v1.3.0: Process timelapse tick (a run resumed at boot waits for the camera)
+    const bool initializing = state_ == AppState::Boot || state_ == AppState::InitDisplay ||
+                              state_ == AppState::InitStorage || state_ == AppState::InitCamera;
+    if (initializing) {
+        // Nothing to do yet
+    } else if (pxlcam::TimelapseController::instance().isRunning()) {
+        pxlcam::TimelapseController::instance().tick();
+        
+        // Update display periodically during timelapse (every 500ms)
+        static uint32_t lastDisplayUpdate = 0;
+        if (nowMs - lastDisplayUpdate >= 500) {
+            updateTimelapseDisplay();
+            lastDisplayUpdate = nowMs;
+        }
+        
+        // Motion runs watch tiny frames between captures, one per tick
+        const bool motionRun = pxlcam::TimelapseController::instance().getConfig().mode ==
+                               pxlcam::TimelapseMode::MOTION_TRIGGERED;
+        const bool burstRun = pxlcam::TimelapseController::instance().getConfig().mode ==
+                              pxlcam::TimelapseMode::BURST;
+        if (motionRun && (state_ == AppState::Idle || state_ == AppState::Feedback) && savesPending_ == 0 &&
+            (pxlcam::timelapse::motionIsActive() || pxlcam::timelapse::motionBegin()) &&
+            pxlcam::timelapse::motionPoll()) {
+            pxlcam::TimelapseController::instance().onCaptureStart();
+            transitionTo(AppState::Capture);
+            return true;
+        }
+        
+#if PXLCAM_CAPTURE_BURST && PXLCAM_STYLIZED_CAPTURE && !PXLCAM_STRIP_CAPTURE
+        // A grabbed burst develops one frame per pass while the writer drains
+        // the earlier ones (saveFileAsync() waits when its queue is full).
+        // burstGrabbed_ belongs to app_shot while a shot is out (Capture)
+        if ((state_ == AppState::Idle || state_ == AppState::Feedback) && burstGrabbed_) {
+            if (pxlcam::capture::getBurstPending() > 0) {
+                transitionTo(AppState::Capture);
+            } else if (savesPending_ == 0) {
+                pxlcam::TimelapseController::instance().stop();
+            }
+            return true;
+        }
+#endif
+        
+        // Deadlines stay on the start + n * interval grid; a frame waits for the
+        // previous one to reach the card and counts as late if that took too long
+        if ((state_ == AppState::Idle || state_ == AppState::Feedback) &&
+            savesPending_ == 0 && pxlcam::TimelapseController::instance().shouldCapture()) {
+            pxlcam::TimelapseController::instance().onCaptureStart();
+            transitionTo(AppState::Capture);
+            return true;
+        }
+        
+        // Check for light sleep opportunity
+        uint32_t nextCapture = pxlcam::TimelapseController::instance().getTimeToNextCapture();
+        const bool deepSleepRun = pxlcam::TimelapseController::instance().getConfig().powerMode ==
+                                  pxlcam::TimelapsePowerMode::DEEP_SLEEP;
+        // Light sleep would freeze the SD writer mid-file
+        if (motionRun || burstRun) {
+            // Detection runs on every frame, a burst is over in seconds: no sleeping
+        } else if (deepSleepRun) {
+            // Between frames only, with every write on the card
+            if ((state_ == AppState::Idle || state_ == AppState::Feedback) &&
+                savesPending_ == 0 && storage::pendingWrites() == 0 &&
+                pxlcam::timelapse::shouldUseDeepSleep(nextCapture)) {
+                sleepUntilNextFrame(nextCapture);
+            }
+        } else if (storage::pendingWrites() == 0 &&
+            pxlcam::timelapse::shouldUseSleep(nextCapture) && nextCapture > 5000) {
+            // Sensor in standby while asleep; on waking, exposure settles
+            // and the time it took moves the next wake
+            setCameraStandby(cameraPins_, true);
+            const bool slept = pxlcam::timelapse::enterLightSleep(nextCapture);
+            const uint32_t wokeMs = millis();
+            if (slept) {
+                pxlcam::timelapse::handleWakeup();
+            }
+            setCameraStandby(cameraPins_, false);
+            if (slept) {
+                pxlcam::exposure::warmUp();
+                pxlcam::timelapse::recordWakeToReady(pxlcam::timelapse::WakeKind::Light, millis() - wokeMs);
+            }
+        }
+    } else if (pxlcam::timelapse::motionIsActive()) {
+        // Motion run stopped
+        pxlcam::timelapse::motionEnd();
+#if PXLCAM_CAPTURE_BURST && PXLCAM_STYLIZED_CAPTURE && !PXLCAM_STRIP_CAPTURE
+    } else if (state_ != AppState::Capture && state_ != AppState::Save && burstGrabbed_) {
+        // Burst run over or stopped: frames not developed yet are dropped
+        pxlcam::capture::releaseBurst();
+        burstGrabbed_ = false;
+#endif
+    } else if (pxlcam::timelapse::sequenceIsOpen()) {
+        // Stopped from the menu or after its last frame
+        pxlcam::timelapse::sequenceClose();
+    } else if (deepSleepWake_) {
+        // Last frame of a deep-sleep run taken: back to the normal UI
+        deepSleepWake_ = false;
+        if (display::initDisplay(displayConfig_)) {
+            showIdleScreen();
+        }
+    }
+#else
+    (void)nowMs;
+#endif
+    return false;
+}
+
+#if PXLCAM_FEATURE_WIFI_PREVIEW
+void AppController::serviceWifi() {
+    // v1.3.0: Process WiFi events if active
+    if (wifiPreviewActive_ && pxlcam::WifiPreview::instance().isActive()) {
+        pxlcam::WifiPreview::instance().tick();
+    }
+}
+#else
+void AppController::serviceWifi() {}
+#endif
+
 void AppController::transitionTo(AppState nextState) {
+    PXLCAM_TRACE_INSTANT(AppState, static_cast<uint32_t>(nextState));
+    // Capture buffers (strip captures) are leased for the capture step and
+    // handed back once the camera is idle again
+    if (nextState == AppState::Capture) {
+        pxlcam::arena::enterPhase(pxlcam::arena::Phase::Capture);
+    } else if (nextState == AppState::Idle && state_ != AppState::Idle) {
+        pxlcam::arena::enterPhase(pxlcam::arena::Phase::None);
+    }
+    // Energy ledger; OLED refreshes and sleeps mark their own time
+    pxlcam::energy::setState(nextState == AppState::Capture || nextState == AppState::Filter
+                                 ? pxlcam::energy::PowerState::Capture
+                             : nextState == AppState::Save ? pxlcam::energy::PowerState::Save
+                                                           : pxlcam::energy::PowerState::Idle);
+#if PXLCAM_FEATURE_TIMELAPSE
+    // Watching for motion only between frames: everything else wants the
+    // capture frame size back
+    if (nextState != AppState::Idle && nextState != AppState::Feedback) {
+        pxlcam::timelapse::motionEnd();
+    }
+#endif
     state_ = nextState;
 }
 
@@ -332,7 +736,7 @@ void AppController::showIdleScreen() {
 
 void AppController::handleMenuInput() {
 #if PXLCAM_ENABLE_MENU
-    ButtonEvent event = button_.consumeEvent();
+    ButtonEvent event = takeButton();
     
     switch (event) {
         case ButtonEvent::ShortPress:
@@ -354,6 +758,13 @@ void AppController::handleMenuInput() {
 }
 
 void AppController::handleInitDisplay() {
+#if PXLCAM_FEATURE_TIMELAPSE
+    if (deepSleepWake_) {
+        // One frame and back to sleep: the OLED stays off
+        transitionTo(AppState::InitStorage);
+        return;
+    }
+#endif
     if (!display::initDisplay(displayConfig_)) {
         enterError("DISPLAY ERROR");
         return;
@@ -364,6 +775,8 @@ void AppController::handleInitDisplay() {
 }
 
 void AppController::handleInitStorage() {
+    // Fast boot: same card and bus as before the deep sleep, no benchmark
+    storageConfig_.quickMount = deepSleepWake_;
     sdAvailable_ = storage::initSD(storageConfig_);
     
     if (sdAvailable_) {
@@ -405,9 +818,16 @@ void AppController::handleInitStorage() {
 
 void AppController::handleInitCamera() {
     if (!configureCamera()) {
+        g_cameraFormat.valid = false;
         enterError(psramAvailable_ ? "CAM ERROR" : "NO CAMERA");
         return;
     }
+    g_cameraFormat = CameraFormatCache{true, cameraSettings_.pixelFormat, cameraUsesRgb_, fallbackToJpeg_};
+
+#if PXLCAM_STRIP_CAPTURE
+    // Driver buffers are sized for strip captures; preview runs at QVGA
+    setFrameSize(FRAMESIZE_QVGA);
+#endif
 
     if (filterConfig_.enabled && cameraUsesRgb_) {
         filter::init(filterConfig_);
@@ -430,24 +850,136 @@ void AppController::handleInitCamera() {
     // Initialize capture pipeline for stylized captures
     pxlcam::capture::init();
     PXLCAM_LOGI("Capture pipeline initialized");
+    pxlcam::arena::logStats();
 #endif
 
     showIdleScreen();
     feedbackShown_ = false;
+#if PXLCAM_FEATURE_TIMELAPSE
+    if (deepSleepWake_) {
+        // Fast boot: the frame this wake is for, as soon as exposure has
+        // settled and its deadline comes (tick() waits out time to spare)
+        pxlcam::exposure::warmUp();
+        bootCaptureMs_ = millis();
+        pxlcam::timelapse::recordWakeToReady(pxlcam::timelapse::WakeKind::Deep, bootCaptureMs_);
+        PXLCAM_LOGI("Fast boot: camera ready %lu ms after boot, deadline in %lu ms",
+                    static_cast<unsigned long>(bootCaptureMs_),
+                    static_cast<unsigned long>(pxlcam::TimelapseController::instance().getTimeToNextCapture()));
+        if (pxlcam::TimelapseController::instance().shouldCapture()) {
+            pxlcam::TimelapseController::instance().onCaptureStart();
+            transitionTo(AppState::Capture);
+            return;
+        }
+    }
+#endif
     transitionTo(AppState::Idle);
 }
 
 void AppController::handleIdle() {
-    // Event-based handling moved to tick()
-    // Legacy: direct press handling
-    if (button_.consumePressed()) {
-        captureDurationMs_ = filterDurationMs_ = saveDurationMs_ = 0;
-        feedbackShown_ = false;
-        transitionTo(AppState::Capture);
+    // Presses arrive as events (pollInput(), handleEvent())
+    ButtonEvent event = takeButton();
+    
+    switch (event) {
+        case ButtonEvent::ShortPress:
+            // Short press: capture with current mode
+            captureDurationMs_ = filterDurationMs_ = saveDurationMs_ = 0;
+            shutterUs_ = pendingPressUs_;
+            feedbackShown_ = false;
+            transitionTo(AppState::Capture);
+            return;
+            
+        case ButtonEvent::LongPress:
+            // Long press (500ms-2s): enter preview mode
+            beginModal();
+            pxlcam::preview::runPreviewLoop();
+            endModal();
+            showIdleScreen();
+            return;
+            
+        case ButtonEvent::VeryLongPress:
+            // Very long press (2s+): open mode menu (modal)
+#if PXLCAM_ENABLE_MENU
+            {
+                // Convert current mode to menu index
+                uint8_t currentModeVal = static_cast<uint8_t>(pxlcam::mode::getCurrentMode());
+                uint8_t menuIdx = pxlcam::menu::fromCaptureModeValue(currentModeVal);
+                
+                // Show modal menu - blocks until selection
+                beginModal();
+                pxlcam::menu::MenuResult result = pxlcam::menu::showModalAt(menuIdx);
+                
+                // Handle selection
+                if (result == pxlcam::menu::MODE_CANCELLED) {
+                    // Do nothing
+                }
+#if PXLCAM_FEATURE_TIMELAPSE
+                else if (result == pxlcam::menu::MODE_TIMELAPSE) {
+                    // v1.3.0: Open timelapse submenu
+                    handleTimelapseMenu();
+                }
+#endif
+#if PXLCAM_FEATURE_WIFI_PREVIEW
+                else if (result == pxlcam::menu::MODE_WIFI) {
+                    // v1.3.0: Open WiFi Preview submenu
+                    handleWifiMenu();
+                }
+#endif
+                else {
+                    // Mode change
+                    uint8_t newModeVal = pxlcam::menu::toCaptureModeValue(result);
+                    pxlcam::mode::setMode(static_cast<pxlcam::mode::CaptureMode>(newModeVal), true);
+                    PXLCAM_LOGI("Mode changed to: %s", pxlcam::menu::getResultName(result));
+                }
+                endModal();
+                
+                showIdleScreen();
+            }
+#endif
+            return;
+            
+        default:
+            break;
+    }
+    
+    // Still held past the preview threshold
+    if (pendingHold_ && event == ButtonEvent::None) {
+        pendingHold_ = false;
+        beginModal();
+        pxlcam::preview::runPreviewLoop();
+        endModal();
+        showIdleScreen();
+        return;
     }
 }
 
 void AppController::handleCapture(uint32_t nowMs) {
+#if PXLCAM_STYLIZED_CAPTURE && !PXLCAM_STRIP_CAPTURE
+    // The shot runs on app_shot while the progress screen goes up; tick()
+    // comes back here until ShotDone arrives
+    if (!shotBusy_) {
+        shotBusy_ = true;
+        shotDone_ = false;
+        shotStartMs_ = nowMs;
+        if (shotTask_) {
+            xTaskNotifyGive(shotTask_);
+        }
+#if PXLCAM_ENABLE_MENU
+        pxlcam::ui::drawProgressScreen("Capturando...", 20);
+#else
+        showStatus("Capturando...");
+#endif
+        if (!shotTask_) {
+            takeShot();
+            shotDone_ = true;
+        }
+    }
+    if (!shotDone_) {
+        return;
+    }
+    shotBusy_ = false;
+    shotDone_ = false;
+    finishShot();
+#else
     const uint32_t start = nowMs;
     
 #if PXLCAM_ENABLE_MENU
@@ -457,33 +989,8 @@ void AppController::handleCapture(uint32_t nowMs) {
 #endif
 
 #if PXLCAM_STYLIZED_CAPTURE
-    // Use new capture pipeline with stylization
-    pxlcam::capture::ProcessedImage processedImg;
-    pxlcam::capture::CaptureResult result = pxlcam::capture::captureFrame(processedImg);
-    
-    captureDurationMs_ = pxlcam::capture::getLastCaptureDuration();
-    filterDurationMs_ = pxlcam::capture::getLastProcessDuration();
-    
-    if (result != pxlcam::capture::CaptureResult::Success) {
-        strncpy(lastMessage_, pxlcam::capture::getResultMessage(result), sizeof(lastMessage_) - 1);
-        lastMessage_[sizeof(lastMessage_) - 1] = '\0';
-#if PXLCAM_ENABLE_MENU
-        pxlcam::ui::drawErrorScreen("CAPTURA", lastMessage_, true);
-#else
-        showStatus(lastMessage_);
-#endif
-        feedbackExpiryMs_ = millis() + kFeedbackDurationMs;
-        feedbackShown_ = false;
-        transitionTo(AppState::Feedback);
-        return;
-    }
-    
-    // Store processed image info for save
-    processedImageData_ = processedImg.data;
-    processedImageLen_ = processedImg.length;
-    processedExtension_ = processedImg.extension;
-    
-    // Skip Filter state since pipeline already processed
+    // Full-resolution strip capture is streamed straight to SD in handleSave()
+    (void)start;
     transitionTo(AppState::Save);
 #else
     // Legacy capture path
@@ -506,6 +1013,79 @@ void AppController::handleCapture(uint32_t nowMs) {
         transitionTo(AppState::Filter);
     }
 #endif
+#endif
+}
+
+/// Stylized capture call; on app_shot, or inline without it
+void AppController::takeShot() {
+#if PXLCAM_STYLIZED_CAPTURE && !PXLCAM_STRIP_CAPTURE
+    PXLCAM_TRACE_SPAN(shotSpan, Shot, 0);
+    const uint32_t start = shotStartMs_;
+    // Use new capture pipeline with stylization
+    pxlcam::capture::ProcessedImage processedImg;
+    pxlcam::capture::CaptureResult result;
+#if PXLCAM_FEATURE_TIMELAPSE && PXLCAM_CAPTURE_BURST
+    // Burst runs: the first pass grabs every frame, each pass develops the oldest
+    const pxlcam::TimelapseController& timelapse = pxlcam::TimelapseController::instance();
+    if (timelapse.isRunning() && timelapse.getConfig().mode == pxlcam::TimelapseMode::BURST) {
+        if (!burstGrabbed_) {
+            burstGrabbed_ = true;
+            AppController* progressTo = xTaskGetCurrentTaskHandle() == shotTask_ ? this : nullptr;
+            pxlcam::capture::captureBurst(timelapse.getConfig().burstFrames,
+                                          timelapse.getConfig().burstIntervalMs,
+                                          onBurstProgress, progressTo);
+        }
+        result = pxlcam::capture::developBurstFrame(pxlcam::mode::getCurrentMode(), processedImg);
+    } else
+#endif
+    {
+#if PXLCAM_CAPTURE_ZSL
+        // Frame nearest the press is already decoded; timelapse shots use "now"
+        const int64_t shutterUs = shutterUs_ ? shutterUs_ : static_cast<int64_t>(start) * 1000;
+        shutterUs_ = 0;
+        result = pxlcam::capture::captureZsl(pxlcam::mode::getCurrentMode(), shutterUs, processedImg);
+#else
+        (void)start;
+        result = pxlcam::capture::captureFrame(processedImg);
+#endif
+    }
+    
+    captureDurationMs_ = pxlcam::capture::getLastCaptureDuration();
+    filterDurationMs_ = pxlcam::capture::getLastProcessDuration();
+    shotResult_ = result;
+    shotSpan.setArg(static_cast<uint32_t>(result));
+    if (result == pxlcam::capture::CaptureResult::Success) {
+        // Store processed image info for save
+        processedImageData_ = processedImg.data;
+        processedImageLen_ = processedImg.length;
+        processedExtension_ = processedImg.extension;
+        processedThumbnail_ = processedImg.thumbnail;
+        processedWidth_ = processedImg.width;
+        processedHeight_ = processedImg.height;
+    }
+#endif
+}
+
+/// Back on the controller once the shot is done
+void AppController::finishShot() {
+#if PXLCAM_STYLIZED_CAPTURE && !PXLCAM_STRIP_CAPTURE
+    if (shotResult_ != pxlcam::capture::CaptureResult::Success) {
+        strncpy(lastMessage_, pxlcam::capture::getResultMessage(shotResult_), sizeof(lastMessage_) - 1);
+        lastMessage_[sizeof(lastMessage_) - 1] = '\0';
+#if PXLCAM_ENABLE_MENU
+        pxlcam::ui::drawErrorScreen("CAPTURA", lastMessage_, true);
+#else
+        showStatus(lastMessage_);
+#endif
+        feedbackExpiryMs_ = millis() + kFeedbackDurationMs;
+        feedbackShown_ = false;
+        transitionTo(AppState::Feedback);
+        return;
+    }
+    
+    // Skip Filter state since pipeline already processed
+    transitionTo(AppState::Save);
+#endif
 }
 
 void AppController::handleFilter() {
@@ -518,6 +1098,7 @@ void AppController::handleFilter() {
 }
 
 void AppController::handleSave() {
+    PXLCAM_TRACE_SCOPE(Save, 0);
 #if PXLCAM_ENABLE_MENU
     pxlcam::ui::drawProgressScreen("Salvando...", 60);
 #endif
@@ -540,10 +1121,43 @@ void AppController::handleSave() {
         return;
     }
 
+#if PXLCAM_FEATURE_TIMELAPSE && PXLCAM_TIMELAPSE_CONTAINER && PXLCAM_STYLIZED_CAPTURE && !PXLCAM_STRIP_CAPTURE
+    // Timelapse frames go into the run's sequence file instead of one file each
+    if (pxlcam::TimelapseController::instance().isRunning() && saveTimelapseFrame()) {
+        transitionTo(AppState::Feedback);
+        return;
+    }
+#endif
+
     const uint32_t start = millis();
     const uint32_t fileNum = getNextFileNumber();
+    char folder[24];
+    storage::captureFolder(fileNum, folder, sizeof(folder));
 
-#if PXLCAM_STYLIZED_CAPTURE
+#if PXLCAM_STYLIZED_CAPTURE && PXLCAM_STRIP_CAPTURE
+    // Capture at full resolution, stylize and write strip by strip
+    const pxlcam::mode::CaptureMode mode = pxlcam::mode::getCurrentMode();
+    char filePath[64];
+    snprintf(filePath, sizeof(filePath), "%s/PXL_%c%04lu.%s", folder,
+             pxlcam::mode::getModeChar(mode), static_cast<unsigned long>(fileNum),
+             pxlcam::capture::getOutputExtension(pxlcam::capture::getEffectiveOutputFormat(mode)));
+
+    setCameraMode(CameraMode::Capture);
+    size_t fileLen = 0;
+    const uint8_t *thumbnail = nullptr;
+    const pxlcam::capture::CaptureResult result = pxlcam::capture::captureToFile(
+        mode, pxlcam::capture::getOutputFormat(), filePath, &fileLen, &thumbnail);
+    setFrameSize(FRAMESIZE_QVGA);
+
+    const bool saved = result == pxlcam::capture::CaptureResult::Success;
+    if (saved && thumbnail) {
+        pxlcam::thumbs::append(filePath, fileLen, 0, 0, thumbnail, PXLCAM_SD_WRITE_WAIT_MS);
+    }
+    const bool queued = false;  // Strips go to the card as they are stylized
+    captureDurationMs_ = pxlcam::capture::getLastCaptureDuration();
+    filterDurationMs_ = pxlcam::capture::getLastProcessDuration();
+    saveDurationMs_ = millis() - start;
+#elif PXLCAM_STYLIZED_CAPTURE
     // Use processed image from capture pipeline
     if (!processedImageData_ || processedImageLen_ == 0) {
         strncpy(lastMessage_, "ERRO DADOS", sizeof(lastMessage_) - 1);
@@ -558,15 +1172,27 @@ void AppController::handleSave() {
     // Build filename with mode indicator
     char modePrefix = pxlcam::mode::getModeChar(pxlcam::mode::getCurrentMode());
     char filePath[64];
-    snprintf(filePath, sizeof(filePath), "/DCIM/PXL_%c%04lu.%s", 
+    snprintf(filePath, sizeof(filePath), "%s/PXL_%c%04lu.%s", folder,
              modePrefix, static_cast<unsigned long>(fileNum), processedExtension_);
     
-    const bool saved = storage::saveFile(filePath, processedImageData_, processedImageLen_);
+    // Copied into the writer queue, so the buffer goes back to the pipeline
+    // now; the save stage is what the state machine waited for, not the card
+    const int64_t writeStart = esp_timer_get_time();
+    const bool queued = storage::saveFileAsync(filePath, processedImageData_, processedImageLen_,
+                                               &AppController::onSaveComplete, this,
+                                               PXLCAM_SD_WRITE_WAIT_MS);
+    const bool saved = queued || storage::saveFile(filePath, processedImageData_, processedImageLen_);
+    if (saved && processedThumbnail_) {
+        pxlcam::thumbs::append(filePath, processedImageLen_, processedWidth_, processedHeight_,
+                               processedThumbnail_, PXLCAM_SD_WRITE_WAIT_MS);  // Queued after the image
+    }
+    pxlcam::capture::recordSaveDuration(static_cast<uint32_t>(esp_timer_get_time() - writeStart));
     saveDurationMs_ = millis() - start;
     
     pxlcam::capture::releaseFrame();
     processedImageData_ = nullptr;
     processedImageLen_ = 0;
+    processedThumbnail_ = nullptr;
 #else
     // Legacy save path
     if (!activeFrame_) {
@@ -574,28 +1200,75 @@ void AppController::handleSave() {
         return;
     }
     
-    const char *extension = cameraUsesRgb_ ? "raw" : "jpg";
+    const char *extension = activeFrame_->format == PIXFORMAT_JPEG ? "jpg" : "raw";
     char filePath[64];
-    snprintf(filePath, sizeof(filePath), "/DCIM/PXL_%04lu.%s", static_cast<unsigned long>(fileNum), extension);
+    snprintf(filePath, sizeof(filePath), "%s/PXL_%04lu.%s", folder, static_cast<unsigned long>(fileNum), extension);
 
-    const bool saved = storage::saveFile(filePath, activeFrame_);
+    const bool queued = storage::saveFileAsync(filePath, activeFrame_->buf, activeFrame_->len,
+                                               &AppController::onSaveComplete, this,
+                                               PXLCAM_SD_WRITE_WAIT_MS);
+    const bool saved = queued || storage::saveFile(filePath, activeFrame_);
     saveDurationMs_ = millis() - start;
     
     releaseActiveFrame();
 #endif
 
     if (saved) {
-        snprintf(lastMessage_, sizeof(lastMessage_), "SALVO!\n%s", filePath);
-        PXLCAM_LOGI("Frame saved to %s", filePath);
+        snprintf(lastMessage_, sizeof(lastMessage_), "SALVO!\n%s", strrchr(filePath, '/') + 1);
 #if PXLCAM_ENABLE_MENU
-        pxlcam::ui::drawSuccessScreen("FOTO SALVA", filePath + 6, 0);  // Skip "/DCIM/"
+        pxlcam::ui::drawSuccessScreen("FOTO SALVA", strrchr(filePath, '/') + 1, 0);  // Name only
 #endif
 
 #if PXLCAM_HWTEST
         // Record capture timing for diagnostics
+#if PXLCAM_STYLIZED_CAPTURE
+        pxlcam::hwtest::recordCaptureTiming(captureDurationMs_, filterDurationMs_, saveDurationMs_,
+                                            &pxlcam::capture::getLastTimings());
+        pxlcam::hwtest::recordFrameStats(pxlcam::capture::getLastFrameStats());
+#else
         pxlcam::hwtest::recordCaptureTiming(captureDurationMs_, filterDurationMs_, saveDurationMs_);
+#endif
+#endif
+    }
+
+    // A queued image is reported by onSaveComplete() once it is on the card
+    if (queued) {
+        savesPending_++;
+    } else {
+        finishSave(filePath, saved);
+    }
+
+    feedbackExpiryMs_ = millis() + kFeedbackDurationMs;
+    feedbackShown_ = false;
+
+    if (kEnableMetrics) {
+        logMetrics();
+    }
+
+    transitionTo(AppState::Feedback);
+}
+
+void AppController::onSaveComplete(const char *path, bool ok, void *user) {
+    AppController *self = static_cast<AppController *>(user);
+    if (self->savesPending_ > 0) {
+        self->savesPending_--;
+    }
+    self->finishSave(path, ok);
+}
+
+void AppController::finishSave(const char *path, bool ok) {
+    if (ok) {
+        PXLCAM_LOGI("Frame saved to %s", path);
+        pxlcam::energy::noteFrame();
+        if (bootCaptureMs_ != 0) {
+            PXLCAM_LOGI("Fast boot: frame on the card %lu ms after boot (capture started at %lu ms)",
+                        static_cast<unsigned long>(millis()), static_cast<unsigned long>(bootCaptureMs_));
+            bootCaptureMs_ = 0;
+        }
+
+#if PXLCAM_HWTEST
         pxlcam::hwtest::incrementFilesWritten();
-        HWTEST_EVENT("CAPTURE_OK", filePath);
+        HWTEST_EVENT("CAPTURE_OK", path);
         pxlcam::hwtest::logToSerial("CAPTURE");
 #endif
 
@@ -608,7 +1281,7 @@ void AppController::handleSave() {
     } else {
         strncpy(lastMessage_, "ERRO SAVE", sizeof(lastMessage_) - 1);
         lastMessage_[sizeof(lastMessage_) - 1] = '\0';
-        PXLCAM_LOGE("Failed to save frame");
+        PXLCAM_LOGE("Failed to save frame %s", path);
 #if PXLCAM_ENABLE_MENU
         pxlcam::ui::drawErrorScreen("ERRO", "Falha ao salvar", true);
 #endif
@@ -625,16 +1298,64 @@ void AppController::handleSave() {
         }
 #endif
     }
+}
+
+#if PXLCAM_FEATURE_TIMELAPSE && PXLCAM_TIMELAPSE_CONTAINER && PXLCAM_STYLIZED_CAPTURE && !PXLCAM_STRIP_CAPTURE
+bool AppController::saveTimelapseFrame() {
+    using namespace pxlcam::timelapse;
+    if (!processedImageData_ || processedImageLen_ == 0) {
+        return false;
+    }
+    // The sequence holds the card stream across frames; a deep sleep drops it
+    if (pxlcam::TimelapseController::instance().getConfig().powerMode ==
+        pxlcam::TimelapsePowerMode::DEEP_SLEEP) {
+        return false;
+    }
+
+    const uint32_t start = millis();
+    if (!sequenceIsOpen()) {
+        const uint32_t fileNum = getNextFileNumber();
+        char folder[24];
+        char path[64];
+        storage::captureFolder(fileNum, folder, sizeof(folder));
+        snprintf(path, sizeof(path), "%s/PXL_T%04lu.avi", folder, static_cast<unsigned long>(fileNum));
+        if (!sequenceOpen(path, processedImageData_, processedImageLen_,
+                          pxlcam::TimelapseController::instance().getConfig().maxFrames)) {
+            return false;  // Not a BMP (or no file): one file per frame
+        }
+    }
+
+    // Written inline: one frame of sequential chunks, no new directory entry
+    const int64_t writeStart = esp_timer_get_time();
+    const bool saved = sequenceAppend(processedImageData_, processedImageLen_);
+    pxlcam::capture::recordSaveDuration(static_cast<uint32_t>(esp_timer_get_time() - writeStart));
+    saveDurationMs_ = millis() - start;
+
+    pxlcam::capture::releaseFrame();
+    processedImageData_ = nullptr;
+    processedImageLen_ = 0;
+    processedThumbnail_ = nullptr;
+
+    if (saved) {
+        snprintf(lastMessage_, sizeof(lastMessage_), "SALVO!\n%s #%lu", strrchr(sequencePath(), '/') + 1,
+                 static_cast<unsigned long>(sequenceFrames()));
+    } else {
+        sequenceClose();  // Keeps the frames synced so far; the next one starts a new file
+    }
+    finishSave(sequencePath(), saved);
 
     feedbackExpiryMs_ = millis() + kFeedbackDurationMs;
     feedbackShown_ = false;
-
     if (kEnableMetrics) {
         logMetrics();
     }
-
-    transitionTo(AppState::Feedback);
+    return true;
 }
+#else
+bool AppController::saveTimelapseFrame() {
+    return false;
+}
+#endif
 
 void AppController::handleFeedback(uint32_t nowMs) {
     if (!feedbackShown_) {
@@ -655,7 +1376,7 @@ bool AppController::configureCamera() {
     psramAvailable_ = psramFound();
     fallbackToJpeg_ = false;
     cameraSettings_ = makeDefaultSettings();
-    cameraSettings_.frameSize = FRAMESIZE_QVGA;
+    cameraSettings_.frameSize = PXLCAM_STRIP_CAPTURE ? PXLCAM_STRIP_CAPTURE_FRAMESIZE : FRAMESIZE_QVGA;
     cameraSettings_.frameBufferCount = psramAvailable_ ? 2 : 1;
     cameraSettings_.enableLedFlash = false;
 
@@ -673,6 +1394,47 @@ bool AppController::configureCamera() {
         return initCamera(cameraPins_, cameraSettings_);
     }
 
+    // Fast boot: the format that worked before this deep sleep
+    if (deepSleepWake_ && g_cameraFormat.valid) {
+        cameraSettings_.pixelFormat = g_cameraFormat.pixelFormat;
+        cameraUsesRgb_ = g_cameraFormat.usesRgb;
+        fallbackToJpeg_ = g_cameraFormat.fallbackToJpeg;
+        if (initCamera(cameraPins_, cameraSettings_)) {
+            PXLCAM_LOGI("Camera initialized with cached format %d", static_cast<int>(cameraSettings_.pixelFormat));
+            return true;
+        }
+        PXLCAM_LOGW("Cached camera format failed, trying the full list");
+        shutdownCamera();
+        fallbackToJpeg_ = false;
+    }
+
+#if PXLCAM_FEATURE_SENSOR_LUMA
+    // Native luma: no JPEG encode on the sensor, no decode on capture
+    cameraSettings_.pixelFormat = PXLCAM_SENSOR_LUMA_YUV422 ? PIXFORMAT_YUV422 : PIXFORMAT_GRAYSCALE;
+    cameraUsesRgb_ = false;
+    if (initCamera(cameraPins_, cameraSettings_)) {
+        PXLCAM_LOGI("Camera initialized in native luma mode (%s)",
+                    PXLCAM_SENSOR_LUMA_YUV422 ? "YUV422" : "GRAYSCALE");
+        return true;
+    }
+
+    PXLCAM_LOGW("Native luma init failed, attempting fallback");
+    shutdownCamera();
+#endif
+
+#if PXLCAM_FEATURE_SENSOR_RGB565
+    // Native RGB565: half the RGB888 frame size, converted to luma per row
+    cameraSettings_.pixelFormat = PIXFORMAT_RGB565;
+    cameraUsesRgb_ = false;  // Pixel filters need RGB888
+    if (initCamera(cameraPins_, cameraSettings_)) {
+        PXLCAM_LOGI("Camera initialized in native RGB565 mode");
+        return true;
+    }
+
+    PXLCAM_LOGW("Native RGB565 init failed, attempting fallback");
+    shutdownCamera();
+#endif
+
 #if PXLCAM_FEATURE_RGB888_EXPERIMENTAL
     // Experimental: Try RGB888 with automatic fallback
     PXLCAM_LOGI("RGB888 experimental mode enabled - attempting init");
@@ -716,20 +1478,24 @@ void AppController::releaseActiveFrame() {
 
 void AppController::handleError() {
     // Allow exit from error state via button press
-    if (button_.consumePressed()) {
+    if (takeButton() != ButtonEvent::None) {
         initializationFailed_ = false;
         transitionTo(AppState::InitDisplay);
     }
 }
 
 uint32_t AppController::getNextFileNumber() {
-    return ++fileCounter_;
+    // Persistent across boots; no directory scan
+    return storage::nextFileNumber();
 }
 
 void AppController::logMetrics() const {
     const uint32_t freePsram = psramFound() ? ESP.getFreePsram() : 0;
     const uint32_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
     PXLCAM_LOGI("Metrics - capture:%ums filter:%ums save:%ums free_psram:%u free_heap:%u", captureDurationMs_, filterDurationMs_, saveDurationMs_, freePsram, freeHeap);
+#if PXLCAM_STYLIZED_CAPTURE
+    pxlcam::capture::logStageStats();
+#endif
 }
 
 // =============================================================================
@@ -757,11 +1523,28 @@ void AppController::handleTimelapseMenu() {
             ctrl.setInterval(intervalMs);
             ctrl.setMaxFrames(maxFramesVal);
             
+            // Intervals of minutes sleep deep between frames; motion and burst runs stay awake
+            pxlcam::TimelapseConfig config = ctrl.getConfig();
+            const bool burst = PXLCAM_TIMELAPSE_BURST_FRAMES > 0;
+            config.mode = burst ? pxlcam::TimelapseMode::BURST
+                        : PXLCAM_TIMELAPSE_MOTION_TRIGGER ? pxlcam::TimelapseMode::MOTION_TRIGGERED
+                                                          : pxlcam::TimelapseMode::INTERVAL;
+            config.burstFrames = PXLCAM_TIMELAPSE_BURST_FRAMES;
+            config.burstIntervalMs = PXLCAM_BURST_INTERVAL_MS;
+            config.powerMode = (burst || PXLCAM_TIMELAPSE_MOTION_TRIGGER) ? pxlcam::TimelapsePowerMode::ACTIVE
+                             : (PXLCAM_TIMELAPSE_DEEP_SLEEP_MS > 0 && intervalMs >= PXLCAM_TIMELAPSE_DEEP_SLEEP_MS)
+                                   ? pxlcam::TimelapsePowerMode::DEEP_SLEEP
+                                   : pxlcam::TimelapsePowerMode::LIGHT_SLEEP;
+            ctrl.setConfig(config);
+            
             // Show start screen
             drawStartScreen(intervalMs, maxFramesVal);
             delay(1500);
             
-            // Start timelapse
+            // Start timelapse; wake margins are learned anew for this scene and
+            // the energy figures cover this run only
+            pxlcam::timelapse::resetWakeModel();
+            pxlcam::energy::reset();
             ctrl.begin();
             PXLCAM_LOGI("Timelapse started: interval=%lums, maxFrames=%lu", 
                         intervalMs, maxFramesVal);
@@ -801,6 +1584,32 @@ void AppController::updateTimelapseDisplay() {
         pxlcam::timelapse::drawActiveScreen();
     }
 }
+
+void AppController::sleepUntilNextFrame(uint32_t sleepMs) {
+    const pxlcam::TimelapseStatus status = pxlcam::TimelapseController::instance().getStatus();
+    PXLCAM_LOGI("Timelapse: frame %lu done (%lu ms late, max %lu), deep sleep for %lu ms",
+                static_cast<unsigned long>(status.framesCaptured),
+                static_cast<unsigned long>(status.lastLatenessMs),
+                static_cast<unsigned long>(status.maxLatenessMs),
+                static_cast<unsigned long>(sleepMs));
+    pxlcam::TimelapseController::instance().suspendToRtc();
+
+    // Everything but the RTC powers down; the sensor is held in PWDN
+#if PXLCAM_HWTEST
+    pxlcam::hwtest::logShutdown();
+#endif
+    storage::shutdownSD();
+    shutdownCamera();
+    holdCameraPowerDown(cameraPins_);
+    display::shutdownDisplay();
+
+    pxlcam::timelapse::enterDeepSleep(sleepMs);
+
+    // Only reached if the wake timer could not be set
+    PXLCAM_LOGE("Deep sleep failed, timelapse stopped");
+    pxlcam::TimelapseController::instance().stop();
+    esp_restart();
+}
 #else
 void AppController::handleTimelapseMenu() {
     // Timelapse disabled
@@ -808,6 +1617,9 @@ void AppController::handleTimelapseMenu() {
 void AppController::updateTimelapseDisplay() {
     // Timelapse disabled
 }
+void AppController::sleepUntilNextFrame(uint32_t) {
+    // Timelapse disabled
+}
 #endif // PXLCAM_FEATURE_TIMELAPSE
 
 // =============================================================================
@@ -828,10 +1640,14 @@ void AppController::handleWifiPreviewToggle() {
         config.targetFps = 10;  // Lower FPS for stability
         config.quality = 40;   // Lower quality for speed
         
-        if (pxlcam::WifiPreview::instance().init(config) &&
-            pxlcam::WifiPreview::instance().start()) {
-            
-            wifiPreviewActive_ = true;
+        bool started;
+        {
+            NetGuard guard(netLock_);
+            started = pxlcam::WifiPreview::instance().init(config) &&
+                      pxlcam::WifiPreview::instance().start();
+            wifiPreviewActive_ = started;
+        }
+        if (started) {
             
             // Show success with IP
             String ip = pxlcam::WifiPreview::instance().getIPAddress();
@@ -848,8 +1664,11 @@ void AppController::handleWifiPreviewToggle() {
         }
     } else {
         // Stop WiFi Preview
-        pxlcam::WifiPreview::instance().stop();
-        wifiPreviewActive_ = false;
+        {
+            NetGuard guard(netLock_);
+            pxlcam::WifiPreview::instance().stop();
+            wifiPreviewActive_ = false;
+        }
         
         showStatus("WiFi OFF");
         delay(1000);
@@ -894,11 +1713,14 @@ void AppController::handleWifiMenu() {
             config.targetFps = 10;
             config.quality = 40;
             
-            if (pxlcam::WifiPreview::instance().init(config) &&
-                pxlcam::WifiPreview::instance().start()) {
-                
-                wifiPreviewActive_ = true;
-                
+            bool started;
+            {
+                NetGuard guard(netLock_);
+                started = pxlcam::WifiPreview::instance().init(config) &&
+                          pxlcam::WifiPreview::instance().start();
+                wifiPreviewActive_ = started;
+            }
+            if (started) {
                 // Enable mDNS for pxlcam.local
                 pxlcam::wifi_enable_mdns("pxlcam");
                 
@@ -918,8 +1740,11 @@ void AppController::handleWifiMenu() {
         }
         
         case WifiMenuResult::STOP: {
-            pxlcam::WifiPreview::instance().stop();
-            wifiPreviewActive_ = false;
+            {
+                NetGuard guard(netLock_);
+                pxlcam::WifiPreview::instance().stop();
+                wifiPreviewActive_ = false;
+            }
             
             drawStoppedScreen();
             delay(1500);
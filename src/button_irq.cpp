@@ -0,0 +1,237 @@
+/**
+ * @file button_irq.cpp
+ * @brief GPIO-interrupt button driver: timestamped, debounced edges
+ */
+
+#include "button_irq.h"
+
+#include <driver/gpio.h>
+#include <esp_attr.h>
+#include <esp_intr_alloc.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <freertos/timers.h>
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
+
+#include "logging.h"
+
+namespace pxlcam::input {
+
+namespace {
+
+constexpr const char* kLogTag = "input";
+
+gpio_num_t g_pin = GPIO_NUM_NC;
+uint8_t g_activeLevel = LOW;
+bool g_active = false;
+bool g_wakeArmed = false;
+QueueHandle_t g_edges = nullptr;
+TimerHandle_t g_lockout = nullptr;
+
+// Shared by the interrupt and the timer task
+portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+bool g_stable = false;          // Debounced level: pressed
+bool g_locked = false;          // Inside the lockout after a transition
+int64_t g_lastEdgeUs = 0;
+uint32_t g_rawEdges = 0;
+uint32_t g_transitions = 0;
+uint32_t g_dropped = 0;
+
+// gpio_get_level() lives in flash, and this runs while the cache is off
+// too (SD and NVS writes)
+bool IRAM_ATTR pinPressed() {
+    const uint32_t pin = static_cast<uint32_t>(g_pin);
+    const uint32_t level = pin < 32 ? (REG_READ(GPIO_IN_REG) >> pin) & 1
+                                    : (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 1;
+    return level == g_activeLevel;
+}
+
+void IRAM_ATTR onEdge(void*) {
+    const int64_t nowUs = esp_timer_get_time();
+    const bool pressed = pinPressed();
+
+    portENTER_CRITICAL_ISR(&g_lock);
+    g_rawEdges++;
+    g_lastEdgeUs = nowUs;
+    const bool transition = !g_locked && pressed != g_stable;
+    if (transition) {
+        g_stable = pressed;
+        g_locked = true;
+    }
+    portEXIT_CRITICAL_ISR(&g_lock);
+    if (!transition) {
+        return;     // Bounce inside the lockout, or back to the stable level
+    }
+
+    BaseType_t woken = pdFALSE;
+    const Edge edge = {nowUs, pressed};
+    const bool queued = xQueueSendFromISR(g_edges, &edge, &woken) == pdTRUE;
+    xTimerResetFromISR(g_lockout, &woken);
+    portENTER_CRITICAL_ISR(&g_lock);
+    if (queued) {
+        g_transitions++;
+    } else {
+        g_dropped++;
+    }
+    portEXIT_CRITICAL_ISR(&g_lock);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/// Lockout over (or awake again): a level that changed under it is a
+/// transition of its own, stamped with the last edge seen
+void settle() {
+    const bool pressed = pinPressed();
+    portENTER_CRITICAL(&g_lock);
+    const bool transition = pressed != g_stable;
+    const int64_t atUs = g_lastEdgeUs;
+    if (transition) {
+        g_stable = pressed;
+        g_locked = true;
+    } else {
+        g_locked = false;
+    }
+    portEXIT_CRITICAL(&g_lock);
+    if (!transition) {
+        return;
+    }
+
+    const Edge edge = {atUs, pressed};
+    const bool queued = xQueueSend(g_edges, &edge, 0) == pdTRUE;
+    xTimerReset(g_lockout, 0);
+    portENTER_CRITICAL(&g_lock);
+    if (queued) {
+        g_transitions++;
+    } else {
+        g_dropped++;
+    }
+    portEXIT_CRITICAL(&g_lock);
+}
+
+void onLockoutEnd(TimerHandle_t) {
+    settle();
+}
+
+}  // namespace
+
+bool begin(gpio_num_t pin, uint8_t activeLevel, uint32_t debounceMs) {
+    if (g_active) {
+        return true;
+    }
+    g_pin = pin;
+    g_activeLevel = activeLevel;
+
+    const TickType_t lockoutTicks = pdMS_TO_TICKS(debounceMs) > 0 ? pdMS_TO_TICKS(debounceMs) : 1;
+    g_edges = xQueueCreate(PXLCAM_BUTTON_EDGE_QUEUE, sizeof(Edge));
+    g_lockout = xTimerCreate("btn_lockout", lockoutTicks, pdFALSE, nullptr, onLockoutEnd);
+
+    // The camera driver installs the same service (it tolerates ours)
+    esp_err_t err = ESP_ERR_NO_MEM;
+    if (g_edges && g_lockout) {
+        err = gpio_install_isr_service(ESP_INTR_FLAG_LOWMED | ESP_INTR_FLAG_IRAM);
+        if (err == ESP_ERR_INVALID_STATE) {
+            err = ESP_OK;   // Already installed
+        }
+    }
+    if (err == ESP_OK) {
+        g_stable = pinPressed();
+        gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+        err = gpio_isr_handler_add(pin, onEdge, nullptr);
+    }
+    if (err == ESP_OK) {
+        err = gpio_intr_enable(pin);
+    }
+
+    if (err != ESP_OK) {
+        PXLCAM_LOGW_TAG(kLogTag, "Button interrupt unavailable (%d), polling GPIO%d", err, pin);
+        gpio_isr_handler_remove(pin);
+        if (g_lockout) {
+            xTimerDelete(g_lockout, 0);
+            g_lockout = nullptr;
+        }
+        if (g_edges) {
+            vQueueDelete(g_edges);
+            g_edges = nullptr;
+        }
+        return false;
+    }
+
+    g_active = true;
+    PXLCAM_LOGI_TAG(kLogTag, "Button interrupt on GPIO%d, %lu ms lockout", pin,
+                    static_cast<unsigned long>(debounceMs));
+    return true;
+}
+
+bool isActive() {
+    return g_active;
+}
+
+bool isPressed() {
+    portENTER_CRITICAL(&g_lock);
+    const bool pressed = g_stable;
+    portEXIT_CRITICAL(&g_lock);
+    return pressed;
+}
+
+bool next(Edge& edge) {
+    return g_active && xQueueReceive(g_edges, &edge, 0) == pdTRUE;
+}
+
+bool wait(TickType_t ticks) {
+    Edge edge;
+    return g_active && xQueuePeek(g_edges, &edge, ticks) == pdTRUE;
+}
+
+void flush() {
+    if (g_active) {
+        xQueueReset(g_edges);
+    }
+}
+
+bool armWake() {
+#if PXLCAM_BUTTON_WAKE
+    if (!g_active || isPressed()) {
+        return false;
+    }
+    gpio_intr_disable(g_pin);
+    if (gpio_wakeup_enable(g_pin, g_activeLevel == LOW ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL) != ESP_OK ||
+        esp_sleep_enable_gpio_wakeup() != ESP_OK) {
+        gpio_wakeup_disable(g_pin);
+        gpio_set_intr_type(g_pin, GPIO_INTR_ANYEDGE);
+        gpio_intr_enable(g_pin);
+        return false;
+    }
+    g_wakeArmed = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void disarmWake() {
+    if (!g_wakeArmed) {
+        return;
+    }
+    g_wakeArmed = false;
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+    gpio_wakeup_disable(g_pin);
+    gpio_set_intr_type(g_pin, GPIO_INTR_ANYEDGE);
+    gpio_intr_enable(g_pin);
+
+    // The press that woke us had no interrupt: it is stamped now
+    portENTER_CRITICAL(&g_lock);
+    g_lastEdgeUs = esp_timer_get_time();
+    portEXIT_CRITICAL(&g_lock);
+    settle();
+}
+
+Stats getStats() {
+    portENTER_CRITICAL(&g_lock);
+    const Stats stats = {g_rawEdges, g_transitions, g_dropped};
+    portEXIT_CRITICAL(&g_lock);
+    return stats;
+}
+
+}  // namespace pxlcam::input
@@ -1,4 +1,5 @@
 #include "button_manager.h"
+#include "button_irq.h"
 #include "pxlcam_config.h"
 
 namespace pxlcam {
@@ -19,39 +20,82 @@ void ButtonManager::begin() {
     pendingEvent_ = ButtonEvent::None;
     lastTransitionMs_ = millis();
     pressStartMs_ = 0;
+#if PXLCAM_BUTTON_IRQ
+    irq_ = input::begin(pin_, activeLevel_, debounceMs_);
+#endif
 }
 
 void ButtonManager::update(uint32_t nowMs) {
+    if (irq_) {
+        // Already debounced, each edge at its interrupt time
+        input::Edge edge;
+        while (input::next(edge)) {
+            const uint32_t atMs = static_cast<uint32_t>(edge.atUs / 1000);
+            if (edge.pressed && !latched_) {
+                latchPress(atMs, edge.atUs);
+            } else if (!edge.pressed && latched_) {
+                latchRelease(atMs);
+            }
+        }
+        return;
+    }
+    
     const uint8_t state = digitalRead(static_cast<uint8_t>(pin_));
     if (state == activeLevel_) {
         // Button is pressed
         if (!latched_ && (nowMs - lastTransitionMs_) >= debounceMs_) {
-            latched_ = true;
-            pendingPress_ = true;
-            pressStartMs_ = nowMs;
-            lastTransitionMs_ = nowMs;
+            latchPress(nowMs, static_cast<int64_t>(nowMs) * 1000);
         }
     } else {
         // Button released
         if (latched_ && (nowMs - lastTransitionMs_) >= debounceMs_) {
-            // Calculate hold duration and determine event type
-            uint32_t holdDuration = nowMs - pressStartMs_;
-            
-            if (holdDuration >= kVeryLongPressMs) {
-                pendingEvent_ = ButtonEvent::VeryLongPress;
-            } else if (holdDuration >= kLongPressMinMs) {
-                pendingEvent_ = ButtonEvent::LongPress;
-            } else {
-                pendingEvent_ = ButtonEvent::ShortPress;
-            }
-            
-            latched_ = false;
-            pressStartMs_ = 0;
-            lastTransitionMs_ = nowMs;
+            latchRelease(nowMs);
         }
     }
 }
 
+void ButtonManager::latchPress(uint32_t atMs, int64_t atUs) {
+    latched_ = true;
+    pendingPress_ = true;
+    pressStartMs_ = atMs;
+    lastPressMs_ = atMs;
+    lastPressUs_ = atUs;
+    lastTransitionMs_ = atMs;
+}
+
+void ButtonManager::latchRelease(uint32_t atMs) {
+    // Calculate hold duration and determine event type
+    uint32_t holdDuration = atMs - pressStartMs_;
+    
+    if (ignoreRelease_) {
+        ignoreRelease_ = false;
+    } else if (holdDuration >= kVeryLongPressMs) {
+        pendingEvent_ = ButtonEvent::VeryLongPress;
+    } else if (holdDuration >= kLongPressMinMs) {
+        pendingEvent_ = ButtonEvent::LongPress;
+    } else {
+        pendingEvent_ = ButtonEvent::ShortPress;
+    }
+    
+    latched_ = false;
+    pressStartMs_ = 0;
+    lastTransitionMs_ = atMs;
+}
+
+void ButtonManager::discard(uint32_t nowMs) {
+    if (irq_) {
+        input::flush();
+        latched_ = input::isPressed();
+    } else {
+        latched_ = digitalRead(static_cast<uint8_t>(pin_)) == activeLevel_;
+    }
+    ignoreRelease_ = latched_;
+    pendingPress_ = false;
+    pendingEvent_ = ButtonEvent::None;
+    pressStartMs_ = 0;
+    lastTransitionMs_ = nowMs;
+}
+
 bool ButtonManager::consumePressed() {
     const bool wasPressed = pendingPress_;
     pendingPress_ = false;
@@ -1,5 +1,6 @@
 #include "camera_bringup.h"
 #include "camera_config.h"
+#include "camera_service.h"
 #include "display.h"
 #include <Arduino.h>
 
@@ -32,6 +33,8 @@ void run() {
     Serial.println("[CAPTURE] Capturing frame...");
     pxlcam::display::printDisplay("CAPTURING...", 1, 0, 0, true, false);
 
+    // A running camera service must not take this frame
+    pxlcam::frames::Pause pause;
     uint32_t start = millis();
     camera_fb_t *fb = esp_camera_fb_get();
     uint32_t elapsed = millis() - start;
@@ -3,20 +3,70 @@
 #include <esp32-hal-psram.h>
 #include <esp_err.h>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
+#include "camera_service.h"
 #include "logging.h"
+#include "pxlcam_config.h"
+#include "sensor_profile.h"
 
 namespace pxlcam {
 
 namespace {
 
 constexpr const char *kLogTag = "pxlcam-camera";
+constexpr uint32_t kStandbyExitMs = 5;  // PWDN low to sensor clocks running
 
 bool g_cameraInitialized = false;
 bool g_ledConfigured = false;
 CameraPins g_activePins{};
 [[maybe_unused]] CameraSettings g_activeSettings{};
 
+CameraModeProfile g_modes[static_cast<size_t>(CameraMode::Count)] = {};
+CameraMode g_mode = CameraMode::Count;
+CameraModeStats g_modeStats{};
+
+// Profiles for the buffers initCamera() just sized: a mode never asks for
+// more pixels than the capture framesize
+void buildModeProfiles(const CameraSettings &settings) {
+    const bool jpeg = settings.pixelFormat == PIXFORMAT_JPEG;
+    g_modes[static_cast<size_t>(CameraMode::Capture)] = {settings.frameSize, settings.pixelFormat,
+                                                         jpeg ? settings.jpegQuality : uint8_t{0}};
+    const framesize_t preview = PXLCAM_PREVIEW_SENSOR_FRAMESIZE < settings.frameSize
+                                    ? PXLCAM_PREVIEW_SENSOR_FRAMESIZE : settings.frameSize;
+    g_modes[static_cast<size_t>(CameraMode::Preview)] = {preview, settings.pixelFormat,
+                                                         jpeg ? uint8_t{PXLCAM_PREVIEW_JPEG_QUALITY} : uint8_t{0}};
+    g_mode = CameraMode::Capture;
+}
+
+int64_t frameStartUs(const camera_fb_t *fb) {
+    return static_cast<int64_t>(fb->timestamp.tv_sec) * 1000000 + fb->timestamp.tv_usec;
+}
+
+/// Drop the frames begun before `switchUs`; returns how many. Frames carry
+/// the new size in fb->width either way (the driver fills it from the
+/// sensor status), so only their start stamp tells them apart.
+uint8_t flushStaleFrames(int64_t switchUs) {
+    uint8_t dropped = 0;
+    for (uint8_t i = 0; i < PXLCAM_CAMERA_MODE_FLUSH_MAX; ++i) {
+        camera_fb_t *fb = esp_camera_fb_get();
+        if (!fb) {
+            break;
+        }
+        const int64_t startUs = frameStartUs(fb);
+        esp_camera_fb_return(fb);
+        sensor::atFrameBoundary();
+        // No stamp: the fixed drain setFrameSize() uses
+        if (startUs == 0 ? i >= 1 : startUs >= switchUs) {
+            break;
+        }
+        dropped++;
+    }
+    return dropped;
+}
+
 void configureLed(const CameraPins &pins, bool enableFlash) {
     g_ledConfigured = false;
     if (!enableFlash || pins.pinLed == GPIO_NUM_NC) {
@@ -132,6 +182,11 @@ bool initCamera(const CameraPins &pins, const CameraSettings &settings) {
         shutdownCamera();
     }
 
+    // Latched by holdCameraPowerDown() before a deep sleep
+    if (pins.pinPwdn != GPIO_NUM_NC) {
+        gpio_hold_dis(pins.pinPwdn);
+    }
+
     bool psramAvailable = psramFound();
     if (!psramAvailable) {
         PXLCAM_LOGW_TAG(kLogTag, "PSRAM not detected; forcing single framebuffer in DRAM");
@@ -161,7 +216,9 @@ bool initCamera(const CameraPins &pins, const CameraSettings &settings) {
 
     g_cameraInitialized = true;
     g_activePins = pins;
+    sensor::markUnknown();
     g_activeSettings = settings;
+    buildModeProfiles(settings);
 
     configureLed(pins, settings.enableLedFlash);
 
@@ -174,20 +231,22 @@ camera_fb_t *captureFrame() {
         return nullptr;
     }
 
-    camera_fb_t* fb = esp_camera_fb_get();
+    // A full-size frame, even while a preview holds the sensor small
+    static frames::ConsumerId consumer = frames::registerConsumer("frame", frames::Need::NextFull);
+    camera_fb_t* fb = frames::acquire(consumer);
     
     // ==========================================================================
     // GUARD-RAIL: Validate frame buffer to prevent divide-by-zero crashes
     // ==========================================================================
     if (!fb) {
-        PXLCAM_LOGE_TAG(kLogTag, "captureFrame: esp_camera_fb_get returned NULL");
+        PXLCAM_LOGE_TAG(kLogTag, "captureFrame: no frame from the camera");
         return nullptr;
     }
     
     if (fb->width == 0 || fb->height == 0 || fb->len == 0) {
         PXLCAM_LOGE_TAG(kLogTag, "captureFrame: Invalid frame (w=%u h=%u len=%u)",
                         fb->width, fb->height, fb->len);
-        esp_camera_fb_return(fb);
+        frames::release(fb);
         return nullptr;
     }
     
@@ -198,7 +257,93 @@ void releaseFrame(camera_fb_t *frame) {
     if (!frame) {
         return;
     }
-    esp_camera_fb_return(frame);
+    frames::release(frame);
+}
+
+bool setFrameSize(framesize_t frameSize, uint8_t settleFrames) {
+    if (!g_cameraInitialized) {
+        PXLCAM_LOGW_TAG(kLogTag, "setFrameSize called before camera initialized");
+        return false;
+    }
+
+    // The settle reads come straight from the driver
+    frames::Pause pause;
+    sensor_t *sensor = esp_camera_sensor_get();
+    if (!sensor || !sensor->set_framesize || sensor->set_framesize(sensor, frameSize) != 0) {
+        PXLCAM_LOGE_TAG(kLogTag, "Failed to set frame size %d", static_cast<int>(frameSize));
+        return false;
+    }
+
+    g_mode = CameraMode::Count;
+
+    for (uint8_t i = 0; i < settleFrames; ++i) {
+        camera_fb_t *fb = esp_camera_fb_get();
+        if (fb) {
+            esp_camera_fb_return(fb);
+        }
+    }
+
+    return true;
+}
+
+const CameraModeProfile &cameraModeProfile(CameraMode mode) {
+    return g_modes[mode < CameraMode::Count ? static_cast<size_t>(mode) : 0];
+}
+
+bool setCameraMode(CameraMode mode) {
+    if (!g_cameraInitialized || mode >= CameraMode::Count) {
+        PXLCAM_LOGW_TAG(kLogTag, "setCameraMode(%d) without a camera", static_cast<int>(mode));
+        return false;
+    }
+
+    sensor_t *sensor = esp_camera_sensor_get();
+    if (!sensor || !sensor->set_framesize) {
+        return false;
+    }
+    const CameraModeProfile &profile = cameraModeProfile(mode);
+    const bool resize = sensor->status.framesize != profile.frameSize;
+    const bool requality = profile.jpegQuality != 0 && sensor->set_quality &&
+                           sensor->status.quality != profile.jpegQuality;
+    if (!resize && !requality) {
+        g_mode = mode;
+        return true;
+    }
+
+    // The flush reads come straight from the driver (no-op when the camera
+    // service switches for a full frame itself)
+    frames::Pause pause;
+    const int64_t start = esp_timer_get_time();
+    if (resize && sensor->set_framesize(sensor, profile.frameSize) != 0) {
+        PXLCAM_LOGE_TAG(kLogTag, "Failed to set frame size %d", static_cast<int>(profile.frameSize));
+        g_mode = CameraMode::Count;
+        return false;
+    }
+    if (requality && sensor->set_quality(sensor, profile.jpegQuality) != 0) {
+        PXLCAM_LOGW_TAG(kLogTag, "JPEG quality %u not applied", profile.jpegQuality);
+    }
+
+    // Quality alone changes no geometry: the frames queued are still usable
+    const uint8_t dropped = resize ? flushStaleFrames(esp_timer_get_time()) : 0;
+    const uint32_t elapsed = static_cast<uint32_t>(esp_timer_get_time() - start);
+    g_mode = mode;
+
+    g_modeStats.switches++;
+    g_modeStats.lastSwitchUs = elapsed;
+    g_modeStats.maxSwitchUs = elapsed > g_modeStats.maxSwitchUs ? elapsed : g_modeStats.maxSwitchUs;
+    g_modeStats.lastDropped = dropped;
+    g_modeStats.framesDropped += dropped;
+    PXLCAM_LOGI_TAG(kLogTag, "Camera mode %s: framesize %d quality %u in %lu us (%u stale frames)",
+                    mode == CameraMode::Preview ? "preview" : "capture", static_cast<int>(profile.frameSize),
+                    profile.jpegQuality, static_cast<unsigned long>(elapsed), dropped);
+    return true;
+}
+
+CameraMode getCameraMode() {
+    return g_mode;
+}
+
+CameraModeStats getCameraModeStats() {
+    return g_modeStats;
 }
 
 void shutdownCamera() {
@@ -212,7 +357,29 @@ void shutdownCamera() {
     }
 
     g_cameraInitialized = false;
+    g_mode = CameraMode::Count;
     deactivateLed();
 }
 
+void holdCameraPowerDown(const CameraPins &pins) {
+    if (pins.pinPwdn == GPIO_NUM_NC) {
+        return;
+    }
+    gpio_reset_pin(pins.pinPwdn);
+    gpio_set_direction(pins.pinPwdn, GPIO_MODE_OUTPUT);
+    gpio_set_level(pins.pinPwdn, 1);
+    gpio_hold_en(pins.pinPwdn);
+    gpio_deep_sleep_hold_en();
+}
+
+void setCameraStandby(const CameraPins &pins, bool standby) {
+    if (!g_cameraInitialized || pins.pinPwdn == GPIO_NUM_NC) {
+        return;
+    }
+    gpio_set_level(pins.pinPwdn, standby ? 1 : 0);
+    if (!standby) {
+        vTaskDelay(pdMS_TO_TICKS(kStandbyExitMs));
+    }
+}
+
 }  // namespace pxlcam
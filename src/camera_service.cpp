@@ -0,0 +1,516 @@
+/**
+ * @file camera_service.cpp
+ * @brief One owner of camera readouts, shared by every frame consumer
+ */
+
+#include "camera_service.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include "camera_config.h"
+#include "logging.h"
+#include "sensor_profile.h"
+#include "trace.h"
+
+namespace pxlcam::frames {
+
+namespace {
+
+constexpr const char* kLogTag = "frames";
+constexpr uint8_t kSlots = 4;           // More than the driver has frame buffers
+constexpr uint32_t kRetryMs = 10;       // After a failed readout
+static_assert(PXLCAM_FRAME_CONSUMERS >= 1 && PXLCAM_FRAME_CONSUMERS <= 32,
+              "PXLCAM_FRAME_CONSUMERS must be 1..32 (wake mask)");
+
+struct Slot {
+    camera_fb_t* fb;
+    int64_t readUs;
+    uint32_t seq;
+    uint8_t refs;           // The service's own while publishing, plus one per consumer
+    bool switched;          // Read in a switch for NextFull: not for other needs
+};
+
+struct Consumer {
+    const char* name;
+    Need need;
+    uint8_t everyN;
+    uint8_t skipped;
+    bool used;
+    bool waiting;
+    bool failed;
+    Slot* delivered;
+    uint32_t lastSeq;
+    int64_t waitStartUs;
+    SemaphoreHandle_t ready;    // Given by the service with a delivery
+    SemaphoreHandle_t owner;    // One acquire() at a time
+    uint32_t frames;
+    uint32_t shared;
+    uint32_t timeouts;
+    uint32_t lastWaitUs;
+    uint32_t maxWaitUs;
+};
+
+Slot g_slots[kSlots] = {};
+Consumer g_consumers[PXLCAM_FRAME_CONSUMERS] = {};
+Slot* g_newest = nullptr;
+uint32_t g_seq = 0;
+Stats g_stats = {};
+TaskHandle_t g_task = nullptr;
+uint8_t g_pauses = 0;           // Exclusive readers inside pause()
+bool g_reading = false;         // Service between its first readout and its last
+portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;  // Slots, consumers, stats, pause
+
+bool valid(ConsumerId id) {
+    return id >= 0 && id < PXLCAM_FRAME_CONSUMERS && g_consumers[id].used;
+}
+
+/// Caller holds g_lock
+bool anyWaiting(bool fullOnly) {
+    for (const Consumer& c : g_consumers) {
+        if (c.used && c.waiting && !c.delivered && (!fullOnly || c.need == Need::NextFull)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool waiting(bool fullOnly) {
+    portENTER_CRITICAL(&g_lock);
+    const bool any = anyWaiting(fullOnly);
+    portEXIT_CRITICAL(&g_lock);
+    return any;
+}
+
+bool atCaptureSize() {
+    const sensor_t* sensor = esp_camera_sensor_get();
+    return sensor && sensor->status.framesize == cameraModeProfile(CameraMode::Capture).frameSize;
+}
+
+/// Caller holds g_lock; true if the buffer goes back to the driver
+bool dropRef(Slot& slot) {
+    if (--slot.refs > 0) {
+        return false;
+    }
+    if (g_newest == &slot) {
+        g_newest = nullptr;
+    }
+    g_stats.held--;
+    return true;
+}
+
+/// Hand one readout to everyone waiting for it; returns who to wake. A
+/// frame of a NextFull switch goes to NextFull consumers only
+uint32_t publish(Slot& slot, bool full) {
+    uint32_t wake = 0;
+    uint8_t taken = 0;
+    for (uint8_t i = 0; i < PXLCAM_FRAME_CONSUMERS; i++) {
+        Consumer& c = g_consumers[i];
+        if (!c.used || !c.waiting || c.delivered) {
+            continue;
+        }
+        bool take = false;
+        switch (c.need) {
+            case Need::Latest:
+                take = !slot.switched;
+                break;
+            case Need::EveryNth:
+                take = !slot.switched && ++c.skipped >= c.everyN;
+                break;
+            case Need::NextFull:
+                take = full;
+                break;
+        }
+        if (!take) {
+            continue;
+        }
+        c.skipped = 0;
+        c.delivered = &slot;
+        c.lastSeq = slot.seq;
+        c.frames++;
+        slot.refs++;
+        taken++;
+        wake |= 1u << i;
+    }
+    g_stats.deliveries += taken;
+    if (taken > 1) {
+        g_stats.shared += taken - 1;
+    } else if (taken == 0) {
+        g_stats.unused++;
+    }
+    return wake;
+}
+
+void wakeConsumers(uint32_t wake) {
+    for (uint8_t i = 0; i < PXLCAM_FRAME_CONSUMERS; i++) {
+        if (wake & (1u << i)) {
+            xSemaphoreGive(g_consumers[i].ready);
+        }
+    }
+}
+
+/// The driver gave nothing: waiters get nullptr, as a direct read would
+void failWaiting() {
+    uint32_t wake = 0;
+    portENTER_CRITICAL(&g_lock);
+    g_stats.failures++;
+    for (uint8_t i = 0; i < PXLCAM_FRAME_CONSUMERS; i++) {
+        Consumer& c = g_consumers[i];
+        if (c.used && c.waiting && !c.delivered) {
+            c.failed = true;
+            wake |= 1u << i;
+        }
+    }
+    portEXIT_CRITICAL(&g_lock);
+    wakeConsumers(wake);
+}
+
+Slot* freeSlot() {
+    for (Slot& slot : g_slots) {
+        if (!slot.fb) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+/// Claim the driver for a round of readouts, unless nobody waits or an
+/// exclusive reader holds it
+bool startReading() {
+    portENTER_CRITICAL(&g_lock);
+    g_reading = g_pauses == 0 && anyWaiting(false);
+    const bool reading = g_reading;
+    portEXIT_CRITICAL(&g_lock);
+    return reading;
+}
+
+bool paused() {
+    portENTER_CRITICAL(&g_lock);
+    const bool any = g_pauses > 0;
+    portEXIT_CRITICAL(&g_lock);
+    return any;
+}
+
+void serviceTask(void*) {
+    for (;;) {
+        while (!startReading()) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+
+        // A full-resolution request in another mode: switch for it,
+        // and back once nobody asks for full frames any more. Latest and
+        // EveryNth consumers get none of the frames read in between
+        CameraMode restoreMode = CameraMode::Count;
+        framesize_t restoreSize = FRAMESIZE_INVALID;
+        bool largestAvailable = false;  // Switch failed: NextFull takes what there is
+        if (waiting(true) && !atCaptureSize()) {
+            const sensor_t* sensor = esp_camera_sensor_get();
+            restoreMode = getCameraMode();
+            restoreSize = sensor ? sensor->status.framesize : FRAMESIZE_INVALID;
+            if (setCameraMode(CameraMode::Capture)) {
+                g_stats.modeSwitches++;
+            } else {
+                restoreSize = FRAMESIZE_INVALID;
+                largestAvailable = true;
+            }
+        }
+
+        do {
+            portENTER_CRITICAL(&g_lock);
+            Slot* slot = freeSlot();
+            portEXIT_CRITICAL(&g_lock);
+            if (!slot) {
+                vTaskDelay(1);  // Every buffer out with consumers
+                continue;
+            }
+
+            camera_fb_t* fb;
+            {
+                PXLCAM_TRACE_SPAN(span, FbGet, 0);
+                fb = esp_camera_fb_get();
+                span.setArg(fb ? fb->len : 0);
+            }
+            if (!fb) {
+                failWaiting();
+                vTaskDelay(pdMS_TO_TICKS(kRetryMs));
+                continue;
+            }
+            sensor::atFrameBoundary();
+            const bool full = largestAvailable || atCaptureSize();
+
+            portENTER_CRITICAL(&g_lock);
+            *slot = Slot{fb, esp_timer_get_time(), ++g_seq, 1, restoreSize != FRAMESIZE_INVALID};
+            g_stats.reads++;
+            g_stats.held++;
+            g_newest = slot;
+            const uint32_t wake = publish(*slot, full);
+            const bool last = dropRef(*slot);
+            if (last) {
+                slot->fb = nullptr;
+            }
+            portEXIT_CRITICAL(&g_lock);
+            if (last) {
+                esp_camera_fb_return(fb);
+            }
+            wakeConsumers(wake);
+        } while (waiting(true) && atCaptureSize() && !paused());
+
+        if (restoreSize != FRAMESIZE_INVALID) {
+            if (restoreMode < CameraMode::Count) {
+                setCameraMode(restoreMode);
+            } else {
+                setFrameSize(restoreSize, 1);
+            }
+        }
+
+        portENTER_CRITICAL(&g_lock);
+        g_reading = false;
+        portEXIT_CRITICAL(&g_lock);
+    }
+}
+
+/// No service: the caller reads the driver itself
+camera_fb_t* readDirect() {
+    camera_fb_t* fb;
+    {
+        PXLCAM_TRACE_SPAN(span, FbGet, 0);
+        fb = esp_camera_fb_get();
+        span.setArg(fb ? fb->len : 0);
+    }
+    if (fb) {
+        sensor::atFrameBoundary();
+    }
+    return fb;
+}
+
+}  // namespace
+
+bool begin() {
+#if PXLCAM_CAMERA_SERVICE
+    if (g_task) {
+        return true;
+    }
+    if (xTaskCreatePinnedToCore(serviceTask, "cam_service", PXLCAM_CAMERA_SERVICE_STACK, nullptr,
+                                PXLCAM_CAMERA_SERVICE_PRIORITY, &g_task,
+                                PXLCAM_CAMERA_SERVICE_CORE) != pdPASS) {
+        g_task = nullptr;
+        PXLCAM_LOGW_TAG(kLogTag, "Camera service task failed, consumers read the driver");
+        return false;
+    }
+    PXLCAM_LOGI_TAG(kLogTag, "Camera service on core %d", PXLCAM_CAMERA_SERVICE_CORE);
+    return true;
+#else
+    return false;
+#endif
+}
+
+ConsumerId registerConsumer(const char* name, Need need, uint8_t everyN) {
+    // Semaphores are kept for the next consumer in a slot. One made here
+    // for a slot that has them by the time it is claimed goes back
+    SemaphoreHandle_t ready = nullptr;
+    SemaphoreHandle_t owner = nullptr;
+    ConsumerId claimed = kNoConsumer;
+    for (ConsumerId id = 0; id < PXLCAM_FRAME_CONSUMERS && claimed == kNoConsumer; id++) {
+        Consumer& c = g_consumers[id];
+        portENTER_CRITICAL(&g_lock);
+        const bool used = c.used;
+        const bool equipped = c.ready && c.owner;
+        portEXIT_CRITICAL(&g_lock);
+        if (used) {
+            continue;
+        }
+        if (!equipped) {
+            if (!ready) {
+                ready = xSemaphoreCreateBinary();
+            }
+            if (!owner) {
+                owner = xSemaphoreCreateMutex();
+            }
+            if (!ready || !owner) {
+                break;
+            }
+        }
+
+        // Another task may have claimed it since
+        portENTER_CRITICAL(&g_lock);
+        if (c.used) {
+            portEXIT_CRITICAL(&g_lock);
+            continue;
+        }
+        if (!c.ready) {
+            c.ready = ready;
+            ready = nullptr;
+        }
+        if (!c.owner) {
+            c.owner = owner;
+            owner = nullptr;
+        }
+        c.name = name;
+        c.need = need;
+        c.everyN = everyN > 0 ? everyN : 1;
+        c.skipped = 0;
+        c.waiting = false;
+        c.failed = false;
+        c.delivered = nullptr;
+        c.lastSeq = 0;
+        c.frames = c.shared = c.timeouts = c.lastWaitUs = c.maxWaitUs = 0;
+        c.used = true;
+        g_stats.consumers++;
+        portEXIT_CRITICAL(&g_lock);
+        claimed = id;
+    }
+    if (ready) {
+        vSemaphoreDelete(ready);
+    }
+    if (owner) {
+        vSemaphoreDelete(owner);
+    }
+    if (claimed == kNoConsumer) {
+        PXLCAM_LOGE_TAG(kLogTag, "No consumer slot for %s", name);
+    }
+    return claimed;
+}
+
+void unregisterConsumer(ConsumerId id) {
+    if (id < 0 || id >= PXLCAM_FRAME_CONSUMERS) {
+        return;
+    }
+    portENTER_CRITICAL(&g_lock);
+    if (g_consumers[id].used) {
+        g_consumers[id].used = false;
+        g_stats.consumers--;
+    }
+    portEXIT_CRITICAL(&g_lock);
+}
+
+void pause() {
+    if (!g_task || xTaskGetCurrentTaskHandle() == g_task) {
+        return;     // Nothing to stop, or the service's own mode switch
+    }
+    portENTER_CRITICAL(&g_lock);
+    g_pauses++;
+    portEXIT_CRITICAL(&g_lock);
+    // The round of readouts under way ends within a frame (or a mode switch)
+    for (;;) {
+        portENTER_CRITICAL(&g_lock);
+        const bool reading = g_reading;
+        portEXIT_CRITICAL(&g_lock);
+        if (!reading) {
+            break;
+        }
+        vTaskDelay(1);
+    }
+}
+
+void resume() {
+    if (!g_task || xTaskGetCurrentTaskHandle() == g_task) {
+        return;
+    }
+    portENTER_CRITICAL(&g_lock);
+    const bool last = g_pauses > 0 && --g_pauses == 0;
+    portEXIT_CRITICAL(&g_lock);
+    if (last) {
+        xTaskNotifyGive(g_task);   // Consumers that waited through it
+    }
+}
+
+camera_fb_t* acquire(ConsumerId id, uint32_t timeoutMs) {
+    if (!g_task || !valid(id)) {
+        return readDirect();
+    }
+    Consumer& c = g_consumers[id];
+    xSemaphoreTake(c.owner, portMAX_DELAY);
+    xSemaphoreTake(c.ready, 0);     // A delivery that came after the last timeout
+
+    // A frame just read for someone else, while they still hold it
+    const int64_t now = esp_timer_get_time();
+    Slot* slot = nullptr;
+    portENTER_CRITICAL(&g_lock);
+    if (c.need == Need::Latest && g_newest && !g_newest->switched && g_newest->seq != c.lastSeq &&
+        now - g_newest->readUs <= static_cast<int64_t>(PXLCAM_FRAME_SHARE_MS) * 1000) {
+        slot = g_newest;
+        slot->refs++;
+        c.lastSeq = slot->seq;
+        c.frames++;
+        c.shared++;
+        g_stats.deliveries++;
+        g_stats.shared++;
+    } else {
+        c.delivered = nullptr;
+        c.failed = false;
+        c.waiting = true;
+        c.waitStartUs = now;
+    }
+    portEXIT_CRITICAL(&g_lock);
+
+    if (!slot) {
+        xTaskNotifyGive(g_task);
+        xSemaphoreTake(c.ready, pdMS_TO_TICKS(timeoutMs));
+        portENTER_CRITICAL(&g_lock);
+        slot = c.delivered;     // Taken under the lock: a late delivery is still ours
+        c.delivered = nullptr;
+        c.waiting = false;
+        const uint32_t waitUs = static_cast<uint32_t>(esp_timer_get_time() - c.waitStartUs);
+        c.lastWaitUs = waitUs;
+        c.maxWaitUs = waitUs > c.maxWaitUs ? waitUs : c.maxWaitUs;
+        if (!slot && !c.failed) {
+            c.timeouts++;
+        }
+        portEXIT_CRITICAL(&g_lock);
+    }
+    xSemaphoreGive(c.owner);
+    return slot ? slot->fb : nullptr;
+}
+
+void release(camera_fb_t* fb) {
+    if (!fb) {
+        return;
+    }
+    bool found = false;
+    bool last = false;
+    portENTER_CRITICAL(&g_lock);
+    for (Slot& slot : g_slots) {
+        if (slot.fb == fb && slot.refs > 0) {
+            found = true;
+            last = dropRef(slot);
+            if (last) {
+                slot.fb = nullptr;
+            }
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&g_lock);
+    // Not the service's: read directly by acquire()
+    if (last || !found) {
+        esp_camera_fb_return(fb);
+    }
+}
+
+Stats getStats() {
+    portENTER_CRITICAL(&g_lock);
+    const Stats stats = g_stats;
+    portEXIT_CRITICAL(&g_lock);
+    return stats;
+}
+
+void logReport() {
+    const Stats stats = getStats();
+    PXLCAM_LOGI_TAG(kLogTag, "%lu reads, %lu deliveries (%lu shared), %lu unused, %lu failed, %u held",
+                    static_cast<unsigned long>(stats.reads), static_cast<unsigned long>(stats.deliveries),
+                    static_cast<unsigned long>(stats.shared), static_cast<unsigned long>(stats.unused),
+                    static_cast<unsigned long>(stats.failures), stats.held);
+    static const char* const kNeeds[] = {"latest", "every-n", "next-full"};
+    for (const Consumer& c : g_consumers) {
+        if (!c.used) {
+            continue;
+        }
+        PXLCAM_LOGI_TAG(kLogTag, "  %-12s %-9s %6lu frames %6lu shared %4lu timeouts, wait %lu us (max %lu)",
+                        c.name, kNeeds[static_cast<uint8_t>(c.need)], static_cast<unsigned long>(c.frames),
+                        static_cast<unsigned long>(c.shared), static_cast<unsigned long>(c.timeouts),
+                        static_cast<unsigned long>(c.lastWaitUs), static_cast<unsigned long>(c.maxWaitUs));
+    }
+}
+
+}  // namespace pxlcam::frames
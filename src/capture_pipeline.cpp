@@ -9,23 +9,49 @@
  * 
  * Output: 8-bit grayscale BMP for easy viewing
  * 
+ * Gray rows pass through the postprocess chain (filters/postprocess.h)
+ * on their way to the stylize, when one is configured.
+ * 
  * v1.3.0 TODOs:
  * - Integrate new palette system from filters/palette.h
  * - Use dither_pipeline for algorithm selection
- * - Add postprocess chain integration
  */
 
 #include "capture_pipeline.h"
+#include "camera_config.h"
+#include "camera_service.h"
+#include "jpeg_luma.h"
+#include "luma_extract.h"
 #include "mode_manager.h"
+#include "pixel_filter.h"
+#include "png_indexed_writer.h"
+#include "storage.h"
+#include "swar.h"
+#include "thumbnail_index.h"
+#include "preview_dither.h"
+#include "filters/postprocess.h"
+#include "filters/resample.h"
+#include "frame_arena.h"
+#include "frame_stack.h"
 #include "logging.h"
+#include "mem_placement.h"
 #include "pxlcam_config.h"
 
 #include <Arduino.h>
 #include <esp_camera.h>
 #include <esp_heap_caps.h>
-#include <img_converters.h>
+#include <esp_timer.h>
 #include <cstring>
+#include <cstdlib>
 #include <cmath>
+#include <new>
+
+#if PXLCAM_CAPTURE_PIPELINED || PXLCAM_CAPTURE_ZSL || PXLCAM_CAPTURE_BURST
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#endif
 
 // =============================================================================
 // v1.3.0 Filter Pipeline Includes
@@ -34,7 +60,10 @@
 #if PXLCAM_FEATURE_STYLIZED_CAPTURE
 #include "filters/palette.h"
 #include "filters/dither_pipeline.h"
-// #include "filters/postprocess.h"  // TODO v1.3.1
+#endif
+
+#ifdef PXL_V13_EXPERIMENTAL
+#include "palettes/palette_manager.h"
 #endif
 
 namespace pxlcam::capture {
@@ -50,7 +79,6 @@ constexpr const char* kLogTag = "capture";
 bool g_initialized = false;
 camera_fb_t* g_activeFrame = nullptr;
 uint8_t* g_processedBuffer = nullptr;
-uint8_t* g_tempRgbBuffer = nullptr;
 size_t g_allocatedSize = 0;
 
 // Metrics
@@ -61,15 +89,18 @@ uint32_t g_lastProcessDuration = 0;
 constexpr int kMaxWidth = 320;
 constexpr int kMaxHeight = 240;
 constexpr size_t kMaxPixels = kMaxWidth * kMaxHeight;
-constexpr size_t kMaxRgbSize = kMaxPixels * 3;
-constexpr size_t kMaxBmpSize = 54 + 1024 + kMaxPixels;  // Header + palette + pixels
+constexpr size_t kMaxBmpSize = 54 + 1024 + kMaxPixels   // Header + palette + pixels
+                               + kMaxHeight * 8 + 2;  // RLE staging slack (see makeLayout())
+/// Output buffers keep the capture's thumbnail right after the largest file
+constexpr size_t kOutputSlotSize = kMaxBmpSize + pxlcam::thumbs::kThumbBytes;
 
 //==============================================================================
 // Bayer 8x8 Dithering Matrix
 //==============================================================================
 
 // Classic Bayer 8x8 ordered dithering matrix (normalized 0-63)
-const uint8_t kBayer8x8[8][8] = {
+// Read per pixel by stylizeSpan(): DRAM, not flash rodata
+const uint8_t PXLCAM_HOT_DATA kBayer8x8[8][8] = {
     {  0, 32,  8, 40,  2, 34, 10, 42 },
     { 48, 16, 56, 24, 50, 18, 58, 26 },
     { 12, 44,  4, 36, 14, 46,  6, 38 },
@@ -81,7 +112,7 @@ const uint8_t kBayer8x8[8][8] = {
 };
 
 // GameBoy 4-tone palette (dark→light)
-const uint8_t kGameBoyPalette[4] = { 0x0F, 0x56, 0x9B, 0xCF };
+const uint8_t PXLCAM_HOT_DATA kGameBoyPalette[4] = { 0x0F, 0x56, 0x9B, 0xCF };
 
 //==============================================================================
 // Gamma LUT for Night Mode
@@ -104,7 +135,8 @@ void buildGammaLut(float gamma) {
 // Memory Allocation (PSRAM Priority)
 //==============================================================================
 
-uint8_t* allocatePsram(size_t size, const char* name) {
+/// PSRAM heap, else the internal heap
+uint8_t* allocateHeap(size_t size, const char* name) {
     uint8_t* ptr = static_cast<uint8_t*>(
         heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
     
@@ -122,9 +154,19 @@ uint8_t* allocatePsram(size_t size, const char* name) {
     return ptr;
 }
 
+/// Held for good: from the frame arena, else the heap
+uint8_t* allocatePsram(size_t size, const char* name) {
+    if (void* resident = pxlcam::arena::reserve(size, name)) {
+        return static_cast<uint8_t*>(resident);
+    }
+    return allocateHeap(size, name);
+}
+
 void freePsram(uint8_t** ptr) {
     if (*ptr) {
-        heap_caps_free(*ptr);
+        if (!pxlcam::arena::owns(*ptr)) {
+            heap_caps_free(*ptr);
+        }
         *ptr = nullptr;
     }
 }
@@ -142,38 +184,120 @@ void rgbToGrayscale(const uint8_t* rgb, uint8_t* gray, int w, int h) {
     }
 }
 
+//==============================================================================
+// Stylize Kernels (span granularity, usable on rows or decoder blocks)
+//==============================================================================
+
+/// Night LUT: gamma boost followed by contrast enhancement
+uint8_t g_nightLut[256];
+bool g_nightLutReady = false;
+
+void buildNightLut() {
+    // Build gamma LUT if needed (gamma < 1 = brighten)
+    if (!g_gammaLutReady) {
+        buildGammaLut(0.6f);  // Night boost
+    }
+    
+    const float contrast = 1.4f;
+    const int mid = 128;
+    
+    for (int i = 0; i < 256; i++) {
+        int val = static_cast<int>((g_gammaLut[i] - mid) * contrast + mid);
+        g_nightLut[i] = (val < 0) ? 0 : ((val > 255) ? 255 : val);
+    }
+    g_nightLutReady = true;
+}
+
+/// GameBoy tone index (0-3, dark→light) for one pixel (Bayer 8x8 threshold)
+inline uint8_t gameBoyIndex(uint8_t pixel, uint8_t bayer) {
+    // Bayer threshold (0-63) scaled to 0-255, centered on zero
+    int adjusted = pixel + (bayer * 4 - 128);
+    adjusted = (adjusted < 0) ? 0 : ((adjusted > 255) ? 255 : adjusted);
+    
+    // 4 equal bands
+    return adjusted >> 6;
+}
+
+/// GameBoy tone for one pixel
+inline uint8_t gameBoyTone(uint8_t pixel, uint8_t bayer) {
+    return kGameBoyPalette[gameBoyIndex(pixel, bayer)];
+}
+
+/// Bayer offsets (bayer * 4 - 128) per row, cells 0-3 and 4-7, as SWAR words
+pxlcam::swar::OffsetWord g_gameBoyWords[8][2];
+bool g_gameBoyWordsReady = false;
+
+void buildGameBoyWords() {
+    for (int y = 0; y < 8; y++) {
+        int16_t offsets[8];
+        for (int x = 0; x < 8; x++) {
+            offsets[x] = static_cast<int16_t>(kBayer8x8[y][x] * 4 - 128);
+        }
+        g_gameBoyWords[y][0] = pxlcam::swar::makeOffsetWord(&offsets[0]);
+        g_gameBoyWords[y][1] = pxlcam::swar::makeOffsetWord(&offsets[4]);
+    }
+    g_gameBoyWordsReady = true;
+}
+
+/// GameBoy tone indices of 4 pixels at x (x % 4 == 0), one per byte
+inline uint32_t gameBoyIndex4(uint32_t pixels, int x, int y) {
+    const uint32_t adjusted = pxlcam::swar::applyOffset(pixels, g_gameBoyWords[y & 7][(x >> 2) & 1]);
+    return (adjusted >> 6) & pxlcam::swar::kLow2Bits;
+}
+
+/// Number of leading pixels of a span that can take the 4-pixel path
+/// Needs a word-aligned source and a span starting on a 4-pixel boundary
+/// (Bayer phase and packed output bytes line up); 0 otherwise.
+inline int wordSpan(const uint8_t* src, int x0, int n) {
+    return (pxlcam::swar::aligned4(src) && (x0 & 3) == 0) ? (n & ~3) : 0;
+}
+
+/// Stylize a horizontal span of n pixels starting at (x0, y)
+/// src and dst may alias (in-place). Runs from IRAM (PXLCAM_HOT_CODE).
+PXLCAM_HOT_CODE void stylizeSpan(const uint8_t* src, uint8_t* dst, int x0, int y, int n,
+                 pxlcam::mode::CaptureMode mode) {
+    switch (mode) {
+        case pxlcam::mode::CaptureMode::GameBoy: {
+            int i = pxlcam::swar::aligned4(dst) ? wordSpan(src, x0, n) : 0;
+            const int words = i;
+            for (int k = 0; k < words; k += 4) {
+                const uint32_t idx = gameBoyIndex4(pxlcam::swar::load4(src + k), x0 + k, y);
+                pxlcam::swar::store4(dst + k, pxlcam::swar::lookup4(idx, kGameBoyPalette));
+            }
+            const uint8_t* bayerRow = kBayer8x8[y & 7];
+            for (; i < n; i++) {
+                dst[i] = gameBoyTone(src[i], bayerRow[(x0 + i) & 7]);
+            }
+            break;
+        }
+        
+        case pxlcam::mode::CaptureMode::Night:
+            for (int i = 0; i < n; i++) {
+                dst[i] = g_nightLut[src[i]];
+            }
+            break;
+            
+        case pxlcam::mode::CaptureMode::Normal:
+        default:
+            if (dst != src) {
+                memcpy(dst, src, n);
+            }
+            break;
+    }
+}
+
 //==============================================================================
 // GameBoy Dithering (Bayer 8x8, 4 tons)
 //==============================================================================
 
 void applyGameBoyDither(uint8_t* gray, int w, int h) {
+    if (!g_gameBoyWordsReady) {
+        buildGameBoyWords();
+    }
+    
     for (int y = 0; y < h; y++) {
-        for (int x = 0; x < w; x++) {
-            const int idx = y * w + x;
-            const uint8_t pixel = gray[idx];
-            
-            // Get Bayer threshold (0-63) and scale to 0-255
-            const uint8_t threshold = kBayer8x8[y & 7][x & 7] * 4;
-            
-            // Determine which of 4 tones based on pixel + dither threshold
-            // Divide into 4 bands with dither offset
-            int adjusted = pixel + (threshold - 128);
-            adjusted = (adjusted < 0) ? 0 : ((adjusted > 255) ? 255 : adjusted);
-            
-            // Map to 4 tones
-            uint8_t tone;
-            if (adjusted < 64) {
-                tone = kGameBoyPalette[0];       // Darkest
-            } else if (adjusted < 128) {
-                tone = kGameBoyPalette[1];
-            } else if (adjusted < 192) {
-                tone = kGameBoyPalette[2];
-            } else {
-                tone = kGameBoyPalette[3];       // Lightest
-            }
-            
-            gray[idx] = tone;
-        }
+        uint8_t* row = gray + y * w;
+        stylizeSpan(row, row, 0, y, w, pxlcam::mode::CaptureMode::GameBoy);
     }
 }
 
@@ -182,27 +306,12 @@ void applyGameBoyDither(uint8_t* gray, int w, int h) {
 //==============================================================================
 
 void applyNightEnhance(uint8_t* gray, int w, int h) {
-    const size_t pixels = w * h;
-    
-    // Build gamma LUT if needed (gamma < 1 = brighten)
-    if (!g_gammaLutReady) {
-        buildGammaLut(0.6f);  // Night boost
+    if (!g_nightLutReady) {
+        buildNightLut();
     }
     
-    // Apply gamma + contrast
-    const float contrast = 1.4f;
-    const int mid = 128;
-    
-    for (size_t i = 0; i < pixels; i++) {
-        // Gamma correction
-        int val = g_gammaLut[gray[i]];
-        
-        // Contrast enhancement
-        val = static_cast<int>((val - mid) * contrast + mid);
-        val = (val < 0) ? 0 : ((val > 255) ? 255 : val);
-        
-        gray[i] = static_cast<uint8_t>(val);
-    }
+    // Gamma + contrast folded into one LUT
+    stylizeSpan(gray, gray, 0, 0, w * h, pxlcam::mode::CaptureMode::Night);
 }
 
 //==============================================================================
@@ -224,7 +333,7 @@ struct BmpInfoHeader {
     int32_t  height;        // Negative = top-down
     uint16_t planes;        // 1
     uint16_t bitCount;      // 8 for grayscale
-    uint32_t compression;   // 0 = none
+    uint32_t compression;   // 0 = none, 1 = RLE8, 2 = RLE4
     uint32_t sizeImage;
     int32_t  xPelsPerMeter;
     int32_t  yPelsPerMeter;
@@ -233,113 +342,2617 @@ struct BmpInfoHeader {
 };
 #pragma pack(pop)
 
+constexpr size_t kBmpHeaderSize = sizeof(BmpFileHeader) + sizeof(BmpInfoHeader);
+constexpr size_t kBmpPaletteSize = 256 * 4;  // RGBX for each grayscale level
+constexpr size_t kBmpPixelOffset = kBmpHeaderSize + kBmpPaletteSize;
+
+/// BMP rows must be 4-byte aligned
+inline int bmpRowStride(int w) {
+    return (w + 3) & ~3;
+}
+
+constexpr uint32_t kBiRle8 = 1;
+constexpr uint32_t kBiRle4 = 2;
+
+/// Fill file + info headers for a palettized BMP
+/// Uncompressed rows are top-down; RLE bitmaps must be bottom-up.
+void fillBmpHeaders(uint8_t* outBmp, int w, int h, uint16_t bitCount, uint32_t colors,
+                    size_t pixelOffset, size_t pixelSize, uint32_t compression = 0) {
+    // File header
+    BmpFileHeader* fileHdr = reinterpret_cast<BmpFileHeader*>(outBmp);
+    fileHdr->type = 0x4D42;  // "BM"
+    fileHdr->size = pixelOffset + pixelSize;
+    fileHdr->reserved1 = 0;
+    fileHdr->reserved2 = 0;
+    fileHdr->offBits = pixelOffset;
+    
+    // Info header
+    BmpInfoHeader* infoHdr = reinterpret_cast<BmpInfoHeader*>(outBmp + sizeof(BmpFileHeader));
+    infoHdr->size = sizeof(BmpInfoHeader);
+    infoHdr->width = w;
+    infoHdr->height = compression ? h : -h;  // Negative = top-down (no flip needed)
+    infoHdr->planes = 1;
+    infoHdr->bitCount = bitCount;
+    infoHdr->compression = compression;
+    infoHdr->sizeImage = pixelSize;
+    infoHdr->xPelsPerMeter = 2835;  // 72 DPI
+    infoHdr->yPelsPerMeter = 2835;
+    infoHdr->clrUsed = colors;
+    infoHdr->clrImportant = colors;
+}
+
+/// Write headers + grayscale palette; pixel rows start at kBmpPixelOffset
+/// @return Total BMP file size (uncompressed)
+size_t writeBmpHeader(uint8_t* outBmp, int w, int h, uint32_t compression = 0) {
+    const size_t pixelSize = static_cast<size_t>(bmpRowStride(w)) * h;
+    fillBmpHeaders(outBmp, w, h, 8, 256, kBmpPixelOffset, pixelSize, compression);
+    
+    // Grayscale palette (256 entries)
+    uint8_t* palette = outBmp + kBmpHeaderSize;
+    for (int i = 0; i < 256; i++) {
+        palette[i * 4 + 0] = i;  // Blue
+        palette[i * 4 + 1] = i;  // Green
+        palette[i * 4 + 2] = i;  // Red
+        palette[i * 4 + 3] = 0;  // Reserved
+    }
+    
+    return kBmpPixelOffset + pixelSize;
+}
+
+/// Clear the alignment bytes at the end of each BMP row
+void clearBmpPadding(uint8_t* pixels, int w, int h) {
+    const int stride = bmpRowStride(w);
+    const int padding = stride - w;
+    if (padding == 0) return;
+    
+    for (int y = 0; y < h; y++) {
+        memset(pixels + y * stride + w, 0, padding);
+    }
+}
+
 bool encodeBmpGrayscale(const uint8_t* gray, int w, int h, 
                          uint8_t* outBmp, size_t& outLength) {
-    // Calculate row padding (BMP rows must be 4-byte aligned)
-    const int rowBytes = w;
-    const int padding = (4 - (rowBytes % 4)) % 4;
-    const int paddedRow = rowBytes + padding;
+    outLength = writeBmpHeader(outBmp, w, h);
+    
+    // Pixel data (with padding)
+    const int stride = bmpRowStride(w);
+    uint8_t* pixels = outBmp + kBmpPixelOffset;
+    for (int y = 0; y < h; y++) {
+        memcpy(pixels + y * stride, gray + y * w, w);
+    }
+    clearBmpPadding(pixels, w, h);
+    
+    return true;
+}
+
+//==============================================================================
+// Indexed Output (4bpp BMP / 2bpp PXL)
+//==============================================================================
+
+#pragma pack(push, 1)
+struct PxlFileHeader {
+    char     magic[4];      // "PXL2"
+    uint16_t width;
+    uint16_t height;
+    uint8_t  bitsPerPixel;  // 2
+    uint8_t  toneCount;     // 4
+    uint8_t  tones[4];      // Gray level per index (dark→light)
+    uint16_t reserved;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(PxlFileHeader) == 16, "PXL header must be 16 bytes");
+
+constexpr int kIndexedTones = 4;
+constexpr size_t kBmp4PixelOffset = kBmpHeaderSize + kIndexedTones * 4;
+
+/// Byte layout of one output file
+/// RLE layouts stage uncompressed rows bottom-up at pixelOffset and pack
+/// each finished row's RLE code downwards from rleTop (see completeRows()).
+struct OutputLayout {
+    OutputFormat format;
+    int width;
+    int height;
+    int stride;             ///< Bytes per pixel row
+    size_t pixelOffset;     ///< First pixel row
+    size_t totalSize;       ///< File size (upper bound when RLE)
+    bool rle;               ///< BI_RLE8 (Bmp8) or BI_RLE4 (Bmp4)
+    size_t rleTop;          ///< End of the compressed rows while encoding
+};
+
+OutputFormat g_outputFormat = static_cast<OutputFormat>(PXLCAM_CAPTURE_OUTPUT_FORMAT);
+
+/// Color tables with the palette manager's colors (palettes::isColorOutput())
+inline bool colorOutput() {
+#ifdef PXL_V13_EXPERIMENTAL
+    return pxlcam::palettes::isColorOutput();
+#else
+    return false;
+#endif
+}
+
+/// Only GameBoy yields 4 tones; other modes keep full 8-bit grayscale
+/// Color GameBoy captures need a color table, so Bmp8 becomes Bmp4.
+OutputFormat resolveFormat(OutputFormat requested, pxlcam::mode::CaptureMode mode) {
+    if (requested != OutputFormat::Bmp8 && mode != pxlcam::mode::CaptureMode::GameBoy) {
+        return OutputFormat::Bmp8;
+    }
+    if (requested == OutputFormat::Bmp8 && mode == pxlcam::mode::CaptureMode::GameBoy && colorOutput()) {
+        return OutputFormat::Bmp4;
+    }
+    return requested;
+}
+
+/// Worst-case RLE8 row: 254-pixel absolute runs, word padding and end of line
+constexpr size_t rle8RowBound(int w) {
+    return w + 2 * ((w + 253) / 254) + 1 + 2;
+}
+
+/// Worst-case RLE4 row: 252-pixel absolute runs, word padding and end of line
+constexpr size_t rle4RowBound(int w) {
+    return (w + 1) / 2 + 2 * ((w + 251) / 252) + 1 + 2;
+}
+
+constexpr size_t kRleRowMax = rle8RowBound(kMaxWidth);
+
+static_assert(rle8RowBound(kMaxWidth) <= 8 + ((kMaxWidth + 3) & ~3) &&
+              rle4RowBound(kMaxWidth) <= 8 + (((kMaxWidth + 1) / 2 + 3) & ~3),
+              "kMaxBmpSize RLE slack too small for kMaxWidth");
+
+/// RLE is for dithered 4-tone frames: long flat runs, period-2 patterns
+bool rleFor(OutputFormat format, pxlcam::mode::CaptureMode mode) {
+#if PXLCAM_CAPTURE_BMP_RLE
+    return (format == OutputFormat::Bmp8 || format == OutputFormat::Bmp4) &&
+           mode == pxlcam::mode::CaptureMode::GameBoy;
+#else
+    (void)format;
+    (void)mode;
+    return false;
+#endif
+}
+
+/// @param rle Compress BMP rows (rleFor()); strip capture streams rows uncompressed
+/// Png2 totalSize is an upper bound; the file size comes from the PNG writer.
+OutputLayout makeLayout(OutputFormat format, int w, int h, bool rle = false) {
+    OutputLayout layout = { format, w, h, 0, 0, 0, false, 0 };
+    
+    switch (format) {
+        case OutputFormat::Bmp4:
+            layout.stride = (((w + 1) / 2) + 3) & ~3;  // 2 px/byte, 4-byte rows
+            layout.pixelOffset = kBmp4PixelOffset;
+            break;
+        case OutputFormat::Pxl2:
+            layout.stride = (w + 3) / 4;                // 4 px/byte, byte rows
+            layout.pixelOffset = sizeof(PxlFileHeader);
+            break;
+        case OutputFormat::Png2:
+            // Rows are staged at the end of the worst-case file and deflated
+            // from offset 0 as they finish; the code never catches up with them
+            layout.stride = (w + 3) / 4;
+            layout.totalSize = pxlcam::png::IndexedPngWriter::maxSize(w, h, 2);
+            layout.pixelOffset = layout.totalSize - static_cast<size_t>(layout.stride) * h;
+            return layout;
+        case OutputFormat::Bmp8:
+        default:
+            layout.stride = bmpRowStride(w);
+            layout.pixelOffset = kBmpPixelOffset;
+            break;
+    }
+    
+    layout.totalSize = layout.pixelOffset + static_cast<size_t>(layout.stride) * h;
+    
+    if (rle && (format == OutputFormat::Bmp8 || format == OutputFormat::Bmp4)) {
+        // Row y's code can end up to y·(bound - stride) bytes above where an
+        // uncompressed row would sit; that slack keeps unencoded rows intact
+        const size_t bound = format == OutputFormat::Bmp8 ? rle8RowBound(w) : rle4RowBound(w);
+        const size_t growth = bound > static_cast<size_t>(layout.stride) ? bound - layout.stride : 0;
+        layout.rle = true;
+        layout.rleTop = layout.totalSize + growth * h;
+        layout.totalSize = layout.pixelOffset + bound * h + 2;
+    }
+    return layout;
+}
+
+/// Layout of a whole-frame output for a capture mode
+OutputLayout frameLayout(OutputFormat requested, pxlcam::mode::CaptureMode mode, int w, int h) {
+    const OutputFormat format = resolveFormat(requested, mode);
+    return makeLayout(format, w, h, rleFor(format, mode));
+}
+
+/// Gray level (and color) for each tone index in indexed files
+/// With color output the tones are the lumas of the colors, so grayscale
+/// views of the indices (PXL2 header, OLED thumbnail) match the file.
+/// @param rgb R, G, B per index (may be nullptr)
+void currentTones(uint8_t tones[kIndexedTones], uint8_t* rgb = nullptr) {
+    memcpy(tones, kGameBoyPalette, kIndexedTones);
+#if PXLCAM_FEATURE_STYLIZED_CAPTURE
+    if (pxlcam::filters::palette_is_initialized()) {
+        memcpy(tones, pxlcam::filters::palette_current().tones, kIndexedTones);
+    }
+#endif
+    
+#ifdef PXL_V13_EXPERIMENTAL
+    uint8_t colors[kIndexedTones * 3];
+    pxlcam::palettes::indexColors(tones, rgb ? rgb : colors);
+#else
+    for (int i = 0; rgb && i < kIndexedTones; i++) {
+        rgb[i * 3 + 0] = rgb[i * 3 + 1] = rgb[i * 3 + 2] = tones[i];
+    }
+#endif
+}
+
+/// Write the header for any output format (layout.pixelOffset bytes)
+/// PNG headers come from the PNG writer (beginPacking()).
+void writeOutputHeader(uint8_t* out, const OutputLayout& layout) {
+    if (layout.format == OutputFormat::Png2) {
+        return;
+    }
+    if (layout.format == OutputFormat::Bmp8) {
+        writeBmpHeader(out, layout.width, layout.height, layout.rle ? kBiRle8 : 0);
+        return;
+    }
+    
+    uint8_t tones[kIndexedTones];
+    uint8_t rgb[kIndexedTones * 3];
+    currentTones(tones, rgb);
+    
+    if (layout.format == OutputFormat::Bmp4) {
+        fillBmpHeaders(out, layout.width, layout.height, 4, kIndexedTones,
+                       layout.pixelOffset, layout.totalSize - layout.pixelOffset,
+                       layout.rle ? kBiRle4 : 0);
+        uint8_t* palette = out + kBmpHeaderSize;
+        for (int i = 0; i < kIndexedTones; i++) {
+            palette[i * 4 + 0] = rgb[i * 3 + 2];  // Blue
+            palette[i * 4 + 1] = rgb[i * 3 + 1];  // Green
+            palette[i * 4 + 2] = rgb[i * 3 + 0];  // Red
+            palette[i * 4 + 3] = 0;               // Reserved
+        }
+    } else {
+        PxlFileHeader* hdr = reinterpret_cast<PxlFileHeader*>(out);
+        memcpy(hdr->magic, "PXL2", 4);
+        hdr->width = layout.width;
+        hdr->height = layout.height;
+        hdr->bitsPerPixel = 2;
+        hdr->toneCount = kIndexedTones;
+        memcpy(hdr->tones, tones, kIndexedTones);
+        hdr->reserved = 0;
+    }
+}
+
+/// Indexed rows are OR-packed, so they must start zeroed
+void prepareOutputRows(const OutputLayout& layout, uint8_t* rows, int count) {
+    if (layout.format != OutputFormat::Bmp8) {
+        memset(rows, 0, static_cast<size_t>(layout.stride) * count);
+    }
+}
+
+/// Reset stats before a frame's first span
+void beginStats(FrameStats& stats) {
+    stats = {};
+    stats.minLuma = 255;
+}
+
+/// Fold n source luma samples into the frame statistics
+/// Runs on the span the stylize kernel is about to read, while it is hot.
+inline void accumulateStats(FrameStats& stats, const uint8_t* gray, int n) {
+    uint8_t lo = stats.minLuma;
+    uint8_t hi = stats.maxLuma;
+    uint32_t sum = 0;
+    uint32_t low = 0;
+    uint32_t high = 0;
+    
+    for (int i = 0; i < n; i++) {
+        const uint8_t v = gray[i];
+        stats.histogram[v >> 4]++;
+        sum += v;
+        low += (v == 0);
+        high += (v == 255);
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    
+    stats.minLuma = lo;
+    stats.maxLuma = hi;
+    stats.lumaSum += sum;
+    stats.clippedLow += low;
+    stats.clippedHigh += high;
+    stats.pixels += n;
+}
+
+void finishStats(FrameStats& stats) {
+    if (stats.pixels == 0) {
+        stats.minLuma = 0;
+        return;
+    }
+    stats.meanLuma = static_cast<uint8_t>(stats.lumaSum / stats.pixels);
+}
+
+/// Stylize n gray pixels at (x0, y) into an output row
+/// y is the image row (dither phase); row is where that row is stored.
+/// For Bmp8, gray may alias the destination row (see spanScratch()).
+void stylizeInto(const OutputLayout& layout, uint8_t* row, const uint8_t* gray,
+                 int x0, int y, int n, pxlcam::mode::CaptureMode mode) {
+    if (layout.format == OutputFormat::Bmp8) {
+        stylizeSpan(gray, row + x0, x0, y, n, mode);
+        return;
+    }
+    
+    // Indexed formats are GameBoy only (see resolveFormat()); aligned groups
+    // of 4 pixels fill whole output bytes, the rest is OR'ed in per pixel
+    const uint8_t* bayerRow = kBayer8x8[y & 7];
+    const int words = wordSpan(gray, x0, n);
+    if (layout.format == OutputFormat::Bmp4) {
+        for (int i = 0; i < words; i += 4) {
+            const int x = x0 + i;
+            pxlcam::swar::packNibbles(gameBoyIndex4(pxlcam::swar::load4(gray + i), x, y), row + (x >> 1));
+        }
+        for (int i = words; i < n; i++) {
+            const int x = x0 + i;
+            const uint8_t idx = gameBoyIndex(gray[i], bayerRow[x & 7]);
+            row[x >> 1] |= idx << ((x & 1) ? 0 : 4);        // High nibble first
+        }
+    } else {
+        for (int i = 0; i < words; i += 4) {
+            const int x = x0 + i;
+            row[x >> 2] = pxlcam::swar::packPairs(gameBoyIndex4(pxlcam::swar::load4(gray + i), x, y));
+        }
+        for (int i = words; i < n; i++) {
+            const int x = x0 + i;
+            const uint8_t idx = gameBoyIndex(gray[i], bayerRow[x & 7]);
+            row[x >> 2] |= idx << (6 - 2 * (x & 3));        // MSB pair first
+        }
+    }
+}
+
+/// Stylize a span of source luma, folding it into the frame statistics
+void writeSpan(const OutputLayout& layout, uint8_t* row, const uint8_t* gray,
+               int x0, int y, int n, pxlcam::mode::CaptureMode mode, FrameStats& stats) {
+    accumulateStats(stats, gray, n);
+    stylizeInto(layout, row, gray, x0, y, n, mode);
+}
+
+/// Where to stage a converted gray row before writeSpan()
+/// Bmp8 converts straight into its destination row; indexed rows need scratch.
+inline uint8_t* spanScratch(const OutputLayout& layout, uint8_t* row, uint8_t* rowBuf) {
+    return layout.format == OutputFormat::Bmp8 ? row : rowBuf;
+}
+
+/// Where output row y is built: in place top-down, or in the bottom-up RLE staging rows
+inline uint8_t* outputRow(const OutputLayout& layout, uint8_t* out, int y) {
+    const int slot = layout.rle ? layout.height - 1 - y : y;
+    return out + layout.pixelOffset + static_cast<size_t>(slot) * layout.stride;
+}
+
+/// Layouts whose finished rows are compressed during the capture pass
+inline bool packsRows(const OutputLayout& layout) {
+    return layout.rle || layout.format == OutputFormat::Png2;
+}
+
+constexpr bool kThumbnails = PXLCAM_CAPTURE_THUMBNAILS != 0;
+
+/// Widest output row a thumbnail is taken from (strip captures included)
+constexpr int kThumbRowMax = PXLCAM_STRIP_MAX_WIDTH > kMaxWidth ? PXLCAM_STRIP_MAX_WIDTH : kMaxWidth;
+
+/// Thumbnail of one output: finished rows are turned back into the gray
+/// levels they show, area-downscaled as they complete, and the 64x64
+/// result is dithered to 1 bit once the last row is in
+struct ThumbBuilder {
+    pxlcam::filters::AreaResampler resampler;
+    uint8_t tones[kIndexedTones];
+    uint8_t gray[pxlcam::thumbs::kThumbWidth * pxlcam::thumbs::kThumbHeight];
+    uint8_t luma[kThumbRowMax];
+    uint8_t pages[pxlcam::thumbs::kThumbBytes];     ///< Strip captures (no output slot)
+};
+
+/// Rows finished so far (compressed for RLE and PNG layouts, and/or
+/// added to the thumbnail)
+struct RowPacker {
+    int nextRow;            ///< First row not yet completed
+    size_t start;           ///< RLE: lowest byte of the compressed rows
+    pxlcam::png::IndexedPngWriter* png;
+    uint8_t* out;           ///< PNG: file being written from offset 0
+    size_t length;          ///< PNG: bytes written
+    size_t capacity;
+    ThumbBuilder* thumb;    ///< Thumbnail being built (nullptr = none)
+    uint8_t* thumbnail;     ///< Its SSD1306 pages (thumbs::kThumbBytes)
+};
+
+pxlcam::png::IndexedPngWriter* g_pngWriter = nullptr;  ///< Calling-task captures
+ThumbBuilder* g_thumbBuilder = nullptr;                ///< Calling-task captures
+
+/// PNG writer state (~13 KB) is only allocated once PNG output is used
+bool acquirePngWriter(pxlcam::png::IndexedPngWriter*& writer, const char* name) {
+    if (!writer) {
+        uint8_t* mem = allocatePsram(sizeof(pxlcam::png::IndexedPngWriter), name);
+        if (mem) {
+            writer = new (mem) pxlcam::png::IndexedPngWriter();
+        }
+    }
+    return writer != nullptr;
+}
+
+/// Start the thumbnail of a w x h output
+/// Builder state (~7.5 KB) is allocated on the first capture that makes one.
+/// @return nullptr when thumbnails are off, the frame is smaller than the
+///         thumbnail or there is no memory (the capture goes on without one)
+ThumbBuilder* startThumbnail(ThumbBuilder*& builder, int width, int height, const char* name) {
+    if (!kThumbnails) {
+        return nullptr;
+    }
+    if (!builder) {
+        uint8_t* mem = allocatePsram(sizeof(ThumbBuilder), name);
+        if (mem) {
+            builder = new (mem) ThumbBuilder();
+        }
+    }
+    if (!builder || !builder->resampler.begin(width, height, pxlcam::filters::ResampleFormat::GRAY,
+                                              builder->gray, pxlcam::thumbs::kThumbWidth,
+                                              pxlcam::thumbs::kThumbHeight, pxlcam::thumbs::kThumbWidth)) {
+        return nullptr;
+    }
+    currentTones(builder->tones);
+    return builder;
+}
+
+/// Dither the downscaled frame into SSD1306 pages
+/// Blue noise keeps no state, so the caller and consumer tasks may both run it.
+bool finishThumbnail(ThumbBuilder& builder, uint8_t* pages) {
+    if (!builder.resampler.done()) {
+        return false;
+    }
+    pxlcam::dither::applyBlueNoiseDither(builder.gray, pxlcam::thumbs::kThumbWidth, pxlcam::thumbs::kThumbHeight,
+                                         pages, pxlcam::dither::BitmapLayout::Pages);
+    return true;
+}
+
+/// Thumbnail pages of an output slot (kOutputSlotSize): right after the file
+inline uint8_t* slotThumbnail(uint8_t* out) {
+    return out + kMaxBmpSize;
+}
+
+bool memorySink(void* user, const uint8_t* data, size_t len) {
+    RowPacker* packer = static_cast<RowPacker*>(user);
+    if (packer->length + len > packer->capacity) {
+        return false;
+    }
+    memcpy(packer->out + packer->length, data, len);
+    packer->length += len;
+    return true;
+}
+
+/// Start packing a frame into the output slot out; PNG writes its header here
+/// @param png Writer for this task (allocated on first use)
+/// @param thumb Thumbnail builder for this task (allocated on first use)
+/// @return false if the PNG writer could not be allocated or started
+bool beginPacking(const OutputLayout& layout, uint8_t* out, RowPacker& packer,
+                  pxlcam::png::IndexedPngWriter*& png, ThumbBuilder*& thumb) {
+    packer = { 0, layout.rleTop, nullptr, out, 0, layout.totalSize, nullptr, slotThumbnail(out) };
+    packer.thumb = startThumbnail(thumb, layout.width, layout.height, "ThumbBuilder");
+    if (layout.format != OutputFormat::Png2) {
+        return true;
+    }
+    if (!acquirePngWriter(png, "PngWriter")) {
+        return false;
+    }
+    
+    uint8_t tones[kIndexedTones];
+    uint8_t rgb[kIndexedTones * 3];
+    currentTones(tones, rgb);
+    packer.png = png;
+    return png->beginRgb(layout.width, layout.height, 2, rgb, kIndexedTones, memorySink, &packer);
+}
+
+/// Pixel x of a packed 4bpp row (high nibble first)
+inline uint8_t nibbleAt(const uint8_t* row, int x) {
+    return (row[x >> 1] >> ((x & 1) ? 0 : 4)) & 0x0F;
+}
+
+/// RLE8 or RLE4 pixel x
+inline uint8_t rlePixel(bool rle4, const uint8_t* row, int x) {
+    return rle4 ? nibbleAt(row, x) : row[x];
+}
+
+/// Pixels from x that repeat the encoded-mode pattern (one value for RLE8,
+/// two alternating values for RLE4), at most limit
+inline int rleRunLength(bool rle4, const uint8_t* row, int x, int w, int limit) {
+    const int end = x + limit < w ? x + limit : w;
+    const uint8_t a = rlePixel(rle4, row, x);
+    const uint8_t b = (rle4 && x + 1 < end) ? rlePixel(rle4, row, x + 1) : a;
+    int i = x + 1;
+    while (i < end && rlePixel(rle4, row, i) == (((i - x) & 1) ? b : a)) {
+        i++;
+    }
+    return i - x;
+}
+
+/// Encoded-mode pair: count pixels of value (RLE8) or of two alternating nibbles (RLE4)
+inline uint8_t* rleEncoded(bool rle4, uint8_t* dst, const uint8_t* row, int x, int count) {
+    *dst++ = static_cast<uint8_t>(count);
+    if (rle4) {
+        const uint8_t b = count > 1 ? nibbleAt(row, x + 1) : 0;
+        *dst++ = static_cast<uint8_t>((nibbleAt(row, x) << 4) | b);
+    } else {
+        *dst++ = row[x];
+    }
+    return dst;
+}
+
+/// Absolute-mode run of count >= 3 pixels, padded to a 16-bit boundary
+inline uint8_t* rleAbsolute(bool rle4, uint8_t* dst, const uint8_t* row, int x, int count) {
+    *dst++ = 0;
+    *dst++ = static_cast<uint8_t>(count);
+    size_t bytes = count;
+    if (rle4) {
+        bytes = (count + 1) / 2;
+        for (int i = 0; i < count; i += 2) {
+            const uint8_t b = i + 1 < count ? nibbleAt(row, x + i + 1) : 0;
+            dst[i / 2] = static_cast<uint8_t>((nibbleAt(row, x + i) << 4) | b);
+        }
+    } else {
+        memcpy(dst, row + x, count);
+    }
+    dst += bytes;
+    if (bytes & 1) {
+        *dst++ = 0;
+    }
+    return dst;
+}
+
+/// Pixels too few for absolute mode (< 3) go out as encoded runs
+inline uint8_t* rleLiteral(bool rle4, uint8_t* dst, const uint8_t* row, int x, int count) {
+    if (count >= 3) {
+        return rleAbsolute(rle4, dst, row, x, count);
+    }
+    if (rle4) {
+        return rleEncoded(rle4, dst, row, x, count);
+    }
+    for (int i = 0; i < count; i++) {
+        dst = rleEncoded(rle4, dst, row, x + i, 1);
+    }
+    return dst;
+}
+
+/// Bytes rleLiteral() writes for count pixels
+inline size_t rleLiteralBytes(bool rle4, int count) {
+    if (count < 3) {
+        return rle4 ? 2 : 2 * count;
+    }
+    const size_t bytes = rle4 ? (count + 1) / 2 : count;
+    return 2 + bytes + (bytes & 1);
+}
+
+/// Encode one row, ending with end-of-line, into dst (kRleRowMax bytes)
+/// Runs worth a pair (3+ equal pixels for RLE8, 4+ for RLE4) are encoded,
+/// the rest is grouped into absolute runs. A row that would come out larger
+/// than plain absolute code (dither noise) is re-encoded as absolute runs,
+/// so no row exceeds rle8RowBound()/rle4RowBound().
+size_t encodeRleRow(const OutputLayout& layout, const uint8_t* row, uint8_t* dst) {
+    const bool rle4 = layout.format == OutputFormat::Bmp4;
+    const int w = layout.width;
+    const int minRun = rle4 ? 4 : 3;
+    const int maxLiteral = rle4 ? 252 : 254;
+    const size_t budget = (rle4 ? rle4RowBound(w) : rle8RowBound(w)) - 2;
+    uint8_t* const begin = dst;
+    
+    bool fits = true;
+    int x = 0;
+    while (x < w) {
+        const int run = rleRunLength(rle4, row, x, w, 255);
+        if (run >= minRun) {
+            if (static_cast<size_t>(dst - begin) + 2 > budget) {
+                fits = false;
+                break;
+            }
+            dst = rleEncoded(rle4, dst, row, x, run);
+            x += run;
+            continue;
+        }
+        
+        // Literal pixels up to the next run worth encoding
+        int end = x + run;
+        while (end < w && end - x < maxLiteral && rleRunLength(rle4, row, end, w, minRun) < minRun) {
+            end++;
+        }
+        if (static_cast<size_t>(dst - begin) + rleLiteralBytes(rle4, end - x) > budget) {
+            fits = false;
+            break;
+        }
+        dst = rleLiteral(rle4, dst, row, x, end - x);
+        x = end;
+    }
+    
+    if (!fits) {
+        dst = begin;
+        for (x = 0; x < w; x += maxLiteral) {
+            dst = rleLiteral(rle4, dst, row, x, w - x < maxLiteral ? w - x : maxLiteral);
+        }
+    }
+    
+    *dst++ = 0;     // End of line
+    *dst++ = 0;
+    return dst - begin;
+}
+
+/// Gray levels shown by a finished output row
+inline const uint8_t* thumbRowLuma(const OutputLayout& layout, const uint8_t* row, ThumbBuilder& builder) {
+    if (layout.format == OutputFormat::Bmp8) {
+        return row;
+    }
+    if (layout.format == OutputFormat::Bmp4) {
+        for (int x = 0; x < layout.width; x++) {
+            builder.luma[x] = builder.tones[nibbleAt(row, x)];
+        }
+    } else {
+        for (int x = 0; x < layout.width; x++) {
+            builder.luma[x] = builder.tones[(row[x >> 2] >> (6 - 2 * (x & 3))) & 0x03];
+        }
+    }
+    return builder.luma;
+}
+
+/// Layouts or captures whose rows are consumed as soon as they are finished
+inline bool tracksRows(const OutputLayout& layout, const RowPacker& packer) {
+    return packsRows(layout) || packer.thumb != nullptr;
+}
+
+/// Complete finished rows up to (not including) endRow
+/// Each row goes into the thumbnail, then into the compressed stream.
+/// Rows are coded in image order, top row first; RLE bitmaps are bottom-up,
+/// so each row's code goes just below the previous one and the stream ends
+/// with the top row at rleTop.
+/// PNG rows are deflated top-down into the file at offset 0.
+void completeRows(const OutputLayout& layout, uint8_t* out, RowPacker& packer, int endRow) {
+    uint8_t code[kRleRowMax];
+    for (; packer.nextRow < endRow; packer.nextRow++) {
+        const uint8_t* row = outputRow(layout, out, packer.nextRow);
+        if (packer.thumb) {
+            packer.thumb->resampler.push_luma_row(thumbRowLuma(layout, row, *packer.thumb));
+        }
+        if (layout.format == OutputFormat::Png2) {
+            packer.png->writeRow(row);
+        } else if (layout.rle) {
+            const size_t len = encodeRleRow(layout, row, code);
+            packer.start -= len;
+            memcpy(out + packer.start, code, len);
+        }
+    }
+}
+
+/// Complete the pixel data and the thumbnail
+/// packer.thumb is left set only if the thumbnail pages were written.
+/// @return Final file size, 0 if the PNG could not be written
+size_t finishOutput(const OutputLayout& layout, uint8_t* out, RowPacker& packer) {
+    if (tracksRows(layout, packer)) {
+        completeRows(layout, out, packer, layout.height);
+    }
+    if (packer.thumb && !finishThumbnail(*packer.thumb, packer.thumbnail)) {
+        packer.thumb = nullptr;
+    }
+    
+    if (layout.format == OutputFormat::Png2) {
+        return packer.png->finish() ? packer.length : 0;
+    }
+    if (!layout.rle) {
+        if (layout.format == OutputFormat::Bmp8) {
+            clearBmpPadding(out + layout.pixelOffset, layout.width, layout.height);
+        }
+        return layout.totalSize;
+    }
+    
+    out[layout.rleTop] = 0;         // End of bitmap
+    out[layout.rleTop + 1] = 1;
+    
+    const size_t pixelSize = layout.rleTop + 2 - packer.start;
+    memmove(out + layout.pixelOffset, out + packer.start, pixelSize);
+    
+    BmpFileHeader* fileHdr = reinterpret_cast<BmpFileHeader*>(out);
+    BmpInfoHeader* infoHdr = reinterpret_cast<BmpInfoHeader*>(out + sizeof(BmpFileHeader));
+    fileHdr->size = layout.pixelOffset + pixelSize;
+    infoHdr->sizeImage = pixelSize;
+    return layout.pixelOffset + pixelSize;
+}
+
+//==============================================================================
+// Stage Profiler (esp_timer_get_time() stamps, rolling windows)
+//==============================================================================
+
+constexpr uint8_t kStageCount = static_cast<uint8_t>(CaptureStage::Count);
+constexpr uint8_t kTimingWindow = PXLCAM_CAPTURE_TIMING_WINDOW;
+
+static_assert(PXLCAM_CAPTURE_TIMING_WINDOW >= 1 && PXLCAM_CAPTURE_TIMING_WINDOW <= 255,
+              "PXLCAM_CAPTURE_TIMING_WINDOW must be 1..255");
+
+/// Ring of the last kTimingWindow samples of one stage
+struct StageWindow {
+    uint32_t samples[kTimingWindow];
+    uint8_t head;
+    uint8_t count;
+};
+
+// Written only by the capturing thread (sync path / collectPipelined)
+CaptureTimings g_lastTimings = {};
+FrameStats g_lastStats = {};
+StageWindow g_stageWindows[kStageCount] = {};
+
+inline int64_t nowUs() {
+    return esp_timer_get_time();
+}
+
+/// Frames do serviço de câmera (camera_service.h): a captura pede o próximo
+/// frame em resolução cheia, o anel ZSL o mais recente
+frames::ConsumerId g_captureConsumer = frames::kNoConsumer;
+frames::ConsumerId g_zslConsumer = frames::kNoConsumer;
+
+inline camera_fb_t* grabFrame(frames::ConsumerId consumer = g_captureConsumer) {
+    return frames::acquire(consumer);
+}
+
+/// Charge the time since `since` to a stage; returns the new stamp
+inline int64_t lapUs(CaptureTimings& t, CaptureStage stage, int64_t since) {
+    const int64_t now = esp_timer_get_time();
+    t[stage] += static_cast<uint32_t>(now - since);
+    return now;
+}
+
+void pushStageSample(CaptureStage stage, uint32_t us) {
+    StageWindow& win = g_stageWindows[static_cast<uint8_t>(stage)];
+    win.samples[win.head] = us;
+    win.head = (win.head + 1) % kTimingWindow;
+    if (win.count < kTimingWindow) {
+        win.count++;
+    }
+}
+
+/// Publish a finished capture as getLastTimings() and feed the windows
+/// Stages the frame never ran stay out of the windows (e.g. Decode only
+/// averages JPEG frames).
+void commitTimings(CaptureTimings t) {
+    t.totalUs = 0;
+    for (uint8_t i = 0; i < kStageCount; i++) {
+        t.totalUs += t.stageUs[i];
+        if (t.stageUs[i] != 0) {
+            pushStageSample(static_cast<CaptureStage>(i), t.stageUs[i]);
+        }
+    }
+    g_lastTimings = t;
+}
+
+/// Processing time of a capture (everything except fb_get and save), in ms
+inline uint32_t processMs(const CaptureTimings& t) {
+    return (t[CaptureStage::Decode] + t[CaptureStage::Gray] + t[CaptureStage::PostProcess] +
+            t[CaptureStage::Stylize] + t[CaptureStage::Encode]) / 1000;
+}
+
+//==============================================================================
+// Postprocess Chain (gray rows → filters/postprocess.h → stylize)
+//==============================================================================
+
+constexpr bool kPostProcess = PXLCAM_FEATURE_STYLIZED_CAPTURE && PXLCAM_CAPTURE_POSTPROCESS;
+constexpr uint8_t kPostWindows = PXLCAM_CAPTURE_POSTPROCESS_WINDOWS;
+constexpr int kPostBandRows = 16;   ///< One JPEG MCU row
+
+/// Chain rows of a capture up to kMaxWidth with every window in use
+constexpr size_t kHotPostBytes = pxlcam::filters::RowChain::storage_bytes_max(kMaxWidth, kPostWindows);
+
+/// Postprocess state of one task's captures
+/// Source rows are counted into the frame statistics as they enter the
+/// chain; the chain's output rows are what gets stylized. Captures up to
+/// kMaxWidth run on a DRAM scratch block when one was free; otherwise row
+/// storage grows to the widest capture that ran a chain and is kept. JPEG luma
+/// comes as MCU blocks, so one MCU row is collected in the band before its
+/// rows go in. The compiled program and vignette table in postprocess.cpp
+/// are shared, but only rebuilt when the chain or the frame size changes.
+struct PostRows {
+    pxlcam::filters::PostProcessConfig config;  ///< The capture's chain (snapshot)
+    pxlcam::filters::RowChain chain;
+    FrameStats* stats;
+    uint8_t* storage;           ///< RowChain rows (heap, wider chains)
+    size_t capacity;
+    uint8_t* hot;               ///< kHotPostBytes of DRAM scratch, nullptr if none was free
+    uint8_t* band;              ///< kPostBandRows x width luma (JPEG)
+    size_t bandCapacity;
+    int width;
+    int bandY;                  ///< Image row of band row 0
+    int bandRows;               ///< Band rows holding luma
+    uint32_t histogram[256];    ///< Chain input of the last capture (histogram EQ)
+    uint32_t histogramPixels;
+};
+
+PostRows* g_post = nullptr;     ///< Calling-task captures
+
+/// Grow a kept row buffer to at least `bytes`
+bool reserveRows(uint8_t*& buffer, size_t& capacity, size_t bytes, const char* name) {
+    if (capacity >= bytes) {
+        return true;
+    }
+    freePsram(&buffer);
+    buffer = allocateHeap(bytes, name);
+    capacity = buffer ? bytes : 0;
+    return buffer != nullptr;
+}
+
+/// Start the configured chain on a w x h capture
+/// @param jpeg Rows come from MCU blocks (bandBlock())
+/// @param sink Where output rows go
+/// @return nullptr when no chain is configured, or no memory for its rows
+///         (logged; the capture goes on without it)
+PostRows* beginPost(PostRows*& post, int w, int h, bool jpeg, FrameStats& stats,
+                    pxlcam::filters::RowChain::RowSink sink, void* user) {
+    if (!kPostProcess) {
+        return nullptr;
+    }
+    const pxlcam::filters::PostProcessConfig& config = pxlcam::filters::postprocess_get_config();
+    if (!config.enabled || config.filterCount == 0) {
+        return nullptr;
+    }
+    
+    if (!post) {
+        uint8_t* mem = allocatePsram(sizeof(PostRows), "PostRows");
+        if (!mem) {
+            return nullptr;
+        }
+        post = new (mem) PostRows();
+        // The 3x3 windows are read nine times per pixel: keep them out of PSRAM
+        post->hot = static_cast<uint8_t*>(pxlcam::placement::scratch(kHotPostBytes, "PostRows", 2));
+    }
+    post->config = config;
+    const size_t bytes = pxlcam::filters::RowChain::storage_bytes(post->config, w, kPostWindows);
+    const bool hot = post->hot && bytes <= kHotPostBytes;
+    if ((!hot && !reserveRows(post->storage, post->capacity, bytes, "PostRows")) ||
+        (jpeg && !reserveRows(post->band, post->bandCapacity,
+                              static_cast<size_t>(w) * kPostBandRows, "PostBand"))) {
+        PXLCAM_LOGW_TAG(kLogTag, "Pós-processamento ignorado: sem memória");
+        return nullptr;
+    }
+    
+    const uint32_t* histogram = post->histogramPixels ? post->histogram : nullptr;
+    if (!post->chain.begin(post->config, w, h, hot ? post->hot : post->storage,
+                           hot ? kHotPostBytes : post->capacity, histogram,
+                           post->histogramPixels, sink, user, kPostWindows) ||
+        !post->chain.active()) {
+        return nullptr;
+    }
+    if (post->chain.skipped()) {
+        PXLCAM_LOGW_TAG(kLogTag, "Pós-processamento: %u filtro(s) 3x3 ignorado(s) (máx. %u)",
+                        post->chain.skipped(), kPostWindows);
+    }
+    
+    post->stats = &stats;
+    post->width = w;
+    post->bandY = 0;
+    post->bandRows = 0;
+    return post;
+}
+
+/// One source row into the chain
+inline bool pushPost(PostRows& post, const uint8_t* gray) {
+    accumulateStats(*post.stats, gray, post.width);
+    return post.chain.push(gray);
+}
+
+/// Send the band's rows down the chain
+bool flushBand(PostRows& post) {
+    for (int r = 0; r < post.bandRows; r++) {
+        if (!pushPost(post, post.band + static_cast<size_t>(r) * post.width)) {
+            return false;
+        }
+    }
+    post.bandY += post.bandRows;
+    post.bandRows = 0;
+    return true;
+}
+
+/// Decoder block into the band; a block of the next MCU row sends the band down first
+bool bandBlock(PostRows& post, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* luma) {
+    if (y != post.bandY && !flushBand(post)) {
+        return false;
+    }
+    if (y != post.bandY || h > kPostBandRows) {
+        PXLCAM_LOGE_TAG(kLogTag, "Pós-processamento: bloco fora da faixa (y=%u h=%u)", y, h);
+        return false;
+    }
+    for (uint16_t row = 0; row < h; row++) {
+        memcpy(post.band + static_cast<size_t>(row) * post.width + x, luma + row * w, w);
+    }
+    if (h > post.bandRows) {
+        post.bandRows = h;
+    }
+    return true;
+}
+
+/// Last rows of the frame; keeps the histogram for the next capture's EQ
+bool finishPost(PostRows& post) {
+    if (!flushBand(post) || !post.chain.finish()) {
+        return false;
+    }
+    if (const uint32_t pixels = post.chain.histogramPixels()) {
+        memcpy(post.histogram, post.chain.histogram(), sizeof(post.histogram));
+        post.histogramPixels = pixels;
+    }
+    return true;
+}
+
+/// Chain output into an output buffer: stylized into its row, finished
+/// rows completed as they come
+/// mark is the caller's profiler stamp; chain time up to here is PostProcess.
+struct OutputRows {
+    const OutputLayout* layout;
+    uint8_t* out;
+    RowPacker* packer;
+    pxlcam::mode::CaptureMode mode;
+    CaptureTimings* timings;
+    int64_t* mark;
+};
+
+bool outputRowSink(void* user, const uint8_t* gray, int y) {
+    OutputRows* o = static_cast<OutputRows*>(user);
+    *o->mark = lapUs(*o->timings, CaptureStage::PostProcess, *o->mark);
+    stylizeInto(*o->layout, outputRow(*o->layout, o->out, y), gray, 0, y, o->layout->width, o->mode);
+    *o->mark = lapUs(*o->timings, CaptureStage::Stylize, *o->mark);
+    if (tracksRows(*o->layout, *o->packer)) {
+        completeRows(*o->layout, o->out, *o->packer, y + 1);
+        *o->mark = lapUs(*o->timings, CaptureStage::Encode, *o->mark);
+    }
+    return true;
+}
+
+//==============================================================================
+// Capture Stages (shared by synchronous and pipelined paths)
+//==============================================================================
+
+void logModeStage(pxlcam::mode::CaptureMode mode) {
+    switch (mode) {
+        case pxlcam::mode::CaptureMode::GameBoy:
+            PXLCAM_LOGI_TAG(kLogTag, "Aplicando dithering GameBoy (Bayer 8x8)...");
+            break;
+        case pxlcam::mode::CaptureMode::Night:
+            PXLCAM_LOGI_TAG(kLogTag, "Aplicando enhance Night (gamma + contraste)...");
+            break;
+        case pxlcam::mode::CaptureMode::Normal:
+        default:
+            PXLCAM_LOGI_TAG(kLogTag, "Modo Normal - grayscale neutro");
+            break;
+    }
+}
+
+/// Check camera frame dimensions and format (logs only on rejection)
+CaptureResult checkFrame(const camera_fb_t* fb, int maxW = kMaxWidth, int maxH = kMaxHeight) {
+    const int w = fb->width;
+    const int h = fb->height;
+    
+    if (w > maxW || h > maxH) {
+        PXLCAM_LOGE_TAG(kLogTag, "Frame muito grande: %dx%d (max %dx%d)", w, h, maxW, maxH);
+        return CaptureResult::MemoryError;
+    }
+    
+    // Bytes per pixel of the raw formats read in place (0 = JPEG / RGB888 / unsupported)
+    const size_t rawStep = (fb->format == PIXFORMAT_RGB565) ? pxlcam::luma::kRgb565Step
+                                                            : pxlcam::lumaSampleStep(fb->format);
+    if (fb->format != PIXFORMAT_JPEG && fb->format != PIXFORMAT_RGB888 && rawStep == 0) {
+        PXLCAM_LOGE_TAG(kLogTag, "Formato nao suportado: %d", fb->format);
+        return CaptureResult::ProcessingError;
+    }
+    
+    if (rawStep != 0 && fb->len < static_cast<size_t>(w) * h * rawStep) {
+        PXLCAM_LOGE_TAG(kLogTag, "Frame truncado: %u bytes (esperado %u)",
+                        fb->len, static_cast<unsigned>(w * h * rawStep));
+        return CaptureResult::ProcessingError;
+    }
+    
+    return CaptureResult::Success;
+}
+
+/// Validate camera frame dimensions and format
+CaptureResult validateFrame(const camera_fb_t* fb, int maxW = kMaxWidth, int maxH = kMaxHeight) {
+    PXLCAM_LOGI_TAG(kLogTag, "Frame: %dx%d, %u bytes, format=%d",
+                    fb->width, fb->height, fb->len, fb->format);
+    return checkFrame(fb, maxW, maxH);
+}
+
+/// Debug logs for a finished capture (PXLCAM_CAPTURE_LOG_STATS only)
+/// Statistics come from the capture pass; only the 9 tone samples touch pixels.
+/// Bmp8 rows are padded to 4 bytes: samples step rows by the stride and stay
+/// inside the image width, off the zeroed padding.
+void logOutputPixels(const uint8_t* out, const OutputLayout& layout, size_t length,
+                     const FrameStats& stats) {
+#if PXLCAM_CAPTURE_LOG_STATS
+    logFrameStats(stats);
+    if (layout.format != OutputFormat::Bmp8 || layout.rle) {
+        PXLCAM_LOGI_TAG(kLogTag, "Saida %s%s: %dx%d, %u bytes",
+                        getOutputFormatName(layout.format), layout.rle ? " RLE" : "",
+                        layout.width, layout.height, static_cast<unsigned>(length));
+        return;
+    }
+    logSampleTones(out + layout.pixelOffset, layout.width, layout.height, layout.stride);
+#else
+    (void)out;
+    (void)layout;
+    (void)length;
+    (void)stats;
+#endif
+}
+
+//==============================================================================
+// Pixel Blocks (scaled JPEG decode, pixel_filter.h)
+//==============================================================================
+
+uint8_t g_pixelBlock = PXLCAM_CAPTURE_PIXEL_BLOCK;
+
+/// Block size a frame is pixelated with (1 = none)
+/// Only JPEG frames, with a block the decoder scales by, that split into
+/// whole blocks: the decoder's 1/block output is then the block average.
+uint8_t pixelBlockFor(const camera_fb_t* fb) {
+    const uint8_t block = g_pixelBlock;
+    if (fb->format != PIXFORMAT_JPEG || pxlcam::filter::decodeScaleFor(block) == JPG_SCALE_NONE ||
+        fb->width % block != 0 || fb->height % block != 0) {
+        return 1;
+    }
+    return block;
+}
+
+/// Decode a JPEG frame to luma blocks, at 1/block when pixelating
+/// Scaled blocks are repeated back to full size before the sink sees them,
+/// so sinks, output layout and row order are the same as without.
+bool decodeFrameBlocks(const camera_fb_t* fb, pxlcam::jpeg::LumaBlockCallback sink, void* user) {
+    const uint8_t block = pixelBlockFor(fb);
+    if (block == 1) {
+        return pxlcam::jpeg::decodeLumaBlocks(fb->buf, fb->len, sink, user);
+    }
+    
+    pxlcam::filter::BlockExpander expander = { sink, user, block };
+    return pxlcam::jpeg::decodeLumaBlocks(fb->buf, fb->len, pxlcam::filter::expandBlocks, &expander,
+                                          pxlcam::filter::decodeScaleFor(block));
+}
+
+/// Decoder sink: stylize each luma block and place it at its final output offset
+/// Time between callbacks is decoder time; time inside is stylize time.
+struct FusedWriter {
+    const OutputLayout* layout;
+    uint8_t* out;
+    RowPacker* packer;
+    pxlcam::mode::CaptureMode mode;
+    CaptureTimings* timings;
+    FrameStats* stats;
+    int64_t mark;
+    PostRows* post;         ///< Blocks go to the chain's band instead (nullptr = none)
+};
+
+bool writeFusedBlock(void* user, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* luma) {
+    FusedWriter* out = static_cast<FusedWriter*>(user);
+    
+    if (!luma) {
+        // Decoded size must match the frame size used for the header
+        return w == out->layout->width && h == out->layout->height;
+    }
+    
+    out->mark = lapUs(*out->timings, CaptureStage::Decode, out->mark);
+    
+    if (out->post) {
+        // Finished bands come back through outputRowSink()
+        const bool placed = bandBlock(*out->post, x, y, w, h, luma);
+        out->mark = lapUs(*out->timings, CaptureStage::PostProcess, out->mark);
+        return placed;
+    }
+    
+    // Blocks arrive in MCU-row order: rows above this band are complete
+    if (tracksRows(*out->layout, *out->packer) && y > out->packer->nextRow) {
+        completeRows(*out->layout, out->out, *out->packer, y);
+        out->mark = lapUs(*out->timings, CaptureStage::Encode, out->mark);
+    }
+    
+    for (uint16_t row = 0; row < h; row++) {
+        writeSpan(*out->layout, outputRow(*out->layout, out->out, y + row), luma + row * w,
+                  x, y + row, w, out->mode, *out->stats);
+    }
+    
+    out->mark = lapUs(*out->timings, CaptureStage::Stylize, out->mark);
+    return true;
+}
+
+/// Single pass: decode/convert, stylize and write output rows in place
+/// The frame is touched once; there is no grayscale copy and no memmove.
+/// RLE rows are compressed as soon as they are complete, while still hot,
+/// and the thumbnail is downscaled from the same rows.
+/// @param length Output file size
+/// @param thumbnail Set if slotThumbnail(out) holds the thumbnail
+CaptureResult captureToOutput(const camera_fb_t* fb, pxlcam::mode::CaptureMode mode,
+                              uint8_t* out, const OutputLayout& layout,
+                              CaptureTimings& t, FrameStats& stats, size_t& length, bool& thumbnail) {
+    const int w = layout.width;
+    const int h = layout.height;
+    
+    beginStats(stats);
+    int64_t mark = nowUs();
+    writeOutputHeader(out, layout);
+    prepareOutputRows(layout, out + layout.pixelOffset, h);
+    RowPacker packer;
+    thumbnail = false;
+    if (!beginPacking(layout, out, packer, g_pngWriter, g_thumbBuilder)) {
+        return CaptureResult::MemoryError;
+    }
+    uint8_t rowBuf[kMaxWidth];
+    lapUs(t, CaptureStage::Encode, mark);
+    
+    logModeStage(mode);
+    
+    // With a chain, gray rows go through it (always via rowBuf: output rows
+    // lag the input) and come out stylized and completed in outputRowSink()
+    OutputRows sink = { &layout, out, &packer, mode, &t, &mark };
+    PostRows* post = beginPost(g_post, w, h, fb->format == PIXFORMAT_JPEG, stats, outputRowSink, &sink);
+    
+    if (fb->format == PIXFORMAT_JPEG) {
+        PXLCAM_LOGI_TAG(kLogTag, "Decodificando JPEG -> luma -> %s...", getOutputFormatName(layout.format));
+        
+        FusedWriter writer = { &layout, out, &packer, mode, &t, &stats, nowUs(), post };
+        sink.mark = &writer.mark;
+        const bool decoded = decodeFrameBlocks(fb, writeFusedBlock, &writer);
+        mark = lapUs(t, CaptureStage::Decode, writer.mark);
+        sink.mark = &mark;
+        if (!decoded) {
+            PXLCAM_LOGE_TAG(kLogTag, "ERRO: Falha ao decodificar JPEG");
+            return CaptureResult::ProcessingError;
+        }
+    } else if (fb->format == PIXFORMAT_RGB888) {
+        PXLCAM_LOGI_TAG(kLogTag, "Convertendo RGB888 -> %s...", getOutputFormatName(layout.format));
+        
+        mark = nowUs();
+        for (int y = 0; y < h; y++) {
+            uint8_t* row = outputRow(layout, out, y);
+            uint8_t* gray = post ? rowBuf : spanScratch(layout, row, rowBuf);
+            rgbToGrayscale(fb->buf + y * w * 3, gray, w, 1);
+            mark = lapUs(t, CaptureStage::Gray, mark);
+            if (post) {
+                pushPost(*post, gray);
+                mark = lapUs(t, CaptureStage::PostProcess, mark);
+                continue;
+            }
+            writeSpan(layout, row, gray, 0, y, w, mode, stats);
+            mark = lapUs(t, CaptureStage::Stylize, mark);
+            if (tracksRows(layout, packer)) {
+                completeRows(layout, out, packer, y + 1);
+                mark = lapUs(t, CaptureStage::Encode, mark);
+            }
+        }
+    } else if (fb->format == PIXFORMAT_RGB565) {
+        // Converted row by row straight out of the frame buffer
+        PXLCAM_LOGI_TAG(kLogTag, "Convertendo RGB565 -> %s...", getOutputFormatName(layout.format));
+        
+        mark = nowUs();
+        for (int y = 0; y < h; y++) {
+            uint8_t* row = outputRow(layout, out, y);
+            uint8_t* gray = post ? rowBuf : spanScratch(layout, row, rowBuf);
+            pxlcam::luma::rgb565Row(fb->buf + y * w * pxlcam::luma::kRgb565Step, gray, w);
+            mark = lapUs(t, CaptureStage::Gray, mark);
+            if (post) {
+                pushPost(*post, gray);
+                mark = lapUs(t, CaptureStage::PostProcess, mark);
+                continue;
+            }
+            writeSpan(layout, row, gray, 0, y, w, mode, stats);
+            mark = lapUs(t, CaptureStage::Stylize, mark);
+            if (tracksRows(layout, packer)) {
+                completeRows(layout, out, packer, y + 1);
+                mark = lapUs(t, CaptureStage::Encode, mark);
+            }
+        }
+    } else {
+        // Native sensor luma: Y is read straight from the frame
+        const size_t step = pxlcam::lumaSampleStep(fb->format);
+        const size_t srcStride = static_cast<size_t>(w) * step;
+        PXLCAM_LOGI_TAG(kLogTag, "Luma nativo (passo %u) -> %s...",
+                        static_cast<unsigned>(step), getOutputFormatName(layout.format));
+        
+        mark = nowUs();
+        for (int y = 0; y < h; y++) {
+            const uint8_t* srcRow = fb->buf + y * srcStride;
+            uint8_t* row = outputRow(layout, out, y);
+            const uint8_t* gray = srcRow;
+            if (step != pxlcam::luma::kGrayscaleStep) {
+                uint8_t* scratch = post ? rowBuf : spanScratch(layout, row, rowBuf);
+                pxlcam::luma::extractRow(srcRow, step, scratch, w);
+                gray = scratch;
+                mark = lapUs(t, CaptureStage::Gray, mark);
+            }
+            if (post) {
+                pushPost(*post, gray);
+                mark = lapUs(t, CaptureStage::PostProcess, mark);
+                continue;
+            }
+            writeSpan(layout, row, gray, 0, y, w, mode, stats);
+            mark = lapUs(t, CaptureStage::Stylize, mark);
+            if (tracksRows(layout, packer)) {
+                completeRows(layout, out, packer, y + 1);
+                mark = lapUs(t, CaptureStage::Encode, mark);
+            }
+        }
+    }
+    
+    if (post) {
+        finishPost(*post);
+        lapUs(t, CaptureStage::PostProcess, mark);
+    }
+    
+    mark = nowUs();
+    length = finishOutput(layout, out, packer);
+    thumbnail = packer.thumb != nullptr;
+    lapUs(t, CaptureStage::Encode, mark);
+    finishStats(stats);
+    return length ? CaptureResult::Success : CaptureResult::ProcessingError;
+}
+
+/// Pipeline stage 1 (producer): convert camera frame to a packed gray plane
+/// @param verbose Log the stage (off for background ring refills)
+/// @param pixelate Apply the pixel block (off for frames that are stacked)
+CaptureResult decodeFrameToGray(const camera_fb_t* fb, uint8_t* grayOut, CaptureTimings& t,
+                                bool verbose = true, bool pixelate = true) {
+    if (fb->format == PIXFORMAT_JPEG) {
+        if (verbose) {
+            PXLCAM_LOGI_TAG(kLogTag, "Decodificando JPEG -> luma...");
+        }
+        
+        const int64_t mark = nowUs();
+        const uint8_t block = pixelate ? pixelBlockFor(fb) : 1;
+        bool decoded = false;
+        if (block == 1) {
+            decoded = pxlcam::jpeg::decodeToLuma(fb->buf, fb->len, grayOut, kMaxWidth, kMaxHeight);
+        } else {
+            // Decoded small into the top of the plane, then grown to full size
+            pxlcam::filter::ScaledImage small;
+            decoded = pxlcam::filter::decodeScaled(fb->buf, fb->len, block, 0, grayOut,
+                                                   kMaxWidth / block, kMaxHeight / block, small);
+            if (decoded) {
+                pxlcam::filter::expandInPlace(small);
+            }
+        }
+        lapUs(t, CaptureStage::Decode, mark);
+        if (!decoded) {
+            PXLCAM_LOGE_TAG(kLogTag, "ERRO: Falha ao decodificar JPEG");
+            return CaptureResult::ProcessingError;
+        }
+    } else if (fb->format == PIXFORMAT_RGB888) {
+        if (verbose) {
+            PXLCAM_LOGI_TAG(kLogTag, "Convertendo para grayscale...");
+        }
+        const int64_t mark = nowUs();
+        rgbToGrayscale(fb->buf, grayOut, fb->width, fb->height);
+        lapUs(t, CaptureStage::Gray, mark);
+    } else if (fb->format == PIXFORMAT_RGB565) {
+        if (verbose) {
+            PXLCAM_LOGI_TAG(kLogTag, "Convertendo RGB565 para grayscale...");
+        }
+        const int64_t mark = nowUs();
+        const size_t srcStride = static_cast<size_t>(fb->width) * pxlcam::luma::kRgb565Step;
+        for (int y = 0; y < static_cast<int>(fb->height); y++) {
+            pxlcam::luma::rgb565Row(fb->buf + y * srcStride, grayOut + y * fb->width, fb->width);
+        }
+        lapUs(t, CaptureStage::Gray, mark);
+    } else {
+        const size_t step = pxlcam::lumaSampleStep(fb->format);
+        const int64_t mark = nowUs();
+        pxlcam::luma::extractPlane(fb->buf, static_cast<size_t>(fb->width) * step, step,
+                                   grayOut, fb->width, fb->width, fb->height);
+        lapUs(t, CaptureStage::Gray, mark);
+    }
+    
+    return CaptureResult::Success;
+}
+
+/// Pipeline stage 2 (consumer): stylize gray rows straight into output rows
+/// @param thumbnail Set if slotThumbnail(out) holds the thumbnail
+/// @param png, thumb, post PNG writer, thumbnail builder and postprocess
+///        rows of the calling task
+/// @return Output file size, 0 if the output could not be written
+size_t stylizeToOutput(const uint8_t* gray, pxlcam::mode::CaptureMode mode,
+                       uint8_t* out, const OutputLayout& layout,
+                       CaptureTimings& t, FrameStats& stats, bool& thumbnail,
+                       pxlcam::png::IndexedPngWriter*& png = g_pngWriter,
+                       ThumbBuilder*& thumb = g_thumbBuilder,
+                       PostRows*& post = g_post) {
+    beginStats(stats);
+    int64_t mark = nowUs();
+    writeOutputHeader(out, layout);
+    prepareOutputRows(layout, out + layout.pixelOffset, layout.height);
+    RowPacker packer;
+    thumbnail = false;
+    if (!beginPacking(layout, out, packer, png, thumb)) {
+        return 0;
+    }
+    lapUs(t, CaptureStage::Encode, mark);
+    
+    logModeStage(mode);
+    
+    mark = nowUs();
+    OutputRows sink = { &layout, out, &packer, mode, &t, &mark };
+    if (PostRows* rows = beginPost(post, layout.width, layout.height, false, stats, outputRowSink, &sink)) {
+        for (int y = 0; y < layout.height; y++) {
+            pushPost(*rows, gray + y * layout.width);
+        }
+        finishPost(*rows);
+        mark = lapUs(t, CaptureStage::PostProcess, mark);
+    } else {
+        for (int y = 0; y < layout.height; y++) {
+            writeSpan(layout, outputRow(layout, out, y), gray + y * layout.width,
+                      0, y, layout.width, mode, stats);
+            completeRows(layout, out, packer, y + 1);
+        }
+        mark = lapUs(t, CaptureStage::Stylize, mark);
+    }
+    const size_t length = finishOutput(layout, out, packer);
+    thumbnail = packer.thumb != nullptr;
+    lapUs(t, CaptureStage::Encode, mark);
+    finishStats(stats);
+    return length;
+}
+
+//==============================================================================
+// Strip Capture (full resolution → file, fixed working set)
+//==============================================================================
+
+constexpr int kStripMaxWidth = PXLCAM_STRIP_MAX_WIDTH;
+constexpr int kStripMaxHeight = PXLCAM_STRIP_MAX_HEIGHT;
+constexpr int kStripRows = PXLCAM_STRIP_ROWS;
+
+// One strip of output rows; Bmp8 has the widest rows of all formats
+constexpr size_t kStripBufferSize =
+    (static_cast<size_t>((kStripMaxWidth + 3) & ~3) * kStripRows > kBmpPixelOffset)
+        ? static_cast<size_t>((kStripMaxWidth + 3) & ~3) * kStripRows
+        : kBmpPixelOffset;
+
+// Raw frames: one source row converted to gray, behind the strip in the
+// same allocation (too large for the capture task's stack)
+constexpr size_t kStripAllocSize = kStripBufferSize + kStripMaxWidth;
+
+static_assert(kStripRows >= 16, "PXLCAM_STRIP_ROWS must hold one JPEG MCU row (16)");
+
+/// Capture-phase arena lease, or a heap buffer kept once the arena had no room
+pxlcam::arena::Lease<uint8_t> g_stripLease;
+uint8_t* g_stripHeap = nullptr;
+uint8_t* g_stripBuffer = nullptr;  ///< Strip buffer of the current capture
+uint8_t* g_stripRowBuf = nullptr;  ///< Its gray row scratch (kStripMaxWidth)
+
+/// Strip state: rows [stripY, stripY + kStripRows) of the image live in strip
+/// mark is the last profiler stamp; time since then belongs to the next lap.
+struct StripWriter {
+    const OutputLayout* layout;
+    pxlcam::mode::CaptureMode mode;
+    uint8_t* strip;
+    int stripY;
+    pxlcam::png::IndexedPngWriter* png;     ///< Png2: rows are deflated into the stream
+    ThumbBuilder* thumb;                    ///< Thumbnail being built (nullptr = none)
+    CaptureTimings* timings;
+    FrameStats* stats;
+    int64_t mark;
+    PostRows* post;                         ///< Rows go through the chain (nullptr = none)
+};
+
+bool streamSink(void*, const uint8_t* data, size_t len) {
+    return pxlcam::storage::appendStream(data, len);
+}
+
+/// Append the first `rows` strip rows to the file and start the next strip
+/// PNG strips are deflated on the way (Encode, including the stream appends).
+/// The rows go into the thumbnail first (Encode).
+bool flushStrip(StripWriter& sw, int rows) {
+    if (rows <= 0) {
+        return true;
+    }
+    
+    if (sw.thumb) {
+        for (int r = 0; r < rows; r++) {
+            const uint8_t* row = sw.strip + static_cast<size_t>(r) * sw.layout->stride;
+            sw.thumb->resampler.push_luma_row(thumbRowLuma(*sw.layout, row, *sw.thumb));
+        }
+        sw.mark = lapUs(*sw.timings, CaptureStage::Encode, sw.mark);
+    }
+    
+    bool written = true;
+    if (sw.png) {
+        for (int r = 0; r < rows && written; r++) {
+            written = sw.png->writeRow(sw.strip + static_cast<size_t>(r) * sw.layout->stride);
+        }
+        sw.mark = lapUs(*sw.timings, CaptureStage::Encode, sw.mark);
+    } else {
+        const size_t bytes = static_cast<size_t>(sw.layout->stride) * rows;
+        written = pxlcam::storage::appendStream(sw.strip, bytes);
+        sw.mark = lapUs(*sw.timings, CaptureStage::Save, sw.mark);
+    }
+    if (!written) {
+        return false;
+    }
+    
+    sw.stripY += rows;
+    prepareOutputRows(*sw.layout, sw.strip, kStripRows);
+    sw.mark = lapUs(*sw.timings, CaptureStage::Encode, sw.mark);
+    return true;
+}
+
+bool writeStripBlock(void* user, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* luma) {
+    StripWriter* sw = static_cast<StripWriter*>(user);
+    
+    if (!luma) {
+        return w == sw->layout->width && h == sw->layout->height;
+    }
+    
+    sw->mark = lapUs(*sw->timings, CaptureStage::Decode, sw->mark);
+    
+    if (sw->post) {
+        // Finished bands come back through stripRowSink()
+        const bool placed = bandBlock(*sw->post, x, y, w, h, luma);
+        sw->mark = lapUs(*sw->timings, CaptureStage::PostProcess, sw->mark);
+        return placed;
+    }
+    
+    // Blocks arrive in MCU-row order: a new y means the previous row band is done
+    if (y != sw->stripY && !flushStrip(*sw, y - sw->stripY)) {
+        return false;
+    }
+    if (y + h - sw->stripY > kStripRows) {
+        PXLCAM_LOGE_TAG(kLogTag, "Strip: bloco fora da faixa (y=%u h=%u)", y, h);
+        return false;
+    }
+    
+    const int stride = sw->layout->stride;
+    for (uint16_t row = 0; row < h; row++) {
+        writeSpan(*sw->layout, sw->strip + (y + row - sw->stripY) * stride, luma + row * w,
+                  x, y + row, w, sw->mode, *sw->stats);
+    }
+    
+    sw->mark = lapUs(*sw->timings, CaptureStage::Stylize, sw->mark);
+    return true;
+}
+
+/// Chain output row y into the strip, flushing the strip once it is full
+bool stripRowSink(void* user, const uint8_t* gray, int y) {
+    StripWriter* sw = static_cast<StripWriter*>(user);
+    sw->mark = lapUs(*sw->timings, CaptureStage::PostProcess, sw->mark);
+    if (y - sw->stripY == kStripRows && !flushStrip(*sw, kStripRows)) {
+        return false;
+    }
+    stylizeInto(*sw->layout, sw->strip + (y - sw->stripY) * sw->layout->stride, gray,
+                0, y, sw->layout->width, sw->mode);
+    sw->mark = lapUs(*sw->timings, CaptureStage::Stylize, sw->mark);
+    return true;
+}
+
+/// Decode/convert + stylize one frame strip by strip into the open stream
+/// @param length Bytes written to the stream
+/// @param thumbnail Set to the thumbnail pages, nullptr when there is none
+CaptureResult streamFrameStrips(const camera_fb_t* fb, pxlcam::mode::CaptureMode mode,
+                                const OutputLayout& layout,
+                                CaptureTimings& t, FrameStats& stats, size_t& length,
+                                const uint8_t*& thumbnail) {
+    const int w = layout.width;
+    const int h = layout.height;
+    
+    beginStats(stats);
+    thumbnail = nullptr;
+    StripWriter sw = { &layout, mode, g_stripBuffer, 0, nullptr,
+                       startThumbnail(g_thumbBuilder, w, h, "ThumbBuilder"), &t, &stats, nowUs(), nullptr };
+    
+    // Header goes out first (top-down BMP / PXL / PNG rows follow in order)
+    bool headerWritten = false;
+    if (layout.format == OutputFormat::Png2) {
+        if (!acquirePngWriter(g_pngWriter, "PngWriter")) {
+            return CaptureResult::MemoryError;
+        }
+        uint8_t tones[kIndexedTones];
+        uint8_t rgb[kIndexedTones * 3];
+        currentTones(tones, rgb);
+        sw.png = g_pngWriter;
+        headerWritten = sw.png->beginRgb(w, h, 2, rgb, kIndexedTones, streamSink, nullptr);
+        sw.mark = lapUs(t, CaptureStage::Encode, sw.mark);
+    } else {
+        writeOutputHeader(g_stripBuffer, layout);
+        sw.mark = lapUs(t, CaptureStage::Encode, sw.mark);
+        headerWritten = pxlcam::storage::appendStream(g_stripBuffer, layout.pixelOffset);
+        sw.mark = lapUs(t, CaptureStage::Save, sw.mark);
+    }
+    if (!headerWritten) {
+        return CaptureResult::ProcessingError;
+    }
+    
+    memset(g_stripBuffer, 0, kStripBufferSize);  // Bmp8 padding stays zero
+    lapUs(t, CaptureStage::Encode, sw.mark);
+    
+    logModeStage(mode);
+    sw.mark = nowUs();
+    sw.post = beginPost(g_post, w, h, fb->format == PIXFORMAT_JPEG, stats, stripRowSink, &sw);
+    sw.mark = lapUs(t, CaptureStage::PostProcess, sw.mark);
+    
+    if (fb->format == PIXFORMAT_JPEG) {
+        const bool decoded = decodeFrameBlocks(fb, writeStripBlock, &sw);
+        sw.mark = lapUs(t, CaptureStage::Decode, sw.mark);
+        if (!decoded) {
+            PXLCAM_LOGE_TAG(kLogTag, "ERRO: Falha ao decodificar JPEG (strip y=%d)", sw.stripY);
+            return CaptureResult::ProcessingError;
+        }
+    } else if (sw.post) {
+        // Output rows lag the chain input: rows are converted into rowBuf and
+        // the strip fills from stripRowSink()
+        const size_t step = (fb->format == PIXFORMAT_RGB888) ? 3
+                          : (fb->format == PIXFORMAT_RGB565) ? pxlcam::luma::kRgb565Step
+                          : pxlcam::lumaSampleStep(fb->format);
+        const size_t srcStride = static_cast<size_t>(w) * step;
+        uint8_t* rowBuf = g_stripRowBuf;
+        
+        for (int y = 0; y < h; y++) {
+            const uint8_t* srcRow = fb->buf + y * srcStride;
+            const uint8_t* gray = rowBuf;
+            if (fb->format == PIXFORMAT_RGB888) {
+                rgbToGrayscale(srcRow, rowBuf, w, 1);
+            } else if (fb->format == PIXFORMAT_RGB565) {
+                pxlcam::luma::rgb565Row(srcRow, rowBuf, w);
+            } else if (step != pxlcam::luma::kGrayscaleStep) {
+                pxlcam::luma::extractRow(srcRow, step, rowBuf, w);
+            } else {
+                gray = srcRow;
+            }
+            sw.mark = lapUs(t, CaptureStage::Gray, sw.mark);
+            if (!pushPost(*sw.post, gray)) {
+                return CaptureResult::ProcessingError;
+            }
+            sw.mark = lapUs(t, CaptureStage::PostProcess, sw.mark);
+        }
+    } else {
+        const size_t step = (fb->format == PIXFORMAT_RGB888) ? 3
+                          : (fb->format == PIXFORMAT_RGB565) ? pxlcam::luma::kRgb565Step
+                          : pxlcam::lumaSampleStep(fb->format);
+        const size_t srcStride = static_cast<size_t>(w) * step;
+        uint8_t* rowBuf = g_stripRowBuf;
+        
+        for (int y = 0; y < h; y++) {
+            if (y - sw.stripY == kStripRows && !flushStrip(sw, kStripRows)) {
+                return CaptureResult::ProcessingError;
+            }
+            
+            const uint8_t* srcRow = fb->buf + y * srcStride;
+            uint8_t* row = sw.strip + (y - sw.stripY) * layout.stride;
+            const uint8_t* gray = srcRow;
+            
+            if (fb->format == PIXFORMAT_RGB888) {
+                uint8_t* scratch = spanScratch(layout, row, rowBuf);
+                rgbToGrayscale(srcRow, scratch, w, 1);
+                gray = scratch;
+                sw.mark = lapUs(t, CaptureStage::Gray, sw.mark);
+            } else if (fb->format == PIXFORMAT_RGB565) {
+                uint8_t* scratch = spanScratch(layout, row, rowBuf);
+                pxlcam::luma::rgb565Row(srcRow, scratch, w);
+                gray = scratch;
+                sw.mark = lapUs(t, CaptureStage::Gray, sw.mark);
+            } else if (step != pxlcam::luma::kGrayscaleStep) {
+                uint8_t* scratch = spanScratch(layout, row, rowBuf);
+                pxlcam::luma::extractRow(srcRow, step, scratch, w);
+                gray = scratch;
+                sw.mark = lapUs(t, CaptureStage::Gray, sw.mark);
+            }
+            writeSpan(layout, row, gray, 0, y, w, mode, stats);
+            sw.mark = lapUs(t, CaptureStage::Stylize, sw.mark);
+        }
+    }
+    
+    if (sw.post) {
+        const bool finished = finishPost(*sw.post);
+        sw.mark = lapUs(t, CaptureStage::PostProcess, sw.mark);
+        if (!finished) {
+            return CaptureResult::ProcessingError;
+        }
+    }
+    
+    // Last (possibly partial) strip
+    if (!flushStrip(sw, h - sw.stripY)) {
+        return CaptureResult::ProcessingError;
+    }
+    length = layout.totalSize;
+    if (sw.png) {
+        const bool finished = sw.png->finish();
+        lapUs(t, CaptureStage::Encode, sw.mark);
+        if (!finished) {
+            return CaptureResult::ProcessingError;
+        }
+        length = sw.png->bytesWritten();
+    }
+    if (sw.thumb && finishThumbnail(*sw.thumb, sw.thumb->pages)) {
+        thumbnail = sw.thumb->pages;
+    }
+    finishStats(stats);
+    return CaptureResult::Success;
+}
+
+//==============================================================================
+// Pipelined Capture Engine (producer core → consumer core)
+//==============================================================================
+
+#if PXLCAM_CAPTURE_PIPELINED
+
+constexpr uint8_t kPipelineDepth = PXLCAM_CAPTURE_QUEUE_DEPTH;
+constexpr uint8_t kMaxQueuedRequests = 8;
+constexpr uint32_t kCollectTimeoutMs = 5000;
+
+static_assert(kPipelineDepth >= 1, "PXLCAM_CAPTURE_QUEUE_DEPTH must be >= 1");
+
+/// Capture request (caller → producer)
+struct CaptureRequest {
+    uint32_t seq;
+    pxlcam::mode::CaptureMode mode;
+    OutputFormat format;
+};
+
+/// Decoded grayscale frame (producer → consumer)
+struct GrayJob {
+    uint32_t seq;
+    pxlcam::mode::CaptureMode mode;
+    OutputFormat format;
+    CaptureResult status;
+    uint8_t graySlot;
+    uint16_t width;
+    uint16_t height;
+    CaptureTimings timings; ///< fb_get + decode/gray so far
+};
+
+/// Encoded output frame (consumer → caller)
+struct OutputJob {
+    uint32_t seq;
+    OutputFormat format;
+    CaptureResult status;
+    uint8_t outSlot;
+    uint16_t width;
+    uint16_t height;
+    size_t length;
+    bool thumbnail;         ///< The slot holds a thumbnail
+    CaptureTimings timings; ///< All stages except save
+    FrameStats stats;
+};
+
+bool g_pipelineRunning = false;
+TaskHandle_t g_producerTask = nullptr;
+TaskHandle_t g_consumerTask = nullptr;
+pxlcam::png::IndexedPngWriter* g_consumerPngWriter = nullptr;  ///< Own writer: runs beside the caller
+ThumbBuilder* g_consumerThumbBuilder = nullptr;
+PostRows* g_consumerPost = nullptr;
+
+QueueHandle_t g_requestQueue = nullptr;   ///< CaptureRequest
+QueueHandle_t g_freeGrayQueue = nullptr;  ///< uint8_t gray slot index
+QueueHandle_t g_grayQueue = nullptr;      ///< GrayJob
+QueueHandle_t g_freeOutQueue = nullptr;   ///< uint8_t output slot index
+QueueHandle_t g_outQueue = nullptr;       ///< OutputJob
+
+uint8_t* g_graySlots[kPipelineDepth] = {};
+uint8_t* g_outSlots[kPipelineDepth] = {};   ///< [0] aliases g_processedBuffer
+
+// Caller-side bookkeeping (only touched from the capturing thread)
+uint32_t g_nextSeq = 0;       ///< Sequence number of next queued request
+uint32_t g_expectSeq = 0;     ///< Sequence number of next result to hand out
+int16_t g_heldOutSlot = -1;   ///< Output slot lent to caller until releaseFrame()
+
+void producerTask(void*) {
+    CaptureRequest req;
+    for (;;) {
+        if (xQueueReceive(g_requestQueue, &req, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        
+        uint8_t slot = 0;
+        xQueueReceive(g_freeGrayQueue, &slot, portMAX_DELAY);
+        
+        GrayJob job = {};
+        job.seq = req.seq;
+        job.mode = req.mode;
+        job.format = req.format;
+        job.graySlot = slot;
+        
+        const int64_t mark = nowUs();
+        camera_fb_t* fb = grabFrame();
+        lapUs(job.timings, CaptureStage::FbGet, mark);
+        
+        if (!fb) {
+            PXLCAM_LOGE_TAG(kLogTag, "ERRO: esp_camera_fb_get() falhou (seq=%u)", req.seq);
+            job.status = CaptureResult::CameraError;
+        } else {
+            job.status = validateFrame(fb);
+            if (job.status == CaptureResult::Success) {
+                job.status = decodeFrameToGray(fb, g_graySlots[slot], job.timings);
+            }
+            job.width = fb->width;
+            job.height = fb->height;
+            // Hand the frame buffer back right away so the sensor can refill it
+            frames::release(fb);
+        }
+        
+        xQueueSend(g_grayQueue, &job, portMAX_DELAY);
+    }
+}
+
+void consumerTask(void*) {
+    GrayJob job;
+    for (;;) {
+        if (xQueueReceive(g_grayQueue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        
+        uint8_t slot = 0;
+        xQueueReceive(g_freeOutQueue, &slot, portMAX_DELAY);
+        
+        OutputJob out = {};
+        out.seq = job.seq;
+        out.format = job.format;
+        out.status = job.status;
+        out.outSlot = slot;
+        out.width = job.width;
+        out.height = job.height;
+        out.timings = job.timings;
+        
+        if (job.status == CaptureResult::Success) {
+            const OutputLayout layout = frameLayout(job.format, job.mode, job.width, job.height);
+            out.length = stylizeToOutput(g_graySlots[job.graySlot], job.mode, g_outSlots[slot], layout,
+                                         out.timings, out.stats, out.thumbnail,
+                                         g_consumerPngWriter, g_consumerThumbBuilder, g_consumerPost);
+            if (out.length == 0) {
+                out.status = CaptureResult::ProcessingError;
+            }
+            logOutputPixels(g_outSlots[slot], layout, out.length, out.stats);
+        }
+        
+        xQueueSend(g_freeGrayQueue, &job.graySlot, portMAX_DELAY);
+        xQueueSend(g_outQueue, &out, portMAX_DELAY);
+    }
+}
+
+/// Undo a startPipeline() that failed part way: the synchronous path runs
+/// without its tasks, queues or slots
+bool abandonPipeline(size_t allocatedBefore) {
+    TaskHandle_t* const tasks[] = {&g_producerTask, &g_consumerTask};
+    for (TaskHandle_t* task : tasks) {
+        if (*task) {
+            vTaskDelete(*task);
+            *task = nullptr;
+        }
+    }
+    QueueHandle_t* const queues[] = {&g_requestQueue, &g_freeGrayQueue, &g_grayQueue, &g_freeOutQueue, &g_outQueue};
+    for (QueueHandle_t* queue : queues) {
+        if (*queue) {
+            vQueueDelete(*queue);
+            *queue = nullptr;
+        }
+    }
+    for (uint8_t i = 0; i < kPipelineDepth; i++) {
+        if (g_outSlots[i] == g_processedBuffer) {
+            g_outSlots[i] = nullptr;    // Not ours to free
+        }
+        freePsram(&g_outSlots[i]);
+        freePsram(&g_graySlots[i]);
+    }
+    g_allocatedSize = allocatedBefore;
+    return false;
+}
+
+bool startPipeline() {
+    const size_t allocatedBefore = g_allocatedSize;
+    for (uint8_t i = 0; i < kPipelineDepth; i++) {
+        g_outSlots[i] = (i == 0) ? g_processedBuffer : allocatePsram(kOutputSlotSize, "PipelineOut");
+        g_graySlots[i] = allocatePsram(kMaxPixels, "PipelineGray");
+        if (!g_outSlots[i] || !g_graySlots[i]) {
+            return abandonPipeline(allocatedBefore);
+        }
+        g_allocatedSize += kMaxPixels + (i == 0 ? 0 : kOutputSlotSize);
+    }
+    
+    g_requestQueue = xQueueCreate(kMaxQueuedRequests, sizeof(CaptureRequest));
+    g_freeGrayQueue = xQueueCreate(kPipelineDepth, sizeof(uint8_t));
+    g_grayQueue = xQueueCreate(kPipelineDepth, sizeof(GrayJob));
+    g_freeOutQueue = xQueueCreate(kPipelineDepth, sizeof(uint8_t));
+    g_outQueue = xQueueCreate(kPipelineDepth, sizeof(OutputJob));
+    if (!g_requestQueue || !g_freeGrayQueue || !g_grayQueue || !g_freeOutQueue || !g_outQueue) {
+        PXLCAM_LOGE_TAG(kLogTag, "Pipeline: falha ao criar filas");
+        return abandonPipeline(allocatedBefore);
+    }
+    
+    for (uint8_t i = 0; i < kPipelineDepth; i++) {
+        xQueueSend(g_freeGrayQueue, &i, 0);
+        xQueueSend(g_freeOutQueue, &i, 0);
+    }
+    
+    if (xTaskCreatePinnedToCore(producerTask, "cap_producer", PXLCAM_CAPTURE_TASK_STACK,
+                                nullptr, PXLCAM_CAPTURE_TASK_PRIORITY, &g_producerTask,
+                                PXLCAM_CAPTURE_PRODUCER_CORE) != pdPASS ||
+        xTaskCreatePinnedToCore(consumerTask, "cap_consumer", PXLCAM_CAPTURE_TASK_STACK,
+                                nullptr, PXLCAM_CAPTURE_TASK_PRIORITY, &g_consumerTask,
+                                PXLCAM_CAPTURE_CONSUMER_CORE) != pdPASS) {
+        PXLCAM_LOGE_TAG(kLogTag, "Pipeline: falha ao criar tasks");
+        return abandonPipeline(allocatedBefore);
+    }
+    
+    g_pipelineRunning = true;
+    PXLCAM_LOGI_TAG(kLogTag, "Pipeline dual-core ativo (produtor=core%d, consumidor=core%d, profundidade=%u)",
+                    PXLCAM_CAPTURE_PRODUCER_CORE, PXLCAM_CAPTURE_CONSUMER_CORE, kPipelineDepth);
+    return true;
+}
+
+void returnHeldOutputSlot() {
+    if (g_heldOutSlot >= 0) {
+        const uint8_t slot = static_cast<uint8_t>(g_heldOutSlot);
+        xQueueSend(g_freeOutQueue, &slot, portMAX_DELAY);
+        g_heldOutSlot = -1;
+    }
+}
+
+uint8_t queueRequests(pxlcam::mode::CaptureMode mode, OutputFormat format, uint8_t count) {
+    const OutputFormat resolved = resolveFormat(format, mode);
+    
+    uint8_t queued = 0;
+    while (queued < count) {
+        CaptureRequest req = { g_nextSeq, mode, resolved };
+        if (xQueueSend(g_requestQueue, &req, 0) != pdTRUE) {
+            PXLCAM_LOGW_TAG(kLogTag, "Pipeline: fila cheia, %u de %u capturas enfileiradas", queued, count);
+            break;
+        }
+        g_nextSeq++;
+        queued++;
+    }
+    return queued;
+}
+
+CaptureResult collectPipelined(pxlcam::mode::CaptureMode mode, OutputFormat format,
+                               ProcessedImage& outImage) {
+    returnHeldOutputSlot();
+    
+    // Nothing queued ahead: this is a single-shot capture
+    if (g_nextSeq == g_expectSeq && queueRequests(mode, format, 1) == 0) {
+        return CaptureResult::MemoryError;
+    }
+    
+    OutputJob out;
+    for (;;) {
+        if (xQueueReceive(g_outQueue, &out, pdMS_TO_TICKS(kCollectTimeoutMs)) != pdTRUE) {
+            PXLCAM_LOGE_TAG(kLogTag, "Pipeline: timeout aguardando frame (seq=%u)", g_expectSeq);
+            g_expectSeq++;  // Abandon this frame; drop it if it shows up later
+            return CaptureResult::CameraError;
+        }
+        if (static_cast<int32_t>(out.seq - g_expectSeq) >= 0) {
+            break;
+        }
+        // Stale result from an abandoned request
+        xQueueSend(g_freeOutQueue, &out.outSlot, portMAX_DELAY);
+    }
+    g_expectSeq = out.seq + 1;
+    
+    commitTimings(out.timings);
+    g_lastCaptureDuration = out.timings[CaptureStage::FbGet] / 1000;
+    g_lastProcessDuration = processMs(out.timings);
+    
+    if (out.status != CaptureResult::Success) {
+        xQueueSend(g_freeOutQueue, &out.outSlot, portMAX_DELAY);
+        return out.status;
+    }
+    
+    g_heldOutSlot = out.outSlot;
+    
+    outImage.data = g_outSlots[out.outSlot];
+    outImage.length = out.length;
+    outImage.width = out.width;
+    outImage.height = out.height;
+    outImage.isProcessed = true;
+    outImage.extension = getOutputExtension(out.format);
+    outImage.format = out.format;
+    outImage.stats = out.stats;
+    outImage.thumbnail = out.thumbnail ? slotThumbnail(g_outSlots[out.outSlot]) : nullptr;
+    g_lastStats = out.stats;
+    
+    PXLCAM_LOGI_TAG(kLogTag, "Captura completa: %dx%d, %u bytes %s", out.width, out.height,
+                    out.length, getOutputFormatName(out.format));
+    PXLCAM_LOGI_TAG(kLogTag, "Tempos: captura=%ums, processo=%ums", 
+                    g_lastCaptureDuration, g_lastProcessDuration);
+    
+    return CaptureResult::Success;
+}
+
+#endif // PXLCAM_CAPTURE_PIPELINED
+
+#if PXLCAM_CAPTURE_ZSL || (PXLCAM_CAPTURE_BURST && !PXLCAM_STRIP_CAPTURE)
+
+/// Sensor timestamp of a frame, or `fallback` if the driver left it empty
+int64_t frameStampUs(const camera_fb_t* fb, int64_t fallback) {
+    const int64_t stamp = static_cast<int64_t>(fb->timestamp.tv_sec) * 1000000 + fb->timestamp.tv_usec;
+    return stamp != 0 ? stamp : fallback;
+}
+
+#endif
+
+//==============================================================================
+// Zero-Shutter-Lag Ring (frames decoded ahead of the shutter)
+//==============================================================================
+
+#if PXLCAM_CAPTURE_ZSL
+
+constexpr uint8_t kZslDepth = PXLCAM_ZSL_DEPTH;
+constexpr int64_t kZslMaxAgeUs = static_cast<int64_t>(PXLCAM_ZSL_MAX_AGE_MS) * 1000;
+
+static_assert(kZslDepth >= 2, "PXLCAM_ZSL_DEPTH must be >= 2 (one slot refills while one is read)");
+
+/// One decoded frame in the ring
+struct ZslSlot {
+    uint8_t* gray;
+    int64_t stampUs;        ///< Sensor timestamp (esp_timer_get_time() base)
+    uint16_t width;
+    uint16_t height;
+    CaptureTimings timings; ///< fb_get + decode/gray of this frame
+    bool valid;             ///< Holds a complete frame
+    bool reading;           ///< Lent to captureZsl(); never refilled meanwhile
+};
+
+ZslSlot g_zslSlots[kZslDepth] = {};
+SemaphoreHandle_t g_zslLock = nullptr;   ///< Guards slot metadata, not pixels
+TaskHandle_t g_zslTask = nullptr;
+volatile bool g_zslArmed = false;
+uint8_t* g_zslOutput = nullptr;          ///< Stylized output (own buffer when pipelined)
+
+/// Slot to refill: an empty one, else the oldest not being read
+/// Called with g_zslLock held. With kZslDepth >= 2 and a single reader
+/// there is always one.
+int8_t zslRefillSlot() {
+    int8_t victim = -1;
+    for (uint8_t i = 0; i < kZslDepth; i++) {
+        const ZslSlot& slot = g_zslSlots[i];
+        if (slot.reading) continue;
+        if (!slot.valid) return i;
+        if (victim < 0 || slot.stampUs < g_zslSlots[victim].stampUs) {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+/// Valid slot with the timestamp nearest `targetUs`, or -1
+/// Called with g_zslLock held.
+int8_t zslNearestSlot(int64_t targetUs) {
+    int8_t best = -1;
+    int64_t bestDist = 0;
+    for (uint8_t i = 0; i < kZslDepth; i++) {
+        const ZslSlot& slot = g_zslSlots[i];
+        if (!slot.valid) continue;
+        const int64_t dist = llabs(slot.stampUs - targetUs);
+        if (best < 0 || dist < bestDist) {
+            best = i;
+            bestDist = dist;
+        }
+    }
+    return best;
+}
+
+void zslTask(void*) {
+    for (;;) {
+        if (!g_zslArmed) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        
+        CaptureTimings t = {};
+        const int64_t mark = nowUs();
+        camera_fb_t* fb = grabFrame(g_zslConsumer);
+        const int64_t grabbed = lapUs(t, CaptureStage::FbGet, mark);
+        
+        if (fb && checkFrame(fb) == CaptureResult::Success) {
+            xSemaphoreTake(g_zslLock, portMAX_DELAY);
+            const int8_t idx = zslRefillSlot();
+            g_zslSlots[idx].valid = false;
+            xSemaphoreGive(g_zslLock);
+            
+            ZslSlot& slot = g_zslSlots[idx];
+            const bool decoded = decodeFrameToGray(fb, slot.gray, t, false) == CaptureResult::Success;
+            
+            xSemaphoreTake(g_zslLock, portMAX_DELAY);
+            slot.stampUs = frameStampUs(fb, grabbed);
+            slot.width = fb->width;
+            slot.height = fb->height;
+            slot.timings = t;
+            slot.valid = decoded;
+            xSemaphoreGive(g_zslLock);
+        }
+        
+        if (fb) {
+            frames::release(fb);
+        }
+        vTaskDelay(pdMS_TO_TICKS(PXLCAM_ZSL_INTERVAL_MS));
+    }
+}
+
+bool startZsl() {
+    for (uint8_t i = 0; i < kZslDepth; i++) {
+        g_zslSlots[i].gray = allocatePsram(kMaxPixels, "ZslSlot");
+        if (!g_zslSlots[i].gray) {
+            return false;
+        }
+        g_allocatedSize += kMaxPixels;
+    }
+    
+    g_zslOutput = g_processedBuffer;
+#if PXLCAM_CAPTURE_PIPELINED
+    // g_processedBuffer is output slot 0 of the running pipeline
+    if (g_pipelineRunning) {
+        g_zslOutput = allocatePsram(kOutputSlotSize, "ZslOutput");
+        if (!g_zslOutput) {
+            return false;
+        }
+        g_allocatedSize += kOutputSlotSize;
+    }
+#endif
+    
+    g_zslLock = xSemaphoreCreateMutex();
+    if (!g_zslLock) {
+        PXLCAM_LOGE_TAG(kLogTag, "ZSL: falha ao criar mutex");
+        return false;
+    }
+    
+    g_zslArmed = true;
+    if (xTaskCreatePinnedToCore(zslTask, "cap_zsl", PXLCAM_CAPTURE_TASK_STACK,
+                                nullptr, PXLCAM_ZSL_TASK_PRIORITY, &g_zslTask,
+                                PXLCAM_ZSL_CORE) != pdPASS) {
+        PXLCAM_LOGE_TAG(kLogTag, "ZSL: falha ao criar task");
+        g_zslTask = nullptr;
+        g_zslArmed = false;
+        return false;
+    }
+    
+    PXLCAM_LOGI_TAG(kLogTag, "ZSL ativo (core%d, %u frames, a cada %dms)",
+                    PXLCAM_ZSL_CORE, kZslDepth, PXLCAM_ZSL_INTERVAL_MS);
+    return true;
+}
+
+#endif // PXLCAM_CAPTURE_ZSL
+
+//==============================================================================
+// Burst Ring (frames grabbed now, developed later)
+//==============================================================================
+
+#if PXLCAM_CAPTURE_BURST && !PXLCAM_STRIP_CAPTURE
+
+constexpr uint8_t kBurstDepth = PXLCAM_BURST_DEPTH;
+
+/// Grabs that may fail in a row before a burst gives up
+constexpr uint8_t kBurstMaxFailures = 3;
+
+static_assert(kBurstDepth >= 1, "PXLCAM_BURST_DEPTH must be >= 1");
+
+/// One grabbed frame; its luma is frame i of g_burstRing
+struct BurstFrame {
+    int64_t stampUs;        ///< Sensor timestamp (esp_timer_get_time() base)
+    uint16_t width;
+    uint16_t height;
+    CaptureTimings timings; ///< fb_get + decode/gray of this frame
+};
+
+uint8_t* g_burstRing = nullptr;          ///< count * kMaxPixels luma, for the burst only
+uint8_t* g_burstOutput = nullptr;        ///< Stylized output (own buffer when pipelined)
+BurstFrame g_burstFrames[kBurstDepth] = {};
+uint8_t g_burstCount = 0;                ///< Frames grabbed
+uint8_t g_burstNext = 0;                 ///< Next frame to develop
+
+#endif // PXLCAM_CAPTURE_BURST
+
+//==============================================================================
+// Night Stacking (several frames averaged into one)
+//==============================================================================
+
+#if PXLCAM_NIGHT_STACK_FRAMES > 1 && !PXLCAM_STRIP_CAPTURE
+
+constexpr uint8_t kStackFrames = PXLCAM_NIGHT_STACK_FRAMES;
+
+static_assert(kStackFrames <= pxlcam::stack::kMaxFrames, "PXLCAM_NIGHT_STACK_FRAMES too large");
+static_assert(pxlcam::stack::kMaxPixels >= kMaxPixels, "Stacker smaller than the capture frame");
+
+pxlcam::stack::FrameStacker g_stacker;
+pxlcam::arena::Lease<uint16_t> g_stackAccLease;
+pxlcam::arena::Lease<uint8_t> g_stackGrayLease;
+uint16_t* g_stackAccHeap = nullptr;      ///< Fallback when the arena has no room, kept
+uint8_t* g_stackGrayHeap = nullptr;
+
+/// Accumulator and frame buffer for one stacked capture
+bool stackBuffers(uint16_t*& acc, uint8_t*& gray) {
+    acc = g_stackAccHeap;
+    if (!acc && g_stackAccLease.acquire(pxlcam::arena::Phase::Capture, kMaxPixels, "StackAcc")) {
+        acc = g_stackAccLease.get();
+    }
+    if (!acc) {
+        g_stackAccHeap = reinterpret_cast<uint16_t*>(allocateHeap(kMaxPixels * sizeof(uint16_t), "StackAcc"));
+        acc = g_stackAccHeap;
+    }
+    
+    gray = g_stackGrayHeap;
+    if (!gray && g_stackGrayLease.acquire(pxlcam::arena::Phase::Capture, kMaxPixels, "StackGray")) {
+        gray = g_stackGrayLease.get();
+    }
+    if (!gray) {
+        g_stackGrayHeap = allocateHeap(kMaxPixels, "StackGray");
+        gray = g_stackGrayHeap;
+    }
+    return acc && gray;
+}
+
+/// Night capture: kStackFrames frames, aligned and averaged, then stylized
+/// The output goes to g_processedBuffer, or to an output slot held from the
+/// running pipeline (returned by releaseFrame()).
+CaptureResult captureStacked(pxlcam::mode::CaptureMode mode, OutputFormat format,
+                             ProcessedImage& outImage) {
+    uint16_t* acc = nullptr;
+    uint8_t* gray = nullptr;
+    if (!stackBuffers(acc, gray)) {
+        return CaptureResult::MemoryError;
+    }
+    
+    uint8_t* out = g_processedBuffer;
+#if PXLCAM_CAPTURE_PIPELINED
+    if (g_pipelineRunning) {
+        uint8_t slot = 0;
+        if (xQueueReceive(g_freeOutQueue, &slot, pdMS_TO_TICKS(kCollectTimeoutMs)) != pdTRUE) {
+            PXLCAM_LOGE_TAG(kLogTag, "Empilhamento: nenhum slot de saida livre");
+            return CaptureResult::MemoryError;
+        }
+        g_heldOutSlot = slot;
+        out = g_outSlots[slot];
+    }
+#endif
+    
+#if PXLCAM_CAPTURE_ZSL
+    // The ring filler would take frames out of the stack
+    const bool zslArmed = g_zslTask && g_zslArmed;
+    setZslArmed(false);
+#endif
+    
+    PXLCAM_LOGI_TAG(kLogTag, "Capturando %u frames para empilhar (modo: %s)...",
+                    kStackFrames, pxlcam::mode::getModeName(mode));
+    
+    CaptureTimings timings = {};
+    CaptureResult result = CaptureResult::Success;
+    int w = 0;
+    int h = 0;
+    for (uint8_t i = 0; i < kStackFrames; i++) {
+        const int64_t captureStart = nowUs();
+        camera_fb_t* fb = grabFrame();
+        lapUs(timings, CaptureStage::FbGet, captureStart);
+        if (!fb) {
+            PXLCAM_LOGE_TAG(kLogTag, "ERRO: esp_camera_fb_get() falhou (frame %u)", i + 1);
+            result = CaptureResult::CameraError;
+            break;
+        }
+        
+        if (i == 0) {
+            result = validateFrame(fb);
+            w = fb->width;
+            h = fb->height;
+            if (result == CaptureResult::Success &&
+                !g_stacker.begin(acc, w, h, PXLCAM_NIGHT_STACK_ALIGN)) {
+                result = CaptureResult::MemoryError;
+            }
+        } else if (static_cast<int>(fb->width) != w || static_cast<int>(fb->height) != h) {
+            result = CaptureResult::ProcessingError;
+        }
+        if (result == CaptureResult::Success) {
+            // Decoded while the DMA already fills the next frame
+            result = decodeFrameToGray(fb, gray, timings, false, false);
+        }
+        frames::release(fb);
+        if (result != CaptureResult::Success) {
+            break;
+        }
+        
+        const int64_t mark = nowUs();
+        g_stacker.add(gray);
+        lapUs(timings, CaptureStage::Gray, mark);
+    }
+    
+#if PXLCAM_CAPTURE_ZSL
+    setZslArmed(zslArmed);
+#endif
+    
+    g_lastCaptureDuration = timings[CaptureStage::FbGet] / 1000;
+    
+    // A frame lost midway still leaves a (shorter) stack
+    if (g_stacker.getFrames() == 0) {
+        return result;
+    }
+    if (result != CaptureResult::Success) {
+        PXLCAM_LOGW_TAG(kLogTag, "Empilhamento parcial: %u/%u frames", g_stacker.getFrames(), kStackFrames);
+    }
+    
+    const int64_t mark = nowUs();
+    g_stacker.finish(gray);
+    lapUs(timings, CaptureStage::Gray, mark);
+    PXLCAM_LOGI_TAG(kLogTag, "Empilhados %u frames (deslocamento max %upx)",
+                    g_stacker.getFrames(), g_stacker.getMaxShift());
+    
+    const OutputLayout layout = frameLayout(format, mode, w, h);
+    bool thumbnail = false;
+    const size_t length = stylizeToOutput(gray, mode, out, layout, timings, g_lastStats, thumbnail);
+    if (length == 0) {
+        return CaptureResult::ProcessingError;
+    }
+    
+    commitTimings(timings);
+    g_lastProcessDuration = processMs(timings);
+    logOutputPixels(out, layout, length, g_lastStats);
+    
+    outImage.data = out;
+    outImage.length = length;
+    outImage.width = layout.width;
+    outImage.height = layout.height;
+    outImage.isProcessed = true;
+    outImage.extension = getOutputExtension(layout.format);
+    outImage.format = layout.format;
+    outImage.stats = g_lastStats;
+    outImage.thumbnail = thumbnail ? slotThumbnail(out) : nullptr;
+    
+    PXLCAM_LOGI_TAG(kLogTag, "Captura completa: %dx%d, %u bytes %s", layout.width, layout.height,
+                    length, getOutputFormatName(layout.format));
+    PXLCAM_LOGI_TAG(kLogTag, "Tempos: captura=%ums, processo=%ums", 
+                    g_lastCaptureDuration, g_lastProcessDuration);
+    
+    return CaptureResult::Success;
+}
+
+#endif // PXLCAM_NIGHT_STACK_FRAMES
+
+}  // anonymous namespace
+
+//==============================================================================
+// Public API
+//==============================================================================
+
+bool init() {
+    if (g_initialized) {
+        return true;
+    }
+    
+    // Allocate processing buffer (for BMP output)
+    g_processedBuffer = allocatePsram(kOutputSlotSize, "ProcessBuffer");
+    if (!g_processedBuffer) {
+        return false;
+    }
+    
+    g_allocatedSize = kOutputSlotSize;
+    
+    // Built up front: stylize kernels may run on the pipeline tasks
+    buildNightLut();
+    buildGameBoyWords();
+    pxlcam::placement::note("NightLut", g_nightLut, sizeof(g_nightLut));
+    pxlcam::placement::note("CaptureBayer8x8", kBayer8x8, sizeof(kBayer8x8));
+    pxlcam::placement::note("GameBoyWords", g_gameBoyWords, sizeof(g_gameBoyWords));
+    pxlcam::placement::note("stylizeSpan", reinterpret_cast<const void*>(&stylizeSpan), 0);
+    g_captureConsumer = frames::registerConsumer("capture", frames::Need::NextFull);
+#if PXLCAM_CAPTURE_ZSL && !PXLCAM_STRIP_CAPTURE
+    g_zslConsumer = frames::registerConsumer("zsl", frames::Need::Latest);
+#endif
+    g_initialized = true;
+    
+#if PXLCAM_CAPTURE_PIPELINED
+    if (!startPipeline()) {
+        // Synchronous path still works with the buffers above
+        PXLCAM_LOGW_TAG(kLogTag, "Pipeline dual-core indisponivel, usando captura sincrona");
+    }
+#endif
+    
+#if PXLCAM_CAPTURE_ZSL && !PXLCAM_STRIP_CAPTURE
+    if (!startZsl()) {
+        // captureZsl() falls back to a fresh capture
+        PXLCAM_LOGW_TAG(kLogTag, "ZSL indisponivel, captura no disparo");
+    }
+#endif
+    
+    PXLCAM_LOGI_TAG(kLogTag, "Pipeline inicializado (total: %u KB)", g_allocatedSize / 1024);
+    return true;
+}
+
+bool isReady() {
+    return g_initialized && g_processedBuffer;
+}
+
+#if PXLCAM_CAPTURE_PIPELINED
+
+bool isPipelineRunning() {
+    return g_pipelineRunning;
+}
+
+uint8_t queueCaptures(pxlcam::mode::CaptureMode mode, uint8_t count) {
+    if (!g_pipelineRunning) {
+        return 0;
+    }
+    return queueRequests(mode, g_outputFormat, count);
+}
+
+uint8_t getPendingCaptures() {
+    return static_cast<uint8_t>(g_nextSeq - g_expectSeq);
+}
+
+#endif // PXLCAM_CAPTURE_PIPELINED
+
+#if PXLCAM_CAPTURE_ZSL
+
+bool isZslRunning() {
+    return g_zslTask != nullptr;
+}
+
+void setZslArmed(bool armed) {
+    if (!g_zslTask) {
+        return;
+    }
+    g_zslArmed = armed;
+    if (armed) {
+        xTaskNotifyGive(g_zslTask);
+    }
+}
+
+uint8_t getZslFrameCount() {
+    if (!g_zslTask) {
+        return 0;
+    }
+    uint8_t count = 0;
+    xSemaphoreTake(g_zslLock, portMAX_DELAY);
+    for (uint8_t i = 0; i < kZslDepth; i++) {
+        count += g_zslSlots[i].valid ? 1 : 0;
+    }
+    xSemaphoreGive(g_zslLock);
+    return count;
+}
+
+CaptureResult captureZsl(pxlcam::mode::CaptureMode mode, int64_t pressUs, ProcessedImage& outImage) {
+    if (!g_zslTask) {
+        return captureWithMode(mode, outImage);
+    }
+    
+    xSemaphoreTake(g_zslLock, portMAX_DELAY);
+    const int8_t idx = zslNearestSlot(pressUs);
+    const bool usable = idx >= 0 && llabs(g_zslSlots[idx].stampUs - pressUs) <= kZslMaxAgeUs;
+    if (usable) {
+        g_zslSlots[idx].reading = true;
+    }
+    xSemaphoreGive(g_zslLock);
+    
+    if (!usable) {
+        PXLCAM_LOGW_TAG(kLogTag, "ZSL: nenhum frame a menos de %dms do disparo, capturando agora",
+                        PXLCAM_ZSL_MAX_AGE_MS);
+        return captureWithMode(mode, outImage);
+    }
+    
+    // Release any previous frame
+    releaseFrame();
+    outImage = { nullptr, 0, 0, 0, false, "bmp", OutputFormat::Bmp8, {}, nullptr };
+    
+    ZslSlot& slot = g_zslSlots[idx];
+    PXLCAM_LOGI_TAG(kLogTag, "Captura ZSL (modo: %s): frame %dx%d de %+ldms em relacao ao disparo",
+                    pxlcam::mode::getModeName(mode), slot.width, slot.height,
+                    static_cast<long>((slot.stampUs - pressUs) / 1000));
+    
+    // The shutter never waited on the sensor; decode cost was paid while idle
+    CaptureTimings timings = slot.timings;
+    timings[CaptureStage::FbGet] = 0;
+    g_lastCaptureDuration = 0;
+    
+    const OutputLayout layout = frameLayout(g_outputFormat, mode, slot.width, slot.height);
+    bool thumbnail = false;
+    const size_t length = stylizeToOutput(slot.gray, mode, g_zslOutput, layout, timings, g_lastStats, thumbnail);
+    
+    xSemaphoreTake(g_zslLock, portMAX_DELAY);
+    slot.reading = false;
+    xSemaphoreGive(g_zslLock);
+    
+    if (length == 0) {
+        return CaptureResult::ProcessingError;
+    }
     
-    // Header sizes
-    const size_t headerSize = sizeof(BmpFileHeader) + sizeof(BmpInfoHeader);
-    const size_t paletteSize = 256 * 4;  // RGBX for each grayscale level
-    const size_t pixelSize = paddedRow * h;
-    const size_t totalSize = headerSize + paletteSize + pixelSize;
+    commitTimings(timings);
+    g_lastProcessDuration = processMs(timings);
+    logOutputPixels(g_zslOutput, layout, length, g_lastStats);
     
-    outLength = totalSize;
+    outImage.data = g_zslOutput;
+    outImage.length = length;
+    outImage.width = layout.width;
+    outImage.height = layout.height;
+    outImage.isProcessed = true;
+    outImage.extension = getOutputExtension(layout.format);
+    outImage.format = layout.format;
+    outImage.stats = g_lastStats;
+    outImage.thumbnail = thumbnail ? slotThumbnail(g_zslOutput) : nullptr;
     
-    // File header
-    BmpFileHeader* fileHdr = reinterpret_cast<BmpFileHeader*>(outBmp);
-    fileHdr->type = 0x4D42;  // "BM"
-    fileHdr->size = totalSize;
-    fileHdr->reserved1 = 0;
-    fileHdr->reserved2 = 0;
-    fileHdr->offBits = headerSize + paletteSize;
+    PXLCAM_LOGI_TAG(kLogTag, "Captura completa: %dx%d, %u bytes %s", layout.width, layout.height,
+                    length, getOutputFormatName(layout.format));
+    PXLCAM_LOGI_TAG(kLogTag, "Tempos: captura=%ums, processo=%ums", 
+                    g_lastCaptureDuration, g_lastProcessDuration);
     
-    // Info header
-    BmpInfoHeader* infoHdr = reinterpret_cast<BmpInfoHeader*>(outBmp + sizeof(BmpFileHeader));
-    infoHdr->size = sizeof(BmpInfoHeader);
-    infoHdr->width = w;
-    infoHdr->height = -h;  // Negative = top-down (no flip needed)
-    infoHdr->planes = 1;
-    infoHdr->bitCount = 8;
-    infoHdr->compression = 0;
-    infoHdr->sizeImage = pixelSize;
-    infoHdr->xPelsPerMeter = 2835;  // 72 DPI
-    infoHdr->yPelsPerMeter = 2835;
-    infoHdr->clrUsed = 256;
-    infoHdr->clrImportant = 256;
+    return CaptureResult::Success;
+}
+
+#endif // PXLCAM_CAPTURE_ZSL
+
+#if PXLCAM_CAPTURE_BURST && !PXLCAM_STRIP_CAPTURE
+
+uint8_t captureBurst(uint8_t count, uint16_t intervalMs, BurstProgress progress, void* user) {
+    releaseBurst();
+    if (!g_initialized) {
+        return 0;
+    }
+    if (count > kBurstDepth) {
+        count = kBurstDepth;
+    }
+    if (count == 0) {
+        return 0;
+    }
     
-    // Grayscale palette (256 entries)
-    uint8_t* palette = outBmp + headerSize;
-    for (int i = 0; i < 256; i++) {
-        palette[i * 4 + 0] = i;  // Blue
-        palette[i * 4 + 1] = i;  // Green
-        palette[i * 4 + 2] = i;  // Red
-        palette[i * 4 + 3] = 0;  // Reserved
+    // Held for this burst only: the PSRAM heap, not the arena
+    g_burstRing = allocateHeap(static_cast<size_t>(count) * kMaxPixels, "BurstRing");
+    if (!g_burstRing) {
+        return 0;
+    }
+    g_burstOutput = g_processedBuffer;
+#if PXLCAM_CAPTURE_PIPELINED
+    // g_processedBuffer is output slot 0 of the running pipeline
+    if (g_pipelineRunning) {
+        g_burstOutput = allocateHeap(kOutputSlotSize, "BurstOutput");
+        if (!g_burstOutput) {
+            releaseBurst();
+            return 0;
+        }
     }
+#endif
     
-    // Pixel data (with padding)
-    uint8_t* pixels = outBmp + headerSize + paletteSize;
-    for (int y = 0; y < h; y++) {
-        memcpy(pixels + y * paddedRow, gray + y * w, w);
-        // Clear padding bytes
-        if (padding > 0) {
-            memset(pixels + y * paddedRow + w, 0, padding);
+#if PXLCAM_CAPTURE_ZSL
+    // The ring filler would take every other frame
+    const bool zslArmed = g_zslTask && g_zslArmed;
+    setZslArmed(false);
+#endif
+    
+    PXLCAM_LOGI_TAG(kLogTag, "Burst: %u frames, intervalo %ums", count, intervalMs);
+    
+    // Frames on a fixed grid from the first one; a slow grab does not push the rest back
+    const int64_t startUs = nowUs();
+    uint8_t failures = 0;
+    while (g_burstCount < count && failures < kBurstMaxFailures) {
+        const int64_t dueUs = startUs + static_cast<int64_t>(g_burstCount) * intervalMs * 1000;
+        const int64_t waitUs = dueUs - nowUs();
+        if (waitUs > 0) {
+            vTaskDelay(pdMS_TO_TICKS(waitUs / 1000));
+        }
+        
+        CaptureTimings t = {};
+        const int64_t mark = nowUs();
+        camera_fb_t* fb = grabFrame();
+        const int64_t grabbed = lapUs(t, CaptureStage::FbGet, mark);
+        
+        // Only the decode to luma here; the DMA fills the next buffer meanwhile
+        uint8_t* gray = g_burstRing + static_cast<size_t>(g_burstCount) * kMaxPixels;
+        if (fb && checkFrame(fb) == CaptureResult::Success &&
+            decodeFrameToGray(fb, gray, t, false) == CaptureResult::Success) {
+            BurstFrame& frame = g_burstFrames[g_burstCount];
+            frame.stampUs = frameStampUs(fb, grabbed);
+            frame.width = fb->width;
+            frame.height = fb->height;
+            frame.timings = t;
+            g_burstCount++;
+            failures = 0;
+        } else {
+            failures++;
+        }
+        
+        if (fb) {
+            frames::release(fb);
+        }
+        if (progress) {
+            progress(g_burstCount, count, user);
         }
     }
     
-    return true;
+#if PXLCAM_CAPTURE_ZSL
+    setZslArmed(zslArmed);
+#endif
+    
+    if (g_burstCount == 0) {
+        PXLCAM_LOGE_TAG(kLogTag, "Burst: nenhum frame capturado");
+        releaseBurst();
+        return 0;
+    }
+    
+    const int64_t spanUs = g_burstFrames[g_burstCount - 1].stampUs - g_burstFrames[0].stampUs;
+    PXLCAM_LOGI_TAG(kLogTag, "Burst: %u/%u frames em %ldms (%.1f fps)", g_burstCount, count,
+                    static_cast<long>(spanUs / 1000),
+                    spanUs > 0 ? (g_burstCount - 1) * 1e6f / spanUs : 0.0f);
+    return g_burstCount;
 }
 
-}  // anonymous namespace
-
-//==============================================================================
-// Public API
-//==============================================================================
+uint8_t getBurstPending() {
+    return static_cast<uint8_t>(g_burstCount - g_burstNext);
+}
 
-bool init() {
-    if (g_initialized) {
-        return true;
+CaptureResult developBurstFrame(pxlcam::mode::CaptureMode mode, ProcessedImage& outImage) {
+    if (g_burstNext >= g_burstCount) {
+        return CaptureResult::CameraError;
     }
     
-    // Allocate processing buffer (for BMP output)
-    g_processedBuffer = allocatePsram(kMaxBmpSize, "ProcessBuffer");
-    if (!g_processedBuffer) {
-        return false;
+    // Release any previous frame
+    releaseFrame();
+    outImage = { nullptr, 0, 0, 0, false, "bmp", OutputFormat::Bmp8, {}, nullptr };
+    
+    const uint8_t index = g_burstNext++;
+    const BurstFrame& frame = g_burstFrames[index];
+    const uint8_t* gray = g_burstRing + static_cast<size_t>(index) * kMaxPixels;
+    PXLCAM_LOGI_TAG(kLogTag, "Burst: revelando frame %u/%u (modo: %s), %+ldms do primeiro",
+                    index + 1, g_burstCount, pxlcam::mode::getModeName(mode),
+                    static_cast<long>((frame.stampUs - g_burstFrames[0].stampUs) / 1000));
+    
+    // The sensor wait and decode were paid during the burst
+    CaptureTimings timings = frame.timings;
+    g_lastCaptureDuration = (timings[CaptureStage::FbGet] + 500) / 1000;
+    
+    const OutputLayout layout = frameLayout(g_outputFormat, mode, frame.width, frame.height);
+    bool thumbnail = false;
+    const size_t length = stylizeToOutput(gray, mode, g_burstOutput, layout, timings, g_lastStats, thumbnail);
+    if (length == 0) {
+        return CaptureResult::ProcessingError;
     }
     
-    // Allocate temp RGB buffer (for JPEG decode)
-    g_tempRgbBuffer = allocatePsram(kMaxRgbSize, "TempRgbBuffer");
-    if (!g_tempRgbBuffer) {
-        freePsram(&g_processedBuffer);
-        return false;
-    }
+    commitTimings(timings);
+    g_lastProcessDuration = processMs(timings);
+    logOutputPixels(g_burstOutput, layout, length, g_lastStats);
     
-    g_allocatedSize = kMaxBmpSize + kMaxRgbSize;
-    g_initialized = true;
+    outImage.data = g_burstOutput;
+    outImage.length = length;
+    outImage.width = layout.width;
+    outImage.height = layout.height;
+    outImage.isProcessed = true;
+    outImage.extension = getOutputExtension(layout.format);
+    outImage.format = layout.format;
+    outImage.stats = g_lastStats;
+    outImage.thumbnail = thumbnail ? slotThumbnail(g_burstOutput) : nullptr;
     
-    PXLCAM_LOGI_TAG(kLogTag, "Pipeline inicializado (total: %u KB)", g_allocatedSize / 1024);
-    return true;
+    PXLCAM_LOGI_TAG(kLogTag, "Captura completa: %dx%d, %u bytes %s", layout.width, layout.height,
+                    length, getOutputFormatName(layout.format));
+    return CaptureResult::Success;
 }
 
-bool isReady() {
-    return g_initialized && g_processedBuffer && g_tempRgbBuffer;
+void releaseBurst() {
+    if (g_burstOutput != g_processedBuffer) {
+        freePsram(&g_burstOutput);
+    }
+    g_burstOutput = nullptr;
+    freePsram(&g_burstRing);
+    g_burstCount = 0;
+    g_burstNext = 0;
 }
 
+#endif // PXLCAM_CAPTURE_BURST
+
 CaptureResult captureFrame(ProcessedImage& outImage) {
     return captureWithMode(pxlcam::mode::getCurrentMode(), outImage);
 }
 
 CaptureResult captureWithMode(pxlcam::mode::CaptureMode mode, ProcessedImage& outImage) {
+    return captureWithMode(mode, g_outputFormat, outImage);
+}
+
+CaptureResult captureWithMode(pxlcam::mode::CaptureMode mode, OutputFormat format,
+                              ProcessedImage& outImage) {
     // Clear output
-    outImage = { nullptr, 0, 0, 0, false, "bmp" };
+    outImage = { nullptr, 0, 0, 0, false, "bmp", OutputFormat::Bmp8, {}, nullptr };
     
     if (!g_initialized && !init()) {
         PXLCAM_LOGE_TAG(kLogTag, "Pipeline nao inicializado");
         return CaptureResult::MemoryError;
     }
     
+#if PXLCAM_NIGHT_STACK_FRAMES > 1 && !PXLCAM_STRIP_CAPTURE
+    // Night stacks its own frames; captures already queued ahead come first
+    if (mode == pxlcam::mode::CaptureMode::Night
+#if PXLCAM_CAPTURE_PIPELINED
+        && (!g_pipelineRunning || g_nextSeq == g_expectSeq)
+#endif
+        ) {
+        releaseFrame();
+        return captureStacked(mode, format, outImage);
+    }
+#endif
+    
+#if PXLCAM_CAPTURE_PIPELINED
+    if (g_pipelineRunning) {
+        return collectPipelined(mode, format, outImage);
+    }
+#endif
+    
     // Release any previous frame
     releaseFrame();
     
@@ -349,9 +2962,11 @@ CaptureResult captureWithMode(pxlcam::mode::CaptureMode mode, ProcessedImage& ou
     PXLCAM_LOGI_TAG(kLogTag, "Capturando frame (modo: %s)...", 
                     pxlcam::mode::getModeName(mode));
     
-    uint32_t captureStart = millis();
-    g_activeFrame = esp_camera_fb_get();
-    g_lastCaptureDuration = millis() - captureStart;
+    CaptureTimings timings = {};
+    const int64_t captureStart = nowUs();
+    g_activeFrame = grabFrame();
+    lapUs(timings, CaptureStage::FbGet, captureStart);
+    g_lastCaptureDuration = timings[CaptureStage::FbGet] / 1000;
     
     if (!g_activeFrame) {
         PXLCAM_LOGE_TAG(kLogTag, "ERRO: esp_camera_fb_get() falhou");
@@ -360,115 +2975,141 @@ CaptureResult captureWithMode(pxlcam::mode::CaptureMode mode, ProcessedImage& ou
     
     const int w = g_activeFrame->width;
     const int h = g_activeFrame->height;
-    const size_t pixels = w * h;
-    
-    PXLCAM_LOGI_TAG(kLogTag, "Frame: %dx%d, %u bytes, format=%d", 
-                    w, h, g_activeFrame->len, g_activeFrame->format);
     
-    // Validate dimensions
-    if (w > kMaxWidth || h > kMaxHeight) {
-        PXLCAM_LOGE_TAG(kLogTag, "Frame muito grande: %dx%d (max %dx%d)", w, h, kMaxWidth, kMaxHeight);
-        return CaptureResult::MemoryError;
+    CaptureResult validResult = validateFrame(g_activeFrame);
+    if (validResult != CaptureResult::Success) {
+        return validResult;
     }
     
     //==========================================================================
-    // Step 2: Convert to RGB888 if needed
+    // Step 2-4: Decode → Grayscale → Mode Filter → output rows (fused)
     //==========================================================================
-    uint32_t processStart = millis();
-    uint8_t* rgb888 = nullptr;
-    
-    if (g_activeFrame->format == PIXFORMAT_JPEG) {
-        PXLCAM_LOGI_TAG(kLogTag, "Decodificando JPEG...");
-        
-        if (!fmt2rgb888(g_activeFrame->buf, g_activeFrame->len, 
-                        PIXFORMAT_JPEG, g_tempRgbBuffer)) {
-            PXLCAM_LOGE_TAG(kLogTag, "ERRO: Falha ao decodificar JPEG");
-            return CaptureResult::ProcessingError;
-        }
-        rgb888 = g_tempRgbBuffer;
-    } 
-    else if (g_activeFrame->format == PIXFORMAT_RGB888) {
-        rgb888 = g_activeFrame->buf;
-    } 
-    else {
-        PXLCAM_LOGE_TAG(kLogTag, "Formato nao suportado: %d", g_activeFrame->format);
-        return CaptureResult::ProcessingError;
+    const OutputLayout layout = frameLayout(format, mode, w, h);
+    size_t length = 0;
+    bool thumbnail = false;
+    CaptureResult processResult = captureToOutput(g_activeFrame, mode, g_processedBuffer, layout,
+                                                  timings, g_lastStats, length, thumbnail);
+    if (processResult != CaptureResult::Success) {
+        return processResult;
     }
     
+    commitTimings(timings);
+    g_lastProcessDuration = processMs(timings);
+    
     //==========================================================================
-    // Step 3: Convert to Grayscale
+    // Step 5: Log Histogram & Sample Tones (Debug, on demand)
     //==========================================================================
-    // Use beginning of processedBuffer as grayscale temp
-    uint8_t* grayBuf = g_processedBuffer;
-    
-    PXLCAM_LOGI_TAG(kLogTag, "Convertendo para grayscale...");
-    rgbToGrayscale(rgb888, grayBuf, w, h);
+    logOutputPixels(g_processedBuffer, layout, length, g_lastStats);
     
     //==========================================================================
-    // Step 4: Apply Mode-Specific Filter
+    // Step 7: Return Result
     //==========================================================================
-    switch (mode) {
-        case pxlcam::mode::CaptureMode::GameBoy:
-            PXLCAM_LOGI_TAG(kLogTag, "Aplicando dithering GameBoy (Bayer 8x8)...");
-            applyGameBoyDither(grayBuf, w, h);
-            break;
-            
-        case pxlcam::mode::CaptureMode::Night:
-            PXLCAM_LOGI_TAG(kLogTag, "Aplicando enhance Night (gamma + contraste)...");
-            applyNightEnhance(grayBuf, w, h);
-            break;
-            
-        case pxlcam::mode::CaptureMode::Normal:
-        default:
-            PXLCAM_LOGI_TAG(kLogTag, "Modo Normal - grayscale neutro");
-            // Keep as-is
-            break;
+    outImage.data = g_processedBuffer;
+    outImage.length = length;
+    outImage.width = w;
+    outImage.height = h;
+    outImage.isProcessed = true;
+    outImage.extension = getOutputExtension(layout.format);
+    outImage.format = layout.format;
+    outImage.stats = g_lastStats;
+    outImage.thumbnail = thumbnail ? slotThumbnail(g_processedBuffer) : nullptr;
+    
+    PXLCAM_LOGI_TAG(kLogTag, "Captura completa: %dx%d, %u bytes %s", w, h,
+                    length, getOutputFormatName(layout.format));
+    PXLCAM_LOGI_TAG(kLogTag, "Tempos: captura=%ums, processo=%ums", 
+                    g_lastCaptureDuration, g_lastProcessDuration);
+    
+    return CaptureResult::Success;
+}
+
+CaptureResult captureToFile(pxlcam::mode::CaptureMode mode, OutputFormat format,
+                            const char* path, size_t* outLength, const uint8_t** outThumbnail) {
+    if (outLength) {
+        *outLength = 0;
+    }
+    if (outThumbnail) {
+        *outThumbnail = nullptr;
     }
     
-    //==========================================================================
-    // Step 5: Log Histogram & Sample Tones (Debug)
-    //==========================================================================
-    logHistogram(grayBuf, pixels);
-    logSampleTones(grayBuf, w, h);
+    g_stripBuffer = g_stripHeap;
+    if (!g_stripBuffer && g_stripLease.acquire(pxlcam::arena::Phase::Capture,
+                                               kStripAllocSize, "StripBuffer")) {
+        g_stripBuffer = g_stripLease.get();
+    }
+    if (!g_stripBuffer) {
+        g_stripHeap = allocateHeap(kStripAllocSize, "StripBuffer");
+        g_stripBuffer = g_stripHeap;
+        if (!g_stripBuffer) {
+            return CaptureResult::MemoryError;
+        }
+    }
+    g_stripRowBuf = g_stripBuffer + kStripBufferSize;
     
-    //==========================================================================
-    // Step 6: Encode as BMP
-    //==========================================================================
-    PXLCAM_LOGI_TAG(kLogTag, "Codificando BMP...");
+    // Release any previous frame
+    releaseFrame();
     
-    // Allocate separate BMP buffer after grayscale processing
-    size_t bmpSize = getBmpSize(w, h);
-    uint8_t* bmpBuf = g_processedBuffer + pixels;  // After grayscale data
+    PXLCAM_LOGI_TAG(kLogTag, "Captura em faixas (modo: %s) -> %s", 
+                    pxlcam::mode::getModeName(mode), path);
     
-    // Check buffer space
-    if (pixels + bmpSize > kMaxBmpSize + pixels) {
-        PXLCAM_LOGE_TAG(kLogTag, "Buffer insuficiente para BMP");
-        return CaptureResult::MemoryError;
+    CaptureTimings timings = {};
+    const int64_t captureStart = nowUs();
+    camera_fb_t* fb = grabFrame();
+    lapUs(timings, CaptureStage::FbGet, captureStart);
+    g_lastCaptureDuration = timings[CaptureStage::FbGet] / 1000;
+    
+    if (!fb) {
+        PXLCAM_LOGE_TAG(kLogTag, "ERRO: esp_camera_fb_get() falhou");
+        return CaptureResult::CameraError;
     }
     
-    size_t actualBmpSize = 0;
-    if (!encodeBmpGrayscale(grayBuf, w, h, bmpBuf, actualBmpSize)) {
-        PXLCAM_LOGE_TAG(kLogTag, "ERRO: Falha ao codificar BMP");
+    CaptureResult result = validateFrame(fb, kStripMaxWidth, kStripMaxHeight);
+    if (result != CaptureResult::Success) {
+        frames::release(fb);
+        return result;
+    }
+    
+    // Size known up front: the file is preallocated before the first strip
+    const OutputLayout layout = makeLayout(resolveFormat(format, mode), fb->width, fb->height);
+    int64_t mark = nowUs();
+    if (!pxlcam::storage::beginStream(path, layout.totalSize)) {
+        frames::release(fb);
         return CaptureResult::ProcessingError;
     }
+    lapUs(timings, CaptureStage::Save, mark);
     
-    // Move BMP to start of buffer for cleaner output
-    memmove(g_processedBuffer, bmpBuf, actualBmpSize);
+    size_t length = 0;
+    const uint8_t* thumbnail = nullptr;
+    result = streamFrameStrips(fb, mode, layout, timings, g_lastStats, length, thumbnail);
+    frames::release(fb);
     
-    g_lastProcessDuration = millis() - processStart;
+    mark = nowUs();
+    if (!pxlcam::storage::endStream() && result == CaptureResult::Success) {
+        result = CaptureResult::ProcessingError;
+    }
+    lapUs(timings, CaptureStage::Save, mark);
     
-    //==========================================================================
-    // Step 7: Return Result
-    //==========================================================================
-    outImage.data = g_processedBuffer;
-    outImage.length = actualBmpSize;
-    outImage.width = w;
-    outImage.height = h;
-    outImage.isProcessed = true;
-    outImage.extension = "bmp";
+    if (result != CaptureResult::Success) {
+        return result;
+    }
     
-    PXLCAM_LOGI_TAG(kLogTag, "Captura completa: %dx%d, %u bytes BMP", w, h, actualBmpSize);
-    PXLCAM_LOGI_TAG(kLogTag, "Tempos: captura=%ums, processo=%ums", 
+    commitTimings(timings);
+    g_lastProcessDuration = processMs(timings) + timings[CaptureStage::Save] / 1000;
+    
+#if PXLCAM_CAPTURE_LOG_STATS
+    logFrameStats(g_lastStats);
+#endif
+    
+    if (outLength) {
+        *outLength = length;
+    }
+    if (outThumbnail) {
+        *outThumbnail = thumbnail;
+    }
+    
+    PXLCAM_LOGI_TAG(kLogTag, "Captura completa: %dx%d, %u bytes %s (faixas de %d linhas)",
+                    layout.width, layout.height, length,
+                    getOutputFormatName(layout.format), kStripRows);
+    PXLCAM_LOGI_TAG(kLogTag, "Tempos: captura=%ums, processo+SD=%ums", 
                     g_lastCaptureDuration, g_lastProcessDuration);
     
     return CaptureResult::Success;
@@ -476,9 +3117,14 @@ CaptureResult captureWithMode(pxlcam::mode::CaptureMode mode, ProcessedImage& ou
 
 void releaseFrame() {
     if (g_activeFrame) {
-        esp_camera_fb_return(g_activeFrame);
+        frames::release(g_activeFrame);
         g_activeFrame = nullptr;
     }
+#if PXLCAM_CAPTURE_PIPELINED
+    if (g_pipelineRunning) {
+        returnHeldOutputSlot();
+    }
+#endif
 }
 
 //==============================================================================
@@ -542,8 +3188,59 @@ size_t getBmpSize(int w, int h) {
 }
 
 size_t estimateOutputSize(uint16_t width, uint16_t height, pxlcam::mode::CaptureMode mode) {
-    (void)mode;  // All modes output BMP
-    return getBmpSize(width, height);
+    return frameLayout(g_outputFormat, mode, width, height).totalSize;
+}
+
+//==============================================================================
+// Output Format
+//==============================================================================
+
+void setOutputFormat(OutputFormat format) {
+    if (static_cast<uint8_t>(format) >= static_cast<uint8_t>(OutputFormat::Count)) {
+        return;
+    }
+    g_outputFormat = format;
+    PXLCAM_LOGI_TAG(kLogTag, "Formato de saida: %s", getOutputFormatName(format));
+}
+
+OutputFormat getOutputFormat() {
+    return g_outputFormat;
+}
+
+void setPixelBlock(uint8_t block) {
+    g_pixelBlock = block == 0 ? 1 : block;
+    if (g_pixelBlock > 1 && pxlcam::filter::decodeScaleFor(g_pixelBlock) == JPG_SCALE_NONE) {
+        PXLCAM_LOGW_TAG(kLogTag, "Bloco de pixel %u sem escala no decoder: capturas sem pixelizacao",
+                        static_cast<unsigned>(g_pixelBlock));
+        return;
+    }
+    PXLCAM_LOGI_TAG(kLogTag, "Bloco de pixel: %u", static_cast<unsigned>(g_pixelBlock));
+}
+
+uint8_t getPixelBlock() {
+    return g_pixelBlock;
+}
+
+OutputFormat getEffectiveOutputFormat(pxlcam::mode::CaptureMode mode) {
+    return resolveFormat(g_outputFormat, mode);
+}
+
+const char* getOutputExtension(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::Pxl2: return "pxl";
+        case OutputFormat::Png2: return "png";
+        default:                 return "bmp";
+    }
+}
+
+const char* getOutputFormatName(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::Bmp8: return "BMP 8-bit";
+        case OutputFormat::Bmp4: return "BMP 4-bit";
+        case OutputFormat::Pxl2: return "PXL 2-bit";
+        case OutputFormat::Png2: return "PNG 2-bit";
+        default:                 return "?";
+    }
 }
 
 //==============================================================================
@@ -558,6 +3255,88 @@ uint32_t getLastProcessDuration() {
     return g_lastProcessDuration;
 }
 
+//==============================================================================
+// Stage Profiler
+//==============================================================================
+
+const CaptureTimings& getLastTimings() {
+    return g_lastTimings;
+}
+
+void recordSaveDuration(uint32_t us) {
+    g_lastTimings.totalUs += us - g_lastTimings[CaptureStage::Save];
+    g_lastTimings[CaptureStage::Save] = us;
+    pushStageSample(CaptureStage::Save, us);
+}
+
+bool getStageStats(CaptureStage stage, StageStats& outStats) {
+    outStats = {};
+    if (stage >= CaptureStage::Count) {
+        return false;
+    }
+    
+    const StageWindow& win = g_stageWindows[static_cast<uint8_t>(stage)];
+    if (win.count == 0) {
+        return false;
+    }
+    
+    // Insertion sort of a copy; the window is small and this runs on demand
+    uint32_t sorted[kTimingWindow];
+    uint64_t sum = 0;
+    for (uint8_t i = 0; i < win.count; i++) {
+        const uint32_t v = win.samples[i];
+        sum += v;
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    
+    // Nearest-rank percentile: smallest sample >= 95% of the window
+    const uint16_t p95Rank = (static_cast<uint16_t>(win.count) * 95 + 99) / 100;
+    
+    outStats.minUs = sorted[0];
+    outStats.avgUs = static_cast<uint32_t>(sum / win.count);
+    outStats.p95Us = sorted[p95Rank - 1];
+    outStats.lastUs = win.samples[(win.head + kTimingWindow - 1) % kTimingWindow];
+    outStats.samples = win.count;
+    return true;
+}
+
+void resetStageStats() {
+    memset(g_stageWindows, 0, sizeof(g_stageWindows));
+    g_lastTimings = {};
+}
+
+const char* getStageName(CaptureStage stage) {
+    switch (stage) {
+        case CaptureStage::FbGet:       return "fb_get";
+        case CaptureStage::Decode:      return "decode";
+        case CaptureStage::Gray:        return "gray";
+        case CaptureStage::PostProcess: return "postprocess";
+        case CaptureStage::Stylize:     return "stylize";
+        case CaptureStage::Encode:      return "encode";
+        case CaptureStage::Save:        return "save";
+        default:                        return "?";
+    }
+}
+
+void logStageStats() {
+    PXLCAM_LOGI_TAG(kLogTag, "Etapas (us, janela de %u): total=%u", kTimingWindow, g_lastTimings.totalUs);
+    for (uint8_t i = 0; i < kStageCount; i++) {
+        const CaptureStage stage = static_cast<CaptureStage>(i);
+        StageStats st;
+        if (!getStageStats(stage, st)) {
+            continue;
+        }
+        PXLCAM_LOGI_TAG(kLogTag, "  %-7s ultimo=%u min=%u med=%u p95=%u (n=%u)",
+                        getStageName(stage), g_lastTimings[stage],
+                        st.minUs, st.avgUs, st.p95Us, st.samples);
+    }
+}
+
 const char* getResultMessage(CaptureResult result) {
     switch (result) {
         case CaptureResult::Success:         return "OK";
@@ -573,6 +3352,35 @@ const char* getResultMessage(CaptureResult result) {
 // Debug: Histogram & Tone Analysis
 //==============================================================================
 
+const FrameStats& getLastFrameStats() {
+    return g_lastStats;
+}
+
+void logFrameStats(const FrameStats& stats) {
+    if (stats.pixels == 0) return;
+    
+    // Pairs of 16-level bins give the 8 bars of logHistogram()
+    uint32_t bins[8];
+    uint32_t maxBin = 1;
+    for (int i = 0; i < 8; i++) {
+        bins[i] = stats.histogram[2 * i] + stats.histogram[2 * i + 1];
+        if (bins[i] > maxBin) maxBin = bins[i];
+    }
+    
+    PXLCAM_LOGI_TAG(kLogTag, "=== HISTOGRAMA ===");
+    for (int i = 0; i < 8; i++) {
+        int barLen = (bins[i] * 20) / maxBin;
+        char bar[22];
+        memset(bar, '#', barLen);
+        bar[barLen] = '\0';
+        PXLCAM_LOGI_TAG(kLogTag, "%d-%d: %s (%u)", i * 32, i * 32 + 31, bar, bins[i]);
+    }
+    
+    PXLCAM_LOGI_TAG(kLogTag, "Luma: min=%u max=%u media=%u, clip: %u pretos / %u brancos (%u px)",
+                    stats.minLuma, stats.maxLuma, stats.meanLuma,
+                    stats.clippedLow, stats.clippedHigh, stats.pixels);
+}
+
 void logHistogram(const uint8_t* gray, size_t length) {
     if (!gray || length == 0) return;
     
@@ -603,8 +3411,9 @@ void logHistogram(const uint8_t* gray, size_t length) {
     }
 }
 
-void logSampleTones(const uint8_t* gray, int w, int h) {
+void logSampleTones(const uint8_t* gray, int w, int h, int stride) {
     if (!gray || w <= 0 || h <= 0) return;
+    if (stride < w) stride = w;
     
     // Sample 9 points in a 3x3 grid
     PXLCAM_LOGI_TAG(kLogTag, "=== AMOSTRA TONS ===");
@@ -619,7 +3428,7 @@ void logSampleTones(const uint8_t* gray, int w, int h) {
         
         for (int col = 0; col < 3; col++) {
             int x = xStep * (col + 1);
-            uint8_t val = gray[y * w + x];
+            uint8_t val = gray[y * stride + x];
             char tmp[16];
             snprintf(tmp, sizeof(tmp), "[%3d] ", val);
             strcat(line, tmp);
@@ -716,6 +3525,61 @@ bool applyStylizedCapture(
     return true;
 }
 
+bool applyStylizedFrame(const camera_fb_t* fb, uint8_t* output,
+                        const pxlcam::filters::DitherConfig& config) {
+    using namespace pxlcam::filters;
+    
+    if (!fb || !output) {
+        PXLCAM_LOGE_TAG(kLogTag, "[v1.3] Stylized frame: invalid params");
+        return false;
+    }
+    
+    SourceFormat srcFormat;
+    switch (fb->format) {
+        case PIXFORMAT_GRAYSCALE: srcFormat = SourceFormat::GRAYSCALE; break;
+        case PIXFORMAT_YUV422:    srcFormat = SourceFormat::YUV422;    break;
+        case PIXFORMAT_RGB565:    srcFormat = SourceFormat::RGB565_BE; break;
+        case PIXFORMAT_RGB888:    srcFormat = SourceFormat::RGB888;    break;
+        default:
+            PXLCAM_LOGE_TAG(kLogTag, "[v1.3] Stylized frame: formato %d precisa de decode", fb->format);
+            return false;
+    }
+    
+    if (checkFrame(fb, DITHER_MAX_WIDTH, DITHER_MAX_HEIGHT) != CaptureResult::Success) {
+        return false;
+    }
+    const size_t needed = static_cast<size_t>(fb->width) * fb->height * source_format_bpp(srcFormat);
+    if (fb->len < needed) {
+        PXLCAM_LOGE_TAG(kLogTag, "[v1.3] Stylized frame: truncado (%u < %u)",
+                        static_cast<unsigned>(fb->len), static_cast<unsigned>(needed));
+        return false;
+    }
+    
+    if (!palette_is_initialized()) {
+        palette_init();
+    }
+    if (!dither_is_initialized()) {
+        dither_init();
+    }
+    
+#if PXLCAM_FEATURE_CUSTOM_PALETTES
+    const Palette& palette = palette_current();
+#else
+    const Palette& palette = palette_get(PaletteType::GB_CLASSIC);
+#endif
+    DitherResult result = apply_palette_dither_ex(fb->buf, srcFormat, output,
+                                                  fb->width, fb->height, palette, config);
+    if (!result.success) {
+        PXLCAM_LOGE_TAG(kLogTag, "[v1.3] Dither failed: %s",
+                        result.errorMsg ? result.errorMsg : "unknown");
+        return false;
+    }
+    
+    PXLCAM_LOGI_TAG(kLogTag, "[v1.3] %s direto do frame: %u pixels, %u bytes",
+                    source_format_name(srcFormat), result.processedPixels, result.outputBytes);
+    return true;
+}
+
 /**
  * @brief Initialize v1.3.0 stylized capture subsystem
  * 
@@ -736,9 +3600,9 @@ void initStylizedCapture() {
     dither_init();
     
 #if PXLCAM_FEATURE_CUSTOM_PALETTES
-    // Load custom palettes from SD if available
-    if (palette_load_from_sd()) {
-        PXLCAM_LOGI_TAG(kLogTag, "[v1.3] Custom palettes loaded from SD");
+    // Custom palettes: NVS snapshot unless palettes.json changed
+    if (palette_load_cached()) {
+        PXLCAM_LOGI_TAG(kLogTag, "[v1.3] Custom palettes loaded");
     }
     
     // Log current palette
@@ -5,10 +5,14 @@
 #include <Wire.h>
 #include <esp_log.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <new>
 
+#include "energy_meter.h"
 #include "logging.h"
+#include "trace.h"
 
 namespace pxlcam::display {
 
@@ -21,6 +25,19 @@ Adafruit_SSD1306 *g_display = nullptr;
 DisplayConfig g_activeConfig{};
 bool g_initialized = false;
 
+// Panel contents as last sent; updateDisplay() transfers only what differs
+constexpr size_t kMaxFrameBytes = 128 * 64 / 8;
+static std::uint8_t g_shadow[kMaxFrameBytes];
+bool g_shadowValid = false;
+std::uint16_t g_lastFlushBytes = 0;
+
+// SSD1306 I2C control bytes and transfer size (control byte + payload fits
+// the smallest Wire buffer)
+constexpr std::uint8_t kControlCommands = 0x00;
+constexpr std::uint8_t kControlData = 0x40;
+constexpr size_t kI2cChunk = 32;
+constexpr std::uint32_t kDefaultI2cHz = 400000;
+
 bool ensureDisplayAllocated(const DisplayConfig &config) {
     if (g_display && g_display->width() == static_cast<int16_t>(config.width) &&
         g_display->height() == static_cast<int16_t>(config.height)) {
@@ -41,6 +58,86 @@ void destroyDisplay() {
         g_display->~Adafruit_SSD1306();
         g_display = nullptr;
     }
+    g_shadowValid = false;
+}
+
+size_t frameBytes() {
+    return static_cast<size_t>(g_activeConfig.width) * ((g_activeConfig.height + 7) / 8);
+}
+
+// Whole framebuffer through the driver; the shadow then matches the panel
+void fullRefresh() {
+    g_display->display();
+
+    // The driver drops the bus to 100 kHz after each transfer
+    Wire.setClock(g_activeConfig.i2cFrequencyHz != 0 ? g_activeConfig.i2cFrequencyHz : kDefaultI2cHz);
+
+    const size_t bytes = frameBytes();
+    g_shadowValid = bytes <= sizeof(g_shadow);
+    if (g_shadowValid) {
+        memcpy(g_shadow, g_display->getBuffer(), bytes);
+    }
+    g_lastFlushBytes = static_cast<std::uint16_t>(bytes);
+}
+
+// Columns col0..col1 of one page, sent with page/column addressing
+bool sendWindow(std::uint8_t page, std::uint8_t col0, std::uint8_t col1, const std::uint8_t *data) {
+    const std::uint8_t address = g_activeConfig.i2cAddress;
+
+    Wire.beginTransmission(address);
+    Wire.write(kControlCommands);
+    Wire.write(SSD1306_COLUMNADDR);
+    Wire.write(col0);
+    Wire.write(col1);
+    Wire.write(SSD1306_PAGEADDR);
+    Wire.write(page);
+    Wire.write(page);
+    if (Wire.endTransmission() != 0) {
+        return false;
+    }
+
+    const size_t count = static_cast<size_t>(col1 - col0) + 1;
+    for (size_t off = 0; off < count; off += kI2cChunk - 1) {
+        const size_t len = std::min(count - off, kI2cChunk - 1);
+        Wire.beginTransmission(address);
+        Wire.write(kControlData);
+        Wire.write(data + off, len);
+        if (Wire.endTransmission() != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Send the changed column range of every page that differs from the shadow
+void flushDirty() {
+    const std::uint8_t *frame = g_display->getBuffer();
+    const int width = g_activeConfig.width;
+    const int pages = (g_activeConfig.height + 7) / 8;
+    std::uint16_t sent = 0;
+
+    for (int page = 0; page < pages; page++) {
+        const std::uint8_t *src = frame + page * width;
+        std::uint8_t *shadow = g_shadow + page * width;
+
+        int first = 0;
+        while (first < width && src[first] == shadow[first]) first++;
+        if (first == width) continue;
+        int last = width - 1;
+        while (src[last] == shadow[last]) last--;
+
+        if (!sendWindow(static_cast<std::uint8_t>(page), static_cast<std::uint8_t>(first),
+                        static_cast<std::uint8_t>(last), src + first)) {
+            // Panel state unknown: resend everything next time
+            PXLCAM_LOGW_TAG(kLogTag, "Partial refresh failed on page %d", page);
+            g_shadowValid = false;
+            g_lastFlushBytes = sent;
+            return;
+        }
+        memcpy(shadow + first, src + first, last - first + 1);
+        sent += last - first + 1;
+    }
+    g_lastFlushBytes = sent;
 }
 
 }  // namespace
@@ -75,9 +172,9 @@ bool initDisplay(const DisplayConfig &config) {
     g_display->clearDisplay();
     g_display->setTextColor(SSD1306_WHITE);
     g_display->setTextSize(1);
-    g_display->display();
 
     g_activeConfig = config;
+    fullRefresh();
     g_initialized = true;
 
     PXLCAM_LOGI_TAG(kLogTag, "Display initialized (%ux%u) on SDA=%d SCL=%d", config.width, config.height, config.sdaPin, config.sclPin);
@@ -90,7 +187,7 @@ void clearDisplay() {
     }
 
     g_display->clearDisplay();
-    g_display->display();
+    updateDisplay();
 }
 
 void printDisplay(const char *message, uint8_t textSize, int16_t cursorX, int16_t cursorY, bool clear, bool wrapText) {
@@ -108,7 +205,7 @@ void printDisplay(const char *message, uint8_t textSize, int16_t cursorX, int16_
     g_display->setTextSize(safeSize);
     g_display->setTextColor(SSD1306_WHITE);
     g_display->println(message);
-    g_display->display();
+    updateDisplay();
 }
 
 void shutdownDisplay() {
@@ -118,7 +215,7 @@ void shutdownDisplay() {
 
     g_display->ssd1306_command(SSD1306_DISPLAYOFF);
     g_display->clearDisplay();
-    g_display->display();
+    updateDisplay();
     destroyDisplay();
     g_initialized = false;
 
@@ -136,7 +233,22 @@ void updateDisplay() {
     if (!g_initialized || !g_display) {
         return;
     }
-    g_display->display();
+    pxlcam::energy::Scope energy(pxlcam::energy::PowerState::Display);
+    PXLCAM_TRACE_SPAN(span, Display, 0);
+    if (g_shadowValid) {
+        flushDirty();
+    } else {
+        fullRefresh();
+    }
+    span.setArg(g_lastFlushBytes);
+}
+
+void invalidateDisplay() {
+    g_shadowValid = false;
+}
+
+std::uint16_t getLastFlushBytes() {
+    return g_lastFlushBytes;
 }
 
 void drawGrayscale64x64(const uint8_t *gray64) {
@@ -150,6 +262,25 @@ void drawGrayscale64x64(const uint8_t *gray64) {
     constexpr int16_t offsetX = 32;
     constexpr int16_t offsetY = 0;
 
+    // Page-aligned: build each framebuffer byte from 8 rows, no per-pixel calls
+    uint8_t *pages = getPageBuffer();
+    if (pages && g_display->width() >= offsetX + 64 && g_display->height() >= offsetY + 64) {
+        const int16_t stride = g_display->width();
+        for (int16_t page = 0; page < 8; page++) {
+            const uint8_t *src = gray64 + page * 8 * 64;
+            uint8_t *dst = pages + (page + offsetY / 8) * stride + offsetX;
+            for (int16_t x = 0; x < 64; x++) {
+                uint8_t bits = 0;
+                for (int b = 0; b < 8; b++) {
+                    bits |= static_cast<uint8_t>((src[b * 64 + x] > 128) << b);
+                }
+                dst[x] = bits;
+            }
+        }
+        updateDisplay();
+        return;
+    }
+
     for (int16_t y = 0; y < 64; y++) {
         for (int16_t x = 0; x < 64; x++) {
             uint8_t v = gray64[y * 64 + x];
@@ -158,11 +289,18 @@ void drawGrayscale64x64(const uint8_t *gray64) {
         }
     }
 
-    g_display->display();
+    updateDisplay();
 }
 
 Adafruit_SSD1306* getDisplayPtr() {
     return g_display;
 }
 
+uint8_t* getPageBuffer() {
+    if (!g_initialized || !g_display || g_display->getRotation() != 0) {
+        return nullptr;
+    }
+    return g_display->getBuffer();
+}
+
 }  // namespace pxlcam::display
@@ -159,7 +159,7 @@ void drawMenu(Adafruit_SSD1306* disp) {
     disp->setCursor(2, kHintY);
     disp->print("Tap:nav  Hold:OK");
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 /**
@@ -175,7 +175,7 @@ void performFadeIn(Adafruit_SSD1306* disp) {
     
     // Step 1: Black screen
     disp->clearDisplay();
-    disp->display();
+    pxlcam::display::updateDisplay();
     delay(g_config.fadeDelayMs);
     
     // Step 2: Draw with partial content
@@ -186,7 +186,7 @@ void performFadeIn(Adafruit_SSD1306* disp) {
         disp->setCursor(28, kTitleY);
         disp->print("MODO CAPTURA");
         disp->drawFastHLine(0, kDividerY, kScreenWidth, SSD1306_WHITE);
-        disp->display();
+        pxlcam::display::updateDisplay();
         delay(g_config.fadeDelayMs);
     }
     
@@ -194,7 +194,7 @@ void performFadeIn(Adafruit_SSD1306* disp) {
     if (g_config.fadeSteps >= 3) {
         for (uint8_t i = 0; i < kItemCount; i++) {
             drawItem(disp, i, i == g_currentIndex);
-            disp->display();
+            pxlcam::display::updateDisplay();
             delay(g_config.fadeDelayMs / 2);
         }
     }
@@ -246,7 +246,7 @@ bool handleInput(uint32_t& pressStartMs, bool& wasPressed) {
                 disp->fillRect(2, kHintY, 124, 10, SSD1306_BLACK);
                 disp->setCursor(2, kHintY);
                 disp->print("Selecionando...");
-                disp->display();
+                pxlcam::display::updateDisplay();
             }
         }
     }
@@ -356,7 +356,7 @@ MenuResult showModalAt(uint8_t initialIndex) {
         // Draw checkmark indicator
         disp->setCursor(52, 40);
         disp->print("[OK]");
-        disp->display();
+        pxlcam::display::updateDisplay();
         
         delay(500);
     }
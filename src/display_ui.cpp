@@ -9,6 +9,7 @@
 #include "logging.h"
 
 #include <Adafruit_SSD1306.h>
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
 
@@ -107,7 +108,8 @@ void drawIcon(int16_t x, int16_t y, IconId iconId) {
     }
 }
 
-void drawStatusBar(int fps, bool sdPresent, uint8_t batteryPct, PreviewMode mode) {
+void drawStatusBar(int fps, bool sdPresent, uint8_t batteryPct, PreviewMode mode,
+                   const char* detail) {
     Adafruit_SSD1306* disp = getDisplayPtr();
     if (!disp) return;
     
@@ -133,9 +135,18 @@ void drawStatusBar(int fps, bool sdPresent, uint8_t batteryPct, PreviewMode mode
     disp->setTextSize(1);
     disp->setTextColor(SSD1306_WHITE);
     disp->setCursor(x, 1);
-    disp->print(getModeName(mode)[0]);  // First letter: A/G/N
+    disp->print(getModeName(mode)[0]);  // First letter: A/G/N/B
     x += 10;
     
+    // Mode detail (e.g. "A FS"), up to 3 characters
+    if (detail) {
+        char tag[4];
+        snprintf(tag, sizeof(tag), "%s", detail);
+        disp->setCursor(x - 2, 1);
+        disp->print(tag);
+        x += strlen(tag) * 6;
+    }
+    
     // FPS (right-aligned)
     char buf[8];
     snprintf(buf, sizeof(buf), "%dfps", fps);
@@ -163,6 +174,51 @@ void drawPreviewBitmap(const uint8_t* packedBitmap, int w, int h) {
     }
 }
 
+void drawPreviewPages(const uint8_t* pages, int w, int h) {
+    Adafruit_SSD1306* disp = getDisplayPtr();
+    if (!disp || !pages) return;
+    
+    const int offsetX = UILayout::PreviewX;
+    const int offsetY = UILayout::PreviewY;
+    
+    uint8_t* fb = getPageBuffer();
+    if (!fb) {
+        // Rotated display: let the driver map each pixel
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                const bool pixel = (pages[(y >> 3) * w + x] >> (y & 7)) & 1;
+                disp->drawPixel(offsetX + x, offsetY + y, pixel ? SSD1306_WHITE : SSD1306_BLACK);
+            }
+        }
+        return;
+    }
+    
+    // Source page q lands `shift` rows down: display byte = q << shift | (q - 1) >> (8 - shift).
+    // Rows outside the preview keep their pixels, rows past the panel are clipped.
+    const int dispW = disp->width();
+    const int shift = offsetY & 7;
+    const int srcPages = (h + 7) >> 3;
+    const int cols = std::min(w, dispW - offsetX);
+    const int yEnd = std::min(offsetY + h, static_cast<int>(disp->height()));
+    
+    for (int page = offsetY >> 3; page * 8 < yEnd; ++page) {
+        const int top = std::max(page * 8, offsetY) - page * 8;
+        const int bottom = std::min(page * 8 + 8, yEnd) - page * 8;
+        const uint8_t mask = static_cast<uint8_t>((0xFF << top) & (0xFF >> (8 - bottom)));
+        
+        const int q = page - (offsetY >> 3);
+        const uint8_t* lo = q < srcPages ? pages + q * w : nullptr;
+        const uint8_t* hi = (shift != 0 && q > 0) ? pages + (q - 1) * w : nullptr;
+        uint8_t* dst = fb + page * dispW + offsetX;
+        
+        for (int x = 0; x < cols; ++x) {
+            uint8_t v = lo ? static_cast<uint8_t>(lo[x] << shift) : 0;
+            if (hi) v |= static_cast<uint8_t>(hi[x] >> (8 - shift));
+            dst[x] = static_cast<uint8_t>((dst[x] & ~mask) | (v & mask));
+        }
+    }
+}
+
 void drawPreviewFrame() {
     Adafruit_SSD1306* disp = getDisplayPtr();
     if (!disp) return;
@@ -173,10 +229,8 @@ void drawPreviewFrame() {
 }
 
 void swapDisplayBuffers() {
-    Adafruit_SSD1306* disp = getDisplayPtr();
-    if (disp) {
-        disp->display();
-    }
+    // Sends only the pages/columns that changed since the last frame
+    updateDisplay();
 }
 
 void drawSmallText(int16_t x, int16_t y, const char* text) {
@@ -223,10 +277,11 @@ void refreshFullUI(int fps, bool sdPresent, uint8_t batteryPct, PreviewMode mode
 
 const char* getModeName(PreviewMode mode) {
     switch (mode) {
-        case PreviewMode::Auto:    return "Auto";
-        case PreviewMode::GameBoy: return "GB";
-        case PreviewMode::Night:   return "Night";
-        default:                   return "?";
+        case PreviewMode::Auto:      return "Auto";
+        case PreviewMode::GameBoy:   return "GB";
+        case PreviewMode::Night:     return "Night";
+        case PreviewMode::BlueNoise: return "Blue";
+        default:                     return "?";
     }
 }
 
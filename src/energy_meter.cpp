@@ -0,0 +1,203 @@
+/**
+ * @file energy_meter.cpp
+ * @brief Time per power state and charge estimates
+ */
+
+#include "energy_meter.h"
+
+#include "logging.h"
+#include "pxlcam_config.h"
+
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <sys/time.h>
+
+#include <cstring>
+
+namespace pxlcam::energy {
+
+namespace {
+
+constexpr const char* kLogTag = "energy";
+constexpr uint32_t kLedgerMagic = 0x454E5231;  // "ENR1"
+
+constexpr uint32_t kCurrentUa[kStateCount] = {
+    PXLCAM_POWER_UA_IDLE,
+    PXLCAM_POWER_UA_CAPTURE,
+    PXLCAM_POWER_UA_SAVE,
+    PXLCAM_POWER_UA_DISPLAY,
+    PXLCAM_POWER_UA_LIGHT_SLEEP,
+    PXLCAM_POWER_UA_DEEP_SLEEP,
+};
+
+/// Kept across deep sleep
+struct Ledger {
+    uint32_t magic;
+    uint64_t stateUs[kStateCount];
+    uint64_t radioUs;
+    uint32_t frames;
+    int64_t sleepClockUs;   ///< RTC clock when the deep sleep began
+    bool sleeping;
+};
+
+RTC_DATA_ATTR Ledger g_ledger;
+
+PowerState g_state = PowerState::Idle;
+int64_t g_markUs = 0;       ///< esp_timer time the current state was last charged to
+bool g_radioOn = false;
+int64_t g_radioMarkUs = 0;
+portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/// Survives deep sleep, unlike esp_timer_get_time()
+int64_t rtcClockUs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+/// Charge the time since the last mark; caller holds g_lock
+void chargeTo(Ledger& ledger, int64_t nowUs) {
+    if (nowUs > g_markUs) {
+        ledger.stateUs[static_cast<size_t>(g_state)] += static_cast<uint64_t>(nowUs - g_markUs);
+    }
+    if (g_radioOn && nowUs > g_radioMarkUs) {
+        ledger.radioUs += static_cast<uint64_t>(nowUs - g_radioMarkUs);
+    }
+}
+
+void clearLedger() {
+    memset(&g_ledger, 0, sizeof(g_ledger));
+    g_ledger.magic = kLedgerMagic;
+}
+
+}  // namespace
+
+void begin() {
+    const int64_t sinceBootUs = esp_timer_get_time();
+
+    portENTER_CRITICAL(&g_lock);
+    const bool continued = g_ledger.magic == kLedgerMagic && esp_reset_reason() == ESP_RST_DEEPSLEEP;
+    if (!continued) {
+        clearLedger();
+    } else if (g_ledger.sleeping) {
+        // The RTC clock ran through the sleep and the boot; the boot is awake time
+        const int64_t asleepUs = rtcClockUs() - g_ledger.sleepClockUs - sinceBootUs;
+        if (asleepUs > 0) {
+            g_ledger.stateUs[static_cast<size_t>(PowerState::DeepSleep)] += static_cast<uint64_t>(asleepUs);
+        }
+    }
+    g_ledger.sleeping = false;
+    g_ledger.stateUs[static_cast<size_t>(PowerState::Idle)] += static_cast<uint64_t>(sinceBootUs);
+    g_state = PowerState::Idle;
+    g_markUs = sinceBootUs;
+    g_radioOn = false;
+    portEXIT_CRITICAL(&g_lock);
+
+    PXLCAM_LOGI_TAG(kLogTag, "Energy ledger %s (%lu frames)", continued ? "continued" : "started",
+                    static_cast<unsigned long>(g_ledger.frames));
+}
+
+void setState(PowerState state) {
+    if (state >= PowerState::Count) {
+        return;
+    }
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&g_lock);
+    chargeTo(g_ledger, now);
+    g_markUs = now;
+    g_radioMarkUs = now;
+    g_state = state;
+    portEXIT_CRITICAL(&g_lock);
+}
+
+PowerState currentState() {
+    return g_state;
+}
+
+void setRadioOn(bool on) {
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&g_lock);
+    chargeTo(g_ledger, now);
+    g_markUs = now;
+    g_radioMarkUs = now;
+    g_radioOn = on;
+    portEXIT_CRITICAL(&g_lock);
+}
+
+void noteFrame() {
+    portENTER_CRITICAL(&g_lock);
+    g_ledger.frames++;
+    portEXIT_CRITICAL(&g_lock);
+}
+
+void reset() {
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&g_lock);
+    clearLedger();
+    g_markUs = now;
+    g_radioMarkUs = now;
+    portEXIT_CRITICAL(&g_lock);
+}
+
+void prepareDeepSleep() {
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&g_lock);
+    chargeTo(g_ledger, now);
+    g_markUs = now;
+    g_radioMarkUs = now;
+    g_radioOn = false;
+    g_state = PowerState::DeepSleep;
+    g_ledger.sleeping = true;
+    g_ledger.sleepClockUs = rtcClockUs();
+    portEXIT_CRITICAL(&g_lock);
+}
+
+Report getReport() {
+    const int64_t now = esp_timer_get_time();
+    Ledger ledger;
+    portENTER_CRITICAL(&g_lock);
+    ledger = g_ledger;
+    chargeTo(ledger, now);
+    portEXIT_CRITICAL(&g_lock);
+
+    Report report = {};
+    uint64_t totalUs = 0;
+    uint64_t chargeUaUs = 0;   // µA·µs: 30 days at 240 mA stays far below 2^64
+    for (size_t i = 0; i < kStateCount; i++) {
+        report.stateMs[i] = static_cast<uint32_t>(ledger.stateUs[i] / 1000);
+        totalUs += ledger.stateUs[i];
+        chargeUaUs += ledger.stateUs[i] * kCurrentUa[i];
+    }
+    chargeUaUs += ledger.radioUs * static_cast<uint64_t>(PXLCAM_POWER_UA_WIFI);
+
+    const uint64_t asleepUs = ledger.stateUs[static_cast<size_t>(PowerState::LightSleep)] +
+                              ledger.stateUs[static_cast<size_t>(PowerState::DeepSleep)];
+    report.radioMs = static_cast<uint32_t>(ledger.radioUs / 1000);
+    report.totalMs = static_cast<uint32_t>(totalUs / 1000);
+    report.frames = ledger.frames;
+    report.dutyCycle = totalUs > 0 ? static_cast<float>(totalUs - asleepUs) / static_cast<float>(totalUs) : 0.0f;
+    report.chargeUah = static_cast<uint32_t>(chargeUaUs / 3600000000ull);
+    report.uahPerFrame = ledger.frames > 0 ? report.chargeUah / ledger.frames : 0;
+    report.averageUa = totalUs > 0 ? static_cast<uint32_t>(chargeUaUs / totalUs) : 0;
+    return report;
+}
+
+uint32_t stateCurrentUa(PowerState state) {
+    return state < PowerState::Count ? kCurrentUa[static_cast<size_t>(state)] : 0;
+}
+
+const char* stateName(PowerState state) {
+    switch (state) {
+        case PowerState::Idle:       return "idle";
+        case PowerState::Capture:    return "capture";
+        case PowerState::Save:       return "save";
+        case PowerState::Display:    return "display";
+        case PowerState::LightSleep: return "light_sleep";
+        case PowerState::DeepSleep:  return "deep_sleep";
+        default:                     return "?";
+    }
+}
+
+}  // namespace pxlcam::energy
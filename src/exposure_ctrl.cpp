@@ -4,12 +4,19 @@
  */
 
 #include "exposure_ctrl.h"
+#include "camera_config.h"
+#include "camera_service.h"
+#include "jpeg_luma.h"
+#include "luma_extract.h"
 #include "pxlcam_config.h"
 #include "logging.h"
 
 #include <Arduino.h>
 #include <esp_camera.h>
 
+#include <math.h>
+#include <stdlib.h>
+
 namespace pxlcam::exposure {
 
 namespace {
@@ -22,6 +29,173 @@ uint8_t g_lastBrightness = 128;
 uint32_t g_lastSampleMs = 0;
 uint8_t g_iterationCount = 0;
 
+// The middle half of the frame (a quarter of its area) weighs this many
+// times the border: the subject, not the sky around it
+constexpr uint32_t kCenterWeight = 3;
+constexpr int kRawSampleStep = 8;   // Every 8th pixel of every 8th row
+
+// Luma is gamma encoded: exposure ratio ~ (luma ratio)^kGamma
+constexpr float kGamma = 2.2f;
+// EV per ae_level step until a step has been measured
+constexpr float kDefaultEvPerLevel = 0.5f;
+constexpr float kMinEvPerLevel = 0.15f;
+constexpr float kMaxEvPerLevel = 1.5f;
+// Samples this close to black or white say little about the slope
+constexpr int kClipLow = 8;
+constexpr int kClipHigh = 247;
+// Manual exposure (AEC off) range of set_aec_value()
+constexpr int kMinAecValue = 1;
+constexpr int kMaxAecValue = 1200;
+
+float g_evPerLevel = kDefaultEvPerLevel;
+int g_prevLuma = -1;          ///< Luma of the sample before the last step
+int8_t g_prevLevel = 0;       ///< ae_level that sample was taken at
+bool g_dropFrame = false;     ///< Next frame was exposed before the last step
+
+/// Centre-weighted luma of decoded 1/8 blocks
+struct Meter {
+    uint16_t w;
+    uint16_t h;
+    uint32_t sum;
+    uint32_t weight;
+};
+
+inline uint32_t pixelWeight(uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    const bool center = x >= w / 4 && x < w - w / 4 && y >= h / 4 && y < h - h / 4;
+    return center ? kCenterWeight : 1;
+}
+
+bool meterBlock(void* user, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* luma) {
+    Meter* meter = static_cast<Meter*>(user);
+    if (!luma) {
+        meter->w = w;
+        meter->h = h;
+        return w > 0 && h > 0;
+    }
+    for (uint16_t by = 0; by < h; by++) {
+        const uint8_t* row = luma + static_cast<size_t>(by) * w;
+        for (uint16_t bx = 0; bx < w; bx++) {
+            const uint32_t weight = pixelWeight(x + bx, y + by, meter->w, meter->h);
+            meter->sum += row[bx] * weight;
+            meter->weight += weight;
+        }
+    }
+    return true;
+}
+
+/// Centre-weighted mean luma of a frame, -1 if it cannot be measured
+/// JPEG frames are decoded at 1/8 block by block, so any frame size works
+/// without a buffer; raw frames are sampled every kRawSampleStep pixels.
+int frameLuma(const camera_fb_t* fb) {
+    if (!fb || !fb->buf || fb->len == 0) {
+        return -1;
+    }
+    
+    Meter meter = {};
+    if (fb->format == PIXFORMAT_JPEG) {
+        if (!jpeg::decodeLumaBlocks(fb->buf, fb->len, meterBlock, &meter, JPG_SCALE_8X) ||
+            meter.weight == 0) {
+            return -1;
+        }
+        return static_cast<int>((meter.sum + meter.weight / 2) / meter.weight);
+    }
+    
+    const bool rgb565 = fb->format == PIXFORMAT_RGB565;
+    const size_t step = rgb565 ? luma::kRgb565Step : lumaSampleStep(fb->format);
+    if (step == 0 || fb->width == 0 || fb->height == 0 || fb->len < fb->width * fb->height * step) {
+        return -1;
+    }
+    for (size_t y = 0; y < fb->height; y += kRawSampleStep) {
+        const uint8_t* row = fb->buf + y * fb->width * step;
+        for (size_t x = 0; x < fb->width; x += kRawSampleStep) {
+            const uint8_t* px = row + x * step;
+            const uint32_t weight = pixelWeight(x, y, fb->width, fb->height);
+            meter.sum += (rgb565 ? luma::rgb565Luma(px[0], px[1]) : px[0]) * weight;
+            meter.weight += weight;
+        }
+    }
+    return static_cast<int>((meter.sum + meter.weight / 2) / meter.weight);
+}
+
+/// Exposure change (EV) that brings a measured luma to the target
+float evToTarget(int measured) {
+    const float from = static_cast<float>(measured < 1 ? 1 : measured);
+    return kGamma * log2f(static_cast<float>(g_config.targetBrightness) / from);
+}
+
+/// Learn EV per ae_level from the last step (secant), ignoring clipped samples
+void learnSlope(int luma) {
+    const int steps = g_config.exposureLevel - g_prevLevel;
+    if (g_prevLuma < 0 || steps == 0 ||
+        luma <= kClipLow || luma >= kClipHigh || g_prevLuma <= kClipLow || g_prevLuma >= kClipHigh) {
+        return;
+    }
+    const float ev = kGamma * log2f(static_cast<float>(luma) / static_cast<float>(g_prevLuma));
+    const float slope = ev / static_cast<float>(steps);
+    if (slope < kMinEvPerLevel || slope > kMaxEvPerLevel) {
+        return;   // Scene changed or AEC had not settled: keep the old slope
+    }
+    g_evPerLevel = slope;
+}
+
+/// One predictive step towards the target, staged in the sensor shadow
+/// With AEC on, ae_level moves by as many steps as the error needs (the
+/// sensor loop does the rest); with AEC off, the exposure time is scaled.
+/// @return true if anything was changed
+bool stepTowards(int luma) {
+    sensor::Settings settings = sensor::target();
+    const float ev = evToTarget(luma);
+    if (!settings.autoExposure) {
+        const int current = settings.aecValue;
+        int next = static_cast<int>(lroundf(static_cast<float>(current < kMinAecValue ? kMinAecValue : current) *
+                                            exp2f(ev)));
+        next = next < kMinAecValue ? kMinAecValue : (next > kMaxAecValue ? kMaxAecValue : next);
+        if (next == current) {
+            return false;
+        }
+        settings.aecValue = static_cast<uint16_t>(next);
+        sensor::stage(settings);
+        PXLCAM_LOGD_TAG(kLogTag, "Exposure %d -> %d (luma %d, %+.2f EV)", current, next, luma, ev);
+        return true;
+    }
+    
+    learnSlope(luma);
+    int steps = static_cast<int>(lroundf(ev / g_evPerLevel));
+    if (steps == 0) {
+        steps = ev > 0 ? 1 : -1;   // Outside tolerance: always move
+    }
+    int level = g_config.exposureLevel + steps;
+    level = level < -2 ? -2 : (level > 2 ? 2 : level);
+    if (level == g_config.exposureLevel) {
+        return false;
+    }
+    g_prevLuma = luma;
+    g_prevLevel = g_config.exposureLevel;
+    g_config.exposureLevel = static_cast<int8_t>(level);
+    settings.aeLevel = g_config.exposureLevel;
+    sensor::stage(settings);
+    PXLCAM_LOGD_TAG(kLogTag, "Exposure level %d -> %d (luma %d, %+.2f EV, %.2f EV/step)",
+                    g_prevLevel, level, luma, ev, g_evPerLevel);
+    return true;
+}
+
+/// Profile with the configured AEC/AGC and level where it leaves them on
+sensor::Settings profileFor(sensor::Profile profile) {
+    sensor::Settings settings = sensor::profileSettings(profile);
+    if (settings.autoExposure) {
+        settings.autoExposure = g_config.autoExposure;
+        settings.aeLevel = g_config.exposureLevel;
+    }
+    if (settings.autoGain) {
+        settings.autoGain = g_config.autoGain;
+    }
+    return settings;
+}
+
+bool withinTolerance(int luma) {
+    return abs(luma - static_cast<int>(g_config.targetBrightness)) <= g_config.tolerance;
+}
+
 }  // anonymous namespace
 
 void init(const ExposureConfig& config) {
@@ -30,16 +204,13 @@ void init(const ExposureConfig& config) {
     g_lastBrightness = 128;
     g_lastSampleMs = 0;
     g_iterationCount = 0;
+    g_evPerLevel = kDefaultEvPerLevel;
+    g_prevLuma = -1;
+    g_dropFrame = false;
     
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (sensor) {
-        sensor->set_exposure_ctrl(sensor, g_config.autoExposure ? 1 : 0);
-        sensor->set_gain_ctrl(sensor, g_config.autoGain ? 1 : 0);
-        
-        if (!g_config.autoExposure) {
-            sensor->set_ae_level(sensor, g_config.exposureLevel);
-        }
-    }
+    // Nothing streams yet: written straight away
+    sensor::stage(profileFor(sensor::Profile::Standard), sensor::Profile::Standard);
+    sensor::apply();
     
     PXLCAM_LOGI_TAG(kLogTag, "Exposure control initialized, AEC=%d, AGC=%d", 
                     g_config.autoExposure, g_config.autoGain);
@@ -49,6 +220,8 @@ void startAutoTune() {
     g_state = TuneState::Sampling;
     g_iterationCount = 0;
     g_lastSampleMs = 0;
+    g_prevLuma = -1;
+    g_dropFrame = false;
     PXLCAM_LOGI_TAG(kLogTag, "Auto-tune started");
 }
 
@@ -75,49 +248,54 @@ bool tick() {
         return true;
     }
     
-    // Get a frame to analyze
-    camera_fb_t* fb = esp_camera_fb_get();
-    if (!fb) {
-        return false;
+    // Get a frame to analyze; the first one after a step was exposed before it.
+    // Both straight from the driver, with the camera service held off
+    int luma;
+    {
+        frames::Pause pause;
+        camera_fb_t* fb = esp_camera_fb_get();
+        if (fb && g_dropFrame) {
+            esp_camera_fb_return(fb);
+            fb = esp_camera_fb_get();
+        }
+        if (!fb) {
+            return false;
+        }
+        g_dropFrame = false;
+        
+        luma = frameLuma(fb);
+        esp_camera_fb_return(fb);
     }
-    
-    g_lastBrightness = calculateBrightness(fb);
-    esp_camera_fb_return(fb);
+    if (luma < 0) {
+        g_state = TuneState::Complete;
+        PXLCAM_LOGW_TAG(kLogTag, "Auto-tune stopped: frame not measurable");
+        return true;
+    }
+    g_lastBrightness = static_cast<uint8_t>(luma);
     
     PXLCAM_LOGD_TAG(kLogTag, "Brightness sample: %d (target: %d)", 
                     g_lastBrightness, g_config.targetBrightness);
     
-    // Check if within tolerance
-    int diff = static_cast<int>(g_lastBrightness) - static_cast<int>(g_config.targetBrightness);
-    if (diff < 0) diff = -diff;
-    
-    if (diff <= g_config.tolerance) {
+    if (withinTolerance(luma)) {
         g_state = TuneState::Complete;
-        PXLCAM_LOGI_TAG(kLogTag, "Auto-tune complete, brightness=%d", g_lastBrightness);
+        PXLCAM_LOGI_TAG(kLogTag, "Auto-tune complete, brightness=%d after %u steps",
+                        g_lastBrightness, g_iterationCount);
         return true;
     }
     
     // Need to adjust
     g_state = TuneState::Adjusting;
     ++g_iterationCount;
-    
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (!sensor) {
-        return false;
+    // Written now, right after the frame was dequeued
+    const bool stepped = stepTowards(luma);
+    sensor::apply();
+    if (!stepped) {
+        g_state = TuneState::Complete;
+        PXLCAM_LOGI_TAG(kLogTag, "Auto-tune complete (exposure at its limit), brightness=%d",
+                        g_lastBrightness);
+        return true;
     }
-    
-    // Determine adjustment direction
-    int8_t adjust = (g_lastBrightness < g_config.targetBrightness) ? 1 : -1;
-    
-    // Get current AE level and adjust
-    int8_t newLevel = g_config.exposureLevel + adjust;
-    if (newLevel < -2) newLevel = -2;
-    if (newLevel > 2) newLevel = 2;
-    
-    g_config.exposureLevel = newLevel;
-    sensor->set_ae_level(sensor, newLevel);
-    
-    PXLCAM_LOGD_TAG(kLogTag, "Adjusted exposure level to %d", newLevel);
+    g_dropFrame = true;
     
     g_state = TuneState::Sampling;
     return false;
@@ -137,28 +315,25 @@ void setExposureLevel(int8_t level) {
     
     g_config.exposureLevel = level;
     
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (sensor) {
-        sensor->set_ae_level(sensor, level);
-    }
+    sensor::Settings settings = sensor::target();
+    settings.aeLevel = level;
+    sensor::stage(settings);
 }
 
 void setAutoExposure(bool enable) {
     g_config.autoExposure = enable;
     
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (sensor) {
-        sensor->set_exposure_ctrl(sensor, enable ? 1 : 0);
-    }
+    sensor::Settings settings = sensor::target();
+    settings.autoExposure = enable;
+    sensor::stage(settings);
 }
 
 void setAutoGain(bool enable) {
     g_config.autoGain = enable;
     
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (sensor) {
-        sensor->set_gain_ctrl(sensor, enable ? 1 : 0);
-    }
+    sensor::Settings settings = sensor::target();
+    settings.autoGain = enable;
+    sensor::stage(settings);
 }
 
 uint8_t getLastBrightness() {
@@ -166,65 +341,93 @@ uint8_t getLastBrightness() {
 }
 
 uint8_t calculateBrightness(const camera_fb_t* fb) {
-    if (!fb || !fb->buf || fb->len == 0) {
-        return 128;
-    }
-    
-    // Sample center region (for JPEG, use simple byte average as approximation)
-    // For better accuracy with JPEG, we'd need to decode - this is a quick estimate
-    uint32_t sum = 0;
-    size_t samples = fb->len > 1024 ? 1024 : fb->len;
-    size_t step = fb->len / samples;
+    const int luma = frameLuma(fb);
+    return luma < 0 ? 128 : static_cast<uint8_t>(luma);
+}
+
+void quickAdjust(const camera_fb_t* fb) {
+    const int luma = frameLuma(fb);
+    if (luma < 0) return;
     
-    for (size_t i = 0; i < fb->len; i += step) {
-        sum += fb->buf[i];
+    g_lastBrightness = static_cast<uint8_t>(luma);
+    if (!withinTolerance(luma)) {
+        stepTowards(luma);
+        sensor::apply();
     }
-    
-    return static_cast<uint8_t>(sum / (fb->len / step));
 }
 
-void quickAdjust(const camera_fb_t* fb) {
-    if (!fb) return;
+WarmupResult warmUp(uint32_t maxMs) {
+    WarmupResult result = {};
+    sensor_t* sensor = esp_camera_sensor_get();
+    if (!sensor) {
+        return result;
+    }
     
-    uint8_t brightness = calculateBrightness(fb);
-    g_lastBrightness = brightness;
+    // Every readout until the sensor settles: none to the camera service
+    frames::Pause pause;
+    const uint32_t start = millis();
+    const framesize_t captureSize = sensor->status.framesize;
+    const bool resized = captureSize > PXLCAM_WARMUP_FRAMESIZE && sensor->set_framesize &&
+                         sensor->set_framesize(sensor, PXLCAM_WARMUP_FRAMESIZE) == 0;
+    const uint16_t warmupWidth = resized ? resolution[PXLCAM_WARMUP_FRAMESIZE].width : 0;
     
-    int diff = static_cast<int>(brightness) - static_cast<int>(g_config.targetBrightness);
-    if (diff < 0) diff = -diff;
+    int lastLuma = -1;
+    uint8_t stable = 0;
+    while (millis() - start < maxMs) {
+        camera_fb_t* fb = esp_camera_fb_get();
+        if (!fb) {
+            break;
+        }
+        // Frames still in the queue from before the switch (or the sleep) are skipped
+        const bool current = !resized || fb->width == warmupWidth;
+        const int luma = current ? frameLuma(fb) : -1;
+        esp_camera_fb_return(fb);
+        if (!current) {
+            continue;
+        }
+        if (luma < 0) {
+            break;  // Not measurable: nothing to wait for
+        }
+        
+        result.frames++;
+        result.meanLuma = static_cast<uint8_t>(luma);
+        const int delta = lastLuma < 0 ? 255 : abs(luma - lastLuma);
+        lastLuma = luma;
+        if (delta > PXLCAM_WARMUP_LUMA_DELTA) {
+            stable = 0;
+        } else if (++stable >= PXLCAM_WARMUP_STABLE_FRAMES) {
+            result.converged = true;
+            break;
+        }
+    }
+    
+    if (resized) {
+        setFrameSize(captureSize, 1);
+    }
+    result.settleMs = millis() - start;
     
-    if (diff > g_config.tolerance) {
-        int8_t adjust = (brightness < g_config.targetBrightness) ? 1 : -1;
-        setExposureLevel(g_config.exposureLevel + adjust);
+    PXLCAM_LOGI_TAG(kLogTag, "Warm-up %s after %lu ms, %u frames, luma %u",
+                    result.converged ? "settled" : "capped",
+                    static_cast<unsigned long>(result.settleMs),
+                    result.frames, result.meanLuma);
+    return result;
+}
+
+void applyProfile(sensor::Profile profile) {
+    if (sensor::currentProfile() != profile) {
+        PXLCAM_LOGI_TAG(kLogTag, "Applying %s profile", sensor::profileName(profile));
     }
+    sensor::stage(profileFor(profile), profile);
 }
 
 void applyNightMode() {
-    PXLCAM_LOGI_TAG(kLogTag, "Applying night mode");
-    
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (!sensor) return;
-    
-    // Maximize exposure for low light
-    sensor->set_exposure_ctrl(sensor, 0);  // Manual exposure
-    sensor->set_gain_ctrl(sensor, 0);      // Manual gain
-    sensor->set_aec_value(sensor, 800);    // High exposure
-    sensor->set_agc_gain(sensor, 20);      // High gain
-    sensor->set_brightness(sensor, 1);     // Slight brightness boost
-    sensor->set_contrast(sensor, 1);       // Slight contrast boost
+    // Maximize exposure for low light: manual exposure and gain
+    applyProfile(sensor::Profile::Night);
 }
 
 void applyStandardMode() {
-    PXLCAM_LOGI_TAG(kLogTag, "Applying standard mode");
-    
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (!sensor) return;
-    
     // Re-enable auto exposure
-    sensor->set_exposure_ctrl(sensor, g_config.autoExposure ? 1 : 0);
-    sensor->set_gain_ctrl(sensor, g_config.autoGain ? 1 : 0);
-    sensor->set_brightness(sensor, 0);
-    sensor->set_contrast(sensor, 0);
-    sensor->set_ae_level(sensor, g_config.exposureLevel);
+    applyProfile(sensor::Profile::Standard);
 }
 
 }  // namespace pxlcam::exposure
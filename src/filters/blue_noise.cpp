@@ -0,0 +1,289 @@
+/**
+ * @file blue_noise.cpp
+ * @brief 64×64 blue-noise threshold tile
+ * 
+ * @details
+ * Generated offline with void-and-cluster on a 64×64 torus: Gaussian
+ * energy filter sigma = 1.5, 10% initial binary pattern, rank r stored as
+ * r * 256 / 4096. Each tile row spans four lines of 16 values below.
+ * 
+ * @see blue_noise.h
+ * 
+ * @author PXLcam Team
+ * @version 1.3.0
+ * @date 2024
+ * 
+ * @copyright MIT License
+ */
+
+#include "filters/blue_noise.h"
+
+namespace pxlcam {
+namespace filters {
+
+// const data stays in flash (DROM) on the ESP32
+static const uint8_t s_blueNoise64[BLUE_NOISE_SIZE * BLUE_NOISE_SIZE] = {
+    183, 237,  74, 190,  26, 210,  10, 193,  32, 102, 185,  20, 115, 164,  51, 110,
+     20, 167,  36, 112,  87, 172, 142,  11, 228, 146, 250, 192, 166, 211,   8,  78,
+    148,  50, 187,  89, 162, 205,  78, 215,  96, 161, 253,  42, 233, 201,  60, 153,
+    174,  72, 187,  28, 228, 200,  16,  62, 114,  25,  53,  93, 186,  71, 245,  89,
+     52,  16, 143,  93, 243, 113, 151,  90, 144,  66, 130, 207,  89, 225, 193, 149,
+    252,  55, 220, 188,  25, 235, 105, 193, 124,  28,  83, 119,  40, 106, 246, 180,
+     30, 231, 133,  24, 252,  44, 125, 241,  61, 197,   3, 183, 125,  24, 115,  92,
+    222,  15, 237, 138, 107,  39, 141, 190, 214, 174, 249, 133,  16, 151,  34, 135,
+    104, 205, 175,  40, 161,  63, 228,  45, 250, 201,   7, 241,  42,  71,   9,  94,
+    205,  77, 123, 147,  64, 200,  34,  60,  95, 208, 176,   2, 230, 152,  61,  95,
+    207, 112,  70, 172, 100, 144,  12, 154,  34, 116, 142,  90,  50, 168, 240, 189,
+     46, 119,  86,  53, 180,  76, 235, 101,   3,  83, 155,  38, 106, 210, 225, 169,
+    250,  69, 120, 233,   5, 203, 129,  18, 105, 168,  83, 151, 173, 125, 218, 137,
+     30, 179,   5, 243,  94, 161, 132, 248, 152,  44, 238, 136,  75, 190,  17, 138,
+    164,  10, 221, 195,  60, 230, 190,  88, 209, 235,  74, 204, 225, 145,  73,   6,
+    139, 206, 167, 244,   7, 204, 154,  50, 129, 221,  65, 234, 181,  57,  80,   1,
+    155,  23, 216,  53, 108,  82, 158, 185, 218,  54,  31, 109, 231,  23, 186,  49,
+    165, 228, 108,  42, 209,  17, 218,  80,  10, 169,  98,  55, 212, 115, 223,  48,
+    250,  86,  43, 150,  19, 113,  38, 167,  57,  24, 176,  13, 108,  34, 215,  99,
+    255,  68,  22, 147, 124,  94,  31, 246, 185,  27, 198, 119,  12, 139, 194, 123,
+    232,  88, 138, 167, 194, 246,  34,  69, 122, 235, 143, 199,  58,  98, 250, 116,
+     65,  87, 150, 187,  74, 120,  47, 183, 226, 116, 202,  18, 160,  33, 175,  71,
+    118, 186, 131, 243,  79, 218, 137, 247, 102, 129, 153, 246,  63, 127, 181, 158,
+     38, 197, 109, 219,  62, 230, 170,  70, 108, 144,  91,  47, 166, 244,  97,  42,
+    173, 201,  33,  74,  20, 141,  99, 207,  13,  88, 181,   2, 213,  78, 156,  15,
+    194, 240,  12, 133, 253, 167,  96, 139,  61,  32, 144, 255,  82, 102, 235, 145,
+     27, 216,   1, 105, 202, 176,  65,   5, 196, 222,  47,  87, 193, 229,  21,  60,
+    120, 175,  84,  35, 187,  12, 136, 216,  20, 172, 255, 207,  73,  27, 215,  65,
+      7, 103, 255, 119, 178, 229,  51, 172, 133, 253,  46, 116, 168, 132,  39, 223,
+    123,  45, 206,  62,  30, 223,   2, 197, 236,  91, 188,  63, 219, 134,  12, 201,
+     94, 169,  67, 153,  49,  25, 121, 160,  76,  32, 112, 168,   0, 146,  94, 211,
+    237,   4, 151, 246, 100, 158,  46,  88, 196,  59,   4, 125, 155, 110, 184, 144,
+    226,  52, 148, 197,  63,   2, 115, 221,  28, 159,  76, 227,  21, 238, 190,  69,
+    175,  93, 157, 106, 184,  72, 151, 112,  22, 164, 122,   4, 168,  46, 188,  57,
+    241,  36, 229, 192,  90, 254, 208,  97, 234, 185, 135, 214,  72, 249,  44, 138,
+     80, 204,  53, 132, 212,  75, 242, 117, 233, 135,  83, 225,  39, 240,  20, 126,
+     75, 170,  14,  93, 240, 160,  87, 189,  65, 105, 194, 140,  61,  89, 109,   4,
+    143, 219,  19, 236, 124, 211,  46, 249,  83, 215,  42, 200, 107, 247,  86, 122,
+    156, 109, 138,  15, 126, 171,  41, 143,  56,  15, 243,  29, 104, 171, 116, 187,
+     27, 164, 114,  16, 175,  30, 192,  10, 163,  35, 187, 100, 200,  60,  92, 205,
+    238, 117, 218,  43, 128, 205,  37, 142, 244,   9, 213,  36, 182, 154, 210, 242,
+     36,  77, 166,  43,  87,  14, 171, 131,  59, 145, 239,  77, 151,  17, 180, 217,
+      7,  73, 208,  54, 237,  72,   8, 226, 117, 173,  90, 154,  58, 202,   9, 226,
+     63, 252,  88, 232,  64, 120, 149,  96,  67, 221, 147,  17, 170, 130, 158,  41,
+     98,  29, 154, 186,  76,  22, 232,  55, 123, 167,  91, 119, 248,  16,  51, 129,
+    184, 112, 251, 133, 179, 228, 101, 204,   7, 184, 100,  24, 225, 133,  69,  40,
+    166, 250,  97, 174, 149, 110, 198, 160,  74, 210,  46, 192, 131, 239,  40,  97,
+    124, 183,  38, 159, 199, 220,  50, 251, 179, 107,  53, 230,  75, 252,   0, 187,
+    137, 202,  58, 250, 106, 151, 178, 101, 206,  32, 234,  57, 137,  83, 172,  96,
+    206,  61,  12, 199,  67,  31, 156,  74, 235,  37, 125, 176,  54, 202, 114, 233,
+    139,  25, 193,  42,  19, 218,  90,  34, 247,  11, 121, 229,  18,  70, 163, 145,
+    219,  18, 140, 104,   0,  86, 132,  24, 205,   5, 124, 191,  33, 111, 213,  69,
+    244,  13,  88, 132,   4, 224,  71,  15, 158,  79, 187,   2, 221, 196,  33, 234,
+     25, 160, 225,  98, 146, 245,  50, 111, 165, 212,  68, 245, 161,  30,  89, 182,
+     58, 110,  80, 225, 121, 181,  58, 140, 101, 184, 147,  81, 106, 177, 210,  83,
+     50, 196,  75, 241, 185,  41, 236, 169,  82, 141, 245,  91, 165, 146,  49, 176,
+    118, 157, 229, 174,  39, 198, 137, 253,  48, 219, 146,  99, 161, 114,  72, 151,
+    123,  83,  46, 119,   1, 187, 130, 198,  14, 142,  94,   9, 106, 214, 149,   1,
+    209, 240, 159, 136,  66, 249,   2, 169, 232,  66,  41, 200, 254,  32, 120,  11,
+    244, 166, 119,  58, 154, 208, 113,  63, 156,  45, 211,  64,  14, 236, 101,  27,
+    197,  47,  71, 211, 116,  56,  92, 189, 105, 127,  30,  66, 251,  44, 212,   5,
+    246, 185, 214, 168, 232,  91,  25,  83, 251,  56, 189, 227, 135,  51, 255,  76,
+    125,  47,  14, 203,  33, 104, 200, 126,  24, 211, 156,   4, 132,  59, 223, 150,
+    107,  33, 224,  12, 134,  95,  17, 183, 220,  30, 113, 175, 201, 129, 216,  79,
+    237, 143,  20,  99, 162, 219,  28, 170,  12, 238, 197, 171,  17, 132, 180,  98,
+     59, 136,  19,  74,  40, 204, 162, 222,  41, 120, 154,  32,  81, 184,  20, 162,
+    192,  95, 177, 235,  85, 150, 227,  45,  86, 116, 241,  97, 167, 195,  88, 181,
+     63, 207,  85, 181, 255,  36, 230, 129,  89, 241, 137,  23,  87,  55,   9, 165,
+     32,  87, 194, 240,   8, 128, 244,  74, 153,  57,  87, 118, 205,  79, 238, 162,
+     34, 202, 111, 255, 141, 108,  64, 137, 180, 215,  72, 201, 236, 120, 100, 223,
+     33, 140,  62, 117, 167,  17,  71, 188, 141, 177,  50,  74, 234,  22,  44, 249,
+      3, 142, 121,  51, 163,  73, 199,  55,   9, 192,  71, 222, 152, 250, 187, 108,
+    221, 130, 174,  60, 149,  81,  41, 194, 134, 214,  38, 235, 148,  52,  10, 116,
+    221,  85, 158,  54, 182,   7, 240,  30,  94,  20, 111,   4, 165,  43, 147,  67,
+    201, 242,   6, 214,  49, 196, 110, 252,   9, 220,  30, 203, 146, 103, 128, 158,
+     97, 191, 234,  21, 214, 112, 143, 173, 108, 154,  48, 179, 101,  35, 135,  63,
+      1, 254,  42, 106, 209, 182, 114, 224,   1, 110, 179,  19, 103, 185, 229, 139,
+     68, 188,  11, 226,  95, 210, 159, 119, 226, 170, 249, 140,  65, 209, 247,  11,
+     86, 123, 157,  97, 238, 131,  31, 155,  61,  99, 164, 120,   7, 190, 222,  72,
+    211,  39,  68, 153,  91,   2, 239,  33, 209, 248, 126,   4, 234,  76, 212, 161,
+    120,  74, 156,  13, 234,  24, 143,  62,  95, 245, 160,  73, 211,  33,  92, 170,
+     22, 243, 146,  37, 128,  77,  47, 191,  61,  85,  37, 187,  94,  25, 170, 108,
+    179,  45, 191,  26,  77, 175, 224,  84, 204, 134, 244,  70, 231,  57,  31, 170,
+     15, 116, 178, 247, 127, 186,  58, 100,  75,  21,  90, 197, 145, 115,  21, 196,
+     95, 217, 178, 124,  87,  48, 250, 171,  32, 201,  54, 137, 115, 253,  63, 205,
+     47, 121,  99, 202, 177,  15, 250, 136,   6, 153, 208, 117, 222, 131,  54, 144,
+    230,  71, 253, 147, 206,   0, 106,  45, 183,  15,  40, 180,  91, 149, 107, 245,
+    137, 227,  86,  49,  28, 205, 157, 231, 138, 170, 227,  62,  37, 175, 244,  47,
+    188,  30,  55, 227, 199, 162, 102, 208,  78, 126,  14, 225, 172,   4, 153, 131,
+    227,  80, 165,  55, 232, 152,  88, 213, 106, 239,  51,  21,  77, 240, 192,  31,
+    208,  14, 113,  42, 125,  66, 165, 247, 122, 221, 158, 115,  13, 214, 186,  82,
+     53, 161,   6, 217, 143,  73, 109,  12, 190,  46, 110, 160, 219,  98,  70, 150,
+    123, 248, 105, 141,  21,  66, 132,   7, 230, 155, 188,  40,  84, 196, 102,  30,
+    184,  10, 248,  26,  72, 113,  24, 173,  69, 193, 130, 180, 155,   0, 103,  84,
+    129, 161,  94, 173, 216, 233, 140,  20,  94,  52,  79, 194, 252,  45, 127,  22,
+    206, 101, 191, 119, 174, 243,  42, 211,  69, 253,  25, 203,   9, 136, 228,  16,
+     84, 168,   6,  76, 187, 241,  40, 180, 109,  60,  97, 240, 143,  50, 245,  67,
+    210, 109, 142, 216, 126, 197, 227,  44, 145,  13,  91, 230,  63, 205, 176, 247,
+     57, 222, 195,   9,  56,  90,  33, 196, 214, 148, 229,  28, 136, 166,  72, 238,
+    148,  37, 254,  59,  92,  16, 135, 166, 122,  91, 152, 125,  79, 182,  54, 201,
+     38, 235, 208, 152, 113, 217,  81, 139, 253,  25, 209, 124,  16, 217, 168, 126,
+    157,  49,  90, 175,  40, 161,  63, 103, 242, 207,  36, 110, 141,  44, 121,  22,
+    143,  36,  74, 249, 152, 180, 117,  71, 173,   3, 110,  58,  87, 201,   5, 106,
+    179,  78, 138,  25, 232, 189,  79, 224,   1, 185,  58, 231,  33, 249, 111, 159,
+    130,  64, 101,  32,  51, 161,  17, 196,  49, 170,  77, 181,  64, 105,  26,  87,
+      3, 240, 191,  18,  81, 251,   2, 127, 177,  78, 162, 255,  10, 215, 166,  78,
+    230, 185, 124, 103,  23, 204, 241,  47, 127, 249, 190, 144, 238, 117, 218,  56,
+    227,  11, 212, 164, 112, 149,  52, 103, 241,  40, 207, 171, 100, 148,   4, 220,
+    190,  21, 173, 230, 198, 128,  89, 224, 118, 147,   1, 233, 155, 195, 237, 178,
+    214,  68, 134, 223, 108, 146, 188, 221,  20,  52, 123, 195,  69,  93, 238, 110,
+      6, 157, 213,  50, 142,  80,   9, 164,  92,  36,  75,  15, 176,  32, 149, 170,
+    124,  90, 194,  65,  37, 217, 199,  27, 156, 138, 111,  16,  69, 204,  47,  82,
+    145, 255, 118,  78,   3, 248,  61, 177,  36, 102, 216,  88,  39, 120,  56, 140,
+     36, 117, 166,  47, 202,  31,  69,  92, 141, 213,  98,  27, 179, 149,  32, 200,
+     62,  88,  27, 169, 237, 113, 220, 135, 201, 217, 155, 227,  98,  52,  84,  18,
+    240,  47, 133, 245,  95,   6, 123, 175,  60, 218,  80, 246, 129, 180, 238, 104,
+     11, 204,  54, 142, 185,  99, 152,  11, 242, 198,  56, 133, 251,   9,  81, 204,
+     98, 247,  12,  89, 231, 119, 159, 245,  37, 173, 239, 135, 228,  51, 127, 173,
+    252, 115, 228, 193,  67,  35, 184,  56,  18, 106,  61, 129, 199, 253, 184, 206,
+    104, 161,  15, 183, 145, 230,  76, 252,  95,   8, 190,  44, 150,  26,  62, 164,
+     42,  91, 168,  29, 209,  38, 229, 132,  79, 158,  19, 173, 192, 145, 226, 172,
+     21, 151, 197,  60, 176,   8,  54, 191, 114,   5,  62,  85,  17, 210,  77,  13,
+    148,  43, 132,   2,  97, 153, 255,  82, 150, 236, 174,  41,   1, 114, 137,  67,
+     35, 215,  73, 115,  56, 163,  41, 194, 134, 169, 116, 223,  94, 211, 122, 228,
+    136, 215, 108, 245, 124,  65, 182, 107,  44, 219, 117,  70,  93,  29, 109,  46,
+     70, 219, 107, 142, 254, 129, 212,  78, 225, 151, 203, 164, 107, 183, 237,  96,
+    219, 184,  81, 164, 222, 125,  11, 110, 194,  27,  90, 213,  78, 160,  23, 238,
+    179, 142, 251, 193,  27, 209, 111,  18,  53, 232,  30,  65, 165,   1, 185,  77,
+     18, 177,  61,  10, 154,  89, 213,  16, 144, 189, 243,  38, 231, 198, 153, 245,
+    130, 182,  37,  77,  23,  92, 168,  18, 101,  48, 124, 251,  39, 138,  57, 119,
+     28,  64, 247,  24, 200,  60, 174, 213,  49, 133, 248, 146, 186, 226,  48,  95,
+    121,   8,  49,  99, 225,  85, 140, 240, 153,  84, 201, 131, 253,  41, 109, 242,
+    157, 224,  83, 198, 236,  26, 162, 252,  57,  96,  12, 162, 131,  57,   3, 206,
+     92,  11, 238, 158, 220, 186,  42, 134, 242, 178,  20,  74, 195,   0, 169, 202,
+    154, 212, 139, 113,  39,  85, 241,  22, 159,  68, 116,  16,  62, 107, 201, 166,
+    224,  83, 159, 131, 172,   5, 183,  66, 216, 105,  14, 179,  81, 147, 198,  57,
+    124,  37, 142, 111,  48, 133,  74, 197, 123, 176,  80, 212, 102, 180,  74, 118,
+    166,  58, 196, 121,  49, 109, 231, 150,  65, 209,  93, 228, 150, 101, 240,  44,
+     88,   8,  99, 172, 229, 148, 129, 100, 230, 182, 206,  39, 233, 135,  10,  71,
+     34, 198, 237,  22,  70, 248,  45, 125,  22, 160, 236,  52, 117, 227,  28,  99,
+    183, 251,   2, 164, 226, 186, 104,  40,   4, 236, 136,  48,  22, 255, 217,  37,
+    231, 147,  83,  19, 206,  72,  26, 195,   4, 118,  35, 132,  55, 217,  76, 129,
+    180, 243,  52, 193,  72,   3, 196,  43,  79,   7,  96, 155, 178,  81, 250, 148,
+    183, 105,  54, 214, 116, 151, 195,  99, 207,  40, 136, 194,   7, 161,  73, 210,
+     53,  88, 195,  65,  93,  16, 239, 206, 151,  67, 221, 195, 156, 123,  88, 173,
+     25, 104, 249, 177, 140, 241, 126,  88, 160, 248, 171, 191,  23, 162,  12, 206,
+     35, 117, 220,  26, 160, 252, 110, 169, 210, 143, 246,  56, 122,  24, 210,  47,
+    128,   4, 144, 185,  91,  26, 229,  75, 171, 250,  90,  67, 218, 102, 242,  19,
+    150, 115, 215,  33, 175, 148,  59, 117, 172,  99,  27, 111,  64,  16, 140,  54,
+    203, 130,   0,  62,  96,  37, 174, 223,  49,  71, 102, 235,  82, 113, 255, 139,
+     62, 157,  80, 135,  95,  58,  31, 233,  63, 118,  31, 219, 195, 105, 167,  92,
+    239, 202,  78, 245,  41, 169, 132,   1,  58, 147,  26, 122, 181,  35, 130, 173,
+    236,  13, 139, 247, 122, 219,  84,  21, 251,  45, 187, 239, 169, 205, 243, 183,
+     73, 226, 160, 197, 217, 151,   9, 112, 208,  21, 141,  46, 204, 180,  31,  90,
+    191, 235,  12, 211, 187, 222, 131, 153,  13, 189,  86, 162,   0,  68, 230,  30,
+     61, 164,  20, 126,  64, 207, 103, 238, 184, 109, 198, 233, 149,  58, 202,  79,
+     45, 181,  70, 101,  50,  10, 183, 210, 144,  75, 127,   2,  84,  42,  98,  10,
+    115,  44,  85,  29, 119,  52, 254,  77, 189, 156, 224,   5, 127,  64, 150, 227,
+     23, 101, 174,  45, 116,  15,  82, 204, 101, 241, 135,  47, 254, 146, 125, 193,
+    115, 219,  93, 228, 177,  23, 145,  83,  19, 222,  50,  14,  83, 255,   4, 104,
+    156, 211,  27, 194, 166, 237, 128,  96,  30, 225, 163, 209, 147, 227, 134, 163,
+    212, 251, 142, 188, 235,  94, 181, 136,  33, 105,  84, 169, 246,  99, 213,  51,
+    120, 144, 250,  66, 165, 244, 181,  55,  35, 174,  65, 203,  93,  20, 171,  80,
+      8, 141,  38, 154, 109, 254,  51, 213, 162, 135,  95, 167, 112, 177, 136, 229,
+    117,  84, 241, 143,  77,  36, 155,  62, 197, 114,  51, 102,  66,  27, 196,  59,
+     23, 174, 105,   6,  65, 155,  19, 219,  64, 242, 192,  55,  29, 160,  10, 178,
+     76, 208,   1,  93, 134,  32, 108, 217, 126, 229,  11, 114, 182, 222,  53, 206,
+    249, 180,  57, 196,   7,  73, 189, 116,  41,  69, 242, 205,  30, 219,  67,  24,
+    168,  52, 127,   0, 204, 113, 223,   8, 171, 248,  17, 233, 188, 121, 245,  91,
+    130,  75,  39, 225, 128, 201,  44, 165, 122,  11, 134, 211, 112, 233,  85, 133,
+    231,  42, 153, 200, 232,  78, 146,   5, 163,  76, 148, 239,  29, 139, 108,  34,
+    130,  99, 236,  85, 215, 125, 167,  25, 225, 191,   3, 126,  54, 151,  95, 200,
+     16, 221, 184,  99, 254,  53, 189,  90, 133,  73, 152,  39, 172,  83,   6, 156,
+    231, 184, 210, 148,  87, 247, 111,  81, 233, 183,  38,  77, 144, 198,  44, 188,
+     23, 111, 176,  54,  17, 188, 224,  61, 196,  98,  43, 167,  84,  64, 242, 159,
+     69,  15, 152,  31, 140,  44, 244,  87, 145, 106, 157,  79, 249, 190,  41, 237,
+     74, 149,  34,  67, 163,  19, 141, 234,  34, 216, 105, 207, 138,  55, 220, 103,
+     47,  15, 116,  56,  29, 171,   7, 194,  53,  98, 160, 252,   2,  63, 105, 245,
+    149,  73, 240, 125, 100, 167,  35, 115, 244,  23, 221, 118, 189, 212,   5, 186,
+    225, 201, 113, 176, 223, 100, 203,  13,  61, 234,  28, 176, 100,  10, 141, 115,
+    247, 104, 198, 134, 227,  86, 174,  66, 118, 190,   3,  88, 254,  21, 166, 202,
+    140, 250, 164, 192, 228,  68, 213, 126, 146,  17, 218, 119, 177, 222, 163,  14,
+     94, 216,  27, 205,  70, 255, 136,  84, 178, 131, 199,  52,  19, 149, 121,  94,
+     46,  81, 252,  59,   1,  71, 154, 179, 123, 198,  48, 215, 129, 231,  58, 186,
+      5,  49, 215,  13, 111,  43, 209,  25, 243,  52, 162, 127,  66, 193, 112,  29,
+     63,  82,  99,  11, 134, 158,  93,  32, 236, 199,  70,  43,  92,  28, 122, 195,
+     56, 167, 132,  45, 159,   3, 212,  50,  11, 155,  70, 251, 102, 232,  35, 174,
+    141,  21, 161, 128, 193, 237, 111,  40, 251,  96, 163,  71,  20, 199,  86, 163,
+    125, 178,  80, 157, 249, 186, 128, 152,  96, 178, 220,  38, 234, 149,  86, 242,
+    178, 217,  38, 237, 109,  47, 255, 175,  59, 111, 155, 189, 137, 239,  76, 144,
+    251,   7, 191, 106, 233,  91, 150, 192, 237,  94,  34, 128, 179,  80,  58, 199,
+    243, 103, 212,  34,  90, 140,  22, 211,  78,   8, 142, 228, 107, 156,  31, 223,
+     98, 239, 139,  32,  97,  71,   5, 229,  75,  18, 141, 100,  11, 183,  45, 130,
+      0, 113, 154, 204,  76, 185,   3, 139,  85,  26, 247,   6, 212,  55, 202,  37,
+    112,  81, 226,  65, 177,  39, 122,  62, 111, 224, 166, 207,   0, 157, 222, 128,
+      8,  69, 186,  54, 224, 176,  65, 165, 129, 194,  37, 181,  53, 254, 137,  69,
+    207,  21,  61, 226, 171, 218,  51, 198, 123, 249,  59, 206, 119, 216,  73, 228,
+    163, 196,  59, 136,  28, 220, 120, 202, 229, 169, 128,  82, 108, 159,  15, 179,
+    215, 154,  29, 136,  18, 200, 248,  15, 176,  25,  82,  50, 241, 114,  26,  89,
+    168, 230, 114, 155,  13, 104, 244,  46, 218, 102, 242,  82, 123,   9, 188,  41,
+    118, 159, 192, 112,  13, 133, 156, 104,  40, 191, 152,  82, 169,  24, 145, 102,
+     34,  87,  17, 248,  92, 161,  68,  18, 101,  46, 216,  35, 182, 233,  89, 130,
+     59,  98, 184, 241, 110, 158,  77, 135, 209, 147, 105, 193, 134,  71, 182, 214,
+     40, 144,  29, 250,  75, 202, 121,   4, 149,  61,  16, 163, 204,  96, 220, 170,
+      2, 248,  74,  39, 205,  81, 243,  26, 170,  93,   8, 232,  43, 252,  60, 182,
+    240, 211, 148, 181, 114,  51, 244, 186, 152,  75, 192, 144,  68,  23, 150, 246,
+      0, 222,  41,  72, 207,  48,  97, 223,  42,  64, 237,  13, 153,  43, 255, 106,
+     60, 196,  84, 131, 163,  35, 184,  89, 232, 191, 131, 226,  28, 150,  76,  55,
+    138,  91, 152, 234, 122, 182,  62, 208, 235, 135,  53, 197, 109, 131, 204,   6,
+    117,  43,  66, 225,   9, 209, 135,  31, 118, 233,  10, 253, 124, 219,  48, 115,
+    200, 163, 122, 148,  12, 235, 171,   2, 187, 124, 164, 218,  93, 207,   7, 138,
+    162, 233,   2, 206,  57, 234, 138,  66, 172,  36, 104,  71,  48, 246, 108, 229,
+    208,  29, 189,  53,  18, 100, 143,   0,  76, 114, 223, 161,  17,  90, 165,  72,
+    140, 174,  97, 130,  38, 168,  86, 222,  59, 175,  93,  53, 102, 191, 172,  84,
+     64,  27, 252,  86, 189, 129,  68, 114, 251,  85,  32,  58, 119, 171,  80, 192,
+     23,  95, 123, 174, 102,  12, 215, 112,  19, 253, 146, 195, 171, 126,  14, 180,
+     67, 103, 130, 220, 158, 247,  43, 193, 154,  21, 184,  70, 143, 244,  33, 213,
+    236,  24, 200, 253,  77, 191, 107,   1, 200, 137,  30, 165, 209,   8,  34, 238,
+    138, 178, 106,  54, 220,  35, 157, 200,  23, 145, 176, 242,  19, 231,  50, 113,
+    246,  65, 215,  46, 244,  79, 157, 194,  52,  84, 218,   3,  92, 203, 157,  45,
+    145, 253,   7,  82, 177,  70, 125, 227,  92, 251,  39, 103, 216,  55, 190,  86,
+    109,  53, 159,  13, 147,  51, 240, 156,  75, 246, 111, 229,  78, 129, 158,  97,
+    224,   6, 198, 159,  17, 102, 238,  49,  96, 214,  67, 101, 197, 137, 157, 206,
+     38, 169, 142,  25, 188, 126,  33, 230, 137, 165, 118,  61, 242,  32,  79, 232,
+     22, 170, 199, 114,  34, 214,  19, 165,  51, 121, 203, 168,   4, 124, 153,  15,
+    181, 127, 221,  89, 119, 205,  28, 126,  44, 182,  12, 145,  43, 244,  63, 187,
+     48, 121,  72, 241, 131, 175,  80, 140, 227,   5, 189, 128,  36,  73,  11,  90,
+    127, 224,  81, 109, 151, 208,  69,  95,   8, 203,  39, 182, 141, 107, 216, 122,
+     97,  43, 222,  56, 146, 188, 103,  75, 211,  25, 139,  66, 236,  97, 221,  44,
+    249,  66, 192,  33, 234,  68, 179, 228,  96, 215,  66, 203, 178, 113, 213,  20,
+    148, 207,  94,  41, 210,  59, 195,  28, 167, 110,  50, 160, 252, 214, 173, 238,
+     28, 185,   5, 254,  57,  14, 239, 181, 107, 248,  73, 223,  19, 166,  54, 186,
+     73, 159, 134,  91, 231,   5, 248, 141, 178, 232,  88, 192,  35, 176,  75, 133,
+    160,   3, 103, 151, 173,   7,  85, 144,  22, 162, 107,  29,  89,   3, 139,  80,
+    236, 172,  26, 143, 107,   9, 254, 120,  70, 235, 205,  24,  83, 113,  59, 142,
+    105,  63, 158, 216,  91, 170, 118,  49, 146,  28, 156, 120,  93, 208,   6, 243,
+    201,  14, 239,  27, 168, 122,  60,  36, 114,  14,  56, 157, 117, 243,  22, 209,
+     85, 199, 231,  50, 127, 245, 110, 208,  57, 247, 132, 226, 155, 254, 193,  36,
+    104,  60, 249, 186, 223, 158,  87, 177,  40, 136,  92, 146, 183,   1, 195,  42,
+    230, 203, 132,  43, 193, 142,  24, 221, 194,  85, 231,  49, 190,  68, 147, 127,
+     49, 180, 116,  64, 203,  86, 217, 153, 197,  95, 254, 203,  10, 145,  57, 169,
+    118,  29, 140,  78, 218,  38, 165,  14, 188,  82,  42, 175,  72,  51, 121, 223,
+    159, 133,   0,  77,  45, 127,  21, 218, 199,   9, 246,  56, 226, 126, 243, 154,
+     89,  14,  76, 115,  29, 237,  78, 130,  60, 168,   0, 135, 254,  31, 224, 103,
+    248,  81, 212, 152,  35, 185,  17, 239,  70, 171, 133,  39, 107, 226,  96, 217,
+     45, 247, 177,  18,  96, 191,  67, 138, 232, 118,   6, 200, 104,  16, 182,  87,
+     22, 199, 217,  98, 175, 243,  64, 101, 152,  79, 117, 166,  37,  97,  68,  26,
+    190, 167, 246, 220, 177, 103, 207,  10, 242, 100, 213, 179, 110,  85, 172,  23,
+    139, 164,   3,  98, 252, 139, 108,  48, 123,   0, 213,  81, 178,  67, 189,   6,
+    153, 100,  60, 208, 156, 120, 253,  31, 100, 161, 217, 134, 239, 150, 232,  41,
+    170,  67, 121, 150,  31, 195, 138, 235,  48, 190, 221,  18, 210, 179, 137, 216,
+    106,  52, 143,   2,  68,  46, 148, 185,  37, 125,  72,  20,  46, 155, 214,  62,
+    112,  38, 220, 128,  55, 172,  79, 224, 162, 236,  55, 149, 246,  29, 134, 234,
+     80, 199, 132, 239,   1,  52, 212,  79, 181,  48,  69,  24,  89,  56, 128, 203,
+    108, 245,  13, 225,  59, 112,   6, 173,  26, 131,  68, 104, 147,  82,   8, 250,
+     36, 124, 210,  92, 163, 121, 253,  86, 164, 228, 147, 202, 234, 120,   8, 197
+};
+
+const uint8_t* blue_noise_row(int y) {
+    return &s_blueNoise64[(y & (BLUE_NOISE_SIZE - 1)) * BLUE_NOISE_SIZE];
+}
+
+} // namespace filters
+} // namespace pxlcam
@@ -6,14 +6,22 @@
  * This file implements the complete dithering system for PXLcam v1.3.0.
  * It provides:
  * - Optimized Bayer 8×8 and 4×4 ordered dithering
+ * - Blue-noise threshold dithering (64×64 void-and-cluster tile)
  * - Floyd–Steinberg error diffusion
  * - Atkinson dithering
  * - Configuration management
  * 
  * **Optimization Notes:**
- * - Bayer matrices stored in PROGMEM to save RAM
+ * - Bayer matrices in DRAM, band and span kernels in IRAM (mem_placement.h)
+ * - Ordered kernels work on 4 pixels per 32-bit word (swar.h)
+ * - Ordered kernels split the frame across both cores (DitherConfig::parallel)
+ * - Error diffusion runs as a two-core row wavefront when serpentine is off
  * - Fixed-point arithmetic for error diffusion (no floats)
+ * - Error rows in the DRAM scratch block, rotated by pointer swap
+ * - Row loops specialized per source format × kernel (templates picked from
+ *   constexpr tables once per image), no per-row format switch
  * - Row-by-row processing for cache efficiency
+ * - Packed index layouts (2bpp, 1bpp, SSD1306 pages) stored per row
  * - In-place processing supported where possible
  * 
  * @see dither_pipeline.h for public API documentation
@@ -26,29 +34,54 @@
  */
 
 #include "filters/dither_pipeline.h"
+#include "filters/blue_noise.h"
+#include "luma_extract.h"
+#include "mem_placement.h"
+#include "swar.h"
 #include <string.h>  // For memcpy, memset
+#include <atomic>
 
 // Only compile if feature is enabled
 #if PXLCAM_FEATURE_STYLIZED_CAPTURE
 
-// ESP32 specific includes for PROGMEM
+// Internal RAM allocation for the buffers that miss the scratch block
 #ifdef ESP32
-#include <pgmspace.h>
+#include <esp_heap_caps.h>
 #else
-// Fallback for non-ESP32 platforms (testing)
-#ifndef PROGMEM
-#define PROGMEM
+#include <stdlib.h>
 #endif
-#ifndef pgm_read_byte
-#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+
+// Band and span kernels in IRAM (PXLCAM_HOT_CODE is empty off ESP32)
+#if PXLCAM_DITHER_IRAM
+#define DITHER_HOT PXLCAM_HOT_CODE
+#else
+#define DITHER_HOT
 #endif
+
+// Second-core worker for split-frame dithering (FreeRTOS only)
+#if defined(ESP32) && PXLCAM_DITHER_PARALLEL
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#define DITHER_HAS_WORKER 1
+#else
+#define DITHER_HAS_WORKER 0
+#endif
+
+// Error-ring lock: preview, capture and stream tasks all dither (FreeRTOS only)
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#define DITHER_HAS_ERROR_LOCK 1
+#else
+#define DITHER_HAS_ERROR_LOCK 0
 #endif
 
 namespace pxlcam {
 namespace filters {
 
 // =============================================================================
-// Bayer Dithering Matrices (PROGMEM)
+// Bayer Dithering Matrices (DRAM)
 // =============================================================================
 
 /**
@@ -60,9 +93,11 @@ namespace filters {
  * Original values (0-15) scaled by 16 and offset:
  * value = (original * 16) + 8 - 128 → range -120 to +127
  * 
- * Stored as unsigned with 128 bias for easier arithmetic.
+ * Stored as unsigned with 128 bias for easier arithmetic. Kept in DRAM
+ * rather than flash rodata (80 bytes for both), so no part of the ordered
+ * path waits on the flash cache.
  */
-static const uint8_t PROGMEM s_bayer4x4[BAYER_4X4_SIZE][BAYER_4X4_SIZE] = {
+static const uint8_t PXLCAM_HOT_DATA s_bayer4x4[BAYER_4X4_SIZE][BAYER_4X4_SIZE] = {
     {   0, 128,  32, 160 },
     { 192,  64, 224,  96 },
     {  48, 176,  16, 144 },
@@ -77,7 +112,7 @@ static const uint8_t PROGMEM s_bayer4x4[BAYER_4X4_SIZE][BAYER_4X4_SIZE] = {
  * 
  * Normalized to 0-255 range with characteristic ordered pattern.
  */
-static const uint8_t PROGMEM s_bayer8x8[BAYER_8X8_SIZE][BAYER_8X8_SIZE] = {
+static const uint8_t PXLCAM_HOT_DATA s_bayer8x8[BAYER_8X8_SIZE][BAYER_8X8_SIZE] = {
     {   0, 128,  32, 160,   8, 136,  40, 168 },
     { 192,  64, 224,  96, 200,  72, 232, 104 },
     {  48, 176,  16, 144,  56, 184,  24, 152 },
@@ -99,7 +134,8 @@ static const char* const s_algorithmNames[] = {
     "Ordered 8x8",       // ORDERED_8X8
     "Ordered 4x4",       // ORDERED_4X4
     "Floyd-Steinberg",   // FLOYD_STEINBERG
-    "Atkinson"           // ATKINSON
+    "Atkinson",          // ATKINSON
+    "Blue Noise"         // BLUE_NOISE
 };
 
 // =============================================================================
@@ -117,22 +153,79 @@ static bool s_initialized = false;
 static DitherConfig s_config;
 
 /**
- * @brief Error diffusion buffer for current row
+ * @brief Padding cells on each side of an error row
+ * 
+ * Kernels write up to 2 pixels past either edge (Atkinson's x±2); those
+ * cells are never read back.
+ */
+static constexpr int ERROR_PAD = 2;
+
+/**
+ * @brief Length of one error row in cells
+ */
+static constexpr int ERROR_ROW_LEN = DITHER_MAX_WIDTH + 2 * ERROR_PAD;
+
+/**
+ * @brief Error rows allocated
  * 
- * Stores accumulated error values as signed 16-bit.
- * Using int16_t to handle overflow during error propagation.
+ * Serial kernels use up to 3; the Atkinson wavefront has 4 in flight.
  */
-static int16_t s_errorRow0[DITHER_MAX_WIDTH + 4];
+static constexpr int ERROR_RING_ROWS = 4;
 
 /**
- * @brief Error diffusion buffer for next row
+ * @brief Ring of error rows for the diffusion kernels
+ * 
+ * Stores accumulated error values as signed 16-bit. rows[0] is the row
+ * being dithered, rows[1] and rows[2] the next ones. Kernels zero each cell
+ * of rows[0] as they consume it, so advancing is a pointer rotation plus
+ * resetting the padding: no per-row copy or clear.
+ * 
+ * Taken once from the DRAM scratch block (else the internal heap): the
+ * kernels do several 16-bit read-modify-writes per pixel, which PSRAM
+ * would serialize behind its cache.
  */
-static int16_t s_errorRow1[DITHER_MAX_WIDTH + 4];
+struct ErrorRing {
+    int16_t* storage;
+    int16_t* rows[3];
+};
 
+static ErrorRing s_errors = {};
+
+// Scratch block storage is held for good; dither_init() after a shutdown reuses it
+static int16_t* s_errorScratch = nullptr;
+
+#if DITHER_HAS_ERROR_LOCK
 /**
- * @brief Error diffusion buffer for row+2 (Atkinson only)
+ * @brief Admits one error-diffusion image at a time into s_errors
+ * 
+ * Created with the ring in dither_init(); callers from different tasks
+ * (preview, capture, WiFi stream) queue instead of sharing error rows.
  */
-static int16_t s_errorRow2[DITHER_MAX_WIDTH + 4];
+static SemaphoreHandle_t s_errorLock = nullptr;
+#endif
+
+/**
+ * @brief Holds s_errorLock for a scope (no-op without FreeRTOS)
+ */
+class ErrorRingGuard {
+public:
+    ErrorRingGuard() {
+#if DITHER_HAS_ERROR_LOCK
+        if (s_errorLock != nullptr) {
+            xSemaphoreTake(s_errorLock, portMAX_DELAY);
+        }
+#endif
+    }
+    ~ErrorRingGuard() {
+#if DITHER_HAS_ERROR_LOCK
+        if (s_errorLock != nullptr) {
+            xSemaphoreGive(s_errorLock);
+        }
+#endif
+    }
+    ErrorRingGuard(const ErrorRingGuard&) = delete;
+    ErrorRingGuard& operator=(const ErrorRingGuard&) = delete;
+};
 
 // =============================================================================
 // Internal Helper Functions
@@ -180,85 +273,1113 @@ static inline uint8_t rgb565_to_luma(uint16_t rgb565) {
 }
 
 /**
- * @brief Find the closest tone index for a given luminance value
+ * @brief Apply strength scaling to threshold offset
  * 
- * Uses minimum distance comparison to find the best matching
- * palette tone. Returns index (0-3) not the tone value.
+ * @param threshold Raw threshold from Bayer matrix (0-255)
+ * @param strength Dither strength (0-255, 128 = normal)
+ * @return int Scaled threshold offset for addition to pixel value
+ */
+static inline int scale_threshold(uint8_t threshold, uint8_t strength) {
+    // Convert threshold to signed offset (-128 to +127)
+    int offset = static_cast<int>(threshold) - 128;
+    
+    // Scale by strength (strength/128 factor)
+    // Using fixed-point: (offset * strength) >> 7
+    offset = (offset * static_cast<int>(strength)) >> 7;
+    
+    return offset;
+}
+
+/**
+ * @brief Convert one source row to grayscale
  * 
- * @param luma Input luminance (0-255)
- * @param palette Palette to search
- * @return uint8_t Tone index (0-3)
+ * Format is a template parameter so the caller's row loop carries no
+ * format switch; every branch below folds away at compile time.
+ * 
+ * @tparam Format Source format
+ * @param src Source buffer
+ * @param grayRow Output grayscale row buffer
+ * @param row Row index
+ * @param w Image width
  */
-static inline uint8_t find_closest_tone_index(uint8_t luma, const Palette& palette) {
-    uint8_t bestIndex = 0;
-    int bestDist = 256;  // Max possible distance + 1
+template <SourceFormat Format>
+static inline void convert_row_to_gray(const uint8_t* src, uint8_t* grayRow, int row, int w) {
+    if (Format == SourceFormat::RGB888) {
+        const uint8_t* srcRow = src + row * w * 3;
+        for (int x = 0; x < w; ++x) {
+            const uint8_t* p = srcRow + x * 3;
+            grayRow[x] = rgb_to_luma(p[0], p[1], p[2]);
+        }
+    } else if (Format == SourceFormat::RGB565) {
+        const uint16_t* srcRow = reinterpret_cast<const uint16_t*>(src) + row * w;
+        for (int x = 0; x < w; ++x) {
+            grayRow[x] = rgb565_to_luma(srcRow[x]);
+        }
+    } else if (Format == SourceFormat::YUV422) {
+        // Y is every other byte; no color math
+        luma::extractRow(src + row * w * 2, luma::kYuv422Step, grayRow, w);
+    } else if (Format == SourceFormat::RGB565_BE) {
+        // Camera frame buffer as delivered (high byte first)
+        luma::rgb565Row(src + row * w * luma::kRgb565Step, grayRow, w);
+    } else {
+        memcpy(grayRow, src + row * w, w);
+    }
+}
+
+/**
+ * @brief Gray pixels of one source row
+ * 
+ * GRAYSCALE rows are read in place; other formats are converted into rowBuf.
+ * 
+ * @tparam Format Source format
+ * @param src Source buffer
+ * @param rowBuf Conversion buffer (DITHER_MAX_WIDTH bytes, word aligned)
+ * @param y Row index
+ * @param w Image width
+ * @return const uint8_t* Gray row
+ */
+template <SourceFormat Format>
+static inline const uint8_t* source_row(const uint8_t* src, uint8_t* rowBuf, int y, int w) {
+    if (Format == SourceFormat::GRAYSCALE) {
+        return src + y * w;
+    }
+    convert_row_to_gray<Format>(src, rowBuf, y, w);
+    return rowBuf;
+}
+
+/**
+ * @brief True if rows go through a pack step instead of straight into dst
+ */
+static inline bool output_packed(DitherOutput output) {
+    return output != DitherOutput::INDICES;
+}
+
+/**
+ * @brief Nearest-tone tables for an output layout
+ * 
+ * The 1-bit layouts quantize between the end tones only: with tones[0]
+ * and tones[3] copied into the middle slots every level maps to index 0
+ * or 2, so bit 1 of the index is the output bit and the error is taken
+ * against the two tones actually shown.
+ * 
+ * @param palette Palette to quantize against
+ * @param output Output layout
+ * @param scratch Storage for tables that are not cached
+ * @return const PaletteLut& Tables to dither with
+ */
+static const PaletteLut& output_lut(const Palette& palette, DitherOutput output,
+                                    PaletteLut& scratch) {
+    if (output != DitherOutput::PACKED_1BPP && output != DitherOutput::SSD1306_PAGES) {
+        return palette_lut(palette, scratch);
+    }
     
-    for (uint8_t i = 0; i < PALETTE_TONE_COUNT; ++i) {
-        int dist = static_cast<int>(luma) - static_cast<int>(palette.tones[i]);
-        if (dist < 0) dist = -dist;  // abs()
+    Palette ends = palette;
+    ends.tones[1] = palette.tones[0];
+    ends.tones[2] = palette.tones[PALETTE_TONE_COUNT - 1];
+    palette_build_lut(ends, scratch);
+    return scratch;
+}
+
+/**
+ * @brief Store one finished row of tone indices in a packed layout
+ * 
+ * Rows of the row-major layouts own their bytes, so any row can be packed
+ * from either core. SSD1306_PAGES shares each byte between the 8 rows of
+ * a page: the page's first row stores, the others OR in their bit.
+ * 
+ * @param indices Tone indices of row y (word aligned)
+ * @param dst Packed destination image
+ * @param w Row width
+ * @param y Row index
+ * @param output Packed layout
+ */
+static void pack_row(const uint8_t* indices, uint8_t* dst, int w, int y, DitherOutput output) {
+    int x = 0;
+    switch (output) {
+        case DitherOutput::PACKED_2BPP: {
+            uint8_t* out = dst + y * ((w + 3) >> 2);
+            for (; x + 4 <= w; x += 4) {
+                out[x >> 2] = swar::packPairs(swar::load4(indices + x));
+            }
+            if (x < w) {
+                uint8_t last = 0;
+                for (int i = 0; i < 4; ++i) {
+                    last = static_cast<uint8_t>((last << 2) | (x + i < w ? (indices[x + i] & 0x03) : 0));
+                }
+                out[x >> 2] = last;
+            }
+            break;
+        }
         
-        if (dist < bestDist) {
-            bestDist = dist;
-            bestIndex = i;
+        case DitherOutput::PACKED_1BPP: {
+            uint8_t* out = dst + y * ((w + 7) >> 3);
+            for (; x + 8 <= w; x += 8) {
+                out[x >> 3] = static_cast<uint8_t>(
+                    (swar::packBits(swar::load4(indices + x) >> 1) << 4) |
+                    swar::packBits(swar::load4(indices + x + 4) >> 1));
+            }
+            if (x < w) {
+                uint8_t last = 0;
+                for (int i = 0; i < 8; ++i) {
+                    last = static_cast<uint8_t>((last << 1) | (x + i < w ? ((indices[x + i] >> 1) & 1) : 0));
+                }
+                out[x >> 3] = last;
+            }
+            break;
+        }
+        
+        case DitherOutput::SSD1306_PAGES: {
+            uint8_t* out = dst + (y >> 3) * w;
+            const int bit = y & 7;
+            if (bit == 0) {
+                for (; x < w; ++x) {
+                    out[x] = (indices[x] >> 1) & 1;
+                }
+            } else {
+                for (; x < w; ++x) {
+                    out[x] |= static_cast<uint8_t>(((indices[x] >> 1) & 1) << bit);
+                }
+            }
+            break;
+        }
+        
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief One Bayer matrix row as strength-scaled offsets
+ * 
+ * `offset` holds the signed offset per cell for the scalar path; `words`
+ * holds cells 0-3 and 4-7 split for saturating SWAR math. For the 4×4
+ * matrix both words (and cells 4-7) repeat the 4-cell pattern.
+ */
+struct OrderedRow {
+    int16_t offset[BAYER_8X8_SIZE];
+    swar::OffsetWord words[2];
+};
+
+/**
+ * @brief Build the scaled offsets of one Bayer row
+ * 
+ * @param bayerRow Matrix row
+ * @param size Matrix size (4 or 8)
+ * @param strength Dither strength (0-255, 128 = normal)
+ * @param out Row to fill
+ */
+static void build_ordered_row(const uint8_t* bayerRow, uint8_t size, uint8_t strength,
+                              OrderedRow& out) {
+    for (int x = 0; x < BAYER_8X8_SIZE; ++x) {
+        out.offset[x] = static_cast<int16_t>(
+            scale_threshold(bayerRow[x & (size - 1)], strength));
+    }
+    out.words[0] = swar::makeOffsetWord(&out.offset[0]);
+    out.words[1] = swar::makeOffsetWord(&out.offset[4]);
+}
+
+/**
+ * @brief Scaled rows of one Bayer matrix, cached for the last strength used
+ * 
+ * Strength is constant across a frame and usually across a session, so the
+ * tables are rebuilt only when a different strength shows up.
+ */
+struct OrderedTable {
+    OrderedRow rows[BAYER_8X8_SIZE];
+    uint8_t strength;
+    bool valid;
+};
+
+static OrderedTable s_ordered8x8;
+static OrderedTable s_ordered4x4;
+
+/**
+ * @brief Get the scaled rows of a matrix, rebuilding only on strength change
+ * 
+ * @param table Cache for this matrix
+ * @param matrix Matrix cells, row-major
+ * @param size Matrix size (4 or 8)
+ * @param strength Dither strength (0-255, 128 = normal)
+ * @return const OrderedRow* `size` rows
+ */
+static const OrderedRow* ordered_rows(OrderedTable& table, const uint8_t* matrix,
+                                      uint8_t size, uint8_t strength) {
+    if (!table.valid || table.strength != strength) {
+        for (int i = 0; i < size; ++i) {
+            build_ordered_row(matrix + i * size, size, strength, table.rows[i]);
         }
+        table.strength = strength;
+        table.valid = true;
     }
+    return table.rows;
+}
+
+static inline const OrderedRow* ordered_rows_8x8(uint8_t strength) {
+    return ordered_rows(s_ordered8x8, &s_bayer8x8[0][0], BAYER_8X8_SIZE, strength);
+}
+
+static inline const OrderedRow* ordered_rows_4x4(uint8_t strength) {
+    return ordered_rows(s_ordered4x4, &s_bayer4x4[0][0], BAYER_4X4_SIZE, strength);
+}
+
+/**
+ * @brief Offset words per blue-noise tile row (4 pixels each)
+ */
+static constexpr int NOISE_ROW_WORDS = BLUE_NOISE_SIZE / 4;
+
+/**
+ * @brief Blue-noise tile as strength-scaled offset words, cached like
+ *        OrderedTable
+ * 
+ * Only the SWAR words are kept (8 KB); the scalar path reads its offset back
+ * out of them. A per-pixel int16 copy would double that.
+ */
+struct NoiseTable {
+    swar::OffsetWord words[BLUE_NOISE_SIZE][NOISE_ROW_WORDS];
+    uint8_t strength;
+    bool valid;
+};
+
+static NoiseTable s_blueNoise;
+
+/**
+ * @brief Get the scaled blue-noise rows, rebuilding only on strength change
+ * 
+ * @param strength Dither strength (0-255, 128 = normal)
+ * @return const swar::OffsetWord* BLUE_NOISE_SIZE rows of NOISE_ROW_WORDS
+ */
+static const swar::OffsetWord* noise_rows(uint8_t strength) {
+    if (!s_blueNoise.valid || s_blueNoise.strength != strength) {
+        for (int y = 0; y < BLUE_NOISE_SIZE; ++y) {
+            const uint8_t* tile = blue_noise_row(y);
+            for (int i = 0; i < NOISE_ROW_WORDS; ++i) {
+                int16_t offsets[4];
+                for (int k = 0; k < 4; ++k) {
+                    offsets[k] = static_cast<int16_t>(scale_threshold(tile[i * 4 + k], strength));
+                }
+                s_blueNoise.words[y][i] = swar::makeOffsetWord(offsets);
+            }
+        }
+        s_blueNoise.strength = strength;
+        s_blueNoise.valid = true;
+    }
+    return &s_blueNoise.words[0][0];
+}
+
+/**
+ * @brief Ordered-dither one row: offset, clamp, map through a 256-entry table
+ * 
+ * Aligned rows run 4 pixels per iteration (saturating word add, word store);
+ * the unaligned remainder takes the scalar path with identical results.
+ * src and dst may alias.
+ * 
+ * @param src Gray row (x = 0 at src[0])
+ * @param dst Output row
+ * @param w Row width
+ * @param row Offsets for this row
+ * @param map Tone values or tone indices per clamped level (PaletteLut)
+ */
+static inline void ordered_row(const uint8_t* src, uint8_t* dst, int w,
+                               const OrderedRow& row, const uint8_t* map) {
+    int x = 0;
+    if (swar::aligned4(src) && swar::aligned4(dst)) {
+        for (; x + 8 <= w; x += 8) {
+            const uint32_t a = swar::applyOffset(swar::load4(src + x), row.words[0]);
+            const uint32_t b = swar::applyOffset(swar::load4(src + x + 4), row.words[1]);
+            swar::store4(dst + x, swar::lookup4(a, map));
+            swar::store4(dst + x + 4, swar::lookup4(b, map));
+        }
+        if (x + 4 <= w) {
+            const uint32_t a = swar::applyOffset(swar::load4(src + x), row.words[0]);
+            swar::store4(dst + x, swar::lookup4(a, map));
+            x += 4;
+        }
+    }
+    for (; x < w; ++x) {
+        dst[x] = map[clamp_u8(static_cast<int>(src[x]) + row.offset[x & 7])];
+    }
+}
+
+/**
+ * @brief Blue-noise dither one row
+ * 
+ * Same as ordered_row() with a 64-pixel period; the scalar remainder
+ * applies the same offset bytes one pixel at a time.
+ * 
+ * @param src Gray row (x = 0 at src[0])
+ * @param dst Output row
+ * @param w Row width
+ * @param words NOISE_ROW_WORDS offset words of this tile row
+ * @param map Tone values or tone indices per clamped level (PaletteLut)
+ */
+static inline void noise_row(const uint8_t* src, uint8_t* dst, int w,
+                             const swar::OffsetWord* words, const uint8_t* map) {
+    int x = 0;
+    if (swar::aligned4(src) && swar::aligned4(dst)) {
+        for (; x + 4 <= w; x += 4) {
+            const uint32_t a = swar::applyOffset(swar::load4(src + x),
+                                                 words[(x >> 2) & (NOISE_ROW_WORDS - 1)]);
+            swar::store4(dst + x, swar::lookup4(a, map));
+        }
+    }
+    for (; x < w; ++x) {
+        const swar::OffsetWord& word = words[(x >> 2) & (NOISE_ROW_WORDS - 1)];
+        const int shift = (x & 3) * 8;
+        const int offset = static_cast<int>((word.pos >> shift) & 0xFF) -
+                           static_cast<int>((word.neg >> shift) & 0xFF);
+        dst[x] = map[clamp_u8(static_cast<int>(src[x]) + offset)];
+    }
+}
+
+struct OrderedJob;
+
+/**
+ * @brief Ordered-dither rows [y0, y1) of a job
+ */
+typedef void (*OrderedBandFn)(const OrderedJob& job, int y0, int y1);
+
+/**
+ * @brief Everything one ordered-dither band needs
+ * 
+ * Rows are independent, so any row range can run on either core. Pointers
+ * (including map, usually the caller's PaletteLut) must stay valid until
+ * run_ordered() returns.
+ */
+struct OrderedJob {
+    OrderedBandFn band;               // Specialized row loop (s_orderedBands)
+    const uint8_t* src;
+    uint8_t* dst;
+    int w;
+    const OrderedRow* rows;           // Bayer rows (null for blue noise)
+    const swar::OffsetWord* noise;    // Blue-noise rows (null for Bayer)
+    int rowMask;                      // Matrix / tile size - 1
+    const uint8_t* map;               // Tone values or tone indices (PaletteLut)
+    DitherOutput output;              // Packed layouts go through pack_row()
+};
+
+/**
+ * @brief Ordered-dither row loop for one source format and kernel
+ * 
+ * Packed layouts cost one branch and a pack_row() per row, not per pixel.
+ * 
+ * @tparam Format Source format
+ * @tparam Noise Blue-noise tile instead of a Bayer matrix
+ */
+template <SourceFormat Format, bool Noise>
+static DITHER_HOT void ordered_band(const OrderedJob& job, int y0, int y1) {
+    // Row buffers for format conversion and packing (word aligned for the SWAR
+    // path). On the stack: both cores run bands of one job at once.
+    alignas(4) uint8_t rowBuf[DITHER_MAX_WIDTH];
+    alignas(4) uint8_t packBuf[DITHER_MAX_WIDTH];
+    const bool packed = output_packed(job.output);
     
-    return bestIndex;
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* grayRow = source_row<Format>(job.src, rowBuf, y, job.w);
+        
+        uint8_t* out = packed ? packBuf : job.dst + y * job.w;
+        if (Noise) {
+            noise_row(grayRow, out, job.w, job.noise + (y & job.rowMask) * NOISE_ROW_WORDS, job.map);
+        } else {
+            ordered_row(grayRow, out, job.w, job.rows[y & job.rowMask], job.map);
+        }
+        if (packed) {
+            pack_row(out, job.dst, job.w, y, job.output);
+        }
+    }
 }
 
+static_assert(static_cast<int>(SourceFormat::GRAYSCALE) == 0 &&
+              static_cast<int>(SourceFormat::RGB888) == 1 &&
+              static_cast<int>(SourceFormat::RGB565) == 2 &&
+              static_cast<int>(SourceFormat::YUV422) == 3 &&
+              static_cast<int>(SourceFormat::RGB565_BE) == 4 &&
+              static_cast<int>(SourceFormat::COUNT) == 5,
+              "Dispatch tables are indexed by SourceFormat");
+
 /**
- * @brief Apply strength scaling to threshold offset
+ * @brief Ordered row loops by [source format][blue noise]
+ */
+static constexpr OrderedBandFn s_orderedBands[static_cast<int>(SourceFormat::COUNT)][2] = {
+    { ordered_band<SourceFormat::GRAYSCALE, false>, ordered_band<SourceFormat::GRAYSCALE, true> },
+    { ordered_band<SourceFormat::RGB888, false>,    ordered_band<SourceFormat::RGB888, true> },
+    { ordered_band<SourceFormat::RGB565, false>,    ordered_band<SourceFormat::RGB565, true> },
+    { ordered_band<SourceFormat::YUV422, false>,    ordered_band<SourceFormat::YUV422, true> },
+    { ordered_band<SourceFormat::RGB565_BE, false>, ordered_band<SourceFormat::RGB565_BE, true> },
+};
+
+/**
+ * @brief Frames shorter than this are not worth a cross-core handoff
+ */
+static constexpr int PARALLEL_MIN_ROWS = 16;
+
+#if DITHER_HAS_WORKER
+
+/**
+ * @brief Persistent worker pinned to PXLCAM_DITHER_WORKER_CORE
  * 
- * @param threshold Raw threshold from Bayer matrix (0-255)
+ * Runs the second-core half of a split job. s_workerLock admits one split
+ * job at a time; a second concurrent caller just runs serially.
+ */
+static TaskHandle_t s_workerTask = nullptr;
+static SemaphoreHandle_t s_workerLock = nullptr;
+static SemaphoreHandle_t s_workerDone = nullptr;
+static void (*s_workerFn)(void*) = nullptr;
+static void* s_workerArg = nullptr;
+
+static void dither_worker_task(void*) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        s_workerFn(s_workerArg);
+        xSemaphoreGive(s_workerDone);
+    }
+}
+
+/**
+ * @brief Create the worker once (kept for the whole session)
+ * 
+ * @return true if the worker is available
+ */
+static bool worker_start() {
+    if (s_workerTask != nullptr) {
+        return true;
+    }
+    
+    if (s_workerLock == nullptr) {
+        s_workerLock = xSemaphoreCreateMutex();
+    }
+    if (s_workerDone == nullptr) {
+        s_workerDone = xSemaphoreCreateBinary();
+    }
+    if (s_workerLock == nullptr || s_workerDone == nullptr) {
+        return false;
+    }
+    
+    if (xTaskCreatePinnedToCore(dither_worker_task, "dither_wrk", PXLCAM_DITHER_WORKER_STACK,
+                                nullptr, PXLCAM_DITHER_WORKER_PRIORITY, &s_workerTask,
+                                PXLCAM_DITHER_WORKER_CORE) != pdPASS) {
+        s_workerTask = nullptr;
+        return false;
+    }
+    return true;
+}
+
+#endif // DITHER_HAS_WORKER
+
+/**
+ * @brief Hand fn(arg) to the worker
+ * 
+ * Refused when there is no worker, the caller already runs on the worker's
+ * core, or the worker is busy with another caller.
+ * 
+ * @return true if the worker took the job; the caller must worker_join()
+ */
+static bool worker_dispatch(void (*fn)(void*), void* arg) {
+#if DITHER_HAS_WORKER
+    if (s_workerTask == nullptr || xPortGetCoreID() == PXLCAM_DITHER_WORKER_CORE ||
+        xSemaphoreTake(s_workerLock, 0) != pdTRUE) {
+        return false;
+    }
+    s_workerFn = fn;
+    s_workerArg = arg;
+    xTaskNotifyGive(s_workerTask);
+    return true;
+#else
+    (void)fn;
+    (void)arg;
+    return false;
+#endif
+}
+
+/**
+ * @brief Wait for the job handed over by worker_dispatch()
+ */
+static void worker_join() {
+#if DITHER_HAS_WORKER
+    xSemaphoreTake(s_workerDone, portMAX_DELAY);
+    xSemaphoreGive(s_workerLock);
+#endif
+}
+
+/**
+ * @brief Row range of an ordered job, for the worker
+ */
+struct OrderedBand {
+    const OrderedJob* job;
+    int y0;
+    int y1;
+};
+
+static void ordered_band_entry(void* arg) {
+    const OrderedBand* band = static_cast<const OrderedBand*>(arg);
+    band->job->band(*band->job, band->y0, band->y1);
+}
+
+/**
+ * @brief Run an ordered job, splitting it across both cores if asked
+ * 
+ * The top half runs on the calling core while the worker does the bottom
+ * half; the call joins before returning. Falls back to a single band when
+ * the worker cannot take it (see worker_dispatch()). SSD1306 pages are
+ * split on a page boundary so no byte is shared between the cores.
+ * 
+ * @param job Job description
+ * @param h Image height
+ * @param parallel DitherConfig::parallel
+ */
+static void run_ordered(const OrderedJob& job, int h, bool parallel) {
+    if (parallel && h >= 2 * PARALLEL_MIN_ROWS) {
+        const int split = (job.output == DitherOutput::SSD1306_PAGES) ? ((h / 2) & ~7) : (h / 2);
+        OrderedBand bottom = { &job, split, h };
+        if (worker_dispatch(ordered_band_entry, &bottom)) {
+            job.band(job, 0, split);
+            worker_join();
+            return;
+        }
+    }
+    job.band(job, 0, h);
+}
+
+/**
+ * @brief Ordered dithering entry shared by every public variant
+ * 
+ * @param src Source buffer
+ * @param srcFormat Source format
+ * @param dst Output buffer
+ * @param w Image width
+ * @param h Image height
+ * @param palette Palette for quantization
+ * @param size Matrix size (4 or 8), or BLUE_NOISE_SIZE for the blue-noise tile
  * @param strength Dither strength (0-255, 128 = normal)
- * @return int Scaled threshold offset for addition to pixel value
+ * @param indices Write tone indices instead of tone values
+ * @param parallel Split across both cores
+ * @param output Index layout (tone values are always one byte per pixel)
  */
-static inline int scale_threshold(uint8_t threshold, uint8_t strength) {
-    // Convert threshold to signed offset (-128 to +127)
-    int offset = static_cast<int>(threshold) - 128;
+static void ordered_dither(const uint8_t* src, SourceFormat srcFormat, uint8_t* dst,
+                           int w, int h, const Palette& palette, uint8_t size,
+                           uint8_t strength, bool indices, bool parallel,
+                           DitherOutput output = DitherOutput::INDICES) {
+    // Nearest-tone tables, one lookup per pixel instead of a tone search
+    PaletteLut lutScratch;
+    const PaletteLut& lut = output_lut(palette, output, lutScratch);
     
-    // Scale by strength (strength/128 factor)
-    // Using fixed-point: (offset * strength) >> 7
-    offset = (offset * static_cast<int>(strength)) >> 7;
+    OrderedJob job;
+    job.band = s_orderedBands[static_cast<int>(srcFormat)][size == BLUE_NOISE_SIZE];
+    job.src = src;
+    job.dst = dst;
+    job.w = w;
+    // Scaled thresholds, cached until strength changes
+    job.rows = nullptr;
+    job.noise = nullptr;
+    if (size == BLUE_NOISE_SIZE) {
+        job.noise = noise_rows(strength);
+    } else {
+        job.rows = (size == BAYER_8X8_SIZE) ? ordered_rows_8x8(strength) : ordered_rows_4x4(strength);
+    }
+    job.rowMask = size - 1;
+    job.map = indices ? lut.index : lut.tone;
+    job.output = output;
     
-    return offset;
+    run_ordered(job, h, parallel);
 }
 
 /**
- * @brief Clear error diffusion buffers
+ * @brief Allocate the error ring (DRAM scratch, else internal heap), once
  * 
- * @param width Image width (determines clear length)
- * @param includeRow2 Also clear row2 buffer (for Atkinson)
+ * @return true if the ring is available
  */
-static void clear_error_buffers(int width, bool includeRow2 = false) {
-    // Add padding on both sides for boundary handling
-    const int bufLen = width + 4;
-    memset(s_errorRow0, 0, bufLen * sizeof(int16_t));
-    memset(s_errorRow1, 0, bufLen * sizeof(int16_t));
-    if (includeRow2) {
-        memset(s_errorRow2, 0, bufLen * sizeof(int16_t));
+static bool error_ring_alloc() {
+#if DITHER_HAS_ERROR_LOCK
+    if (s_errorLock == nullptr) {
+        s_errorLock = xSemaphoreCreateMutex();
     }
+#endif
+    if (s_errors.storage != nullptr) {
+        return true;
+    }
+    
+    const size_t bytes = ERROR_RING_ROWS * ERROR_ROW_LEN * sizeof(int16_t);
+    if (s_errorScratch == nullptr) {
+        s_errorScratch = static_cast<int16_t*>(placement::scratch(bytes, "DitherErrors"));
+    }
+    s_errors.storage = s_errorScratch;
+    if (s_errors.storage != nullptr) {
+        return true;
+    }
+#ifdef ESP32
+    s_errors.storage = static_cast<int16_t*>(
+        heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+#else
+    s_errors.storage = static_cast<int16_t*>(malloc(bytes));
+#endif
+    placement::note("DitherErrors", s_errors.storage, bytes);
+    return s_errors.storage != nullptr;
 }
 
 /**
- * @brief Rotate error buffers down one row
+ * @brief Release the error ring
+ */
+static void error_ring_free() {
+    if (s_errors.storage != s_errorScratch) {
+#ifdef ESP32
+        heap_caps_free(s_errors.storage);
+#else
+        free(s_errors.storage);
+#endif
+    }
+    s_errors = {};
+}
+
+/**
+ * @brief Reset the ring for a new image
  * 
+ * @param rowCount Rows the kernel diffuses into (2 = FS, 3 = Atkinson)
+ * @return true if the ring is available
+ */
+static bool error_ring_begin(int rowCount) {
+    if (!error_ring_alloc()) {
+        return false;
+    }
+    
+    for (int i = 0; i < 3; ++i) {
+        s_errors.rows[i] = s_errors.storage + i * ERROR_ROW_LEN;
+    }
+    memset(s_errors.storage, 0, rowCount * ERROR_ROW_LEN * sizeof(int16_t));
+    return true;
+}
+
+/**
+ * @brief Advance the ring one row (pointer rotation)
+ * 
+ * The finished rows[0] was zeroed cell by cell while it was consumed; only
+ * its padding still holds error and is reset before it becomes the last row.
+ * 
+ * @param ring Ring to advance (s_errors, or a stream's own rows)
  * @param width Image width
- * @param threeRows Also rotate row2 (for Atkinson)
+ * @param rowCount Rows in use (2 = FS, 3 = Atkinson)
+ */
+static inline void error_ring_advance(ErrorRing& ring, int width, int rowCount) {
+    int16_t* done = ring.rows[0];
+    done[0] = done[1] = 0;
+    done[width + ERROR_PAD] = done[width + ERROR_PAD + 1] = 0;
+    
+    for (int i = 0; i + 1 < rowCount; ++i) {
+        ring.rows[i] = ring.rows[i + 1];
+    }
+    ring.rows[rowCount - 1] = done;
+}
+
+/**
+ * @brief Error diffusion over a run of pixels
+ * 
+ * Quantizes gray + carried error, writes map[level] (tone values or tone
+ * indices), and spreads the error into e0 (this row), e1 (next row) and,
+ * for Atkinson, e2 (row + 2). Each e0 cell is zeroed as it is consumed.
+ * The scan direction is a template parameter, so every neighbor offset is
+ * a constant.
+ * 
+ * @tparam Atkinson Atkinson (1/8 to 6 neighbors, 2/8 discarded) instead of Floyd–Steinberg
+ * @tparam Step +1 left to right, -1 right to left
+ * @param gray Source gray row
+ * @param out Output row
+ * @param e0 Error cells of this row (x = 0 at e0[0])
+ * @param e1 Error cells of the next row
+ * @param e2 Error cells of row + 2 (Atkinson only)
+ * @param x First pixel
+ * @param count Pixels to process
+ * @param lut Nearest-tone tables (error is taken against lut.tone)
+ * @param map lut.tone or lut.index
+ */
+template <bool Atkinson, int Step>
+static DITHER_HOT void diffusion_span(const uint8_t* gray, uint8_t* out,
+                                      int16_t* e0, int16_t* e1, int16_t* e2, int x, int count,
+                                      const PaletteLut& lut, const uint8_t* map) {
+    for (int n = 0; n < count; ++n, x += Step) {
+        // Get source pixel with accumulated error (and consume the cell)
+        const uint8_t pixel = clamp_u8(static_cast<int>(gray[x]) + e0[x]);
+        e0[x] = 0;
+        
+        out[x] = map[pixel];
+        
+        const int error = static_cast<int>(pixel) - static_cast<int>(lut.tone[pixel]);
+        if (Atkinson) {
+            const int errFrac = error >> 3;  // error / 8
+            
+            //     * 1/8 1/8
+            // 1/8 1/8 1/8
+            //     1/8
+            e0[x + Step] += errFrac;
+            e0[x + 2 * Step] += errFrac;
+            e1[x - Step] += errFrac;
+            e1[x] += errFrac;
+            e1[x + Step] += errFrac;
+            e2[x] += errFrac;
+        } else {
+            // Floyd-Steinberg weights: 7/16 ahead, 3/16 5/16 1/16 below
+            e0[x + Step] += (error * 7) >> 4;
+            e1[x - Step] += (error * 3) >> 4;
+            e1[x] += (error * 5) >> 4;
+            e1[x + Step] += (error * 1) >> 4;
+        }
+    }
+}
+
+/**
+ * @brief Pixels per wavefront step between progress updates
+ */
+static constexpr int WAVEFRONT_CHUNK = 16;
+
+/**
+ * @brief Everything one error-diffusion image needs
+ * 
+ * Shared by the serial ring and the two-core wavefront. Core 0 (the caller)
+ * takes even rows and the worker odd rows, all left to right. Pixel x of
+ * row y needs every error from row y-1 up to x+1, and the two rows must not
+ * write the same cells at once, so row y-1 has to stay `lag` pixels ahead:
+ * 3 for Floyd–Steinberg, 4 for Atkinson (which writes x+2). Rows live in
+ * ring slots y % slots; a slot is reused only by the core that finished it,
+ * after its padding is reset.
+ * 
+ * done[c] is core c's progress as y * w + pixels finished in row y, so it
+ * only ever grows and a waiting row never sees a reset.
+ */
+struct DiffusionJob {
+    const uint8_t* src;
+    uint8_t* dst;
+    int w;
+    int h;
+    const PaletteLut* lut;
+    const uint8_t* map;
+    DitherOutput output;
+    bool serpentine;
+    void (*wavefront)(DiffusionJob& job, int first);  // Specialized row loop (s_wavefrontRows)
+    int slots;
+    int lag;
+    std::atomic<int32_t> done[2];
+};
+
+/**
+ * @brief Serial error diffusion through the ring (s_errors.rows)
+ * 
+ * Serpentine rows flip the scan direction; each direction has its own
+ * span instantiation.
+ * 
+ * @tparam Format Source format
+ * @tparam Atkinson Atkinson instead of Floyd–Steinberg
+ */
+template <SourceFormat Format, bool Atkinson>
+static void diffusion_serial(const DiffusionJob& job) {
+    alignas(4) uint8_t rowBuf[DITHER_MAX_WIDTH];
+    alignas(4) uint8_t packBuf[DITHER_MAX_WIDTH];
+    const bool packed = output_packed(job.output);
+    const int w = job.w;
+    
+    for (int y = 0; y < job.h; ++y) {
+        const uint8_t* grayRow = source_row<Format>(job.src, rowBuf, y, w);
+        uint8_t* out = packed ? packBuf : job.dst + y * w;
+        int16_t* e0 = s_errors.rows[0] + ERROR_PAD;
+        int16_t* e1 = s_errors.rows[1] + ERROR_PAD;
+        int16_t* e2 = s_errors.rows[2] + ERROR_PAD;
+        
+        if (!job.serpentine || ((y & 1) == 0)) {
+            diffusion_span<Atkinson, 1>(grayRow, out, e0, e1, e2, 0, w, *job.lut, job.map);
+        } else {
+            diffusion_span<Atkinson, -1>(grayRow, out, e0, e1, e2, w - 1, w, *job.lut, job.map);
+        }
+        if (packed) {
+            pack_row(out, job.dst, w, y, job.output);
+        }
+        error_ring_advance(s_errors, w, Atkinson ? 3 : 2);
+    }
+}
+
+static inline int16_t* wavefront_slot(int y, int slots) {
+    return s_errors.storage + (y % slots) * ERROR_ROW_LEN + ERROR_PAD;
+}
+
+/**
+ * @brief Rows first, first + 2, ... of a wavefront job
+ * 
+ * @tparam Format Source format
+ * @tparam Atkinson Atkinson instead of Floyd–Steinberg
  */
-static void rotate_error_buffers(int width, bool threeRows = false) {
-    const int bufLen = width + 4;
+template <SourceFormat Format, bool Atkinson>
+static void wavefront_rows(DiffusionJob& job, int first) {
+    alignas(4) uint8_t rowBuf[DITHER_MAX_WIDTH];
+    alignas(4) uint8_t packBuf[DITHER_MAX_WIDTH];
+    const bool packed = output_packed(job.output);
+    const int w = job.w;
+    std::atomic<int32_t>& mine = job.done[first];
+    const std::atomic<int32_t>& prev = job.done[first ^ 1];
+    int32_t prevDone = prev.load(std::memory_order_acquire);
     
-    if (threeRows) {
-        // Row0 = Row1, Row1 = Row2, Row2 = 0
-        memcpy(s_errorRow0, s_errorRow1, bufLen * sizeof(int16_t));
-        memcpy(s_errorRow1, s_errorRow2, bufLen * sizeof(int16_t));
-        memset(s_errorRow2, 0, bufLen * sizeof(int16_t));
+    for (int y = first; y < job.h; y += 2) {
+        const uint8_t* grayRow = source_row<Format>(job.src, rowBuf, y, w);
+        uint8_t* out = packed ? packBuf : job.dst + y * w;
+        int16_t* e0 = wavefront_slot(y, job.slots);
+        int16_t* e1 = wavefront_slot(y + 1, job.slots);
+        int16_t* e2 = wavefront_slot(y + 2, job.slots);
+        const int32_t prevBase = (y - 1) * w;  // Row 0 waits for nothing
+        
+        for (int x = 0; x < w; x += WAVEFRONT_CHUNK) {
+            const int count = (w - x < WAVEFRONT_CHUNK) ? (w - x) : WAVEFRONT_CHUNK;
+            const int ahead = x + count - 1 + job.lag;
+            const int32_t need = prevBase + (ahead < w ? ahead : w);
+            while (prevDone < need) {
+                prevDone = prev.load(std::memory_order_acquire);
+            }
+            
+            diffusion_span<Atkinson, 1>(grayRow, out, e0, e1, e2, x, count, *job.lut, job.map);
+            mine.store(y * w + x + count, std::memory_order_release);
+        }
+        if (packed) {
+            pack_row(out, job.dst, w, y, job.output);
+        }
+        
+        // Finished (row y-1 is done too): only the padding still holds error
+        e0[-2] = e0[-1] = 0;
+        e0[w] = e0[w + 1] = 0;
+    }
+}
+
+/**
+ * @brief Serial diffusion loops by [source format][Atkinson]
+ */
+static constexpr void (*s_diffusionSerial[static_cast<int>(SourceFormat::COUNT)][2])(const DiffusionJob&) = {
+    { diffusion_serial<SourceFormat::GRAYSCALE, false>, diffusion_serial<SourceFormat::GRAYSCALE, true> },
+    { diffusion_serial<SourceFormat::RGB888, false>,    diffusion_serial<SourceFormat::RGB888, true> },
+    { diffusion_serial<SourceFormat::RGB565, false>,    diffusion_serial<SourceFormat::RGB565, true> },
+    { diffusion_serial<SourceFormat::YUV422, false>,    diffusion_serial<SourceFormat::YUV422, true> },
+    { diffusion_serial<SourceFormat::RGB565_BE, false>, diffusion_serial<SourceFormat::RGB565_BE, true> },
+};
+
+/**
+ * @brief Wavefront row loops by [source format][Atkinson]
+ */
+static constexpr void (*s_wavefrontRows[static_cast<int>(SourceFormat::COUNT)][2])(DiffusionJob&, int) = {
+    { wavefront_rows<SourceFormat::GRAYSCALE, false>, wavefront_rows<SourceFormat::GRAYSCALE, true> },
+    { wavefront_rows<SourceFormat::RGB888, false>,    wavefront_rows<SourceFormat::RGB888, true> },
+    { wavefront_rows<SourceFormat::RGB565, false>,    wavefront_rows<SourceFormat::RGB565, true> },
+    { wavefront_rows<SourceFormat::YUV422, false>,    wavefront_rows<SourceFormat::YUV422, true> },
+    { wavefront_rows<SourceFormat::RGB565_BE, false>, wavefront_rows<SourceFormat::RGB565_BE, true> },
+};
+
+static void wavefront_worker_entry(void* arg) {
+    DiffusionJob* job = static_cast<DiffusionJob*>(arg);
+    job->wavefront(*job, 1);
+}
+
+/**
+ * @brief Try to run an error-diffusion job as a two-core wavefront
+ * 
+ * Output is bit-identical to the serial kernels without serpentine (a
+ * reversed row would have to wait for the whole previous row). SSD1306
+ * pages are refused: neighbouring rows share their bytes.
+ * 
+ * @param job Job with src/dst/lut/map/output/wavefront filled in
+ * @param atkinson Atkinson instead of Floyd–Steinberg
+ * @return true if the image was dithered; false means run it serially
+ */
+static bool wavefront_dither(DiffusionJob& job, bool atkinson) {
+    if (job.serpentine || job.h < 2 * PARALLEL_MIN_ROWS ||
+        job.output == DitherOutput::SSD1306_PAGES || !error_ring_alloc()) {
+        return false;
+    }
+    
+    job.slots = atkinson ? 4 : 3;
+    job.lag = atkinson ? 4 : 3;
+    job.done[0].store(0, std::memory_order_relaxed);
+    job.done[1].store(0, std::memory_order_relaxed);
+    memset(s_errors.storage, 0, job.slots * ERROR_ROW_LEN * sizeof(int16_t));
+    
+    if (!worker_dispatch(wavefront_worker_entry, &job)) {
+        return false;
+    }
+    job.wavefront(job, 0);
+    worker_join();
+    return true;
+}
+
+/**
+ * @brief Error-diffusion entry shared by every public variant
+ * 
+ * Rows are converted to gray one at a time; diffusion only needs the
+ * current row plus the error ring. With `parallel` and no serpentine the
+ * rows run as a two-core wavefront instead.
+ * 
+ * @param src Source buffer
+ * @param srcFormat Source format
+ * @param dst Output buffer
+ * @param w Image width
+ * @param h Image height
+ * @param palette Palette for quantization
+ * @param atkinson Atkinson instead of Floyd–Steinberg
+ * @param serpentine Alternate scan direction per row
+ * @param indices Write tone indices instead of tone values
+ * @param parallel Run as a two-core wavefront when possible
+ * @param output Index layout (tone values are always one byte per pixel)
+ * @return false if the error ring could not be allocated
+ */
+static bool error_diffusion(const uint8_t* src, SourceFormat srcFormat, uint8_t* dst,
+                            int w, int h, const Palette& palette, bool atkinson,
+                            bool serpentine, bool indices, bool parallel,
+                            DitherOutput output = DitherOutput::INDICES) {
+    // Nearest-tone tables, one lookup per pixel instead of a tone search
+    PaletteLut lutScratch;
+    const PaletteLut& lut = output_lut(palette, output, lutScratch);
+    const int format = static_cast<int>(srcFormat);
+    
+    DiffusionJob job;
+    job.src = src;
+    job.dst = dst;
+    job.w = w;
+    job.h = h;
+    job.lut = &lut;
+    job.map = indices ? lut.index : lut.tone;
+    job.output = output;
+    job.serpentine = serpentine;
+    job.wavefront = s_wavefrontRows[format][atkinson];
+    
+    ErrorRingGuard guard;
+    if (parallel && wavefront_dither(job, atkinson)) {
+        return true;
+    }
+    
+    if (!error_ring_begin(atkinson ? 3 : 2)) {
+        return false;
+    }
+    s_diffusionSerial[format][atkinson](job);
+    return true;
+}
+
+// =============================================================================
+// Streaming State
+// =============================================================================
+
+/**
+ * @brief Row converters by source format (one row, in place of source_row())
+ */
+static constexpr void (*s_convertRow[static_cast<int>(SourceFormat::COUNT)])(
+    const uint8_t*, uint8_t*, int, int) = {
+    convert_row_to_gray<SourceFormat::GRAYSCALE>,
+    convert_row_to_gray<SourceFormat::RGB888>,
+    convert_row_to_gray<SourceFormat::RGB565>,
+    convert_row_to_gray<SourceFormat::YUV422>,
+    convert_row_to_gray<SourceFormat::RGB565_BE>,
+};
+
+/**
+ * @brief The open dither_begin() stream
+ * 
+ * The stream owns its error rows and row buffers (one allocation, sized to
+ * its width) instead of borrowing s_errors, so whole-frame calls made while
+ * a stream is open do not disturb its carried error. The nearest-tone
+ * tables are copied because the caller's palette may not outlive begin.
+ */
+struct DitherStream {
+    bool active;
+    const char* error;          // First failure, reported by dither_end()
+    DitherConfig config;
+    SourceFormat srcFormat;
+    int w;
+    int y;                      // Rows pushed so far
+    PaletteLut lut;
+    ErrorRing errors;           // storage is the whole allocation
+    uint8_t* grayBuf;           // Converted source row
+    uint8_t* indexBuf;          // Tone indices of the current row
+    uint8_t* packBuf;           // Packed row or SSD1306 page being built
+    DitherRowSink sink;
+    void* user;
+};
+
+static DitherStream s_stream = {};
+
+/**
+ * @brief Allocate the stream buffers (internal RAM first, then any heap)
+ * 
+ * @param w Row width
+ * @param diffusion Reserve error rows
+ * @return true if the buffers are available
+ */
+static bool stream_alloc(int w, bool diffusion) {
+    const size_t rowLen = static_cast<size_t>(w) + 2 * ERROR_PAD;
+    const size_t errorBytes = diffusion ? ((3 * rowLen * sizeof(int16_t) + 3) & ~static_cast<size_t>(3)) : 0;
+    const size_t stride = (static_cast<size_t>(w) + 3) & ~static_cast<size_t>(3);
+    const size_t bytes = errorBytes + 3 * stride;
+    
+#ifdef ESP32
+    uint8_t* block = static_cast<uint8_t*>(
+        heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    if (block == nullptr) {
+        block = static_cast<uint8_t*>(heap_caps_malloc(bytes, MALLOC_CAP_8BIT));
+    }
+#else
+    uint8_t* block = static_cast<uint8_t*>(malloc(bytes));
+#endif
+    if (block == nullptr) {
+        return false;
+    }
+    
+    s_stream.errors.storage = reinterpret_cast<int16_t*>(block);
+    for (int i = 0; i < 3; ++i) {
+        s_stream.errors.rows[i] = s_stream.errors.storage + i * rowLen;
+    }
+    memset(block, 0, errorBytes);
+    s_stream.grayBuf = block + errorBytes;
+    s_stream.indexBuf = s_stream.grayBuf + stride;
+    s_stream.packBuf = s_stream.indexBuf + stride;
+    return true;
+}
+
+/**
+ * @brief Release the stream buffers and close the stream
+ */
+static void stream_free() {
+#ifdef ESP32
+    heap_caps_free(s_stream.errors.storage);
+#else
+    free(s_stream.errors.storage);
+#endif
+    s_stream = {};
+}
+
+/**
+ * @brief Error-diffuse one streamed row through the stream's own ring
+ * 
+ * Same kernel and serpentine rule as diffusion_serial(), so a streamed
+ * image matches the whole-frame result exactly.
+ * 
+ * @tparam Atkinson Atkinson instead of Floyd–Steinberg
+ * @param gray Gray row
+ */
+template <bool Atkinson>
+static void stream_diffuse(const uint8_t* gray) {
+    DitherStream& s = s_stream;
+    int16_t* e0 = s.errors.rows[0] + ERROR_PAD;
+    int16_t* e1 = s.errors.rows[1] + ERROR_PAD;
+    int16_t* e2 = s.errors.rows[2] + ERROR_PAD;
+    
+    if (!s.config.serpentine || ((s.y & 1) == 0)) {
+        diffusion_span<Atkinson, 1>(gray, s.indexBuf, e0, e1, e2, 0, s.w, s.lut, s.lut.index);
     } else {
-        // Row0 = Row1, Row1 = 0
-        memcpy(s_errorRow0, s_errorRow1, bufLen * sizeof(int16_t));
-        memset(s_errorRow1, 0, bufLen * sizeof(int16_t));
+        diffusion_span<Atkinson, -1>(gray, s.indexBuf, e0, e1, e2, s.w - 1, s.w, s.lut, s.lut.index);
     }
+    error_ring_advance(s.errors, s.w, Atkinson ? 3 : 2);
+}
+
+/**
+ * @brief Hand finished output to the sink
+ * 
+ * @param data Output bytes
+ * @param y First image row they cover
+ * @param bytes Byte count
+ * @return false if the sink aborted
+ */
+static bool stream_emit(const uint8_t* data, int y, size_t bytes) {
+    if (!s_stream.sink(s_stream.user, y, data, bytes)) {
+        s_stream.error = "Sink aborted";
+        return false;
+    }
+    return true;
 }
 
 // =============================================================================
@@ -270,11 +1391,26 @@ void dither_init() {
         return;  // Idempotent
     }
     
-    // Initialize default configuration
-    s_config = DitherConfig();
+    // Initialize default configuration (and its threshold tables)
+    dither_set_config(DitherConfig());
     
-    // Clear error buffers
-    clear_error_buffers(DITHER_MAX_WIDTH, true);
+    // Error rows live in internal RAM for the whole session
+    error_ring_alloc();
+    
+    // For placement::logReport(): threshold tables and one kernel of each kind
+    placement::note("Bayer8x8", s_bayer8x8, sizeof(s_bayer8x8));
+    placement::note("Ordered8x8Table", &s_ordered8x8, sizeof(s_ordered8x8));
+    placement::note("Ordered4x4Table", &s_ordered4x4, sizeof(s_ordered4x4));
+    placement::note("BlueNoiseTable", &s_blueNoise, sizeof(s_blueNoise));
+    placement::note("ordered_band", reinterpret_cast<const void*>(
+        &ordered_band<SourceFormat::RGB565_BE, false>), 0);
+    placement::note("diffusion_span", reinterpret_cast<const void*>(
+        &diffusion_span<false, 1>), 0);
+    
+#if DITHER_HAS_WORKER
+    // Second-core worker for DitherConfig::parallel
+    worker_start();
+#endif
     
     s_initialized = true;
 }
@@ -288,8 +1424,10 @@ void dither_shutdown() {
         return;
     }
     
-    // Clear buffers for security
-    clear_error_buffers(DITHER_MAX_WIDTH, true);
+    error_ring_free();
+    if (s_stream.active) {
+        stream_free();
+    }
     
     s_initialized = false;
 }
@@ -307,6 +1445,7 @@ void apply_dither(
     DitherAlgorithm algo
 ) {
     DitherConfig config(algo);
+    config.parallel = s_config.parallel;
     apply_dither_ex(src, dst, w, h, palette, config);
 }
 
@@ -330,20 +1469,27 @@ bool apply_dither_ex(
     // Dispatch to appropriate algorithm
     switch (config.algorithm) {
         case DitherAlgorithm::ORDERED_8X8:
-            dither_ordered_8x8(src, dst, w, h, palette, config.strength);
+            ordered_dither(src, SourceFormat::GRAYSCALE, dst, w, h, palette,
+                           BAYER_8X8_SIZE, config.strength, false, config.parallel);
             break;
             
         case DitherAlgorithm::ORDERED_4X4:
-            dither_ordered_4x4(src, dst, w, h, palette, config.strength);
+            ordered_dither(src, SourceFormat::GRAYSCALE, dst, w, h, palette,
+                           BAYER_4X4_SIZE, config.strength, false, config.parallel);
+            break;
+            
+        case DitherAlgorithm::BLUE_NOISE:
+            ordered_dither(src, SourceFormat::GRAYSCALE, dst, w, h, palette,
+                           BLUE_NOISE_SIZE, config.strength, false, config.parallel);
             break;
             
         case DitherAlgorithm::FLOYD_STEINBERG:
-            dither_floyd_steinberg(src, dst, w, h, palette, config.serpentine);
-            break;
+            return error_diffusion(src, SourceFormat::GRAYSCALE, dst, w, h, palette,
+                                   false, config.serpentine, false, config.parallel);
             
         case DitherAlgorithm::ATKINSON:
-            dither_atkinson(src, dst, w, h, palette, config.serpentine);
-            break;
+            return error_diffusion(src, SourceFormat::GRAYSCALE, dst, w, h, palette,
+                                   true, config.serpentine, false, config.parallel);
             
         default:
             return false;
@@ -358,6 +1504,11 @@ bool apply_dither_ex(
 
 void dither_set_config(const DitherConfig& config) {
     s_config = config;
+    
+    // Warm the threshold caches so the first frame pays nothing
+    ordered_rows_8x8(config.strength);
+    ordered_rows_4x4(config.strength);
+    noise_rows(config.strength);
 }
 
 const DitherConfig& dither_get_config() {
@@ -429,31 +1580,8 @@ void dither_ordered_8x8(
     const Palette& palette,
     uint8_t strength
 ) {
-    // Process row by row for cache efficiency
-    for (int y = 0; y < h; ++y) {
-        // Precompute row offset in source/dest
-        const int rowOffset = y * w;
-        
-        // Precompute y modulo for Bayer lookup
-        const int yMod = y & 7;  // y % 8 using bitmask
-        
-        for (int x = 0; x < w; ++x) {
-            // Get source pixel
-            const uint8_t srcPixel = src[rowOffset + x];
-            
-            // Get threshold from Bayer matrix (PROGMEM read)
-            const int xMod = x & 7;  // x % 8 using bitmask
-            const uint8_t threshold = pgm_read_byte(&s_bayer8x8[yMod][xMod]);
-            
-            // Apply threshold offset scaled by strength
-            const int offset = scale_threshold(threshold, strength);
-            const int adjusted = static_cast<int>(srcPixel) + offset;
-            
-            // Clamp and map to palette
-            const uint8_t clamped = clamp_u8(adjusted);
-            dst[rowOffset + x] = palette_map_value(clamped, palette);
-        }
-    }
+    ordered_dither(src, SourceFormat::GRAYSCALE, dst, w, h, palette,
+                   BAYER_8X8_SIZE, strength, false, false);
 }
 
 // =============================================================================
@@ -468,27 +1596,24 @@ void dither_ordered_4x4(
     const Palette& palette,
     uint8_t strength
 ) {
-    // Process row by row for cache efficiency
-    for (int y = 0; y < h; ++y) {
-        const int rowOffset = y * w;
-        const int yMod = y & 3;  // y % 4 using bitmask
-        
-        for (int x = 0; x < w; ++x) {
-            const uint8_t srcPixel = src[rowOffset + x];
-            
-            // Get threshold from Bayer matrix
-            const int xMod = x & 3;  // x % 4 using bitmask
-            const uint8_t threshold = pgm_read_byte(&s_bayer4x4[yMod][xMod]);
-            
-            // Apply threshold offset scaled by strength
-            const int offset = scale_threshold(threshold, strength);
-            const int adjusted = static_cast<int>(srcPixel) + offset;
-            
-            // Clamp and map to palette
-            const uint8_t clamped = clamp_u8(adjusted);
-            dst[rowOffset + x] = palette_map_value(clamped, palette);
-        }
-    }
+    ordered_dither(src, SourceFormat::GRAYSCALE, dst, w, h, palette,
+                   BAYER_4X4_SIZE, strength, false, false);
+}
+
+// =============================================================================
+// Low-Level API - Blue-Noise Dithering
+// =============================================================================
+
+void dither_blue_noise(
+    const uint8_t* src,
+    uint8_t* dst,
+    int w,
+    int h,
+    const Palette& palette,
+    uint8_t strength
+) {
+    ordered_dither(src, SourceFormat::GRAYSCALE, dst, w, h, palette,
+                   BLUE_NOISE_SIZE, strength, false, false);
 }
 
 // =============================================================================
@@ -504,7 +1629,7 @@ void dither_ordered_4x4(
  * 
  * Using fixed-point with denominator 16 for integer math.
  */
-void dither_floyd_steinberg(
+bool dither_floyd_steinberg(
     const uint8_t* src,
     uint8_t* dst,
     int w,
@@ -512,75 +1637,8 @@ void dither_floyd_steinberg(
     const Palette& palette,
     bool serpentine
 ) {
-    // Clear error buffers
-    clear_error_buffers(w, false);
-    
-    // Error buffer index offset (2 pixels padding on left)
-    const int errOffset = 2;
-    
-    for (int y = 0; y < h; ++y) {
-        const int rowOffset = y * w;
-        
-        // Determine scan direction for serpentine
-        const bool leftToRight = !serpentine || ((y & 1) == 0);
-        
-        const int xStart = leftToRight ? 0 : (w - 1);
-        const int xEnd = leftToRight ? w : -1;
-        const int xStep = leftToRight ? 1 : -1;
-        
-        for (int x = xStart; x != xEnd; x += xStep) {
-            // Get source pixel with accumulated error
-            int pixel = static_cast<int>(src[rowOffset + x]) + s_errorRow0[x + errOffset];
-            pixel = clamp_u8(pixel);
-            
-            // Quantize to nearest palette tone
-            const uint8_t quantized = palette_map_value(static_cast<uint8_t>(pixel), palette);
-            dst[rowOffset + x] = quantized;
-            
-            // Calculate quantization error
-            const int error = pixel - static_cast<int>(quantized);
-            
-            // Distribute error to neighbors using fixed-point arithmetic
-            // Floyd-Steinberg weights: 7/16, 3/16, 5/16, 1/16
-            
-            if (leftToRight) {
-                // Standard left-to-right distribution
-                //       * 7/16
-                // 3/16 5/16 1/16
-                
-                // Right neighbor (same row): 7/16
-                s_errorRow0[x + errOffset + 1] += (error * 7) >> 4;
-                
-                // Bottom-left neighbor: 3/16
-                s_errorRow1[x + errOffset - 1] += (error * 3) >> 4;
-                
-                // Bottom neighbor: 5/16
-                s_errorRow1[x + errOffset] += (error * 5) >> 4;
-                
-                // Bottom-right neighbor: 1/16
-                s_errorRow1[x + errOffset + 1] += (error * 1) >> 4;
-            } else {
-                // Right-to-left (mirrored) distribution
-                // 7/16 *
-                // 1/16 5/16 3/16
-                
-                // Left neighbor (same row): 7/16
-                s_errorRow0[x + errOffset - 1] += (error * 7) >> 4;
-                
-                // Bottom-right neighbor: 3/16
-                s_errorRow1[x + errOffset + 1] += (error * 3) >> 4;
-                
-                // Bottom neighbor: 5/16
-                s_errorRow1[x + errOffset] += (error * 5) >> 4;
-                
-                // Bottom-left neighbor: 1/16
-                s_errorRow1[x + errOffset - 1] += (error * 1) >> 4;
-            }
-        }
-        
-        // Rotate error buffers for next row
-        rotate_error_buffers(w, false);
-    }
+    return error_diffusion(src, SourceFormat::GRAYSCALE, dst, w, h, palette,
+                           false, serpentine, false, false);
 }
 
 // =============================================================================
@@ -598,7 +1656,7 @@ void dither_floyd_steinberg(
  * Total: 6/8 = 75% of error propagated (25% discarded)
  * This gives more contrast than Floyd-Steinberg.
  */
-void dither_atkinson(
+bool dither_atkinson(
     const uint8_t* src,
     uint8_t* dst,
     int w,
@@ -606,349 +1664,14 @@ void dither_atkinson(
     const Palette& palette,
     bool serpentine
 ) {
-    // Clear error buffers (including row2 for Atkinson)
-    clear_error_buffers(w, true);
-    
-    // Error buffer index offset
-    const int errOffset = 2;
-    
-    for (int y = 0; y < h; ++y) {
-        const int rowOffset = y * w;
-        
-        // Determine scan direction
-        const bool leftToRight = !serpentine || ((y & 1) == 0);
-        
-        const int xStart = leftToRight ? 0 : (w - 1);
-        const int xEnd = leftToRight ? w : -1;
-        const int xStep = leftToRight ? 1 : -1;
-        
-        for (int x = xStart; x != xEnd; x += xStep) {
-            // Get source pixel with accumulated error
-            int pixel = static_cast<int>(src[rowOffset + x]) + s_errorRow0[x + errOffset];
-            pixel = clamp_u8(pixel);
-            
-            // Quantize to nearest palette tone
-            const uint8_t quantized = palette_map_value(static_cast<uint8_t>(pixel), palette);
-            dst[rowOffset + x] = quantized;
-            
-            // Calculate quantization error
-            // Atkinson uses 1/8 for each of 6 neighbors (6/8 total)
-            const int error = pixel - static_cast<int>(quantized);
-            const int errFrac = error >> 3;  // error / 8
-            
-            if (leftToRight) {
-                // Standard left-to-right distribution
-                //     * 1/8 1/8
-                // 1/8 1/8 1/8
-                //     1/8
-                
-                // Same row: x+1, x+2
-                s_errorRow0[x + errOffset + 1] += errFrac;
-                s_errorRow0[x + errOffset + 2] += errFrac;
-                
-                // Next row: x-1, x, x+1
-                s_errorRow1[x + errOffset - 1] += errFrac;
-                s_errorRow1[x + errOffset] += errFrac;
-                s_errorRow1[x + errOffset + 1] += errFrac;
-                
-                // Row after next: x
-                s_errorRow2[x + errOffset] += errFrac;
-            } else {
-                // Right-to-left (mirrored) distribution
-                // 1/8 1/8 *
-                //     1/8 1/8 1/8
-                //         1/8
-                
-                // Same row: x-1, x-2
-                s_errorRow0[x + errOffset - 1] += errFrac;
-                s_errorRow0[x + errOffset - 2] += errFrac;
-                
-                // Next row: x+1, x, x-1
-                s_errorRow1[x + errOffset + 1] += errFrac;
-                s_errorRow1[x + errOffset] += errFrac;
-                s_errorRow1[x + errOffset - 1] += errFrac;
-                
-                // Row after next: x
-                s_errorRow2[x + errOffset] += errFrac;
-            }
-        }
-        
-        // Rotate error buffers for next row
-        rotate_error_buffers(w, true);
-    }
+    return error_diffusion(src, SourceFormat::GRAYSCALE, dst, w, h, palette,
+                           true, serpentine, false, false);
 }
 
 // =============================================================================
 // Primary API - apply_palette_dither()
 // =============================================================================
 
-/**
- * @brief Static grayscale buffer for format conversion
- * 
- * Used when input is RGB and needs conversion to grayscale before dithering.
- * Size: DITHER_MAX_WIDTH * DITHER_MAX_HEIGHT = 307,200 bytes
- * 
- * TODO v1.3.1: Consider PSRAM allocation for larger buffers
- */
-static uint8_t s_grayBuffer[DITHER_MAX_WIDTH * 4];  // 4 rows for streaming conversion
-
-/**
- * @brief Convert source buffer to grayscale row by row
- * 
- * @param src Source buffer
- * @param srcFormat Source format
- * @param grayRow Output grayscale row buffer
- * @param row Row index
- * @param w Image width
- */
-static void convert_row_to_gray(
-    const uint8_t* src,
-    SourceFormat srcFormat,
-    uint8_t* grayRow,
-    int row,
-    int w
-) {
-    switch (srcFormat) {
-        case SourceFormat::GRAYSCALE:
-            // Direct copy
-            memcpy(grayRow, src + row * w, w);
-            break;
-            
-        case SourceFormat::RGB888: {
-            const uint8_t* srcRow = src + row * w * 3;
-            for (int x = 0; x < w; ++x) {
-                const uint8_t* p = srcRow + x * 3;
-                grayRow[x] = rgb_to_luma(p[0], p[1], p[2]);
-            }
-            break;
-        }
-        
-        case SourceFormat::RGB565: {
-            const uint16_t* srcRow = reinterpret_cast<const uint16_t*>(src) + row * w;
-            for (int x = 0; x < w; ++x) {
-                grayRow[x] = rgb565_to_luma(srcRow[x]);
-            }
-            break;
-        }
-    }
-}
-
-/**
- * @brief Internal ordered dithering with index output
- * 
- * Same as dither_ordered_8x8 but outputs tone indices instead of values.
- */
-static void ordered_8x8_to_indices(
-    const uint8_t* src,
-    SourceFormat srcFormat,
-    uint8_t* dstIndices,
-    int w,
-    int h,
-    const Palette& palette,
-    uint8_t strength
-) {
-    // Row buffer for format conversion
-    uint8_t rowBuf[DITHER_MAX_WIDTH];
-    
-    for (int y = 0; y < h; ++y) {
-        // Convert row to grayscale if needed
-        const uint8_t* grayRow;
-        if (srcFormat == SourceFormat::GRAYSCALE) {
-            grayRow = src + y * w;
-        } else {
-            convert_row_to_gray(src, srcFormat, rowBuf, y, w);
-            grayRow = rowBuf;
-        }
-        
-        const int rowOffset = y * w;
-        const int yMod = y & 7;
-        
-        for (int x = 0; x < w; ++x) {
-            const uint8_t srcPixel = grayRow[x];
-            const int xMod = x & 7;
-            const uint8_t threshold = pgm_read_byte(&s_bayer8x8[yMod][xMod]);
-            
-            const int offset = scale_threshold(threshold, strength);
-            const int adjusted = static_cast<int>(srcPixel) + offset;
-            const uint8_t clamped = clamp_u8(adjusted);
-            
-            // Output tone INDEX (0-3) instead of tone value
-            dstIndices[rowOffset + x] = find_closest_tone_index(clamped, palette);
-        }
-    }
-}
-
-/**
- * @brief Internal ordered 4x4 dithering with index output
- */
-static void ordered_4x4_to_indices(
-    const uint8_t* src,
-    SourceFormat srcFormat,
-    uint8_t* dstIndices,
-    int w,
-    int h,
-    const Palette& palette,
-    uint8_t strength
-) {
-    uint8_t rowBuf[DITHER_MAX_WIDTH];
-    
-    for (int y = 0; y < h; ++y) {
-        const uint8_t* grayRow;
-        if (srcFormat == SourceFormat::GRAYSCALE) {
-            grayRow = src + y * w;
-        } else {
-            convert_row_to_gray(src, srcFormat, rowBuf, y, w);
-            grayRow = rowBuf;
-        }
-        
-        const int rowOffset = y * w;
-        const int yMod = y & 3;
-        
-        for (int x = 0; x < w; ++x) {
-            const uint8_t srcPixel = grayRow[x];
-            const int xMod = x & 3;
-            const uint8_t threshold = pgm_read_byte(&s_bayer4x4[yMod][xMod]);
-            
-            const int offset = scale_threshold(threshold, strength);
-            const int adjusted = static_cast<int>(srcPixel) + offset;
-            const uint8_t clamped = clamp_u8(adjusted);
-            
-            dstIndices[rowOffset + x] = find_closest_tone_index(clamped, palette);
-        }
-    }
-}
-
-/**
- * @brief Internal Floyd-Steinberg with index output
- */
-static void floyd_steinberg_to_indices(
-    const uint8_t* src,
-    SourceFormat srcFormat,
-    uint8_t* dstIndices,
-    int w,
-    int h,
-    const Palette& palette,
-    bool serpentine
-) {
-    // Convert entire image to grayscale first for error diffusion
-    // (Error diffusion needs access to neighboring pixels)
-    static uint8_t s_fullGrayBuf[DITHER_MAX_WIDTH * DITHER_MAX_HEIGHT];
-    
-    // Convert all rows
-    for (int y = 0; y < h; ++y) {
-        convert_row_to_gray(src, srcFormat, s_fullGrayBuf + y * w, y, w);
-    }
-    
-    // Clear error buffers
-    clear_error_buffers(w, false);
-    
-    const int errOffset = 2;
-    
-    for (int y = 0; y < h; ++y) {
-        const int rowOffset = y * w;
-        
-        const bool leftToRight = !serpentine || ((y & 1) == 0);
-        
-        const int xStart = leftToRight ? 0 : (w - 1);
-        const int xEnd = leftToRight ? w : -1;
-        const int xStep = leftToRight ? 1 : -1;
-        
-        for (int x = xStart; x != xEnd; x += xStep) {
-            int pixel = static_cast<int>(s_fullGrayBuf[rowOffset + x]) + s_errorRow0[x + errOffset];
-            pixel = clamp_u8(pixel);
-            
-            // Find closest tone INDEX
-            const uint8_t toneIndex = find_closest_tone_index(static_cast<uint8_t>(pixel), palette);
-            dstIndices[rowOffset + x] = toneIndex;
-            
-            // Get the actual tone value for error calculation
-            const uint8_t quantized = palette.tones[toneIndex];
-            const int error = pixel - static_cast<int>(quantized);
-            
-            // Floyd-Steinberg error distribution
-            if (leftToRight) {
-                s_errorRow0[x + errOffset + 1] += (error * 7) >> 4;
-                s_errorRow1[x + errOffset - 1] += (error * 3) >> 4;
-                s_errorRow1[x + errOffset] += (error * 5) >> 4;
-                s_errorRow1[x + errOffset + 1] += (error * 1) >> 4;
-            } else {
-                s_errorRow0[x + errOffset - 1] += (error * 7) >> 4;
-                s_errorRow1[x + errOffset + 1] += (error * 3) >> 4;
-                s_errorRow1[x + errOffset] += (error * 5) >> 4;
-                s_errorRow1[x + errOffset - 1] += (error * 1) >> 4;
-            }
-        }
-        
-        rotate_error_buffers(w, false);
-    }
-}
-
-/**
- * @brief Internal Atkinson with index output
- */
-static void atkinson_to_indices(
-    const uint8_t* src,
-    SourceFormat srcFormat,
-    uint8_t* dstIndices,
-    int w,
-    int h,
-    const Palette& palette,
-    bool serpentine
-) {
-    // Convert entire image to grayscale first
-    static uint8_t s_fullGrayBuf[DITHER_MAX_WIDTH * DITHER_MAX_HEIGHT];
-    
-    for (int y = 0; y < h; ++y) {
-        convert_row_to_gray(src, srcFormat, s_fullGrayBuf + y * w, y, w);
-    }
-    
-    // Clear error buffers
-    clear_error_buffers(w, true);
-    
-    const int errOffset = 2;
-    
-    for (int y = 0; y < h; ++y) {
-        const int rowOffset = y * w;
-        
-        const bool leftToRight = !serpentine || ((y & 1) == 0);
-        
-        const int xStart = leftToRight ? 0 : (w - 1);
-        const int xEnd = leftToRight ? w : -1;
-        const int xStep = leftToRight ? 1 : -1;
-        
-        for (int x = xStart; x != xEnd; x += xStep) {
-            int pixel = static_cast<int>(s_fullGrayBuf[rowOffset + x]) + s_errorRow0[x + errOffset];
-            pixel = clamp_u8(pixel);
-            
-            const uint8_t toneIndex = find_closest_tone_index(static_cast<uint8_t>(pixel), palette);
-            dstIndices[rowOffset + x] = toneIndex;
-            
-            const uint8_t quantized = palette.tones[toneIndex];
-            const int error = pixel - static_cast<int>(quantized);
-            const int errFrac = error >> 3;  // error / 8
-            
-            // Atkinson distribution (6 neighbors, 1/8 each)
-            if (leftToRight) {
-                s_errorRow0[x + errOffset + 1] += errFrac;
-                s_errorRow0[x + errOffset + 2] += errFrac;
-                s_errorRow1[x + errOffset - 1] += errFrac;
-                s_errorRow1[x + errOffset] += errFrac;
-                s_errorRow1[x + errOffset + 1] += errFrac;
-                s_errorRow2[x + errOffset] += errFrac;
-            } else {
-                s_errorRow0[x + errOffset - 1] += errFrac;
-                s_errorRow0[x + errOffset - 2] += errFrac;
-                s_errorRow1[x + errOffset + 1] += errFrac;
-                s_errorRow1[x + errOffset] += errFrac;
-                s_errorRow1[x + errOffset - 1] += errFrac;
-                s_errorRow2[x + errOffset] += errFrac;
-            }
-        }
-        
-        rotate_error_buffers(w, true);
-    }
-}
-
 DitherResult apply_palette_dither(
     const uint8_t* src,
     SourceFormat srcFormat,
@@ -990,30 +1713,190 @@ DitherResult apply_palette_dither_ex(
     if (static_cast<uint8_t>(config.algorithm) >= static_cast<uint8_t>(DitherAlgorithm::COUNT)) {
         return DitherResult::Error("Invalid algorithm");
     }
+    if (static_cast<uint8_t>(config.output) >= static_cast<uint8_t>(DitherOutput::COUNT)) {
+        return DitherResult::Error("Invalid output layout");
+    }
+    if (static_cast<uint8_t>(srcFormat) >= static_cast<uint8_t>(SourceFormat::COUNT)) {
+        return DitherResult::Error("Invalid source format");
+    }
     
     // Dispatch to appropriate index-output algorithm
     switch (config.algorithm) {
         case DitherAlgorithm::ORDERED_8X8:
-            ordered_8x8_to_indices(src, srcFormat, dst, w, h, palette, config.strength);
+            ordered_dither(src, srcFormat, dst, w, h, palette,
+                           BAYER_8X8_SIZE, config.strength, true, config.parallel, config.output);
             break;
             
         case DitherAlgorithm::ORDERED_4X4:
-            ordered_4x4_to_indices(src, srcFormat, dst, w, h, palette, config.strength);
+            ordered_dither(src, srcFormat, dst, w, h, palette,
+                           BAYER_4X4_SIZE, config.strength, true, config.parallel, config.output);
+            break;
+            
+        case DitherAlgorithm::BLUE_NOISE:
+            ordered_dither(src, srcFormat, dst, w, h, palette,
+                           BLUE_NOISE_SIZE, config.strength, true, config.parallel, config.output);
             break;
             
         case DitherAlgorithm::FLOYD_STEINBERG:
-            floyd_steinberg_to_indices(src, srcFormat, dst, w, h, palette, config.serpentine);
+            if (!error_diffusion(src, srcFormat, dst, w, h, palette, false,
+                                 config.serpentine, true, config.parallel, config.output)) {
+                return DitherResult::Error("Error buffer allocation failed");
+            }
             break;
             
         case DitherAlgorithm::ATKINSON:
-            atkinson_to_indices(src, srcFormat, dst, w, h, palette, config.serpentine);
+            if (!error_diffusion(src, srcFormat, dst, w, h, palette, true,
+                                 config.serpentine, true, config.parallel, config.output)) {
+                return DitherResult::Error("Error buffer allocation failed");
+            }
             break;
             
         default:
             return DitherResult::Error("Unsupported algorithm");
     }
     
-    return DitherResult::Ok(static_cast<uint32_t>(w * h));
+    return DitherResult::Ok(static_cast<uint32_t>(w * h),
+                            static_cast<uint32_t>(dither_output_size(config.output, w, h)));
+}
+
+// =============================================================================
+// Streaming API
+// =============================================================================
+
+DitherResult dither_begin(
+    int w,
+    SourceFormat srcFormat,
+    const Palette& palette,
+    const DitherConfig& config,
+    DitherRowSink sink,
+    void* user
+) {
+    if (s_stream.active) {
+        return DitherResult::Error("Stream already open");
+    }
+    if (sink == nullptr) {
+        return DitherResult::Error("sink is null");
+    }
+    if (w <= 0 || w > DITHER_STREAM_MAX_WIDTH) {
+        return DitherResult::Error("Invalid width");
+    }
+    if (static_cast<uint8_t>(config.algorithm) >= static_cast<uint8_t>(DitherAlgorithm::COUNT)) {
+        return DitherResult::Error("Invalid algorithm");
+    }
+    if (static_cast<uint8_t>(config.output) >= static_cast<uint8_t>(DitherOutput::COUNT)) {
+        return DitherResult::Error("Invalid output layout");
+    }
+    if (static_cast<uint8_t>(srcFormat) >= static_cast<uint8_t>(SourceFormat::COUNT)) {
+        return DitherResult::Error("Invalid source format");
+    }
+    
+    if (!stream_alloc(w, dither_algorithm_uses_error_buffer(config.algorithm))) {
+        s_stream = {};
+        return DitherResult::Error("Stream buffer allocation failed");
+    }
+    
+    PaletteLut lutScratch;
+    s_stream.lut = output_lut(palette, config.output, lutScratch);
+    s_stream.config = config;
+    s_stream.srcFormat = srcFormat;
+    s_stream.w = w;
+    s_stream.y = 0;
+    s_stream.error = nullptr;
+    s_stream.sink = sink;
+    s_stream.user = user;
+    s_stream.active = true;
+    return DitherResult::Ok();
+}
+
+bool dither_push_row(const uint8_t* row) {
+    DitherStream& s = s_stream;
+    if (!s.active || s.error != nullptr) {
+        return false;
+    }
+    if (row == nullptr) {
+        s.error = "row is null";
+        return false;
+    }
+    
+    const int w = s.w;
+    const int y = s.y;
+    const uint8_t* gray = row;
+    if (s.srcFormat != SourceFormat::GRAYSCALE) {
+        s_convertRow[static_cast<int>(s.srcFormat)](row, s.grayBuf, 0, w);
+        gray = s.grayBuf;
+    }
+    
+    // Thresholds are looked up per row: another caller may have retuned the
+    // shared tables since the last push
+    const uint8_t strength = s.config.strength;
+    switch (s.config.algorithm) {
+        case DitherAlgorithm::ORDERED_8X8:
+            ordered_row(gray, s.indexBuf, w, ordered_rows_8x8(strength)[y & (BAYER_8X8_SIZE - 1)],
+                        s.lut.index);
+            break;
+            
+        case DitherAlgorithm::ORDERED_4X4:
+            ordered_row(gray, s.indexBuf, w, ordered_rows_4x4(strength)[y & (BAYER_4X4_SIZE - 1)],
+                        s.lut.index);
+            break;
+            
+        case DitherAlgorithm::BLUE_NOISE:
+            noise_row(gray, s.indexBuf, w,
+                      noise_rows(strength) + (y & (BLUE_NOISE_SIZE - 1)) * NOISE_ROW_WORDS,
+                      s.lut.index);
+            break;
+            
+        case DitherAlgorithm::FLOYD_STEINBERG:
+            stream_diffuse<false>(gray);
+            break;
+            
+        case DitherAlgorithm::ATKINSON:
+            stream_diffuse<true>(gray);
+            break;
+            
+        default:
+            break;
+    }
+    s.y = y + 1;
+    
+    switch (s.config.output) {
+        case DitherOutput::INDICES:
+            return stream_emit(s.indexBuf, y, static_cast<size_t>(w));
+            
+        case DitherOutput::SSD1306_PAGES:
+            // A page goes out once its 8th row is in; dither_end() flushes a partial one
+            pack_row(s.indexBuf, s.packBuf, w, y & 7, s.config.output);
+            return (y & 7) != 7 || stream_emit(s.packBuf, y - 7, static_cast<size_t>(w));
+            
+        default:
+            pack_row(s.indexBuf, s.packBuf, w, 0, s.config.output);
+            return stream_emit(s.packBuf, y, dither_output_size(s.config.output, w, 1));
+    }
+}
+
+DitherResult dither_end() {
+    if (!s_stream.active) {
+        return DitherResult::Error("No stream open");
+    }
+    
+    const int w = s_stream.w;
+    const int h = s_stream.y;
+    const DitherOutput output = s_stream.config.output;
+    if (s_stream.error == nullptr && output == DitherOutput::SSD1306_PAGES && (h & 7) != 0) {
+        stream_emit(s_stream.packBuf, h & ~7, static_cast<size_t>(w));
+    }
+    
+    const char* error = s_stream.error;
+    stream_free();
+    if (error != nullptr) {
+        return DitherResult::Error(error);
+    }
+    return DitherResult::Ok(static_cast<uint32_t>(w * h),
+                            static_cast<uint32_t>(dither_output_size(output, w, h)));
+}
+
+bool dither_stream_active() {
+    return s_stream.active;
 }
 
 // =============================================================================
@@ -1035,10 +1918,28 @@ void indices_to_grayscale(
     }
 }
 
+size_t dither_output_size(DitherOutput output, int w, int h) {
+    if (w <= 0 || h <= 0) {
+        return 0;
+    }
+    
+    const size_t width = static_cast<size_t>(w);
+    const size_t height = static_cast<size_t>(h);
+    switch (output) {
+        case DitherOutput::INDICES:       return width * height;
+        case DitherOutput::PACKED_2BPP:   return ((width + 3) / 4) * height;
+        case DitherOutput::PACKED_1BPP:   return ((width + 7) / 8) * height;
+        case DitherOutput::SSD1306_PAGES: return width * ((height + 7) / 8);
+        default:                          return 0;
+    }
+}
+
 uint8_t source_format_bpp(SourceFormat format) {
     switch (format) {
         case SourceFormat::GRAYSCALE: return 1;
         case SourceFormat::RGB565:    return 2;
+        case SourceFormat::YUV422:    return 2;
+        case SourceFormat::RGB565_BE: return 2;
         case SourceFormat::RGB888:    return 3;
         default:                      return 1;
     }
@@ -1049,6 +1950,8 @@ const char* source_format_name(SourceFormat format) {
         case SourceFormat::GRAYSCALE: return "Grayscale";
         case SourceFormat::RGB565:    return "RGB565";
         case SourceFormat::RGB888:    return "RGB888";
+        case SourceFormat::YUV422:    return "YUV422";
+        case SourceFormat::RGB565_BE: return "RGB565 BE";
         default:                      return "Unknown";
     }
 }
@@ -1078,7 +1981,7 @@ void dither_debug_print_matrix(uint8_t size) {
         for (int y = 0; y < 4; ++y) {
             Serial.print("  ");
             for (int x = 0; x < 4; ++x) {
-                Serial.printf("%3u ", pgm_read_byte(&s_bayer4x4[y][x]));
+                Serial.printf("%3u ", s_bayer4x4[y][x]);
             }
             Serial.println();
         }
@@ -1086,7 +1989,7 @@ void dither_debug_print_matrix(uint8_t size) {
         for (int y = 0; y < 8; ++y) {
             Serial.print("  ");
             for (int x = 0; x < 8; ++x) {
-                Serial.printf("%3u ", pgm_read_byte(&s_bayer8x8[y][x]));
+                Serial.printf("%3u ", s_bayer8x8[y][x]);
             }
             Serial.println();
         }
@@ -24,6 +24,7 @@
 #include "filters/palette.h"
 #include "pxlcam_config.h"
 #include <string.h>  // For memcpy, strncpy
+#include <stddef.h>  // For offsetof
 
 #if PXLCAM_FEATURE_CUSTOM_PALETTES
 #include "nvs_store.h"
@@ -43,6 +44,7 @@ namespace filters {
 namespace {
 constexpr const char* kLogTag = "palette";
 constexpr const char* kNvsKeyPaletteId = "palette_id";
+constexpr const char* kNvsKeyPaletteCache = "palette_cache";
 }
 #endif
 
@@ -65,6 +67,14 @@ static Palette s_palettes[TOTAL_PALETTE_COUNT];
  */
 static char s_custom_names[CUSTOM_PALETTE_COUNT][PALETTE_NAME_MAX_LEN];
 
+/**
+ * @brief Cached nearest-tone tables, parallel to s_palettes
+ * 
+ * Kept beside the registry rather than inside Palette so palettes built by
+ * callers stay the plain tones + name aggregate.
+ */
+static PaletteLut s_luts[TOTAL_PALETTE_COUNT];
+
 #if PXLCAM_FEATURE_CUSTOM_PALETTES
 /**
  * @brief Custom palette slot metadata
@@ -147,6 +157,51 @@ static inline uint8_t type_to_index(PaletteType type) {
     return idx;
 }
 
+/**
+ * @brief Nearest tone index by distance search
+ * 
+ * Reference mapping used to fill the lookup tables. Strict comparison, so
+ * ties resolve to the lower (darker) index.
+ * 
+ * @param value Input grayscale value
+ * @param tones Palette tones
+ * @return uint8_t Tone index (0-3)
+ */
+static uint8_t nearest_tone_index(uint8_t value, const uint8_t tones[PALETTE_TONE_COUNT]) {
+    uint8_t bestIndex = 0;
+    int16_t bestDist = 256;  // Maximum possible distance + 1
+    
+    for (uint8_t i = 0; i < PALETTE_TONE_COUNT; ++i) {
+        int16_t dist = static_cast<int16_t>(value) - static_cast<int16_t>(tones[i]);
+        if (dist < 0) dist = -dist;  // abs()
+        
+        if (dist < bestDist) {
+            bestDist = dist;
+            bestIndex = i;
+        }
+    }
+    
+    return bestIndex;
+}
+
+/**
+ * @brief Registry slot of a palette, or -1 if it is not a registry entry
+ */
+static inline int registry_index(const Palette& palette) {
+    const Palette* p = &palette;
+    if (p < s_palettes || p >= s_palettes + TOTAL_PALETTE_COUNT) {
+        return -1;
+    }
+    return static_cast<int>(p - s_palettes);
+}
+
+/**
+ * @brief Rebuild the cached tables after s_palettes[index].tones changed
+ */
+static inline void refresh_lut(uint8_t index) {
+    palette_build_lut(s_palettes[index], s_luts[index]);
+}
+
 /**
  * @brief Initialize a single palette entry
  * 
@@ -159,6 +214,7 @@ static void init_palette_entry(uint8_t index, const uint8_t tones[PALETTE_TONE_C
     
     memcpy(s_palettes[index].tones, tones, PALETTE_TONE_COUNT);
     s_palettes[index].name = name;
+    refresh_lut(index);
 }
 
 /**
@@ -174,6 +230,7 @@ static void init_custom_palette_entry(uint8_t customIndex, const uint8_t tones[P
     const uint8_t arrayIndex = BUILTIN_PALETTE_COUNT + customIndex;
     
     memcpy(s_palettes[arrayIndex].tones, tones, PALETTE_TONE_COUNT);
+    refresh_lut(arrayIndex);
     
     // Copy name to mutable buffer
     strncpy(s_custom_names[customIndex], name, PALETTE_NAME_MAX_LEN - 1);
@@ -323,39 +380,38 @@ PaletteType palette_get_default_type() {
 // =============================================================================
 
 uint8_t palette_map_value(uint8_t value, const Palette& palette) {
-    // Compute distance to each tone and find the closest
-    uint8_t bestIndex = 0;
-    int16_t bestDist = 256;  // Maximum possible distance + 1
-    
-    for (uint8_t i = 0; i < PALETTE_TONE_COUNT; ++i) {
-        int16_t dist = static_cast<int16_t>(value) - static_cast<int16_t>(palette.tones[i]);
-        if (dist < 0) dist = -dist;  // abs()
-        
-        if (dist < bestDist) {
-            bestDist = dist;
-            bestIndex = i;
-        }
+    const int idx = registry_index(palette);
+    if (idx >= 0) {
+        return s_luts[idx].tone[value];
     }
-    
-    return palette.tones[bestIndex];
+    return palette.tones[nearest_tone_index(value, palette.tones)];
 }
 
 uint8_t palette_map_index(uint8_t value, const Palette& palette) {
-    // Same algorithm as palette_map_value, but returns index
-    uint8_t bestIndex = 0;
-    int16_t bestDist = 256;
-    
-    for (uint8_t i = 0; i < PALETTE_TONE_COUNT; ++i) {
-        int16_t dist = static_cast<int16_t>(value) - static_cast<int16_t>(palette.tones[i]);
-        if (dist < 0) dist = -dist;
-        
-        if (dist < bestDist) {
-            bestDist = dist;
-            bestIndex = i;
-        }
+    const int idx = registry_index(palette);
+    if (idx >= 0) {
+        return s_luts[idx].index[value];
     }
-    
-    return bestIndex;
+    return nearest_tone_index(value, palette.tones);
+}
+
+void palette_build_lut(const Palette& palette, PaletteLut& outLut) {
+    // Nearest tone is monotonic in value for sorted tones, but custom
+    // palettes may be unsorted, so each entry is searched independently
+    for (int v = 0; v < 256; ++v) {
+        const uint8_t idx = nearest_tone_index(static_cast<uint8_t>(v), palette.tones);
+        outLut.index[v] = idx;
+        outLut.tone[v] = palette.tones[idx];
+    }
+}
+
+const PaletteLut& palette_lut(const Palette& palette, PaletteLut& scratch) {
+    const int idx = registry_index(palette);
+    if (idx >= 0) {
+        return s_luts[idx];
+    }
+    palette_build_lut(palette, scratch);
+    return scratch;
 }
 
 // =============================================================================
@@ -373,6 +429,7 @@ bool palette_set_custom(PaletteType type, const uint8_t tones[PALETTE_TONE_COUNT
     
     // Copy tones
     memcpy(s_palettes[arrayIndex].tones, tones, PALETTE_TONE_COUNT);
+    refresh_lut(arrayIndex);
     
     // Copy name if provided
     if (name != nullptr) {
@@ -481,6 +538,7 @@ bool palette_set_custom_slot(PaletteType type, const Palette& palette) {
     
     // Copy tones
     memcpy(s_palettes[arrayIndex].tones, palette.tones, PALETTE_TONE_COUNT);
+    refresh_lut(arrayIndex);
     
     // Copy name
     if (palette.name != nullptr) {
@@ -666,6 +724,154 @@ bool parse_palette_object(const char* json, Palette& outPalette, char* nameBuffe
 
 } // anonymous namespace
 
+// =============================================================================
+// NVS Palette Cache
+// =============================================================================
+
+namespace {
+
+constexpr uint8_t kPaletteCacheVersion = 1;
+
+/**
+ * @brief Binary snapshot of the custom slots as parsed from palettes.json
+ * 
+ * Stamped with the file's size and mtime: while both match, boot restores
+ * the slots from NVS instead of reading and parsing the JSON. Without a
+ * mounted SD card the last snapshot is used as is. The selection itself
+ * stays under kNvsKeyPaletteId.
+ */
+struct PaletteCache {
+    uint8_t version;                    ///< kPaletteCacheVersion
+    uint8_t loadedMask;                 ///< Bit i: custom slot i holds file data
+    uint8_t reserved[2];
+    uint32_t fileSize;                  ///< 0 = no palettes.json
+    uint32_t fileMtime;
+    uint8_t tones[CUSTOM_PALETTE_COUNT][PALETTE_TONE_COUNT];
+    char names[CUSTOM_PALETTE_COUNT][PALETTE_NAME_MAX_LEN];
+    uint32_t checksum;                  ///< FNV-1a of every field above
+};
+
+/**
+ * @brief FNV-1a over the cache, up to the checksum field
+ */
+uint32_t cache_checksum(const PaletteCache& cache) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&cache);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(PaletteCache, checksum); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Size and mtime of palettes.json (both 0 when there is no file)
+ * @return false if the file exists but cannot be opened
+ */
+bool stat_palette_file(uint32_t& size, uint32_t& mtime) {
+    size = 0;
+    mtime = 0;
+    if (!SD_MMC.exists(PALETTE_SD_PATH)) {
+        return true;
+    }
+    
+    File file = SD_MMC.open(PALETTE_SD_PATH, FILE_READ);
+    if (!file) {
+        return false;
+    }
+    size = static_cast<uint32_t>(file.size());
+    mtime = static_cast<uint32_t>(file.getLastWrite());
+    file.close();
+    return true;
+}
+
+/**
+ * @brief Read the snapshot; false if missing, of another version or corrupt
+ */
+bool read_palette_cache(PaletteCache& cache) {
+    if (!pxlcam::nvs::isInitialized()) {
+        pxlcam::nvs::nvsStoreInit();
+    }
+    
+    return pxlcam::nvs::readBytes(kNvsKeyPaletteCache, &cache, sizeof(cache)) &&
+           cache.version == kPaletteCacheVersion &&
+           cache.checksum == cache_checksum(cache);
+}
+
+/**
+ * @brief Snapshot the custom slots, stamped with the file they came from
+ */
+void write_palette_cache(uint32_t fileSize, uint32_t fileMtime) {
+    PaletteCache cache;
+    memset(&cache, 0, sizeof(cache));
+    cache.version = kPaletteCacheVersion;
+    cache.fileSize = fileSize;
+    cache.fileMtime = fileMtime;
+    
+    for (uint8_t i = 0; i < CUSTOM_PALETTE_COUNT; ++i) {
+        if (!s_custom_slots[i].loaded) continue;
+        
+        const Palette& pal = s_palettes[BUILTIN_PALETTE_COUNT + i];
+        cache.loadedMask |= static_cast<uint8_t>(1u << i);
+        memcpy(cache.tones[i], pal.tones, PALETTE_TONE_COUNT);
+        strncpy(cache.names[i], pal.name, PALETTE_NAME_MAX_LEN - 1);
+    }
+    cache.checksum = cache_checksum(cache);
+    
+    if (!pxlcam::nvs::writeBytes(kNvsKeyPaletteCache, &cache, sizeof(cache))) {
+        PXLCAM_LOGW_TAG(kLogTag, "Palette cache write to NVS failed");
+    }
+}
+
+/**
+ * @brief Put the snapshot's slots into the registry
+ */
+void restore_palette_cache(const PaletteCache& cache) {
+    for (uint8_t i = 0; i < CUSTOM_PALETTE_COUNT; ++i) {
+        if (!(cache.loadedMask & (1u << i))) continue;
+        
+        const uint8_t arrayIndex = BUILTIN_PALETTE_COUNT + i;
+        memcpy(s_palettes[arrayIndex].tones, cache.tones[i], PALETTE_TONE_COUNT);
+        refresh_lut(arrayIndex);
+        memcpy(s_custom_names[i], cache.names[i], PALETTE_NAME_MAX_LEN);
+        s_custom_names[i][PALETTE_NAME_MAX_LEN - 1] = '\0';
+        s_palettes[arrayIndex].name = s_custom_names[i];
+        
+        s_custom_slots[i].loaded = true;
+        s_custom_slots[i].data = s_palettes[arrayIndex];
+    }
+}
+
+} // anonymous namespace
+
+bool palette_load_cached() {
+    PaletteCache cache;
+    const bool cached = read_palette_cache(cache);
+    
+    // No card: the last snapshot is the best there is
+    if (SD_MMC.cardType() == CARD_NONE) {
+        if (!cached) {
+            PXLCAM_LOGW_TAG(kLogTag, "SD not mounted and no palette cache");
+            return false;
+        }
+        restore_palette_cache(cache);
+        PXLCAM_LOGI_TAG(kLogTag, "Custom palettes from NVS cache (SD not mounted)");
+        return true;
+    }
+    
+    uint32_t fileSize = 0;
+    uint32_t fileMtime = 0;
+    if (cached && stat_palette_file(fileSize, fileMtime) &&
+        fileSize == cache.fileSize && fileMtime == cache.fileMtime) {
+        restore_palette_cache(cache);
+        PXLCAM_LOGI_TAG(kLogTag, "Custom palettes from NVS cache (%u bytes, mtime %u)",
+                        static_cast<unsigned>(fileSize), static_cast<unsigned>(fileMtime));
+        return true;
+    }
+    
+    // Changed, new or never cached: parse it (this refreshes the cache)
+    return palette_load_from_sd();
+}
+
 // =============================================================================
 // SD Card Load/Save Implementation
 // =============================================================================
@@ -680,6 +886,7 @@ bool palette_load_from_sd() {
     // Check if file exists
     if (!SD_MMC.exists(PALETTE_SD_PATH)) {
         PXLCAM_LOGI_TAG(kLogTag, "No palettes.json found at %s (using defaults)", PALETTE_SD_PATH);
+        write_palette_cache(0, 0);
         return true;  // Not an error - custom palettes are optional
     }
     
@@ -701,6 +908,8 @@ bool palette_load_from_sd() {
     
     size_t bytesRead = file.readBytes(jsonBuffer, kMaxJsonSize - 1);
     jsonBuffer[bytesRead] = '\0';
+    const uint32_t fileSize = static_cast<uint32_t>(file.size());
+    const uint32_t fileMtime = static_cast<uint32_t>(file.getLastWrite());
     file.close();
     
     PXLCAM_LOGI_TAG(kLogTag, "Read %u bytes from %s", bytesRead, PALETTE_SD_PATH);
@@ -710,6 +919,7 @@ bool palette_load_from_sd() {
     if (!arrayStart || *arrayStart != '[') {
         PXLCAM_LOGW_TAG(kLogTag, "No 'custom_palettes' array found in JSON");
         free(jsonBuffer);
+        write_palette_cache(fileSize, fileMtime);
         return true;  // Empty/invalid JSON is not fatal
     }
     
@@ -742,6 +952,7 @@ bool palette_load_from_sd() {
             // Copy to appropriate slot
             const uint8_t arrayIndex = BUILTIN_PALETTE_COUNT + slotIndex;
             memcpy(s_palettes[arrayIndex].tones, tempPalette.tones, PALETTE_TONE_COUNT);
+            refresh_lut(arrayIndex);
             s_palettes[arrayIndex].name = s_custom_names[slotIndex];
             
             // Mark as loaded
@@ -765,6 +976,7 @@ bool palette_load_from_sd() {
     
     free(jsonBuffer);
     PXLCAM_LOGI_TAG(kLogTag, "Loaded %d custom palettes from SD", slotIndex);
+    write_palette_cache(fileSize, fileMtime);
     return true;
 }
 
@@ -844,6 +1056,13 @@ bool palette_save_to_sd() {
     }
     
     PXLCAM_LOGI_TAG(kLogTag, "Saved custom palettes to %s", PALETTE_SD_PATH);
+    
+    // The file just written is what the slots hold
+    uint32_t fileSize = 0;
+    uint32_t fileMtime = 0;
+    if (stat_palette_file(fileSize, fileMtime)) {
+        write_palette_cache(fileSize, fileMtime);
+    }
     return true;
 }
 
@@ -7,7 +7,9 @@
  */
 
 #include "filters/postprocess.h"
+#include "mem_placement.h"
 #include <cmath>
+#include <cstring>
 
 namespace pxlcam {
 namespace filters {
@@ -29,13 +31,44 @@ static const char* s_filterNames[] = {
     "Histogram EQ",
     "Vignette",
     "Grain",
-    "Dither"
+    "Dither",
+    "Night"
 };
 
 // Gamma lookup table (256 entries)
 static uint8_t s_gammaLUT[256];
 static float s_currentGamma = 0.0f;
 
+// Night enhance: gamma boost, then contrast (the capture pipeline's Night LUT)
+static constexpr float kNightGamma = 0.6f;
+static constexpr float kNightContrast = 1.4f;
+
+// Compiled chain (cached by configuration hash) and per-frame scratch
+static ChainProgram s_program;
+static bool s_programValid = false;
+static uint8_t s_frameLUT[256];
+static uint32_t s_histogram[256];
+
+// Vignette: gain over squared distance (1024 steps up to the corner) and
+// the column terms of the left half, for the last size and parameters.
+// Terms are d^2 scaled so the corner is 2^16.
+static constexpr int kVignetteIndexShift = 6;
+static constexpr int kVignetteColsStatic = 800;     // Half of a UXGA row
+static uint16_t s_vignetteGain[1025];
+static uint16_t s_vignetteColsStatic[kVignetteColsStatic];
+static uint16_t* s_vignetteCols = s_vignetteColsStatic;
+static float s_vignetteScale = 0.0f;
+static int s_vignetteW = 0;
+static int s_vignetteH = 0;
+static float s_vignetteStrength = -1.0f;
+static float s_vignetteRadius = -1.0f;
+
+// Grain generator state (xorshift32, never zero)
+static uint32_t s_grainState = 0x9E3779B9u;
+
+// Row window for frames up to capture width (wider ones allocate)
+alignas(4) static uint8_t s_windowStorage[row_window_bytes(320)];
+
 // =============================================================================
 // Helper Functions
 // =============================================================================
@@ -51,6 +84,179 @@ static void buildGammaLUT(float gamma) {
     s_currentGamma = gamma;
 }
 
+static inline uint8_t clampByte(int val) {
+    return (uint8_t)(val < 0 ? 0 : (val > 255 ? 255 : val));
+}
+
+static void gammaMap(float gamma, uint8_t* lut) {
+    buildGammaLUT(gamma);
+    memcpy(lut, s_gammaLUT, 256);
+}
+
+static void contrastMap(float contrast, uint8_t* lut) {
+    for (int i = 0; i < 256; i++) {
+        lut[i] = clampByte((int)((i - 128) * contrast + 128));
+    }
+}
+
+static void brightnessMap(int brightness, uint8_t* lut) {
+    for (int i = 0; i < 256; i++) {
+        lut[i] = clampByte(i + brightness);
+    }
+}
+
+static void nightMap(uint8_t* lut) {
+    buildGammaLUT(kNightGamma);
+    for (int i = 0; i < 256; i++) {
+        lut[i] = clampByte((int)((s_gammaLUT[i] - 128) * kNightContrast + 128));
+    }
+}
+
+/// Equalization map of a histogram; identity for a flat image
+static void equalizeMap(const uint32_t* histogram, uint32_t pixels, uint8_t* lut) {
+    uint32_t cdf = 0;
+    uint32_t cdfMin = 0;
+    for (int i = 0; i < 256; i++) {
+        if (histogram[i] > 0) {
+            cdfMin = histogram[i];
+            break;
+        }
+    }
+    if (pixels <= cdfMin) {
+        for (int i = 0; i < 256; i++) {
+            lut[i] = (uint8_t)i;
+        }
+        return;
+    }
+    
+    const uint32_t range = pixels - cdfMin;
+    for (int i = 0; i < 256; i++) {
+        cdf += histogram[i];
+        lut[i] = cdf > 0 ? (uint8_t)(((cdf - cdfMin) * 255ull) / range) : 0;
+    }
+}
+
+/// Value map of a position-independent filter other than histogram EQ
+static void filterMap(const FilterParams& params, uint8_t* lut) {
+    switch (params.type) {
+        case FilterType::GAMMA_CORRECTION:
+            gammaMap(params.param1 > 0 ? params.param1 : 2.2f, lut);
+            break;
+        case FilterType::CONTRAST:
+            contrastMap(params.strength, lut);
+            break;
+        case FilterType::BRIGHTNESS:
+            brightnessMap((int)(params.param1 * 255) - 128, lut);
+            break;
+        case FilterType::NIGHT_ENHANCE:
+            nightMap(lut);
+            break;
+        default:
+            for (int i = 0; i < 256; i++) {
+                lut[i] = (uint8_t)i;
+            }
+            break;
+    }
+}
+
+static inline uint8_t max3(uint8_t a, uint8_t b, uint8_t c) {
+    const uint8_t m = a > b ? a : b;
+    return m > c ? m : c;
+}
+
+static inline uint8_t min3(uint8_t a, uint8_t b, uint8_t c) {
+    const uint8_t m = a < b ? a : b;
+    return m < c ? m : c;
+}
+
+static inline uint8_t med3(uint8_t a, uint8_t b, uint8_t c) {
+    return a > b ? (b > c ? b : (a > c ? c : a))
+                 : (a > c ? a : (b > c ? c : b));
+}
+
+static void applyLUT(uint8_t* buffer, size_t size, const uint8_t* lut) {
+    for (size_t i = 0; i < size; i++) {
+        buffer[i] = lut[buffer[i]];
+    }
+}
+
+static void histogramOf(const uint8_t* buffer, size_t size, uint32_t* histogram) {
+    memset(histogram, 0, 256 * sizeof(uint32_t));
+    for (size_t i = 0; i < size; i++) {
+        histogram[buffer[i]]++;
+    }
+}
+
+/// Vignette tables for a size and parameters (kept until they change)
+static bool buildVignette(int w, int h, float strength, float radius) {
+    if (w == s_vignetteW && h == s_vignetteH &&
+        strength == s_vignetteStrength && radius == s_vignetteRadius) {
+        return true;
+    }
+    
+    const int halfW = (w + 1) / 2;
+    if (s_vignetteCols != s_vignetteColsStatic) {
+        free(s_vignetteCols);
+        s_vignetteCols = s_vignetteColsStatic;
+    }
+    if (halfW > kVignetteColsStatic) {
+        s_vignetteCols = static_cast<uint16_t*>(malloc((size_t)halfW * sizeof(uint16_t)));
+        if (!s_vignetteCols) {
+            s_vignetteCols = s_vignetteColsStatic;
+            s_vignetteW = 0;
+            return false;
+        }
+    }
+    
+    // Pixel centres, so that x and w-1-x are the same distance out
+    const float maxD2 = (w * 0.5f) * (w * 0.5f) + (h * 0.5f) * (h * 0.5f);
+    s_vignetteScale = 65536.0f / maxD2;
+    for (int x = 0; x < halfW; x++) {
+        const float dx = x + 0.5f - w * 0.5f;
+        s_vignetteCols[x] = (uint16_t)(dx * dx * s_vignetteScale);
+    }
+    for (int i = 0; i <= 1024; i++) {
+        const float dist = sqrtf(i / 1024.0f);
+        float factor = 1.0f - (dist - radius) * strength;
+        factor = factor < 0.0f ? 0.0f : (factor > 1.0f ? 1.0f : factor);
+        s_vignetteGain[i] = (uint16_t)(factor * 256.0f + 0.5f);
+    }
+    
+    s_vignetteW = w;
+    s_vignetteH = h;
+    s_vignetteStrength = strength;
+    s_vignetteRadius = radius;
+    return true;
+}
+
+/// Filter takes part in the chain (DITHER runs in dither_pipeline)
+static inline bool isActive(const FilterParams& params) {
+    return params.enabled && params.type != FilterType::DITHER;
+}
+
+/// FNV-1a over what the compiled program depends on
+static uint32_t configHash(const PostProcessConfig& config) {
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const void* data, size_t len) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < len; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    };
+    mix(&config.filterCount, sizeof(config.filterCount));
+    for (uint8_t i = 0; i < config.filterCount && i < MAX_FILTER_CHAIN; i++) {
+        const FilterParams& f = config.filters[i];
+        const uint8_t head[2] = {static_cast<uint8_t>(f.type), static_cast<uint8_t>(isActive(f))};
+        mix(head, sizeof(head));
+        if (isActive(f)) {
+            mix(&f.strength, sizeof(f.strength));
+            mix(&f.param1, sizeof(f.param1));
+            mix(&f.param2, sizeof(f.param2));
+        }
+    }
+    return hash;
+}
+
 // =============================================================================
 // Implementation
 // =============================================================================
@@ -63,6 +269,14 @@ bool postprocess_init() {
     // Build default gamma LUT
     buildGammaLUT(2.2f);
     
+    // Per-pixel tables are static (DRAM); listed by placement::logReport()
+    placement::note("PostGammaLut", s_gammaLUT, sizeof(s_gammaLUT));
+    placement::note("PostFrameLut", s_frameLUT, sizeof(s_frameLUT));
+    placement::note("PostProgram", &s_program, sizeof(s_program));
+    placement::note("VignetteGain", s_vignetteGain, sizeof(s_vignetteGain));
+    placement::note("VignetteCols", s_vignetteColsStatic, sizeof(s_vignetteColsStatic));
+    placement::note("PostWindow", s_windowStorage, sizeof(s_windowStorage));
+    
     s_initialized = true;
     return true;
 }
@@ -75,13 +289,24 @@ bool apply_postprocess_chain(uint8_t* buffer, int w, int h) {
     if (!buffer || w <= 0 || h <= 0) return false;
     if (!s_config.enabled) return true;
     
-    // Apply each enabled filter in order
-    for (uint8_t i = 0; i < s_config.filterCount; i++) {
-        if (s_config.filters[i].enabled) {
-            if (!apply_filter(buffer, w, h, s_config.filters[i])) {
+    // Each run of pointwise filters is one lookup pass
+    const ChainProgram& program = postprocess_compile(s_config);
+    const size_t size = (size_t)w * h;
+    for (uint8_t i = 0; i < program.stepCount; i++) {
+        const ChainStep& step = program.steps[i];
+        if (!step.lut) {
+            if (!apply_filter(buffer, w, h, s_config.filters[step.first])) {
                 return false;
             }
+            continue;
+        }
+        const uint8_t* lut = program.luts[step.lutIndex];
+        if (step.needsHistogram) {
+            histogramOf(buffer, size, s_histogram);
+            postprocess_build_lut(s_config, step, s_histogram, (uint32_t)size, s_frameLUT);
+            lut = s_frameLUT;
         }
+        applyLUT(buffer, size, lut);
     }
     
     return true;
@@ -127,13 +352,368 @@ bool apply_filter(uint8_t* buffer, int w, int h, const FilterParams& params) {
             // Dithering handled by dither_pipeline
             break;
             
+        case FilterType::NIGHT_ENHANCE:
+            filter_night_enhance(buffer, w, h);
+            break;
+            
+        default:
+            return false;
+    }
+    
+    return true;
+}
+
+// =============================================================================
+// Chain Compiler
+// =============================================================================
+
+bool filter_is_pointwise(FilterType type) {
+    switch (type) {
+        case FilterType::GAMMA_CORRECTION:
+        case FilterType::CONTRAST:
+        case FilterType::BRIGHTNESS:
+        case FilterType::HISTOGRAM_EQ:
+        case FilterType::NIGHT_ENHANCE:
+            return true;
         default:
             return false;
     }
+}
+
+const ChainProgram& postprocess_compile(const PostProcessConfig& config) {
+    const uint32_t hash = configHash(config);
+    if (s_programValid && s_program.hash == hash) {
+        return s_program;
+    }
+    
+    s_program.stepCount = 0;
+    s_program.hash = hash;
+    uint8_t lutCount = 0;
+    ChainStep* run = nullptr;   // Open pointwise run
+    for (uint8_t i = 0; i < config.filterCount && i < MAX_FILTER_CHAIN; i++) {
+        const FilterParams& f = config.filters[i];
+        if (!isActive(f)) {
+            if (run) run->count = i + 1 - run->first;   // Skipped inside the run
+            continue;
+        }
+        if (filter_is_pointwise(f.type)) {
+            if (!run) {
+                run = &s_program.steps[s_program.stepCount++];
+                *run = ChainStep{i, 0, true, false, lutCount++};
+            }
+            run->count = i + 1 - run->first;
+            run->needsHistogram |= f.type == FilterType::HISTOGRAM_EQ;
+        } else {
+            run = nullptr;
+            s_program.steps[s_program.stepCount++] = ChainStep{i, 1, false, false, 0};
+        }
+    }
     
+    // Tables that do not depend on the frame are built once here
+    for (uint8_t i = 0; i < s_program.stepCount; i++) {
+        const ChainStep& step = s_program.steps[i];
+        if (step.lut && !step.needsHistogram) {
+            postprocess_build_lut(config, step, nullptr, 0, s_program.luts[step.lutIndex]);
+        }
+    }
+    s_programValid = true;
+    return s_program;
+}
+
+void postprocess_build_lut(const PostProcessConfig& config, const ChainStep& step,
+                           const uint32_t* histogram, uint32_t pixels, uint8_t lut[256]) {
+    uint8_t map[256];
+    uint32_t mapped[256];
+    for (int v = 0; v < 256; v++) {
+        lut[v] = (uint8_t)v;
+    }
+    
+    for (uint8_t i = step.first; i < step.first + step.count && i < config.filterCount; i++) {
+        const FilterParams& f = config.filters[i];
+        if (!isActive(f)) continue;
+        
+        if (f.type == FilterType::HISTOGRAM_EQ) {
+            if (!histogram) continue;
+            // Histogram of this filter's input: the run's input through the table so far
+            memset(mapped, 0, sizeof(mapped));
+            for (int v = 0; v < 256; v++) {
+                mapped[lut[v]] += histogram[v];
+            }
+            equalizeMap(mapped, pixels, map);
+        } else {
+            filterMap(f, map);
+        }
+        for (int v = 0; v < 256; v++) {
+            lut[v] = map[lut[v]];
+        }
+    }
+}
+
+// =============================================================================
+// Row Window (3x3 neighborhood filters)
+// =============================================================================
+
+bool RowWindow3::begin(const FilterParams& params, int w, uint8_t* storage) {
+    pushed_ = 0;
+    if (!storage || w <= 0 ||
+        (params.type != FilterType::SHARPEN && params.type != FilterType::DENOISE)) {
+        w_ = 0;
+        return false;
+    }
+    
+    type_ = params.type;
+    const float limit = type_ == FilterType::DENOISE ? 1.0f : 4.0f;
+    const float strength = params.strength < 0 ? 0 : (params.strength > limit ? limit : params.strength);
+    strength_ = (int16_t)(strength * 256.0f + 0.5f);
+    w_ = w;
+    // Column scratch (w + 2 entries, 3 bytes each at most) first, then the ring
+    sums_ = reinterpret_cast<uint16_t*>(storage);
+    uint8_t* ring = storage + (size_t)(w + 2) * 3;
+    for (int i = 0; i < 3; i++) {
+        rows_[i] = ring + (size_t)i * w;
+    }
     return true;
 }
 
+bool RowWindow3::push(const uint8_t* row, uint8_t* out) {
+    if (w_ == 0) return false;
+    
+    const uint32_t n = pushed_++;
+    memcpy(rows_[n % 3], row, w_);
+    if (n == 0) {
+        return false;   // Needs the row below
+    }
+    const uint8_t* top = rows_[(n >= 2 ? n - 2 : n - 1) % 3];
+    filterRow(top, rows_[(n - 1) % 3], rows_[n % 3], out);
+    return true;
+}
+
+bool RowWindow3::finish(uint8_t* out) {
+    if (w_ == 0 || pushed_ == 0) return false;
+    
+    const uint32_t n = pushed_ - 1;     // Last row, repeated below
+    const uint8_t* top = rows_[(n >= 1 ? n - 1 : n) % 3];
+    filterRow(top, rows_[n % 3], rows_[n % 3], out);
+    return true;
+}
+
+void RowWindow3::filterRow(const uint8_t* top, const uint8_t* mid, const uint8_t* bot,
+                           uint8_t* out) {
+    const int w = w_;
+    
+    if (type_ == FilterType::SHARPEN) {
+        // Unsharp mask: p + strength * (9p - box) / 2, box from column sums
+        uint16_t* sums = sums_;     // sums[x + 1] is column x, ends repeated
+        for (int x = 0; x < w; x++) {
+            sums[x + 1] = (uint16_t)(top[x] + mid[x] + bot[x]);
+        }
+        sums[0] = sums[1];
+        sums[w + 1] = sums[w];
+        
+        int box = sums[0] + sums[1] + sums[2];
+        for (int x = 0; x < w; x++) {
+            const int p = mid[x];
+            out[x] = clampByte(p + (((9 * p - box) * strength_) >> 9));
+            if (x + 1 < w) {
+                box += sums[x + 3] - sums[x];
+            }
+        }
+        return;
+    }
+    
+    // Denoise: exact 3x3 median, blended by strength. Each column triple is
+    // sorted once (lo <= md <= hi); the median of the window is the median of
+    // max(lo), median(md) and min(hi) over its three columns.
+    uint8_t* lo = reinterpret_cast<uint8_t*>(sums_);
+    uint8_t* md = lo + (w + 2);
+    uint8_t* hi = md + (w + 2);
+    for (int x = 0; x < w; x++) {
+        uint8_t a = top[x];
+        uint8_t b = mid[x];
+        uint8_t c = bot[x];
+        if (a > b) { const uint8_t t = a; a = b; b = t; }
+        if (b > c) { const uint8_t t = b; b = c; c = t; }
+        if (a > b) { const uint8_t t = a; a = b; b = t; }
+        lo[x + 1] = a;
+        md[x + 1] = b;
+        hi[x + 1] = c;
+    }
+    lo[0] = lo[1];  md[0] = md[1];  hi[0] = hi[1];
+    lo[w + 1] = lo[w];  md[w + 1] = md[w];  hi[w + 1] = hi[w];
+    
+    for (int x = 0; x < w; x++) {
+        const uint8_t maxLo = max3(lo[x], lo[x + 1], lo[x + 2]);
+        const uint8_t medMd = med3(md[x], md[x + 1], md[x + 2]);
+        const uint8_t minHi = min3(hi[x], hi[x + 1], hi[x + 2]);
+        const int m = med3(maxLo, medMd, minHi);
+        const int p = mid[x];
+        out[x] = (uint8_t)(p + (((m - p) * strength_) >> 8));
+    }
+}
+
+// =============================================================================
+// Row-Streamed Chain
+// =============================================================================
+
+/// Row buffers stay 2-byte aligned for the windows' column sums
+static inline size_t evenBytes(int w) {
+    return ((size_t)w + 1) & ~(size_t)1;
+}
+
+/// 3x3 filters of a program that fit in maxWindows
+static uint8_t windowSteps(const PostProcessConfig& config, const ChainProgram& program,
+                           uint8_t maxWindows) {
+    uint8_t windows = 0;
+    for (uint8_t i = 0; i < program.stepCount; i++) {
+        const FilterType type = config.filters[program.steps[i].first].type;
+        if (!program.steps[i].lut && (type == FilterType::SHARPEN || type == FilterType::DENOISE) &&
+            windows < maxWindows) {
+            windows++;
+        }
+    }
+    return windows;
+}
+
+size_t RowChain::storage_bytes(const PostProcessConfig& config, int w, uint8_t maxWindows) {
+    if (!config.enabled || w <= 0) return 0;
+    
+    // Input row, then per window its storage and its output row
+    const uint8_t windows = windowSteps(config, postprocess_compile(config), maxWindows);
+    return evenBytes(w) + windows * (row_window_bytes(w) + evenBytes(w));
+}
+
+bool RowChain::begin(const PostProcessConfig& config, int w, int h, uint8_t* storage, size_t bytes,
+                     const uint32_t* histogram, uint32_t pixels, RowSink sink, void* user,
+                     uint8_t maxWindows) {
+    stepCount_ = 0;
+    windowCount_ = 0;
+    skipped_ = 0;
+    countHistogram_ = false;
+    pushed_ = 0;
+    w_ = w;
+    h_ = h;
+    sink_ = sink;
+    user_ = user;
+    if (w <= 0 || h <= 0 || !sink) return false;
+    if (!config.enabled) return true;
+    
+    const ChainProgram& program = postprocess_compile(config);
+    if (program.stepCount == 0) return true;
+    if (!storage || bytes < storage_bytes(config, w, maxWindows)) return false;
+    
+    row_ = storage;
+    uint8_t* next = storage + evenBytes(w);
+    uint8_t lutCount = 0;
+    for (uint8_t i = 0; i < program.stepCount; i++) {
+        const ChainStep& step = program.steps[i];
+        const FilterParams& f = config.filters[step.first];
+        Step& s = steps_[stepCount_];
+        s.strength = f.strength;
+        s.param1 = f.param1;
+        
+        if (step.lut) {
+            s.kind = Kind::Lut;
+            s.index = lutCount++;
+            if (step.needsHistogram) {
+                postprocess_build_lut(config, step, histogram, pixels, luts_[s.index]);
+                countHistogram_ = true;
+            } else {
+                memcpy(luts_[s.index], program.luts[step.lutIndex], 256);
+            }
+        } else if (f.type == FilterType::SHARPEN || f.type == FilterType::DENOISE) {
+            if (windowCount_ >= maxWindows) {
+                skipped_++;
+                continue;
+            }
+            s.kind = Kind::Window;
+            s.index = windowCount_++;
+            windows_[s.index].begin(f, w, next);
+            windowOut_[s.index] = next + row_window_bytes(w);
+            next = windowOut_[s.index] + evenBytes(w);
+        } else if (f.type == FilterType::VIGNETTE) {
+            s.kind = Kind::Vignette;
+        } else if (f.type == FilterType::GRAIN) {
+            s.kind = Kind::Grain;
+        } else {
+            continue;
+        }
+        stepCount_++;
+    }
+    
+    if (countHistogram_) {
+        memset(histogram_, 0, sizeof(histogram_));
+    }
+    return true;
+}
+
+bool RowChain::push(const uint8_t* row) {
+    if (stepCount_ == 0) {
+        return sink_(user_, row, pushed_++);
+    }
+    
+    const int w = w_;
+    if (countHistogram_) {
+        for (int x = 0; x < w; x++) {
+            histogram_[row[x]]++;
+        }
+    }
+    
+    // The input is read-only: the first table is applied while copying it
+    uint8_t from = 0;
+    if (steps_[0].kind == Kind::Lut) {
+        const uint8_t* lut = luts_[steps_[0].index];
+        for (int x = 0; x < w; x++) {
+            row_[x] = lut[row[x]];
+        }
+        from = 1;
+    } else {
+        memcpy(row_, row, w);
+    }
+    return run(from, row_, pushed_++);
+}
+
+bool RowChain::finish() {
+    // Each window's last row still goes through the steps after it,
+    // including the later windows, before those give up their own
+    for (uint8_t i = 0; i < stepCount_; i++) {
+        const Step& s = steps_[i];
+        if (s.kind != Kind::Window) continue;
+        
+        uint8_t* out = windowOut_[s.index];
+        if (windows_[s.index].finish(out) && !run(i + 1, out, pushed_ - 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RowChain::run(uint8_t from, uint8_t* row, int y) {
+    for (uint8_t i = from; i < stepCount_; i++) {
+        const Step& s = steps_[i];
+        switch (s.kind) {
+            case Kind::Lut:
+                applyLUT(row, w_, luts_[s.index]);
+                break;
+            case Kind::Window: {
+                uint8_t* out = windowOut_[s.index];
+                if (!windows_[s.index].push(row, out)) {
+                    return true;    // First row: held until the one below
+                }
+                row = out;
+                y--;
+                break;
+            }
+            case Kind::Vignette:
+                filter_vignette_rows(row, y, 1, w_, h_, s.strength, s.param1);
+                break;
+            case Kind::Grain:
+                filter_grain_rows(row, 1, w_, s.strength);
+                break;
+        }
+    }
+    return sink_(user_, row, y);
+}
+
 void postprocess_set_config(const PostProcessConfig& config) {
     s_config = config;
 }
@@ -187,144 +767,128 @@ const char* postprocess_get_filter_name(FilterType type) {
 
 void filter_gamma(uint8_t* buffer, int w, int h, float gamma) {
     buildGammaLUT(gamma);
-    
-    int size = w * h;
-    for (int i = 0; i < size; i++) {
-        buffer[i] = s_gammaLUT[buffer[i]];
-    }
+    applyLUT(buffer, (size_t)w * h, s_gammaLUT);
 }
 
 void filter_contrast(uint8_t* buffer, int w, int h, float contrast) {
-    int size = w * h;
-    float factor = (259.0f * (contrast * 255.0f + 255.0f)) / (255.0f * (259.0f - contrast * 255.0f));
-    
-    for (int i = 0; i < size; i++) {
-        int val = (int)(factor * (buffer[i] - 128) + 128);
-        buffer[i] = constrain(val, 0, 255);
-    }
+    uint8_t lut[256];
+    contrastMap(contrast, lut);
+    applyLUT(buffer, (size_t)w * h, lut);
 }
 
 void filter_brightness(uint8_t* buffer, int w, int h, int brightness) {
-    int size = w * h;
-    for (int i = 0; i < size; i++) {
-        int val = buffer[i] + brightness;
-        buffer[i] = constrain(val, 0, 255);
-    }
+    uint8_t lut[256];
+    brightnessMap(brightness, lut);
+    applyLUT(buffer, (size_t)w * h, lut);
 }
 
-void filter_sharpen(uint8_t* buffer, int w, int h, float strength) {
-    // Simple unsharp mask using 3x3 kernel
-    // TODO: Implement proper convolution with temporary buffer
+void filter_night_enhance(uint8_t* buffer, int w, int h) {
+    uint8_t lut[256];
+    nightMap(lut);
+    applyLUT(buffer, (size_t)w * h, lut);
+}
+
+/// Run a 3x3 filter over a frame in place through a row window
+static void applyNeighborhood(uint8_t* buffer, int w, int h, const FilterParams& params) {
+    if (!buffer || w <= 0 || h <= 0) return;
     
-    // Skip edges for now
-    for (int y = 1; y < h - 1; y++) {
-        for (int x = 1; x < w - 1; x++) {
-            int idx = y * w + x;
-            
-            // Calculate Laplacian
-            int center = buffer[idx] * 5;
-            int neighbors = buffer[idx - 1] + buffer[idx + 1] + 
-                           buffer[idx - w] + buffer[idx + w];
-            
-            int sharpened = center - neighbors;
-            int result = buffer[idx] + (int)(sharpened * strength);
-            buffer[idx] = constrain(result, 0, 255);
+    // Capture-size rows fit the static window; wider ones borrow the heap
+    uint8_t* storage = s_windowStorage;
+    if (row_window_bytes(w) > sizeof(s_windowStorage)) {
+        storage = static_cast<uint8_t*>(malloc(row_window_bytes(w)));
+        if (!storage) return;
+    }
+    
+    RowWindow3 window;
+    if (window.begin(params, w, storage)) {
+        for (int y = 0; y < h; y++) {
+            // Output row y-1 is written after row y was copied into the ring
+            window.push(buffer + (size_t)y * w, buffer + (size_t)(y > 0 ? y - 1 : 0) * w);
         }
+        window.finish(buffer + (size_t)(h - 1) * w);
+    }
+    
+    if (storage != s_windowStorage) {
+        free(storage);
     }
 }
 
+void filter_sharpen(uint8_t* buffer, int w, int h, float strength) {
+    applyNeighborhood(buffer, w, h, FilterParams(FilterType::SHARPEN, true, strength));
+}
+
 void filter_denoise(uint8_t* buffer, int w, int h, float strength) {
-    // Simple 3x3 median filter approximation
-    // TODO: Implement proper median filter
-    
-    for (int y = 1; y < h - 1; y++) {
-        for (int x = 1; x < w - 1; x++) {
-            int idx = y * w + x;
-            
-            // Calculate local average
-            int sum = buffer[idx - w - 1] + buffer[idx - w] + buffer[idx - w + 1] +
-                     buffer[idx - 1] + buffer[idx] + buffer[idx + 1] +
-                     buffer[idx + w - 1] + buffer[idx + w] + buffer[idx + w + 1];
-            
-            int avg = sum / 9;
-            int result = buffer[idx] + (int)((avg - buffer[idx]) * strength);
-            buffer[idx] = constrain(result, 0, 255);
-        }
-    }
+    applyNeighborhood(buffer, w, h, FilterParams(FilterType::DENOISE, true, strength));
 }
 
 void filter_histogram_eq(uint8_t* buffer, int w, int h) {
-    int size = w * h;
-    
-    // Calculate histogram
-    int histogram[256] = {0};
-    for (int i = 0; i < size; i++) {
-        histogram[buffer[i]]++;
-    }
-    
-    // Calculate CDF
-    int cdf[256];
-    cdf[0] = histogram[0];
-    for (int i = 1; i < 256; i++) {
-        cdf[i] = cdf[i - 1] + histogram[i];
-    }
-    
-    // Find minimum non-zero CDF
-    int cdfMin = 0;
-    for (int i = 0; i < 256; i++) {
-        if (cdf[i] > 0) {
-            cdfMin = cdf[i];
-            break;
-        }
-    }
-    
-    // Build equalization LUT
+    const size_t size = (size_t)w * h;
     uint8_t lut[256];
-    for (int i = 0; i < 256; i++) {
-        if (cdf[i] > 0) {
-            lut[i] = (uint8_t)(((cdf[i] - cdfMin) * 255) / (size - cdfMin));
-        } else {
-            lut[i] = 0;
-        }
-    }
-    
-    // Apply equalization
-    for (int i = 0; i < size; i++) {
-        buffer[i] = lut[buffer[i]];
-    }
+    histogramOf(buffer, size, s_histogram);
+    equalizeMap(s_histogram, (uint32_t)size, lut);
+    applyLUT(buffer, size, lut);
 }
 
 void filter_vignette(uint8_t* buffer, int w, int h, float strength, float radius) {
-    float cx = w / 2.0f;
-    float cy = h / 2.0f;
-    float maxDist = sqrtf(cx * cx + cy * cy);
+    filter_vignette_rows(buffer, 0, h, w, h, strength, radius);
+}
+
+void filter_vignette_rows(uint8_t* rows, int y0, int count, int w, int h,
+                          float strength, float radius) {
+    if (!rows || w <= 0 || h <= 0 || count <= 0) return;
+    if (!buildVignette(w, h, strength, radius)) return;
     
-    for (int y = 0; y < h; y++) {
-        for (int x = 0; x < w; x++) {
-            int idx = y * w + x;
-            
-            float dx = x - cx;
-            float dy = y - cy;
-            float dist = sqrtf(dx * dx + dy * dy) / maxDist;
-            
-            // Calculate vignette factor
-            float factor = 1.0f - (dist - radius) * strength;
-            factor = fmaxf(0.0f, fminf(1.0f, factor));
-            
-            buffer[idx] = (uint8_t)(buffer[idx] * factor);
+    const int halfW = (w + 1) / 2;
+    for (int r = 0; r < count; r++) {
+        const int y = y0 + r;
+        const int my = y < h / 2 ? y : h - 1 - y;     // Mirrored into the top quadrant
+        const float dyc = my + 0.5f - h * 0.5f;
+        const uint32_t dy = (uint32_t)(dyc * dyc * s_vignetteScale);
+        uint8_t* row = rows + (size_t)r * w;
+        for (int x = 0; x < halfW; x++) {
+            const uint16_t gain = s_vignetteGain[(s_vignetteCols[x] + dy) >> kVignetteIndexShift];
+            row[x] = (uint8_t)((row[x] * gain) >> 8);
+            const int mx = w - 1 - x;
+            if (mx != x) {
+                row[mx] = (uint8_t)((row[mx] * gain) >> 8);
+            }
         }
     }
 }
 
 void filter_grain(uint8_t* buffer, int w, int h, float amount) {
-    int size = w * h;
-    int grainRange = (int)(amount * 50);
+    filter_grain_rows(buffer, h, w, amount);
+}
+
+void filter_grain_rows(uint8_t* rows, int count, int w, float amount) {
+    if (!rows || w <= 0 || count <= 0) return;
+    const int range = (int)(amount * 50);
+    if (range <= 0) return;
     
-    for (int i = 0; i < size; i++) {
-        int grain = (rand() % (grainRange * 2 + 1)) - grainRange;
-        int result = buffer[i] + grain;
-        buffer[i] = constrain(result, 0, 255);
+    // Byte b of a step maps to (b * span) >> 8 - range: uniform over +/- range
+    const int span = range * 2 + 1;
+    const size_t size = (size_t)w * count;
+    uint32_t state = s_grainState;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        for (int k = 0; k < 4; k++) {
+            const int grain = (int)((((state >> (8 * k)) & 0xFFu) * span) >> 8) - range;
+            rows[i + k] = clampByte(rows[i + k] + grain);
+        }
+    }
+    if (i < size) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        for (int k = 0; i < size; i++, k++) {
+            const int grain = (int)((((state >> (8 * k)) & 0xFFu) * span) >> 8) - range;
+            rows[i] = clampByte(rows[i] + grain);
+        }
     }
+    s_grainState = state;
 }
 
 // =============================================================================
@@ -0,0 +1,199 @@
+/**
+ * @file resample.cpp
+ * @brief Fixed-point area (box) downscaler implementation
+ */
+
+#include "filters/resample.h"
+#include "luma_extract.h"
+#include <string.h>
+
+namespace pxlcam {
+namespace filters {
+
+// =============================================================================
+// Luma Fetch
+// =============================================================================
+
+namespace {
+
+template <ResampleFormat Format>
+inline uint32_t fetch_luma(const uint8_t* row, int x) {
+    switch (Format) {
+        case ResampleFormat::YUV422:
+            return row[x * 2];
+        case ResampleFormat::RGB565:
+            return pxlcam::luma::rgb565Luma(row[x * 2], row[x * 2 + 1]);
+        case ResampleFormat::RGB888: {
+            const uint8_t* p = row + x * 3;
+            return (77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8;
+        }
+        default:
+            return row[x];
+    }
+}
+
+/**
+ * Horizontal box filter of one source row into dstW column sums.
+ *
+ * Source pixel x spans [x*dstW, (x+1)*dstW) and destination column dx spans
+ * [dx*srcW, (dx+1)*srcW). Since dstW <= srcW a source pixel overlaps at most
+ * two columns, so the walk only tracks the current column's right edge.
+ */
+template <ResampleFormat Format>
+void filter_row(const uint8_t* row, int srcW, int dstW, uint32_t* colSum) {
+    memset(colSum, 0, dstW * sizeof(uint32_t));
+    
+    const uint32_t unit = dstW;
+    uint32_t pos = 0;
+    uint32_t edge = srcW;
+    uint32_t* col = colSum;
+    
+    for (int x = 0; x < srcW; x++, pos += unit) {
+        const uint32_t v = fetch_luma<Format>(row, x);
+        if (pos + unit < edge) {
+            *col += v * unit;
+            continue;
+        }
+        
+        // Pixel reaches the column edge: split it between this column and the next
+        const uint32_t a = edge - pos;
+        *col++ += v * a;
+        edge += srcW;
+        if (a < unit) {
+            *col += v * (unit - a);
+        }
+    }
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// AreaResampler
+// =============================================================================
+
+bool AreaResampler::begin(int srcW, int srcH, ResampleFormat format,
+                          uint8_t* dst, int dstW, int dstH, size_t dstStride) {
+    active_ = false;
+    
+    if (!dst || dstW <= 0 || dstH <= 0 || dstW > RESAMPLE_MAX_DST_WIDTH) return false;
+    if (srcW < dstW || srcH < dstH) return false;
+    if (srcW > RESAMPLE_MAX_SRC_DIM || srcH > RESAMPLE_MAX_SRC_DIM) return false;
+    if (dstStride < static_cast<size_t>(dstW)) return false;
+    if (format >= ResampleFormat::COUNT) return false;
+    
+    srcW_ = srcW;
+    srcH_ = srcH;
+    dstW_ = dstW;
+    dstH_ = dstH;
+    dst_ = dst;
+    dstStride_ = dstStride;
+    format_ = format;
+    
+    area_ = static_cast<uint32_t>(srcW) * srcH;
+    recip_ = ((1ULL << 32) + area_ - 1) / area_;
+    
+    srcY_ = 0;
+    dstY_ = 0;
+    memset(acc_, 0, sizeof(acc_));
+    if (hist_) {
+        memset(hist_, 0, 256 * sizeof(uint32_t));
+    }
+    active_ = true;
+    return true;
+}
+
+bool AreaResampler::push_row(const uint8_t* row) {
+    if (!active_ || srcY_ >= srcH_ || !row) return false;
+    
+    switch (format_) {
+        case ResampleFormat::YUV422:
+            filter_row<ResampleFormat::YUV422>(row, srcW_, dstW_, colSum_);
+            break;
+        case ResampleFormat::RGB565:
+            filter_row<ResampleFormat::RGB565>(row, srcW_, dstW_, colSum_);
+            break;
+        case ResampleFormat::RGB888:
+            filter_row<ResampleFormat::RGB888>(row, srcW_, dstW_, colSum_);
+            break;
+        default:
+            filter_row<ResampleFormat::GRAY>(row, srcW_, dstW_, colSum_);
+            break;
+    }
+    
+    accumulate_row();
+    return true;
+}
+
+bool AreaResampler::push_luma_row(const uint8_t* luma) {
+    if (!active_ || srcY_ >= srcH_ || !luma) return false;
+    
+    filter_row<ResampleFormat::GRAY>(luma, srcW_, dstW_, colSum_);
+    accumulate_row();
+    return true;
+}
+
+void AreaResampler::accumulate_row() {
+    // Same walk as filter_row(), vertically: row srcY_ spans
+    // [srcY_*dstH, (srcY_+1)*dstH), destination row dstY_ ends at (dstY_+1)*srcH
+    const uint32_t unit = dstH_;
+    const uint32_t pos = static_cast<uint32_t>(srcY_) * unit;
+    const uint32_t edge = static_cast<uint32_t>(dstY_ + 1) * srcH_;
+    srcY_++;
+    
+    if (pos + unit < edge) {
+        for (int i = 0; i < dstW_; i++) {
+            acc_[i] += colSum_[i] * unit;
+        }
+        return;
+    }
+    
+    const uint32_t a = edge - pos;
+    for (int i = 0; i < dstW_; i++) {
+        acc_[i] += colSum_[i] * a;
+    }
+    emit_row();
+    
+    // The rest of this source row starts the next destination row
+    const uint32_t b = unit - a;
+    for (int i = 0; i < dstW_; i++) {
+        acc_[i] = colSum_[i] * b;
+    }
+}
+
+void AreaResampler::emit_row() {
+    if (dstY_ >= dstH_) return;
+    
+    uint8_t* out = dst_ + static_cast<size_t>(dstY_) * dstStride_;
+    const uint32_t half = area_ / 2;
+    for (int i = 0; i < dstW_; i++) {
+        out[i] = static_cast<uint8_t>(((acc_[i] + half) * recip_) >> 32);
+    }
+    if (hist_) {
+        for (int i = 0; i < dstW_; i++) {
+            hist_[out[i]]++;
+        }
+    }
+    dstY_++;
+}
+
+// =============================================================================
+// One-shot API
+// =============================================================================
+
+bool resample_area(const uint8_t* src, size_t srcStride, ResampleFormat format,
+                   int srcW, int srcH,
+                   uint8_t* dst, int dstW, int dstH, size_t dstStride) {
+    static AreaResampler s_resampler;
+    
+    if (!src) return false;
+    if (srcStride < static_cast<size_t>(srcW) * resample_bytes_per_pixel(format)) return false;
+    if (!s_resampler.begin(srcW, srcH, format, dst, dstW, dstH, dstStride)) return false;
+    
+    for (int y = 0; y < srcH; y++) {
+        s_resampler.push_row(src + static_cast<size_t>(y) * srcStride);
+    }
+    return true;
+}
+
+} // namespace filters
+} // namespace pxlcam
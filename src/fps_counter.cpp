@@ -12,38 +12,220 @@ namespace pxlcam::util {
 
 namespace {
 constexpr const char* kLogTag = "pxlcam-fps";
+
+constexpr const char* kStageNames[] = {
+    "grab", "decode", "downscale", "dither", "blit", "i2c"
+};
+static_assert(sizeof(kStageNames) / sizeof(kStageNames[0]) == static_cast<size_t>(FrameStage::Count),
+              "kStageNames must match FrameStage");
+
+constexpr uint32_t kMinBucketUs = 16;        // Bucket 0: below 16 µs
+constexpr uint32_t kMaxBucketUs = 1u << 22;  // Last bucket: 4.2 s and up
 }
 
-void FPSCounter::tick() {
-    uint32_t now = millis();
-    
-    if (lastTickMs_ != 0) {
-        frameTimeMs_ = now - lastTickMs_;
-        frameTimes_[frameIndex_] = frameTimeMs_;
-        frameIndex_ = (frameIndex_ + 1) % kSampleCount;
-        
-        // Calculate average FPS from rolling window
-        uint32_t totalMs = 0;
-        for (int i = 0; i < kSampleCount; ++i) {
-            totalMs += frameTimes_[i];
+const char* getFrameStageName(FrameStage stage) {
+    const uint8_t i = static_cast<uint8_t>(stage);
+    return i < static_cast<uint8_t>(FrameStage::Count) ? kStageNames[i] : "?";
+}
+
+//==============================================================================
+// LatencyHistogram
+//==============================================================================
+
+int LatencyHistogram::bucketFor(uint32_t us) {
+    if (us < kMinBucketUs) return 0;
+    if (us >= kMaxBucketUs) return kBuckets - 1;
+    
+    // Octave from the leading bit, then the next two bits pick the quarter
+    const int octave = 31 - __builtin_clz(us);
+    const int quarter = (us >> (octave - 2)) & 3;
+    return 1 + (octave - 4) * 4 + quarter;
+}
+
+uint32_t LatencyHistogram::bucketUpperUs(int bucket) {
+    if (bucket <= 0) return kMinBucketUs;
+    if (bucket >= kBuckets - 1) return UINT32_MAX;
+    
+    const int octave = 4 + (bucket - 1) / 4;
+    const uint32_t quarter = (bucket - 1) % 4;
+    return (5 + quarter) << (octave - 2);
+}
+
+void LatencyHistogram::record(uint32_t us) {
+    const int b = bucketFor(us);
+    if (counts_[b] == UINT16_MAX) {
+        for (int i = 0; i < kBuckets; ++i) {
+            counts_[i] >>= 1;
         }
-        
-        if (totalMs > 0) {
-            currentFps_ = (1000 * kSampleCount) / totalMs;
+    }
+    counts_[b]++;
+    
+    samples_++;
+    sumUs_ += us;
+    lastUs_ = us;
+    if (us < minUs_) minUs_ = us;
+    if (us > maxUs_) maxUs_ = us;
+}
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < kBuckets; ++i) {
+        counts_[i] = 0;
+    }
+    samples_ = 0;
+    sumUs_ = 0;
+    lastUs_ = 0;
+    minUs_ = UINT32_MAX;
+    maxUs_ = 0;
+}
+
+uint32_t LatencyHistogram::percentile(uint32_t total, uint32_t pct) const {
+    const uint32_t rank = (total * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            // The bucket edge can overshoot the largest sample seen
+            const uint32_t upper = bucketUpperUs(i);
+            return upper < maxUs_ ? upper : maxUs_;
         }
     }
+    return maxUs_;
+}
+
+void LatencyHistogram::summarize(TimingSummary& out) const {
+    out = TimingSummary{};
+    if (samples_ == 0) return;
+    
+    uint32_t total = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        total += counts_[i];
+    }
     
-    lastTickMs_ = now;
+    out.samples = samples_;
+    out.lastUs = lastUs_;
+    out.minUs = minUs_;
+    out.maxUs = maxUs_;
+    out.avgUs = static_cast<uint32_t>(sumUs_ / samples_);
+    out.p50Us = percentile(total, 50);
+    out.p95Us = percentile(total, 95);
+    out.p99Us = percentile(total, 99);
+}
+
+//==============================================================================
+// FPSCounter
+//==============================================================================
+
+void FPSCounter::tick() {
+    const uint32_t now = micros();
+    
+    if (!haveTick_) {
+        haveTick_ = true;
+        lastTickUs_ = now;
+        return;
+    }
+    
+    const uint32_t interval = now - lastTickUs_;
+    lastTickUs_ = now;
+    
+    // Jitter: J += (|D| - J) / 16 with D the change in interval
+    const int32_t delta = static_cast<int32_t>(interval - frameTimeUs_);
+    const uint32_t absDelta = delta < 0 ? -delta : delta;
+    const uint32_t jitter = frameTimeUs_ == 0 ? 0
+        : static_cast<uint32_t>(static_cast<int32_t>(jitterUs_) +
+                                (static_cast<int32_t>(absDelta) - static_cast<int32_t>(jitterUs_)) / 16);
+    
+    frameTimes_[frameIndex_] = interval;
+    frameIndex_ = (frameIndex_ + 1) % kSampleCount;
+    
+    // Calculate average FPS from rolling window
+    uint64_t totalUs = 0;
+    for (int i = 0; i < kSampleCount; ++i) {
+        totalUs += frameTimes_[i];
+    }
+    
+    portENTER_CRITICAL(&lock_);
+    frameTimeUs_ = interval;
+    jitterUs_ = jitter;
+    if (stallThresholdUs_ != 0 && interval > stallThresholdUs_) {
+        stalls_++;
+    }
+    frameHist_.record(interval);
+    portEXIT_CRITICAL(&lock_);
+    
+    if (totalUs > 0) {
+        currentFps_ = static_cast<int>((1000000ull * kSampleCount) / totalUs);
+    }
+}
+
+void FPSCounter::recordStage(FrameStage stage, uint32_t us) {
+    const int i = static_cast<int>(stage);
+    if (i >= kStageCount) return;
+    
+    portENTER_CRITICAL(&lock_);
+    stageHist_[i].record(us);
+    portEXIT_CRITICAL(&lock_);
+}
+
+void FPSCounter::getFrameSummary(TimingSummary& out) const {
+    portENTER_CRITICAL(&lock_);
+    frameHist_.summarize(out);
+    portEXIT_CRITICAL(&lock_);
+}
+
+void FPSCounter::getStageSummary(FrameStage stage, TimingSummary& out) const {
+    const int i = static_cast<int>(stage);
+    if (i >= kStageCount) {
+        out = TimingSummary{};
+        return;
+    }
+    
+    portENTER_CRITICAL(&lock_);
+    stageHist_[i].summarize(out);
+    portEXIT_CRITICAL(&lock_);
+}
+
+void FPSCounter::logSummary(const char* prefix) const {
+    TimingSummary s;
+    getFrameSummary(s);
+    PXLCAM_LOGI_TAG(kLogTag, "[%s] frame(us): n=%u p50=%u p95=%u p99=%u max=%u jitter=%u stalls=%u",
+                    prefix, s.samples, s.p50Us, s.p95Us, s.p99Us, s.maxUs, jitterUs_, stalls_);
+    
+    for (int i = 0; i < kStageCount; ++i) {
+        getStageSummary(static_cast<FrameStage>(i), s);
+        if (s.samples == 0) continue;
+        PXLCAM_LOGI_TAG(kLogTag, "[%s]   %-9s avg=%u p50=%u p95=%u p99=%u max=%u",
+                        prefix, kStageNames[i], s.avgUs, s.p50Us, s.p95Us, s.p99Us, s.maxUs);
+    }
 }
 
 void FPSCounter::reset() {
+    portENTER_CRITICAL(&lock_);
     for (int i = 0; i < kSampleCount; ++i) {
         frameTimes_[i] = 0;
     }
     frameIndex_ = 0;
-    lastTickMs_ = 0;
+    lastTickUs_ = 0;
+    haveTick_ = false;
     currentFps_ = 0;
-    frameTimeMs_ = 0;
+    frameTimeUs_ = 0;
+    jitterUs_ = 0;
+    stalls_ = 0;
+    frameHist_.reset();
+    for (int i = 0; i < kStageCount; ++i) {
+        stageHist_[i].reset();
+    }
+    portEXIT_CRITICAL(&lock_);
+}
+
+//==============================================================================
+// StageTimer
+//==============================================================================
+
+StageTimer::StageTimer(FPSCounter& counter, FrameStage stage)
+    : counter_(counter), stage_(stage), startUs_(micros()) {}
+
+StageTimer::~StageTimer() {
+    counter_.recordStage(stage_, micros() - startUs_);
 }
 
 }  // namespace pxlcam::util
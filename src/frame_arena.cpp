@@ -0,0 +1,212 @@
+/**
+ * @file frame_arena.cpp
+ * @brief One PSRAM block for the frame buffers, shared between phases
+ */
+
+#include "frame_arena.h"
+
+#include "logging.h"
+
+#include <esp_heap_caps.h>
+#include <esp32-hal-psram.h>
+#include <freertos/FreeRTOS.h>
+
+#include <atomic>
+
+namespace pxlcam::arena {
+
+namespace {
+
+constexpr const char* kLogTag = "arena";
+constexpr size_t kPhaseCount = static_cast<size_t>(Phase::Count);
+
+// Resident blocks grow up from g_base, phase leases down from g_end;
+// [g_bottom, g_top) is free
+uintptr_t g_base = 0;
+uintptr_t g_end = 0;
+uintptr_t g_bottom = 0;
+uintptr_t g_top = 0;
+bool g_begun = false;
+Phase g_phase = Phase::None;
+std::atomic<uint32_t> g_generation{0};
+
+size_t g_highWater = 0;
+size_t g_phasePeak[kPhaseCount] = {};
+uint32_t g_blocks = 0;
+uint32_t g_failures = 0;
+portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+
+bool validAlign(size_t align) {
+    return align != 0 && (align & (align - 1)) == 0;
+}
+
+/// Caller holds g_lock
+void noteUse() {
+    const size_t used = (g_bottom - g_base) + (g_end - g_top);
+    if (used > g_highWater) {
+        g_highWater = used;
+    }
+    const size_t phaseBytes = g_end - g_top;
+    size_t& peak = g_phasePeak[static_cast<size_t>(g_phase)];
+    if (phaseBytes > peak) {
+        peak = phaseBytes;
+    }
+}
+
+}  // namespace
+
+bool begin(size_t bytes) {
+    if (g_begun) {
+        return g_base != 0;
+    }
+    g_begun = true;
+
+    if (bytes == 0 || !psramFound()) {
+        PXLCAM_LOGW_TAG(kLogTag, "No frame arena (PSRAM %s)", psramFound() ? "disabled" : "missing");
+        return false;
+    }
+    void* block = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!block) {
+        PXLCAM_LOGE_TAG(kLogTag, "Failed to reserve %u byte frame arena", static_cast<unsigned>(bytes));
+        return false;
+    }
+
+    portENTER_CRITICAL(&g_lock);
+    g_base = reinterpret_cast<uintptr_t>(block);
+    g_end = g_base + bytes;
+    g_bottom = g_base;
+    g_top = g_end;
+    portEXIT_CRITICAL(&g_lock);
+
+    PXLCAM_LOGI_TAG(kLogTag, "Frame arena: %u bytes in PSRAM", static_cast<unsigned>(bytes));
+    return true;
+}
+
+bool isReady() {
+    return g_base != 0;
+}
+
+void* reserve(size_t bytes, const char* name, size_t align) {
+    if (!isReady() || bytes == 0 || !validAlign(align)) {
+        return nullptr;
+    }
+
+    uintptr_t start = 0;
+    portENTER_CRITICAL(&g_lock);
+    const uintptr_t aligned = (g_bottom + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    if (aligned >= g_bottom && aligned <= g_top && g_top - aligned >= bytes) {
+        start = aligned;
+        g_bottom = aligned + bytes;
+        g_blocks++;
+        noteUse();
+    } else {
+        g_failures++;
+    }
+    portEXIT_CRITICAL(&g_lock);
+
+    if (!start) {
+        PXLCAM_LOGW_TAG(kLogTag, "%s: %u bytes do not fit", name, static_cast<unsigned>(bytes));
+        return nullptr;
+    }
+    PXLCAM_LOGI_TAG(kLogTag, "%s: %u bytes resident", name, static_cast<unsigned>(bytes));
+    return reinterpret_cast<void*>(start);
+}
+
+void enterPhase(Phase phase) {
+    if (phase >= Phase::Count) {
+        return;
+    }
+    portENTER_CRITICAL(&g_lock);
+    g_phase = phase;
+    g_top = g_end;
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+    portEXIT_CRITICAL(&g_lock);
+}
+
+Phase currentPhase() {
+    return g_phase;
+}
+
+void* acquire(Phase phase, size_t bytes, const char* name, size_t align) {
+    if (!isReady() || bytes == 0 || !validAlign(align) || phase == Phase::None) {
+        return nullptr;
+    }
+
+    uintptr_t start = 0;
+    bool inPhase = true;
+    portENTER_CRITICAL(&g_lock);
+    if (phase != g_phase) {
+        inPhase = false;
+    } else if (g_top - g_bottom >= bytes) {
+        const uintptr_t aligned = (g_top - bytes) & ~static_cast<uintptr_t>(align - 1);
+        if (aligned >= g_bottom) {
+            start = aligned;
+            g_top = aligned;
+            g_blocks++;
+            noteUse();
+        }
+    }
+    if (inPhase && !start) {
+        g_failures++;
+    }
+    portEXIT_CRITICAL(&g_lock);
+
+    if (!inPhase) {
+        PXLCAM_LOGW_TAG(kLogTag, "%s: %s lease asked for during %s", name,
+                        phaseName(phase), phaseName(g_phase));
+    } else if (!start) {
+        PXLCAM_LOGW_TAG(kLogTag, "%s: %u bytes do not fit", name, static_cast<unsigned>(bytes));
+    }
+    return reinterpret_cast<void*>(start);
+}
+
+uint32_t generation() {
+    return g_generation.load(std::memory_order_acquire);
+}
+
+bool owns(const void* ptr) {
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+    return isReady() && addr >= g_base && addr < g_end;
+}
+
+Stats getStats() {
+    Stats stats = {};
+    portENTER_CRITICAL(&g_lock);
+    stats.capacity = g_end - g_base;
+    stats.resident = g_bottom - g_base;
+    stats.phaseBytes = g_end - g_top;
+    stats.highWater = g_highWater;
+    for (size_t i = 0; i < kPhaseCount; i++) {
+        stats.phasePeak[i] = g_phasePeak[i];
+    }
+    stats.blocks = g_blocks;
+    stats.failures = g_failures;
+    stats.phase = g_phase;
+    portEXIT_CRITICAL(&g_lock);
+    return stats;
+}
+
+void logStats() {
+    const Stats stats = getStats();
+    PXLCAM_LOGI_TAG(kLogTag, "Arena: %u/%u bytes (resident %u, %s %u), peak %u, "
+                    "preview peak %u, capture peak %u, %u blocks, %u misses",
+                    static_cast<unsigned>(stats.resident + stats.phaseBytes),
+                    static_cast<unsigned>(stats.capacity),
+                    static_cast<unsigned>(stats.resident), phaseName(stats.phase),
+                    static_cast<unsigned>(stats.phaseBytes),
+                    static_cast<unsigned>(stats.highWater),
+                    static_cast<unsigned>(stats.phasePeak[static_cast<size_t>(Phase::Preview)]),
+                    static_cast<unsigned>(stats.phasePeak[static_cast<size_t>(Phase::Capture)]),
+                    static_cast<unsigned>(stats.blocks), static_cast<unsigned>(stats.failures));
+}
+
+const char* phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::None:    return "none";
+        case Phase::Preview: return "preview";
+        case Phase::Capture: return "capture";
+        default:             return "?";
+    }
+}
+
+}  // namespace pxlcam::arena
@@ -0,0 +1,63 @@
+/**
+ * @file frame_pacer.cpp
+ * @brief Deadline-based frame pacing for preview loops
+ */
+
+#include "frame_pacer.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace pxlcam::util {
+
+void FramePacer::begin(uint16_t targetFps) {
+    periodTicks_ = 0;
+    if (targetFps > 0) {
+        periodTicks_ = pdMS_TO_TICKS(1000 / targetFps);
+        if (periodTicks_ == 0) {
+            periodTicks_ = 1;
+        }
+    }
+    lastWake_ = xTaskGetTickCount();
+    frames_ = 0;
+    missed_ = 0;
+    lastSlackMs_ = 0;
+}
+
+bool FramePacer::endFrame() {
+    frames_++;
+    if (periodTicks_ == 0) {
+        lastSlackMs_ = 0;
+        return true;
+    }
+    
+    const TickType_t now = xTaskGetTickCount();
+    const TickType_t elapsed = now - static_cast<TickType_t>(lastWake_);
+    if (elapsed >= periodTicks_) {
+        // Overran: start the next frame now rather than bursting to catch up
+        missed_++;
+        lastSlackMs_ = 0;
+        lastWake_ = now;
+        return false;
+    }
+    
+    lastSlackMs_ = (periodTicks_ - elapsed) * portTICK_PERIOD_MS;
+    TickType_t wake = static_cast<TickType_t>(lastWake_);
+    vTaskDelayUntil(&wake, periodTicks_);
+    lastWake_ = wake;
+    return true;
+}
+
+void FramePacer::resync() {
+    lastWake_ = xTaskGetTickCount();
+}
+
+uint32_t FramePacer::ticksToDeadline() const {
+    if (periodTicks_ == 0) {
+        return 0;
+    }
+    const TickType_t elapsed = xTaskGetTickCount() - static_cast<TickType_t>(lastWake_);
+    return elapsed >= periodTicks_ ? 0 : periodTicks_ - elapsed;
+}
+
+}  // namespace pxlcam::util
@@ -0,0 +1,182 @@
+/**
+ * @file frame_stack.cpp
+ * @brief Multi-frame stacking of luma frames for low-light captures
+ */
+
+#include "frame_stack.h"
+#include "swar.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace pxlcam::stack {
+
+namespace {
+
+/// Fractional bits of the profile means
+constexpr int kProfileShift = 3;
+
+/// acc[0..3] += src[0..3]; acc is 4-byte aligned, src need not be (shifted rows)
+inline void addPixels4(uint16_t* acc, const uint8_t* src) {
+    uint32_t p;
+    memcpy(&p, src, sizeof(p));
+    uint8_t* words = reinterpret_cast<uint8_t*>(acc);
+    // Bytes 0,1 and 2,3 spread into 16-bit lanes: pixels stay in order
+    const uint32_t lo = swar::load4(words) + ((p & 0xFFu) | ((p & 0xFF00u) << 8));
+    const uint32_t hi = swar::load4(words + 4) + (((p >> 16) & 0xFFu) | ((p >> 8) & 0x00FF0000u));
+    swar::store4(words, lo);
+    swar::store4(words + 4, hi);
+}
+
+/// acc[x] += src[clamp(x + dx)] over one row
+void addShiftedRow(uint16_t* acc, const uint8_t* src, int w, int dx, bool words) {
+    const int lo = dx < 0 ? -dx : 0;      // First x whose source is in the row
+    const int hi = dx > 0 ? w - dx : w;   // End of that range
+
+    int x = 0;
+    for (; x < lo; x++) {
+        acc[x] += src[0];
+    }
+    if (words) {
+        for (; x < hi && (x & 3); x++) {
+            acc[x] += src[x + dx];
+        }
+        for (; x + 4 <= hi; x += 4) {
+            addPixels4(acc + x, src + x + dx);
+        }
+    }
+    for (; x < hi; x++) {
+        acc[x] += src[x + dx];
+    }
+    for (; x < w; x++) {
+        acc[x] += src[w - 1];
+    }
+}
+
+/// Offset d (cur[i + d] matches ref[i]) with the least mean absolute difference
+/// Both profiles have their overlap mean removed first. Offsets are tried
+/// from 0 outwards and only a strictly better one wins, so a flat scene
+/// stays at 0.
+int bestShift(const uint16_t* ref, const uint16_t* cur, int n, int radius) {
+    int best = 0;
+    uint32_t bestCost = UINT32_MAX;
+    for (int k = 0; k <= 2 * radius; k++) {
+        const int d = (k & 1) ? (k + 1) / 2 : -(k / 2);   // 0, 1, -1, 2, -2, ...
+        const int lo = d < 0 ? -d : 0;
+        const int hi = d > 0 ? n - d : n;
+        const int count = hi - lo;
+        if (count < n / 2) {
+            continue;
+        }
+
+        int32_t offset = 0;
+        for (int i = lo; i < hi; i++) {
+            offset += static_cast<int32_t>(ref[i]) - cur[i + d];
+        }
+        offset /= count;
+
+        uint32_t cost = 0;
+        for (int i = lo; i < hi; i++) {
+            cost += static_cast<uint32_t>(abs(static_cast<int32_t>(ref[i]) - cur[i + d] - offset));
+        }
+        cost = cost * 256 / static_cast<uint32_t>(count);
+        if (cost < bestCost) {
+            bestCost = cost;
+            best = d;
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+bool FrameStacker::begin(uint16_t* acc, int w, int h, uint8_t alignRadius) {
+    acc_ = nullptr;
+    frames_ = 0;
+    shiftX_ = 0;
+    shiftY_ = 0;
+    maxShift_ = 0;
+    if (!acc || w <= 0 || h <= 0 || w > kMaxWidth || h > kMaxHeight) {
+        return false;
+    }
+
+    acc_ = acc;
+    w_ = w;
+    h_ = h;
+    // A shift needs at least 3/4 of the frame in common
+    const int limit = (w < h ? w : h) / 4;
+    radius_ = alignRadius > kMaxAlignRadius ? kMaxAlignRadius : alignRadius;
+    if (radius_ > limit) {
+        radius_ = static_cast<uint8_t>(limit);
+    }
+    memset(acc_, 0, static_cast<size_t>(w) * h * sizeof(uint16_t));
+    return true;
+}
+
+bool FrameStacker::add(const uint8_t* gray) {
+    if (!acc_ || !gray || frames_ >= kMaxFrames) {
+        return false;
+    }
+
+    int dx = 0;
+    int dy = 0;
+    if (radius_ > 0) {
+        if (frames_ == 0) {
+            project(gray, refRows_, refCols_);
+        } else {
+            project(gray, rows_, cols_);
+            dx = bestShift(refCols_, cols_, w_, radius_);
+            dy = bestShift(refRows_, rows_, h_, radius_);
+        }
+    }
+    shiftX_ = static_cast<int8_t>(dx);
+    shiftY_ = static_cast<int8_t>(dy);
+    const uint8_t shift = static_cast<uint8_t>(abs(dx) > abs(dy) ? abs(dx) : abs(dy));
+    if (shift > maxShift_) {
+        maxShift_ = shift;
+    }
+
+    // Rows stay word aligned when the accumulator and the width are
+    const bool words = swar::aligned4(acc_) && (w_ & 1) == 0;
+    for (int y = 0; y < h_; y++) {
+        int sy = y + dy;
+        sy = sy < 0 ? 0 : (sy >= h_ ? h_ - 1 : sy);
+        addShiftedRow(acc_ + static_cast<size_t>(y) * w_, gray + static_cast<size_t>(sy) * w_,
+                      w_, dx, words);
+    }
+    frames_++;
+    return true;
+}
+
+void FrameStacker::finish(uint8_t* out) const {
+    if (!acc_ || !out || frames_ == 0) {
+        return;
+    }
+
+    // Rounded division by a 20-bit reciprocal: exact for powers of two,
+    // otherwise off by well under one level
+    const uint32_t recip = (1u << 20) / frames_;
+    const size_t pixels = static_cast<size_t>(w_) * h_;
+    for (size_t i = 0; i < pixels; i++) {
+        const uint32_t mean = (acc_[i] * recip + (1u << 19)) >> 20;
+        out[i] = static_cast<uint8_t>(mean > 255 ? 255 : mean);
+    }
+}
+
+void FrameStacker::project(const uint8_t* gray, uint16_t* rows, uint16_t* cols) const {
+    uint32_t colSums[kMaxWidth] = {};
+    for (int y = 0; y < h_; y++) {
+        const uint8_t* row = gray + static_cast<size_t>(y) * w_;
+        uint32_t rowSum = 0;
+        for (int x = 0; x < w_; x++) {
+            rowSum += row[x];
+            colSums[x] += row[x];
+        }
+        rows[y] = static_cast<uint16_t>(((rowSum << kProfileShift) + w_ / 2) / w_);
+    }
+    for (int x = 0; x < w_; x++) {
+        cols[x] = static_cast<uint16_t>(((colSums[x] << kProfileShift) + h_ / 2) / h_);
+    }
+}
+
+}  // namespace pxlcam::stack
@@ -15,6 +15,9 @@
 
 #include <Arduino.h>
 #include <SD_MMC.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <stdarg.h>
 
 namespace pxlcam::hwtest {
@@ -23,6 +26,15 @@ namespace {
 
 constexpr const char* kLogTag = "hwlog";
 
+/// Longest formatted record; longer lines are cut
+constexpr size_t kMaxRecord = 320;
+
+/// Drain task: lowest priority above idle, off the capture core
+constexpr uint32_t kTaskStack = 3072;
+constexpr UBaseType_t kTaskPriority = tskIDLE_PRIORITY + 1;
+constexpr BaseType_t kTaskCore = 0;
+constexpr uint32_t kStopWaitMs = 2000;
+
 //==============================================================================
 // State
 //==============================================================================
@@ -31,7 +43,21 @@ LogConfig g_config;
 File g_logFile;
 bool g_active = false;
 uint32_t g_lastFlushTime = 0;
-char g_lineBuf[256];
+
+// Record ring: loggers copy formatted lines in at tail + used, the drain
+// writes them out in batches from tail
+uint8_t* g_ring = nullptr;
+size_t g_ringSize = 0;
+size_t g_tail = 0;
+size_t g_used = 0;
+uint32_t g_dropped = 0;          ///< Records that did not fit
+uint32_t g_droppedReported = 0;  ///< Drops already noted in the file
+portMUX_TYPE g_ringLock = portMUX_INITIALIZER_UNLOCKED;
+
+uint32_t g_fileBytes = 0;        ///< Tracked log size (rotation without size())
+TaskHandle_t g_task = nullptr;
+volatile bool g_stopTask = false;
+volatile bool g_flushRequested = false;
 
 //==============================================================================
 // Helpers
@@ -48,19 +74,69 @@ const char* levelToStr(LogLevel level) {
     }
 }
 
+/// Direct write from the drain side (header, drop notes)
+void writeDirect(const char* text) {
+    g_fileBytes += g_logFile.print(text);
+}
+
 void writeHeader() {
-    g_logFile.println("================================================================================");
-    g_logFile.println("PXLcam v1.3.0-HWTEST Diagnostic Log");
-    g_logFile.printf("Boot Time: %lu ms\n", millis());
-    g_logFile.println("================================================================================");
-    g_logFile.println();
+    char line[48];
+    writeDirect("================================================================================\n");
+    writeDirect("PXLcam v1.3.0-HWTEST Diagnostic Log\n");
+    snprintf(line, sizeof(line), "Boot Time: %lu ms\n", millis());
+    writeDirect(line);
+    writeDirect("================================================================================\n\n");
     g_logFile.flush();
 }
 
+/// Queue one record; never touches the card
+void pushRecord(const char* text, size_t length) {
+    if (length > kMaxRecord) {
+        length = kMaxRecord;
+    }
+
+    bool wake = false;
+    portENTER_CRITICAL(&g_ringLock);
+    const size_t used = g_used;
+    if (g_ring == nullptr || used + length > g_ringSize) {
+        g_dropped++;
+    } else {
+        const size_t at = (g_tail + used) % g_ringSize;
+        const size_t first = length < g_ringSize - at ? length : g_ringSize - at;
+        memcpy(g_ring + at, text, first);
+        memcpy(g_ring, text + first, length - first);
+        g_used += length;
+        wake = used < g_config.batchBytes && used + length >= g_config.batchBytes;
+    }
+    portEXIT_CRITICAL(&g_ringLock);
+
+    if (wake && g_task != nullptr) {
+        xTaskNotifyGive(g_task);
+    }
+}
+
+void pushf(const char* fmt, ...) {
+    char line[kMaxRecord];
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n > 0) {
+        pushRecord(line, static_cast<size_t>(n) < sizeof(line) ? n : sizeof(line) - 1);
+    }
+}
+
+uint32_t pendingBytes() {
+    portENTER_CRITICAL(&g_ringLock);
+    const size_t used = g_used;
+    portEXIT_CRITICAL(&g_ringLock);
+    return static_cast<uint32_t>(used);
+}
+
 void checkRotate() {
     if (!g_active) return;
     
-    uint32_t size = g_logFile.size();
+    const uint32_t size = g_fileBytes;
     if (size < g_config.maxFileSizeKb * 1024) return;
     
     // Close current log
@@ -71,6 +147,7 @@ void checkRotate() {
     SD_MMC.rename(g_config.logPath, "/PXL/hwtest.log.bak");
     
     // Open new log
+    g_fileBytes = 0;
     g_logFile = SD_MMC.open(g_config.logPath, FILE_WRITE);
     if (g_logFile) {
         writeHeader();
@@ -81,6 +158,56 @@ void checkRotate() {
     }
 }
 
+/// Write everything queued, one contiguous ring span per write
+void drain(bool flush) {
+    while (g_active) {
+        portENTER_CRITICAL(&g_ringLock);
+        const size_t tail = g_tail;
+        const size_t used = g_used;
+        const uint32_t dropped = g_dropped;
+        portEXIT_CRITICAL(&g_ringLock);
+
+        if (dropped != g_droppedReported) {
+            char note[64];
+            snprintf(note, sizeof(note), "[%lu] LOG: %lu records dropped\n", millis(),
+                     static_cast<unsigned long>(dropped - g_droppedReported));
+            writeDirect(note);
+            g_droppedReported = dropped;
+        }
+        if (used == 0) {
+            break;
+        }
+
+        // The span is ours until tail moves: loggers only write into free space
+        const size_t span = used < g_ringSize - tail ? used : g_ringSize - tail;
+        g_fileBytes += g_logFile.write(g_ring + tail, span);
+
+        portENTER_CRITICAL(&g_ringLock);
+        g_tail = (tail + span) % g_ringSize;
+        g_used -= span;
+        portEXIT_CRITICAL(&g_ringLock);
+
+        checkRotate();
+    }
+
+    if (g_active && (flush || millis() - g_lastFlushTime >= g_config.flushIntervalMs)) {
+        g_logFile.flush();
+        g_lastFlushTime = millis();
+    }
+}
+
+/// Wakes on a full batch or every flush interval
+void drainTask(void*) {
+    while (!g_stopTask) {
+        const bool timedOut = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(g_config.flushIntervalMs)) == 0;
+        const bool flush = timedOut || g_flushRequested;
+        g_flushRequested = false;
+        drain(flush);
+    }
+    g_task = nullptr;
+    vTaskDelete(nullptr);
+}
+
 }  // anonymous namespace
 
 //==============================================================================
@@ -97,18 +224,41 @@ bool logInit(const LogConfig* config) {
         SD_MMC.mkdir("/PXL");
     }
     
+    g_ringSize = g_config.ringBytes;
+    g_ring = static_cast<uint8_t*>(heap_caps_malloc(g_ringSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!g_ring) {
+        g_ring = static_cast<uint8_t*>(heap_caps_malloc(g_ringSize, MALLOC_CAP_8BIT));
+    }
+    if (!g_ring) {
+        PXLCAM_LOGE_TAG(kLogTag, "No memory for %u-byte log ring", static_cast<unsigned>(g_ringSize));
+        return false;
+    }
+    g_tail = g_used = 0;
+    g_dropped = g_droppedReported = 0;
+    
     // Open log file for append
     g_logFile = SD_MMC.open(g_config.logPath, FILE_APPEND);
     if (!g_logFile) {
         PXLCAM_LOGE_TAG(kLogTag, "Failed to open log file: %s", g_config.logPath);
+        heap_caps_free(g_ring);
+        g_ring = nullptr;
         return false;
     }
     
+    g_fileBytes = g_logFile.size();  // Only query; from here on it is counted
     g_active = true;
     g_lastFlushTime = millis();
     
     writeHeader();
     
+    // Without the task logUpdate() drains on the caller's loop
+    g_stopTask = false;
+    if (xTaskCreatePinnedToCore(drainTask, "hwlog", kTaskStack, nullptr, kTaskPriority,
+                                &g_task, kTaskCore) != pdPASS) {
+        g_task = nullptr;
+        PXLCAM_LOGW_TAG(kLogTag, "Log task unavailable, draining from logUpdate()");
+    }
+    
     PXLCAM_LOGI_TAG(kLogTag, "Logging to %s", g_config.logPath);
     logEvent("BOOT", "HWTEST diagnostic mode started");
     
@@ -119,9 +269,25 @@ void logShutdown() {
     if (!g_active) return;
     
     logEvent("SHUTDOWN", "HWTEST session ending");
-    g_logFile.flush();
+    
+    if (g_task != nullptr) {
+        g_stopTask = true;
+        xTaskNotifyGive(g_task);
+        const uint32_t start = millis();
+        while (g_task != nullptr && millis() - start < kStopWaitMs) {
+            delay(10);
+        }
+    }
+    if (g_task == nullptr) {
+        drain(true);
+    }
+    
     g_logFile.close();
     g_active = false;
+    if (g_task == nullptr) {
+        heap_caps_free(g_ring);
+        g_ring = nullptr;
+    }
     
     PXLCAM_LOGI_TAG(kLogTag, "Log file closed");
 }
@@ -136,20 +302,21 @@ void logMsg(LogLevel level, const char* tag, const char* fmt, ...) {
     uint32_t m = s / 60;
     uint32_t h = m / 60;
     
-    // Build message
+    // Build message (caller's stack: loggers may be on any task)
+    char message[256];
     va_list args;
     va_start(args, fmt);
-    vsnprintf(g_lineBuf, sizeof(g_lineBuf), fmt, args);
+    vsnprintf(message, sizeof(message), fmt, args);
     va_end(args);
     
-    // Write to file
-    g_logFile.printf("[%02lu:%02lu:%02lu.%03lu] [%s] [%s] %s\n",
-                     h % 24, m % 60, s % 60, ms % 1000,
-                     levelToStr(level), tag, g_lineBuf);
+    // Queue for the file
+    pushf("[%02lu:%02lu:%02lu.%03lu] [%s] [%s] %s\n",
+          h % 24, m % 60, s % 60, ms % 1000,
+          levelToStr(level), tag, message);
     
     // Echo to serial if configured
     if (g_config.logToSerial) {
-        Serial.printf("[HWLOG] [%s] [%s] %s\n", levelToStr(level), tag, g_lineBuf);
+        Serial.printf("[HWLOG] [%s] [%s] %s\n", levelToStr(level), tag, message);
     }
 }
 
@@ -158,22 +325,30 @@ void logMetrics() {
     
     SystemMetrics m = getMetrics();
     
-    g_logFile.println("--- METRICS SNAPSHOT ---");
-    g_logFile.printf("  Memory: heap=%luK psram=%luK minHeap=%luK frag=%d%%\n",
-                     m.freeHeap / 1024, m.freePsram / 1024, 
-                     m.minFreeHeap / 1024, m.heapFragmentation);
-    g_logFile.printf("  Performance: fps=%.1f avg=%.1f frames=%lu\n",
-                     m.currentFps, m.avgFps, m.frameCount);
-    g_logFile.printf("  Timing: capture=%lums filter=%lums save=%lums\n",
-                     m.captureTimeMs, m.filterTimeMs, m.saveTimeMs);
-    g_logFile.printf("  WiFi: active=%d clients=%d ip=%s frames=%lu\n",
-                     m.wifiActive, m.wifiClients, m.wifiIp, m.wifiFramesSent);
-    g_logFile.printf("  Storage: sd=%d total=%lluMB free=%lluMB files=%lu\n",
-                     m.sdMounted, m.sdTotalMb, m.sdFreeMb, m.filesWritten);
-    g_logFile.printf("  Timelapse: active=%d frames=%lu interval=%lums\n",
-                     m.timelapseActive, m.timelapseFrames, m.timelapseIntervalMs);
-    g_logFile.printf("  Uptime: %lu seconds\n", m.uptimeSeconds);
-    g_logFile.println("------------------------");
+    pushf("--- METRICS SNAPSHOT ---\n");
+    pushf("  Memory: heap=%luK psram=%luK minHeap=%luK frag=%d%%\n",
+          m.freeHeap / 1024, m.freePsram / 1024, 
+          m.minFreeHeap / 1024, m.heapFragmentation);
+    pushf("  Performance: fps=%.1f avg=%.1f frames=%lu\n",
+          m.currentFps, m.avgFps, m.frameCount);
+    pushf("  Timing: capture=%lums filter=%lums save=%lums\n",
+          m.captureTimeMs, m.filterTimeMs, m.saveTimeMs);
+    pushf("  Preview: p50=%luus p95=%luus p99=%luus max=%luus jitter=%luus stalls=%lu\n",
+          m.previewP50Us, m.previewP95Us, m.previewP99Us, m.previewMaxUs,
+          m.previewJitterUs, m.previewStalls);
+    pushf("  Preview p95: grab=%lu decode=%lu downscale=%lu dither=%lu blit=%lu i2c=%lu us\n",
+          m.previewStageP95Us[0], m.previewStageP95Us[1], m.previewStageP95Us[2],
+          m.previewStageP95Us[3], m.previewStageP95Us[4], m.previewStageP95Us[5]);
+    pushf("  WiFi: active=%d clients=%d ip=%s frames=%lu\n",
+          m.wifiActive, m.wifiClients, m.wifiIp, m.wifiFramesSent);
+    pushf("  Storage: sd=%d total=%lluMB free=%lluMB files=%lu\n",
+          m.sdMounted, m.sdTotalMb, m.sdFreeMb, m.filesWritten);
+    pushf("  Timelapse: active=%d frames=%lu interval=%lums\n",
+          m.timelapseActive, m.timelapseFrames, m.timelapseIntervalMs);
+    pushf("  Log: size=%lu queued=%lu dropped=%lu\n",
+          g_fileBytes, pendingBytes(), g_dropped);
+    pushf("  Uptime: %lu seconds\n", m.uptimeSeconds);
+    pushf("------------------------\n");
 }
 
 void logEvent(const char* eventName, const char* detail) {
@@ -182,9 +357,9 @@ void logEvent(const char* eventName, const char* detail) {
     uint32_t ms = millis();
     
     if (detail) {
-        g_logFile.printf("[%lu] EVENT: %s - %s\n", ms, eventName, detail);
+        pushf("[%lu] EVENT: %s - %s\n", ms, eventName, detail);
     } else {
-        g_logFile.printf("[%lu] EVENT: %s\n", ms, eventName);
+        pushf("[%lu] EVENT: %s\n", ms, eventName);
     }
     
     if (g_config.logToSerial) {
@@ -194,8 +369,12 @@ void logEvent(const char* eventName, const char* detail) {
 
 void logFlush() {
     if (!g_active) return;
-    g_logFile.flush();
-    g_lastFlushTime = millis();
+    if (g_task != nullptr) {
+        g_flushRequested = true;
+        xTaskNotifyGive(g_task);
+    } else {
+        drain(true);
+    }
 }
 
 bool logIsActive() {
@@ -204,21 +383,20 @@ bool logIsActive() {
 
 uint32_t logGetSize() {
     if (!g_active) return 0;
-    return g_logFile.size();
+    return g_fileBytes + pendingBytes();
+}
+
+uint32_t logDroppedCount() {
+    return g_dropped;
 }
 
 void logUpdate() {
-    if (!g_active) return;
-    
-    uint32_t now = millis();
+    if (!g_active || g_task != nullptr) return;
     
-    // Auto-flush at interval
-    if (now - g_lastFlushTime >= g_config.flushIntervalMs) {
-        logFlush();
+    // No drain task: write a full batch or at the flush interval (rotates too)
+    if (pendingBytes() >= g_config.batchBytes || millis() - g_lastFlushTime >= g_config.flushIntervalMs) {
+        drain(false);
     }
-    
-    // Check if rotation needed
-    checkRotate();
 }
 
 }  // namespace pxlcam::hwtest
@@ -12,6 +12,8 @@
 
 #include "display.h"
 #include "logging.h"
+#include "capture_pipeline.h"
+#include "preview.h"
 
 #include <Arduino.h>
 #include <Adafruit_SSD1306.h>
@@ -112,6 +114,24 @@ void collectSdMetrics() {
     g_metrics.uptimeSeconds = (millis() - g_startTime) / 1000;
 }
 
+void collectPreviewMetrics() {
+    const auto& telemetry = pxlcam::preview::getFrameTelemetry();
+    
+    pxlcam::util::TimingSummary s;
+    telemetry.getFrameSummary(s);
+    g_metrics.previewP50Us = s.p50Us;
+    g_metrics.previewP95Us = s.p95Us;
+    g_metrics.previewP99Us = s.p99Us;
+    g_metrics.previewMaxUs = s.maxUs;
+    g_metrics.previewJitterUs = telemetry.getJitterUs();
+    g_metrics.previewStalls = telemetry.getStalls();
+    
+    for (uint8_t i = 0; i < kPreviewStageSlots; i++) {
+        telemetry.getStageSummary(static_cast<pxlcam::util::FrameStage>(i), s);
+        g_metrics.previewStageP95Us[i] = s.p95Us;
+    }
+}
+
 void calculateFps() {
     uint32_t now = millis();
     uint32_t elapsed = now - g_fpsLastCalcTime;
@@ -173,6 +193,7 @@ void update() {
     collectWifiMetrics();
     collectTimelapseMetrics();
     collectSdMetrics();
+    collectPreviewMetrics();
     calculateFps();
 }
 
@@ -199,7 +220,7 @@ void drawOverlay() {
     disp->setCursor(0, y);
     disp->print(buf);
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 void drawFullDiagScreen() {
@@ -228,8 +249,9 @@ void drawFullDiagScreen() {
     
     // Performance
     disp->setCursor(0, 30);
-    disp->printf("FPS: %.1f (avg:%.1f)",
-                 g_metrics.currentFps, g_metrics.avgFps);
+    disp->printf("FPS:%.1f p99:%lums S:%lu",
+                 g_metrics.currentFps, g_metrics.previewP99Us / 1000,
+                 g_metrics.previewStalls);
     
     // WiFi
     disp->setCursor(0, 39);
@@ -252,18 +274,42 @@ void drawFullDiagScreen() {
                  g_metrics.uptimeSeconds,
                  g_metrics.frameCount);
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 SystemMetrics getMetrics() {
     return g_metrics;
 }
 
-void recordCaptureTiming(uint32_t captureMs, uint32_t filterMs, uint32_t saveMs) {
+static_assert(kCaptureStageSlots == static_cast<uint8_t>(pxlcam::capture::CaptureStage::Count),
+              "kCaptureStageSlots must match CaptureStage::Count");
+static_assert(kPreviewStageSlots == static_cast<uint8_t>(pxlcam::util::FrameStage::Count),
+              "kPreviewStageSlots must match FrameStage::Count");
+
+void recordCaptureTiming(uint32_t captureMs, uint32_t filterMs, uint32_t saveMs,
+                         const pxlcam::capture::CaptureTimings* stages) {
     g_metrics.captureTimeMs = captureMs;
     g_metrics.filterTimeMs = filterMs;
     g_metrics.saveTimeMs = saveMs;
     g_metrics.frameCount++;
+    
+    if (stages) {
+        for (uint8_t i = 0; i < kCaptureStageSlots; i++) {
+            pxlcam::capture::StageStats st;
+            pxlcam::capture::getStageStats(static_cast<pxlcam::capture::CaptureStage>(i), st);
+            g_metrics.stageUs[i] = stages->stageUs[i];
+            g_metrics.stageP95Us[i] = st.p95Us;
+        }
+    }
+}
+
+void recordFrameStats(const pxlcam::capture::FrameStats& stats) {
+    g_metrics.lumaMean = stats.meanLuma;
+    g_metrics.lumaMin = stats.minLuma;
+    g_metrics.lumaMax = stats.maxLuma;
+    g_metrics.clippedPct = stats.pixels
+        ? static_cast<uint8_t>((100ull * (stats.clippedLow + stats.clippedHigh)) / stats.pixels)
+        : 0;
 }
 
 void tickFps() {
@@ -297,6 +343,34 @@ void logToSerial(const char* prefix) {
                     g_metrics.captureTimeMs,
                     g_metrics.filterTimeMs,
                     g_metrics.saveTimeMs);
+    
+    PXLCAM_LOGI_TAG(kLogTag, "[%s] stages(us): fb=%lu dec=%lu gray=%lu post=%lu sty=%lu enc=%lu save=%lu",
+                    prefix,
+                    g_metrics.stageUs[0], g_metrics.stageUs[1], g_metrics.stageUs[2],
+                    g_metrics.stageUs[3], g_metrics.stageUs[4], g_metrics.stageUs[5],
+                    g_metrics.stageUs[6]);
+    
+    PXLCAM_LOGI_TAG(kLogTag, "[%s] stages p95(us): fb=%lu dec=%lu gray=%lu post=%lu sty=%lu enc=%lu save=%lu",
+                    prefix,
+                    g_metrics.stageP95Us[0], g_metrics.stageP95Us[1], g_metrics.stageP95Us[2],
+                    g_metrics.stageP95Us[3], g_metrics.stageP95Us[4], g_metrics.stageP95Us[5],
+                    g_metrics.stageP95Us[6]);
+    
+    PXLCAM_LOGI_TAG(kLogTag, "[%s] preview(us): p50=%lu p95=%lu p99=%lu max=%lu jitter=%lu stalls=%lu",
+                    prefix,
+                    g_metrics.previewP50Us, g_metrics.previewP95Us, g_metrics.previewP99Us,
+                    g_metrics.previewMaxUs, g_metrics.previewJitterUs, g_metrics.previewStalls);
+    
+    PXLCAM_LOGI_TAG(kLogTag, "[%s] preview p95(us): grab=%lu dec=%lu ds=%lu dith=%lu blit=%lu i2c=%lu",
+                    prefix,
+                    g_metrics.previewStageP95Us[0], g_metrics.previewStageP95Us[1],
+                    g_metrics.previewStageP95Us[2], g_metrics.previewStageP95Us[3],
+                    g_metrics.previewStageP95Us[4], g_metrics.previewStageP95Us[5]);
+    
+    PXLCAM_LOGI_TAG(kLogTag, "[%s] luma: mean=%u min=%u max=%u clip=%u%%",
+                    prefix,
+                    g_metrics.lumaMean, g_metrics.lumaMin, g_metrics.lumaMax,
+                    g_metrics.clippedPct);
 }
 
 bool isEnabled() {
@@ -0,0 +1,334 @@
+/**
+ * @file jpeg_gray_encoder.cpp
+ * @brief Baseline grayscale JPEG encoder with fixed tables
+ */
+
+#include "jpeg_gray_encoder.h"
+
+#include <cstring>
+
+namespace pxlcam::jpeg {
+
+namespace {
+
+/// JPEG Annex K.1 luminance quantization table (natural order)
+constexpr uint8_t kLumaQuant[64] = {
+    16, 11, 10, 16, 24,  40,  51,  61,
+    12, 12, 14, 19, 26,  58,  60,  55,
+    14, 13, 16, 24, 40,  57,  69,  56,
+    14, 17, 22, 29, 51,  87,  80,  62,
+    18, 22, 37, 56, 68,  109, 103, 77,
+    24, 35, 55, 64, 81,  104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103, 99,
+};
+
+/// Zigzag index → natural index
+constexpr uint8_t kZigzag[64] = {
+    0,  1,  8,  16, 9,  2,  3,  10,
+    17, 24, 32, 25, 18, 11, 4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13, 6,  7,  14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+/// Annex K.3 luminance Huffman tables (code counts per length, symbols)
+constexpr uint8_t kDcBits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcVals[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+constexpr uint8_t kAcBits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+constexpr uint8_t kAcVals[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61,
+    0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52,
+    0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25,
+    0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45,
+    0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64,
+    0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83,
+    0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+    0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+    0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3,
+    0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8,
+    0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+/// AAN scale factors: cos(k·π/16)·√2, 1 for k = 0
+constexpr float kAanScale[8] = {
+    1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+    1.0f, 0.785694958f, 0.541196100f, 0.275899379f,
+};
+
+/// Canonical Huffman codes from the (bits, vals) description
+void buildHuffman(const uint8_t* bits, const uint8_t* vals, uint16_t* codes, uint8_t* sizes) {
+    uint16_t code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; len++) {
+        for (int i = 0; i < bits[len - 1]; i++) {
+            codes[vals[k]] = code;
+            sizes[vals[k]] = static_cast<uint8_t>(len);
+            code++;
+            k++;
+        }
+        code <<= 1;
+    }
+}
+
+/// In-place AAN forward DCT (rows then columns), output scaled by 8·AAN
+void fdct8x8(float* d) {
+    for (int pass = 0; pass < 2; pass++) {
+        const int step = pass == 0 ? 1 : 8;
+        const int next = pass == 0 ? 8 : 1;
+        for (int i = 0; i < 8; i++) {
+            float* p = d + i * next;
+            const float t0 = p[0 * step] + p[7 * step];
+            const float t7 = p[0 * step] - p[7 * step];
+            const float t1 = p[1 * step] + p[6 * step];
+            const float t6 = p[1 * step] - p[6 * step];
+            const float t2 = p[2 * step] + p[5 * step];
+            const float t5 = p[2 * step] - p[5 * step];
+            const float t3 = p[3 * step] + p[4 * step];
+            const float t4 = p[3 * step] - p[4 * step];
+
+            // Even part
+            const float t10 = t0 + t3;
+            const float t13 = t0 - t3;
+            const float t11 = t1 + t2;
+            const float t12 = t1 - t2;
+            p[0 * step] = t10 + t11;
+            p[4 * step] = t10 - t11;
+            const float z1 = (t12 + t13) * 0.707106781f;
+            p[2 * step] = t13 + z1;
+            p[6 * step] = t13 - z1;
+
+            // Odd part
+            const float s10 = t4 + t5;
+            const float s11 = t5 + t6;
+            const float s12 = t6 + t7;
+            const float z5 = (s10 - s12) * 0.382683433f;
+            const float z2 = 0.541196100f * s10 + z5;
+            const float z4 = 1.306562965f * s12 + z5;
+            const float z3 = s11 * 0.707106781f;
+            const float z11 = t7 + z3;
+            const float z13 = t7 - z3;
+            p[5 * step] = z13 + z2;
+            p[3 * step] = z13 - z2;
+            p[1 * step] = z11 + z4;
+            p[7 * step] = z11 - z4;
+        }
+    }
+}
+
+/// Entropy-coded segment writer with 0xFF byte stuffing
+struct BitWriter {
+    uint8_t* out;
+    size_t capacity;
+    size_t pos;
+    uint32_t acc;
+    int bits;
+    bool overflow;
+
+    void byte(uint8_t b) {
+        if (pos >= capacity) {
+            overflow = true;
+            return;
+        }
+        out[pos++] = b;
+    }
+
+    void put(uint32_t code, int size) {
+        acc = (acc << size) | (code & ((1u << size) - 1));
+        bits += size;
+        while (bits >= 8) {
+            const uint8_t b = static_cast<uint8_t>(acc >> (bits - 8));
+            byte(b);
+            if (b == 0xFF) {
+                byte(0x00);
+            }
+            bits -= 8;
+        }
+    }
+
+    /// Pad the last byte with 1 bits
+    void flush() {
+        if (bits > 0) {
+            put(0x7F, 8 - bits);
+        }
+    }
+};
+
+/// Magnitude category of a coefficient (bits needed for |v|)
+inline int category(int v) {
+    if (v < 0) v = -v;
+    int n = 0;
+    while (v) {
+        n++;
+        v >>= 1;
+    }
+    return n;
+}
+
+/// Additional bits for a coefficient of the given category
+inline uint32_t magnitudeBits(int v, int cat) {
+    return v < 0 ? static_cast<uint32_t>(v + (1 << cat) - 1) : static_cast<uint32_t>(v);
+}
+
+size_t writeMarker(uint8_t* out, size_t pos, uint8_t marker, const uint8_t* body, size_t len) {
+    out[pos++] = 0xFF;
+    out[pos++] = marker;
+    out[pos++] = static_cast<uint8_t>((len + 2) >> 8);
+    out[pos++] = static_cast<uint8_t>(len + 2);
+    memcpy(out + pos, body, len);
+    return pos + len;
+}
+
+}  // namespace
+
+void GrayJpegEncoder::begin(uint8_t quality) {
+    if (quality < 1) quality = 1;
+    if (quality > 100) quality = 100;
+    const int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+
+    for (int i = 0; i < 64; i++) {
+        int q = (kLumaQuant[kZigzag[i]] * scale + 50) / 100;
+        if (q < 1) q = 1;
+        if (q > 255) q = 255;
+        qtable_[i] = static_cast<uint8_t>(q);
+    }
+
+    // Fold quantization and the AAN output scaling into one multiplier
+    for (int zz = 0; zz < 64; zz++) {
+        const int n = kZigzag[zz];
+        const int row = n >> 3;
+        const int col = n & 7;
+        fdtbl_[n] = 1.0f / (qtable_[zz] * kAanScale[row] * kAanScale[col] * 8.0f);
+    }
+
+    memset(dcCode_, 0, sizeof(dcCode_));
+    memset(dcSize_, 0, sizeof(dcSize_));
+    memset(acCode_, 0, sizeof(acCode_));
+    memset(acSize_, 0, sizeof(acSize_));
+    buildHuffman(kDcBits, kDcVals, dcCode_, dcSize_);
+    buildHuffman(kAcBits, kAcVals, acCode_, acSize_);
+    ready_ = true;
+}
+
+size_t GrayJpegEncoder::encode(const uint8_t* gray, int width, int height, int stride, int scale,
+                               uint8_t* out, size_t capacity) const {
+    if (!ready_ || !gray || !out || width <= 0 || height <= 0 || scale < 1 || scale > 4) {
+        return 0;
+    }
+    const int outW = width * scale;
+    const int outH = height * scale;
+    if (outW > 0xFFFF || outH > 0xFFFF || capacity < 700) {
+        return 0;
+    }
+
+    // Headers: SOI, APP0 (JFIF), DQT, SOF0, DHT ×2, SOS (~620 bytes)
+    size_t pos = 0;
+    out[pos++] = 0xFF;
+    out[pos++] = 0xD8;
+
+    static const uint8_t kJfif[14] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+    pos = writeMarker(out, pos, 0xE0, kJfif, sizeof(kJfif));
+
+    uint8_t dqt[65];
+    dqt[0] = 0;     // 8-bit precision, table 0
+    memcpy(dqt + 1, qtable_, 64);
+    pos = writeMarker(out, pos, 0xDB, dqt, sizeof(dqt));
+
+    const uint8_t sof[9] = {
+        8,
+        static_cast<uint8_t>(outH >> 8), static_cast<uint8_t>(outH),
+        static_cast<uint8_t>(outW >> 8), static_cast<uint8_t>(outW),
+        1,              // One component
+        1, 0x11, 0,     // Id 1, 1×1 sampling, quant table 0
+    };
+    pos = writeMarker(out, pos, 0xC0, sof, sizeof(sof));
+
+    uint8_t dht[1 + 16 + 162];
+    dht[0] = 0x00;  // DC table 0
+    memcpy(dht + 1, kDcBits, 16);
+    memcpy(dht + 17, kDcVals, sizeof(kDcVals));
+    pos = writeMarker(out, pos, 0xC4, dht, 17 + sizeof(kDcVals));
+    dht[0] = 0x10;  // AC table 0
+    memcpy(dht + 1, kAcBits, 16);
+    memcpy(dht + 17, kAcVals, sizeof(kAcVals));
+    pos = writeMarker(out, pos, 0xC4, dht, 17 + sizeof(kAcVals));
+
+    static const uint8_t kSos[6] = {1, 1, 0x00, 0, 63, 0};
+    pos = writeMarker(out, pos, 0xDA, kSos, sizeof(kSos));
+
+    // Leave room for EOI
+    BitWriter bw = {out, capacity - 2, pos, 0, 0, false};
+    int prevDc = 0;
+    float block[64];
+
+    for (int by = 0; by < outH && !bw.overflow; by += 8) {
+        for (int bx = 0; bx < outW && !bw.overflow; bx += 8) {
+            // Gather with upscale; partial blocks replicate the last row/column
+            for (int y = 0; y < 8; y++) {
+                int oy = by + y;
+                if (oy >= outH) oy = outH - 1;
+                const uint8_t* row = gray + static_cast<size_t>(oy / scale) * stride;
+                for (int x = 0; x < 8; x++) {
+                    int ox = bx + x;
+                    if (ox >= outW) ox = outW - 1;
+                    block[y * 8 + x] = static_cast<float>(row[ox / scale]) - 128.0f;
+                }
+            }
+
+            fdct8x8(block);
+
+            int coeffs[64];
+            for (int zz = 0; zz < 64; zz++) {
+                const int n = kZigzag[zz];
+                const float v = block[n] * fdtbl_[n];
+                coeffs[zz] = static_cast<int>(v < 0.0f ? v - 0.5f : v + 0.5f);
+            }
+
+            const int diff = coeffs[0] - prevDc;
+            prevDc = coeffs[0];
+            const int dcCat = category(diff);
+            bw.put(dcCode_[dcCat], dcSize_[dcCat]);
+            if (dcCat) {
+                bw.put(magnitudeBits(diff, dcCat), dcCat);
+            }
+
+            int run = 0;
+            for (int zz = 1; zz < 64; zz++) {
+                int v = coeffs[zz];
+                if (v == 0) {
+                    run++;
+                    continue;
+                }
+                while (run >= 16) {
+                    bw.put(acCode_[0xF0], acSize_[0xF0]);    // ZRL
+                    run -= 16;
+                }
+                // Baseline AC tops out at category 10 (only reachable at quality 100)
+                if (v > 1023) v = 1023;
+                if (v < -1023) v = -1023;
+                const int cat = category(v);
+                const uint8_t symbol = static_cast<uint8_t>((run << 4) | cat);
+                bw.put(acCode_[symbol], acSize_[symbol]);
+                bw.put(magnitudeBits(v, cat), cat);
+                run = 0;
+            }
+            if (run > 0) {
+                bw.put(acCode_[0x00], acSize_[0x00]);        // EOB
+            }
+        }
+    }
+
+    bw.flush();
+    if (bw.overflow) {
+        return 0;
+    }
+    pos = bw.pos;
+    out[pos++] = 0xFF;
+    out[pos++] = 0xD9;
+    return pos;
+}
+
+}  // namespace pxlcam::jpeg
@@ -0,0 +1,139 @@
+/**
+ * @file jpeg_luma.cpp
+ * @brief JPEG → luminance decoder (no RGB888 staging buffer)
+ */
+
+#include "jpeg_luma.h"
+#include "logging.h"
+
+#include <cstring>
+
+namespace pxlcam::jpeg {
+
+namespace {
+
+constexpr const char* kLogTag = "pxlcam-jpeg";
+
+/// Largest MCU emitted by TJpgDec (16x16 for 4:2:0 subsampling)
+constexpr size_t kMaxMcuPixels = 16 * 16;
+
+struct BlockDecoder {
+    const uint8_t* input;
+    size_t inputLen;
+    LumaBlockCallback callback;
+    void* user;
+    uint8_t luma[kMaxMcuPixels];
+};
+
+struct PlaneWriter {
+    uint8_t* out;
+    uint16_t maxW;
+    uint16_t maxH;
+    uint16_t width;
+    uint16_t height;
+};
+
+size_t readInput(void* arg, size_t index, uint8_t* buf, size_t len) {
+    BlockDecoder* dec = static_cast<BlockDecoder*>(arg);
+    if (index >= dec->inputLen) {
+        return 0;
+    }
+    if (len > dec->inputLen - index) {
+        len = dec->inputLen - index;
+    }
+    if (buf) {
+        memcpy(buf, dec->input + index, len);
+    }
+    return len;
+}
+
+bool writeBlock(void* arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* data) {
+    BlockDecoder* dec = static_cast<BlockDecoder*>(arg);
+    
+    if (!data) {
+        // Start marker carries the output size at (0,0); end marker is ignored
+        if (x == 0 && y == 0) {
+            return dec->callback(dec->user, 0, 0, w, h, nullptr);
+        }
+        return true;
+    }
+    
+    const size_t count = static_cast<size_t>(w) * h;
+    if (count > kMaxMcuPixels) {
+        PXLCAM_LOGE_TAG(kLogTag, "MCU too large: %ux%u", w, h);
+        return false;
+    }
+    
+    // TJpgDec emits R,G,B per pixel; ITU-R BT.601 luma
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* p = data + i * 3;
+        dec->luma[i] = (77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8;
+    }
+    
+    return dec->callback(dec->user, x, y, w, h, dec->luma);
+}
+
+bool writePlane(void* user, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* luma) {
+    PlaneWriter* plane = static_cast<PlaneWriter*>(user);
+    
+    if (!luma) {
+        if (w > plane->maxW || h > plane->maxH) {
+            PXLCAM_LOGE_TAG(kLogTag, "JPEG too large: %ux%u (max %ux%u)", w, h, plane->maxW, plane->maxH);
+            return false;
+        }
+        plane->width = w;
+        plane->height = h;
+        return true;
+    }
+    
+    uint8_t* dst = plane->out + static_cast<size_t>(y) * plane->width + x;
+    for (uint16_t row = 0; row < h; row++) {
+        memcpy(dst, luma, w);
+        dst += plane->width;
+        luma += w;
+    }
+    return true;
+}
+
+}  // anonymous namespace
+
+bool decodeLumaBlocks(const uint8_t* jpg, size_t len,
+                      LumaBlockCallback callback, void* user,
+                      jpg_scale_t scale) {
+    if (!jpg || len == 0 || !callback) {
+        return false;
+    }
+    
+    BlockDecoder dec;
+    dec.input = jpg;
+    dec.inputLen = len;
+    dec.callback = callback;
+    dec.user = user;
+    
+    esp_err_t err = esp_jpg_decode(len, scale, readInput, writeBlock, &dec);
+    if (err != ESP_OK) {
+        PXLCAM_LOGE_TAG(kLogTag, "JPEG decode failed: %d", err);
+        return false;
+    }
+    return true;
+}
+
+bool decodeToLuma(const uint8_t* jpg, size_t len, uint8_t* outGray,
+                  uint16_t maxW, uint16_t maxH,
+                  uint16_t* outW, uint16_t* outH,
+                  jpg_scale_t scale) {
+    if (!outGray) {
+        return false;
+    }
+    
+    PlaneWriter plane = { outGray, maxW, maxH, 0, 0 };
+    if (!decodeLumaBlocks(jpg, len, writePlane, &plane, scale)) {
+        return false;
+    }
+    
+    if (outW) *outW = plane.width;
+    if (outH) *outH = plane.height;
+    return true;
+}
+
+}  // namespace pxlcam::jpeg
@@ -0,0 +1,210 @@
+/**
+ * @file mem_placement.cpp
+ * @brief Where hot code, tables and row buffers live (IRAM, DRAM, PSRAM)
+ */
+
+#include "mem_placement.h"
+
+#ifdef ESP32
+#include "logging.h"
+
+#include <freertos/FreeRTOS.h>
+#include <soc/soc.h>
+#if __has_include(<esp_memory_utils.h>)
+#include <esp_memory_utils.h>
+#else
+#include <soc/soc_memory_layout.h>
+#endif
+#define PLACEMENT_HAS_LOCK 1
+#else
+#include <stdio.h>
+#define PLACEMENT_HAS_LOCK 0
+#endif
+
+namespace pxlcam::placement {
+
+namespace {
+
+constexpr const char* kLogTag = "placement";
+
+struct Entry {
+    const char* name;
+    const void* ptr;
+    size_t bytes;
+};
+
+// Scratch block: .bss, which the linker keeps in internal DRAM
+alignas(16) uint8_t g_scratch[PXLCAM_DRAM_SCRATCH_BYTES > 0 ? PXLCAM_DRAM_SCRATCH_BYTES : 1];
+size_t g_used = 0;
+uint32_t g_blocks = 0;
+uint32_t g_failures = 0;
+
+Entry g_entries[PXLCAM_PLACEMENT_MAX_ENTRIES];
+uint16_t g_entryCount = 0;
+uint16_t g_dropped = 0;
+
+#if PLACEMENT_HAS_LOCK
+portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+#define PLACEMENT_LOCK() portENTER_CRITICAL(&g_lock)
+#define PLACEMENT_UNLOCK() portEXIT_CRITICAL(&g_lock)
+#else
+#define PLACEMENT_LOCK()
+#define PLACEMENT_UNLOCK()
+#endif
+
+bool validAlign(size_t align) {
+    return align != 0 && (align & (align - 1)) == 0;
+}
+
+/// Caller holds the lock
+void noteLocked(const char* name, const void* ptr, size_t bytes) {
+    for (uint16_t i = 0; i < g_entryCount; i++) {
+        if (g_entries[i].ptr == ptr) {
+            g_entries[i].name = name;
+            g_entries[i].bytes = bytes;
+            return;
+        }
+    }
+    if (g_entryCount < PXLCAM_PLACEMENT_MAX_ENTRIES) {
+        g_entries[g_entryCount++] = Entry{name, ptr, bytes};
+    } else {
+        g_dropped++;
+    }
+}
+
+}  // namespace
+
+const char* regionName(Region region) {
+    switch (region) {
+        case Region::Iram:    return "IRAM";
+        case Region::Dram:    return "DRAM";
+        case Region::Psram:   return "PSRAM";
+        case Region::Flash:   return "flash";
+        default:              return "?";
+    }
+}
+
+Region regionOf(const void* ptr) {
+#ifdef ESP32
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+    if (esp_ptr_in_iram(ptr)) {
+        return Region::Iram;
+    }
+    if (esp_ptr_in_dram(ptr)) {
+        return Region::Dram;
+    }
+    if (esp_ptr_external_ram(ptr)) {
+        return Region::Psram;
+    }
+    if (esp_ptr_in_drom(ptr) || (addr >= SOC_IROM_LOW && addr < SOC_IROM_HIGH)) {
+        return Region::Flash;
+    }
+#else
+    (void)ptr;
+#endif
+    return Region::Unknown;
+}
+
+void* scratch(size_t bytes, const char* name, size_t align) {
+    if (bytes == 0 || !validAlign(align) || PXLCAM_DRAM_SCRATCH_BYTES == 0) {
+        return nullptr;
+    }
+
+    void* block = nullptr;
+    PLACEMENT_LOCK();
+    const uintptr_t base = reinterpret_cast<uintptr_t>(g_scratch);
+    const uintptr_t aligned = (base + g_used + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    const size_t offset = aligned - base;
+    if (offset <= PXLCAM_DRAM_SCRATCH_BYTES && PXLCAM_DRAM_SCRATCH_BYTES - offset >= bytes) {
+        block = g_scratch + offset;
+        g_used = offset + bytes;
+        g_blocks++;
+        noteLocked(name, block, bytes);
+    } else {
+        g_failures++;
+    }
+    PLACEMENT_UNLOCK();
+
+#ifdef ESP32
+    if (!block) {
+        PXLCAM_LOGW_TAG(kLogTag, "%s: %u bytes do not fit in DRAM scratch", name,
+                        static_cast<unsigned>(bytes));
+    } else {
+        PXLCAM_LOGI_TAG(kLogTag, "%s: %u bytes in DRAM scratch", name, static_cast<unsigned>(bytes));
+    }
+#endif
+    return block;
+}
+
+bool owns(const void* ptr) {
+    const uint8_t* p = static_cast<const uint8_t*>(ptr);
+    return PXLCAM_DRAM_SCRATCH_BYTES > 0 && p >= g_scratch && p < g_scratch + PXLCAM_DRAM_SCRATCH_BYTES;
+}
+
+void note(const char* name, const void* ptr, size_t bytes) {
+    if (!ptr) {
+        return;
+    }
+    PLACEMENT_LOCK();
+    noteLocked(name, ptr, bytes);
+    PLACEMENT_UNLOCK();
+}
+
+Stats getStats() {
+    Stats stats = {};
+    PLACEMENT_LOCK();
+    stats.capacity = PXLCAM_DRAM_SCRATCH_BYTES;
+    stats.used = g_used;
+    stats.blocks = g_blocks;
+    stats.failures = g_failures;
+    stats.entries = g_entryCount;
+    stats.dropped = g_dropped;
+    PLACEMENT_UNLOCK();
+    return stats;
+}
+
+void logReport() {
+    // Entries are only ever appended or updated in place; a copy keeps the
+    // logging out of the critical section
+    Entry entries[PXLCAM_PLACEMENT_MAX_ENTRIES];
+    const Stats stats = getStats();
+    PLACEMENT_LOCK();
+    for (uint16_t i = 0; i < stats.entries; i++) {
+        entries[i] = g_entries[i];
+    }
+    PLACEMENT_UNLOCK();
+
+    size_t regionBytes[static_cast<size_t>(Region::Count)] = {};
+    for (uint16_t i = 0; i < stats.entries; i++) {
+        const Region region = regionOf(entries[i].ptr);
+        regionBytes[static_cast<size_t>(region)] += entries[i].bytes;
+#ifdef ESP32
+        PXLCAM_LOGI_TAG(kLogTag, "%-20s %-5s %6u bytes @%p", entries[i].name, regionName(region),
+                        static_cast<unsigned>(entries[i].bytes), entries[i].ptr);
+#else
+        printf("%-20s %-5s %6u bytes @%p\n", entries[i].name, regionName(region),
+               static_cast<unsigned>(entries[i].bytes), entries[i].ptr);
+#endif
+    }
+
+#ifdef ESP32
+    uint8_t probe = 0;  // Where the calling task's stack (and its row buffers) is
+    PXLCAM_LOGI_TAG(kLogTag, "Placement: IRAM %u, DRAM %u, PSRAM %u, flash %u bytes; "
+                    "scratch %u/%u (%u blocks, %u misses); stack in %s; %u entries, %u dropped",
+                    static_cast<unsigned>(regionBytes[static_cast<size_t>(Region::Iram)]),
+                    static_cast<unsigned>(regionBytes[static_cast<size_t>(Region::Dram)]),
+                    static_cast<unsigned>(regionBytes[static_cast<size_t>(Region::Psram)]),
+                    static_cast<unsigned>(regionBytes[static_cast<size_t>(Region::Flash)]),
+                    static_cast<unsigned>(stats.used), static_cast<unsigned>(stats.capacity),
+                    static_cast<unsigned>(stats.blocks), static_cast<unsigned>(stats.failures),
+                    regionName(regionOf(&probe)),
+                    static_cast<unsigned>(stats.entries), static_cast<unsigned>(stats.dropped));
+#else
+    printf("Placement: scratch %u/%u (%u blocks, %u misses); %u entries, %u dropped\n",
+           static_cast<unsigned>(stats.used), static_cast<unsigned>(stats.capacity),
+           static_cast<unsigned>(stats.blocks), static_cast<unsigned>(stats.failures),
+           static_cast<unsigned>(stats.entries), static_cast<unsigned>(stats.dropped));
+#endif
+}
+
+}  // namespace pxlcam::placement
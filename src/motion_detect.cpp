@@ -0,0 +1,220 @@
+/**
+ * @file motion_detect.cpp
+ * @brief Cheap scene-change detector on small grayscale frames
+ */
+
+#include "motion_detect.h"
+#include "swar.h"
+
+#include <cstring>
+
+namespace pxlcam::motion {
+
+namespace {
+
+/// |a - b| summed over 4 pixels of a word pair
+inline uint32_t sad4(uint32_t a, uint32_t b) {
+    const uint32_t d = swar::subSat(a, b) | swar::subSat(b, a);
+    const uint32_t pairs = (d & 0x00FF00FFu) + ((d >> 8) & 0x00FF00FFu);
+    return (pairs & 0xFFFF) + (pairs >> 16);
+}
+
+/// SAD of one 8-pixel block row
+inline uint32_t sadRow8(const uint8_t* a, const uint8_t* b, bool words) {
+    if (words) {
+        return sad4(swar::load4(a), swar::load4(b)) + sad4(swar::load4(a + 4), swar::load4(b + 4));
+    }
+    uint32_t sum = 0;
+    for (int i = 0; i < kBlockSize; i++) {
+        sum += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    }
+    return sum;
+}
+
+}  // namespace
+
+void blockSad(const uint8_t* a, const uint8_t* b, int w, int h, uint16_t* blockSad) {
+    const int blocksX = w / kBlockSize;
+    const int blocksY = h / kBlockSize;
+    
+    // Rows stay word aligned when the frames and the width are
+    const bool words = swar::aligned4(a) && swar::aligned4(b) && (w & 3) == 0;
+    
+    for (int by = 0; by < blocksY; by++) {
+        uint16_t* out = blockSad + by * blocksX;
+        memset(out, 0, blocksX * sizeof(uint16_t));
+        
+        for (int row = 0; row < kBlockSize; row++) {
+            const size_t offset = static_cast<size_t>(by * kBlockSize + row) * w;
+            const uint8_t* pa = a + offset;
+            const uint8_t* pb = b + offset;
+            for (int bx = 0; bx < blocksX; bx++) {
+                out[bx] += sadRow8(pa + bx * kBlockSize, pb + bx * kBlockSize, words);
+            }
+        }
+    }
+}
+
+bool ChangeDetector::begin(int w, int h, const Config& config) {
+    if (w <= 0 || h <= 0 || w % kBlockSize || h % kBlockSize || w * h > kMaxPixels) {
+        w_ = 0;
+        h_ = 0;
+        return false;
+    }
+    w_ = w;
+    h_ = h;
+    config_ = config;
+    changedBlocks_ = 0;
+    maxBlockSad_ = 0;
+    staticFrames_ = 0;
+    primed_ = false;
+    return true;
+}
+
+bool ChangeDetector::update(const uint8_t* gray) {
+    if (!gray || w_ == 0) {
+        return true;
+    }
+    
+    const size_t pixels = static_cast<size_t>(w_) * h_;
+    if (!primed_) {
+        memcpy(ref_, gray, pixels);
+        primed_ = true;
+        changedBlocks_ = static_cast<uint16_t>(pixels / (kBlockSize * kBlockSize));
+        maxBlockSad_ = 0;
+        staticFrames_ = 0;
+        return true;
+    }
+    
+    uint16_t sads[kMaxPixels / (kBlockSize * kBlockSize)];
+    blockSad(gray, ref_, w_, h_, sads);
+    
+    const int blocks = static_cast<int>(pixels / (kBlockSize * kBlockSize));
+    uint16_t changed = 0;
+    uint16_t maxSad = 0;
+    for (int i = 0; i < blocks; i++) {
+        if (sads[i] > config_.blockThreshold) changed++;
+        if (sads[i] > maxSad) maxSad = sads[i];
+    }
+    changedBlocks_ = changed;
+    maxBlockSad_ = maxSad;
+    
+    if (changed < config_.minBlocks) {
+        staticFrames_++;
+        return false;
+    }
+    
+    memcpy(ref_, gray, pixels);
+    staticFrames_ = 0;
+    return true;
+}
+
+bool MotionDetector::begin(int w, int h, const Config& config) {
+    if (w <= 0 || h <= 0 || w % kBlockSize || h % kBlockSize || w * h > kMaxPixels) {
+        w_ = 0;
+        h_ = 0;
+        return false;
+    }
+    w_ = w;
+    h_ = h;
+    config_ = config;
+    memset(sensitivity_, kDefaultSensitivity, sizeof(sensitivity_));
+    events_ = 0;
+    suppressed_ = 0;
+    reset();
+    return true;
+}
+
+void MotionDetector::setZone(int bx0, int by0, int bx1, int by1, uint8_t sensitivity) {
+    const int blocksX = w_ / kBlockSize;
+    const int blocksY = h_ / kBlockSize;
+    for (int by = by0 < 0 ? 0 : by0; by < by1 && by < blocksY; by++) {
+        for (int bx = bx0 < 0 ? 0 : bx0; bx < bx1 && bx < blocksX; bx++) {
+            sensitivity_[by * blocksX + bx] = sensitivity;
+        }
+    }
+}
+
+void MotionDetector::reset() {
+    frames_ = 0;            // The cool-down carries on
+    movingBlocks_ = 0;
+}
+
+bool MotionDetector::update(const uint8_t* gray, uint32_t nowMs) {
+    if (!gray || w_ == 0) {
+        return false;
+    }
+    
+    const size_t pixels = static_cast<size_t>(w_) * h_;
+    const int blocksX = w_ / kBlockSize;
+    const int blocks = static_cast<int>(pixels / (kBlockSize * kBlockSize));
+    if (frames_ == 0) {
+        for (size_t i = 0; i < pixels; i++) {
+            background_[i] = static_cast<uint16_t>(gray[i] << 4);
+        }
+        memcpy(reference_, gray, pixels);
+        for (int i = 0; i < blocks; i++) {
+            // Start where noiseFactor times the noise is the floor
+            noise_[i] = static_cast<uint16_t>((static_cast<uint32_t>(config_.noiseFloor) << 4) /
+                                              (config_.noiseFactor ? config_.noiseFactor : 1));
+        }
+        frames_ = 1;
+        movingBlocks_ = 0;
+        return false;
+    }
+    
+    uint16_t sads[kMaxBlocks];
+    blockSad(gray, reference_, w_, h_, sads);
+    
+    const bool learning = frames_ < config_.learnFrames;
+    uint16_t moving = 0;
+    for (int i = 0; i < blocks; i++) {
+        const uint32_t sad = sads[i];
+        const uint32_t noise = (static_cast<uint32_t>(noise_[i]) * config_.noiseFactor + 8) >> 4;
+        const uint32_t threshold = noise > config_.noiseFloor ? noise : config_.noiseFloor;
+        // SAD * sensitivity / 100 against the threshold, without dividing
+        const bool isMoving = sensitivity_[i] != 0 &&
+                              sad * sensitivity_[i] > threshold * kDefaultSensitivity;
+        if (isMoving) {
+            moving++;
+        }
+        
+        // Noise: fast while learning, then mostly from still blocks, so a
+        // flickering area raises its own level over time (Q4, below 65536)
+        const int noiseShift = learning ? 1 : (isMoving ? 6 : 3);
+        const int32_t target = static_cast<int32_t>(sad > 4095 ? 4095 : sad) << 4;
+        noise_[i] = static_cast<uint16_t>(noise_[i] + ((target - noise_[i]) >> noiseShift));
+        
+        // Blend the block into the background
+        const int shift = (isMoving && !learning) ? config_.movingShift : config_.stillShift;
+        const int bx = (i % blocksX) * kBlockSize;
+        const int by = (i / blocksX) * kBlockSize;
+        for (int row = 0; row < kBlockSize; row++) {
+            const size_t offset = static_cast<size_t>(by + row) * w_ + bx;
+            for (int col = 0; col < kBlockSize; col++) {
+                const size_t p = offset + col;
+                const int32_t diff = (static_cast<int32_t>(gray[p]) << 4) - background_[p];
+                background_[p] = static_cast<uint16_t>(background_[p] + (diff >> shift));
+                reference_[p] = static_cast<uint8_t>((background_[p] + 8) >> 4);
+            }
+        }
+    }
+    movingBlocks_ = moving;
+    
+    if (learning) {
+        frames_++;
+        return false;
+    }
+    if (moving < config_.minBlocks) {
+        return false;
+    }
+    if (events_ != 0 && nowMs - lastEventMs_ < config_.cooldownMs) {
+        suppressed_++;
+        return false;
+    }
+    lastEventMs_ = nowMs;
+    events_++;
+    return true;
+}
+
+}  // namespace pxlcam::motion
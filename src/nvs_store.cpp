@@ -181,6 +181,36 @@ int8_t readI8(const char* key, int8_t defaultValue) {
     return g_prefs.getChar(key, defaultValue);
 }
 
+bool writeBytes(const char* key, const void* data, size_t len) {
+    if (!g_initialized || !key || !data) {
+        PXLCAM_LOGE_TAG(kLogTag, "writeBytes falhou: NVS=%d, key=%s", g_initialized, key ? key : "null");
+        return false;
+    }
+    
+    size_t written = g_prefs.putBytes(key, data, len);
+    
+    if (written != len) {
+        PXLCAM_LOGE_TAG(kLogTag, "Falha ao escrever blob [%s] (%u bytes)", key, static_cast<unsigned>(len));
+        return false;
+    }
+    
+    PXLCAM_LOGD_TAG(kLogTag, "Blob escrito [%s] (%u bytes)", key, static_cast<unsigned>(len));
+    return true;
+}
+
+bool readBytes(const char* key, void* out, size_t len) {
+    if (!g_initialized || !key || !out) {
+        return false;
+    }
+    
+    // A blob of another size is from an older layout
+    if (!g_prefs.isKey(key) || g_prefs.getBytesLength(key) != len) {
+        return false;
+    }
+    
+    return g_prefs.getBytes(key, out, len) == len;
+}
+
 bool exists(const char* key) {
     if (!g_initialized || !key) {
         return false;
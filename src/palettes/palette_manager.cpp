@@ -7,6 +7,7 @@
  */
 
 #include "palettes/palette_manager.h"
+#include "pxlcam_config.h"
 
 #ifdef PXL_V13_EXPERIMENTAL
 
@@ -123,6 +124,7 @@ static const Palette s_builtinPalettes[] = {
 static Palette s_customPalettes[3];
 static PaletteId s_activePaletteId = PaletteId::GAMEBOY_CLASSIC;
 static bool s_initialized = false;
+static bool s_colorOutput = PXLCAM_CAPTURE_COLOR_OUTPUT != 0;
 
 // ============================================================================
 // Color Methods
@@ -136,6 +138,10 @@ uint32_t Color::toRGB888() const {
     return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
 }
 
+uint8_t Color::toLuma() const {
+    return (77 * r + 150 * g + 29 * b) >> 8;
+}
+
 // ============================================================================
 // Palette Manager Implementation
 // ============================================================================
@@ -238,6 +244,32 @@ uint8_t getPaletteCount() {
     return static_cast<uint8_t>(PaletteId::PALETTE_COUNT);
 }
 
+void setColorOutput(bool enabled) {
+    s_colorOutput = enabled;
+}
+
+bool isColorOutput() {
+    return s_colorOutput;
+}
+
+void indexColors(uint8_t tones[Palette::MAX_COLORS], uint8_t rgb[Palette::MAX_COLORS * 3]) {
+    const Palette* pal = s_colorOutput ? getActivePalette() : nullptr;
+    
+    for (uint8_t i = 0; i < Palette::MAX_COLORS; i++) {
+        if (!pal || pal->colorCount == 0) {
+            rgb[i * 3 + 0] = rgb[i * 3 + 1] = rgb[i * 3 + 2] = tones[i];
+            continue;
+        }
+        
+        // 2-3 color palettes: darkest index → first color, lightest → last
+        const Color& color = pal->colors[i * (pal->colorCount - 1) / (Palette::MAX_COLORS - 1)];
+        rgb[i * 3 + 0] = color.r;
+        rgb[i * 3 + 1] = color.g;
+        rgb[i * 3 + 2] = color.b;
+        tones[i] = color.toLuma();
+    }
+}
+
 } // namespace palettes
 } // namespace pxlcam
 
@@ -0,0 +1,546 @@
+/**
+ * @file pipeline_bench.cpp
+ * @brief On-device benchmark of the capture pipeline stages
+ */
+
+#include "pipeline_bench.h"
+
+namespace pxlcam::bench {
+
+const char* placementName(Placement placement) {
+    switch (placement) {
+        case Placement::Psram:    return "psram";
+        case Placement::Internal: return "internal";
+        default:                  return "?";
+    }
+}
+
+}  // namespace pxlcam::bench
+
+#if PXLCAM_FEATURE_BENCHMARK
+
+#include "camera_config.h"
+#include "camera_service.h"
+#include "capture_pipeline.h"
+#include "display.h"
+#include "filters/dither_pipeline.h"
+#include "filters/palette.h"
+#include "filters/postprocess.h"
+#include "filters/resample.h"
+#include "jpeg_gray_encoder.h"
+#include "jpeg_luma.h"
+#include "logging.h"
+#include "luma_extract.h"
+#include "png_indexed_writer.h"
+#include "storage.h"
+
+#include <SD_MMC.h>
+#include <esp_camera.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+namespace pxlcam::bench {
+
+namespace {
+
+constexpr const char* kLogTag = "bench";
+constexpr const char* kCsvHeader =
+    "width,height,memory,stage,runs,min_us,avg_us,max_us,ns_per_px,bytes,status\n";
+
+/// Written by the sd_write stage, removed after it
+constexpr const char* kScratchPath = "/bench/scratch.bmp";
+
+constexpr framesize_t kFrameSizes[] = { PXLCAM_BENCH_FRAMESIZES };
+
+/// OLED blit source: the preview's size
+constexpr int kBlitSize = 64;
+
+using filters::DitherAlgorithm;
+
+/// Short CSV names, indexed by DitherAlgorithm
+const char* const kDitherStages[] = {
+    "dither_ordered8", "dither_ordered4", "dither_floyd", "dither_atkinson", "dither_bluenoise"
+};
+static_assert(sizeof(kDitherStages) / sizeof(kDitherStages[0]) ==
+              static_cast<size_t>(DitherAlgorithm::COUNT),
+              "One stage name per DitherAlgorithm");
+
+struct FilterStage {
+    const char* name;
+    void (*apply)(uint8_t* gray, int w, int h);
+};
+
+/// Each postprocess filter at a typical setting
+const FilterStage kFilterStages[] = {
+    { "pp_gamma",         [](uint8_t* p, int w, int h) { filters::filter_gamma(p, w, h, 0.8f); } },
+    { "pp_contrast",      [](uint8_t* p, int w, int h) { filters::filter_contrast(p, w, h, 1.3f); } },
+    { "pp_brightness",    [](uint8_t* p, int w, int h) { filters::filter_brightness(p, w, h, 20); } },
+    { "pp_sharpen",       [](uint8_t* p, int w, int h) { filters::filter_sharpen(p, w, h, 0.5f); } },
+    { "pp_denoise",       [](uint8_t* p, int w, int h) { filters::filter_denoise(p, w, h, 1.0f); } },
+    { "pp_histogram_eq",  [](uint8_t* p, int w, int h) { filters::filter_histogram_eq(p, w, h); } },
+    { "pp_night_enhance", [](uint8_t* p, int w, int h) { filters::filter_night_enhance(p, w, h); } },
+    { "pp_vignette",      [](uint8_t* p, int w, int h) { filters::filter_vignette(p, w, h, 0.5f, 0.5f); } },
+    { "pp_grain",         [](uint8_t* p, int w, int h) { filters::filter_grain(p, w, h, 0.3f); } },
+};
+
+// The last sweep's CSV (PSRAM, allocated on the first run)
+char* g_csv = nullptr;
+size_t g_csvLen = 0;
+bool g_csvReady = false;
+bool g_csvFull = false;
+
+std::atomic<bool> g_pending(false);
+std::atomic<bool> g_running(false);
+
+// Kernel state shared by every sweep
+filters::AreaResampler g_resampler;
+jpeg::GrayJpegEncoder g_jpeg;
+
+// =============================================================================
+// Buffers
+// =============================================================================
+
+uint32_t placementCaps(Placement placement) {
+    return placement == Placement::Internal ? (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+                                            : (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+/// Working set of one sweep, all in one placement (no fallback: a
+/// placement that does not fit is what the no_mem row reports)
+struct Buffers {
+    uint8_t* frame = nullptr;           ///< Copy of the sensor frame
+    uint8_t* gray = nullptr;            ///< w * h decoded luma
+    uint8_t* work = nullptr;            ///< 2 * w * h: RGB565 copy, filter and dither output
+    uint8_t* out = nullptr;             ///< Encoder output
+    size_t outCapacity = 0;
+    png::IndexedPngWriter* png = nullptr;
+
+    bool allocate(Placement placement, size_t frameLen, int w, int h) {
+        const uint32_t caps = placementCaps(placement);
+        const size_t pixels = static_cast<size_t>(w) * h;
+        outCapacity = capture::getBmpSize(w, h);
+        if (png::IndexedPngWriter::maxSize(w, h, 2) > outCapacity) {
+            outCapacity = png::IndexedPngWriter::maxSize(w, h, 2);
+        }
+        if (jpeg::GrayJpegEncoder::worstCaseSize(w, h) > outCapacity) {
+            outCapacity = jpeg::GrayJpegEncoder::worstCaseSize(w, h);
+        }
+
+        frame = static_cast<uint8_t*>(heap_caps_malloc(frameLen, caps));
+        gray = static_cast<uint8_t*>(heap_caps_malloc(pixels, caps));
+        work = static_cast<uint8_t*>(heap_caps_malloc(pixels * 2, caps));
+        out = static_cast<uint8_t*>(heap_caps_malloc(outCapacity, caps));
+        void* writer = heap_caps_malloc(sizeof(png::IndexedPngWriter), caps);
+        if (writer) {
+            png = new (writer) png::IndexedPngWriter();
+        }
+        return frame && gray && work && out && png;
+    }
+
+    ~Buffers() {
+        if (png) {
+            png->~IndexedPngWriter();
+            heap_caps_free(png);
+        }
+        heap_caps_free(frame);
+        heap_caps_free(gray);
+        heap_caps_free(work);
+        heap_caps_free(out);
+    }
+};
+
+struct MemorySink {
+    uint8_t* buf;
+    size_t capacity;
+    size_t len;
+};
+
+bool memorySink(void* user, const uint8_t* data, size_t len) {
+    MemorySink* sink = static_cast<MemorySink*>(user);
+    if (sink->len + len > sink->capacity) {
+        return false;
+    }
+    memcpy(sink->buf + sink->len, data, len);
+    sink->len += len;
+    return true;
+}
+
+// =============================================================================
+// Timing and CSV
+// =============================================================================
+
+struct Timing {
+    uint32_t minUs = 0;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+    uint8_t runs = 0;
+};
+
+/// Time PXLCAM_BENCH_RUNS calls of stage(); prepare() runs untimed before
+/// each (restoring in-place inputs)
+/// @return false as soon as a call fails
+template <typename Prepare, typename Stage>
+bool timeStage(Timing& timing, Prepare prepare, Stage stage) {
+    for (int run = 0; run < PXLCAM_BENCH_RUNS; run++) {
+        prepare();
+        const int64_t start = esp_timer_get_time();
+        const bool ok = stage();
+        const uint32_t us = static_cast<uint32_t>(esp_timer_get_time() - start);
+        if (!ok) {
+            return false;
+        }
+        if (timing.runs == 0 || us < timing.minUs) timing.minUs = us;
+        if (us > timing.maxUs) timing.maxUs = us;
+        timing.totalUs += us;
+        timing.runs++;
+    }
+    return true;
+}
+
+template <typename Stage>
+bool timeStage(Timing& timing, Stage stage) {
+    return timeStage(timing, [] {}, stage);
+}
+
+void appendCsv(const char* text) {
+    const size_t len = strlen(text);
+    if (g_csvLen + len + 1 > PXLCAM_BENCH_CSV_BYTES) {
+        if (!g_csvFull) {
+            PXLCAM_LOGW_TAG(kLogTag, "CSV buffer full, dropping rows (PXLCAM_BENCH_CSV_BYTES)");
+        }
+        g_csvFull = true;
+        return;
+    }
+    memcpy(g_csv + g_csvLen, text, len + 1);
+    g_csvLen += len;
+}
+
+/// Where the rows of one sweep go
+struct Context {
+    uint16_t width;
+    uint16_t height;
+    const char* memory;
+};
+
+void addRow(const Context& ctx, const char* stage, const Timing& timing, size_t bytes) {
+    const uint32_t pixels = static_cast<uint32_t>(ctx.width) * ctx.height;
+    const uint32_t avgUs = timing.runs ? static_cast<uint32_t>(timing.totalUs / timing.runs) : 0;
+    const uint32_t nsPerPx = pixels ? static_cast<uint32_t>((static_cast<uint64_t>(timing.minUs) * 1000) / pixels) : 0;
+    char row[128];
+    snprintf(row, sizeof(row), "%u,%u,%s,%s,%u,%u,%u,%u,%u,%u,ok\n",
+             ctx.width, ctx.height, ctx.memory, stage, timing.runs,
+             static_cast<unsigned>(timing.minUs), static_cast<unsigned>(avgUs),
+             static_cast<unsigned>(timing.maxUs), static_cast<unsigned>(nsPerPx),
+             static_cast<unsigned>(bytes));
+    appendCsv(row);
+    PXLCAM_LOGD_TAG(kLogTag, "%ux%u %-8s %-18s min %6u us avg %6u us", ctx.width, ctx.height,
+                    ctx.memory, stage, static_cast<unsigned>(timing.minUs), static_cast<unsigned>(avgUs));
+}
+
+/// A stage that did not run: no_mem, failed or skipped
+void addStatusRow(const Context& ctx, const char* stage, const char* status) {
+    char row[96];
+    snprintf(row, sizeof(row), "%u,%u,%s,%s,0,,,,,,%s\n", ctx.width, ctx.height, ctx.memory, stage, status);
+    appendCsv(row);
+    PXLCAM_LOGW_TAG(kLogTag, "%ux%u %s %s: %s", ctx.width, ctx.height, ctx.memory, stage, status);
+}
+
+/// Record a timed stage; the next stage starts after a tick so WiFi and
+/// the idle task get the CPU between them
+void finishStage(const Context& ctx, const char* stage, bool ok, const Timing& timing, size_t bytes = 0) {
+    if (ok) {
+        addRow(ctx, stage, timing, bytes);
+    } else {
+        addStatusRow(ctx, stage, "failed");
+    }
+    vTaskDelay(1);
+}
+
+// =============================================================================
+// Sweeps
+// =============================================================================
+
+/// Time fb_get at the sensor's current size and keep the last frame
+camera_fb_t* benchFrameGrab(Timing& timing) {
+    camera_fb_t* fb = nullptr;
+    const bool ok = timeStage(timing, [&] {
+        if (fb) {
+            esp_camera_fb_return(fb);
+            fb = nullptr;
+        }
+    }, [&] {
+        fb = esp_camera_fb_get();
+        return fb != nullptr;
+    });
+    if (!ok && fb) {
+        esp_camera_fb_return(fb);
+        fb = nullptr;
+    }
+    return fb;
+}
+
+/// Every stage after the grab, on a copy of one frame, with the working
+/// set in one placement
+void sweep(const camera_fb_t* fb, Placement placement) {
+    const int w = fb->width;
+    const int h = fb->height;
+    const size_t pixels = static_cast<size_t>(w) * h;
+    const Context ctx = { static_cast<uint16_t>(w), static_cast<uint16_t>(h), placementName(placement) };
+
+    Buffers b;
+    if (!b.allocate(placement, fb->len, w, h)) {
+        addStatusRow(ctx, "alloc", "no_mem");
+        return;
+    }
+    memcpy(b.frame, fb->buf, fb->len);
+
+    // Decode to luma (or pull Y out of a raw luma frame)
+    Timing t;
+    const size_t step = lumaSampleStep(fb->format);
+    if (fb->format == PIXFORMAT_JPEG) {
+        const size_t len = fb->len;
+        const bool ok = timeStage(t, [&] {
+            return jpeg::decodeToLuma(b.frame, len, b.gray, w, h);
+        });
+        finishStage(ctx, "decode", ok, t);
+        if (!ok) return;
+    } else if (step != 0) {
+        const bool ok = timeStage(t, [&] {
+            luma::extractPlane(b.frame, w * step, step, b.gray, w, w, h);
+            return true;
+        });
+        finishStage(ctx, "decode", ok, t);
+    } else {
+        // RGB565 / RGB888 sensor: the gray stage below is the conversion
+        addStatusRow(ctx, "decode", "skipped");
+        for (size_t i = 0; i < pixels; i++) {
+            b.gray[i] = static_cast<uint8_t>((i * 256) / pixels);
+        }
+    }
+
+    // RGB565 to gray, the conversion RGB565 sensors take instead of decode
+    for (size_t i = 0; i < pixels; i++) {
+        const uint8_t v = b.gray[i];
+        const uint16_t rgb = ((v & 0xF8) << 8) | ((v & 0xFC) << 3) | (v >> 3);
+        b.work[i * 2] = static_cast<uint8_t>(rgb >> 8);
+        b.work[i * 2 + 1] = static_cast<uint8_t>(rgb);
+    }
+    t = Timing();
+    finishStage(ctx, "gray", timeStage(t, [&] {
+        for (int y = 0; y < h; y++) {
+            luma::rgb565Row(b.work + y * w * 2, b.out + y * w, w);
+        }
+        return true;
+    }), t);
+
+    // Filters, each on a fresh copy of the frame
+    for (const FilterStage& filter : kFilterStages) {
+        t = Timing();
+        finishStage(ctx, filter.name, timeStage(t, [&] { memcpy(b.work, b.gray, pixels); }, [&] {
+            filter.apply(b.work, w, h);
+            return true;
+        }), t);
+    }
+
+    // Dithers
+    const filters::Palette& palette = filters::palette_get(filters::PaletteType::GB_CLASSIC);
+    for (uint8_t a = 0; a < static_cast<uint8_t>(DitherAlgorithm::COUNT); a++) {
+        const DitherAlgorithm algo = static_cast<DitherAlgorithm>(a);
+        t = Timing();
+        finishStage(ctx, kDitherStages[a], timeStage(t, [&] {
+            return filters::apply_palette_dither(b.gray, filters::SourceFormat::GRAYSCALE, b.work,
+                                                 w, h, palette, algo).success;
+        }), t);
+    }
+
+    // Encoders
+    size_t bmpLen = 0;
+    t = Timing();
+    finishStage(ctx, "encode_bmp", timeStage(t, [&] {
+        return capture::encodeGrayscaleBmp(b.gray, w, h, b.out, bmpLen);
+    }), t, bmpLen);
+
+    filters::DitherConfig packed;
+    packed.algorithm = DitherAlgorithm::ORDERED_8X8;
+    packed.output = filters::DitherOutput::PACKED_2BPP;
+    MemorySink sink = { b.out, b.outCapacity, 0 };
+    const size_t rowBytes = png::IndexedPngWriter::rowBytes(w, 2);
+    const bool packedOk = filters::apply_palette_dither_ex(b.gray, filters::SourceFormat::GRAYSCALE, b.work,
+                                                           w, h, palette, packed).success;
+    t = Timing();
+    finishStage(ctx, "encode_png", packedOk && timeStage(t, [&] { sink.len = 0; }, [&] {
+        if (!b.png->begin(w, h, 2, palette.tones, filters::PALETTE_TONE_COUNT, memorySink, &sink)) {
+            return false;
+        }
+        for (int y = 0; y < h; y++) {
+            b.png->writeRow(b.work + y * rowBytes);
+        }
+        return b.png->finish();
+    }), t, sink.len);
+
+    size_t jpegLen = 0;
+    t = Timing();
+    finishStage(ctx, "encode_jpeg", timeStage(t, [&] {
+        jpegLen = g_jpeg.encode(b.gray, w, h, w, 1, b.out, b.outCapacity);
+        return jpegLen > 0;
+    }), t, jpegLen);
+
+    // SD write of the BMP, from this placement
+    if (!storage::getStorageStatus().mounted) {
+        addStatusRow(ctx, "sd_write", "skipped");
+    } else if (capture::encodeGrayscaleBmp(b.gray, w, h, b.out, bmpLen)) {
+        t = Timing();
+        finishStage(ctx, "sd_write", timeStage(t, [&] {
+            return storage::saveFile(kScratchPath, b.out, bmpLen);
+        }), t, bmpLen);
+        SD_MMC.remove(kScratchPath);
+    }
+
+    // OLED blit: downscale to the preview size, draw, push every page
+    if (!display::getDisplayPtr()) {
+        addStatusRow(ctx, "oled_blit", "skipped");
+    } else {
+        uint8_t* thumb = b.out;
+        t = Timing();
+        finishStage(ctx, "oled_blit", timeStage(t, [&] {
+            if (!g_resampler.begin(w, h, filters::ResampleFormat::GRAY, thumb, kBlitSize, kBlitSize, kBlitSize)) {
+                return false;
+            }
+            for (int y = 0; y < h; y++) {
+                g_resampler.push_row(b.gray + y * w);
+            }
+            display::drawGrayscale64x64(thumb);
+            display::invalidateDisplay();
+            display::updateDisplay();
+            return g_resampler.done();
+        }), t);
+    }
+}
+
+}  // namespace
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+bool run() {
+    sensor_t* sensor = esp_camera_sensor_get();
+    if (!sensor) {
+        PXLCAM_LOGE_TAG(kLogTag, "Camera not initialized");
+        return false;
+    }
+    if (!g_csv) {
+        g_csv = static_cast<char*>(heap_caps_malloc(PXLCAM_BENCH_CSV_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        if (!g_csv) {
+            g_csv = static_cast<char*>(malloc(PXLCAM_BENCH_CSV_BYTES));
+        }
+        if (!g_csv) {
+            PXLCAM_LOGE_TAG(kLogTag, "No memory for the CSV buffer");
+            return false;
+        }
+    }
+
+    g_running = true;
+    g_csvReady = false;
+    g_csvLen = 0;
+    g_csvFull = false;
+    appendCsv(kCsvHeader);
+
+    filters::palette_init();
+    filters::dither_init();
+    filters::postprocess_init();
+    if (!g_jpeg.isReady()) {
+        g_jpeg.begin(80);
+    }
+
+    // Every size is read straight from the driver; consumers wait it out
+    frames::Pause pause;
+    const int64_t startUs = esp_timer_get_time();
+    const framesize_t previous = static_cast<framesize_t>(sensor->status.framesize);
+    PXLCAM_LOGI_TAG(kLogTag, "Benchmark: %u sizes x %u placements, %d runs per stage",
+                    static_cast<unsigned>(sizeof(kFrameSizes) / sizeof(kFrameSizes[0])),
+                    static_cast<unsigned>(Placement::Count), PXLCAM_BENCH_RUNS);
+
+    for (const framesize_t size : kFrameSizes) {
+        if (!setFrameSize(size, 2)) {
+            PXLCAM_LOGW_TAG(kLogTag, "Frame size %d not available, skipped", static_cast<int>(size));
+            continue;
+        }
+
+        Timing grab;
+        camera_fb_t* fb = benchFrameGrab(grab);
+        if (!fb) {
+            const Context ctx = { 0, 0, "camera" };
+            addStatusRow(ctx, "fb_get", "failed");
+            continue;
+        }
+        const Context camera = { static_cast<uint16_t>(fb->width), static_cast<uint16_t>(fb->height), "camera" };
+        if (fb->width != resolution[size].width || fb->height != resolution[size].height) {
+            // Larger than the frame buffers the camera was initialized for
+            addStatusRow(camera, "fb_get", "skipped");
+            esp_camera_fb_return(fb);
+            continue;
+        }
+        finishStage(camera, "fb_get", true, grab, fb->len);
+
+        for (uint8_t p = 0; p < static_cast<uint8_t>(Placement::Count); p++) {
+            sweep(fb, static_cast<Placement>(p));
+        }
+        esp_camera_fb_return(fb);
+    }
+
+    setFrameSize(previous, 2);
+
+    if (storage::getStorageStatus().mounted &&
+        !storage::saveFile(PXLCAM_BENCH_CSV_PATH, reinterpret_cast<const uint8_t*>(g_csv), g_csvLen)) {
+        PXLCAM_LOGW_TAG(kLogTag, "Could not write %s", PXLCAM_BENCH_CSV_PATH);
+    }
+
+    g_csvReady = true;
+    g_running = false;
+    PXLCAM_LOGI_TAG(kLogTag, "Benchmark done in %u ms (%u CSV bytes)",
+                    static_cast<unsigned>((esp_timer_get_time() - startUs) / 1000),
+                    static_cast<unsigned>(g_csvLen));
+    return true;
+}
+
+void requestRun() {
+    g_pending = true;
+}
+
+bool isPending() {
+    return g_pending;
+}
+
+bool isRunning() {
+    return g_running;
+}
+
+bool poll() {
+    if (!g_pending) {
+        return false;
+    }
+    run();
+    g_pending = false;
+    return true;
+}
+
+const char* results(size_t* len) {
+    if (!g_csvReady || g_running) {
+        if (len) *len = 0;
+        return nullptr;
+    }
+    if (len) *len = g_csvLen;
+    return g_csv;
+}
+
+}  // namespace pxlcam::bench
+
+#endif  // PXLCAM_FEATURE_BENCHMARK
@@ -1,6 +1,7 @@
 #include "pixel_filter.h"
 
 #include <algorithm>
+#include <cstring>
 
 #include <esp_log.h>
 
@@ -26,78 +27,218 @@ bool isRgbFramebuffer(const camera_fb_t *frame) {
     return frame != nullptr && frame->format == PIXFORMAT_RGB888;
 }
 
-}  // namespace
+constexpr int kSumSlots = 192;     // Per-column-block sums kept on the stack at once
+constexpr uint16_t kMaxMcuSide = 16;
 
-void init(const FilterConfig &config) {
-    g_config = config;
-    if (g_config.blockSize == 0) {
-        g_config.blockSize = kDefaultBlockSize;
+// 2^n block sizes divide full blocks with a shift; -1 otherwise.
+int blockShift(uint8_t block) {
+    int shift = 0;
+    while ((1 << shift) < block) {
+        ++shift;
     }
-    g_initialized = true;
+    return (1 << shift) == block ? shift : -1;
 }
 
-void applyPixelFilter(uint8_t *rgbBuffer, size_t length, uint16_t width, uint16_t height, uint8_t blockSize, uint8_t brightnessOffset) {
-    if (rgbBuffer == nullptr || length == 0 || width == 0 || height == 0) {
+void repeatPixel(const uint8_t *pixel, uint8_t channels, uint16_t count, uint8_t *out) {
+    if (channels == 1) {
+        memset(out, pixel[0], count);
+        return;
+    }
+    for (uint16_t i = 0; i < count; ++i) {
+        memcpy(out + i * channels, pixel, channels);
+    }
+}
+
+// Block average of an interleaved buffer with kChannels bytes per pixel.
+// A band of blocks is summed column by column as its rows stream past, so
+// each pixel is read once and written once and only edge blocks divide.
+template <int kChannels>
+void pixelate(uint8_t *buffer, uint16_t width, uint16_t height, uint8_t block, uint8_t brightnessOffset) {
+    if (width == 0 || height == 0 || block <= 1) {
         return;
     }
 
-    const uint8_t block = blockSize == 0 ? kDefaultBlockSize : blockSize;
-    const uint32_t stride = static_cast<uint32_t>(width) * 3;
+    constexpr int kBandBlocks = kSumSlots / kChannels;
+    const size_t stride = static_cast<size_t>(width) * kChannels;
+    const int shift = blockShift(block);
+    const uint16_t bandWidth = std::min<uint32_t>(kBandBlocks * block, width);
+    uint32_t sums[kSumSlots];
+    uint8_t averages[kSumSlots];
 
     for (uint16_t y = 0; y < height; y += block) {
         const uint16_t blockHeight = std::min<uint16_t>(block, height - y);
 
-        for (uint16_t x = 0; x < width; x += block) {
-            const uint16_t blockWidth = std::min<uint16_t>(block, width - x);
-
-            uint32_t sumR = 0;
-            uint32_t sumG = 0;
-            uint32_t sumB = 0;
-            uint32_t pixelCount = 0;
+        for (uint16_t x0 = 0; x0 < width; x0 += bandWidth) {
+            const uint16_t x1 = std::min<uint32_t>(x0 + bandWidth, width);
+            const int blocks = (x1 - x0 + block - 1) / block;
+            memset(sums, 0, sizeof(uint32_t) * blocks * kChannels);
 
             for (uint16_t by = 0; by < blockHeight; ++by) {
-                const uint32_t rowOffset = static_cast<uint32_t>(y + by) * stride;
-                const uint32_t colOffset = static_cast<uint32_t>(x) * 3;
-                const uint8_t *rowPtr = rgbBuffer + rowOffset + colOffset;
-
-                for (uint16_t bx = 0; bx < blockWidth; ++bx) {
-                    const uint8_t *pixel = rowPtr + (bx * 3);
-                    sumR += pixel[0];
-                    sumG += pixel[1];
-                    sumB += pixel[2];
-                    ++pixelCount;
+                const uint8_t *pixel = buffer + (y + by) * stride + x0 * kChannels;
+                uint32_t *sum = sums;
+                for (uint16_t x = x0; x < x1; sum += kChannels) {
+                    const uint16_t end = std::min<uint32_t>(x + block, x1);
+                    for (; x < end; ++x, pixel += kChannels) {
+                        for (int c = 0; c < kChannels; ++c) {
+                            sum[c] += pixel[c];
+                        }
+                    }
                 }
             }
 
-            if (pixelCount == 0) {
-                continue;
+            for (int b = 0; b < blocks; ++b) {
+                const uint16_t blockWidth = std::min<uint32_t>(block, x1 - x0 - b * block);
+                const bool whole = shift >= 0 && blockWidth == block && blockHeight == block;
+                const uint32_t pixelCount = static_cast<uint32_t>(blockWidth) * blockHeight;
+                for (int c = 0; c < kChannels; ++c) {
+                    const uint32_t sum = sums[b * kChannels + c];
+                    const uint32_t average = whole ? (sum >> (2 * shift)) : (sum / pixelCount);
+                    averages[b * kChannels + c] = clampByte(static_cast<int>(average) + brightnessOffset);
+                }
             }
 
-            const uint8_t avgR = clampByte(static_cast<int>(sumR / pixelCount) + brightnessOffset);
-            const uint8_t avgG = clampByte(static_cast<int>(sumG / pixelCount) + brightnessOffset);
-            const uint8_t avgB = clampByte(static_cast<int>(sumB / pixelCount) + brightnessOffset);
-
             for (uint16_t by = 0; by < blockHeight; ++by) {
-                const uint32_t rowOffset = static_cast<uint32_t>(y + by) * stride;
-                const uint32_t colOffset = static_cast<uint32_t>(x) * 3;
-                uint8_t *rowPtr = rgbBuffer + rowOffset + colOffset;
-
-                for (uint16_t bx = 0; bx < blockWidth; ++bx) {
-                    uint8_t *pixel = rowPtr + (bx * 3);
-                    pixel[0] = avgR;
-                    pixel[1] = avgG;
-                    pixel[2] = avgB;
+                uint8_t *pixel = buffer + (y + by) * stride + x0 * kChannels;
+                const uint8_t *average = averages;
+                for (uint16_t x = x0; x < x1; average += kChannels) {
+                    const uint16_t run = std::min<uint32_t>(block, x1 - x);
+                    repeatPixel(average, kChannels, run, pixel);
+                    pixel += run * kChannels;
+                    x += run;
                 }
             }
         }
     }
 }
 
+}  // namespace
+
+void init(const FilterConfig &config) {
+    g_config = config;
+    if (g_config.blockSize == 0) {
+        g_config.blockSize = kDefaultBlockSize;
+    }
+    g_initialized = true;
+}
+
+void applyPixelFilter(uint8_t *rgbBuffer, size_t length, uint16_t width, uint16_t height, uint8_t blockSize, uint8_t brightnessOffset) {
+    if (rgbBuffer == nullptr || length < static_cast<size_t>(width) * height * 3) {
+        return;
+    }
+    pixelate<3>(rgbBuffer, width, height, blockSize == 0 ? kDefaultBlockSize : blockSize, brightnessOffset);
+}
+
+void applyPixelFilterGray(uint8_t *grayBuffer, size_t length, uint16_t width, uint16_t height, uint8_t blockSize, uint8_t brightnessOffset) {
+    if (grayBuffer == nullptr || length < static_cast<size_t>(width) * height) {
+        return;
+    }
+    pixelate<1>(grayBuffer, width, height, blockSize == 0 ? kDefaultBlockSize : blockSize, brightnessOffset);
+}
+
+jpg_scale_t decodeScaleFor(uint8_t blockSize) {
+    switch (blockSize) {
+        case 2: return JPG_SCALE_2X;
+        case 4: return JPG_SCALE_4X;
+        case 8: return JPG_SCALE_8X;
+        default: return JPG_SCALE_NONE;
+    }
+}
+
+bool decodeScaled(const uint8_t *jpg, size_t len, uint8_t blockSize, uint8_t brightnessOffset,
+                  uint8_t *pixels, uint16_t maxWidth, uint16_t maxHeight, ScaledImage &out) {
+    const jpg_scale_t scale = decodeScaleFor(blockSize);
+    if (scale == JPG_SCALE_NONE) {
+        return false;
+    }
+
+    uint16_t width = 0;
+    uint16_t height = 0;
+    if (!jpeg::decodeToLuma(jpg, len, pixels, maxWidth, maxHeight, &width, &height, scale)) {
+        return false;
+    }
+
+    // The offset is applied to the block averages, as the full-resolution filter does
+    if (brightnessOffset != 0) {
+        const size_t count = static_cast<size_t>(width) * height;
+        for (size_t i = 0; i < count; ++i) {
+            pixels[i] = clampByte(pixels[i] + brightnessOffset);
+        }
+    }
+
+    out = ScaledImage{pixels, width, height, 1, blockSize};
+    return true;
+}
+
+void expandRow(const ScaledImage &image, uint16_t y, uint8_t *out, uint16_t width) {
+    const uint8_t *src = image.pixels + static_cast<size_t>(y / image.scale) * image.width * image.channels;
+    const uint16_t columns = std::min<uint16_t>(image.width, (width + image.scale - 1) / image.scale);
+
+    for (uint16_t x = 0; x < columns; ++x) {
+        const uint16_t run = std::min<uint16_t>(image.scale, width - x * image.scale);
+        repeatPixel(src + x * image.channels, image.channels, run, out);
+        out += run * image.channels;
+    }
+}
+
+void expandInPlace(const ScaledImage &image) {
+    const size_t rowBytes = static_cast<size_t>(image.width) * image.channels;
+    const size_t fullRowBytes = rowBytes * image.scale;
+
+    // Bottom-up and right to left, a scaled pixel is read before its block overwrites it
+    for (int y = image.height - 1; y >= 0; --y) {
+        const uint8_t *src = image.pixels + y * rowBytes;
+        uint8_t *dst = image.pixels + static_cast<size_t>(y) * image.scale * fullRowBytes;
+
+        for (int x = image.width - 1; x >= 0; --x) {
+            repeatPixel(src + x * image.channels, image.channels, image.scale,
+                        dst + static_cast<size_t>(x) * image.scale * image.channels);
+        }
+        for (uint8_t row = 1; row < image.scale; ++row) {
+            memcpy(dst + row * fullRowBytes, dst, fullRowBytes);
+        }
+    }
+}
+
+bool expandBlocks(void *expander, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t *luma) {
+    const BlockExpander *blocks = static_cast<const BlockExpander *>(expander);
+    const uint8_t scale = blocks->scale;
+    const uint16_t fullWidth = w * scale;
+    const uint16_t fullHeight = h * scale;
+
+    if (luma == nullptr) {
+        return blocks->sink(blocks->user, 0, 0, fullWidth, fullHeight, nullptr);
+    }
+
+    // A scaled MCU is at most 16 / scale pixels wide
+    uint8_t full[kMaxMcuSide * kMaxMcuSide];
+    if (fullWidth > kMaxMcuSide || fullHeight > kMaxMcuSide) {
+        PXLCAM_LOGE_TAG(kLogTag, "Scaled block too large: %ux%u x%u", w, h, scale);
+        return false;
+    }
+
+    for (uint16_t row = 0; row < h; ++row) {
+        uint8_t *dst = full + row * scale * fullWidth;
+        for (uint16_t col = 0; col < w; ++col) {
+            memset(dst + col * scale, luma[row * w + col], scale);
+        }
+        for (uint8_t copy = 1; copy < scale; ++copy) {
+            memcpy(dst + copy * fullWidth, dst, fullWidth);
+        }
+    }
+
+    return blocks->sink(blocks->user, x * scale, y * scale, fullWidth, fullHeight, full);
+}
+
 void apply(camera_fb_t *frame) {
     if (!g_initialized || !g_config.enabled) {
         return;
     }
 
+    if (frame != nullptr && frame->format == PIXFORMAT_GRAYSCALE) {
+        applyPixelFilterGray(frame->buf, frame->len, frame->width, frame->height, g_config.blockSize, g_config.brightnessOffset);
+        return;
+    }
+
     if (!isRgbFramebuffer(frame)) {
         PXLCAM_LOGW_TAG(kLogTag, "apply called with unsupported framebuffer format: %d", frame ? frame->format : -1);
         return;
@@ -0,0 +1,372 @@
+/**
+ * @file png_indexed_writer.cpp
+ * @brief Streaming indexed-color PNG writer (fixed-Huffman deflate)
+ */
+
+#include "png_indexed_writer.h"
+
+#include <cstring>
+
+namespace pxlcam::png {
+
+namespace {
+
+constexpr uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+constexpr size_t kMinMatch = 3;
+constexpr size_t kMaxMatch = 258;
+
+/// Bytes fed to the window between compress() calls
+constexpr size_t kFeedStep = 2048;
+
+static_assert(kFeedStep + kMaxMatch <= IndexedPngWriter::kWindowSize - IndexedPngWriter::kMaxDistance,
+              "Window must hold the match history plus one feed step");
+static_assert((IndexedPngWriter::kWindowSize & (IndexedPngWriter::kWindowSize - 1)) == 0 &&
+              (IndexedPngWriter::kHashSize & (IndexedPngWriter::kHashSize - 1)) == 0,
+              "Window and hash sizes must be powers of two");
+
+/// Deflate length codes 257-285: base length and extra bits
+constexpr uint16_t kLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+constexpr uint8_t kLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+
+/// Deflate distance codes 0-29: base distance and extra bits
+constexpr uint16_t kDistBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+constexpr uint8_t kDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+/// CRC-32 (PNG / zlib polynomial), one nibble per step
+constexpr uint32_t kCrcNibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t crcUpdate(uint32_t crc, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ kCrcNibble[crc & 0x0F];
+        crc = (crc >> 4) ^ kCrcNibble[crc & 0x0F];
+    }
+    return crc;
+}
+
+inline void wrBe32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+/// Length code index (0-28) for a match length
+inline int lengthCode(size_t length) {
+    int code = 28;
+    while (kLengthBase[code] > length) {
+        code--;
+    }
+    return code;
+}
+
+/// Distance code (0-29) for a match distance
+inline int distanceCode(size_t distance) {
+    int code = 29;
+    while (kDistBase[code] > distance) {
+        code--;
+    }
+    return code;
+}
+
+}  // namespace
+
+size_t IndexedPngWriter::maxSize(int width, int height, uint8_t bitDepth) {
+    const size_t raw = (rowBytes(width, bitDepth) + 1) * static_cast<size_t>(height);
+    // zlib header, 3-bit block header, 9-bit literals, 7-bit end code, Adler-32
+    const size_t zlib = 2 + (3 + 9 * raw + 7 + 7) / 8 + 4;
+    const size_t chunks = (zlib + kChunkSize - 1) / kChunkSize;
+    const size_t colors = static_cast<size_t>(1) << bitDepth;
+    return sizeof(kSignature) + (12 + 13) + (12 + 3 * colors) + zlib + 12 * chunks + 12;
+}
+
+bool IndexedPngWriter::begin(int width, int height, uint8_t bitDepth, const uint8_t* tones, int colors,
+                             Sink sink, void* user) {
+    if (!tones || colors < 1 || colors > 256) {
+        ok_ = false;
+        return false;
+    }
+
+    uint8_t plte[3 * 256];
+    for (int i = 0; i < colors; i++) {
+        plte[i * 3 + 0] = tones[i];
+        plte[i * 3 + 1] = tones[i];
+        plte[i * 3 + 2] = tones[i];
+    }
+    return beginRgb(width, height, bitDepth, plte, colors, sink, user);
+}
+
+bool IndexedPngWriter::beginRgb(int width, int height, uint8_t bitDepth, const uint8_t* rgb, int colors,
+                                Sink sink, void* user) {
+    ok_ = false;
+    if (width <= 0 || height <= 0 || !rgb || !sink ||
+        (bitDepth != 1 && bitDepth != 2 && bitDepth != 4 && bitDepth != 8) ||
+        colors < 1 || colors > (1 << bitDepth)) {
+        return false;
+    }
+
+    sink_ = sink;
+    user_ = user;
+    written_ = 0;
+    rowBytes_ = rowBytes(width, bitDepth);
+    rowsLeft_ = height;
+    adler_ = 1;
+    bitBuf_ = 0;
+    bitCount_ = 0;
+    chunkFill_ = 0;
+    inPos_ = 0;
+    encPos_ = 0;
+    memset(head_, 0, sizeof(head_));
+    ok_ = true;
+
+    uint8_t ihdr[13];
+    wrBe32(ihdr, static_cast<uint32_t>(width));
+    wrBe32(ihdr + 4, static_cast<uint32_t>(height));
+    ihdr[8] = bitDepth;
+    ihdr[9] = 3;        // Indexed color
+    ihdr[10] = 0;       // Deflate
+    ihdr[11] = 0;       // Adaptive filtering (type 0 on every row)
+    ihdr[12] = 0;       // No interlace
+
+    ok_ = emit(kSignature, sizeof(kSignature)) &&
+          emitChunk("IHDR", ihdr, sizeof(ihdr)) &&
+          emitChunk("PLTE", rgb, 3 * colors);
+
+    // zlib header (deflate, 32K window, fastest), then one final fixed-Huffman block
+    putBits(0x78, 8);
+    putBits(0x01, 8);
+    putBits(1, 1);      // BFINAL
+    putBits(1, 2);      // BTYPE = fixed Huffman
+    return ok_;
+}
+
+bool IndexedPngWriter::writeRow(const uint8_t* row) {
+    if (!ok_ || rowsLeft_ <= 0) {
+        return false;
+    }
+    rowsLeft_--;
+
+    static const uint8_t kFilterNone = 0;
+    feed(&kFilterNone, 1);
+    feed(row, rowBytes_);
+    return ok_;
+}
+
+bool IndexedPngWriter::finish() {
+    if (!ok_) {
+        return false;
+    }
+    if (rowsLeft_ != 0) {
+        ok_ = false;
+        return false;
+    }
+
+    compress(true);
+    putCode(0, 7);      // End of block (256)
+    if (bitCount_ > 0) {
+        putBits(0, 8 - bitCount_);
+    }
+    const uint32_t adler = adler_;
+    putBits(adler >> 24, 8);
+    putBits((adler >> 16) & 0xFF, 8);
+    putBits((adler >> 8) & 0xFF, 8);
+    putBits(adler & 0xFF, 8);
+
+    ok_ = ok_ && flushIdat() && emitChunk("IEND", nullptr, 0);
+    const bool done = ok_;
+    ok_ = false;
+    return done;
+}
+
+bool IndexedPngWriter::ditherSink(void* user, int y, const uint8_t* data, size_t bytes) {
+    IndexedPngWriter* writer = static_cast<IndexedPngWriter*>(user);
+    (void)y;
+    return bytes == writer->rowBytes_ && writer->writeRow(data);
+}
+
+bool IndexedPngWriter::emit(const uint8_t* data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    if (!sink_(user_, data, len)) {
+        return false;
+    }
+    written_ += len;
+    return true;
+}
+
+bool IndexedPngWriter::emitChunk(const char* type, const uint8_t* data, size_t len) {
+    uint8_t head[8];
+    uint8_t tail[4];
+    wrBe32(head, static_cast<uint32_t>(len));
+    memcpy(head + 4, type, 4);
+    const uint32_t crc = crcUpdate(crcUpdate(0xFFFFFFFFu, head + 4, 4), data, len) ^ 0xFFFFFFFFu;
+    wrBe32(tail, crc);
+    return emit(head, sizeof(head)) && emit(data, len) && emit(tail, sizeof(tail));
+}
+
+bool IndexedPngWriter::flushIdat() {
+    if (chunkFill_ == 0) {
+        return true;
+    }
+    const size_t fill = chunkFill_;
+    chunkFill_ = 0;
+    return emitChunk("IDAT", chunk_, fill);
+}
+
+void IndexedPngWriter::putBits(uint32_t value, uint8_t count) {
+    bitBuf_ |= value << bitCount_;
+    bitCount_ += count;
+    while (bitCount_ >= 8) {
+        chunk_[chunkFill_++] = static_cast<uint8_t>(bitBuf_);
+        bitBuf_ >>= 8;
+        bitCount_ -= 8;
+        if (chunkFill_ == kChunkSize) {
+            if (ok_) {
+                ok_ = flushIdat();
+            }
+            chunkFill_ = 0;     // After a failure the rest is dropped
+        }
+    }
+}
+
+/// Huffman codes are sent most significant bit first
+void IndexedPngWriter::putCode(uint16_t code, uint8_t count) {
+    uint32_t reversed = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    putBits(reversed, count);
+}
+
+void IndexedPngWriter::putLiteral(uint8_t value) {
+    if (value < 144) {
+        putCode(0x30 + value, 8);
+    } else {
+        putCode(0x190 + (value - 144), 9);
+    }
+}
+
+void IndexedPngWriter::putMatch(size_t length, size_t distance) {
+    const int lc = lengthCode(length);
+    const uint16_t symbol = static_cast<uint16_t>(257 + lc);
+    if (symbol < 280) {
+        putCode(symbol - 256, 7);
+    } else {
+        putCode(0xC0 + (symbol - 280), 8);
+    }
+    if (kLengthExtra[lc]) {
+        putBits(static_cast<uint32_t>(length - kLengthBase[lc]), kLengthExtra[lc]);
+    }
+
+    const int dc = distanceCode(distance);
+    putCode(static_cast<uint16_t>(dc), 5);
+    if (kDistExtra[dc]) {
+        putBits(static_cast<uint32_t>(distance - kDistBase[dc]), kDistExtra[dc]);
+    }
+}
+
+/// Append input to the window (Adler-32 on the way) and code what can be coded
+void IndexedPngWriter::feed(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        const size_t step = len < kFeedStep ? len : kFeedStep;
+        uint32_t a = adler_ & 0xFFFF;
+        uint32_t b = adler_ >> 16;
+        for (size_t i = 0; i < step; i++) {
+            window_[(inPos_ + i) & (kWindowSize - 1)] = data[i];
+            a += data[i];
+            if (a >= 65521) a -= 65521;
+            b += a;
+            if (b >= 65521) b -= 65521;
+        }
+        adler_ = (b << 16) | a;
+        inPos_ += step;
+        compress(false);
+        data += step;
+        len -= step;
+    }
+}
+
+uint32_t IndexedPngWriter::hashAt(size_t pos) const {
+    const size_t mask = kWindowSize - 1;
+    return ((window_[pos & mask] << 6) ^ (window_[(pos + 1) & mask] << 3) ^ window_[(pos + 2) & mask]) &
+           (kHashSize - 1);
+}
+
+size_t IndexedPngWriter::matchLength(size_t candidate, size_t pos, size_t limit) const {
+    size_t n = 0;
+    while (n < limit &&
+           window_[(candidate + n) & (kWindowSize - 1)] == window_[(pos + n) & (kWindowSize - 1)]) {
+        n++;
+    }
+    return n;
+}
+
+/// Greedy LZ77 over the window; keeps kMaxMatch bytes of lookahead unless final
+void IndexedPngWriter::compress(bool final) {
+    const size_t line = rowBytes_ + 1;
+    const size_t mask = kWindowSize - 1;
+
+    while (encPos_ < inPos_ && (final || inPos_ - encPos_ >= kMaxMatch)) {
+        const size_t pos = encPos_;
+        const size_t avail = inPos_ - pos;
+        const size_t limit = avail < kMaxMatch ? avail : kMaxMatch;
+
+        size_t bestLen = 0;
+        size_t bestDist = 0;
+        if (limit >= kMinMatch) {
+            const uint32_t hash = hashAt(pos);
+
+            // Hash chain head, then one row and one Bayer period (8 rows) up
+            const size_t candidates[3] = {
+                head_[hash] ? head_[hash] - 1 : pos,
+                pos >= line ? pos - line : pos,
+                pos >= 8 * line ? pos - 8 * line : pos,
+            };
+            for (size_t c = 0; c < 3; c++) {
+                const size_t cand = candidates[c];
+                if (cand >= pos || pos - cand > kMaxDistance) {
+                    continue;
+                }
+                const size_t len = matchLength(cand, pos, limit);
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestDist = pos - cand;
+                }
+            }
+        }
+
+        const size_t advance = bestLen >= kMinMatch ? bestLen : 1;
+        if (bestLen >= kMinMatch) {
+            putMatch(bestLen, bestDist);
+        } else {
+            putLiteral(window_[pos & mask]);
+        }
+
+        // Every position with a full prefix becomes the newest for its hash
+        for (size_t i = 0; i < advance; i++) {
+            const size_t p = pos + i;
+            if (p + kMinMatch > inPos_) break;
+            head_[hashAt(p)] = static_cast<uint32_t>(p + 1);
+        }
+        encPos_ += advance;
+    }
+}
+
+}  // namespace pxlcam::png
@@ -1,28 +1,37 @@
 #include "preview.h"
 
 #include <esp_camera.h>
-#include <img_converters.h>
 #include <esp_heap_caps.h>
+#include <atomic>
 #include <cstring>
 
+#include "button_irq.h"
+#include "camera_config.h"
+#include "camera_service.h"
 #include "display.h"
+#include "exposure_ctrl.h"
+#include "frame_arena.h"
+#include "jpeg_luma.h"
 #include "logging.h"
 #include "pxlcam_config.h"
+#include "trace.h"
 
 #if PXLCAM_DOUBLE_BUFFER_PREVIEW
 #include "preview_buffer.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 #endif
 
-#if PXLCAM_GAMEBOY_DITHER
+#if PXLCAM_GAMEBOY_DITHER || PXLCAM_ENABLE_HISTEQ
 #include "preview_dither.h"
 #endif
 
-#if PXLCAM_ENABLE_NIGHT
-#include "exposure_ctrl.h"
-#endif
-
 #include "fps_counter.h"
+#include "frame_pacer.h"
+#include "motion_detect.h"
 #include "display_ui.h"
+#include "filters/resample.h"
 #include <cstdio>
 
 namespace pxlcam::preview {
@@ -31,18 +40,50 @@ namespace {
 
 constexpr int kPreviewW = 64;
 constexpr int kPreviewH = 64;
-constexpr int kFrameDelayMs = 50;  // ~20 FPS target (was 80ms / ~12 FPS in v1.0)
+#if PXLCAM_PREVIEW_MAX_FPS
+constexpr uint16_t kTargetFps = 0;  // Unpaced
+#else
+constexpr uint16_t kTargetFps = PXLCAM_TARGET_FPS;  // 20 FPS (was ~12 FPS in v1.0)
+#endif
+constexpr uint32_t kMaxFrameWaitMs = 100;  // Unpaced: longest wait for a camera frame
+constexpr uint32_t kIdleFrameMs = PXLCAM_PREVIEW_IDLE_MS;  // Capture interval while static
 constexpr int kButtonPin = 12;
-constexpr size_t kMaxRgbSize = 320 * 240 * 3;  // QVGA RGB888
+constexpr int kMaxSrcW = 320;  // QVGA
+constexpr int kMaxSrcH = 240;
 
 // 64×64 grayscale buffer (1 byte per pixel) - used as fallback when double buffer disabled
 static uint8_t s_img64[kPreviewW * kPreviewH];
 
-// RGB buffer in PSRAM if available
-static uint8_t* s_rgbBuf = nullptr;
+// One band of decoded JPEG MCU rows: a frame arena lease for each preview
+// session, or a heap buffer kept once the arena had no room
+constexpr int kMcuBandRows = 16;
+static pxlcam::arena::Lease<uint8_t> s_mcuBandLease;
+static uint8_t* s_mcuBandHeap = nullptr;
+static uint8_t* s_mcuBand = nullptr;
+
+// Downscaler for the camera side; JPEG decode writes through s_decodeOut
+static pxlcam::filters::AreaResampler s_resampler;
+static uint8_t* s_decodeOut = nullptr;
+
+// Preview frames come from the camera service, shared with a WiFi stream
+static pxlcam::frames::ConsumerId s_frameConsumer = pxlcam::frames::kNoConsumer;
+
+#if PXLCAM_PREVIEW_MOTION_SKIP
+// Scene-change gate: unchanged frames skip dither, blit and the OLED flush.
+// Runs on whichever task captures; others request a reset through the flag
+static pxlcam::motion::ChangeDetector s_motion;
+static std::atomic<bool> s_motionResetPending{true};
+static std::atomic<bool> s_sceneStatic{false};
+#endif
+
+#if PXLCAM_ENABLE_HISTEQ
+// Histogram of each downscaled frame and the equalizer it feeds
+static uint32_t s_hist[256];
+static pxlcam::dither::TemporalEqualizer s_equalizer;
+#endif
 
-// 1-bit packed bitmap for dithered output
-static uint8_t s_bitmap1bit[(kPreviewW * kPreviewH + 7) / 8];
+// 1-bit dithered output in SSD1306 page layout
+static uint8_t s_bitmap1bit[kPreviewW * ((kPreviewH + 7) / 8)];
 
 // FPS counter instance
 static pxlcam::util::FPSCounter s_fpsCounter;
@@ -54,48 +95,90 @@ static pxlcam::dither::DitherMode s_ditherMode = pxlcam::dither::DitherMode::Gam
 static int s_ditherMode = 0;
 #endif
 
+// Dither time of the last presented frame
+static uint32_t s_lastDitherUs = 0;
+
+#if PXLCAM_GAMEBOY_DITHER && PXLCAM_PREVIEW_GOVERNOR
+// Auto mode: dither level chosen against the frame budget
+static pxlcam::dither::QualityGovernor s_governor;
+#endif
+
 
 // ---------------------------------------------------------------------------
-// Downscale RGB888 → 64×64 grayscale
+// Downscale any camera frame → 64×64 grayscale
+// Area resample: non-multiple-of-64 sizes keep their edge rows and columns
 // ---------------------------------------------------------------------------
-void downscaleTo64x64(const uint8_t* rgb, int w, int h, uint8_t* outGray) {
-    const int blockW = w / kPreviewW;
-    const int blockH = h / kPreviewH;
-
-    if (blockW == 0 || blockH == 0) {
-        PXLCAM_LOGE("[PREVIEW] Invalid block size (src=%dx%d)", w, h);
-        return;
+bool downscaleTo64x64(const uint8_t* src, pxlcam::filters::ResampleFormat format,
+                      int w, int h, uint8_t* outGray) {
+    const size_t stride = static_cast<size_t>(w) * pxlcam::filters::resample_bytes_per_pixel(format);
+    if (!s_resampler.begin(w, h, format, outGray, kPreviewW, kPreviewH, kPreviewW)) {
+        PXLCAM_LOGE("[PREVIEW] Invalid resample size (src=%dx%d)", w, h);
+        return false;
     }
 
-    int idx = 0;
-
-    for (int gy = 0; gy < kPreviewH; gy++) {
-        for (int gx = 0; gx < kPreviewW; gx++) {
+    for (int y = 0; y < h; y++) {
+        s_resampler.push_row(src + y * stride);
+    }
+    return true;
+}
 
-            uint32_t sum = 0;
-            int count = 0;
 
-            for (int by = 0; by < blockH; by++) {
-                int y = gy * blockH + by;
-                if (y >= h) break;
+// ---------------------------------------------------------------------------
+// Decode JPEG → 64×64 grayscale
+// MCUs arrive left to right in bands of up to 16 rows; each finished band is
+// fed to the resampler row by row
+// ---------------------------------------------------------------------------
+bool bandLumaBlock(void* user, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* luma) {
+    uint8_t* band = static_cast<uint8_t*>(user);
+
+    if (!luma) {
+        if (w > kMaxSrcW || h > kMaxSrcH) return false;
+        if (!s_resampler.begin(w, h, pxlcam::filters::ResampleFormat::GRAY,
+                               s_decodeOut, kPreviewW, kPreviewH, kPreviewW)) {
+            PXLCAM_LOGE("[PREVIEW] Invalid resample size (src=%dx%d)", w, h);
+            return false;
+        }
+        return true;
+    }
 
-                for (int bx = 0; bx < blockW; bx++) {
-                    int x = gx * blockW + bx;
-                    if (x >= w) break;
+    const int bandW = s_resampler.src_width();
+    if (h > kMcuBandRows || x + w > bandW) return false;
 
-                    const uint8_t* p = rgb + (y * w + x) * 3;
+    for (uint16_t row = 0; row < h; row++) {
+        memcpy(band + row * bandW + x, luma + row * w, w);
+    }
 
-                    // grayscale = 0.299R + 0.587G + 0.114B
-                    uint8_t gray = (77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8;
+    // Last MCU of the band: its rows are complete across the full width
+    if (x + w == bandW) {
+        for (uint16_t row = 0; row < h && y + row < s_resampler.src_height(); row++) {
+            s_resampler.push_luma_row(band + row * bandW);
+        }
+    }
+    return true;
+}
 
-                    sum += gray;
-                    count++;
-                }
-            }
+// Largest decoder downscale that still leaves at least one source pixel per
+// preview pixel; 320x240 decodes at 1/2, so IDCT and color work drop by 3/4
+jpg_scale_t previewJpegScale(int w, int h) {
+#if PXLCAM_PREVIEW_SOURCE == PXLCAM_PREVIEW_SOURCE_FULL
+    (void)w;
+    (void)h;
+    return JPG_SCALE_NONE;
+#else
+    int shift = JPG_SCALE_8X;
+    while (shift > JPG_SCALE_NONE && ((w >> shift) < kPreviewW || (h >> shift) < kPreviewH)) {
+        shift--;
+    }
+    return static_cast<jpg_scale_t>(shift);
+#endif
+}
 
-            outGray[idx++] = (count > 0 ? sum / count : 0);
-        }
+bool decodeJpegTo64x64(const uint8_t* jpg, size_t len, int w, int h, uint8_t* outGray) {
+    s_decodeOut = outGray;
+    if (!pxlcam::jpeg::decodeLumaBlocks(jpg, len, bandLumaBlock, s_mcuBand, previewJpegScale(w, h))) {
+        return false;
     }
+    return s_resampler.done();
 }
 
 
@@ -103,6 +186,10 @@ void downscaleTo64x64(const uint8_t* rgb, int w, int h, uint8_t* outGray) {
 // Button helpers
 // ---------------------------------------------------------------------------
 bool isButtonPressed() {
+    // The interrupt driver's debounced level when it runs (app_controller.h)
+    if (pxlcam::input::isActive()) {
+        return pxlcam::input::isPressed();
+    }
     return digitalRead(kButtonPin) == LOW;
 }
 
@@ -115,139 +202,324 @@ bool waitForButtonRelease(uint32_t timeoutMs) {
     return true;
 }
 
-}  // namespace
-
-
-
 // ---------------------------------------------------------------------------
-// PREVIEW BEGIN
+// Session buffers: frame arena leases of the Preview phase, heap fallback
 // ---------------------------------------------------------------------------
-void begin() {
-    pinMode(kButtonPin, INPUT_PULLUP);
-
-    PXLCAM_LOGI("[PREVIEW] begin()");
-
-    // Try PSRAM first
-    if (psramFound()) {
-        s_rgbBuf = (uint8_t*)heap_caps_malloc(kMaxRgbSize, MALLOC_CAP_SPIRAM);
-        if (s_rgbBuf) {
-            PXLCAM_LOGI("[PREVIEW] Alloc RGB buffer in PSRAM (%d bytes)", kMaxRgbSize);
+bool acquireMcuBand() {
+    const size_t bandBytes = kMaxSrcW * kMcuBandRows;
+
+    if (s_mcuBandHeap) {
+        s_mcuBand = s_mcuBandHeap;
+    } else if (s_mcuBandLease.get() ||
+               s_mcuBandLease.acquire(pxlcam::arena::Phase::Preview, bandBytes, "PreviewBand")) {
+        s_mcuBand = s_mcuBandLease.get();
+    } else {
+        // Try PSRAM first
+        if (psramFound()) {
+            s_mcuBandHeap = (uint8_t*)heap_caps_malloc(bandBytes, MALLOC_CAP_SPIRAM);
+            if (s_mcuBandHeap) {
+                PXLCAM_LOGI("[PREVIEW] Alloc MCU band in PSRAM (%d bytes)", bandBytes);
+            }
         }
-    }
 
-    // fallback
-    if (!s_rgbBuf) {
-        s_rgbBuf = (uint8_t*)malloc(kMaxRgbSize);
-        if (s_rgbBuf) {
-            PXLCAM_LOGW("[PREVIEW] Alloc RGB buffer in DRAM (%d bytes)", kMaxRgbSize);
+        // fallback
+        if (!s_mcuBandHeap) {
+            s_mcuBandHeap = (uint8_t*)malloc(bandBytes);
+            if (s_mcuBandHeap) {
+                PXLCAM_LOGW("[PREVIEW] Alloc MCU band in DRAM (%d bytes)", bandBytes);
+            }
         }
+        s_mcuBand = s_mcuBandHeap;
     }
 
-    if (!s_rgbBuf) {
-        PXLCAM_LOGE("[PREVIEW] FAILED to allocate RGB buffer!");
+    if (!s_mcuBand) {
+        PXLCAM_LOGE("[PREVIEW] FAILED to allocate MCU band!");
     }
-
-#if PXLCAM_DOUBLE_BUFFER_PREVIEW
-    // Initialize double buffer system
-    if (!initBuffers()) {
-        PXLCAM_LOGE("[PREVIEW] Double buffer init failed");
-    } else {
-        PXLCAM_LOGI("[PREVIEW] Double buffer initialized");
-    }
-#endif
-
-#if PXLCAM_GAMEBOY_DITHER
-    // Initialize dithering module
-    pxlcam::dither::initDitherModule(true);
-    PXLCAM_LOGI("[PREVIEW] Dither module initialized");
-#endif
-
-    // Initialize FPS counter
-    s_fpsCounter.reset();
-    
-    // Initialize UI
-    pxlcam::display::initUI();
-
-    PXLCAM_LOGI("[PREVIEW] Module initialized OK");
+    return s_mcuBand != nullptr;
 }
 
-
-
 // ---------------------------------------------------------------------------
-// CAPTURE + PROCESS ONE FRAME
+// Frame stages: camera side (grab + downscale) and display side (dither + draw)
 // ---------------------------------------------------------------------------
-bool frame() {
-    if (!s_rgbBuf) {
+bool captureGray(uint8_t* grayBuf) {
+    if (!s_mcuBand) {
         return false;
     }
 
-    camera_fb_t* fb = esp_camera_fb_get();
+    uint32_t stageStart = micros();
+    // Mode switches staged by the button handler land between frames (the
+    // service applies them)
+    camera_fb_t* fb = pxlcam::frames::acquire(s_frameConsumer);
     if (!fb) {
         return false;
     }
+    s_fpsCounter.recordStage(pxlcam::util::FrameStage::Grab, micros() - stageStart);
 
     int srcW = fb->width;
     int srcH = fb->height;
 
-    size_t needed = srcW * srcH * 3;
-    if (needed > kMaxRgbSize) {
-        esp_camera_fb_return(fb);
+    if (srcW > kMaxSrcW || srcH > kMaxSrcH) {
+        pxlcam::frames::release(fb);
         return false;
     }
 
     bool converted = false;
+    pxlcam::util::FrameStage convertStage = pxlcam::util::FrameStage::Downscale;
+    stageStart = micros();
 
-    // Convert JPEG → RGB888
+    // Decode/downscale straight to 64x64 grayscale (no RGB888 copy)
     if (fb->format == PIXFORMAT_JPEG) {
-        converted = fmt2rgb888(fb->buf, fb->len, fb->format, s_rgbBuf);
-    } else if (fb->format == PIXFORMAT_RGB888) {
-        memcpy(s_rgbBuf, fb->buf, fb->len);
-        converted = true;
+        converted = decodeJpegTo64x64(fb->buf, fb->len, srcW, srcH, grayBuf);
+        convertStage = pxlcam::util::FrameStage::Decode;
+    } else {
+        using pxlcam::filters::ResampleFormat;
+        ResampleFormat format = ResampleFormat::COUNT;
+        if (fb->format == PIXFORMAT_RGB888) {
+            format = ResampleFormat::RGB888;
+        } else if (fb->format == PIXFORMAT_RGB565) {
+            format = ResampleFormat::RGB565;
+        } else if (fb->format == PIXFORMAT_GRAYSCALE) {
+            format = ResampleFormat::GRAY;
+        } else if (fb->format == PIXFORMAT_YUV422) {
+            format = ResampleFormat::YUV422;
+        }
+
+        const size_t frameBytes = static_cast<size_t>(srcW) * srcH *
+                                  pxlcam::filters::resample_bytes_per_pixel(format);
+        if (format != ResampleFormat::COUNT && fb->len >= frameBytes) {
+            converted = downscaleTo64x64(fb->buf, format, srcW, srcH, grayBuf);
+        }
     }
 
-    esp_camera_fb_return(fb);
+    pxlcam::frames::release(fb);
 
     if (!converted) {
         return false;
     }
 
-#if PXLCAM_DOUBLE_BUFFER_PREVIEW
-    // Get write buffer from double buffer system
-    uint8_t* grayBuf = g_previewBuffer.getWriteBuffer();
-    if (!grayBuf) {
-        grayBuf = s_img64;  // Fallback
+#if PXLCAM_ENABLE_HISTEQ
+    // Equalize with the histogram the downscale just gathered; the LUT is
+    // smoothed across frames so the preview doesn't flicker
+    s_equalizer.update(s_hist, kPreviewW * kPreviewH);
+    s_equalizer.apply(grayBuf, kPreviewW * kPreviewH);
+#endif
+
+    s_fpsCounter.recordStage(convertStage, micros() - stageStart);
+    return true;
+}
+
+// True if the frame differs enough from the last one shown to redraw
+bool sceneChanged(const uint8_t* grayBuf) {
+#if PXLCAM_PREVIEW_MOTION_SKIP
+    if (s_motionResetPending.exchange(false)) {
+        s_motion.reset();
     }
+    const bool changed = s_motion.update(grayBuf);
+    s_sceneStatic = !changed;
+    return changed;
 #else
-    uint8_t* grayBuf = s_img64;
+    (void)grayBuf;
+    return true;
 #endif
+}
 
-    // Downscale to 64x64 grayscale
-    downscaleTo64x64(s_rgbBuf, srcW, srcH, grayBuf);
+// True while the capture side is dropping frames as unchanged
+bool sceneStatic() {
+#if PXLCAM_PREVIEW_MOTION_SKIP
+    return s_sceneStatic;
+#else
+    return false;
+#endif
+}
 
-#if PXLCAM_ENABLE_HISTEQ
-    // Apply histogram equalization for better contrast
-    pxlcam::dither::histogramEqualize(grayBuf, kPreviewW, kPreviewH);
+// Force the next captured frame to be shown (mode change, new session)
+void requestRedraw() {
+#if PXLCAM_PREVIEW_MOTION_SKIP
+    s_sceneStatic = false;
+    s_motionResetPending = true;
 #endif
+}
 
+void presentGray(const uint8_t* grayBuf) {
+    PXLCAM_TRACE_SCOPE(PreviewFrame, 0);
 #if PXLCAM_GAMEBOY_DITHER
-    // Apply current dithering mode
-    pxlcam::dither::processDither(grayBuf, kPreviewW, kPreviewH, s_bitmap1bit, false);
-    
-    // Draw 1-bit preview via UI module
-    pxlcam::display::drawPreviewBitmap(s_bitmap1bit, kPreviewW, kPreviewH);
+    // Dither straight into the SSD1306 page layout and blit it
+    const uint32_t ditherStart = micros();
+#if PXLCAM_GAMEBOY_DITHER && PXLCAM_PREVIEW_GOVERNOR
+    if (s_ditherMode == pxlcam::dither::DitherMode::Threshold) {
+        // Auto: best algorithm the frame budget allows
+        pxlcam::dither::ditherAtLevel(grayBuf, kPreviewW, kPreviewH, s_bitmap1bit,
+                                      s_governor.current(), pxlcam::dither::BitmapLayout::Pages);
+    } else
+#endif
+    {
+        pxlcam::dither::processDither(grayBuf, kPreviewW, kPreviewH, s_bitmap1bit, false,
+                                      pxlcam::dither::BitmapLayout::Pages);
+    }
+    s_lastDitherUs = micros() - ditherStart;
+    s_fpsCounter.recordStage(pxlcam::util::FrameStage::Dither, s_lastDitherUs);
+    {
+        pxlcam::util::StageTimer timer(s_fpsCounter, pxlcam::util::FrameStage::Blit);
+        pxlcam::display::drawPreviewPages(s_bitmap1bit, kPreviewW, kPreviewH);
+    }
 #else
     // Direct grayscale display (v1.0 style)
-    pxlcam::display::drawGrayscale64x64(grayBuf);
+    {
+        pxlcam::util::StageTimer timer(s_fpsCounter, pxlcam::util::FrameStage::Blit);
+        pxlcam::display::drawGrayscale64x64(grayBuf);
+    }
+#endif
+
+    // Update FPS counter
+    s_fpsCounter.tick();
+}
+
+
+#if PXLCAM_DOUBLE_BUFFER_PREVIEW
+// ---------------------------------------------------------------------------
+// Camera task: fills g_previewBuffer while the preview loop draws the other half
+// Created once and parked between preview sessions (no frame buffer held)
+// ---------------------------------------------------------------------------
+TaskHandle_t s_cameraTask = nullptr;
+TaskHandle_t s_displayTask = nullptr;
+SemaphoreHandle_t s_cameraParked = nullptr;
+volatile bool s_cameraArmed = false;
+
+void cameraTask(void*) {
+    bool running = false;
+    for (;;) {
+        if (!s_cameraArmed) {
+            if (running) {
+                running = false;
+                xSemaphoreGive(s_cameraParked);
+            }
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            // Only armCamera() wakes us; its disarmCamera() must get the
+            // park back even if it came before we saw the camera armed
+            running = true;
+            continue;
+        }
+
+        uint8_t* writeBuf = g_previewBuffer.getWriteBuffer();
+        if (captureGray(writeBuf)) {
+            if (sceneChanged(writeBuf)) {
+                g_previewBuffer.commitWrite();
+                xTaskNotifyGive(s_displayTask);
+            } else {
+                // Static scene: keep the slot, and look again less often
+                vTaskDelay(pdMS_TO_TICKS(kIdleFrameMs));
+            }
+        } else {
+            // No frame or undecodable: don't spin on a failing camera
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+}
+
+bool startCameraTask() {
+    s_cameraParked = xSemaphoreCreateBinary();
+    if (!s_cameraParked) {
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(cameraTask, "preview_cam", PXLCAM_PREVIEW_TASK_STACK,
+                                nullptr, PXLCAM_PREVIEW_TASK_PRIORITY, &s_cameraTask,
+                                PXLCAM_PREVIEW_CAMERA_CORE) != pdPASS) {
+        s_cameraTask = nullptr;
+        vSemaphoreDelete(s_cameraParked);
+        s_cameraParked = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// Start filling buffers; frames are signalled to the calling task
+void armCamera() {
+    s_displayTask = xTaskGetCurrentTaskHandle();
+    g_previewBuffer.resetStats();
+    s_cameraArmed = true;
+    xTaskNotifyGive(s_cameraTask);
+}
+
+// Stop and wait until the camera task has returned its last frame buffer
+void disarmCamera() {
+    s_cameraArmed = false;
+    xSemaphoreTake(s_cameraParked, portMAX_DELAY);
+    ulTaskNotifyTake(pdTRUE, 0);  // Drop a frame signal still pending for us
+    if (uint8_t* stale = g_previewBuffer.getReadBuffer()) {
+        (void)stale;
+        g_previewBuffer.releaseRead();
+    }
+    PXLCAM_LOGI("[PREVIEW] Pipeline: %u frames, %u dropped",
+                g_previewBuffer.getCommittedFrames(), g_previewBuffer.getDroppedFrames());
+}
+#endif
+
+
+}  // namespace
+
+
+
+// ---------------------------------------------------------------------------
+// PREVIEW BEGIN
+// ---------------------------------------------------------------------------
+void begin() {
+    if (!pxlcam::input::isActive()) {
+        pinMode(kButtonPin, INPUT_PULLUP);  // Otherwise ButtonManager set it up
+    }
+
+    PXLCAM_LOGI("[PREVIEW] begin()");
+
+    if (s_frameConsumer == pxlcam::frames::kNoConsumer) {
+        s_frameConsumer = pxlcam::frames::registerConsumer("preview", pxlcam::frames::Need::Latest);
+    }
+
+#if PXLCAM_ENABLE_HISTEQ
+    s_resampler.set_histogram(s_hist);
+#endif
+
+#if PXLCAM_PREVIEW_MOTION_SKIP
+    pxlcam::motion::ChangeDetector::Config motionConfig;
+    motionConfig.blockThreshold = PXLCAM_MOTION_BLOCK_SAD;
+    motionConfig.minBlocks = PXLCAM_MOTION_MIN_BLOCKS;
+    s_motion.begin(kPreviewW, kPreviewH, motionConfig);
 #endif
 
 #if PXLCAM_DOUBLE_BUFFER_PREVIEW
-    // Commit write buffer (swap)
-    g_previewBuffer.commitWrite();
+    // Camera task that fills the double buffer; the buffers themselves are
+    // taken for each preview session (acquireSessionBuffers())
+    if (!startCameraTask()) {
+        PXLCAM_LOGE("[PREVIEW] Camera task failed, preview runs single-threaded");
+    } else {
+        PXLCAM_LOGI("[PREVIEW] Camera task on core%d", PXLCAM_PREVIEW_CAMERA_CORE);
+    }
 #endif
 
-    // Update FPS counter
-    s_fpsCounter.tick();
+#if PXLCAM_GAMEBOY_DITHER
+    // Initialize dithering module
+    pxlcam::dither::initDitherModule(true);
+    PXLCAM_LOGI("[PREVIEW] Dither module initialized");
+#endif
+
+    // Initialize FPS counter
+    s_fpsCounter.reset();
+    s_fpsCounter.setStallThresholdUs(PXLCAM_PREVIEW_STALL_MS * 1000u);
+    
+    // Initialize UI
+    pxlcam::display::initUI();
 
+    PXLCAM_LOGI("[PREVIEW] Module initialized OK");
+}
+
+
+
+// ---------------------------------------------------------------------------
+// CAPTURE + PROCESS ONE FRAME
+// ---------------------------------------------------------------------------
+bool frame() {
+    if (!acquireMcuBand() || !captureGray(s_img64)) {
+        return false;
+    }
+    presentGray(s_img64);
     return true;
 }
 
@@ -275,6 +547,47 @@ void runPreviewLoop() {
     uint32_t buttonDownMs = 0;
     bool modeChanged = false;
 
+    // Staged first: the frames flushed by the mode switch apply it
+    pxlcam::exposure::applyProfile(pxlcam::sensor::Profile::Preview);
+#if PXLCAM_PREVIEW_SOURCE == PXLCAM_PREVIEW_SOURCE_SENSOR
+    // Small sensor frames while previewing; the stale ones are flushed here,
+    // before the camera task starts
+    if (!pxlcam::setCameraMode(pxlcam::CameraMode::Preview)) {
+        PXLCAM_LOGW("[PREVIEW] Preview camera mode failed, decoding capture size");
+    }
+#endif
+
+#if PXLCAM_ENABLE_HISTEQ
+    // New session, new scene: start from the first frame's curve
+    s_equalizer.reset();
+#endif
+
+    requestRedraw();
+
+    // Session buffers share the frame arena with the capture step
+    pxlcam::arena::enterPhase(pxlcam::arena::Phase::Preview);
+    acquireMcuBand();
+
+#if PXLCAM_DOUBLE_BUFFER_PREVIEW
+    // Camera latency and display time overlap: the camera task grabs the next
+    // frame while this loop dithers and blits the last one
+    const bool pipelined = s_cameraTask != nullptr && initBuffers();
+    if (pipelined) {
+        armCamera();
+    }
+#endif
+
+    // Sleeps only the slack left in each frame period
+    pxlcam::util::FramePacer pacer;
+    pacer.begin(kTargetFps);
+
+#if PXLCAM_GAMEBOY_DITHER && PXLCAM_PREVIEW_GOVERNOR
+    // Auto mode keeps each frame's work inside one PXLCAM_TARGET_FPS period
+    pxlcam::dither::QualityGovernor::Config governorConfig;
+    governorConfig.budgetUs = 1000000u / PXLCAM_TARGET_FPS;
+    s_governor.begin(governorConfig);
+#endif
+
     while (true) {
 
         // Button handling: short press = exit, long hold (2s) = cycle mode
@@ -290,9 +603,14 @@ void runPreviewLoop() {
                 modeChanged = true;
                 
 #if PXLCAM_GAMEBOY_DITHER
-                // Cycle: GameBoy -> Night -> Auto -> GameBoy
+                // Cycle: GameBoy -> Blue noise -> Night -> Auto -> GameBoy
                 switch (s_ditherMode) {
                     case pxlcam::dither::DitherMode::GameBoy:
+                        s_ditherMode = pxlcam::dither::DitherMode::BlueNoise;
+                        uiMode = pxlcam::display::PreviewMode::BlueNoise;
+                        PXLCAM_LOGI("[PREVIEW] Mode: Blue noise");
+                        break;
+                    case pxlcam::dither::DitherMode::BlueNoise:
                         s_ditherMode = pxlcam::dither::DitherMode::Night;
                         uiMode = pxlcam::display::PreviewMode::Night;
 #if PXLCAM_ENABLE_NIGHT
@@ -304,7 +622,7 @@ void runPreviewLoop() {
                         s_ditherMode = pxlcam::dither::DitherMode::Threshold;
                         uiMode = pxlcam::display::PreviewMode::Auto;
 #if PXLCAM_ENABLE_NIGHT
-                        pxlcam::exposure::applyStandardMode();
+                        pxlcam::exposure::applyProfile(pxlcam::sensor::Profile::Preview);
 #endif
                         PXLCAM_LOGI("[PREVIEW] Mode: Auto");
                         break;
@@ -316,6 +634,7 @@ void runPreviewLoop() {
                 }
                 pxlcam::dither::setDitherMode(s_ditherMode);
 #endif
+                requestRedraw();
                 
                 // Visual feedback for mode change
                 pxlcam::display::clearDisplay();
@@ -333,28 +652,127 @@ void runPreviewLoop() {
                 // Short press (< 500ms) = exit preview
                 if (holdTime < 500 && !modeChanged) {
                     PXLCAM_LOGI("[PREVIEW] Exit preview (short press)");
-                    return;
+                    break;
                 }
             }
             buttonDownMs = 0;
             modeChanged = false;
         }
 
-        // Capture and process frame
-        frame();
+        bool presented = false;
+        uint32_t workStart = micros();
+
+#if PXLCAM_DOUBLE_BUFFER_PREVIEW
+        if (pipelined) {
+            // Newest frame from the camera task, waiting no later than this
+            // frame's deadline (a static scene sends none, so wait longer)
+            TickType_t wait = pacer.isUnpaced() ? pdMS_TO_TICKS(kMaxFrameWaitMs)
+                                                : pacer.ticksToDeadline();
+            if (sceneStatic()) {
+                wait = pdMS_TO_TICKS(kIdleFrameMs);
+            }
+            ulTaskNotifyTake(pdTRUE, wait);
+            workStart = micros();
+            if (const uint8_t* grayBuf = g_previewBuffer.getReadBuffer()) {
+                presentGray(grayBuf);
+                g_previewBuffer.releaseRead();
+                presented = true;
+            }
+        } else
+#endif
+        {
+            // Capture and process frame
+            if (captureGray(s_img64) && sceneChanged(s_img64)) {
+                presentGray(s_img64);
+                presented = true;
+            }
+        }
+
+        if (!presented && sceneStatic()) {
+#if PXLCAM_DOUBLE_BUFFER_PREVIEW
+            if (!pipelined)
+#endif
+            {
+                delay(kIdleFrameMs);
+            }
+            // Nothing new on screen: skip overlay and flush, and don't let the
+            // idle gap count as a slow frame
+            s_fpsCounter.pause();
+            pacer.resync();
+            continue;
+        }
 
 #if PXLCAM_UI_OVERLAY
         // Draw complete UI overlay
         int fps = s_fpsCounter.getFPS();
-        pxlcam::display::drawStatusBar(fps, true, 100, uiMode);
+        const char* quality = nullptr;
+#if PXLCAM_GAMEBOY_DITHER && PXLCAM_PREVIEW_GOVERNOR
+        if (s_ditherMode == pxlcam::dither::DitherMode::Threshold) {
+            quality = pxlcam::dither::getQualityTag(s_governor.current());
+        }
+#endif
+        pxlcam::display::drawStatusBar(fps, true, 100, uiMode, quality);
         pxlcam::display::drawHintBar("Hold 2s: mode | Tap: exit");
 #endif
 
         // Swap display buffer
-        pxlcam::display::swapDisplayBuffers();
+        {
+            pxlcam::util::StageTimer timer(s_fpsCounter, pxlcam::util::FrameStage::I2C);
+            pxlcam::display::swapDisplayBuffers();
+        }
+
+#if PXLCAM_GAMEBOY_DITHER && PXLCAM_PREVIEW_GOVERNOR
+        if (presented && s_ditherMode == pxlcam::dither::DitherMode::Threshold &&
+            s_governor.update(s_lastDitherUs, micros() - workStart)) {
+            PXLCAM_LOGI("[PREVIEW] Auto dither -> %s",
+                        pxlcam::dither::getQualityTag(s_governor.current()));
+        }
+#else
+        (void)workStart;
+#endif
+
+        pacer.endFrame();
+    }
+
+    PXLCAM_LOGI("[PREVIEW] Pacing: %u frames, %u missed deadlines (target %u FPS)",
+                static_cast<unsigned>(pacer.getFrames()),
+                static_cast<unsigned>(pacer.getMissedDeadlines()),
+                static_cast<unsigned>(kTargetFps));
+    s_fpsCounter.logSummary("PREVIEW");
 
-        delay(kFrameDelayMs);
+#if PXLCAM_DOUBLE_BUFFER_PREVIEW
+    if (pipelined) {
+        disarmCamera();
     }
+#endif
+
+    // Capture settings before the frame size goes back, so the frames that
+    // follow the switch already have them (a Night preview included)
+    pxlcam::exposure::applyProfile(pxlcam::sensor::Profile::Capture);
+    pxlcam::sensor::apply();
+
+#if PXLCAM_PREVIEW_SOURCE == PXLCAM_PREVIEW_SOURCE_SENSOR
+    if (!pxlcam::setCameraMode(pxlcam::CameraMode::Capture)) {
+        PXLCAM_LOGE("[PREVIEW] Failed to restore the capture camera mode");
+    }
+#endif
+
+    // Camera task is parked: hand the session buffers back
+    s_mcuBand = nullptr;
+    pxlcam::arena::enterPhase(pxlcam::arena::Phase::None);
+    pxlcam::arena::logStats();
+}
+
+const pxlcam::util::FPSCounter& getFrameTelemetry() {
+    return s_fpsCounter;
+}
+
+uint32_t getDroppedFrames() {
+#if PXLCAM_DOUBLE_BUFFER_PREVIEW
+    return g_previewBuffer.getDroppedFrames();
+#else
+    return 0;
+#endif
 }
 
 }  // namespace pxlcam::preview
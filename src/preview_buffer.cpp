@@ -24,106 +24,139 @@ DoubleBuffer::~DoubleBuffer() {
 }
 
 bool DoubleBuffer::allocate() {
-    if (buffers_[0] != nullptr) {
-        return true;  // Already allocated
+    if (isAllocated()) {
+        return true;  // Heap block, or this session's lease
     }
     
-    PXLCAM_LOGI_TAG(kLogTag, "Allocating double buffer: %d bytes each", kBufferSize);
+    constexpr size_t kBlockSize = kBufferSize * 2 + kBitmapSize;
+    uint8_t* block = heapBlock_;
     
-    // Try PSRAM first
-    buffers_[0] = static_cast<uint8_t*>(heap_caps_malloc(kBufferSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-    buffers_[1] = static_cast<uint8_t*>(heap_caps_malloc(kBufferSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-    bitmapBuffer_ = static_cast<uint8_t*>(heap_caps_malloc(kBitmapSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-    
-    if (buffers_[0] && buffers_[1] && bitmapBuffer_) {
+    // Frame arena first: the block is only needed while a preview runs
+    if (!block && lease_.acquire(arena::Phase::Preview, kBlockSize, "PreviewDouble")) {
+        block = lease_.get();
         inPsram_ = true;
-        PXLCAM_LOGI_TAG(kLogTag, "Buffers allocated in PSRAM");
-    } else {
-        // Fallback to regular heap
-        if (buffers_[0]) { heap_caps_free(buffers_[0]); buffers_[0] = nullptr; }
-        if (buffers_[1]) { heap_caps_free(buffers_[1]); buffers_[1] = nullptr; }
-        if (bitmapBuffer_) { heap_caps_free(bitmapBuffer_); bitmapBuffer_ = nullptr; }
+        PXLCAM_LOGI_TAG(kLogTag, "Double buffer leased from frame arena: %d bytes",
+                        static_cast<int>(kBlockSize));
+    }
+    
+    if (!block) {
+        PXLCAM_LOGI_TAG(kLogTag, "Allocating double buffer: %d bytes each", kBufferSize);
         
-        PXLCAM_LOGW_TAG(kLogTag, "PSRAM alloc failed, trying heap");
-        buffers_[0] = static_cast<uint8_t*>(malloc(kBufferSize));
-        buffers_[1] = static_cast<uint8_t*>(malloc(kBufferSize));
-        bitmapBuffer_ = static_cast<uint8_t*>(malloc(kBitmapSize));
-        inPsram_ = false;
+        // Try PSRAM first
+        heapBlock_ = static_cast<uint8_t*>(heap_caps_malloc(kBlockSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        inPsram_ = heapBlock_ != nullptr;
+        if (inPsram_) {
+            PXLCAM_LOGI_TAG(kLogTag, "Buffers allocated in PSRAM");
+        } else {
+            // Fallback to regular heap
+            PXLCAM_LOGW_TAG(kLogTag, "PSRAM alloc failed, trying heap");
+            heapBlock_ = static_cast<uint8_t*>(malloc(kBlockSize));
+        }
+        block = heapBlock_;
     }
     
-    if (!buffers_[0] || !buffers_[1] || !bitmapBuffer_) {
+    if (!block) {
         PXLCAM_LOGE_TAG(kLogTag, "Failed to allocate preview buffers");
         deallocate();
         return false;
     }
     
+    buffers_[0] = block;
+    buffers_[1] = block + kBufferSize;
+    bitmapBuffer_ = block + kBufferSize * 2;
+    
     // Clear buffers
-    memset(buffers_[0], 0, kBufferSize);
-    memset(buffers_[1], 0, kBufferSize);
-    memset(bitmapBuffer_, 0, kBitmapSize);
+    memset(block, 0, kBlockSize);
     
     // Reset state
     writeIdx_ = 0;
     readIdx_ = 1;
-    state_[0].ready.store(false);
-    state_[0].inUse.store(false);
-    state_[1].ready.store(false);
-    state_[1].inUse.store(false);
+    state_[0].store(SlotState::Free);
+    state_[1].store(SlotState::Free);
+    resetStats();
     
     PXLCAM_LOGI_TAG(kLogTag, "Double buffer initialized, PSRAM=%d", inPsram_);
     return true;
 }
 
 void DoubleBuffer::deallocate() {
-    if (buffers_[0]) {
-        if (inPsram_) heap_caps_free(buffers_[0]);
-        else free(buffers_[0]);
-        buffers_[0] = nullptr;
-    }
-    if (buffers_[1]) {
-        if (inPsram_) heap_caps_free(buffers_[1]);
-        else free(buffers_[1]);
-        buffers_[1] = nullptr;
-    }
-    if (bitmapBuffer_) {
-        if (inPsram_) heap_caps_free(bitmapBuffer_);
-        else free(bitmapBuffer_);
-        bitmapBuffer_ = nullptr;
+    if (heapBlock_) {
+        if (inPsram_) heap_caps_free(heapBlock_);
+        else free(heapBlock_);
+        heapBlock_ = nullptr;
     }
+    lease_ = arena::Lease<uint8_t>();
+    buffers_[0] = nullptr;
+    buffers_[1] = nullptr;
+    bitmapBuffer_ = nullptr;
+}
+
+bool DoubleBuffer::isAllocated() const {
+    return buffers_[0] != nullptr && (heapBlock_ || lease_.get());
 }
 
 uint8_t* DoubleBuffer::getWriteBuffer() {
     return buffers_[writeIdx_];
 }
 
+bool DoubleBuffer::reclaim(int idx) {
+    SlotState expected = SlotState::Ready;
+    if (!state_[idx].compare_exchange_strong(expected, SlotState::Free, std::memory_order_acq_rel)) {
+        return false;
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
 void DoubleBuffer::commitWrite() {
-    // Mark current write buffer as ready
-    state_[writeIdx_].ready.store(true, std::memory_order_release);
+    const int done = writeIdx_;
+    const int other = 1 - done;
+    
+    // Drop a frame nobody read before publishing, so only one slot is ever Ready
+    reclaim(other);
+    
+    // Publish: pixel writes happen-before the consumer's acquire
+    state_[done].store(SlotState::Ready, std::memory_order_release);
+    committed_.fetch_add(1, std::memory_order_relaxed);
     
-    // Swap indices
-    writeIdx_ = 1 - writeIdx_;
+    for (;;) {
+        if (state_[other].load(std::memory_order_acquire) == SlotState::Free) {
+            writeIdx_ = other;
+            return;
+        }
+        if (reclaim(done)) {
+            // Consumer is still on the other slot: overwrite this frame next
+            writeIdx_ = done;
+            return;
+        }
+        // Consumer released `other` and took `done` between the checks; retry
+    }
 }
 
 uint8_t* DoubleBuffer::getReadBuffer() {
-    int idx = 1 - writeIdx_;  // Read from the other buffer
-    
-    if (!state_[idx].ready.load(std::memory_order_acquire)) {
-        return nullptr;  // No ready buffer
+    // At most one slot is Ready; the write slot never is
+    for (int idx = 0; idx < 2; idx++) {
+        SlotState expected = SlotState::Ready;
+        if (state_[idx].compare_exchange_strong(expected, SlotState::Reading, std::memory_order_acq_rel)) {
+            readIdx_ = idx;
+            return buffers_[idx];
+        }
     }
-    
-    state_[idx].inUse.store(true, std::memory_order_release);
-    readIdx_ = idx;
-    return buffers_[idx];
+    return nullptr;  // No ready buffer
 }
 
 void DoubleBuffer::releaseRead() {
-    state_[readIdx_].inUse.store(false, std::memory_order_release);
-    state_[readIdx_].ready.store(false, std::memory_order_release);
+    state_[readIdx_].store(SlotState::Free, std::memory_order_release);
 }
 
 bool DoubleBuffer::hasReadyBuffer() const {
-    int idx = 1 - writeIdx_;
-    return state_[idx].ready.load(std::memory_order_acquire);
+    return state_[0].load(std::memory_order_acquire) == SlotState::Ready ||
+           state_[1].load(std::memory_order_acquire) == SlotState::Ready;
+}
+
+void DoubleBuffer::resetStats() {
+    committed_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
 }
 
 uint8_t* DoubleBuffer::getBitmapBuffer() {
@@ -4,6 +4,9 @@
  */
 
 #include "preview_dither.h"
+#include "filters/blue_noise.h"
+#include "filters/dither_pipeline.h"
+#include "filters/palette.h"
 #include "pxlcam_config.h"
 #include "logging.h"
 
@@ -39,10 +42,19 @@ static const uint8_t kBayer8x8[64] = {
 };
 
 // Utility: set bit in packed bitmap
+// Pages: byte (y / 8) * w + x, bit y % 8 (SSD1306 framebuffer order)
+template <BitmapLayout Layout>
 inline void setBitPacked(uint8_t* out, int x, int y, int w, bool bit) {
-    const int idx = y * w + x;
-    const int byteIndex = idx >> 3;
-    const int bitIndex = 7 - (idx & 7);
+    int byteIndex;
+    int bitIndex;
+    if (Layout == BitmapLayout::Pages) {
+        byteIndex = (y >> 3) * w + x;
+        bitIndex = y & 7;
+    } else {
+        const int idx = y * w + x;
+        byteIndex = idx >> 3;
+        bitIndex = 7 - (idx & 7);
+    }
     if (bit) {
         out[byteIndex] |= (1 << bitIndex);
     } else {
@@ -128,16 +140,80 @@ void histogramEqualize(uint8_t* gray, int w, int h) {
     }
 }
 
-void applyGameBoyDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap) {
+void TemporalEqualizer::reset() {
+    for (int i = 0; i < 256; ++i) {
+        target_[i] = static_cast<uint16_t>(i << 8);
+        blend_[i] = target_[i];
+        lut_[i] = static_cast<uint8_t>(i);
+    }
+    memset(coarse_, 0, sizeof(coarse_));
+    framesSinceRebuild_ = 0;
+    rebuilds_ = 0;
+    primed_ = false;
+}
+
+void TemporalEqualizer::update(const uint32_t* hist, uint32_t pixels) {
+    if (!hist || pixels == 0) return;
+    
+    uint32_t coarse[kCoarseBins] = {0};
+    for (int i = 0; i < 256; ++i) {
+        coarse[i >> 4] += hist[i];
+    }
+    
+    // Share of pixels that changed coarse bin since the curve was built
+    uint32_t moved = 0;
+    for (int i = 0; i < kCoarseBins; ++i) {
+        moved += coarse[i] > coarse_[i] ? coarse[i] - coarse_[i] : coarse_[i] - coarse[i];
+    }
+    const bool sceneChanged = moved * 50 > static_cast<uint32_t>(PXLCAM_HISTEQ_CHANGE_PCT) * pixels;
+    
+    framesSinceRebuild_++;
+    if (!primed_ || sceneChanged || framesSinceRebuild_ >= PXLCAM_HISTEQ_REBUILD_FRAMES) {
+        // Equalization curve: CDF scaled to 0..255 in 8.8 fixed point
+        uint32_t cum = 0;
+        for (int i = 0; i < 256; ++i) {
+            cum += hist[i];
+            target_[i] = static_cast<uint16_t>((static_cast<uint64_t>(cum) * (255 << 8) + pixels / 2) / pixels);
+        }
+        memcpy(coarse_, coarse, sizeof(coarse_));
+        framesSinceRebuild_ = 0;
+        rebuilds_++;
+    }
+    
+    if (!primed_) {
+        memcpy(blend_, target_, sizeof(blend_));
+        primed_ = true;
+    } else {
+        // blend += (target - blend) / 2^shift
+        for (int i = 0; i < 256; ++i) {
+            const int32_t delta = static_cast<int32_t>(target_[i]) - blend_[i];
+            blend_[i] = static_cast<uint16_t>(blend_[i] + (delta >> PXLCAM_HISTEQ_IIR_SHIFT));
+        }
+    }
+    
+    for (int i = 0; i < 256; ++i) {
+        lut_[i] = static_cast<uint8_t>((blend_[i] + 128) >> 8);
+    }
+}
+
+void TemporalEqualizer::apply(uint8_t* gray, int n) const {
+    if (!gray) return;
+    for (int i = 0; i < n; ++i) {
+        gray[i] = lut_[gray[i]];
+    }
+}
+
+namespace {
+
+template <BitmapLayout Layout>
+void applyGameBoyDitherKernel(const uint8_t* gray, int w, int h, uint8_t* outBitmap) {
     if (!g_initialized) {
         initDitherModule(true);
     }
     
     if (!gray || !outBitmap || w <= 0 || h <= 0) return;
     
-    const int N = w * h;
-    const int bytes = (N + 7) / 8;
-    memset(outBitmap, 0, bytes);
+    memset(outBitmap, 0, bitmapBytes(w, h, Layout));
     
     for (int y = 0; y < h; ++y) {
         for (int x = 0; x < w; ++x) {
@@ -152,17 +228,17 @@ void applyGameBoyDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap) {
             const uint8_t b = kBayer8x8[(y & 7) * 8 + (x & 7)];
             const int threshold = static_cast<int>(target) + (b * 85 / 64) - 42;
             
-            setBitPacked(outBitmap, x, y, w, static_cast<int>(g) >= threshold);
+            setBitPacked<Layout>(outBitmap, x, y, w, static_cast<int>(g) >= threshold);
         }
     }
 }
 
-void applyFloydSteinbergDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap) {
+template <BitmapLayout Layout>
+void applyFloydSteinbergDitherKernel(const uint8_t* gray, int w, int h, uint8_t* outBitmap) {
     if (!gray || !outBitmap || w <= 0 || h <= 0) return;
     
     const int N = w * h;
-    const int bytes = (N + 7) / 8;
-    memset(outBitmap, 0, bytes);
+    memset(outBitmap, 0, bitmapBytes(w, h, Layout));
     
     // Need working buffer for error diffusion
     // Using static buffer to avoid heap allocation in loop
@@ -180,7 +256,7 @@ void applyFloydSteinbergDither(const uint8_t* gray, int w, int h, uint8_t* outBi
             const float newv = oldv < 128.0f ? 0.0f : 255.0f;
             const float err = oldv - newv;
             
-            setBitPacked(outBitmap, x, y, w, newv >= 128.0f);
+            setBitPacked<Layout>(outBitmap, x, y, w, newv >= 128.0f);
             
             // Distribute error to neighbors
             if (x + 1 < w) {
@@ -199,21 +275,77 @@ void applyFloydSteinbergDither(const uint8_t* gray, int w, int h, uint8_t* outBi
     }
 }
 
-void convertTo1bitThreshold(const uint8_t* gray, int w, int h, uint8_t* outBitmap, uint8_t threshold) {
+template <BitmapLayout Layout>
+void applyBlueNoiseDitherKernel(const uint8_t* gray, int w, int h, uint8_t* outBitmap) {
     if (!gray || !outBitmap || w <= 0 || h <= 0) return;
     
-    const int N = w * h;
-    const int bytes = (N + 7) / 8;
-    memset(outBitmap, 0, bytes);
+    memset(outBitmap, 0, bitmapBytes(w, h, Layout));
+    
+    constexpr int kMask = pxlcam::filters::BLUE_NOISE_SIZE - 1;
+    for (int y = 0; y < h; ++y) {
+        // Thresholds 0..255 are uniform over the tile: P(on) = g / 256
+        const uint8_t* tile = pxlcam::filters::blue_noise_row(y);
+        for (int x = 0; x < w; ++x) {
+            setBitPacked<Layout>(outBitmap, x, y, w, gray[y * w + x] > tile[x & kMask]);
+        }
+    }
+}
+
+template <BitmapLayout Layout>
+void convertTo1bitThresholdKernel(const uint8_t* gray, int w, int h, uint8_t* outBitmap, uint8_t threshold) {
+    if (!gray || !outBitmap || w <= 0 || h <= 0) return;
+    
+    memset(outBitmap, 0, bitmapBytes(w, h, Layout));
     
     for (int y = 0; y < h; ++y) {
         for (int x = 0; x < w; ++x) {
             const int idx = y * w + x;
-            setBitPacked(outBitmap, x, y, w, gray[idx] > threshold);
+            setBitPacked<Layout>(outBitmap, x, y, w, gray[idx] > threshold);
         }
     }
 }
 
+}  // namespace
+
+void applyGameBoyDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap, BitmapLayout layout) {
+    if (layout == BitmapLayout::Pages) {
+        applyGameBoyDitherKernel<BitmapLayout::Pages>(gray, w, h, outBitmap);
+    } else {
+        applyGameBoyDitherKernel<BitmapLayout::RowMajor>(gray, w, h, outBitmap);
+    }
+}
+
+void applyFloydSteinbergDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap, BitmapLayout layout) {
+    if (layout == BitmapLayout::Pages) {
+        applyFloydSteinbergDitherKernel<BitmapLayout::Pages>(gray, w, h, outBitmap);
+    } else {
+        applyFloydSteinbergDitherKernel<BitmapLayout::RowMajor>(gray, w, h, outBitmap);
+    }
+}
+
+void applyBlueNoiseDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap, BitmapLayout layout) {
+    if (layout == BitmapLayout::Pages) {
+        applyBlueNoiseDitherKernel<BitmapLayout::Pages>(gray, w, h, outBitmap);
+    } else {
+        applyBlueNoiseDitherKernel<BitmapLayout::RowMajor>(gray, w, h, outBitmap);
+    }
+}
+
+void convertTo1bitThreshold(const uint8_t* gray, int w, int h, uint8_t* outBitmap, uint8_t threshold, BitmapLayout layout) {
+    if (layout == BitmapLayout::Pages) {
+        convertTo1bitThresholdKernel<BitmapLayout::Pages>(gray, w, h, outBitmap, threshold);
+    } else {
+        convertTo1bitThresholdKernel<BitmapLayout::RowMajor>(gray, w, h, outBitmap, threshold);
+    }
+}
+
+int bitmapBytes(int w, int h, BitmapLayout layout) {
+    if (layout == BitmapLayout::Pages) {
+        return w * ((h + 7) / 8);
+    }
+    return (w * h + 7) / 8;
+}
+
 void applyNightVision(uint8_t* gray, int w, int h, float gammaBoost, float contrastMult) {
     if (!gray || w <= 0 || h <= 0) return;
     
@@ -235,7 +367,8 @@ void applyNightVision(uint8_t* gray, int w, int h, float gammaBoost, float contr
     }
 }
 
-void processDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap, bool enableHistEq) {
+void processDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap, bool enableHistEq,
+                   BitmapLayout layout) {
     if (!gray || !outBitmap || w <= 0 || h <= 0) return;
     
     // Make working copy if we need to modify
@@ -253,24 +386,63 @@ void processDither(const uint8_t* gray, int w, int h, uint8_t* outBitmap, bool e
     // Apply current dither mode
     switch (g_currentMode) {
         case DitherMode::Threshold:
-            convertTo1bitThreshold(workBuf, w, h, outBitmap, 128);
+            convertTo1bitThreshold(workBuf, w, h, outBitmap, 128, layout);
             break;
             
         case DitherMode::GameBoy:
-            applyGameBoyDither(workBuf, w, h, outBitmap);
+            applyGameBoyDither(workBuf, w, h, outBitmap, layout);
             break;
             
         case DitherMode::FloydSteinberg:
-            applyFloydSteinbergDither(workBuf, w, h, outBitmap);
+            applyFloydSteinbergDither(workBuf, w, h, outBitmap, layout);
             break;
             
         case DitherMode::Night:
             applyNightVision(workBuf, w, h);
-            convertTo1bitThreshold(workBuf, w, h, outBitmap, 100);  // Lower threshold for night
+            convertTo1bitThreshold(workBuf, w, h, outBitmap, 100, layout);  // Lower threshold for night
+            break;
+            
+        case DitherMode::BlueNoise:
+            applyBlueNoiseDither(workBuf, w, h, outBitmap, layout);
             break;
     }
 }
 
+void ditherAtLevel(const uint8_t* gray, int w, int h, uint8_t* outBitmap, QualityLevel level,
+                   BitmapLayout layout) {
+    if (!gray || !outBitmap || w <= 0 || h <= 0) return;
+    
+#if PXLCAM_FEATURE_STYLIZED_CAPTURE
+    using namespace pxlcam::filters;
+    DitherAlgorithm algorithm;
+    switch (level) {
+        case QualityLevel::FloydSteinberg: algorithm = DitherAlgorithm::FLOYD_STEINBERG; break;
+        case QualityLevel::Atkinson:       algorithm = DitherAlgorithm::ATKINSON; break;
+        case QualityLevel::BlueNoise:      algorithm = DitherAlgorithm::BLUE_NOISE; break;
+        case QualityLevel::Bayer8:         algorithm = DitherAlgorithm::ORDERED_8X8; break;
+        case QualityLevel::Bayer4:         algorithm = DitherAlgorithm::ORDERED_4X4; break;
+        default:
+            convertTo1bitThreshold(gray, w, h, outBitmap, 128, layout);
+            return;
+    }
+    
+    if (!palette_is_initialized()) palette_init();
+    if (!dither_is_initialized()) dither_init();
+    
+    // Full-range palette: the 1-bit outputs split between tones[0] and tones[3]
+    DitherConfig config(algorithm);
+    config.output = layout == BitmapLayout::Pages ? DitherOutput::SSD1306_PAGES : DitherOutput::PACKED_1BPP;
+    const DitherResult result = apply_palette_dither_ex(gray, SourceFormat::GRAYSCALE, outBitmap, w, h,
+                                                        palette_get(PaletteType::GB_POCKET), config);
+    if (result.success) {
+        return;
+    }
+#else
+    (void)level;
+#endif
+    convertTo1bitThreshold(gray, w, h, outBitmap, 128, layout);
+}
+
 bool selfTest() {
     PXLCAM_LOGI_TAG(kLogTag, "Running dither self-test");
     
@@ -0,0 +1,109 @@
+/**
+ * @file quality_governor.cpp
+ * @brief Picks the best preview dither level that fits the frame budget
+ */
+
+#include "quality_governor.h"
+
+#include <cstddef>
+
+namespace pxlcam::dither {
+
+namespace {
+
+constexpr const char* kQualityTags[] = { "FS", "ATK", "BN", "B8", "B4", "THR" };
+static_assert(sizeof(kQualityTags) / sizeof(kQualityTags[0]) == static_cast<size_t>(QualityLevel::Count),
+              "kQualityTags must match QualityLevel");
+
+constexpr uint16_t kMaxCooldownFrames = 3600;  // ~3 min at 20 FPS
+
+}  // namespace
+
+const char* getQualityTag(QualityLevel level) {
+    const uint8_t i = static_cast<uint8_t>(level);
+    return i < static_cast<uint8_t>(QualityLevel::Count) ? kQualityTags[i] : "?";
+}
+
+void QualityGovernor::begin(const Config& config) {
+    config_ = config;
+    for (int i = 0; i < kLevels; ++i) {
+        costUs_[i] = 0;
+        retryAfter_[i] = 0;
+        cooldown_[i] = 0;
+    }
+    level_ = QualityLevel::FloydSteinberg;
+    frame_ = 0;
+    switches_ = 0;
+    overruns_ = 0;
+    calm_ = 0;
+}
+
+uint32_t QualityGovernor::getCostUs(QualityLevel level) const {
+    const int i = static_cast<int>(level);
+    return i < kLevels ? costUs_[i] : 0;
+}
+
+void QualityGovernor::setLevel(int level) {
+    level_ = static_cast<QualityLevel>(level);
+    overruns_ = 0;
+    calm_ = 0;
+    switches_++;
+}
+
+bool QualityGovernor::update(uint32_t ditherUs, uint32_t workUs) {
+    const int level = static_cast<int>(level_);
+    frame_++;
+    
+    // cost += (sample - cost) / 8
+    uint32_t& cost = costUs_[level];
+    if (cost == 0) {
+        cost = ditherUs > 0 ? ditherUs : 1;
+    } else {
+        cost = static_cast<uint32_t>(static_cast<int32_t>(cost) +
+                                     (static_cast<int32_t>(ditherUs) - static_cast<int32_t>(cost)) / 8);
+    }
+    
+    if (workUs > config_.budgetUs) {
+        calm_ = 0;
+        if (++overruns_ < config_.overrunFrames || level == kLevels - 1) {
+            return false;
+        }
+        
+        // Give up on this level for a while; longer each time it fails
+        uint16_t& cooldown = cooldown_[level];
+        cooldown = cooldown == 0 ? config_.cooldownFrames
+                                 : (cooldown >= kMaxCooldownFrames / 2 ? kMaxCooldownFrames : cooldown * 2);
+        retryAfter_[level] = frame_ + cooldown;
+        setLevel(level + 1);
+        return true;
+    }
+    
+    overruns_ = 0;
+    if (level == 0) {
+        return false;
+    }
+    
+    // Would the better level fit in place of this one?
+    const int better = level - 1;
+    bool fits = frame_ >= retryAfter_[better];
+    if (fits && costUs_[better] != 0) {
+        const uint32_t others = workUs > cost ? workUs - cost : 0;
+        const uint64_t predicted = static_cast<uint64_t>(others) + costUs_[better];
+        fits = predicted * 100 <= static_cast<uint64_t>(config_.budgetUs) * config_.headroomPct;
+    }
+    
+    if (!fits) {
+        calm_ = 0;
+        return false;
+    }
+    if (++calm_ < config_.calmFrames) {
+        return false;
+    }
+    
+    // This level held up; a later failure starts its cooldown from scratch
+    cooldown_[level] = 0;
+    setLevel(better);
+    return true;
+}
+
+}  // namespace pxlcam::dither
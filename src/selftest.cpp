@@ -5,7 +5,9 @@
 #include <Arduino.h>
 #include <esp_system.h>
 
+#include "camera_config.h"
 #include "display.h"
+#include "pipeline_bench.h"
 
 namespace pxlcam::selftest {
 
@@ -96,6 +98,29 @@ void testButton() {
     }
 }
 
+#if PXLCAM_FEATURE_BENCHMARK
+void testBenchmark() {
+    Serial.print("[BENCHMARK]   ");
+    Serial.println("Timing every pipeline stage (takes a while)...");
+
+    // Sensor no maior tamanho: cada resolução do benchmark cabe nos buffers
+    if (!pxlcam::initCamera(pxlcam::makeDefaultPins(), pxlcam::makeDefaultSettings())) {
+        Serial.println("              FAIL - Could not initialize camera");
+        return;
+    }
+
+    // Sem SD montado: as linhas sd_write saem como skipped
+    if (pxlcam::bench::run()) {
+        Serial.println("              OK - CSV:");
+        Serial.println();
+        Serial.print(pxlcam::bench::results());
+    } else {
+        Serial.println("              FAIL - Benchmark did not run");
+    }
+    pxlcam::shutdownCamera();
+}
+#endif
+
 void printChipInfo() {
     Serial.println("[CHIP INFO]");
     Serial.print("              Model: ");
@@ -133,6 +158,9 @@ void run() {
     testHeap();
     testDisplay();
     testButton();
+#if PXLCAM_FEATURE_BENCHMARK
+    testBenchmark();
+#endif
 
     printFooter();
 
@@ -0,0 +1,209 @@
+/**
+ * @file sensor_profile.cpp
+ * @brief Shadow of the OV2640 settings and named profiles
+ */
+
+#include "sensor_profile.h"
+
+#include "logging.h"
+#include "pxlcam_config.h"
+
+#include <esp_camera.h>
+#include <freertos/FreeRTOS.h>
+
+#include <atomic>
+
+namespace pxlcam::sensor {
+
+namespace {
+
+constexpr const char* kLogTag = "sensor";
+
+enum Field : uint16_t {
+    kGainCeiling  = 1u << 0,
+    kAutoExposure = 1u << 1,
+    kAutoGain     = 1u << 2,
+    kAeLevel      = 1u << 3,
+    kAecValue     = 1u << 4,
+    kAgcGain      = 1u << 5,
+    kBrightness   = 1u << 6,
+    kContrast     = 1u << 7,
+    kSaturation   = 1u << 8,
+};
+
+constexpr Settings kStandard = {0, 0, 0, true, true, 0, 300, 0, GAINCEILING_2X};
+
+Settings g_shadow = kStandard;      ///< What the sensor holds (fields in g_known)
+uint16_t g_known = 0;
+Settings g_target = kStandard;
+bool g_pending = false;
+Profile g_profile = Profile::Standard;
+Stats g_stats = {};
+portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+std::atomic<bool> g_applying{false};
+
+/// One setter call if the field is not known to hold the value
+template <typename T>
+void write(sensor_t* s, int (*setter)(sensor_t*, int), uint16_t field, T& shadow, T value,
+           uint16_t& known, uint8_t& writes) {
+    if ((known & field) && shadow == value) {
+        g_stats.skipped++;
+        return;
+    }
+    if (!setter || setter(s, static_cast<int>(value)) != 0) {
+        g_stats.failed++;
+        known &= static_cast<uint16_t>(~field);
+        return;
+    }
+    shadow = value;
+    known |= field;
+    writes++;
+}
+
+/// set_gainceiling() takes the enum
+int setGainCeiling(sensor_t* s, int value) {
+    return s->set_gainceiling ? s->set_gainceiling(s, static_cast<gainceiling_t>(value)) : -1;
+}
+
+}  // namespace
+
+Settings profileSettings(Profile profile) {
+    Settings settings = kStandard;
+    switch (profile) {
+        case Profile::Night:
+            settings.autoExposure = false;
+            settings.autoGain = false;
+            settings.aecValue = 800;
+            settings.agcGain = 20;
+            settings.brightness = 1;
+            settings.contrast = 1;
+            break;
+        case Profile::Preview:
+            settings.contrast = PXLCAM_SENSOR_PREVIEW_CONTRAST;
+            settings.gainCeiling = PXLCAM_SENSOR_PREVIEW_GAINCEILING;
+            break;
+        case Profile::Standard:
+        case Profile::Capture:
+        default:
+            break;
+    }
+    return settings;
+}
+
+const char* profileName(Profile profile) {
+    switch (profile) {
+        case Profile::Standard: return "standard";
+        case Profile::Night:    return "night";
+        case Profile::Preview:  return "preview";
+        case Profile::Capture:  return "capture";
+        default:                return "custom";
+    }
+}
+
+void stage(const Settings& settings, Profile profile) {
+    portENTER_CRITICAL(&g_lock);
+    g_target = settings;
+    g_pending = true;
+    if (profile < Profile::Count) {
+        g_profile = profile;
+    }
+    portEXIT_CRITICAL(&g_lock);
+}
+
+void stageProfile(Profile profile) {
+    stage(profileSettings(profile), profile);
+}
+
+Settings target() {
+    portENTER_CRITICAL(&g_lock);
+    const Settings settings = g_target;
+    portEXIT_CRITICAL(&g_lock);
+    return settings;
+}
+
+Profile currentProfile() {
+    return g_profile;
+}
+
+bool pending() {
+    return g_pending;
+}
+
+uint8_t apply() {
+    // One batch at a time; a frame owner that finds one running leaves the
+    // staged settings for the next boundary
+    if (g_applying.exchange(true)) {
+        return 0;
+    }
+    sensor_t* s = esp_camera_sensor_get();
+    if (!s) {
+        g_applying = false;
+        return 0;
+    }
+
+    portENTER_CRITICAL(&g_lock);
+    const bool staged = g_pending;
+    const Settings want = g_target;
+    g_pending = false;
+    portEXIT_CRITICAL(&g_lock);
+    if (!staged) {
+        g_applying = false;
+        return 0;
+    }
+
+    uint16_t known = g_known;
+    uint8_t writes = 0;
+    uint8_t gainCeiling = g_shadow.gainCeiling;
+    uint8_t autoExposure = g_shadow.autoExposure;
+    uint8_t autoGain = g_shadow.autoGain;
+    int8_t aeLevel = g_shadow.aeLevel;
+    uint16_t aecValue = g_shadow.aecValue;
+    uint8_t agcGain = g_shadow.agcGain;
+    int8_t brightness = g_shadow.brightness;
+    int8_t contrast = g_shadow.contrast;
+    int8_t saturation = g_shadow.saturation;
+
+    // Control modes before the values they govern
+    write(s, setGainCeiling, kGainCeiling, gainCeiling, want.gainCeiling, known, writes);
+    write(s, s->set_exposure_ctrl, kAutoExposure, autoExposure,
+          static_cast<uint8_t>(want.autoExposure), known, writes);
+    write(s, s->set_gain_ctrl, kAutoGain, autoGain, static_cast<uint8_t>(want.autoGain), known, writes);
+    if (want.autoExposure) {
+        // The sensor loop owns the exposure time from here on
+        known &= static_cast<uint16_t>(~kAecValue);
+        write(s, s->set_ae_level, kAeLevel, aeLevel, want.aeLevel, known, writes);
+    } else {
+        write(s, s->set_aec_value, kAecValue, aecValue, want.aecValue, known, writes);
+    }
+    if (want.autoGain) {
+        known &= static_cast<uint16_t>(~kAgcGain);
+    } else {
+        write(s, s->set_agc_gain, kAgcGain, agcGain, want.agcGain, known, writes);
+    }
+    write(s, s->set_brightness, kBrightness, brightness, want.brightness, known, writes);
+    write(s, s->set_contrast, kContrast, contrast, want.contrast, known, writes);
+    write(s, s->set_saturation, kSaturation, saturation, want.saturation, known, writes);
+
+    g_shadow = {brightness, contrast, saturation, autoExposure != 0, autoGain != 0,
+                aeLevel, aecValue, agcGain, gainCeiling};
+    g_known = known;
+    if (writes > 0) {
+        g_stats.batches++;
+        g_stats.writes += writes;
+        PXLCAM_LOGD_TAG(kLogTag, "Applied %s: %u writes", profileName(g_profile), writes);
+    }
+    g_applying = false;
+    return writes;
+}
+
+void markUnknown() {
+    portENTER_CRITICAL(&g_lock);
+    g_known = 0;
+    portEXIT_CRITICAL(&g_lock);
+}
+
+Stats getStats() {
+    return g_stats;
+}
+
+}  // namespace pxlcam::sensor
@@ -3,12 +3,27 @@
 #include <Arduino.h>
 #include <FS.h>
 #include <SD_MMC.h>
+#include <esp_attr.h>
 #include <esp_err.h>
+#include <esp_heap_caps.h>
 #include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
 #include <string>
 
 #include "logging.h"
+#include "nvs_store.h"
+#include "pxlcam_config.h"
+#include "trace.h"
 
 namespace pxlcam::storage {
 
@@ -17,8 +32,117 @@ namespace {
 constexpr const char *kLogTag = "pxlcam-storage";
 
 StorageConfig g_config{};
+StorageStatus g_status{};
 bool g_initialized = false;
 
+// One SD_MMC bus setting tried by initSD()
+struct BusCandidate {
+    bool mode1Bit;
+    int frequencyKHz;
+};
+
+constexpr const char *kBenchPath = "/.sdtest";
+constexpr size_t kBenchChunk = 8192;
+
+// Files are written through the VFS (plain fd, no stdio buffer) in
+// PXLCAM_SD_WRITE_CHUNK pieces from a DMA-capable buffer. Every piece but the
+// last starts and ends on a chunk boundary, so FatFs passes whole sectors
+// straight to the SDMMC driver instead of copying them through its sector
+// window. When the final size is known, seeking there at open builds the
+// cluster chain once, instead of a FAT lookup and update per new cluster
+// in the middle of the write.
+constexpr size_t kWriteChunk = PXLCAM_SD_WRITE_CHUNK;
+static_assert(kWriteChunk >= 512 && kWriteChunk % 512 == 0, "PXLCAM_SD_WRITE_CHUNK must be a multiple of the sector size");
+
+struct AlignedWriter {
+    int fd = -1;
+    uint8_t *buffer = nullptr;  // kWriteChunk bytes; nullptr writes straight through
+    size_t fill = 0;            // Bytes waiting in buffer
+    size_t written = 0;         // Bytes accepted (buffered or on the card)
+    size_t reserved = 0;        // Size preallocated at open
+    bool ok = false;
+    std::string fullPath;       // For the trim after close (the FAT VFS may lack ftruncate())
+};
+
+uint8_t *g_fileBuffer = nullptr;    // writeBufferToFile() (callers hold the SD lock)
+uint8_t *g_streamBuffer = nullptr;  // The open stream keeps its chunk between appends
+
+AlignedWriter g_stream;
+std::string g_streamPath;
+
+WriteStats g_writeStats{};
+
+// Bus setting of the last successful probe, for quickMount (see initSD())
+struct BusCache {
+    bool valid;
+    bool mode1Bit;
+    int frequencyKHz;
+};
+RTC_DATA_ATTR BusCache g_busCache;
+
+// Directories known to exist, so a save doesn't look each one up again
+constexpr size_t kDirCacheEntries = 8;
+constexpr size_t kDirCachePath = 32;
+char g_dirCache[kDirCacheEntries][kDirCachePath] = {};
+size_t g_dirCacheNext = 0;  // Round-robin replacement
+
+// File numbering (see nextFileNumber()). Kept in RTC memory, so a deep-sleep
+// timelapse goes on with its batch instead of reserving one per frame; any
+// other boot reloads both from the image (0) and reads NVS again.
+RTC_DATA_ATTR uint32_t g_nextFileNumber = 0;     // 0 = not loaded from NVS yet
+RTC_DATA_ATTR uint32_t g_reservedFileNumber = 0; // Highest number NVS knows is taken
+
+// Background writer
+constexpr size_t kMaxJobPath = 64;
+constexpr uint32_t kWriterStopMs = 10000;  // Longest shutdownSD() waits for queued writes
+
+struct WriteJob {
+    char path[kMaxJobPath];
+    uint8_t *data;            // Owned copy; nullptr asks the writer to exit
+    size_t length;
+    WriteCallback callback;
+    void *user;
+    bool append;              // appendRecord(): data is one record added to the file
+    bool ok;
+};
+
+QueueHandle_t g_jobQueue = nullptr;      // saveFileAsync() -> writer
+QueueHandle_t g_doneQueue = nullptr;     // writer -> pollWrites()
+SemaphoreHandle_t g_jobSlots = nullptr;  // One token per image in flight
+SemaphoreHandle_t g_sdLock = nullptr;    // Serialises card access between tasks
+TaskHandle_t g_writerTask = nullptr;
+
+// Holds the card for one operation (no-op before the writer exists)
+class SdLock {
+   public:
+    SdLock() {
+        if (g_sdLock != nullptr) {
+            xSemaphoreTake(g_sdLock, portMAX_DELAY);
+        }
+    }
+    ~SdLock() {
+        if (g_sdLock != nullptr) {
+            xSemaphoreGive(g_sdLock);
+        }
+    }
+    SdLock(const SdLock &) = delete;
+    SdLock &operator=(const SdLock &) = delete;
+};
+
+// Time one file write and add it to the counters
+size_t timedWrite(int fd, const uint8_t *data, size_t length) {
+    PXLCAM_TRACE_SCOPE(SdWrite, length);
+    const uint32_t start = micros();
+    const ssize_t result = ::write(fd, data, length);
+    const size_t written = result > 0 ? static_cast<size_t>(result) : 0;
+    g_writeStats.writeUs += micros() - start;
+    g_writeStats.bytes += written;
+    if (written != length) {
+        g_writeStats.failures++;
+    }
+    return written;
+}
+
 const char *resolveMountPoint(const StorageConfig &config) {
     return (config.mountPoint != nullptr && config.mountPoint[0] != '\0') ? config.mountPoint : "/sdcard";
 }
@@ -35,7 +159,35 @@ std::string sanitizePath(const char *path) {
     return sanitized;
 }
 
+bool isCachedDirectory(const std::string &directory) {
+    for (const char *entry : g_dirCache) {
+        if (entry[0] != '\0' && directory == entry) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void cacheDirectory(const std::string &directory) {
+    if (directory.size() >= kDirCachePath) {
+        return;  // Rare deep paths just get looked up
+    }
+    memcpy(g_dirCache[g_dirCacheNext], directory.c_str(), directory.size() + 1);
+    g_dirCacheNext = (g_dirCacheNext + 1) % kDirCacheEntries;
+}
+
+void clearDirectoryCache() {
+    memset(g_dirCache, 0, sizeof(g_dirCache));
+    g_dirCacheNext = 0;
+}
+
 bool ensureParentDirectories(const std::string &fullPath) {
+    // Common case: the file's own folder was seen before, nothing to look up
+    const std::size_t lastSlash = fullPath.rfind('/');
+    if (lastSlash == 0 || lastSlash == std::string::npos || isCachedDirectory(fullPath.substr(0, lastSlash))) {
+        return true;
+    }
+
     std::size_t searchPos = 1;  // skip root slash
     while (true) {
         std::size_t slash = fullPath.find('/', searchPos);
@@ -44,36 +196,381 @@ bool ensureParentDirectories(const std::string &fullPath) {
         }
 
         std::string directory = fullPath.substr(0, slash);
-        if (!directory.empty() && directory != "/" && !SD_MMC.exists(directory.c_str())) {
-            if (!SD_MMC.mkdir(directory.c_str())) {
+        if (!directory.empty() && directory != "/" && !isCachedDirectory(directory)) {
+            if (!SD_MMC.exists(directory.c_str()) && !SD_MMC.mkdir(directory.c_str())) {
                 PXLCAM_LOGE_TAG(kLogTag, "Failed to create directory: %s", directory.c_str());
                 return false;
             }
+            cacheDirectory(directory);
         }
 
         searchPos = slash + 1;
     }
 }
 
+void allocWriteBuffers() {
+    if (g_fileBuffer != nullptr || g_streamBuffer != nullptr) {
+        return;  // Kept by a shutdown whose writer never stopped
+    }
+    g_fileBuffer = static_cast<uint8_t *>(heap_caps_malloc(kWriteChunk, MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+    g_streamBuffer = static_cast<uint8_t *>(heap_caps_malloc(kWriteChunk, MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+    if (g_fileBuffer == nullptr || g_streamBuffer == nullptr) {
+        PXLCAM_LOGW_TAG(kLogTag, "No DMA memory for %u-byte write buffers; writing unaligned", static_cast<unsigned>(kWriteChunk));
+    }
+}
+
+void freeWriteBuffers() {
+    heap_caps_free(g_fileBuffer);
+    heap_caps_free(g_streamBuffer);
+    g_fileBuffer = g_streamBuffer = nullptr;
+}
+
+// Create (or truncate) path; expectedSize > 0 preallocates that many bytes
+bool alignedOpen(AlignedWriter &writer, const std::string &path, uint8_t *buffer, size_t expectedSize) {
+    writer = AlignedWriter{};
+    writer.fullPath = std::string(resolveMountPoint(g_config)) + path;
+    writer.fd = ::open(writer.fullPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (writer.fd < 0) {
+        PXLCAM_LOGE_TAG(kLogTag, "Failed to open file for writing: %s", path.c_str());
+        return false;
+    }
+
+    if (expectedSize > 0) {
+        // In write mode FatFs allocates the clusters it seeks over
+        const off_t end = static_cast<off_t>(expectedSize);
+        if (::lseek(writer.fd, end, SEEK_SET) == end) {
+            writer.reserved = expectedSize;
+        }
+        if (::lseek(writer.fd, 0, SEEK_SET) != 0) {
+            ::close(writer.fd);
+            writer.fd = -1;
+            return false;
+        }
+    }
+
+    writer.buffer = buffer;
+    writer.ok = true;
+    return true;
+}
+
+bool alignedAppend(AlignedWriter &writer, const uint8_t *data, size_t length) {
+    if (!writer.ok) {
+        return false;
+    }
+
+    if (writer.buffer == nullptr) {
+        const size_t written = timedWrite(writer.fd, data, length);
+        writer.written += written;
+        writer.ok = written == length;
+        return writer.ok;
+    }
+
+    while (length > 0) {
+        const size_t take = length < kWriteChunk - writer.fill ? length : kWriteChunk - writer.fill;
+        memcpy(writer.buffer + writer.fill, data, take);
+        writer.fill += take;
+        writer.written += take;
+        data += take;
+        length -= take;
+
+        if (writer.fill == kWriteChunk) {
+            writer.fill = 0;
+            if (timedWrite(writer.fd, writer.buffer, kWriteChunk) != kWriteChunk) {
+                writer.ok = false;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Overwrite bytes already appended (container headers). The part still in
+// the buffer is patched there; the rest is written in place on the card.
+bool alignedPatch(AlignedWriter &writer, size_t offset, const uint8_t *data, size_t length) {
+    if (!writer.ok || offset + length > writer.written) {
+        return false;
+    }
+
+    const size_t flushed = writer.written - writer.fill;  // Where the file position is
+    if (offset + length > flushed) {
+        const size_t from = offset > flushed ? offset : flushed;
+        memcpy(writer.buffer + (from - flushed), data + (from - offset), offset + length - from);
+        length = from - offset;
+    }
+    if (length == 0) {
+        return true;
+    }
+
+    writer.ok = ::lseek(writer.fd, static_cast<off_t>(offset), SEEK_SET) == static_cast<off_t>(offset) &&
+                timedWrite(writer.fd, data, length) == length &&
+                ::lseek(writer.fd, static_cast<off_t>(flushed), SEEK_SET) == static_cast<off_t>(flushed);
+    return writer.ok;
+}
+
+// Put everything appended on the card and commit the directory entry. The
+// partial chunk is written and the position stepped back over it, so the
+// next full chunk rewrites it aligned.
+bool alignedSync(AlignedWriter &writer) {
+    if (!writer.ok) {
+        return false;
+    }
+
+    if (writer.fill > 0) {
+        const off_t back = static_cast<off_t>(writer.fill);
+        writer.ok = timedWrite(writer.fd, writer.buffer, writer.fill) == writer.fill &&
+                    ::lseek(writer.fd, -back, SEEK_CUR) >= 0;
+    }
+    if (writer.ok && ::fsync(writer.fd) != 0) {
+        writer.ok = false;
+    }
+    return writer.ok;
+}
+
+// Write the tail, close and give back any unused reservation. The trim goes
+// by path after close(): truncate() reaches the FAT VFS where ftruncate() on
+// an fd may not. A failed trim leaves unused bytes past the data, never a
+// lost file.
+bool alignedClose(AlignedWriter &writer) {
+    if (writer.fd < 0) {
+        return false;
+    }
+
+    if (writer.ok && writer.fill > 0) {
+        writer.ok = timedWrite(writer.fd, writer.buffer, writer.fill) == writer.fill;
+        writer.fill = 0;
+    }
+    if (::close(writer.fd) != 0) {
+        writer.ok = false;
+    }
+    writer.fd = -1;
+    if (writer.ok && writer.reserved > writer.written &&
+        ::truncate(writer.fullPath.c_str(), static_cast<off_t>(writer.written)) != 0) {
+        PXLCAM_LOGW_TAG(kLogTag, "Could not trim %s to %u bytes (%u reserved)", writer.fullPath.c_str(),
+                        static_cast<unsigned>(writer.written), static_cast<unsigned>(writer.reserved));
+    }
+    return writer.ok;
+}
+
 bool writeBufferToFile(const std::string &path, const uint8_t *data, size_t length) {
     if (!ensureParentDirectories(path)) {
         return false;
     }
 
-    File file = SD_MMC.open(path.c_str(), FILE_WRITE);
-    if (!file) {
-        PXLCAM_LOGE_TAG(kLogTag, "Failed to open file for writing: %s", path.c_str());
+    AlignedWriter writer;
+    if (!alignedOpen(writer, path, g_fileBuffer, length)) {
         return false;
     }
 
-    const size_t written = file.write(data, length);
-    file.close();
+    alignedAppend(writer, data, length);
+    if (!alignedClose(writer)) {
+        PXLCAM_LOGE_TAG(kLogTag, "Incomplete write (%u/%u bytes) to %s", static_cast<unsigned>(writer.written), static_cast<unsigned>(length), path.c_str());
+        SD_MMC.remove(path.c_str());
+        return false;
+    }
 
-    if (written != length) {
-        PXLCAM_LOGE_TAG(kLogTag, "Incomplete write (%u/%u bytes) to %s", static_cast<unsigned>(written), static_cast<unsigned>(length), path.c_str());
+    g_writeStats.files++;
+    return true;
+}
+
+// Add one length-byte record at the end of path. A file that ends in a
+// partial record (an append cut short by a power loss) is trimmed back to
+// its last whole record first, so records stay at multiples of length.
+bool appendRecordToFile(const std::string &path, const uint8_t *data, size_t length) {
+    if (!ensureParentDirectories(path)) {
+        return false;
+    }
+
+    // Trimmed by path before opening (the FAT VFS may lack ftruncate())
+    const std::string fullPath = std::string(resolveMountPoint(g_config)) + path;
+    struct stat st;
+    if (::stat(fullPath.c_str(), &st) == 0) {
+        const off_t end = st.st_size;
+        const off_t whole = end - end % static_cast<off_t>(length);
+        if (whole != end) {
+            PXLCAM_LOGW_TAG(kLogTag, "Dropping %u-byte partial record in %s", static_cast<unsigned>(end - whole), path.c_str());
+            if (::truncate(fullPath.c_str(), whole) != 0) {
+                PXLCAM_LOGE_TAG(kLogTag, "Could not trim %s, record not appended", path.c_str());
+                return false;
+            }
+        }
+    }
+
+    const int fd = ::open(fullPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0666);
+    if (fd < 0) {
+        PXLCAM_LOGE_TAG(kLogTag, "Failed to open file for appending: %s", path.c_str());
+        return false;
+    }
+
+    bool ok = timedWrite(fd, data, length) == length;
+    if (::close(fd) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        PXLCAM_LOGE_TAG(kLogTag, "Record append failed for %s", path.c_str());
+    }
+    return ok;
+}
+
+// Sequential write then read-back of PXLCAM_SD_BENCH_BYTES; false on any
+// short transfer or mismatch. Each chunk carries its index so a stale or
+// misplaced sector doesn't verify.
+bool benchmarkBus(float &writeMBps, float &readMBps) {
+    uint8_t *buffer = static_cast<uint8_t *>(heap_caps_malloc(kBenchChunk, MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+    if (buffer == nullptr) {
+        PXLCAM_LOGE_TAG(kLogTag, "No DMA memory for the SD benchmark");
+        return false;
+    }
+    const size_t chunks = PXLCAM_SD_BENCH_BYTES / kBenchChunk > 0 ? PXLCAM_SD_BENCH_BYTES / kBenchChunk : 1;
+    const size_t total = chunks * kBenchChunk;
+    bool ok = true;
+
+    File file = SD_MMC.open(kBenchPath, FILE_WRITE);
+    ok = static_cast<bool>(file);
+    const uint32_t writeStart = micros();
+    for (size_t i = 0; ok && i < chunks; i++) {
+        for (size_t j = 0; j < kBenchChunk; j++) {
+            buffer[j] = static_cast<uint8_t>(j ^ (j >> 8) ^ i);
+        }
+        ok = file.write(buffer, kBenchChunk) == kBenchChunk;
+    }
+    if (file) {
+        file.close();  // Includes the final flush to the card
+    }
+    const uint32_t writeUs = micros() - writeStart;
+
+    uint32_t readUs = 0;
+    if (ok) {
+        file = SD_MMC.open(kBenchPath, FILE_READ);
+        ok = static_cast<bool>(file);
+        const uint32_t readStart = micros();
+        for (size_t i = 0; ok && i < chunks; i++) {
+            ok = file.read(buffer, kBenchChunk) == kBenchChunk;
+            for (size_t j = 0; ok && j < kBenchChunk; j++) {
+                ok = buffer[j] == static_cast<uint8_t>(j ^ (j >> 8) ^ i);
+            }
+        }
+        readUs = micros() - readStart;
+        if (file) {
+            file.close();
+        }
+    }
+
+    SD_MMC.remove(kBenchPath);
+    heap_caps_free(buffer);
+    if (!ok) {
+        return false;
+    }
+
+    // bytes / µs == MB/s
+    writeMBps = writeUs > 0 ? static_cast<float>(total) / writeUs : 0.0f;
+    readMBps = readUs > 0 ? static_cast<float>(total) / readUs : 0.0f;
+    return true;
+}
+
+void writerTask(void *) {
+    WriteJob job;
+    while (xQueueReceive(g_jobQueue, &job, portMAX_DELAY) == pdTRUE && job.data != nullptr) {
+        {
+            SdLock lock;
+            job.ok = job.append ? appendRecordToFile(job.path, job.data, job.length)
+                                : writeBufferToFile(job.path, job.data, job.length);
+        }
+        heap_caps_free(job.data);
+        job.data = nullptr;
+        xQueueSend(g_doneQueue, &job, portMAX_DELAY);
+    }
+    g_writerTask = nullptr;
+    vTaskDelete(nullptr);
+}
+
+bool startWriter() {
+    g_sdLock = xSemaphoreCreateMutex();
+    g_jobSlots = xSemaphoreCreateCounting(PXLCAM_SD_WRITE_QUEUE_DEPTH, PXLCAM_SD_WRITE_QUEUE_DEPTH);
+    g_jobQueue = xQueueCreate(PXLCAM_SD_WRITE_QUEUE_DEPTH + 1, sizeof(WriteJob));  // + stop request
+    g_doneQueue = xQueueCreate(PXLCAM_SD_WRITE_QUEUE_DEPTH, sizeof(WriteJob));
+    if (g_sdLock == nullptr || g_jobSlots == nullptr || g_jobQueue == nullptr || g_doneQueue == nullptr ||
+        xTaskCreatePinnedToCore(writerTask, "sd_writer", PXLCAM_SD_WRITER_STACK, nullptr,
+                                PXLCAM_SD_WRITER_PRIORITY, &g_writerTask, PXLCAM_SD_WRITER_CORE) != pdPASS) {
+        g_writerTask = nullptr;
+        PXLCAM_LOGW_TAG(kLogTag, "Background writer unavailable; saves run inline");
+        return false;
+    }
+    return true;
+}
+
+void stopWriter() {
+    if (g_writerTask != nullptr) {
+        // FIFO: everything queued before the stop request is written first
+        WriteJob stop{};
+        xQueueSend(g_jobQueue, &stop, portMAX_DELAY);
+        const uint32_t start = millis();
+        while (g_writerTask != nullptr && millis() - start < kWriterStopMs) {
+            delay(10);
+        }
+        if (g_writerTask != nullptr) {
+            PXLCAM_LOGE_TAG(kLogTag, "Background writer did not stop; keeping its queues");
+            return;
+        }
+    }
+    pollWrites();
+
+    if (g_jobQueue != nullptr) vQueueDelete(g_jobQueue);
+    if (g_doneQueue != nullptr) vQueueDelete(g_doneQueue);
+    if (g_jobSlots != nullptr) vSemaphoreDelete(g_jobSlots);
+    if (g_sdLock != nullptr) vSemaphoreDelete(g_sdLock);
+    g_jobQueue = g_doneQueue = nullptr;
+    g_jobSlots = g_sdLock = nullptr;
+}
+
+// Copy data into an owned buffer and hand it to the writer task
+bool queueJob(const char *caller, const char *relativePath, const uint8_t *data, size_t length,
+              WriteCallback callback, void *user, uint32_t waitMs, bool append) {
+    if (!g_initialized || g_writerTask == nullptr) {
+        return false;
+    }
+
+    if (relativePath == nullptr || data == nullptr || length == 0) {
+        PXLCAM_LOGE_TAG(kLogTag, "Invalid arguments supplied to %s", caller);
+        return false;
+    }
+
+    if (g_config.maxFileSizeBytes != 0 && length > g_config.maxFileSizeBytes) {
+        PXLCAM_LOGE_TAG(kLogTag, "Buffer exceeds maxFileSizeBytes (%u > %u)", static_cast<unsigned>(length), static_cast<unsigned>(g_config.maxFileSizeBytes));
         return false;
     }
 
+    const std::string path = sanitizePath(relativePath);
+    if (path.empty() || path.size() >= kMaxJobPath) {
+        PXLCAM_LOGE_TAG(kLogTag, "Could not queue path for %s: %s", caller, relativePath);
+        return false;
+    }
+
+    // Backpressure: a full queue holds the caller until the card catches up
+    if (xSemaphoreTake(g_jobSlots, pdMS_TO_TICKS(waitMs)) != pdTRUE) {
+        PXLCAM_LOGW_TAG(kLogTag, "Write queue full (%u images) after %lu ms", static_cast<unsigned>(PXLCAM_SD_WRITE_QUEUE_DEPTH), static_cast<unsigned long>(waitMs));
+        return false;
+    }
+
+    WriteJob job{};
+    job.data = static_cast<uint8_t *>(heap_caps_malloc(length, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (job.data == nullptr) {
+        job.data = static_cast<uint8_t *>(heap_caps_malloc(length, MALLOC_CAP_8BIT));
+    }
+    if (job.data == nullptr) {
+        PXLCAM_LOGE_TAG(kLogTag, "No memory to queue %u bytes", static_cast<unsigned>(length));
+        xSemaphoreGive(g_jobSlots);
+        return false;
+    }
+    memcpy(job.data, data, length);
+    memcpy(job.path, path.c_str(), path.size() + 1);
+    job.length = length;
+    job.callback = callback;
+    job.user = user;
+    job.append = append;
+
+    // Cannot block: the queue has a place for every token plus the stop request
+    xQueueSend(g_jobQueue, &job, portMAX_DELAY);
+    PXLCAM_TRACE_COUNTER(SdQueue, pendingWrites());
     return true;
 }
 
@@ -85,18 +582,78 @@ bool initSD(const StorageConfig &config) {
     }
 
     const char *mountPoint = resolveMountPoint(config);
-    constexpr bool kMode1Bit = true;               // ESP32-CAM shares pins with camera, prefer 1-bit mode.
     constexpr bool kFormatOnFail = false;          // Avoid accidental formatting; surface errors instead.
-    constexpr int kDefaultFrequency = SDMMC_FREQ_DEFAULT;
 
-    if (!SD_MMC.begin(mountPoint, kMode1Bit, kFormatOnFail, kDefaultFrequency)) {
-        PXLCAM_LOGE_TAG(kLogTag, "Failed to mount SD_MMC at %s", mountPoint);
-        return false;
+    // Fastest first; the last entry is the conservative setting that was
+    // always used before (ESP32-CAM shares pins with the camera, so 1-bit)
+    static const BusCandidate kCandidates[] = {
+        {false, SDMMC_FREQ_HIGHSPEED},
+        {false, SDMMC_FREQ_DEFAULT},
+        {true, SDMMC_FREQ_HIGHSPEED},
+        {true, SDMMC_FREQ_DEFAULT},
+    };
+
+    g_status = StorageStatus{};
+
+    // Deep-sleep wake: the card and bus have not changed since the last probe
+    if (config.quickMount && g_busCache.valid) {
+        g_status.candidatesTried = 1;
+        if (SD_MMC.begin(mountPoint, g_busCache.mode1Bit, kFormatOnFail, g_busCache.frequencyKHz) &&
+            SD_MMC.cardType() != CARD_NONE) {
+            g_status.mounted = true;
+            g_status.mode1Bit = g_busCache.mode1Bit;
+            g_status.frequencyKHz = g_busCache.frequencyKHz;
+        } else {
+            PXLCAM_LOGW_TAG(kLogTag, "Quick mount failed, probing the bus again");
+            SD_MMC.end();
+            g_busCache.valid = false;
+        }
     }
 
-    if (SD_MMC.cardType() == CARD_NONE) {
-        PXLCAM_LOGE_TAG(kLogTag, "No SD card detected on SD_MMC bus");
-        SD_MMC.end();
+    for (const BusCandidate &bus : kCandidates) {
+        if (g_status.mounted) {
+            break;
+        }
+        if (!bus.mode1Bit && !(config.probeBus && config.allow4Bit)) {
+            continue;
+        }
+        if (bus.frequencyKHz != SDMMC_FREQ_DEFAULT && !config.probeBus) {
+            continue;
+        }
+        g_status.candidatesTried++;
+
+        if (!SD_MMC.begin(mountPoint, bus.mode1Bit, kFormatOnFail, bus.frequencyKHz)) {
+            PXLCAM_LOGW_TAG(kLogTag, "Mount failed (%s, %d kHz)", bus.mode1Bit ? "1-bit" : "4-bit", bus.frequencyKHz);
+            continue;
+        }
+
+        if (SD_MMC.cardType() == CARD_NONE) {
+            PXLCAM_LOGE_TAG(kLogTag, "No SD card detected on SD_MMC bus");
+            SD_MMC.end();
+            return false;
+        }
+
+        // Replaces the old one-line .sdtest: exercises the bus with real
+        // transfers and catches the CRC errors a too-fast clock produces
+        float writeMBps = 0.0f;
+        float readMBps = 0.0f;
+        if (!benchmarkBus(writeMBps, readMBps)) {
+            PXLCAM_LOGW_TAG(kLogTag, "SD I/O test failed (%s, %d kHz), falling back", bus.mode1Bit ? "1-bit" : "4-bit", bus.frequencyKHz);
+            SD_MMC.end();
+            continue;
+        }
+
+        g_status.mounted = true;
+        g_status.mode1Bit = bus.mode1Bit;
+        g_status.frequencyKHz = bus.frequencyKHz;
+        g_status.writeMBps = writeMBps;
+        g_status.readMBps = readMBps;
+        g_busCache = BusCache{true, bus.mode1Bit, bus.frequencyKHz};
+        break;
+    }
+
+    if (!g_status.mounted) {
+        PXLCAM_LOGE_TAG(kLogTag, "Failed to mount SD_MMC at %s (%u bus settings tried)", mountPoint, g_status.candidatesTried);
         return false;
     }
 
@@ -104,42 +661,30 @@ bool initSD(const StorageConfig &config) {
     if (!SD_MMC.exists("/DCIM") && !SD_MMC.mkdir("/DCIM")) {
         PXLCAM_LOGE_TAG(kLogTag, "Failed to create /DCIM directory");
         SD_MMC.end();
+        g_status.mounted = false;
         return false;
     }
 
-    // ==========================================================================
-    // STABILITY FIX: Validate SD I/O with real write test
-    // ==========================================================================
-    {
-        const char* testPath = "/.sdtest";
-        File testFile = SD_MMC.open(testPath, FILE_WRITE);
-        if (!testFile) {
-            PXLCAM_LOGE_TAG(kLogTag, "SD I/O test FAILED - cannot create test file");
-            SD_MMC.end();
-            return false;
-        }
-        
-        size_t written = testFile.println("PXLcam SD test");
-        testFile.close();
-        
-        if (written == 0) {
-            PXLCAM_LOGE_TAG(kLogTag, "SD I/O test FAILED - write returned 0 bytes");
-            SD_MMC.end();
-            return false;
-        }
-        
-        // Cleanup test file
-        SD_MMC.remove(testPath);
-        PXLCAM_LOGI_TAG(kLogTag, "SD I/O test PASSED");
-    }
+    // Another card may hold other folders
+    clearDirectoryCache();
+    cacheDirectory("/DCIM");
 
     g_config = config;
     g_initialized = true;
+    allocWriteBuffers();
+    startWriter();
 
-    PXLCAM_LOGI_TAG(kLogTag, "SD_MMC mounted at %s (size=%lluMB)", mountPoint, static_cast<unsigned long long>(SD_MMC.cardSize() / (1024ULL * 1024ULL)));
+    PXLCAM_LOGI_TAG(kLogTag, "SD_MMC mounted at %s (size=%lluMB, %s @ %d kHz, write %.2f MB/s, read %.2f MB/s)",
+                    mountPoint, static_cast<unsigned long long>(SD_MMC.cardSize() / (1024ULL * 1024ULL)),
+                    g_status.mode1Bit ? "1-bit" : "4-bit", g_status.frequencyKHz,
+                    static_cast<double>(g_status.writeMBps), static_cast<double>(g_status.readMBps));
     return true;
 }
 
+StorageStatus getStorageStatus() {
+    return g_status;
+}
+
 bool saveFile(const char *relativePath, const uint8_t *data, size_t length) {
     if (!g_initialized) {
         PXLCAM_LOGE_TAG(kLogTag, "saveFile called before initSD");
@@ -162,6 +707,7 @@ bool saveFile(const char *relativePath, const uint8_t *data, size_t length) {
         return false;
     }
 
+    SdLock lock;
     return writeBufferToFile(path, data, length);
 }
 
@@ -173,12 +719,207 @@ bool saveFile(const char *relativePath, const camera_fb_t *frame) {
     return saveFile(relativePath, frame->buf, frame->len);
 }
 
+bool beginStream(const char *relativePath, size_t expectedSize) {
+    if (!g_initialized) {
+        PXLCAM_LOGE_TAG(kLogTag, "beginStream called before initSD");
+        return false;
+    }
+
+    if (g_stream.fd >= 0) {
+        PXLCAM_LOGW_TAG(kLogTag, "beginStream: closing stale stream %s", g_streamPath.c_str());
+        endStream();
+    }
+
+    SdLock lock;
+    g_streamPath = sanitizePath(relativePath);
+    if (g_streamPath.empty() || !ensureParentDirectories(g_streamPath)) {
+        return false;
+    }
+
+    return alignedOpen(g_stream, g_streamPath, g_streamBuffer, expectedSize);
+}
+
+bool appendStream(const uint8_t *data, size_t length) {
+    if (g_stream.fd < 0 || !g_stream.ok) {
+        return false;
+    }
+
+    if (g_config.maxFileSizeBytes != 0 && g_stream.written + length > g_config.maxFileSizeBytes) {
+        PXLCAM_LOGE_TAG(kLogTag, "Stream exceeds maxFileSizeBytes (%u bytes)", static_cast<unsigned>(g_config.maxFileSizeBytes));
+        g_stream.ok = false;
+        return false;
+    }
+
+    SdLock lock;
+    if (!alignedAppend(g_stream, data, length)) {
+        PXLCAM_LOGE_TAG(kLogTag, "Write failed at %u bytes into %s", static_cast<unsigned>(g_stream.written), g_streamPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool patchStream(size_t offset, const uint8_t *data, size_t length) {
+    if (g_stream.fd < 0) {
+        return false;
+    }
+
+    SdLock lock;
+    if (!alignedPatch(g_stream, offset, data, length)) {
+        PXLCAM_LOGE_TAG(kLogTag, "Patch at %u failed in %s", static_cast<unsigned>(offset), g_streamPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool syncStream() {
+    if (g_stream.fd < 0) {
+        return false;
+    }
+
+    SdLock lock;
+    if (!alignedSync(g_stream)) {
+        PXLCAM_LOGE_TAG(kLogTag, "Sync failed for %s", g_streamPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool endStream(bool keepOnError) {
+    if (g_stream.fd < 0) {
+        return false;
+    }
+
+    SdLock lock;
+    const bool ok = alignedClose(g_stream);
+    if (!ok && !keepOnError) {
+        SD_MMC.remove(g_streamPath.c_str());
+    } else {
+        g_writeStats.files++;
+    }
+    return ok;
+}
+
+size_t streamBytesWritten() {
+    return g_stream.written;
+}
+
+bool saveFileAsync(const char *relativePath, const uint8_t *data, size_t length,
+                   WriteCallback callback, void *user, uint32_t waitMs) {
+    return queueJob("saveFileAsync", relativePath, data, length, callback, user, waitMs, false);
+}
+
+bool appendRecord(const char *relativePath, const uint8_t *record, size_t length) {
+    if (!g_initialized) {
+        PXLCAM_LOGE_TAG(kLogTag, "appendRecord called before initSD");
+        return false;
+    }
+
+    if (relativePath == nullptr || record == nullptr || length == 0) {
+        PXLCAM_LOGE_TAG(kLogTag, "Invalid arguments supplied to appendRecord");
+        return false;
+    }
+
+    const std::string path = sanitizePath(relativePath);
+    if (path.empty()) {
+        PXLCAM_LOGE_TAG(kLogTag, "Could not sanitise path for appendRecord");
+        return false;
+    }
+
+    SdLock lock;
+    return appendRecordToFile(path, record, length);
+}
+
+bool appendRecordAsync(const char *relativePath, const uint8_t *record, size_t length,
+                       WriteCallback callback, void *user, uint32_t waitMs) {
+    return queueJob("appendRecordAsync", relativePath, record, length, callback, user, waitMs, true);
+}
+
+void pollWrites() {
+    if (g_doneQueue == nullptr) {
+        return;
+    }
+
+    WriteJob job;
+    while (xQueueReceive(g_doneQueue, &job, 0) == pdTRUE) {
+        if (job.callback != nullptr) {
+            job.callback(job.path, job.ok, job.user);
+        }
+        xSemaphoreGive(g_jobSlots);
+        PXLCAM_TRACE_COUNTER(SdQueue, pendingWrites());
+    }
+}
+
+bool flushWrites(uint32_t timeoutMs) {
+    const uint32_t start = millis();
+    while (true) {
+        pollWrites();
+        if (pendingWrites() == 0) {
+            return true;
+        }
+        if (millis() - start >= timeoutMs) {
+            return false;
+        }
+        delay(5);
+    }
+}
+
+uint8_t pendingWrites() {
+    if (g_jobSlots == nullptr) {
+        return 0;
+    }
+    return static_cast<uint8_t>(PXLCAM_SD_WRITE_QUEUE_DEPTH - uxSemaphoreGetCount(g_jobSlots));
+}
+
+bool isWriterRunning() {
+    return g_writerTask != nullptr;
+}
+
+uint32_t nextFileNumber() {
+    if (g_nextFileNumber == 0) {
+        g_reservedFileNumber = nvs::readU32(nvs::keys::kLastFileNum, 0);
+        g_nextFileNumber = g_reservedFileNumber + 1;
+    }
+
+    // Reserve the next batch before handing out a number NVS doesn't cover
+    if (g_nextFileNumber > g_reservedFileNumber) {
+        const uint32_t reserved = g_nextFileNumber + PXLCAM_FILE_NUMBER_BATCH - 1;
+        if (nvs::writeU32(nvs::keys::kLastFileNum, reserved)) {
+            g_reservedFileNumber = reserved;
+        } else {
+            PXLCAM_LOGW_TAG(kLogTag, "File number not persisted; numbers may repeat after reset");
+        }
+    }
+    return g_nextFileNumber++;
+}
+
+void captureFolder(uint32_t number, char *out, size_t size) {
+    const uint32_t folder = 100 + (number > 0 ? (number - 1) / PXLCAM_FILES_PER_FOLDER : 0);
+    snprintf(out, size, "/DCIM/%03luPXLCM", static_cast<unsigned long>(folder));
+}
+
+WriteStats getWriteStats() {
+    return g_writeStats;
+}
+
 void shutdownSD() {
     if (!g_initialized) {
         return;
     }
 
+    if (g_stream.fd >= 0) {
+        g_stream.ok = false;
+        endStream();
+    }
+
+    // Queued images are written (and reported) before the card goes away
+    stopWriter();
+    if (g_writerTask == nullptr) {
+        freeWriteBuffers();
+    }
+
     SD_MMC.end();
+    clearDirectoryCache();
+    g_status.mounted = false;
     g_initialized = false;
     g_config = StorageConfig{};
 
@@ -0,0 +1,99 @@
+/**
+ * @file thumbnail_index.cpp
+ * @brief Per-folder thumbnail sidecar (THUMBS.IDX)
+ */
+
+#include "thumbnail_index.h"
+
+#include "logging.h"
+#include "pxlcam_config.h"
+#include "storage.h"
+
+#include <FS.h>
+#include <SD_MMC.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace pxlcam::thumbs {
+
+namespace {
+
+constexpr const char* kLogTag = "thumbs";
+constexpr char kMagic[4] = { 'P', 'X', 'T', '1' };
+
+}  // namespace
+
+void indexPath(const char* folder, char* out, size_t size) {
+    snprintf(out, size, "%s/%s", folder, kIndexName);
+}
+
+bool append(const char* path, size_t fileSize, uint16_t width, uint16_t height,
+            const uint8_t* pages, uint32_t waitMs) {
+    const char* slash = path ? strrchr(path, '/') : nullptr;
+    if (!slash || slash == path || !pages) {
+        return false;
+    }
+    const char* name = slash + 1;
+    const size_t nameLen = strlen(name);
+    const size_t folderLen = static_cast<size_t>(slash - path);
+    char index[64];
+    if (nameLen == 0 || nameLen >= kNameMax || folderLen + 1 + strlen(kIndexName) >= sizeof(index)) {
+        PXLCAM_LOGW_TAG(kLogTag, "No thumbnail record for %s (name too long)", path);
+        return false;
+    }
+    snprintf(index, sizeof(index), "%.*s/%s", static_cast<int>(folderLen), path, kIndexName);
+
+    Record record;
+    memset(&record, 0, sizeof(record));
+    memcpy(record.magic, kMagic, sizeof(kMagic));
+    memcpy(record.name, name, nameLen);
+    record.fileSize = static_cast<uint32_t>(fileSize);
+    record.width = width;
+    record.height = height;
+    memcpy(record.pages, pages, kThumbBytes);
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+    if (storage::appendRecordAsync(index, bytes, kRecordSize, nullptr, nullptr, waitMs)) {
+        return true;
+    }
+    return storage::appendRecord(index, bytes, kRecordSize);
+}
+
+uint32_t count(const char* folder) {
+    char path[64];
+    indexPath(folder, path, sizeof(path));
+    File file = SD_MMC.open(path, FILE_READ);
+    if (!file) {
+        return 0;
+    }
+    const uint32_t records = file.isDirectory() ? 0 : static_cast<uint32_t>(file.size() / kRecordSize);
+    file.close();
+    return records;
+}
+
+size_t read(const char* folder, uint32_t first, Record* out, size_t max) {
+    if (!out || max == 0) {
+        return 0;
+    }
+    char path[64];
+    indexPath(folder, path, sizeof(path));
+    File file = SD_MMC.open(path, FILE_READ);
+    if (!file) {
+        return 0;
+    }
+
+    size_t records = 0;
+    if (!file.isDirectory() && file.seek(static_cast<uint32_t>(first) * kRecordSize)) {
+        while (records < max &&
+               file.read(reinterpret_cast<uint8_t*>(out + records), kRecordSize) == kRecordSize &&
+               memcmp(out[records].magic, kMagic, sizeof(kMagic)) == 0) {
+            out[records].name[kNameMax - 1] = '\0';
+            records++;
+        }
+    }
+    file.close();
+    return records;
+}
+
+}  // namespace pxlcam::thumbs
@@ -10,8 +10,49 @@
 
 #if PXLCAM_FEATURE_TIMELAPSE
 
+#include <esp_attr.h>
+#include <sys/time.h>
+
 namespace pxlcam {
 
+namespace {
+
+constexpr uint32_t kRtcRunMagic = 0x504C5452;  // "PLTR"
+
+/// A run across deep sleeps. Plain fields only: RTC_DATA_ATTR memory keeps
+/// its contents through a deep sleep and is reloaded from the image on any
+/// other boot, so a constructor must not run over it.
+struct RtcRun {
+    uint32_t magic;             ///< kRtcRunMagic while a run is suspended
+    uint32_t intervalMs;
+    uint32_t maxFrames;
+    uint32_t durationMs;
+    uint32_t framesCaptured;
+    uint32_t nextIndex;         ///< Frame whose deadline is next
+    uint32_t elapsedMs;         ///< Run time when the sleep started
+    int64_t suspendedUs;        ///< RTC clock then (gettimeofday, kept in deep sleep)
+    uint64_t latenessSumMs;
+    uint32_t latenessFrames;
+    uint32_t lastLatenessMs;
+    uint32_t maxLatenessMs;
+    uint32_t deadlinesSkipped;
+    uint8_t mode;
+    uint8_t powerMode;
+    uint8_t latePolicy;
+    uint8_t applyStyleFilter;
+    uint8_t showCountdown;
+};
+
+RTC_DATA_ATTR RtcRun g_rtcRun;
+
+int64_t rtcClockUs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000LL + tv.tv_usec;
+}
+
+} // anonymous namespace
+
 // =============================================================================
 // Singleton
 // =============================================================================
@@ -27,7 +68,11 @@ TimelapseController& TimelapseController::instance() {
 
 TimelapseController::TimelapseController()
     : m_startTime(0)
+    , m_nextIndex(0)
     , m_lastCaptureTime(0)
+    , m_pausedAt(0)
+    , m_latenessSumMs(0)
+    , m_latenessFrames(0)
     , m_captureCallback(nullptr)
 {
     m_config = TimelapseConfig();
@@ -67,6 +112,9 @@ void TimelapseController::setConfig(const TimelapseConfig& config) {
     if (m_config.intervalMs < 1000) {
         m_config.intervalMs = 1000;
     }
+    if (m_config.mode == TimelapseMode::BURST) {
+        m_config.maxFrames = m_config.burstFrames;
+    }
 }
 
 const TimelapseConfig& TimelapseController::getConfig() const {
@@ -79,13 +127,21 @@ bool TimelapseController::begin() {
     }
     
     m_startTime = millis();
-    m_lastCaptureTime = 0;
+    m_nextIndex = 0;
+    m_lastCaptureTime = m_startTime;
+    m_latenessSumMs = 0;
+    m_latenessFrames = 0;
     
     m_status.running = true;
     m_status.paused = false;
     m_status.framesCaptured = 0;
     m_status.elapsedMs = 0;
+    m_status.nextCaptureMs = 0;
     m_status.lastCaptureOk = true;
+    m_status.lastLatenessMs = 0;
+    m_status.maxLatenessMs = 0;
+    m_status.meanLatenessMs = 0;
+    m_status.deadlinesSkipped = 0;
     
     if (m_config.maxFrames > 0) {
         m_status.framesRemaining = m_config.maxFrames;
@@ -93,30 +149,28 @@ bool TimelapseController::begin() {
         m_status.framesRemaining = 0xFFFFFFFF;
     }
     
-    // First capture is immediate
-    if (m_captureCallback) {
-        m_captureCallback();
-    }
-    
+    // Frame 0 is due now; tick() takes it
     return true;
 }
 
 void TimelapseController::stop() {
     m_status.running = false;
     m_status.paused = false;
+    g_rtcRun.magic = 0;  // A later timer wake starts fresh
 }
 
 void TimelapseController::pause() {
-    if (m_status.running) {
+    if (m_status.running && !m_status.paused) {
         m_status.paused = true;
+        m_pausedAt = millis();
     }
 }
 
 void TimelapseController::resume() {
     if (m_status.running && m_status.paused) {
         m_status.paused = false;
-        // Adjust timing so next capture is relative to resume time
-        m_lastCaptureTime = millis();
+        // The paused time does not count: every deadline moves by it
+        m_startTime += millis() - m_pausedAt;
     }
 }
 
@@ -146,22 +200,21 @@ void TimelapseController::tick() {
         return;
     }
     
-    // Calculate time to next capture
-    uint32_t timeSinceLast = now - m_lastCaptureTime;
-    if (timeSinceLast >= m_config.intervalMs) {
-        m_status.nextCaptureMs = 0;
-    } else {
-        m_status.nextCaptureMs = m_config.intervalMs - timeSinceLast;
-    }
+    m_status.nextCaptureMs = getTimeToNextCapture();
+    m_status.lastCaptureMs = now - m_lastCaptureTime;
     
-    // Update remaining time estimate
+    // Update remaining time estimate: the next deadline, then one interval per frame
     if (m_config.maxFrames > 0) {
         uint32_t remaining = m_config.maxFrames - m_status.framesCaptured;
-        m_status.remainingMs = remaining * m_config.intervalMs;
+        const uint32_t spacing = m_config.mode == TimelapseMode::BURST
+            ? m_config.burstIntervalMs : m_config.intervalMs;
+        m_status.remainingMs = remaining > 0
+            ? m_status.nextCaptureMs + (remaining - 1) * spacing : 0;
     }
     
     // Check if should capture
     if (shouldCapture() && m_captureCallback) {
+        onCaptureStart();
         m_captureCallback();
     }
 }
@@ -169,16 +222,46 @@ void TimelapseController::tick() {
 bool TimelapseController::shouldCapture() const {
     if (!m_status.running || m_status.paused) return false;
     
-    uint32_t now = millis();
+    // Motion runs have no deadlines; their captures come from the trigger
+    if (m_config.mode == TimelapseMode::MOTION_TRIGGERED) return false;
     
-    // First frame (lastCaptureTime == 0) was already captured in begin()
-    if (m_lastCaptureTime == 0) return false;
+    // A burst has one deadline, its start
+    if (m_config.mode == TimelapseMode::BURST) return m_nextIndex == 0;
     
-    return (now - m_lastCaptureTime) >= m_config.intervalMs;
+    // Signed: correct across the millis() wrap
+    return static_cast<int32_t>(millis() - deadline(m_nextIndex)) >= 0;
+}
+
+void TimelapseController::onCaptureStart() {
+    const uint32_t now = millis();
+    m_lastCaptureTime = now;
+    if (m_config.mode == TimelapseMode::MOTION_TRIGGERED) {
+        return;  // Not late for anything
+    }
+    
+    if (m_config.latePolicy == TimelapseLatePolicy::SKIP &&
+        static_cast<int32_t>(now - m_startTime) >= 0) {
+        // The latest deadline that has passed is the one this frame is for
+        const uint32_t latest = (now - m_startTime) / m_config.intervalMs;
+        if (latest > m_nextIndex) {
+            m_status.deadlinesSkipped += latest - m_nextIndex;
+            m_nextIndex = latest;
+        }
+    }
+    
+    const int32_t late = static_cast<int32_t>(now - deadline(m_nextIndex));
+    const uint32_t lateness = late > 0 ? static_cast<uint32_t>(late) : 0;
+    m_latenessSumMs += lateness;
+    m_latenessFrames++;
+    m_status.lastLatenessMs = lateness;
+    m_status.maxLatenessMs = max(m_status.maxLatenessMs, lateness);
+    m_status.meanLatenessMs = static_cast<uint32_t>(m_latenessSumMs / m_latenessFrames);
+    
+    m_nextIndex++;
+    m_status.nextCaptureMs = getTimeToNextCapture();
 }
 
 void TimelapseController::onCaptureComplete(bool success) {
-    m_lastCaptureTime = millis();
     m_status.lastCaptureOk = success;
     
     if (success) {
@@ -187,8 +270,6 @@ void TimelapseController::onCaptureComplete(bool success) {
             m_status.framesRemaining--;
         }
     }
-    
-    m_status.lastCaptureMs = 0;
 }
 
 TimelapseStatus TimelapseController::getStatus() const {
@@ -200,7 +281,14 @@ uint32_t TimelapseController::getFramesCaptured() const {
 }
 
 uint32_t TimelapseController::getTimeToNextCapture() const {
-    return m_status.nextCaptureMs;
+    if (m_config.mode == TimelapseMode::MOTION_TRIGGERED || m_config.mode == TimelapseMode::BURST) {
+        return 0;
+    }
+    if (!m_status.running || m_status.paused) {
+        return m_status.nextCaptureMs;
+    }
+    const int32_t until = static_cast<int32_t>(deadline(m_nextIndex) - millis());
+    return until > 0 ? static_cast<uint32_t>(until) : 0;
 }
 
 uint8_t TimelapseController::getProgress() const {
@@ -213,6 +301,74 @@ void TimelapseController::onCapture(CaptureCallback callback) {
     m_captureCallback = callback;
 }
 
+void TimelapseController::suspendToRtc() {
+    g_rtcRun.intervalMs = m_config.intervalMs;
+    g_rtcRun.maxFrames = m_config.maxFrames;
+    g_rtcRun.durationMs = m_config.durationMs;
+    g_rtcRun.framesCaptured = m_status.framesCaptured;
+    g_rtcRun.nextIndex = m_nextIndex;
+    g_rtcRun.elapsedMs = millis() - m_startTime;
+    g_rtcRun.suspendedUs = rtcClockUs();
+    g_rtcRun.latenessSumMs = m_latenessSumMs;
+    g_rtcRun.latenessFrames = m_latenessFrames;
+    g_rtcRun.lastLatenessMs = m_status.lastLatenessMs;
+    g_rtcRun.maxLatenessMs = m_status.maxLatenessMs;
+    g_rtcRun.deadlinesSkipped = m_status.deadlinesSkipped;
+    g_rtcRun.mode = static_cast<uint8_t>(m_config.mode);
+    g_rtcRun.powerMode = static_cast<uint8_t>(m_config.powerMode);
+    g_rtcRun.latePolicy = static_cast<uint8_t>(m_config.latePolicy);
+    g_rtcRun.applyStyleFilter = m_config.applyStyleFilter;
+    g_rtcRun.showCountdown = m_config.showCountdown;
+    g_rtcRun.magic = m_status.running ? kRtcRunMagic : 0;
+}
+
+bool TimelapseController::resumeFromRtc() {
+    if (g_rtcRun.magic != kRtcRunMagic) {
+        return false;
+    }
+    
+    m_config.mode = static_cast<TimelapseMode>(g_rtcRun.mode);
+    m_config.intervalMs = g_rtcRun.intervalMs;
+    m_config.maxFrames = g_rtcRun.maxFrames;
+    m_config.durationMs = g_rtcRun.durationMs;
+    m_config.powerMode = static_cast<TimelapsePowerMode>(g_rtcRun.powerMode);
+    m_config.latePolicy = static_cast<TimelapseLatePolicy>(g_rtcRun.latePolicy);
+    m_config.applyStyleFilter = g_rtcRun.applyStyleFilter != 0;
+    m_config.showCountdown = g_rtcRun.showCountdown != 0;
+    
+    // Time asleep and booting, from the clock that ran through the sleep
+    const int64_t asleepUs = rtcClockUs() - g_rtcRun.suspendedUs;
+    const uint32_t asleepMs = asleepUs > 0 ? static_cast<uint32_t>(asleepUs / 1000) : 0;
+    const uint32_t elapsedMs = g_rtcRun.elapsedMs + asleepMs;
+    const uint32_t now = millis();
+    m_startTime = now - elapsedMs;
+    m_nextIndex = g_rtcRun.nextIndex;
+    m_lastCaptureTime = now - asleepMs;
+    m_latenessSumMs = g_rtcRun.latenessSumMs;
+    m_latenessFrames = g_rtcRun.latenessFrames;
+    
+    m_status.running = true;
+    m_status.paused = false;
+    m_status.framesCaptured = g_rtcRun.framesCaptured;
+    m_status.elapsedMs = elapsedMs;
+    m_status.nextCaptureMs = getTimeToNextCapture();
+    m_status.lastCaptureOk = true;
+    m_status.lastLatenessMs = g_rtcRun.lastLatenessMs;
+    m_status.maxLatenessMs = g_rtcRun.maxLatenessMs;
+    m_status.meanLatenessMs = m_latenessFrames > 0
+        ? static_cast<uint32_t>(m_latenessSumMs / m_latenessFrames) : 0;
+    m_status.deadlinesSkipped = g_rtcRun.deadlinesSkipped;
+    m_status.framesRemaining = m_config.maxFrames > 0
+        ? m_config.maxFrames - min(m_status.framesCaptured, m_config.maxFrames)
+        : 0xFFFFFFFF;
+    return true;
+}
+
+uint32_t TimelapseController::deadline(uint32_t index) const {
+    // Modulo 2^32 like millis() itself
+    return m_startTime + static_cast<uint32_t>(static_cast<uint64_t>(index) * m_config.intervalMs);
+}
+
 // =============================================================================
 // Convenience Functions
 // =============================================================================
@@ -13,6 +13,7 @@
 #include "timelapse.h"
 #include "timelapse_settings.h"
 #include "display.h"
+#include "energy_meter.h"
 #include "logging.h"
 
 #include <Arduino.h>
@@ -137,7 +138,7 @@ void drawMenu(Adafruit_SSD1306* disp) {
     disp->setCursor(2, kHintY);
     disp->print("Tap:nav  Hold:OK");
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 bool handleInput(uint32_t& pressStartMs, bool& wasPressed) {
@@ -278,7 +279,7 @@ void showIntervalSelect() {
         disp->setCursor(2, kHintY);
         disp->print("Tap:+  Hold:OK");
         
-        disp->display();
+        pxlcam::display::updateDisplay();
         
         // Handle input
         bool isPressed = readButton();
@@ -339,7 +340,7 @@ void showMaxFramesSelect() {
         disp->setCursor(2, kHintY);
         disp->print("Tap:+  Hold:OK");
         
-        disp->display();
+        pxlcam::display::updateDisplay();
         
         // Handle input
         bool isPressed = readButton();
@@ -425,13 +426,23 @@ void drawActiveScreen() {
     disp->print("Proxima: ");
     disp->print(timeBuf);
     
-    // Elapsed time
-    formatTime(status.elapsedMs, timeBuf, sizeof(timeBuf));
+    // Elapsed time, every other 3 s the energy figures of the run
     disp->setCursor(4, 50);
-    disp->print("Decorrido: ");
-    disp->print(timeBuf);
+    if ((millis() / 3000) & 1) {
+        const energy::Report power = energy::getReport();
+        char energyBuf[24];
+        snprintf(energyBuf, sizeof(energyBuf), "Duty %u%% %lu.%02lumAh/f",
+                 static_cast<unsigned>(power.dutyCycle * 100.0f + 0.5f),
+                 static_cast<unsigned long>(power.uahPerFrame / 1000),
+                 static_cast<unsigned long>(power.uahPerFrame % 1000 / 10));
+        disp->print(energyBuf);
+    } else {
+        formatTime(status.elapsedMs, timeBuf, sizeof(timeBuf));
+        disp->print("Decorrido: ");
+        disp->print(timeBuf);
+    }
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 void drawStartScreen(uint32_t intervalMs, uint32_t maxFrames) {
@@ -465,7 +476,7 @@ void drawStartScreen(uint32_t intervalMs, uint32_t maxFrames) {
     disp->setCursor(20, 52);
     disp->print("Iniciando...");
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 void drawStoppedScreen(uint32_t framesCaptured) {
@@ -491,7 +502,7 @@ void drawStoppedScreen(uint32_t framesCaptured) {
     disp->setCursor(30, 52);
     disp->print("salvos!");
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 char* formatTime(uint32_t ms, char* buf, size_t bufSize) {
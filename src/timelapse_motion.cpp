@@ -0,0 +1,203 @@
+/**
+ * @file timelapse_motion.cpp
+ * @brief Motion trigger for TimelapseMode::MOTION_TRIGGERED runs
+ *
+ * @version 1.3.0
+ */
+
+#include "timelapse_motion.h"
+
+#if PXLCAM_FEATURE_TIMELAPSE
+
+#include "camera_config.h"
+#include "camera_service.h"
+#include "filters/resample.h"
+#include "jpeg_luma.h"
+#include "logging.h"
+#include "motion_detect.h"
+
+#include <Arduino.h>
+#include <esp_camera.h>
+#include <esp_heap_caps.h>
+#include <esp32-hal-psram.h>
+
+#include <cstring>
+#include <new>
+
+namespace pxlcam::timelapse {
+
+namespace {
+
+constexpr const char* kLogTag = "tl_motion";
+
+constexpr int kFrameW = 64;         ///< Detector frame (one block grid of 8x8)
+constexpr int kFrameH = 64;
+constexpr int kMaxSrcW = 160;       ///< Widest watching framesize (QQVGA)
+constexpr int kMaxSrcH = 120;
+constexpr int kBandRows = 16;       ///< Tallest JPEG MCU
+
+motion::MotionDetector* g_detector = nullptr;
+filters::AreaResampler g_resampler;
+uint8_t g_band[kMaxSrcW * kBandRows];
+alignas(4) uint8_t g_gray[kFrameW * kFrameH];
+
+framesize_t g_captureSize = FRAMESIZE_INVALID;
+uint16_t g_watchWidth = 0;
+bool g_active = false;
+frames::ConsumerId g_consumer = frames::kNoConsumer;
+MotionStats g_stats = {};
+
+bool ensureDetector() {
+    if (g_detector) {
+        return true;
+    }
+    void* mem = nullptr;
+    if (psramFound()) {
+        mem = heap_caps_malloc(sizeof(motion::MotionDetector), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (!mem) {
+        mem = malloc(sizeof(motion::MotionDetector));
+    }
+    if (!mem) {
+        PXLCAM_LOGE_TAG(kLogTag, "No memory for the motion detector");
+        return false;
+    }
+    g_detector = new (mem) motion::MotionDetector();
+    
+    motion::MotionDetector::Config config;
+    config.noiseFloor = PXLCAM_MOTION_NOISE_FLOOR;
+    config.noiseFactor = PXLCAM_MOTION_NOISE_FACTOR;
+    config.minBlocks = PXLCAM_MOTION_EVENT_BLOCKS;
+    config.cooldownMs = PXLCAM_MOTION_COOLDOWN_MS;
+    g_detector->begin(kFrameW, kFrameH, config);
+    return true;
+}
+
+// MCUs arrive left to right in bands of up to 16 rows; each finished band
+// goes to the resampler row by row (as in the preview decoder)
+bool bandLumaBlock(void*, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* luma) {
+    if (!luma) {
+        return w <= kMaxSrcW && h <= kMaxSrcH &&
+               g_resampler.begin(w, h, filters::ResampleFormat::GRAY, g_gray, kFrameW, kFrameH, kFrameW);
+    }
+    
+    const int bandW = g_resampler.src_width();
+    if (h > kBandRows || x + w > bandW) {
+        return false;
+    }
+    for (uint16_t row = 0; row < h; row++) {
+        memcpy(g_band + row * bandW + x, luma + row * w, w);
+    }
+    if (x + w == bandW) {
+        for (uint16_t row = 0; row < h && y + row < g_resampler.src_height(); row++) {
+            g_resampler.push_luma_row(g_band + row * bandW);
+        }
+    }
+    return true;
+}
+
+/// Frame to 64x64 luma in g_gray
+bool toGray(const camera_fb_t* fb) {
+    if (fb->format == PIXFORMAT_JPEG) {
+        return jpeg::decodeLumaBlocks(fb->buf, fb->len, bandLumaBlock, nullptr) && g_resampler.done();
+    }
+    
+    filters::ResampleFormat format = filters::ResampleFormat::COUNT;
+    switch (fb->format) {
+        case PIXFORMAT_GRAYSCALE: format = filters::ResampleFormat::GRAY;   break;
+        case PIXFORMAT_YUV422:    format = filters::ResampleFormat::YUV422; break;
+        case PIXFORMAT_RGB565:    format = filters::ResampleFormat::RGB565; break;
+        case PIXFORMAT_RGB888:    format = filters::ResampleFormat::RGB888; break;
+        default:                  return false;
+    }
+    const size_t stride = fb->width * filters::resample_bytes_per_pixel(format);
+    return fb->len >= stride * fb->height &&
+           filters::resample_area(fb->buf, stride, format, fb->width, fb->height,
+                                  g_gray, kFrameW, kFrameH, kFrameW);
+}
+
+} // anonymous namespace
+
+bool motionBegin() {
+    if (g_active) {
+        return true;
+    }
+    sensor_t* sensor = esp_camera_sensor_get();
+    if (!sensor || !ensureDetector()) {
+        return false;
+    }
+    
+    g_captureSize = sensor->status.framesize;
+    if (!setFrameSize(PXLCAM_MOTION_FRAMESIZE, 2)) {
+        g_captureSize = FRAMESIZE_INVALID;
+        return false;
+    }
+    g_watchWidth = resolution[PXLCAM_MOTION_FRAMESIZE].width;
+    g_detector->reset();
+    g_consumer = frames::registerConsumer("motion", frames::Need::Latest);
+    g_active = true;
+    PXLCAM_LOGI_TAG(kLogTag, "Watching for motion (%ux%u)", g_watchWidth,
+                    resolution[PXLCAM_MOTION_FRAMESIZE].height);
+    return true;
+}
+
+bool motionPoll() {
+    if (!g_active) {
+        return false;
+    }
+    
+    const uint32_t start = micros();
+    camera_fb_t* fb = frames::acquire(g_consumer);
+    if (!fb) {
+        return false;
+    }
+    // A frame still of the capture size is left over from before the switch
+    const bool converted = fb->width == g_watchWidth && toGray(fb);
+    frames::release(fb);
+    if (!converted) {
+        return false;
+    }
+    
+    const bool event = g_detector->update(g_gray, millis());
+    g_stats.frames++;
+    g_stats.events = g_detector->getEvents();
+    g_stats.suppressed = g_detector->getSuppressed();
+    g_stats.movingBlocks = g_detector->getMovingBlocks();
+    g_stats.lastFrameUs = micros() - start;
+    
+    if (event) {
+        PXLCAM_LOGI_TAG(kLogTag, "Motion: %u blocks moving (event %lu)",
+                        g_stats.movingBlocks, static_cast<unsigned long>(g_stats.events));
+    }
+    return event;
+}
+
+void motionEnd() {
+    if (!g_active) {
+        return;
+    }
+    g_active = false;
+    frames::unregisterConsumer(g_consumer);
+    g_consumer = frames::kNoConsumer;
+    if (g_captureSize != FRAMESIZE_INVALID) {
+        setFrameSize(g_captureSize, 2);
+    }
+}
+
+bool motionIsActive() {
+    return g_active;
+}
+
+void motionSetZone(int bx0, int by0, int bx1, int by1, uint8_t sensitivity) {
+    if (ensureDetector()) {
+        g_detector->setZone(bx0, by0, bx1, by1, sensitivity);
+    }
+}
+
+MotionStats motionGetStats() {
+    return g_stats;
+}
+
+} // namespace pxlcam::timelapse
+
+#endif // PXLCAM_FEATURE_TIMELAPSE
@@ -10,11 +10,15 @@
 
 #if PXLCAM_FEATURE_TIMELAPSE
 
+#include "button_irq.h"
+#include "energy_meter.h"
 #include "logging.h"
 
 #include <Arduino.h>
+#include <esp_attr.h>
 #include <esp_sleep.h>
 #include <esp_pm.h>
+#include <esp_system.h>
 
 namespace pxlcam::timelapse {
 
@@ -24,6 +28,12 @@ constexpr const char* kLogTag = "tl_power";
 
 bool g_sleepEnabled = true;
 bool g_wasTimerWakeup = false;
+bool g_wasDeepSleepWakeup = false;
+
+constexpr size_t kWakeKinds = static_cast<size_t>(WakeKind::Count);
+
+// Wake-to-ready moving average per sleep kind (0 = not measured yet)
+RTC_DATA_ATTR uint32_t g_readyMs[kWakeKinds];
 
 } // anonymous namespace
 
@@ -40,7 +50,8 @@ void powerInit() {
     
     if (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER) {
         g_wasTimerWakeup = true;
-        PXLCAM_LOGI_TAG(kLogTag, "Woke from timer sleep");
+        g_wasDeepSleepWakeup = esp_reset_reason() == ESP_RST_DEEPSLEEP;
+        PXLCAM_LOGI_TAG(kLogTag, "Woke from timer %s sleep", g_wasDeepSleepWakeup ? "deep" : "light");
     }
     
     PXLCAM_LOGI_TAG(kLogTag, "Power management initialized (sleep %s)",
@@ -52,53 +63,119 @@ bool shouldUseSleep(uint32_t intervalMs) {
     return intervalMs >= kMinSleepIntervalMs;
 }
 
-void enterLightSleep(uint32_t sleepMs) {
+bool enterLightSleep(uint32_t sleepMs) {
     if (!g_sleepEnabled) {
         PXLCAM_LOGW_TAG(kLogTag, "Sleep disabled, skipping");
-        return;
+        return false;
     }
     
     // Subtract wake margin for camera warmup
-    if (sleepMs <= kWakeMarginMs) {
+    const uint32_t marginMs = wakeMarginMs(WakeKind::Light);
+    if (sleepMs <= marginMs) {
         PXLCAM_LOGD_TAG(kLogTag, "Sleep duration too short, skipping");
-        return;
+        return false;
     }
     
-    uint32_t actualSleepMs = sleepMs - kWakeMarginMs;
+    uint32_t actualSleepMs = sleepMs - marginMs;
     uint64_t sleepUs = (uint64_t)actualSleepMs * 1000ULL;
     
     PXLCAM_LOGI_TAG(kLogTag, "Entering light sleep for %lu ms", actualSleepMs);
     
+    // A held button is in use: sleeping would leave its release unseen
+    if (pxlcam::input::isActive() && pxlcam::input::isPressed()) {
+        PXLCAM_LOGD_TAG(kLogTag, "Button held, skipping sleep");
+        return false;
+    }
+    
     // Configure timer wakeup
     esp_err_t err = esp_sleep_enable_timer_wakeup(sleepUs);
     if (err != ESP_OK) {
         PXLCAM_LOGE_TAG(kLogTag, "Failed to set timer wakeup: %d", err);
-        return;
+        return false;
     }
+    // ...and the button, so a press is not held up until the frame is due
+    const bool buttonWake = pxlcam::input::armWake();
     
     // Flush logs before sleep
     Serial.flush();
     delay(10);
     
     // Enter light sleep
-    esp_light_sleep_start();
+    {
+        energy::Scope asleep(energy::PowerState::LightSleep);
+        esp_light_sleep_start();
+    }
     
     // We wake up here
     g_wasTimerWakeup = (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER);
+    if (buttonWake) {
+        pxlcam::input::disarmWake();
+    }
+    
+    PXLCAM_LOGI_TAG(kLogTag, "Woke from light sleep (%s)", getWakeupReason());
+    return true;
+}
+
+void recordWakeToReady(WakeKind kind, uint32_t readyMs) {
+    if (kind >= WakeKind::Count) {
+        return;
+    }
+    uint32_t& avg = g_readyMs[static_cast<size_t>(kind)];
+    // A slower wake counts in full at once: a late frame costs more than an early wake
+    avg = (avg == 0 || readyMs > avg) ? readyMs : (3 * avg + readyMs) / 4;
+    PXLCAM_LOGD_TAG(kLogTag, "%s wake ready after %lu ms, margin now %lu ms",
+                    kind == WakeKind::Deep ? "Deep" : "Light",
+                    static_cast<unsigned long>(readyMs),
+                    static_cast<unsigned long>(wakeMarginMs(kind)));
+}
+
+uint32_t wakeMarginMs(WakeKind kind) {
+    const uint32_t fixedMs = kind == WakeKind::Deep ? kDeepWakeMarginMs : kWakeMarginMs;
+    if (kind >= WakeKind::Count || g_readyMs[static_cast<size_t>(kind)] == 0) {
+        return fixedMs;
+    }
+    return min(g_readyMs[static_cast<size_t>(kind)] + kWakeSlackMs, kMaxWakeMarginMs);
+}
+
+void resetWakeModel() {
+    for (size_t i = 0; i < kWakeKinds; i++) {
+        g_readyMs[i] = 0;
+    }
+}
+
+bool shouldUseDeepSleep(uint32_t sleepMs) {
+    return g_sleepEnabled && sleepMs >= kMinDeepSleepMs;
+}
+
+bool enterDeepSleep(uint32_t sleepMs) {
+    const uint32_t marginMs = wakeMarginMs(WakeKind::Deep);
+    const uint32_t actualSleepMs = sleepMs > marginMs ? sleepMs - marginMs : 0;
     
-    PXLCAM_LOGI_TAG(kLogTag, "Woke from light sleep (timer: %s)",
-                    g_wasTimerWakeup ? "yes" : "no");
+    // Without a timer wake the run would never continue
+    esp_err_t err = esp_sleep_enable_timer_wakeup((uint64_t)actualSleepMs * 1000ULL);
+    if (err != ESP_OK) {
+        PXLCAM_LOGE_TAG(kLogTag, "Failed to set timer wakeup: %d", err);
+        return false;
+    }
+    
+    PXLCAM_LOGI_TAG(kLogTag, "Entering deep sleep for %lu ms", actualSleepMs);
+    Serial.flush();
+    delay(10);
+    
+    energy::prepareDeepSleep();
+    esp_deep_sleep_start();
+    return false;  // Not reached: the wake is a reset
+}
+
+bool wasDeepSleepWakeup() {
+    return g_wasDeepSleepWakeup;
 }
 
 void handleWakeup() {
-    // Re-initialize peripherals if needed
-    // For light sleep, most peripherals remain active
-    // Camera may need brief warmup
+    // For light sleep, most peripherals remain active; the camera comes out
+    // of standby in exposure::warmUp(), which waits exactly as long as needed
     
     PXLCAM_LOGD_TAG(kLogTag, "Handling wakeup, reason: %s", getWakeupReason());
-    
-    // Small delay for peripheral stabilization
-    delay(100);
 }
 
 bool wasTimerWakeup() {
@@ -0,0 +1,272 @@
+/**
+ * @file timelapse_sequence.cpp
+ * @brief Uncompressed AVI writer for timelapse sequences
+ *
+ * @version 1.3.0
+ */
+
+#include "timelapse_sequence.h"
+
+#if PXLCAM_FEATURE_TIMELAPSE
+
+#include "logging.h"
+#include "storage.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace pxlcam::timelapse {
+
+namespace {
+
+constexpr const char* kLogTag = "tl_seq";
+
+// Fixed part of the header: RIFF, hdrl LIST, avih, strl LIST, strh, strf tag
+constexpr size_t kStrfDataOffset = 172;
+constexpr size_t kRiffSizeOffset = 4;
+constexpr size_t kAvihFlagsOffset = 44;
+constexpr size_t kAvihFramesOffset = 48;
+constexpr size_t kStrhLengthOffset = 140;
+
+constexpr uint32_t kAvifHasIndex = 0x10;
+constexpr uint32_t kAviifKeyframe = 0x10;
+
+/// BMP file header before the BITMAPINFOHEADER
+constexpr size_t kBmpFileHeader = 14;
+
+/// idx1 entries written per append at close
+constexpr size_t kIndexBatch = 32;
+
+struct Sequence {
+    bool open;
+    uint32_t frames;
+    size_t pixelOffset;     ///< Header size of the incoming BMP frames
+    size_t frameBytes;      ///< Pixel rows per frame
+    size_t moviOffset;      ///< 'LIST' of the movi list
+    char path[64];
+};
+
+Sequence g_seq = {};
+
+inline uint16_t rd16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t rd32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline void wr16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+inline void wr32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+inline void wrTag(uint8_t* p, const char* tag) {
+    memcpy(p, tag, 4);
+}
+
+/// Bytes of one '00db' chunk (frames are even-sized; pad otherwise)
+size_t chunkBytes() {
+    return 8 + g_seq.frameBytes + (g_seq.frameBytes & 1);
+}
+
+/// Size of the file before idx1
+size_t dataEnd() {
+    return g_seq.moviOffset + 12 + g_seq.frames * chunkBytes();
+}
+
+bool patch32(size_t offset, uint32_t value) {
+    uint8_t bytes[4];
+    wr32(bytes, value);
+    return storage::patchStream(offset, bytes, sizeof(bytes));
+}
+
+/// Sizes and counts for the frames written so far
+bool patchCounts(size_t fileSize) {
+    return patch32(kRiffSizeOffset, static_cast<uint32_t>(fileSize - 8)) &&
+           patch32(kAvihFramesOffset, g_seq.frames) &&
+           patch32(kStrhLengthOffset, g_seq.frames) &&
+           patch32(g_seq.moviOffset + 4, static_cast<uint32_t>(4 + g_seq.frames * chunkBytes()));
+}
+
+/// RIFF + hdrl (avih, strl/strh) up to the strf payload
+void buildFixedHeader(uint8_t* h, int32_t width, int32_t height, size_t strfBytes) {
+    const uint32_t fps = PXLCAM_TIMELAPSE_AVI_FPS > 0 ? PXLCAM_TIMELAPSE_AVI_FPS : 1;
+    const uint32_t chunk = static_cast<uint32_t>(chunkBytes());
+    const uint32_t absHeight = static_cast<uint32_t>(height < 0 ? -height : height);
+    memset(h, 0, kStrfDataOffset);
+
+    wrTag(h + 0, "RIFF");
+    wrTag(h + 8, "AVI ");
+    wrTag(h + 12, "LIST");
+    wr32(h + 16, static_cast<uint32_t>(g_seq.moviOffset - 20));
+    wrTag(h + 20, "hdrl");
+
+    wrTag(h + 24, "avih");
+    wr32(h + 28, 56);
+    wr32(h + 32, 1000000u / fps);               // µs per frame
+    wr32(h + 36, chunk * fps);                  // Max bytes per second
+    wr32(h + 56, 1);                            // Streams
+    wr32(h + 60, chunk);                        // Suggested buffer
+    wr32(h + 64, static_cast<uint32_t>(width));
+    wr32(h + 68, absHeight);
+
+    wrTag(h + 88, "LIST");
+    wr32(h + 92, static_cast<uint32_t>(g_seq.moviOffset - 96));
+    wrTag(h + 96, "strl");
+
+    wrTag(h + 100, "strh");
+    wr32(h + 104, 56);
+    wrTag(h + 108, "vids");
+    wrTag(h + 112, "DIB ");
+    wr32(h + 128, 1);                           // Scale
+    wr32(h + 132, fps);                         // Rate
+    wr32(h + 144, chunk);                       // Suggested buffer
+    wr32(h + 148, 0xFFFFFFFFu);                 // Quality: default
+    wr16(h + 160, static_cast<uint16_t>(width));
+    wr16(h + 162, static_cast<uint16_t>(absHeight));
+
+    wrTag(h + 164, "strf");
+    wr32(h + 168, static_cast<uint32_t>(strfBytes));
+}
+
+} // anonymous namespace
+
+bool sequenceOpen(const char* path, const uint8_t* bmp, size_t bmpLength, uint32_t expectedFrames) {
+    if (g_seq.open) {
+        sequenceClose();
+    }
+
+    // Uncompressed bottom-up or top-down DIB, <= 8 bits per pixel
+    if (!path || !bmp || bmpLength < kBmpFileHeader + 40 || bmp[0] != 'B' || bmp[1] != 'M') {
+        return false;
+    }
+    const size_t pixelOffset = rd32(bmp + 10);
+    const uint16_t bitCount = rd16(bmp + 28);
+    const size_t strfBytes = pixelOffset - kBmpFileHeader;
+    if (pixelOffset >= bmpLength || pixelOffset < kBmpFileHeader + 40 || (strfBytes & 1) ||
+        rd32(bmp + 30) != 0 || (bitCount != 1 && bitCount != 4 && bitCount != 8)) {
+        PXLCAM_LOGW_TAG(kLogTag, "Frame is not an indexed BMP, no sequence");
+        return false;
+    }
+
+    g_seq = {};
+    g_seq.pixelOffset = pixelOffset;
+    g_seq.frameBytes = bmpLength - pixelOffset;
+    g_seq.moviOffset = kStrfDataOffset + strfBytes;
+    snprintf(g_seq.path, sizeof(g_seq.path), "%s", path);
+
+    if (expectedFrames == 0) {
+        expectedFrames = PXLCAM_TIMELAPSE_PREALLOC_FRAMES;
+    }
+    const size_t reserve = g_seq.moviOffset + 12 + expectedFrames * (chunkBytes() + 16) + 8;
+    if (!storage::beginStream(path, reserve)) {
+        return false;
+    }
+
+    uint8_t header[kStrfDataOffset];
+    uint8_t movi[12];
+    buildFixedHeader(header, static_cast<int32_t>(rd32(bmp + 18)), static_cast<int32_t>(rd32(bmp + 22)), strfBytes);
+    wrTag(movi, "LIST");
+    wr32(movi + 4, 4);
+    wrTag(movi + 8, "movi");
+    wr32(header + kRiffSizeOffset, static_cast<uint32_t>(dataEnd() - 8));
+
+    // BITMAPINFOHEADER and palette go in as the stream format unchanged
+    if (!storage::appendStream(header, sizeof(header)) ||
+        !storage::appendStream(bmp + kBmpFileHeader, strfBytes) ||
+        !storage::appendStream(movi, sizeof(movi)) ||
+        !storage::syncStream()) {
+        storage::endStream();
+        return false;
+    }
+
+    g_seq.open = true;
+    PXLCAM_LOGI_TAG(kLogTag, "Sequence %s (%u bytes/frame, %lu reserved)", path,
+                    static_cast<unsigned>(g_seq.frameBytes), static_cast<unsigned long>(expectedFrames));
+    return true;
+}
+
+bool sequenceAppend(const uint8_t* bmp, size_t bmpLength) {
+    if (!g_seq.open || !bmp || bmpLength != g_seq.pixelOffset + g_seq.frameBytes ||
+        rd32(bmp + 10) != g_seq.pixelOffset) {
+        return false;
+    }
+
+    uint8_t chunk[8];
+    wrTag(chunk, "00db");
+    wr32(chunk + 4, static_cast<uint32_t>(g_seq.frameBytes));
+    static const uint8_t kPad = 0;
+
+    if (!storage::appendStream(chunk, sizeof(chunk)) ||
+        !storage::appendStream(bmp + g_seq.pixelOffset, g_seq.frameBytes) ||
+        ((g_seq.frameBytes & 1) && !storage::appendStream(&kPad, 1))) {
+        return false;
+    }
+
+    // Checkpoint: a power cut from here on keeps this frame
+    g_seq.frames++;
+    return patchCounts(dataEnd()) && storage::syncStream();
+}
+
+bool sequenceClose() {
+    if (!g_seq.open) {
+        return false;
+    }
+    g_seq.open = false;
+
+    // Offsets count from the 'movi' tag
+    uint8_t index[kIndexBatch * 16];
+    uint8_t tag[8];
+    wrTag(tag, "idx1");
+    wr32(tag + 4, g_seq.frames * 16);
+    bool ok = storage::appendStream(tag, sizeof(tag));
+
+    const size_t chunk = chunkBytes();
+    for (uint32_t first = 0; ok && first < g_seq.frames; first += kIndexBatch) {
+        const uint32_t count = g_seq.frames - first < kIndexBatch ? g_seq.frames - first : kIndexBatch;
+        for (uint32_t i = 0; i < count; i++) {
+            uint8_t* e = index + i * 16;
+            wrTag(e, "00db");
+            wr32(e + 4, kAviifKeyframe);
+            wr32(e + 8, static_cast<uint32_t>(4 + (first + i) * chunk));
+            wr32(e + 12, static_cast<uint32_t>(g_seq.frameBytes));
+        }
+        ok = storage::appendStream(index, count * 16);
+    }
+
+    ok = ok && patchCounts(dataEnd() + 8 + g_seq.frames * 16) && patch32(kAvihFlagsOffset, kAvifHasIndex);
+    if (!ok) {
+        PXLCAM_LOGW_TAG(kLogTag, "Index not written for %s", g_seq.path);
+    }
+    // Kept either way: without idx1 it is still an AVI of every synced frame
+    ok = storage::endStream(true) && ok;
+
+    PXLCAM_LOGI_TAG(kLogTag, "Sequence closed: %s, %lu frames", g_seq.path,
+                    static_cast<unsigned long>(g_seq.frames));
+    return ok;
+}
+
+bool sequenceIsOpen() {
+    return g_seq.open;
+}
+
+uint32_t sequenceFrames() {
+    return g_seq.frames;
+}
+
+const char* sequencePath() {
+    return g_seq.path;
+}
+
+} // namespace pxlcam::timelapse
+
+#endif // PXLCAM_FEATURE_TIMELAPSE
@@ -0,0 +1,391 @@
+/**
+ * @file trace.cpp
+ * @brief Timeline of capture, stream, SD and display spans on both cores
+ */
+
+#include "trace.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "logging.h"
+#include "mem_placement.h"
+#include "storage.h"
+
+namespace pxlcam::trace {
+
+#if PXLCAM_TRACE
+
+static_assert(PXLCAM_TRACE_EVENTS >= 16 && (PXLCAM_TRACE_EVENTS & (PXLCAM_TRACE_EVENTS - 1)) == 0,
+              "PXLCAM_TRACE_EVENTS must be a power of two, 16 or more");
+static_assert(PXLCAM_TRACE_TASKS >= 1 && PXLCAM_TRACE_TASKS < 255, "PXLCAM_TRACE_TASKS must be 1..254");
+
+namespace detail {
+std::atomic<bool> g_recording{false};
+}
+
+namespace {
+
+constexpr const char* kLogTag = "trace";
+constexpr uint8_t kCores = 2;
+constexpr uint32_t kMask = PXLCAM_TRACE_EVENTS - 1;
+constexpr uint8_t kNoTask = 0xFF;     ///< Task table full
+constexpr size_t kChunk = 1024;       ///< JSON handed to the writer at a time
+
+enum Phase : uint8_t {
+    kComplete = 0,
+    kInstant,
+    kCounter
+};
+
+struct Event {
+    uint32_t startUs;
+    uint32_t durUs;
+    uint32_t arg;
+    Id id;
+    uint8_t task;       ///< Index into g_tasks
+    uint8_t core;       ///< Core the span began on
+    uint8_t phase;
+};
+static_assert(sizeof(Event) == 16, "trace events are 16 bytes");
+
+struct Ring {
+    Event* events;
+    std::atomic<uint32_t> head;     ///< Events reserved so far; slot = head & kMask
+};
+
+struct TaskName {
+    TaskHandle_t handle;
+    char name[16];
+};
+
+const char* const kNames[] = {
+    "shot", "fb_get", "save", "sd_write", "sd_queue", "display",
+    "preview_frame", "stream_grab", "stream_send", "app_event", "app_state",
+};
+static_assert(sizeof(kNames) / sizeof(kNames[0]) == static_cast<size_t>(Id::Count),
+              "one name per trace::Id");
+
+Ring g_rings[kCores];
+
+// Handles are compared only; names are copied while the task is alive.
+// A task created later at a freed handle's address inherits its name.
+TaskName g_tasks[PXLCAM_TRACE_TASKS];
+std::atomic<uint8_t> g_taskCount{0};
+
+portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;  // Task table inserts, enable state
+bool g_wanted = false;
+uint8_t g_pauses = 0;
+std::atomic<bool> g_dumpRequested{false};
+
+/// Caller holds g_lock
+void updateRecording() {
+    detail::g_recording.store(g_wanted && g_rings[0].events != nullptr && g_pauses == 0,
+                              std::memory_order_relaxed);
+}
+
+uint8_t taskSlot() {
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    const uint8_t seen = g_taskCount.load(std::memory_order_acquire);
+    for (uint8_t i = 0; i < seen; i++) {
+        if (g_tasks[i].handle == self) {
+            return i;
+        }
+    }
+
+    // First event of this task
+    uint8_t slot = kNoTask;
+    portENTER_CRITICAL(&g_lock);
+    const uint8_t count = g_taskCount.load(std::memory_order_relaxed);
+    for (uint8_t i = seen; i < count && slot == kNoTask; i++) {
+        if (g_tasks[i].handle == self) {
+            slot = i;
+        }
+    }
+    if (slot == kNoTask && count < PXLCAM_TRACE_TASKS) {
+        g_tasks[count].handle = self;
+        strncpy(g_tasks[count].name, pcTaskGetName(self), sizeof(g_tasks[count].name) - 1);
+        g_tasks[count].name[sizeof(g_tasks[count].name) - 1] = '\0';
+        g_taskCount.store(count + 1, std::memory_order_release);
+        slot = count;
+    }
+    portEXIT_CRITICAL(&g_lock);
+    return slot;
+}
+
+void record(Id id, uint32_t startUs, uint32_t durUs, uint32_t arg, uint8_t core, uint8_t phase) {
+    const uint8_t task = taskSlot();
+    Ring& ring = g_rings[xPortGetCoreID() < kCores ? xPortGetCoreID() : 0];
+    const uint32_t index = ring.head.fetch_add(1, std::memory_order_relaxed);
+    ring.events[index & kMask] = Event{startUs, durUs, arg, id, task, core, phase};
+}
+
+/// Recording stops for the life of a dump, so the rings hold still
+class Pause {
+   public:
+    Pause() {
+        portENTER_CRITICAL(&g_lock);
+        g_pauses++;
+        updateRecording();
+        portEXIT_CRITICAL(&g_lock);
+        vTaskDelay(1);  // Writers past the check finish their 16 bytes
+    }
+    ~Pause() {
+        portENTER_CRITICAL(&g_lock);
+        g_pauses--;
+        updateRecording();
+        portEXIT_CRITICAL(&g_lock);
+    }
+    Pause(const Pause&) = delete;
+    Pause& operator=(const Pause&) = delete;
+};
+
+/// Buffers printf output into kChunk pieces for the writer
+class JsonOut {
+   public:
+    JsonOut(Writer writer, void* user) : writer_(writer), user_(user) {}
+
+    void add(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char line[224];
+        va_list args;
+        va_start(args, fmt);
+        const int n = vsnprintf(line, sizeof(line), fmt, args);
+        va_end(args);
+        if (n <= 0 || !ok_) {
+            return;
+        }
+        const size_t len = static_cast<size_t>(n) < sizeof(line) ? static_cast<size_t>(n) : sizeof(line) - 1;
+        if (used_ + len > sizeof(buf_)) {
+            flush();
+        }
+        memcpy(buf_ + used_, line, len);
+        used_ += len;
+    }
+
+    /// Separator before every event but the first
+    void next() {
+        add("%s\n", first_ ? "" : ",");
+        first_ = false;
+    }
+
+    bool flush() {
+        if (ok_ && used_ > 0) {
+            ok_ = writer_(buf_, used_, user_);
+        }
+        used_ = 0;
+        return ok_;
+    }
+
+   private:
+    Writer writer_;
+    void* user_;
+    char buf_[kChunk];
+    size_t used_ = 0;
+    bool ok_ = true;
+    bool first_ = true;
+};
+
+}  // namespace
+
+bool begin() {
+    if (g_rings[0].events) {
+        return true;
+    }
+    for (uint8_t c = 0; c < kCores; c++) {
+        // Written from every task: PSRAM first, internal RAM if there is none
+        Event* events = static_cast<Event*>(
+            heap_caps_calloc(PXLCAM_TRACE_EVENTS, sizeof(Event), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        if (!events) {
+            events = static_cast<Event*>(heap_caps_calloc(PXLCAM_TRACE_EVENTS, sizeof(Event), MALLOC_CAP_8BIT));
+        }
+        if (!events) {
+            PXLCAM_LOGW_TAG(kLogTag, "No memory for %u trace events, tracing off",
+                            static_cast<unsigned>(PXLCAM_TRACE_EVENTS));
+            for (uint8_t i = 0; i < c; i++) {
+                heap_caps_free(g_rings[i].events);
+                g_rings[i].events = nullptr;
+            }
+            return false;
+        }
+        g_rings[c].events = events;
+        g_rings[c].head.store(0);
+        pxlcam::placement::note(c == 0 ? "trace ring core 0" : "trace ring core 1", events,
+                                PXLCAM_TRACE_EVENTS * sizeof(Event));
+    }
+
+    portENTER_CRITICAL(&g_lock);
+    g_wanted = true;
+    updateRecording();
+    portEXIT_CRITICAL(&g_lock);
+    PXLCAM_LOGI_TAG(kLogTag, "Tracing %u events per core (%u bytes)", static_cast<unsigned>(PXLCAM_TRACE_EVENTS),
+                    static_cast<unsigned>(kCores * PXLCAM_TRACE_EVENTS * sizeof(Event)));
+    return true;
+}
+
+void setEnabled(bool on) {
+    portENTER_CRITICAL(&g_lock);
+    g_wanted = on;
+    updateRecording();
+    portEXIT_CRITICAL(&g_lock);
+}
+
+void clear() {
+    Pause pause;
+    for (Ring& ring : g_rings) {
+        ring.head.store(0);
+    }
+}
+
+uint32_t now() {
+    return static_cast<uint32_t>(esp_timer_get_time());
+}
+
+void Span::start() {
+    core_ = static_cast<uint8_t>(xPortGetCoreID());
+    startUs_ = now();
+}
+
+void complete(Id id, uint32_t startUs, uint32_t arg, uint8_t startCore) {
+    if (isEnabled()) {
+        record(id, startUs, now() - startUs, arg, startCore, kComplete);
+    }
+}
+
+void instant(Id id, uint32_t arg) {
+    if (isEnabled()) {
+        record(id, now(), 0, arg, static_cast<uint8_t>(xPortGetCoreID()), kInstant);
+    }
+}
+
+void counter(Id id, uint32_t value) {
+    if (isEnabled()) {
+        record(id, now(), 0, value, static_cast<uint8_t>(xPortGetCoreID()), kCounter);
+    }
+}
+
+bool writeJson(Writer writer, void* user) {
+    Pause pause;
+    JsonOut out(writer, user);
+
+    // Event stamps are the low 32 bits of esp_timer: unwrapped against now
+    // (a ring covers far less than the 71 minutes they wrap in)
+    const int64_t now64 = esp_timer_get_time();
+    const uint32_t now32 = static_cast<uint32_t>(now64);
+    const uint8_t tasks = g_taskCount.load(std::memory_order_acquire);
+
+    out.add("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (uint8_t c = 0; c < kCores; c++) {
+        out.next();
+        out.add("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%u,\"args\":{\"name\":\"core %u\"}}", c, c);
+        for (uint8_t t = 0; t < tasks; t++) {
+            out.next();
+            out.add("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    c, t, g_tasks[t].name);
+        }
+        if (tasks == PXLCAM_TRACE_TASKS) {
+            out.next();
+            out.add("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"other\"}}",
+                    c, kNoTask);
+        }
+    }
+
+    for (uint8_t c = 0; c < kCores && g_rings[c].events; c++) {
+        const uint32_t head = g_rings[c].head.load();
+        const uint32_t count = head < PXLCAM_TRACE_EVENTS ? head : PXLCAM_TRACE_EVENTS;
+        for (uint32_t i = head - count; i != head; i++) {
+            const Event& e = g_rings[c].events[i & kMask];
+            const long long ts = static_cast<long long>(now64 - static_cast<uint32_t>(now32 - e.startUs));
+            const char* name = e.id < Id::Count ? kNames[static_cast<uint8_t>(e.id)] : "?";
+            out.next();
+            switch (e.phase) {
+                case kComplete:
+                    out.add("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%lld,\"dur\":%lu,"
+                            "\"args\":{\"arg\":%lu}}",
+                            name, e.core, e.task, ts, static_cast<unsigned long>(e.durUs),
+                            static_cast<unsigned long>(e.arg));
+                    break;
+                case kInstant:
+                    out.add("{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,\"tid\":%u,\"ts\":%lld,"
+                            "\"args\":{\"arg\":%lu}}",
+                            name, e.core, e.task, ts, static_cast<unsigned long>(e.arg));
+                    break;
+                default:
+                    out.add("{\"name\":\"%s\",\"ph\":\"C\",\"pid\":%u,\"ts\":%lld,\"args\":{\"value\":%lu}}",
+                            name, e.core, ts, static_cast<unsigned long>(e.arg));
+                    break;
+            }
+        }
+    }
+    out.add("\n]}\n");
+    return out.flush();
+}
+
+bool dumpToSd() {
+    char path[32];
+    snprintf(path, sizeof(path), "/trace_%lu.json", static_cast<unsigned long>(millis()));
+    if (!storage::beginStream(path)) {
+        PXLCAM_LOGE_TAG(kLogTag, "Trace dump: cannot open %s", path);
+        return false;
+    }
+    size_t bytes = 0;
+    const bool written = writeJson([](const char* data, size_t length, void* user) {
+        *static_cast<size_t*>(user) += length;
+        return storage::appendStream(reinterpret_cast<const uint8_t*>(data), length);
+    }, &bytes);
+    const bool ok = storage::endStream() && written;
+    if (ok) {
+        PXLCAM_LOGI_TAG(kLogTag, "Trace written to %s (%u bytes)", path, static_cast<unsigned>(bytes));
+    } else {
+        PXLCAM_LOGE_TAG(kLogTag, "Trace dump to %s failed", path);
+    }
+    return ok;
+}
+
+void requestDump() {
+    g_dumpRequested.store(true);
+}
+
+bool takeDumpRequest() {
+    return g_dumpRequested.exchange(false);
+}
+
+Stats getStats() {
+    Stats stats = {};
+    for (uint8_t c = 0; c < kCores; c++) {
+        stats.recorded[c] = g_rings[c].head.load();
+    }
+    stats.capacity = g_rings[0].events ? PXLCAM_TRACE_EVENTS : 0;
+    stats.tasks = g_taskCount.load();
+    return stats;
+}
+
+#else  // PXLCAM_TRACE
+
+bool begin() { return false; }
+void setEnabled(bool) {}
+void clear() {}
+uint32_t now() { return 0; }
+void complete(Id, uint32_t, uint32_t, uint8_t) {}
+void instant(Id, uint32_t) {}
+void counter(Id, uint32_t) {}
+
+bool writeJson(Writer writer, void* user) {
+    static const char kEmpty[] = "{\"traceEvents\":[]}\n";
+    return writer(kEmpty, sizeof(kEmpty) - 1, user);
+}
+
+bool dumpToSd() { return false; }
+void requestDump() {}
+bool takeDumpRequest() { return false; }
+Stats getStats() { return Stats{}; }
+
+#endif  // PXLCAM_TRACE
+
+}  // namespace pxlcam::trace
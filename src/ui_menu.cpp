@@ -205,7 +205,7 @@ void drawModeSelectScreen() {
     disp->setCursor(2, 56);
     disp->print("Tap:nav  Hold:OK");
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 void drawConfirmScreen(const char* modeName) {
@@ -228,7 +228,7 @@ void drawConfirmScreen(const char* modeName) {
     disp->setCursor(10, 54);
     disp->print("Hold:OK  Tap:cancel");
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 void drawErrorScreen(const char* title, const char* message, bool canRetry) {
@@ -266,7 +266,7 @@ void drawErrorScreen(const char* title, const char* message, bool canRetry) {
         disp->print("Tap: tentar novamente");
     }
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 void drawSuccessScreen(const char* title, const char* message, uint16_t durationMs) {
@@ -301,7 +301,7 @@ void drawSuccessScreen(const char* title, const char* message, uint16_t duration
         disp->print(message);
     }
     
-    disp->display();
+    pxlcam::display::updateDisplay();
     
     if (durationMs > 0) {
         delay(durationMs);
@@ -338,7 +338,7 @@ void drawProgressScreen(const char* title, uint8_t progress) {
     disp->setCursor(textX, 48);
     disp->print(buf);
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 void drawInfoScreen() {
@@ -378,7 +378,7 @@ void drawInfoScreen() {
         disp->print("KB");
     }
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 MenuState getMenuState() {
@@ -0,0 +1,77 @@
+/**
+ * @file rate_controller.cpp
+ * @brief Per-client MJPEG rate control against a latency target
+ */
+
+#include "rate_controller.h"
+
+namespace pxlcam::stream {
+
+namespace {
+
+/// EWMA weight of a new sample: 1/4
+constexpr uint32_t kAvgShift = 2;
+
+/// Writes faster than this were absorbed by the send buffer; they say
+/// nothing about the link beyond "at least this fast"
+constexpr uint32_t kMinMeasurableUs = 1000;
+
+/// Quality climbs 2 points per fast frame, drops by a quarter per slow one
+constexpr uint8_t kQualityStepUp = 2;
+
+/// Frames to wait after a cut: the average needs them to see smaller frames
+constexpr uint8_t kHoldFrames = 4;
+
+}  // namespace
+
+void RateController::begin(const RateConfig& config) {
+    config_ = config;
+    if (config_.minQuality > config_.maxQuality) {
+        config_.minQuality = config_.maxQuality;
+    }
+    if (config_.maxIntervalMs < config_.minIntervalMs) {
+        config_.maxIntervalMs = config_.minIntervalMs;
+    }
+    intervalMs_ = config_.minIntervalMs;
+    quality_ = config_.maxQuality;
+    sendUsAvg_ = 0;
+    throughputBps_ = 0;
+    holdFrames_ = 0;
+    primed_ = false;
+}
+
+void RateController::onFrameSent(size_t bytes, uint32_t sendUs) {
+    if (!primed_) {
+        sendUsAvg_ = sendUs;
+        primed_ = true;
+    } else {
+        sendUsAvg_ = sendUsAvg_ - (sendUsAvg_ >> kAvgShift) + (sendUs >> kAvgShift);
+    }
+
+    const uint32_t measuredUs = sendUs < kMinMeasurableUs ? kMinMeasurableUs : sendUs;
+    const uint32_t bps = static_cast<uint32_t>(static_cast<uint64_t>(bytes) * 1000000u / measuredUs);
+    throughputBps_ = throughputBps_ == 0
+        ? bps
+        : throughputBps_ - (throughputBps_ >> kAvgShift) + (bps >> kAvgShift);
+
+    // Pace at the drain rate plus 25% so the send buffer empties between frames
+    uint32_t interval = (sendUsAvg_ + (sendUsAvg_ >> 2)) / 1000;
+    if (interval < config_.minIntervalMs) interval = config_.minIntervalMs;
+    if (interval > config_.maxIntervalMs) interval = config_.maxIntervalMs;
+    intervalMs_ = interval;
+
+    // Quality: multiplicative decrease over the target, additive increase well under it
+    const uint32_t targetUs = static_cast<uint32_t>(config_.latencyMs) * 1000u;
+    if (holdFrames_ > 0) {
+        holdFrames_--;
+    } else if (sendUsAvg_ > targetUs) {
+        const uint8_t next = static_cast<uint8_t>(quality_ - quality_ / 4);
+        quality_ = next < config_.minQuality ? config_.minQuality : next;
+        holdFrames_ = kHoldFrames;
+    } else if (sendUsAvg_ < targetUs / 2 && quality_ < config_.maxQuality) {
+        const uint16_t next = static_cast<uint16_t>(quality_) + kQualityStepUp;
+        quality_ = next > config_.maxQuality ? config_.maxQuality : static_cast<uint8_t>(next);
+    }
+}
+
+}  // namespace pxlcam::stream
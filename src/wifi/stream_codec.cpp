@@ -0,0 +1,201 @@
+/**
+ * @file stream_codec.cpp
+ * @brief Per-client delta + RLE coding of stylized stream packets
+ */
+
+#include "stream_codec.h"
+
+#include <esp_heap_caps.h>
+#include <cstring>
+
+namespace pxlcam::stream {
+
+namespace {
+
+constexpr size_t kMaxLiteral = 128;
+constexpr size_t kMinRun = 3;
+constexpr size_t kMaxRun = 130;
+constexpr uint8_t kRunBase = 125;   ///< Control byte for a run of n: n + 125
+
+uint8_t* allocBuffer(size_t size) {
+    uint8_t* ptr = static_cast<uint8_t*>(
+        heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!ptr) {
+        ptr = static_cast<uint8_t*>(heap_caps_malloc(size, MALLOC_CAP_8BIT));
+    }
+    return ptr;
+}
+
+inline uint8_t valueAt(const uint8_t* src, const uint8_t* ref, size_t i) {
+    return ref ? static_cast<uint8_t>(src[i] ^ ref[i]) : src[i];
+}
+
+uint8_t* flushLiterals(const uint8_t* src, const uint8_t* ref, size_t from, size_t to,
+                       uint8_t* out) {
+    while (from < to) {
+        size_t count = to - from;
+        if (count > kMaxLiteral) {
+            count = kMaxLiteral;
+        }
+        *out++ = static_cast<uint8_t>(count - 1);
+        for (size_t i = 0; i < count; i++) {
+            *out++ = valueAt(src, ref, from + i);
+        }
+        from += count;
+    }
+    return out;
+}
+
+}  // namespace
+
+size_t rleEncode(const uint8_t* src, const uint8_t* ref, size_t len, uint8_t* out) {
+    uint8_t* const start = out;
+    size_t literalStart = 0;
+    size_t i = 0;
+
+    while (i < len) {
+        const uint8_t value = valueAt(src, ref, i);
+        size_t run = 1;
+        while (i + run < len && run < kMaxRun && valueAt(src, ref, i + run) == value) {
+            run++;
+        }
+
+        // Runs shorter than 3 cost less as literals
+        if (run < kMinRun) {
+            i += run;
+            continue;
+        }
+
+        out = flushLiterals(src, ref, literalStart, i, out);
+        *out++ = static_cast<uint8_t>(run + kRunBase);
+        *out++ = value;
+        i += run;
+        literalStart = i;
+    }
+
+    out = flushLiterals(src, ref, literalStart, len, out);
+    return static_cast<size_t>(out - start);
+}
+
+bool rleDecode(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen, bool xorInto) {
+    size_t in = 0;
+    size_t pos = 0;
+
+    while (in < srcLen) {
+        const uint8_t control = src[in++];
+        if (control < kMaxLiteral) {
+            const size_t count = static_cast<size_t>(control) + 1;
+            if (in + count > srcLen || pos + count > dstLen) {
+                return false;
+            }
+            for (size_t i = 0; i < count; i++) {
+                dst[pos + i] = xorInto ? static_cast<uint8_t>(dst[pos + i] ^ src[in + i])
+                                       : src[in + i];
+            }
+            in += count;
+            pos += count;
+        } else {
+            const size_t count = static_cast<size_t>(control) - kRunBase;
+            if (in >= srcLen || pos + count > dstLen) {
+                return false;
+            }
+            const uint8_t value = src[in++];
+            for (size_t i = 0; i < count; i++) {
+                dst[pos + i] = xorInto ? static_cast<uint8_t>(dst[pos + i] ^ value) : value;
+            }
+            pos += count;
+        }
+    }
+    return pos == dstLen;
+}
+
+bool StreamCodec::begin(size_t maxPacket, uint16_t keyframeInterval) {
+    end();
+    if (maxPacket <= kStylizedHeaderBytes) {
+        return false;
+    }
+
+    ref_ = allocBuffer(maxPacket);
+    out_ = allocBuffer(kCodecHeaderBytes + rleMaxSize(maxPacket - kStylizedHeaderBytes));
+    if (!ref_ || !out_) {
+        end();
+        return false;
+    }
+    maxPacket_ = maxPacket;
+    keyframeInterval_ = keyframeInterval;
+    keyPending_ = true;
+    return true;
+}
+
+void StreamCodec::end() {
+    heap_caps_free(ref_);
+    heap_caps_free(out_);
+    ref_ = nullptr;
+    out_ = nullptr;
+    maxPacket_ = 0;
+    refLen_ = 0;
+    sinceKey_ = 0;
+    keyframes_ = 0;
+    deltas_ = 0;
+    bytesIn_ = 0;
+    bytesOut_ = 0;
+}
+
+size_t StreamCodec::encode(const uint8_t* packet, size_t len, const uint8_t*& out) {
+    if (!out_ || !packet || len <= kStylizedHeaderBytes || len > maxPacket_) {
+        return 0;
+    }
+
+    const uint8_t* indices = packet + kStylizedHeaderBytes;
+    const size_t count = len - kStylizedHeaderBytes;
+    uint8_t* payload = out_ + kCodecHeaderBytes;
+
+    // A new palette or size invalidates what the client has on screen
+    bool key = keyPending_ || refLen_ != len ||
+               memcmp(ref_, packet, kStylizedHeaderBytes) != 0 ||
+               (keyframeInterval_ > 0 && sinceKey_ >= keyframeInterval_);
+
+    uint8_t flags = 0;
+    size_t payloadLen = 0;
+    if (!key) {
+        payloadLen = rleEncode(indices, ref_ + kStylizedHeaderBytes, count, payload);
+        if (payloadLen < count) {
+            flags = kFlagDelta | kFlagRle;
+        } else {
+            key = true;     // Scene cut: the delta is no smaller than the frame
+        }
+    }
+    if (key) {
+        payloadLen = rleEncode(indices, nullptr, count, payload);
+        if (payloadLen < count) {
+            flags = kFlagRle;
+        } else {
+            memcpy(payload, indices, count);
+            payloadLen = count;
+            flags = 0;
+        }
+    }
+
+    memcpy(out_, packet, kStylizedHeaderBytes);
+    out_[kStylizedHeaderBytes] = flags;
+    out_[kStylizedHeaderBytes + 1] = 0;
+
+    memcpy(ref_, packet, len);
+    refLen_ = len;
+    if (key) {
+        keyPending_ = false;
+        sinceKey_ = 0;
+        keyframes_++;
+    } else {
+        sinceKey_++;
+        deltas_++;
+    }
+
+    const size_t total = kCodecHeaderBytes + payloadLen;
+    bytesIn_ += len;
+    bytesOut_ += total;
+    out = out_;
+    return total;
+}
+
+}  // namespace pxlcam::stream
@@ -0,0 +1,194 @@
+/**
+ * @file stream_ring.cpp
+ * @brief Reference-counted frame slots shared by one producer and many readers
+ */
+
+#include "stream_ring.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+namespace pxlcam::stream {
+
+namespace {
+
+constexpr EventBits_t kFrameBit = 1u << 0;
+
+/// Longest single wait in waitNewer(); bounds the cost of a missed pulse
+constexpr uint32_t kWaitSliceMs = 10;
+
+/// Slots grow in 4 KB steps so small size changes don't reallocate
+constexpr size_t kGrowStep = 4096;
+
+uint8_t* allocSlot(size_t size) {
+    uint8_t* ptr = static_cast<uint8_t*>(
+        heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!ptr) {
+        ptr = static_cast<uint8_t*>(heap_caps_malloc(size, MALLOC_CAP_8BIT));
+    }
+    return ptr;
+}
+
+}  // namespace
+
+bool FrameRing::begin(uint8_t slots) {
+    if (slots < 2 || slots > kMaxSlots) {
+        return false;
+    }
+    end();
+
+    events_ = xEventGroupCreate();
+    if (!events_) {
+        return false;
+    }
+    slotCount_ = slots;
+    latest_ = -1;
+    writing_ = -1;
+    seq_ = 0;
+    published_ = 0;
+    dropped_ = 0;
+    return true;
+}
+
+void FrameRing::end() {
+    for (Slot& slot : slots_) {
+        if (slot.buf) {
+            heap_caps_free(slot.buf);
+        }
+        slot = Slot();
+    }
+    if (events_) {
+        vEventGroupDelete(events_);
+        events_ = nullptr;
+    }
+    slotCount_ = 0;
+    latest_ = -1;
+    writing_ = -1;
+}
+
+uint8_t* FrameRing::reserve(size_t len) {
+    if (slotCount_ == 0 || len == 0) {
+        return nullptr;
+    }
+
+    // One frame in flight at a time, even if two tasks publish
+    int8_t pick = -1;
+    portENTER_CRITICAL(&lock_);
+    if (writing_ < 0) {
+        for (int8_t i = 0; i < static_cast<int8_t>(slotCount_); i++) {
+            if (i != latest_ && slots_[i].refs == 0) {
+                pick = i;
+                break;
+            }
+        }
+        writing_ = pick;
+    }
+    portEXIT_CRITICAL(&lock_);
+
+    if (pick < 0) {
+        dropped_++;
+        return nullptr;
+    }
+
+    // Not the newest and unreferenced: no reader can reach it until publish()
+    Slot& slot = slots_[pick];
+    if (slot.capacity < len) {
+        const size_t capacity = (len + kGrowStep - 1) / kGrowStep * kGrowStep;
+        if (slot.buf) {
+            heap_caps_free(slot.buf);
+        }
+        slot.buf = allocSlot(capacity);
+        slot.capacity = slot.buf ? capacity : 0;
+        if (!slot.buf) {
+            cancel();
+            dropped_++;
+            return nullptr;
+        }
+    }
+    return slot.buf;
+}
+
+void FrameRing::publish(size_t len, uint32_t captureMs) {
+    if (writing_ < 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&lock_);
+    Slot& slot = slots_[writing_];
+    slot.len = len;
+    slot.seq = ++seq_;
+    slot.captureMs = captureMs;
+    latest_ = writing_;
+    writing_ = -1;
+    portEXIT_CRITICAL(&lock_);
+
+    published_++;
+
+    // Pulse: wakes every reader blocked in waitNewer()
+    xEventGroupSetBits(events_, kFrameBit);
+    xEventGroupClearBits(events_, kFrameBit);
+}
+
+void FrameRing::cancel() {
+    portENTER_CRITICAL(&lock_);
+    writing_ = -1;
+    portEXIT_CRITICAL(&lock_);
+}
+
+bool FrameRing::acquireLatest(uint32_t afterSeq, FrameRef& out) {
+    bool got = false;
+    portENTER_CRITICAL(&lock_);
+    if (latest_ >= 0 && slots_[latest_].seq > afterSeq) {
+        Slot& slot = slots_[latest_];
+        slot.refs++;
+        out.data = slot.buf;
+        out.len = slot.len;
+        out.seq = slot.seq;
+        out.captureMs = slot.captureMs;
+        out.slot = latest_;
+        got = true;
+    }
+    portEXIT_CRITICAL(&lock_);
+    return got;
+}
+
+bool FrameRing::waitNewer(uint32_t afterSeq, FrameRef& out, uint32_t timeoutMs) {
+    if (slotCount_ == 0) {
+        return false;
+    }
+
+    const uint32_t start = millis();
+    while (!acquireLatest(afterSeq, out)) {
+        const uint32_t elapsed = millis() - start;
+        if (elapsed >= timeoutMs) {
+            return false;
+        }
+        uint32_t slice = timeoutMs - elapsed;
+        if (slice > kWaitSliceMs) {
+            slice = kWaitSliceMs;
+        }
+        xEventGroupWaitBits(events_, kFrameBit, pdFALSE, pdFALSE, pdMS_TO_TICKS(slice));
+    }
+    return true;
+}
+
+void FrameRing::release(FrameRef& ref) {
+    if (ref.slot >= 0) {
+        portENTER_CRITICAL(&lock_);
+        Slot& slot = slots_[ref.slot];
+        if (slot.refs > 0) {
+            slot.refs--;
+        }
+        portEXIT_CRITICAL(&lock_);
+    }
+    ref = FrameRef();
+}
+
+uint32_t FrameRing::getLatestSeq() const {
+    portENTER_CRITICAL(&lock_);
+    const uint32_t seq = latest_ >= 0 ? slots_[latest_].seq : 0;
+    portEXIT_CRITICAL(&lock_);
+    return seq;
+}
+
+}  // namespace pxlcam::stream
@@ -0,0 +1,190 @@
+/**
+ * @file stylized_stream.cpp
+ * @brief Dithered preview frames for the WebSocket stream
+ */
+
+#include "stylized_stream.h"
+#include "pxlcam_config.h"
+
+#if PXLCAM_FEATURE_WIFI_PREVIEW
+
+#include "filters/dither_pipeline.h"
+#include "filters/palette.h"
+#include "jpeg_luma.h"
+
+#ifdef PXL_V13_EXPERIMENTAL
+#include "palettes/palette_manager.h"
+#endif
+
+#include <esp_heap_caps.h>
+#include <cstring>
+
+namespace pxlcam::stream {
+
+namespace {
+
+uint8_t* allocScratch(size_t size) {
+    uint8_t* ptr = static_cast<uint8_t*>(
+        heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!ptr) {
+        ptr = static_cast<uint8_t*>(heap_caps_malloc(size, MALLOC_CAP_8BIT));
+    }
+    return ptr;
+}
+
+/// Largest decoder downscale that keeps the image at least w×h
+jpg_scale_t decodeScaleFor(int srcW, int srcH, int w, int h) {
+    int shift = 0;
+    while (shift < 3 && (srcW >> (shift + 1)) >= w && (srcH >> (shift + 1)) >= h) {
+        shift++;
+    }
+    return static_cast<jpg_scale_t>(shift);
+}
+
+bool resampleFormatFor(pixformat_t format, filters::ResampleFormat& out) {
+    switch (format) {
+        case PIXFORMAT_GRAYSCALE: out = filters::ResampleFormat::GRAY;   return true;
+        case PIXFORMAT_YUV422:    out = filters::ResampleFormat::YUV422; return true;
+        case PIXFORMAT_RGB565:    out = filters::ResampleFormat::RGB565; return true;
+        case PIXFORMAT_RGB888:    out = filters::ResampleFormat::RGB888; return true;
+        default:                  return false;
+    }
+}
+
+}  // namespace
+
+bool StylizedEncoder::begin(int w, int h, uint8_t jpegQuality) {
+    end();
+    if (w <= 0 || h <= 0 || w > RESAMPLE_MAX_DST_WIDTH) {
+        return false;
+    }
+
+    // The stream may start before the first stylized capture
+    if (!filters::palette_is_initialized()) {
+        filters::palette_init();
+    }
+    if (!filters::dither_is_initialized()) {
+        filters::dither_init();
+    }
+
+    decode_ = allocScratch(static_cast<size_t>(w) * h * 4);
+    luma_ = allocScratch(static_cast<size_t>(w) * h);
+    packet_ = allocScratch(stylizedPacketSize(w, h));
+    if (!decode_ || !luma_ || !packet_) {
+        end();
+        return false;
+    }
+    jpeg_.begin(jpegQuality);
+    w_ = w;
+    h_ = h;
+    return true;
+}
+
+void StylizedEncoder::end() {
+    heap_caps_free(decode_);
+    heap_caps_free(luma_);
+    heap_caps_free(packet_);
+    decode_ = nullptr;
+    luma_ = nullptr;
+    packet_ = nullptr;
+    w_ = 0;
+    h_ = 0;
+}
+
+bool StylizedEncoder::frameToLuma(const camera_fb_t* fb) {
+    const uint8_t* src = fb->buf;
+    int srcW = fb->width;
+    int srcH = fb->height;
+    filters::ResampleFormat format;
+
+    if (fb->format == PIXFORMAT_JPEG) {
+        uint16_t decW = 0;
+        uint16_t decH = 0;
+        if (!jpeg::decodeToLuma(fb->buf, fb->len, decode_, w_ * 2, h_ * 2, &decW, &decH,
+                                decodeScaleFor(srcW, srcH, w_, h_))) {
+            return false;
+        }
+        src = decode_;
+        srcW = decW;
+        srcH = decH;
+        format = filters::ResampleFormat::GRAY;
+    } else if (!resampleFormatFor(fb->format, format)) {
+        return false;
+    } else if (fb->len < static_cast<size_t>(srcW) * srcH * filters::resample_bytes_per_pixel(format)) {
+        return false;
+    }
+
+    if (!resampler_.begin(srcW, srcH, format, luma_, w_, h_, w_)) {
+        return false;
+    }
+    const size_t stride = static_cast<size_t>(srcW) * filters::resample_bytes_per_pixel(format);
+    for (int y = 0; y < srcH; y++) {
+        resampler_.push_row(src + y * stride);
+    }
+    return resampler_.done();
+}
+
+bool StylizedEncoder::encode(const camera_fb_t* fb, uint8_t* out) {
+    using namespace pxlcam::filters;
+
+    if (!fb || !out || w_ == 0 || !frameToLuma(fb)) {
+        return false;
+    }
+
+#if PXLCAM_FEATURE_CUSTOM_PALETTES
+    const Palette& palette = palette_current();
+#else
+    const Palette& palette = palette_get(PaletteType::GB_CLASSIC);
+#endif
+
+    // Same algorithm and strength as the stylized capture; serial so the
+    // stream never competes with a capture for the dither worker
+    DitherConfig config = dither_get_config();
+    config.output = DitherOutput::PACKED_2BPP;
+    config.parallel = false;
+
+    memcpy(out, palette.tones, PALETTE_TONE_COUNT);
+    out[4] = static_cast<uint8_t>(w_);
+    out[5] = static_cast<uint8_t>(w_ >> 8);
+    out[6] = static_cast<uint8_t>(h_);
+    out[7] = static_cast<uint8_t>(h_ >> 8);
+
+    // Same color table as a capture; tones become the colors' luma
+    uint8_t* colors = out + 8;
+#ifdef PXL_V13_EXPERIMENTAL
+    palettes::indexColors(out, colors);
+#else
+    for (int i = 0; i < PALETTE_TONE_COUNT; i++) {
+        colors[i * 3 + 0] = colors[i * 3 + 1] = colors[i * 3 + 2] = out[i];
+    }
+#endif
+
+    const DitherResult result = apply_palette_dither_ex(luma_, SourceFormat::GRAYSCALE,
+                                                        out + kStylizedHeaderBytes, w_, h_,
+                                                        palette, config);
+    return result.success;
+}
+
+size_t StylizedEncoder::packetToJpeg(const uint8_t* packet, int scale, uint8_t* out,
+                                     size_t capacity) {
+    if (!packet || !out || w_ == 0) {
+        return 0;
+    }
+
+    // Indices → tones; the luma it was dithered from is no longer needed
+    const uint8_t* tones = packet;
+    const uint8_t* indices = packet + kStylizedHeaderBytes;
+    const int stride = (w_ + 3) / 4;
+    for (int y = 0; y < h_; y++) {
+        const uint8_t* src = indices + y * stride;
+        uint8_t* dst = luma_ + y * w_;
+        for (int x = 0; x < w_; x++) {
+            dst[x] = tones[(src[x >> 2] >> (6 - 2 * (x & 3))) & 3];
+        }
+    }
+    return jpeg_.encode(luma_, w_, h_, w_, scale, out, capacity);
+}
+
+}  // namespace pxlcam::stream
+
+#endif // PXLCAM_FEATURE_WIFI_PREVIEW
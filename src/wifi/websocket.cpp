@@ -0,0 +1,141 @@
+/**
+ * @file websocket.cpp
+ * @brief Minimal RFC 6455 helpers for the preview WebSocket stream
+ */
+
+#include "websocket.h"
+
+#include <mbedtls/sha1.h>
+#include <mbedtls/version.h>
+#include <cstring>
+
+namespace pxlcam::ws {
+
+namespace {
+
+constexpr char kGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+/// Longest Sec-WebSocket-Key accepted (a valid one is 24 characters)
+constexpr size_t kMaxKeyLen = 64;
+
+bool sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    return mbedtls_sha1(data, len, out) == 0;
+#else
+    return mbedtls_sha1_ret(data, len, out) == 0;
+#endif
+}
+
+size_t base64(const uint8_t* src, size_t len, char* out) {
+    static const char kAlphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t n = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        const uint32_t a = src[i];
+        const uint32_t b = i + 1 < len ? src[i + 1] : 0;
+        const uint32_t c = i + 2 < len ? src[i + 2] : 0;
+        const uint32_t triple = (a << 16) | (b << 8) | c;
+        out[n++] = kAlphabet[(triple >> 18) & 0x3F];
+        out[n++] = kAlphabet[(triple >> 12) & 0x3F];
+        out[n++] = i + 1 < len ? kAlphabet[(triple >> 6) & 0x3F] : '=';
+        out[n++] = i + 2 < len ? kAlphabet[triple & 0x3F] : '=';
+    }
+    out[n] = '\0';
+    return n;
+}
+
+}  // namespace
+
+bool acceptKey(const char* key, char* out, size_t outSize) {
+    if (!key || !out || outSize < 29) {
+        return false;
+    }
+    
+    while (*key == ' ' || *key == '\t') {
+        key++;
+    }
+    size_t keyLen = strlen(key);
+    while (keyLen > 0 && (key[keyLen - 1] == ' ' || key[keyLen - 1] == '\r' ||
+                          key[keyLen - 1] == '\n' || key[keyLen - 1] == '\t')) {
+        keyLen--;
+    }
+    if (keyLen == 0 || keyLen > kMaxKeyLen) {
+        return false;
+    }
+    
+    uint8_t input[kMaxKeyLen + sizeof(kGuid)];
+    memcpy(input, key, keyLen);
+    memcpy(input + keyLen, kGuid, sizeof(kGuid) - 1);
+    
+    uint8_t digest[20];
+    if (!sha1(input, keyLen + sizeof(kGuid) - 1, digest)) {
+        return false;
+    }
+    base64(digest, sizeof(digest), out);
+    return true;
+}
+
+size_t frameHeader(uint8_t* out, uint8_t opcode, size_t payloadLen) {
+    out[0] = 0x80 | (opcode & 0x0F);
+    if (payloadLen < 126) {
+        out[1] = static_cast<uint8_t>(payloadLen);
+        return 2;
+    }
+    if (payloadLen <= 0xFFFF) {
+        out[1] = 126;
+        out[2] = static_cast<uint8_t>(payloadLen >> 8);
+        out[3] = static_cast<uint8_t>(payloadLen);
+        return 4;
+    }
+    out[1] = 127;
+    const uint64_t len = payloadLen;
+    for (int i = 0; i < 8; i++) {
+        out[2 + i] = static_cast<uint8_t>(len >> (56 - 8 * i));
+    }
+    return 10;
+}
+
+bool parseClientHeader(const uint8_t* buf, size_t len, ClientFrame& out) {
+    if (len < 2) {
+        return false;
+    }
+    
+    out.fin = (buf[0] & 0x80) != 0;
+    out.opcode = buf[0] & 0x0F;
+    out.masked = (buf[1] & 0x80) != 0;
+    
+    size_t pos = 2;
+    uint64_t payload = buf[1] & 0x7F;
+    if (payload == 126) {
+        if (len < pos + 2) return false;
+        payload = (static_cast<uint64_t>(buf[2]) << 8) | buf[3];
+        pos += 2;
+    } else if (payload == 127) {
+        if (len < pos + 8) return false;
+        payload = 0;
+        for (int i = 0; i < 8; i++) {
+            payload = (payload << 8) | buf[2 + i];
+        }
+        pos += 8;
+    }
+    
+    if (out.masked) {
+        if (len < pos + 4) return false;
+        memcpy(out.mask, buf + pos, 4);
+        pos += 4;
+    } else {
+        memset(out.mask, 0, sizeof(out.mask));
+    }
+    
+    out.payloadLen = payload;
+    out.headerLen = pos;
+    return true;
+}
+
+void unmask(uint8_t* data, size_t len, const uint8_t mask[4], size_t offset) {
+    for (size_t i = 0; i < len; i++) {
+        data[i] ^= mask[(offset + i) & 3];
+    }
+}
+
+}  // namespace pxlcam::ws
@@ -7,6 +7,46 @@
  * - HTTP server with MJPEG streaming
  * - Web interface for camera preview
  * 
+ * One capture task encodes each frame once into a FrameRing; every MJPEG
+ * client sends the newest slot, so viewers share captures instead of each
+ * taking a camera frame and holding it during writes. The capture task is
+ * itself a consumer of the camera service (camera_service.h), sharing its
+ * readouts with the OLED preview and the capture paths.
+ * 
+ * /stream and /capture responses are written by a sender task per client,
+ * so WebServer::handleClient() (and tick()) only parses requests and hands
+ * the socket over; the main loop keeps running while someone watches.
+ * 
+ * A WebSocket server on wsPort streams the stylized frame itself: palette
+ * dithered, 2 bits per pixel (see stylized_stream.h), drawn by the page on
+ * a canvas. It shares the capture task and has its own slot ring; each
+ * client's sender delta + RLE codes the frames against what it last sent
+ * (see stream_codec.h).
+ * 
+ * /stylized is the same dithered frame as MJPEG, for viewers that aren't
+ * the page: the capture task turns the packet into a small grayscale JPEG
+ * with fixed tables and buffers reused frame to frame (see
+ * jpeg_gray_encoder.h), into a third ring.
+ * 
+ * /files lists DCIM a page at a time and /files/<name> streams a file in
+ * 4 KB chunks (Range requests give 206), from sender tasks that run below
+ * the stream's priority.
+ * 
+ * Power: the capture pipeline (task, rings, stylized scratch) exists only
+ * while a stream client does, the modem sleeps while nobody is associated
+ * (or, in STA mode, while nothing is being served), an AP with no stations
+ * skips request polling until an association event, and config.autoOffMs
+ * turns WiFi off after that long idle.
+ * 
+ * /metrics is Prometheus text written through a 1 KB stack buffer from a
+ * sender task: no String building, no heap, tick() is not held up.
+ * 
+ * /bench?run=1 asks for an on-device pipeline benchmark (pipeline_bench.h),
+ * run by the app loop once no stream is open; /bench then serves its CSV.
+ * 
+ * /trace.json streams trace::writeJson() from a sender task; recording
+ * pauses while it is read, so a long download leaves a gap in the next one.
+ * 
  * @version 1.3.0
  * @date 2024
  */
@@ -15,12 +55,41 @@
 
 #if PXLCAM_FEATURE_WIFI_PREVIEW
 
+#include "camera_config.h"
+#include "camera_service.h"
+#include "capture_pipeline.h"
+#include "energy_meter.h"
+#include "frame_pacer.h"
+#include "pipeline_bench.h"
+#include "preview.h"
+#include "pxlcam_config.h"
+#include "trace.h"
+#include "rate_controller.h"
+#include "sensor_profile.h"
+#include "storage.h"
+#include "stream_codec.h"
+#include "stream_ring.h"
+#include "stylized_stream.h"
+#include "websocket.h"
+#include "wifi_sta.h"
+#if PXLCAM_FEATURE_TIMELAPSE
+#include "timelapse.h"
+#endif
 #include "logging.h"
 
+#include <atomic>
+#include <stdarg.h>
+#include <strings.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
 #include <WiFi.h>
 #include <WebServer.h>
 #include <ESPmDNS.h>
+#include <SD_MMC.h>
 #include <esp_camera.h>
+#include <esp_heap_caps.h>
+#include <img_converters.h>
 
 namespace pxlcam {
 
@@ -28,6 +97,420 @@ namespace {
 
 constexpr const char* kLogTag = "wifi_preview";
 
+/// Quality used when re-encoding non-JPEG sensor frames for /capture
+constexpr uint8_t kReencodeJpegQuality = 80;
+
+/// Stream clients tracked for quality votes and /metrics
+constexpr uint8_t kMaxClientSlots = 8;
+
+/// ClientSlot::kind values
+constexpr uint8_t kSlotFree = 0;
+constexpr uint8_t kSlotMjpeg = 1;
+constexpr uint8_t kSlotWebSocket = 2;
+constexpr uint8_t kSlotStylized = 3;
+
+/// One live stream client, updated by its sender task
+struct ClientSlot {
+    std::atomic<uint8_t> kind{kSlotFree};
+    std::atomic<uint8_t> quality{0};        ///< MJPEG quality vote (0 = none)
+    std::atomic<uint32_t> frames{0};
+    std::atomic<uint32_t> bytes{0};
+    std::atomic<uint32_t> startMs{0};
+};
+
+ClientSlot* claimClientSlot(ClientSlot* slots, uint8_t kind) {
+    for (uint8_t i = 0; i < kMaxClientSlots; i++) {
+        uint8_t expected = kSlotFree;
+        if (slots[i].kind.compare_exchange_strong(expected, kind)) {
+            slots[i].quality = 0;
+            slots[i].frames = 0;
+            slots[i].bytes = 0;
+            slots[i].startMs = millis();
+            return &slots[i];
+        }
+    }
+    return nullptr;
+}
+
+void releaseClientSlot(ClientSlot* slot) {
+    if (slot) {
+        slot->quality = 0;
+        slot->kind = kSlotFree;
+    }
+}
+
+void countClientFrame(ClientSlot* slot, size_t bytes) {
+    if (slot) {
+        slot->frames++;
+        slot->bytes += bytes;
+    }
+}
+
+/// Slowest per-client pacing the rate controller may pick (ms)
+constexpr uint16_t kMaxClientIntervalMs = 2000;
+
+/// Sensor quality changes smaller than this are not applied (each costs a
+/// register write and can glitch the frame being exposed)
+constexpr uint8_t kQualityApplyStep = 4;
+
+/// Capture task poll interval while no client is streaming (ms)
+constexpr uint32_t kCaptureIdleMs = 50;
+
+/// Longest a client waits for a new frame before re-checking its socket (ms)
+constexpr uint32_t kStreamWaitMs = 250;
+
+/// Time stop() gives the capture task to exit (ms)
+constexpr uint32_t kCaptureStopMs = 500;
+
+/// Bytes handed to the socket per write(); the sender yields between them
+constexpr size_t kSendChunk = 4096;
+
+/// Station count refresh interval in tick() (ms)
+constexpr uint32_t kStationPollMs = 500;
+
+/// Station count poll while the AP has nobody associated; association
+/// events wake tick() sooner (ms)
+constexpr uint32_t kIdleStationPollMs = 2000;
+
+/// Write a whole buffer at the pace the socket drains it
+/// @return false if the client went away or stalled for timeoutMs
+bool writeAll(WiFiClient& client, const uint8_t* data, size_t len, uint32_t timeoutMs) {
+    uint32_t lastProgress = millis();
+    while (len > 0) {
+        const size_t n = client.write(data, len < kSendChunk ? len : kSendChunk);
+        if (n == 0) {
+            // Send buffer full: wait for this client only
+            if (!client.connected() || millis() - lastProgress >= timeoutMs) {
+                return false;
+            }
+            vTaskDelay(1);
+            continue;
+        }
+        data += n;
+        len -= n;
+        lastProgress = millis();
+    }
+    return true;
+}
+
+bool writeAll(WiFiClient& client, const char* text, uint32_t timeoutMs) {
+    return writeAll(client, reinterpret_cast<const uint8_t*>(text), strlen(text), timeoutMs);
+}
+
+/// Time a WebSocket client gets to send its upgrade request (ms)
+constexpr uint32_t kWsHandshakeMs = 2000;
+
+/// Largest upgrade request accepted (browsers send ~500 bytes)
+constexpr size_t kWsRequestMax = 1024;
+
+/// Read exactly len bytes, or fail after timeoutMs without progress
+bool readExact(WiFiClient& client, uint8_t* buf, size_t len, uint32_t timeoutMs) {
+    uint32_t lastProgress = millis();
+    while (len > 0) {
+        if (client.available() > 0) {
+            const int c = client.read();
+            if (c < 0) continue;
+            *buf++ = static_cast<uint8_t>(c);
+            len--;
+            lastProgress = millis();
+        } else if (!client.connected() || millis() - lastProgress >= timeoutMs) {
+            return false;
+        } else {
+            vTaskDelay(1);
+        }
+    }
+    return true;
+}
+
+/// Read the HTTP upgrade request and answer it
+bool websocketHandshake(WiFiClient& client) {
+    char request[kWsRequestMax];
+    size_t len = 0;
+    const uint32_t start = millis();
+    
+    // Headers end with an empty line
+    while (len < sizeof(request) - 1) {
+        if (client.available() > 0) {
+            const int c = client.read();
+            if (c < 0) continue;
+            request[len++] = static_cast<char>(c);
+            if (len >= 4 && memcmp(request + len - 4, "\r\n\r\n", 4) == 0) break;
+        } else if (!client.connected() || millis() - start >= kWsHandshakeMs) {
+            return false;
+        } else {
+            vTaskDelay(1);
+        }
+    }
+    request[len] = '\0';
+    
+    static const char kKeyHeader[] = "Sec-WebSocket-Key:";
+    const char* key = nullptr;
+    for (char* line = request; line && *line; ) {
+        char* next = strstr(line, "\r\n");
+        if (next) *next = '\0';
+        if (strncasecmp(line, kKeyHeader, sizeof(kKeyHeader) - 1) == 0) {
+            key = line + sizeof(kKeyHeader) - 1;
+        }
+        line = next ? next + 2 : nullptr;
+    }
+    
+    char accept[32];
+    if (!key || !ws::acceptKey(key, accept, sizeof(accept))) {
+        writeAll(client, "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n",
+                 PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        return false;
+    }
+    
+    char response[160];
+    snprintf(response, sizeof(response),
+             "HTTP/1.1 101 Switching Protocols\r\n"
+             "Upgrade: websocket\r\n"
+             "Connection: Upgrade\r\n"
+             "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    return writeAll(client, response, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+}
+
+/// Handle whatever the browser sent (pings, close); never blocks on an idle socket
+/// @return false once the connection should end
+bool websocketPoll(WiFiClient& client) {
+    while (client.available() > 0) {
+        // Fixed part first, then the extended length and mask it announces
+        uint8_t header[14];
+        if (!readExact(client, header, 2, PXLCAM_STREAM_SEND_TIMEOUT_MS)) return false;
+        const uint8_t lenCode = header[1] & 0x7F;
+        const size_t extra = (lenCode == 126 ? 2 : lenCode == 127 ? 8 : 0) + ((header[1] & 0x80) ? 4 : 0);
+        if (!readExact(client, header + 2, extra, PXLCAM_STREAM_SEND_TIMEOUT_MS)) return false;
+        
+        ws::ClientFrame frame;
+        if (!ws::parseClientHeader(header, 2 + extra, frame)) return false;
+        
+        // Control payloads are at most 125 bytes; anything else is discarded
+        uint8_t payload[125];
+        const bool control = (frame.opcode & 0x08) != 0;
+        if (control && frame.payloadLen > sizeof(payload)) return false;
+        
+        uint64_t remaining = frame.payloadLen;
+        size_t kept = 0;
+        while (remaining > 0) {
+            const size_t n = remaining < sizeof(payload) ? static_cast<size_t>(remaining) : sizeof(payload);
+            if (!readExact(client, payload, n, PXLCAM_STREAM_SEND_TIMEOUT_MS)) return false;
+            kept = n;
+            remaining -= n;
+        }
+        if (!control) continue;
+        ws::unmask(payload, kept, frame.mask);
+        
+        if (frame.opcode == ws::kOpClose) {
+            // Echo the status code and let the client close the socket
+            uint8_t reply[ws::kMaxHeaderBytes + 2];
+            const size_t codeLen = kept >= 2 ? 2 : 0;
+            const size_t headerLen = ws::frameHeader(reply, ws::kOpClose, codeLen);
+            memcpy(reply + headerLen, payload, codeLen);
+            writeAll(client, reply, headerLen + codeLen, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+            return false;
+        }
+        if (frame.opcode == ws::kOpPing) {
+            uint8_t pong[ws::kMaxHeaderBytes];
+            const size_t headerLen = ws::frameHeader(pong, ws::kOpPong, kept);
+            if (!writeAll(client, pong, headerLen, PXLCAM_STREAM_SEND_TIMEOUT_MS) ||
+                !writeAll(client, payload, kept, PXLCAM_STREAM_SEND_TIMEOUT_MS)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// JPEG view of a camera frame
+struct JpegView {
+    const uint8_t* buf;
+    size_t len;
+    bool owned;     ///< buf was allocated by frame2jpg() and must be freed
+};
+
+/// Get JPEG bytes for a frame, encoding on the fly if the sensor is not in JPEG mode
+/// @param quality Re-encode quality (0-100); sensor JPEG is used as is
+bool frameToJpeg(camera_fb_t* fb, JpegView& out, uint8_t quality) {
+    if (fb->format == PIXFORMAT_JPEG) {
+        out = { fb->buf, fb->len, false };
+        return true;
+    }
+    
+    uint8_t* jpgBuf = nullptr;
+    size_t jpgLen = 0;
+    if (!frame2jpg(fb, quality, &jpgBuf, &jpgLen)) {
+        return false;
+    }
+    out = { jpgBuf, jpgLen, true };
+    return true;
+}
+
+void releaseJpeg(JpegView& view) {
+    if (view.owned) {
+        free(const_cast<uint8_t*>(view.buf));
+    }
+    view = { nullptr, 0, false };
+}
+
+// =============================================================================
+// SD File Helpers
+// =============================================================================
+
+/// Directory served by /files
+constexpr const char* kFilesDir = "/DCIM";
+
+/// Longest file name accepted in /files/<name>
+constexpr size_t kFileNameMax = 48;
+
+/// SD read size per chunk; one buffer per download, never the whole file
+constexpr size_t kFileChunk = 4096;
+
+const char* contentTypeFor(const char* name) {
+    const char* dot = strrchr(name, '.');
+    if (!dot) return "application/octet-stream";
+    if (strcasecmp(dot, ".jpg") == 0 || strcasecmp(dot, ".jpeg") == 0) return "image/jpeg";
+    if (strcasecmp(dot, ".bmp") == 0) return "image/bmp";
+    if (strcasecmp(dot, ".png") == 0) return "image/png";
+    if (strcasecmp(dot, ".avi") == 0) return "video/x-msvideo";
+    if (strcasecmp(dot, ".json") == 0) return "application/json";
+    if (strcasecmp(dot, ".txt") == 0 || strcasecmp(dot, ".log") == 0) return "text/plain";
+    return "application/octet-stream";
+}
+
+/// A file inside kFilesDir or one capture folder below it ("100PXLCM/x.bmp"):
+/// at most one separator, no "..", no hidden or empty components
+bool isSafeFileName(const char* name) {
+    const size_t len = strlen(name);
+    if (len == 0 || len >= kFileNameMax) {
+        return false;
+    }
+    uint8_t separators = 0;
+    for (size_t i = 0; i < len; i++) {
+        const char c = name[i];
+        const bool componentStart = i == 0 || name[i - 1] == '/';
+        if (componentStart && (c == '.' || c == '/')) {
+            return false;
+        }
+        if (c == '/' && (++separators > 1 || i + 1 == len)) {
+            return false;
+        }
+        if (c == '\\' || c < 0x20 || c == '"') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Last path component (some cores return full paths from File::name())
+const char* baseName(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+/// Parse a single "bytes=" range against a file of size bytes
+/// @return false if the range is malformed or unsatisfiable
+bool parseRange(const char* header, uint32_t size, uint32_t& first, uint32_t& last) {
+    if (strncasecmp(header, "bytes=", 6) != 0 || size == 0) {
+        return false;
+    }
+    const char* p = header + 6;
+    char* end = nullptr;
+    if (*p == '-') {
+        // Suffix: the last n bytes
+        const unsigned long n = strtoul(p + 1, &end, 10);
+        if (end == p + 1 || n == 0) return false;
+        first = n >= size ? 0 : size - static_cast<uint32_t>(n);
+        last = size - 1;
+        return true;
+    }
+    const unsigned long a = strtoul(p, &end, 10);
+    if (end == p || *end != '-' || a >= size) {
+        return false;
+    }
+    p = end + 1;
+    if (*p == '\0' || *p == ',') {
+        last = size - 1;
+    } else {
+        const unsigned long b = strtoul(p, &end, 10);
+        if (end == p || b < a) return false;
+        last = b >= size ? size - 1 : static_cast<uint32_t>(b);
+    }
+    first = static_cast<uint32_t>(a);
+    return true;
+}
+
+// =============================================================================
+// Metrics Writer
+// =============================================================================
+
+/// Stack buffer /metrics is formatted into; flushed to the socket when full
+constexpr size_t kMetricsChunk = 1024;
+
+/// Prometheus text format straight to a socket, one small buffer, no heap
+class MetricsWriter {
+public:
+    explicit MetricsWriter(WiFiClient& client) : client_(client) {}
+    
+    /// # HELP / # TYPE header of a metric family
+    void family(const char* name, const char* type, const char* help) {
+        append("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+    
+    /// Sample without labels
+    void value(const char* name, uint32_t v) {
+        append("%s %lu\n", name, static_cast<unsigned long>(v));
+    }
+    
+    /// Sample with a preformatted label set (e.g. stage="decode")
+    void value(const char* name, const char* labels, uint32_t v) {
+        append("%s{%s} %lu\n", name, labels, static_cast<unsigned long>(v));
+    }
+    
+    void value(const char* name, const char* labels, float v) {
+        append("%s{%s} %.2f\n", name, labels, static_cast<double>(v));
+    }
+    
+    /// Send what is buffered; false once the client is gone
+    bool flush() {
+        if (ok_ && len_ > 0) {
+            ok_ = writeAll(client_, reinterpret_cast<const uint8_t*>(buf_), len_,
+                           PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        }
+        len_ = 0;
+        return ok_;
+    }
+    
+private:
+    void append(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        for (int attempt = 0; attempt < 2 && ok_; attempt++) {
+            va_list args;
+            va_start(args, fmt);
+            const int n = vsnprintf(buf_ + len_, sizeof(buf_) - len_, fmt, args);
+            va_end(args);
+            if (n < 0) {
+                return;
+            }
+            if (len_ + static_cast<size_t>(n) < sizeof(buf_)) {
+                len_ += n;
+                return;
+            }
+            flush();    // Line did not fit: send the buffer and retry once
+        }
+    }
+    
+    WiFiClient& client_;
+    char buf_[kMetricsChunk];
+    size_t len_ = 0;
+    bool ok_ = true;
+};
+
+/// Stream quality (0-100, higher is better) → sensor JPEG quality
+/// (63 = smallest … 6 = best; lower values overflow the sensor's buffer)
+int sensorQualityFor(uint8_t quality) {
+    if (quality > 100) quality = 100;
+    return 63 - (static_cast<int>(quality) * 57) / 100;
+}
+
 // =============================================================================
 // HTML Page
 // =============================================================================
@@ -68,13 +551,19 @@ const char kIndexHtml[] PROGMEM = R"rawliteral(
             padding: 10px;
             max-width: 100%;
         }
-        #stream {
+        #stream, #pixel {
             display: block;
             max-width: 100%;
             width: 320px;
             height: auto;
             border-radius: 4px;
         }
+        #pixel {
+            display: none;
+        }
+        #pixel, #stream.styled {
+            image-rendering: pixelated;
+        }
         .status {
             margin-top: 15px;
             padding: 10px 20px;
@@ -121,6 +610,7 @@ const char kIndexHtml[] PROGMEM = R"rawliteral(
     
     <div class="stream-container">
         <img id="stream" src="/stream" alt="Camera Stream">
+        <canvas id="pixel"></canvas>
     </div>
     
     <div class="status">
@@ -129,6 +619,9 @@ const char kIndexHtml[] PROGMEM = R"rawliteral(
     
     <div class="controls">
         <button onclick="location.reload()">Atualizar</button>
+        <button id="mode" onclick="toggleMode()">Pixel</button>
+        <button id="style" onclick="toggleStyle()">Estilizado</button>
+        <button id="bench" onclick="runBench()">Benchmark</button>
     </div>
     
     <p class="footer">Desenvolvido por PXLcam Team</p>
@@ -136,16 +629,149 @@ const char kIndexHtml[] PROGMEM = R"rawliteral(
     <script>
         const img = document.getElementById('stream');
         const status = document.getElementById('status');
+        const styleBtn = document.getElementById('style');
+        let jpegPath = '/stream';   // '/stylized': the dithered frame as MJPEG
         
         img.onerror = function() {
+            if (img.style.display === 'none') return;
             status.textContent = 'Desconectado';
             status.style.color = '#ff4444';
-            setTimeout(() => { img.src = '/stream?' + Date.now(); }, 2000);
+            setTimeout(() => { img.src = jpegPath + '?' + Date.now(); }, 2000);
         };
+        
+        function toggleStyle() {
+            jpegPath = jpegPath === '/stream' ? '/stylized' : '/stream';
+            img.classList.toggle('styled', jpegPath === '/stylized');
+            styleBtn.textContent = jpegPath === '/stream' ? 'Estilizado' : 'Original';
+            if (!ws) img.src = jpegPath + '?' + Date.now();
+        }
         img.onload = function() {
             status.textContent = 'Conectado';
             status.style.color = '#00ff88';
         };
+        
+        // Pixel mode: 2bpp palette frames over WebSocket, drawn 1:1 on a canvas
+        // Message: tones[4], width u16, height u16, rgb[4][3], flags, reserved,
+        // then the indices (4 pixels per byte, MSB first); flags bit 0 = XOR with
+        // the previous frame, bit 1 = RLE (c < 128: c+1 literals, else byte x c-125)
+        const canvas = document.getElementById('pixel');
+        const ctx = canvas.getContext('2d');
+        const modeBtn = document.getElementById('mode');
+        let ws = null;
+        let wsPort = 81;
+        let frame = null;
+        
+        function unpack(bytes, out, delta) {
+            let i = 22, o = 0;
+            if (!(bytes[20] & 2)) {
+                for (; o < out.length && i < bytes.length; o++, i++) out[o] = delta ? out[o] ^ bytes[i] : bytes[i];
+                return o === out.length;
+            }
+            while (i < bytes.length) {
+                const c = bytes[i++];
+                if (c < 128) {
+                    for (let k = 0; k <= c; k++, o++, i++) out[o] = delta ? out[o] ^ bytes[i] : bytes[i];
+                } else {
+                    const v = bytes[i++];
+                    for (let k = 0; k < c - 125; k++, o++) out[o] = delta ? out[o] ^ v : v;
+                }
+            }
+            return o === out.length;
+        }
+        
+        function drawPacket(buf) {
+            const bytes = new Uint8Array(buf);
+            const view = new DataView(buf);
+            const w = view.getUint16(4, true);
+            const h = view.getUint16(6, true);
+            const stride = (w + 3) >> 2;
+            const delta = (bytes[20] & 1) !== 0;
+            if (!frame || frame.length !== stride * h) {
+                if (delta) return;
+                frame = new Uint8Array(stride * h);
+            }
+            if (!unpack(bytes, frame, delta)) {
+                frame = null;   // Wait for the next keyframe
+                return;
+            }
+            if (canvas.width !== w || canvas.height !== h) {
+                canvas.width = w;
+                canvas.height = h;
+            }
+            const image = ctx.createImageData(w, h);
+            const px = image.data;
+            for (let y = 0; y < h; y++) {
+                const row = y * stride;
+                for (let x = 0; x < w; x++) {
+                    const c = 8 + 3 * ((frame[row + (x >> 2)] >> (6 - 2 * (x & 3))) & 3);
+                    const o = (y * w + x) * 4;
+                    px[o] = bytes[c];
+                    px[o + 1] = bytes[c + 1];
+                    px[o + 2] = bytes[c + 2];
+                    px[o + 3] = 255;
+                }
+            }
+            ctx.putImageData(image, 0, 0);
+        }
+        
+        function startPixel() {
+            img.src = '';
+            img.style.display = 'none';
+            canvas.style.display = 'block';
+            modeBtn.textContent = 'JPEG';
+            ws = new WebSocket('ws://' + location.hostname + ':' + wsPort + '/');
+            ws.binaryType = 'arraybuffer';
+            frame = null;
+            ws.onmessage = (e) => drawPacket(e.data);
+            ws.onopen = () => { status.textContent = 'Conectado (pixel)'; status.style.color = '#00ff88'; };
+            ws.onclose = () => {
+                if (!ws) return;
+                status.textContent = 'Desconectado';
+                status.style.color = '#ff4444';
+                setTimeout(() => { if (ws) startPixel(); }, 2000);
+            };
+        }
+        
+        function stopPixel() {
+            const old = ws;
+            ws = null;
+            if (old) old.close();
+            canvas.style.display = 'none';
+            img.style.display = 'block';
+            img.src = jpegPath + '?' + Date.now();
+            modeBtn.textContent = 'Pixel';
+        }
+        
+        function toggleMode() {
+            if (ws) stopPixel(); else startPixel();
+        }
+        
+        // The benchmark needs the camera: close the streams, ask until the
+        // camera is free, then wait for the CSV
+        function runBench() {
+            const old = ws;
+            ws = null;
+            if (old) old.close();
+            img.style.display = 'none';
+            canvas.style.display = 'none';
+            img.src = '';
+            status.textContent = 'Benchmark...';
+            status.style.color = '#00d4ff';
+            const wait = () => fetch('/bench').then((r) => {
+                if (r.ok) location.href = '/bench'; else setTimeout(wait, 3000);
+            }).catch(() => setTimeout(wait, 3000));
+            const start = () => fetch('/bench?run=1').then((r) => {
+                setTimeout(r.status === 202 ? wait : start, r.status === 202 ? 3000 : 1000);
+            }).catch(() => setTimeout(start, 1000));
+            start();
+        }
+        
+        fetch('/status').then((r) => r.json()).then((s) => {
+            if (!s.bench) document.getElementById('bench').style.display = 'none';
+            if (!s.ws_port) { modeBtn.style.display = 'none'; return; }
+            wsPort = s.ws_port;
+            if (s.format === 'ws') startPixel();
+        }).catch(() => {});
     </script>
 </body>
 </html>
@@ -157,17 +783,88 @@ const char kIndexHtml[] PROGMEM = R"rawliteral(
 // WifiPreview Implementation
 // =============================================================================
 
+/// What a sender task serves
+enum class WifiPreview::SessionKind : uint8_t {
+    Mjpeg,      ///< /stream multipart JPEG
+    Still,      ///< Single /capture image
+    WebSocket,  ///< Stylized 2bpp frames on wsPort
+    FileList,   ///< /files DCIM listing page
+    File,       ///< /files/<name> download
+    Metrics,    ///< /metrics scrape
+    Stylized,   ///< /stylized multipart JPEG of the dithered frame
+    Trace       ///< /trace.json event trace
+};
+
+/// What a /files request asked for (parsed by the handler)
+struct WifiPreview::FileRequest {
+    char name[kFileNameMax] = {};
+    char range[48] = {};        ///< Raw Range header ("" = whole file)
+    uint32_t page = 0;
+};
+
+/// One client connection owned by a sender task
+struct WifiPreview::Session {
+    WifiPreview* owner;
+    WiFiClient client;
+    SessionKind kind;
+    FileRequest file;
+};
+
 struct WifiPreview::Impl {
     WifiPreviewConfig config;
     WifiPreviewStatus status;
     WebServer* server;
     bool initialized;
-    bool streaming;
+    std::atomic<bool> streaming;
     uint32_t lastFrameTime;
     uint32_t frameInterval;
     
+    // Shared capture: one producer task, one slot ring per format, N readers
+    stream::FrameRing ring;
+    stream::FrameRing wsRing;
+    stream::FrameRing styledRing;
+    stream::StylizedEncoder stylized;
+    WiFiServer* wsServer;
+    TaskHandle_t captureTask;
+    std::atomic<bool> captureRunning;
+    frames::ConsumerId stillConsumer;       ///< /capture without a stream (senders share it)
+    std::atomic<uint8_t> streamClients;     ///< MJPEG readers (drive the capture task)
+    std::atomic<uint8_t> wsClients;         ///< WebSocket readers
+    std::atomic<uint8_t> styledClients;     ///< /stylized readers
+    std::atomic<uint8_t> sessions;          ///< Live sender tasks (stream + still + ws)
+    
+    // Counters written by the sender tasks
+    std::atomic<uint32_t> framesServed;
+    std::atomic<uint32_t> bytesServed;
+    std::atomic<uint32_t> framesSkipped;
+    std::atomic<uint32_t> wsRawBytes;       ///< Stylized packets before delta/RLE
+    std::atomic<uint32_t> wsWireBytes;      ///< ...and as sent
+    
+    // Adaptive quality: each MJPEG client votes what its link can take and
+    // the capture task encodes for the best of them
+    ClientSlot clients[kMaxClientSlots];
+    uint8_t streamQuality;                  ///< Quality of the last MJPEG frame
+    int sensorQualityRestore;               ///< Sensor quality before streaming (-1 = untouched)
+    uint32_t lastStationPoll;
+    
+    // Power policy
+    std::atomic<uint8_t> pipelineUsers;     ///< Stream sessions that need the capture pipeline
+    std::atomic<bool> stationEvent;         ///< Set by WiFi events: re-check stations now
+    bool pipelineUp;
+    bool idle;                              ///< Nobody to serve: pipeline down, modem sleep
+    uint32_t idleSinceMs;
+    uint32_t pipelineIdleSinceMs;
+    wifi_event_id_t eventIds[2];
+    
     Impl() : server(nullptr), initialized(false), streaming(false),
-             lastFrameTime(0), frameInterval(67) {} // ~15fps
+             lastFrameTime(0), frameInterval(67), // ~15fps
+             wsServer(nullptr), captureTask(nullptr), captureRunning(false),
+             stillConsumer(frames::kNoConsumer),
+             streamClients(0), wsClients(0), styledClients(0), sessions(0),
+             framesServed(0), bytesServed(0), framesSkipped(0),
+             wsRawBytes(0), wsWireBytes(0), streamQuality(0), sensorQualityRestore(-1),
+             lastStationPoll(0), pipelineUsers(0), stationEvent(false), pipelineUp(false),
+             idle(false), idleSinceMs(0), pipelineIdleSinceMs(0), eventIds{0, 0} {}
 };
 
 WifiPreview& WifiPreview::instance() {
@@ -212,17 +909,17 @@ bool WifiPreview::start() {
         return true;
     }
     
-    // Start WiFi AP
-    PXLCAM_LOGI_TAG(kLogTag, "Starting WiFi AP: %s", m_impl->config.ssid);
-    
-    WiFi.mode(WIFI_AP);
-    WiFi.softAP(m_impl->config.ssid, m_impl->config.password, m_impl->config.channel);
+    if (!startNetwork()) {
+        return false;
+    }
     
-    IPAddress ip = WiFi.softAPIP();
-    snprintf(m_impl->status.ipAddress, sizeof(m_impl->status.ipAddress),
-             "%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
+    // Full power until updatePower() sees nobody to serve
+    WiFi.setSleep(false);
     
-    PXLCAM_LOGI_TAG(kLogTag, "AP started, IP: %s", m_impl->status.ipAddress);
+    // Still requests share one consumer; its mutex orders concurrent ones
+    if (m_impl->stillConsumer == frames::kNoConsumer) {
+        m_impl->stillConsumer = frames::registerConsumer("wifi_still", frames::Need::Latest);
+    }
     
     // Create HTTP server
     m_impl->server = new WebServer(m_impl->config.httpPort);
@@ -233,7 +930,11 @@ bool WifiPreview::start() {
     });
     
     m_impl->server->on("/stream", HTTP_GET, [this]() {
-        handleStream();
+        handleStream(false);
+    });
+    
+    m_impl->server->on("/stylized", HTTP_GET, [this]() {
+        handleStream(true);
     });
     
     m_impl->server->on("/capture", HTTP_GET, [this]() {
@@ -244,10 +945,63 @@ bool WifiPreview::start() {
         handleStatus();
     });
     
+    m_impl->server->on("/metrics", HTTP_GET, [this]() {
+        if (!startSession(SessionKind::Metrics, m_impl->server->client())) {
+            m_impl->server->send(503, "text/plain", "Too many clients");
+        }
+    });
+    
+    m_impl->server->on("/trace.json", HTTP_GET, [this]() {
+        if (!startSession(SessionKind::Trace, m_impl->server->client())) {
+            m_impl->server->send(503, "text/plain", "Too many clients");
+        }
+    });
+    
+    m_impl->server->on("/files", HTTP_GET, [this]() {
+        handleFiles();
+    });
+    
+    m_impl->server->on("/bench", HTTP_GET, [this]() {
+        handleBench();
+    });
+    
+    // /files/<name>: WebServer has no prefix routes, so match it here
+    m_impl->server->onNotFound([this]() {
+        const String uri = m_impl->server->uri();
+        if (strncmp(uri.c_str(), "/files/", 7) == 0) {
+            handleFile(uri.c_str() + 7);
+        } else {
+            m_impl->server->send(404, "text/plain", "Not found");
+        }
+    });
+    
+    static const char* kCollectedHeaders[] = { "Range" };
+    m_impl->server->collectHeaders(kCollectedHeaders, 1);
+    
     m_impl->server->begin();
     PXLCAM_LOGI_TAG(kLogTag, "HTTP server started on port %d", m_impl->config.httpPort);
     
+    // Stylized WebSocket stream; the capture pipeline behind both streams
+    // is brought up by the first client (see startPipeline())
+    m_impl->wsServer = new WiFiServer(m_impl->config.wsPort);
+    m_impl->wsServer->begin();
+    PXLCAM_LOGI_TAG(kLogTag, "WebSocket stream on port %d (%dx%d, 2bpp)",
+                    m_impl->config.wsPort, PXLCAM_WS_STREAM_W, PXLCAM_WS_STREAM_H);
+    
+    // Association changes wake tick() out of its idle polling
+    if (m_impl->config.mode != WifiMode::STA) {
+        auto onStation = [this](arduino_event_id_t, arduino_event_info_t) {
+            m_impl->stationEvent = true;
+        };
+        m_impl->eventIds[0] = WiFi.onEvent(onStation, ARDUINO_EVENT_WIFI_AP_STACONNECTED);
+        m_impl->eventIds[1] = WiFi.onEvent(onStation, ARDUINO_EVENT_WIFI_AP_STADISCONNECTED);
+    }
+    
     m_impl->streaming = true;
+    m_impl->idle = false;
+    m_impl->idleSinceMs = millis();
+    m_impl->pipelineIdleSinceMs = millis();
+    m_impl->stationEvent = true;
     m_impl->status.initialized = true;
     m_impl->status.connected = true;
     m_impl->status.streaming = true;
@@ -255,17 +1009,144 @@ bool WifiPreview::start() {
     return true;
 }
 
+bool WifiPreview::startPipeline() {
+    if (m_impl->pipelineUp) {
+        return true;
+    }
+    
+    // Shared capture for all stream clients
+    if (!m_impl->ring.begin(PXLCAM_STREAM_SLOTS)) {
+        PXLCAM_LOGE_TAG(kLogTag, "Stream ring allocation failed");
+        return false;
+    }
+    m_impl->captureRunning = true;
+    if (xTaskCreatePinnedToCore(captureTaskEntry, "wifi_cap", PXLCAM_STREAM_TASK_STACK,
+                                this, PXLCAM_STREAM_TASK_PRIORITY, &m_impl->captureTask,
+                                PXLCAM_STREAM_CAPTURE_CORE) != pdPASS) {
+        m_impl->captureRunning = false;
+        m_impl->captureTask = nullptr;
+        m_impl->ring.end();
+        PXLCAM_LOGE_TAG(kLogTag, "Stream capture task failed to start");
+        return false;
+    }
+    
+    // Stylized packets (and their JPEGs) come from the same capture task
+    if (!m_impl->stylized.begin(PXLCAM_WS_STREAM_W, PXLCAM_WS_STREAM_H,
+                                PXLCAM_STYLIZED_MJPEG_QUALITY) ||
+        !m_impl->wsRing.begin(PXLCAM_STREAM_SLOTS) ||
+        !m_impl->styledRing.begin(PXLCAM_STREAM_SLOTS)) {
+        m_impl->stylized.end();
+        m_impl->wsRing.end();
+        PXLCAM_LOGW_TAG(kLogTag, "Stylized streams unavailable");
+    }
+    
+    m_impl->pipelineUp = true;
+    PXLCAM_LOGI_TAG(kLogTag, "Stream pipeline up");
+    return true;
+}
+
+void WifiPreview::stopPipeline() {
+    if (!m_impl->pipelineUp) {
+        return;
+    }
+    
+    // The capture task clears its handle on exit; only then is the ring free
+    m_impl->captureRunning = false;
+    const uint32_t stopStart = millis();
+    while (m_impl->captureTask && millis() - stopStart < kCaptureStopMs) {
+        delay(10);
+    }
+    if (m_impl->captureTask || m_impl->pipelineUsers > 0) {
+        PXLCAM_LOGW_TAG(kLogTag, "Stream tasks did not stop, keeping the ring");
+        return;
+    }
+    m_impl->ring.end();
+    m_impl->wsRing.end();
+    m_impl->styledRing.end();
+    m_impl->stylized.end();
+    m_impl->pipelineUp = false;
+    PXLCAM_LOGI_TAG(kLogTag, "Stream pipeline down");
+}
+
+bool WifiPreview::startNetwork() {
+    const WifiMode mode = m_impl->config.mode;
+    IPAddress ip;
+    if (mode == WifiMode::OFF) {
+        PXLCAM_LOGE_TAG(kLogTag, "WiFi mode is OFF");
+        return false;
+    }
+    
+    if (mode == WifiMode::AP || mode == WifiMode::AP_STA) {
+        PXLCAM_LOGI_TAG(kLogTag, "Starting WiFi AP: %s", m_impl->config.ssid);
+        WiFi.mode(mode == WifiMode::AP ? WIFI_AP : WIFI_AP_STA);
+        WiFi.softAP(m_impl->config.ssid, m_impl->config.password, m_impl->config.channel);
+        ip = WiFi.softAPIP();
+    }
+    
+    // AP+STA joins the network with the AP's own credentials
+    if (mode == WifiMode::STA || mode == WifiMode::AP_STA) {
+        PXLCAM_LOGI_TAG(kLogTag, "Joining WiFi network: %s", m_impl->config.ssid);
+        const sta::ConnectResult result = sta::connect(m_impl->config.ssid, m_impl->config.password);
+        if (result != sta::ConnectResult::Failed) {
+            ip = WiFi.localIP();
+        } else if (mode == WifiMode::STA) {
+            WiFi.mode(WIFI_OFF);
+            return false;
+        }
+    }
+    
+    snprintf(m_impl->status.ipAddress, sizeof(m_impl->status.ipAddress),
+             "%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
+    PXLCAM_LOGI_TAG(kLogTag, "Network up, IP: %s", m_impl->status.ipAddress);
+    energy::setRadioOn(true);
+    return true;
+}
+
 void WifiPreview::stop() {
+    // Senders notice within one frame wait (or one stalled write) and exit
+    m_impl->streaming = false;
+    const uint32_t sessionStopStart = millis();
+    while (m_impl->sessions > 0 &&
+           millis() - sessionStopStart < kStreamWaitMs + PXLCAM_STREAM_SEND_TIMEOUT_MS) {
+        delay(10);
+    }
+    if (m_impl->sessions > 0) {
+        PXLCAM_LOGW_TAG(kLogTag, "%u stream sender(s) still running", m_impl->sessions.load());
+    } else {
+        // A sender still running may be inside acquire(): kept for the next start()
+        frames::unregisterConsumer(m_impl->stillConsumer);
+        m_impl->stillConsumer = frames::kNoConsumer;
+    }
+    
     if (m_impl->server) {
         m_impl->server->stop();
         delete m_impl->server;
         m_impl->server = nullptr;
     }
+    if (m_impl->wsServer) {
+        m_impl->wsServer->stop();
+        delete m_impl->wsServer;
+        m_impl->wsServer = nullptr;
+    }
     
-    WiFi.softAPdisconnect(true);
+    stopPipeline();
+    
+    for (wifi_event_id_t& id : m_impl->eventIds) {
+        if (id) {
+            WiFi.removeEvent(id);
+            id = 0;
+        }
+    }
+    
+    if (m_impl->config.mode != WifiMode::AP) {
+        WiFi.disconnect(true);
+    }
+    if (m_impl->config.mode != WifiMode::STA) {
+        WiFi.softAPdisconnect(true);
+    }
     WiFi.mode(WIFI_OFF);
+    energy::setRadioOn(false);
     
-    m_impl->streaming = false;
     m_impl->status.connected = false;
     m_impl->status.streaming = false;
     
@@ -279,21 +1160,99 @@ bool WifiPreview::isActive() const {
 void WifiPreview::tick() {
     if (!m_impl->streaming || !m_impl->server) return;
     
+    const uint32_t tickStart = micros();
+    const uint32_t now = millis();
+    
+    // An AP nobody has joined can't receive requests: poll stations only
+    if (m_impl->idle && m_impl->config.mode == WifiMode::AP && !m_impl->stationEvent &&
+        now - m_impl->lastStationPoll < kIdleStationPollMs) {
+        return;
+    }
+    
+    // Handlers only parse and hand sockets to sender tasks, so this stays short
     m_impl->server->handleClient();
-    m_impl->status.clientCount = WiFi.softAPgetStationNum();
+    
+    // WebSocket clients are accepted here and upgraded by their own task
+    if (m_impl->wsServer) {
+        WiFiClient wsClient = m_impl->wsServer->available();
+        if (wsClient && (!startPipeline() || !m_impl->wsRing.isReady() ||
+                         !startSession(SessionKind::WebSocket, wsClient))) {
+            wsClient.stop();
+        }
+    }
+    
+    if (m_impl->stationEvent.exchange(false) || now - m_impl->lastStationPoll >= kStationPollMs) {
+        m_impl->lastStationPoll = now;
+        // On someone else's network only our own sessions are countable
+        m_impl->status.clientCount = m_impl->config.mode == WifiMode::STA
+            ? m_impl->sessions.load()
+            : WiFi.softAPgetStationNum();
+        m_impl->status.connected = m_impl->config.mode != WifiMode::STA ||
+                                   WiFi.status() == WL_CONNECTED;
+        updatePower(now);
+        if (!m_impl->streaming) {
+            return;     // Auto-off
+        }
+    }
+    
+    const uint32_t tickUs = micros() - tickStart;
+    if (tickUs > m_impl->status.tickMaxUs) {
+        m_impl->status.tickMaxUs = tickUs;
+    }
+}
+
+void WifiPreview::updatePower(uint32_t now) {
+    // The pipeline follows stream sessions, with a grace period for reconnects
+    if (m_impl->pipelineUsers > 0) {
+        m_impl->pipelineIdleSinceMs = now;
+    } else if (m_impl->pipelineUp && now - m_impl->pipelineIdleSinceMs >= PXLCAM_WIFI_PIPELINE_IDLE_MS) {
+        stopPipeline();
+    }
+    
+    // Idle: no station on our AP (or, on someone else's network, no session)
+    const bool idle = m_impl->config.mode == WifiMode::STA
+        ? m_impl->sessions == 0
+        : m_impl->status.clientCount == 0 && m_impl->sessions == 0;
+    if (idle != m_impl->idle) {
+        m_impl->idle = idle;
+        m_impl->idleSinceMs = now;
+        
+        // Modem sleep costs latency and throughput, so only while nobody is served
+        WiFi.setSleep(idle);
+        PXLCAM_LOGI_TAG(kLogTag, idle ? "Idle: modem sleep on" : "Client present: modem sleep off");
+    }
+    
+    const uint32_t autoOffMs = m_impl->config.autoOffMs;
+    if (idle && autoOffMs > 0 && now - m_impl->idleSinceMs >= autoOffMs) {
+        PXLCAM_LOGI_TAG(kLogTag, "No clients for %lu s, turning WiFi off",
+                        static_cast<unsigned long>(autoOffMs / 1000));
+        stop();
+    }
 }
 
 uint8_t WifiPreview::sendFrame(const uint8_t* frameData, size_t frameSize) {
-    if (!m_impl->streaming) return 0;
+    if (!m_impl->streaming || !frameData || frameSize == 0) return 0;
     
-    m_impl->status.framesServed++;
-    m_impl->status.bytesServed += frameSize;
+    // Published like a captured frame; every stream client picks it up
+    uint8_t* slot = m_impl->ring.reserve(frameSize);
+    if (!slot) return 0;
+    memcpy(slot, frameData, frameSize);
+    m_impl->ring.publish(frameSize, millis());
     
-    return m_impl->status.clientCount;
+    return m_impl->streamClients;
 }
 
 WifiPreviewStatus WifiPreview::getStatus() const {
-    return m_impl->status;
+    WifiPreviewStatus status = m_impl->status;
+    status.streaming = m_impl->streaming;
+    status.framesServed = m_impl->framesServed;
+    status.bytesServed = m_impl->bytesServed;
+    status.framesSkipped = m_impl->framesSkipped;
+    status.streamClients = m_impl->streamClients + m_impl->wsClients + m_impl->styledClients;
+    status.framesCaptured = m_impl->ring.getPublished();
+    status.framesDropped = m_impl->ring.getDropped();
+    status.idle = m_impl->idle;
+    return status;
 }
 
 String WifiPreview::getIPAddress() const {
@@ -308,73 +1267,971 @@ void WifiPreview::setQuality(uint8_t quality) {
     m_impl->config.quality = quality;
 }
 
+void WifiPreview::setAutoOffTimeout(uint32_t ms) {
+    m_impl->config.autoOffMs = ms;
+}
+
 void WifiPreview::setTargetFps(uint8_t fps) {
+    if (fps == 0) return;
     m_impl->config.targetFps = fps;
     m_impl->frameInterval = 1000 / fps;
 }
 
+// =============================================================================
+// Stream Capture Task
+// =============================================================================
+
+void WifiPreview::captureTaskEntry(void* arg) {
+    static_cast<WifiPreview*>(arg)->captureLoop();
+    vTaskDelete(nullptr);
+}
+
+void WifiPreview::captureLoop() {
+    uint8_t pacedFps = m_impl->config.targetFps;
+    pxlcam::util::FramePacer pacer;
+    pacer.begin(pacedFps);
+    const frames::ConsumerId consumer = frames::registerConsumer("wifi_stream", frames::Need::Latest);
+    
+    while (m_impl->captureRunning) {
+        // Nobody watching: don't touch the camera
+        const bool mjpeg = m_impl->streamClients > 0;
+        const bool stylized = m_impl->wsClients > 0;
+        const bool styledJpeg = m_impl->styledClients > 0;
+        if (!mjpeg) {
+            restoreSensorQuality();
+        }
+        if (!mjpeg && !stylized && !styledJpeg) {
+            vTaskDelay(pdMS_TO_TICKS(kCaptureIdleMs));
+            pacer.resync();
+            continue;
+        }
+        
+        if (m_impl->config.targetFps != pacedFps) {
+            pacedFps = m_impl->config.targetFps;
+            pacer.begin(pacedFps);
+        }
+        
+        const uint8_t quality = mjpeg ? streamQualityVote() : 0;
+        if (mjpeg) {
+            applySensorQuality(quality);
+        }
+        
+        PXLCAM_TRACE_SPAN(grab, StreamGrab, 0);
+        camera_fb_t* fb = frames::acquire(consumer);
+        if (!fb) {
+            PXLCAM_LOGE_TAG(kLogTag, "Camera capture failed");
+            vTaskDelay(pdMS_TO_TICKS(100));
+            pacer.resync();
+            continue;
+        }
+        
+        // Stylized packet straight from the frame (decode + dither), dithered
+        // once for both the WebSocket and the /stylized clients
+        if (stylized || styledJpeg) {
+            stream::StylizedEncoder& encoder = m_impl->stylized;
+            uint8_t* wsSlot = stylized ? m_impl->wsRing.reserve(encoder.packetSize()) : nullptr;
+            uint8_t* packet = wsSlot ? wsSlot : encoder.packetScratch();
+            const bool encoded = encoder.encode(fb, packet);
+            
+            if (encoded && styledJpeg) {
+                const size_t capacity = encoder.jpegCapacity(PXLCAM_STYLIZED_MJPEG_SCALE);
+                uint8_t* slot = m_impl->styledRing.reserve(capacity);
+                const size_t len = slot ? encoder.packetToJpeg(packet, PXLCAM_STYLIZED_MJPEG_SCALE,
+                                                               slot, capacity) : 0;
+                if (len > 0) {
+                    m_impl->styledRing.publish(len, millis());
+                } else if (slot) {
+                    m_impl->styledRing.cancel();
+                }
+            }
+            
+            if (wsSlot && encoded) {
+                m_impl->wsRing.publish(encoder.packetSize(), millis());
+            } else if (wsSlot) {
+                m_impl->wsRing.cancel();
+            }
+        }
+        
+        // The framebuffer is held only for the copy, never for a client write
+        uint8_t* slot = nullptr;
+        size_t len = 0;
+        JpegView jpeg;
+        if (mjpeg && frameToJpeg(fb, jpeg, quality)) {
+            slot = m_impl->ring.reserve(jpeg.len);
+            if (slot) {
+                memcpy(slot, jpeg.buf, jpeg.len);
+            }
+            len = jpeg.len;
+            releaseJpeg(jpeg);
+        } else if (mjpeg) {
+            PXLCAM_LOGE_TAG(kLogTag, "JPEG encode failed");
+        }
+        frames::release(fb);
+        
+        if (slot) {
+            m_impl->ring.publish(len, millis());
+        }
+        grab.setArg(len);
+        grab.end();
+        
+        pacer.endFrame();
+    }
+    
+    frames::unregisterConsumer(consumer);
+    restoreSensorQuality();
+    m_impl->captureTask = nullptr;
+}
+
+uint8_t WifiPreview::streamQualityVote() const {
+    uint8_t best = 0;
+    for (const ClientSlot& slot : m_impl->clients) {
+        const uint8_t q = slot.kind == kSlotMjpeg ? slot.quality.load() : 0;
+        if (q > best) best = q;
+    }
+    return best > 0 ? best : m_impl->config.quality;
+}
+
+void WifiPreview::applySensorQuality(uint8_t quality) {
+    const uint8_t previous = m_impl->streamQuality;
+    m_impl->streamQuality = quality;
+    
+    sensor_t* sensor = esp_camera_sensor_get();
+    if (!sensor || sensor->pixformat != PIXFORMAT_JPEG || !sensor->set_quality) {
+        return;
+    }
+    const uint8_t delta = quality > previous ? quality - previous : previous - quality;
+    if (m_impl->sensorQualityRestore >= 0 && delta < kQualityApplyStep) {
+        m_impl->streamQuality = previous;   // Keep measuring against what is applied
+        return;
+    }
+    if (m_impl->sensorQualityRestore < 0) {
+        m_impl->sensorQualityRestore = sensor->status.quality;
+    }
+    sensor->set_quality(sensor, sensorQualityFor(quality));
+}
+
+void WifiPreview::restoreSensorQuality() {
+    if (m_impl->sensorQualityRestore < 0) {
+        return;
+    }
+    sensor_t* sensor = esp_camera_sensor_get();
+    if (sensor && sensor->set_quality) {
+        sensor->set_quality(sensor, m_impl->sensorQualityRestore);
+    }
+    m_impl->sensorQualityRestore = -1;
+    m_impl->streamQuality = 0;
+}
+
 // =============================================================================
 // HTTP Handlers
 // =============================================================================
 
-void WifiPreview::handleStream() {
-    WiFiClient client = m_impl->server->client();
+void WifiPreview::handleStream(bool stylized) {
+    const bool ready = startPipeline() &&
+                       (stylized ? m_impl->styledRing.isReady() : m_impl->ring.isReady());
+    if (!ready) {
+        m_impl->server->send(503, "text/plain", "Stream unavailable");
+        PXLCAM_LOGE_TAG(kLogTag, "MJPEG stream refused: no capture ring");
+        return;
+    }
+    if (!startSession(stylized ? SessionKind::Stylized : SessionKind::Mjpeg,
+                      m_impl->server->client())) {
+        m_impl->server->send(503, "text/plain", "Too many clients");
+    }
+}
+
+void WifiPreview::handleCapture() {
+    if (!startSession(SessionKind::Still, m_impl->server->client())) {
+        m_impl->server->send(503, "text/plain", "Too many clients");
+    }
+}
+
+// =============================================================================
+// Client Sender Tasks
+// =============================================================================
+
+bool WifiPreview::startSession(SessionKind kind, const WiFiClient& client,
+                               const FileRequest* file) {
+    if (m_impl->sessions >= m_impl->config.maxClients) {
+        PXLCAM_LOGW_TAG(kLogTag, "Client refused: %u sessions already", m_impl->sessions.load());
+        return false;
+    }
+    
+    // The sender task owns a copy of the socket; WebServer drops its own
+    // reference when the handler returns without closing the connection
+    Session* session = new Session{this, client, kind, FileRequest()};
+    if (file) {
+        session->file = *file;
+    }
+    static const char* const kTaskNames[] = { "wifi_tx", "wifi_still", "wifi_ws",
+                                              "wifi_ls", "wifi_file", "wifi_metrics",
+                                              "wifi_styled", "wifi_trace" };
     
+    // Downloads yield to the live stream: they only get the CPU it leaves
+    const bool bulk = kind == SessionKind::FileList || kind == SessionKind::File;
+    const bool usesPipeline = kind == SessionKind::Mjpeg || kind == SessionKind::WebSocket ||
+                              kind == SessionKind::Stylized;
+    m_impl->sessions++;
+    if (usesPipeline) {
+        m_impl->pipelineUsers++;
+    }
+    if (xTaskCreatePinnedToCore(senderTaskEntry, kTaskNames[static_cast<int>(kind)],
+                                PXLCAM_STREAM_SENDER_STACK, session,
+                                bulk ? PXLCAM_FILES_TASK_PRIORITY : PXLCAM_STREAM_TASK_PRIORITY,
+                                nullptr,
+                                PXLCAM_STREAM_CAPTURE_CORE) != pdPASS) {
+        m_impl->sessions--;
+        if (usesPipeline) {
+            m_impl->pipelineUsers--;
+        }
+        delete session;
+        PXLCAM_LOGE_TAG(kLogTag, "Sender task failed to start");
+        return false;
+    }
+    return true;
+}
+
+void WifiPreview::senderTaskEntry(void* arg) {
+    Session* session = static_cast<Session*>(arg);
+    WifiPreview* self = session->owner;
+    session->client.setNoDelay(true);
+    
+    switch (session->kind) {
+        case SessionKind::Mjpeg:     self->serveStream(session->client, false); break;
+        case SessionKind::Still:     self->serveCapture(session->client); break;
+        case SessionKind::WebSocket: self->serveWebSocket(session->client); break;
+        case SessionKind::FileList:  self->serveFileList(session->client, session->file); break;
+        case SessionKind::File:      self->serveFile(session->client, session->file); break;
+        case SessionKind::Metrics:   self->serveMetrics(session->client); break;
+        case SessionKind::Stylized:  self->serveStream(session->client, true); break;
+        case SessionKind::Trace:     self->serveTrace(session->client); break;
+    }
+    
+    session->client.stop();
+    if (session->kind == SessionKind::Mjpeg || session->kind == SessionKind::WebSocket ||
+        session->kind == SessionKind::Stylized) {
+        self->m_impl->pipelineUsers--;
+    }
+    delete session;
+    self->m_impl->sessions--;
+    vTaskDelete(nullptr);
+}
+
+void WifiPreview::serveStream(WiFiClient& client, bool stylized) {
     // Send MJPEG headers
-    String response = "HTTP/1.1 200 OK\r\n";
-    response += "Content-Type: multipart/x-mixed-replace; boundary=frame\r\n\r\n";
-    client.print(response);
+    if (!writeAll(client, "HTTP/1.1 200 OK\r\n"
+                          "Content-Type: multipart/x-mixed-replace; boundary=frame\r\n\r\n",
+                  PXLCAM_STREAM_SEND_TIMEOUT_MS)) {
+        return;
+    }
     
-    PXLCAM_LOGI_TAG(kLogTag, "MJPEG stream started for client");
+    PXLCAM_LOGI_TAG(kLogTag, "%s stream started for client", stylized ? "Stylized" : "MJPEG");
+    std::atomic<uint8_t>& readers = stylized ? m_impl->styledClients : m_impl->streamClients;
+    stream::FrameRing& ring = stylized ? m_impl->styledRing : m_impl->ring;
+    readers++;
     
-    while (client.connected()) {
-        camera_fb_t* fb = esp_camera_fb_get();
-        if (!fb) {
-            PXLCAM_LOGE_TAG(kLogTag, "Camera capture failed");
-            delay(100);
+    // This client's link decides its pacing and its quality vote (the
+    // stylized JPEG has a fixed quality, so there only the pacing applies)
+    stream::RateConfig rateConfig;
+    rateConfig.latencyMs = PXLCAM_STREAM_LATENCY_MS;
+    rateConfig.minIntervalMs = 1000 / m_impl->config.targetFps;
+    rateConfig.maxIntervalMs = kMaxClientIntervalMs;
+    rateConfig.minQuality = PXLCAM_STREAM_MIN_QUALITY;
+    rateConfig.maxQuality = m_impl->config.quality;
+    stream::RateController rate;
+    rate.begin(rateConfig);
+    
+    ClientSlot* slot = claimClientSlot(m_impl->clients, stylized ? kSlotStylized : kSlotMjpeg);
+    if (slot) {
+        slot->quality = rate.quality();
+    }
+    
+    // Frames are paced by the capture task; a slow client skips to the newest
+    uint32_t lastSeq = ring.getLatestSeq();
+    uint32_t sent = 0;
+    uint32_t skipped = 0;
+    uint32_t lastSendMs = 0;
+    
+    while (m_impl->streaming && client.connected()) {
+        // Hold off until this client's link has drained the previous frame
+        const uint32_t sinceSend = millis() - lastSendMs;
+        if (sent > 0 && sinceSend < rate.intervalMs()) {
+            const uint32_t waitMs = rate.intervalMs() - sinceSend;
+            vTaskDelay(pdMS_TO_TICKS(waitMs < kStreamWaitMs ? waitMs : kStreamWaitMs));
             continue;
         }
         
-        // Send frame
-        client.printf("--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n", fb->len);
-        client.write(fb->buf, fb->len);
-        client.print("\r\n");
+        stream::FrameRef frame;
+        if (!ring.waitNewer(lastSeq, frame, kStreamWaitMs)) {
+            continue;
+        }
+        if (sent > 0) {
+            skipped += frame.seq - lastSeq - 1;
+            m_impl->framesSkipped += frame.seq - lastSeq - 1;
+        }
+        lastSeq = frame.seq;
         
-        m_impl->status.framesServed++;
-        m_impl->status.bytesServed += fb->len;
+        // Send frame; a stalled socket blocks this client only
+        char header[96];
+        snprintf(header, sizeof(header),
+                 "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n",
+                 static_cast<unsigned>(frame.len));
+        lastSendMs = millis();
+        const uint32_t sendStart = micros();
+        PXLCAM_TRACE_SPAN(send, StreamSend, frame.len);
+        const bool ok = writeAll(client, header, PXLCAM_STREAM_SEND_TIMEOUT_MS) &&
+                        writeAll(client, frame.data, frame.len, PXLCAM_STREAM_SEND_TIMEOUT_MS) &&
+                        writeAll(client, "\r\n", PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        send.end();
+        const uint32_t sendUs = micros() - sendStart;
+        const size_t len = frame.len;
+        ring.release(frame);
+        if (!ok) {
+            break;
+        }
+        
+        rate.onFrameSent(strlen(header) + len + 2, sendUs);
+        if (slot) {
+            slot->quality = rate.quality();
+        }
+        countClientFrame(slot, len);
+        
+        m_impl->framesServed++;
+        m_impl->bytesServed += len;
+        sent++;
+    }
+    
+    releaseClientSlot(slot);
+    readers--;
+    PXLCAM_LOGI_TAG(kLogTag, "%s stream ended (%u sent, %u skipped, q=%u, %u ms/frame, %u B/s)",
+                    stylized ? "Stylized" : "MJPEG", sent, skipped, rate.quality(),
+                    rate.intervalMs(), rate.throughputBps());
+}
+
+void WifiPreview::serveWebSocket(WiFiClient& client) {
+    if (!websocketHandshake(client)) {
+        PXLCAM_LOGW_TAG(kLogTag, "WebSocket handshake failed");
+        return;
+    }
+    
+    // Per-client reference frame: deltas are against what this browser shows
+    stream::StreamCodec codec;
+    if (!codec.begin(stream::stylizedPacketSize(PXLCAM_WS_STREAM_W, PXLCAM_WS_STREAM_H),
+                     PXLCAM_WS_KEYFRAME_INTERVAL)) {
+        PXLCAM_LOGW_TAG(kLogTag, "WebSocket codec alloc failed");
+        return;
+    }
+    
+    PXLCAM_LOGI_TAG(kLogTag, "WebSocket stream started for client");
+    m_impl->wsClients++;
+    ClientSlot* slot = claimClientSlot(m_impl->clients, kSlotWebSocket);
+    
+    uint32_t lastSeq = m_impl->wsRing.getLatestSeq();
+    uint32_t sent = 0;
+    uint32_t skipped = 0;
+    
+    while (m_impl->streaming && client.connected() && websocketPoll(client)) {
+        stream::FrameRef frame;
+        if (!m_impl->wsRing.waitNewer(lastSeq, frame, kStreamWaitMs)) {
+            continue;
+        }
+        if (sent > 0) {
+            skipped += frame.seq - lastSeq - 1;
+            m_impl->framesSkipped += frame.seq - lastSeq - 1;
+        }
+        lastSeq = frame.seq;
         
-        esp_camera_fb_return(fb);
+        // Coding reads the slot once, so it is released before the write
+        const uint8_t* wire = nullptr;
+        const size_t len = codec.encode(frame.data, frame.len, wire);
+        const size_t rawLen = frame.len;
+        m_impl->wsRing.release(frame);
+        if (len == 0) {
+            continue;
+        }
         
-        // Rate limiting
-        delay(m_impl->frameInterval);
+        uint8_t header[ws::kMaxHeaderBytes];
+        const size_t headerLen = ws::frameHeader(header, ws::kOpBinary, len);
+        PXLCAM_TRACE_SPAN(send, StreamSend, len);
+        const bool ok = writeAll(client, header, headerLen, PXLCAM_STREAM_SEND_TIMEOUT_MS) &&
+                        writeAll(client, wire, len, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        send.end();
+        if (!ok) {
+            break;
+        }
         
-        // Check for client disconnect
-        if (!client.connected()) break;
+        m_impl->framesServed++;
+        m_impl->bytesServed += len;
+        m_impl->wsRawBytes += rawLen;
+        m_impl->wsWireBytes += len;
+        countClientFrame(slot, len);
+        sent++;
     }
     
-    PXLCAM_LOGI_TAG(kLogTag, "MJPEG stream ended");
+    releaseClientSlot(slot);
+    
+    m_impl->wsClients--;
+    PXLCAM_LOGI_TAG(kLogTag, "WebSocket stream ended (%u sent, %u skipped, %u keyframes, %u -> %u bytes)",
+                    sent, skipped, codec.getKeyframes(), codec.getBytesIn(), codec.getBytesOut());
 }
 
-void WifiPreview::handleCapture() {
-    camera_fb_t* fb = esp_camera_fb_get();
+void WifiPreview::serveCapture(WiFiClient& client) {
+    static const char kStillHeader[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: image/jpeg\r\n"
+        "Content-Disposition: inline; filename=capture.jpg\r\n"
+        "Connection: close\r\n"
+        "Content-Length: %u\r\n\r\n";
+    char header[160];
+    
+    // While streaming, the newest shared frame is as fresh as a new capture
+    if (m_impl->streamClients > 0) {
+        stream::FrameRef frame;
+        if (m_impl->ring.acquireLatest(0, frame)) {
+            snprintf(header, sizeof(header), kStillHeader, static_cast<unsigned>(frame.len));
+            if (writeAll(client, header, PXLCAM_STREAM_SEND_TIMEOUT_MS)) {
+                writeAll(client, frame.data, frame.len, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+            }
+            m_impl->ring.release(frame);
+            return;
+        }
+    }
+    
+    // A frame the stream or preview just read serves the still too. Without
+    // a consumer acquire() would read the driver behind the service's back
+    if (m_impl->stillConsumer == frames::kNoConsumer) {
+        writeAll(client, "HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\n\r\n"
+                         "Camera busy", PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        return;
+    }
+    camera_fb_t* fb = frames::acquire(m_impl->stillConsumer);
     if (!fb) {
-        m_impl->server->send(500, "text/plain", "Camera capture failed");
+        writeAll(client, "HTTP/1.1 500 Internal Server Error\r\nConnection: close\r\n\r\n"
+                         "Camera capture failed", PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        return;
+    }
+    
+    JpegView jpeg;
+    if (!frameToJpeg(fb, jpeg, kReencodeJpegQuality)) {
+        frames::release(fb);
+        writeAll(client, "HTTP/1.1 500 Internal Server Error\r\nConnection: close\r\n\r\n"
+                         "JPEG encode failed", PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        return;
+    }
+    
+    snprintf(header, sizeof(header), kStillHeader, static_cast<unsigned>(jpeg.len));
+    if (writeAll(client, header, PXLCAM_STREAM_SEND_TIMEOUT_MS)) {
+        writeAll(client, jpeg.buf, jpeg.len, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+    }
+    
+    releaseJpeg(jpeg);
+    frames::release(fb);
+}
+
+// =============================================================================
+// SD File Server
+// =============================================================================
+
+void WifiPreview::handleFiles() {
+    FileRequest request;
+    if (m_impl->server->hasArg("page")) {
+        request.page = strtoul(m_impl->server->arg("page").c_str(), nullptr, 10);
+    }
+    if (!startSession(SessionKind::FileList, m_impl->server->client(), &request)) {
+        m_impl->server->send(503, "text/plain", "Too many clients");
+    }
+}
+
+void WifiPreview::handleFile(const char* name) {
+    if (!isSafeFileName(name)) {
+        m_impl->server->send(400, "text/plain", "Bad file name");
+        return;
+    }
+    FileRequest request;
+    strncpy(request.name, name, sizeof(request.name) - 1);
+    if (m_impl->server->hasHeader("Range")) {
+        strncpy(request.range, m_impl->server->header("Range").c_str(), sizeof(request.range) - 1);
+    }
+    if (!startSession(SessionKind::File, m_impl->server->client(), &request)) {
+        m_impl->server->send(503, "text/plain", "Too many clients");
+    }
+}
+
+void WifiPreview::serveFileList(WiFiClient& client, const FileRequest& request) {
+    if (SD_MMC.cardType() == CARD_NONE) {
+        writeAll(client, "HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\n\r\n"
+                         "No SD card", PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        return;
+    }
+    File dir = SD_MMC.open(kFilesDir);
+    if (!dir || !dir.isDirectory()) {
+        writeAll(client, "HTTP/1.1 404 Not Found\r\nConnection: close\r\n\r\n"
+                         "No DCIM folder", PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        return;
+    }
+    
+    // Entries are written as they are read; the length is unknown up front
+    char line[kFileNameMax + 64];
+    snprintf(line, sizeof(line),
+             "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\n\r\n"
+             "{\"page\":%u,\"per_page\":%u,\"files\":[",
+             static_cast<unsigned>(request.page), static_cast<unsigned>(PXLCAM_FILES_PAGE_SIZE));
+    bool ok = writeAll(client, line, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+    
+    // Captures live one folder down (storage::captureFolder()); older files
+    // at the top level are listed too
+    const uint32_t skip = request.page * PXLCAM_FILES_PAGE_SIZE;
+    uint32_t index = 0;
+    uint32_t listed = 0;
+    bool more = false;
+    File folder;
+    bool inFolder = false;
+    char folderName[16] = {};
+    while (ok && m_impl->streaming) {
+        File entry = inFolder ? folder.openNextFile() : dir.openNextFile();
+        if (!entry) {
+            if (inFolder) {
+                folder.close();
+                folder = File();
+                inFolder = false;
+                continue;
+            }
+            break;
+        }
+        if (entry.isDirectory()) {
+            const char* sub = baseName(entry.name());
+            if (!inFolder && sub[0] != '.' && strlen(sub) < sizeof(folderName)) {
+                strncpy(folderName, sub, sizeof(folderName));
+                folder = entry;
+                inFolder = true;
+            } else {
+                entry.close();
+            }
+            continue;
+        }
+        if (index++ < skip) {
+            entry.close();
+            continue;
+        }
+        if (listed == PXLCAM_FILES_PAGE_SIZE) {
+            more = true;
+            entry.close();
+            break;
+        }
+        
+        // Names are relative to kFilesDir, as /files/<name> takes them
+        snprintf(line, sizeof(line), "%s{\"name\":\"%s%s%s\",\"size\":%u}",
+                 listed > 0 ? "," : "", inFolder ? folderName : "", inFolder ? "/" : "",
+                 baseName(entry.name()), static_cast<unsigned>(entry.size()));
+        entry.close();
+        ok = writeAll(client, line, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        listed++;
+    }
+    if (inFolder) {
+        folder.close();
+    }
+    dir.close();
+    
+    if (ok) {
+        snprintf(line, sizeof(line), "],\"more\":%s}", more ? "true" : "false");
+        writeAll(client, line, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+    }
+}
+
+void WifiPreview::serveFile(WiFiClient& client, const FileRequest& request) {
+    char path[kFileNameMax + 8];
+    snprintf(path, sizeof(path), "%s/%s", kFilesDir, request.name);
+    
+    File file = SD_MMC.open(path, FILE_READ);
+    if (!file || file.isDirectory()) {
+        writeAll(client, "HTTP/1.1 404 Not Found\r\nConnection: close\r\n\r\n"
+                         "File not found", PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        return;
+    }
+    
+    const uint32_t size = file.size();
+    uint32_t first = 0;
+    uint32_t last = size > 0 ? size - 1 : 0;
+    const bool ranged = request.range[0] != '\0';
+    char header[256];
+    
+    if (ranged && !parseRange(request.range, size, first, last)) {
+        snprintf(header, sizeof(header),
+                 "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%u\r\n"
+                 "Connection: close\r\n\r\n", static_cast<unsigned>(size));
+        writeAll(client, header, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        file.close();
+        return;
+    }
+    
+    const uint32_t length = size > 0 ? last - first + 1 : 0;
+    if (ranged) {
+        snprintf(header, sizeof(header),
+                 "HTTP/1.1 206 Partial Content\r\nContent-Type: %s\r\n"
+                 "Content-Range: bytes %u-%u/%u\r\nContent-Length: %u\r\n"
+                 "Accept-Ranges: bytes\r\nConnection: close\r\n\r\n",
+                 contentTypeFor(request.name), static_cast<unsigned>(first),
+                 static_cast<unsigned>(last), static_cast<unsigned>(size),
+                 static_cast<unsigned>(length));
+    } else {
+        snprintf(header, sizeof(header),
+                 "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %u\r\n"
+                 "Accept-Ranges: bytes\r\nConnection: close\r\n\r\n",
+                 contentTypeFor(request.name), static_cast<unsigned>(length));
+    }
+    
+    uint8_t* chunk = static_cast<uint8_t*>(
+        heap_caps_malloc(kFileChunk, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!chunk) {
+        chunk = static_cast<uint8_t*>(heap_caps_malloc(kFileChunk, MALLOC_CAP_8BIT));
+    }
+    if (!chunk || (first > 0 && !file.seek(first))) {
+        writeAll(client, "HTTP/1.1 500 Internal Server Error\r\nConnection: close\r\n\r\n",
+                 PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        heap_caps_free(chunk);
+        file.close();
         return;
     }
     
-    m_impl->server->sendHeader("Content-Disposition", "inline; filename=capture.jpg");
-    m_impl->server->send_P(200, "image/jpeg", (const char*)fb->buf, fb->len);
+    // One chunk in memory at a time: SD read, socket write, repeat
+    uint32_t remaining = length;
+    bool ok = writeAll(client, header, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+    while (ok && remaining > 0 && m_impl->streaming) {
+        const size_t want = remaining < kFileChunk ? remaining : kFileChunk;
+        const size_t got = file.read(chunk, want);
+        if (got == 0) {
+            PXLCAM_LOGW_TAG(kLogTag, "Read failed in %s", path);
+            break;
+        }
+        ok = writeAll(client, chunk, got, PXLCAM_STREAM_SEND_TIMEOUT_MS);
+        remaining -= got;
+    }
+    
+    heap_caps_free(chunk);
+    file.close();
+    PXLCAM_LOGI_TAG(kLogTag, "Served %s (%u of %u bytes)", request.name,
+                    static_cast<unsigned>(length - remaining), static_cast<unsigned>(length));
+}
+
+// =============================================================================
+// Benchmark
+// =============================================================================
+
+void WifiPreview::handleBench() {
+#if PXLCAM_FEATURE_BENCHMARK
+    // The sweep runs on the app loop; streams would fight it for the camera
+    if (m_impl->server->hasArg("run")) {
+        if (m_impl->streamClients > 0 || m_impl->wsClients > 0 || m_impl->styledClients > 0) {
+            m_impl->server->send(409, "text/plain", "Close the streams first");
+            return;
+        }
+        pxlcam::bench::requestRun();
+        m_impl->server->send(202, "text/plain", "Benchmark requested");
+        return;
+    }
     
-    esp_camera_fb_return(fb);
+    size_t len = 0;
+    const char* csv = pxlcam::bench::results(&len);
+    if (pxlcam::bench::isPending() || !csv) {
+        m_impl->server->send(503, "text/plain", pxlcam::bench::isPending()
+                             ? "Benchmark running" : "No benchmark yet (/bench?run=1)");
+        return;
+    }
+    m_impl->server->setContentLength(len);
+    m_impl->server->sendHeader("Content-Disposition", "inline; filename=bench.csv");
+    m_impl->server->send(200, "text/csv", "");
+    m_impl->server->sendContent(csv, len);
+#else
+    m_impl->server->send(404, "text/plain", "Benchmark not built (PXLCAM_FEATURE_BENCHMARK)");
+#endif
+}
+
+// =============================================================================
+// Metrics
+// =============================================================================
+
+void WifiPreview::serveMetrics(WiFiClient& client) {
+    if (!writeAll(client, "HTTP/1.1 200 OK\r\n"
+                          "Content-Type: text/plain; version=0.0.4\r\n"
+                          "Connection: close\r\n\r\n",
+                  PXLCAM_STREAM_SEND_TIMEOUT_MS)) {
+        return;
+    }
+    
+    MetricsWriter m(client);
+    char labels[64];
+    
+    m.family("pxlcam_uptime_seconds", "gauge", "Seconds since boot");
+    m.value("pxlcam_uptime_seconds", millis() / 1000);
+    
+    // Memory: free, low-water mark and largest block per region
+    struct Region { const char* name; uint32_t caps; };
+    static const Region kRegions[] = {
+        { "internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT },
+        { "psram", MALLOC_CAP_SPIRAM },
+    };
+    m.family("pxlcam_heap_free_bytes", "gauge", "Free heap");
+    for (const Region& r : kRegions) {
+        snprintf(labels, sizeof(labels), "region=\"%s\"", r.name);
+        m.value("pxlcam_heap_free_bytes", labels, static_cast<uint32_t>(heap_caps_get_free_size(r.caps)));
+    }
+    m.family("pxlcam_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+    for (const Region& r : kRegions) {
+        snprintf(labels, sizeof(labels), "region=\"%s\"", r.name);
+        m.value("pxlcam_heap_min_free_bytes", labels,
+                static_cast<uint32_t>(heap_caps_get_minimum_free_size(r.caps)));
+    }
+    m.family("pxlcam_heap_largest_block_bytes", "gauge", "Largest allocatable block");
+    for (const Region& r : kRegions) {
+        snprintf(labels, sizeof(labels), "region=\"%s\"", r.name);
+        m.value("pxlcam_heap_largest_block_bytes", labels,
+                static_cast<uint32_t>(heap_caps_get_largest_free_block(r.caps)));
+    }
+    
+    // Capture stages: rolling window per stage
+    m.family("pxlcam_capture_stage_us", "gauge", "Capture stage time over the rolling window");
+    for (uint8_t i = 0; i < static_cast<uint8_t>(capture::CaptureStage::Count); i++) {
+        const auto stage = static_cast<capture::CaptureStage>(i);
+        capture::StageStats st;
+        capture::getStageStats(stage, st);
+        const char* name = capture::getStageName(stage);
+        snprintf(labels, sizeof(labels), "stage=\"%s\",stat=\"last\"", name);
+        m.value("pxlcam_capture_stage_us", labels, capture::getLastTimings()[stage]);
+        snprintf(labels, sizeof(labels), "stage=\"%s\",stat=\"min\"", name);
+        m.value("pxlcam_capture_stage_us", labels, st.minUs);
+        snprintf(labels, sizeof(labels), "stage=\"%s\",stat=\"avg\"", name);
+        m.value("pxlcam_capture_stage_us", labels, st.avgUs);
+        snprintf(labels, sizeof(labels), "stage=\"%s\",stat=\"p95\"", name);
+        m.value("pxlcam_capture_stage_us", labels, st.p95Us);
+    }
+    
+    // OLED preview
+    const auto& telemetry = preview::getFrameTelemetry();
+    util::TimingSummary ts;
+    telemetry.getFrameSummary(ts);
+    m.family("pxlcam_preview_fps", "gauge", "OLED preview frame rate");
+    m.value("pxlcam_preview_fps", static_cast<uint32_t>(telemetry.getFPS()));
+    m.family("pxlcam_preview_frame_us", "gauge", "OLED preview frame interval");
+    m.value("pxlcam_preview_frame_us", "quantile=\"0.5\"", ts.p50Us);
+    m.value("pxlcam_preview_frame_us", "quantile=\"0.95\"", ts.p95Us);
+    m.value("pxlcam_preview_frame_us", "quantile=\"0.99\"", ts.p99Us);
+    m.family("pxlcam_preview_stalls_total", "counter", "Preview frames over the stall threshold");
+    m.value("pxlcam_preview_stalls_total", telemetry.getStalls());
+    m.family("pxlcam_preview_dropped_frames_total", "counter", "Preview frames overwritten before drawing");
+    m.value("pxlcam_preview_dropped_frames_total", preview::getDroppedFrames());
+    m.family("pxlcam_preview_stage_us", "gauge", "OLED preview stage time (p95)");
+    for (uint8_t i = 0; i < static_cast<uint8_t>(util::FrameStage::Count); i++) {
+        const auto stage = static_cast<util::FrameStage>(i);
+        telemetry.getStageSummary(stage, ts);
+        snprintf(labels, sizeof(labels), "stage=\"%s\"", util::getFrameStageName(stage));
+        m.value("pxlcam_preview_stage_us", labels, ts.p95Us);
+    }
+    
+    // Streaming
+    m.family("pxlcam_stream_frames_total", "counter", "Stream frames by outcome");
+    m.value("pxlcam_stream_frames_total", "outcome=\"served\"", m_impl->framesServed.load());
+    m.value("pxlcam_stream_frames_total", "outcome=\"captured\"", m_impl->ring.getPublished());
+    m.value("pxlcam_stream_frames_total", "outcome=\"skipped\"", m_impl->framesSkipped.load());
+    m.value("pxlcam_stream_frames_total", "outcome=\"dropped\"", m_impl->ring.getDropped());
+    m.family("pxlcam_stream_bytes_total", "counter", "Stream bytes sent");
+    m.value("pxlcam_stream_bytes_total", m_impl->bytesServed.load());
+    m.family("pxlcam_stream_quality", "gauge", "JPEG quality of the shared MJPEG stream");
+    m.value("pxlcam_stream_quality", m_impl->streamQuality);
+    m.family("pxlcam_stream_tick_max_us", "gauge", "Longest WifiPreview::tick()");
+    m.value("pxlcam_stream_tick_max_us", m_impl->status.tickMaxUs);
+    
+    m.family("pxlcam_stream_client_fps", "gauge", "Frame rate per stream client since it connected");
+    const uint32_t now = millis();
+    for (uint8_t i = 0; i < kMaxClientSlots; i++) {
+        const ClientSlot& slot = m_impl->clients[i];
+        const uint8_t kind = slot.kind;
+        if (kind == kSlotFree) {
+            continue;
+        }
+        const uint32_t elapsed = now - slot.startMs;
+        const float fps = elapsed > 0 ? slot.frames * 1000.0f / elapsed : 0.0f;
+        snprintf(labels, sizeof(labels), "client=\"%u\",kind=\"%s\"", i,
+                 kind == kSlotMjpeg ? "mjpeg" : kind == kSlotStylized ? "stylized" : "ws");
+        m.value("pxlcam_stream_client_fps", labels, fps);
+    }
+    
+    // SD writes
+    const storage::WriteStats sd = storage::getWriteStats();
+    m.family("pxlcam_sd_write_bytes_total", "counter", "Bytes written to the SD card");
+    m.value("pxlcam_sd_write_bytes_total", sd.bytes);
+    m.family("pxlcam_sd_write_us_total", "counter", "Time spent in SD writes");
+    m.value("pxlcam_sd_write_us_total", sd.writeUs);
+    m.family("pxlcam_sd_write_bytes_per_second", "gauge", "Average SD write throughput");
+    m.value("pxlcam_sd_write_bytes_per_second",
+            sd.writeUs > 0 ? static_cast<uint32_t>(static_cast<uint64_t>(sd.bytes) * 1000000u / sd.writeUs) : 0);
+    m.family("pxlcam_sd_files_total", "counter", "Files written to the SD card");
+    m.value("pxlcam_sd_files_total", sd.files);
+    m.family("pxlcam_sd_write_failures_total", "counter", "Failed or short SD writes");
+    m.value("pxlcam_sd_write_failures_total", sd.failures);
+    const storage::StorageStatus bus = storage::getStorageStatus();
+    if (bus.mounted) {
+        m.family("pxlcam_sd_bus_info", "gauge", "SD_MMC bus chosen at mount");
+        snprintf(labels, sizeof(labels), "width=\"%u\",khz=\"%d\"", bus.mode1Bit ? 1u : 4u,
+                 bus.frequencyKHz);
+        m.value("pxlcam_sd_bus_info", labels, 1u);
+        m.family("pxlcam_sd_mount_mbps", "gauge", "Sequential speed measured at mount (MB/s)");
+        m.value("pxlcam_sd_mount_mbps", "dir=\"write\"", bus.writeMBps);
+        m.value("pxlcam_sd_mount_mbps", "dir=\"read\"", bus.readMBps);
+    }
+    
+    // Energy ledger (time per power state, charge from PXLCAM_POWER_UA_*)
+    const energy::Report power = energy::getReport();
+    m.family("pxlcam_power_state_ms_total", "counter", "Time spent in each power state");
+    for (size_t i = 0; i < energy::kStateCount; i++) {
+        snprintf(labels, sizeof(labels), "state=\"%s\"", energy::stateName(static_cast<energy::PowerState>(i)));
+        m.value("pxlcam_power_state_ms_total", labels, power.stateMs[i]);
+    }
+    m.family("pxlcam_power_radio_ms_total", "counter", "Time with the WiFi radio on");
+    m.value("pxlcam_power_radio_ms_total", power.radioMs);
+    m.family("pxlcam_power_duty_cycle_permille", "gauge", "Awake share of the accounted time");
+    m.value("pxlcam_power_duty_cycle_permille", static_cast<uint32_t>(power.dutyCycle * 1000.0f + 0.5f));
+    m.family("pxlcam_power_charge_uah_total", "counter", "Estimated charge drawn");
+    m.value("pxlcam_power_charge_uah_total", power.chargeUah);
+    m.family("pxlcam_power_uah_per_frame", "gauge", "Estimated charge per saved frame");
+    m.value("pxlcam_power_uah_per_frame", power.uahPerFrame);
+    m.family("pxlcam_power_average_ua", "gauge", "Estimated mean current");
+    m.value("pxlcam_power_average_ua", power.averageUa);
+    m.family("pxlcam_power_frames_total", "counter", "Frames saved since the ledger started");
+    m.value("pxlcam_power_frames_total", power.frames);
+    
+    // Sensor settings shadow: setter calls made and avoided
+    const sensor::Stats sccb = sensor::getStats();
+    m.family("pxlcam_sensor_writes_total", "counter", "Sensor setter calls made by the settings shadow");
+    m.value("pxlcam_sensor_writes_total", sccb.writes);
+    m.family("pxlcam_sensor_writes_skipped_total", "counter", "Staged sensor settings already held");
+    m.value("pxlcam_sensor_writes_skipped_total", sccb.skipped);
+    m.family("pxlcam_sensor_write_failures_total", "counter", "Sensor setter calls that failed");
+    m.value("pxlcam_sensor_write_failures_total", sccb.failed);
+    
+    // Camera mode switches (preview <-> capture framesize)
+    const CameraModeStats modes = getCameraModeStats();
+    m.family("pxlcam_camera_mode_switches_total", "counter", "Camera mode switches that changed the sensor");
+    m.value("pxlcam_camera_mode_switches_total", modes.switches);
+    m.family("pxlcam_camera_mode_switch_us", "gauge", "Register writes to the first frame in the new mode");
+    m.value("pxlcam_camera_mode_switch_us", "stat=\"last\"", modes.lastSwitchUs);
+    m.value("pxlcam_camera_mode_switch_us", "stat=\"max\"", modes.maxSwitchUs);
+    m.family("pxlcam_camera_mode_frames_dropped_total", "counter", "Stale frames flushed by mode switches");
+    m.value("pxlcam_camera_mode_frames_dropped_total", modes.framesDropped);
+    
+    // Camera service: readouts and how far they were shared
+    const frames::Stats fs = frames::getStats();
+    m.family("pxlcam_camera_reads_total", "counter", "Sensor readouts by the camera service");
+    m.value("pxlcam_camera_reads_total", fs.reads);
+    m.family("pxlcam_camera_deliveries_total", "counter", "Frames handed to consumers");
+    m.value("pxlcam_camera_deliveries_total", "kind=\"first\"", fs.deliveries - fs.shared);
+    m.value("pxlcam_camera_deliveries_total", "kind=\"shared\"", fs.shared);
+    m.family("pxlcam_camera_reads_unused_total", "counter", "Readouts no consumer took");
+    m.value("pxlcam_camera_reads_unused_total", fs.unused);
+    m.family("pxlcam_camera_read_failures_total", "counter", "Readouts the driver failed");
+    m.value("pxlcam_camera_read_failures_total", fs.failures);
+    m.family("pxlcam_camera_frames_held", "gauge", "Frame buffers out with consumers");
+    m.value("pxlcam_camera_frames_held", static_cast<uint32_t>(fs.held));
+    m.family("pxlcam_camera_consumers", "gauge", "Registered frame consumers");
+    m.value("pxlcam_camera_consumers", static_cast<uint32_t>(fs.consumers));
+    
+#if PXLCAM_FEATURE_TIMELAPSE
+    const TimelapseStatus tl = TimelapseController::instance().getStatus();
+    m.family("pxlcam_timelapse_running", "gauge", "1 while a timelapse runs");
+    m.value("pxlcam_timelapse_running", tl.running ? 1u : 0u);
+    m.family("pxlcam_timelapse_frames_total", "counter", "Timelapse frames captured");
+    m.value("pxlcam_timelapse_frames_total", tl.framesCaptured);
+    m.family("pxlcam_timelapse_frames_remaining", "gauge", "Timelapse frames left (0 = unlimited)");
+    m.value("pxlcam_timelapse_frames_remaining", tl.framesRemaining);
+    m.family("pxlcam_timelapse_progress_percent", "gauge", "Timelapse progress");
+    m.value("pxlcam_timelapse_progress_percent", TimelapseController::instance().getProgress());
+    m.family("pxlcam_timelapse_next_capture_ms", "gauge", "Time until the next timelapse frame");
+    m.value("pxlcam_timelapse_next_capture_ms", tl.nextCaptureMs);
+    m.family("pxlcam_timelapse_lateness_ms", "gauge", "Timelapse frame start after its deadline");
+    m.value("pxlcam_timelapse_lateness_ms", "stat=\"last\"", tl.lastLatenessMs);
+    m.value("pxlcam_timelapse_lateness_ms", "stat=\"max\"", tl.maxLatenessMs);
+    m.value("pxlcam_timelapse_lateness_ms", "stat=\"mean\"", tl.meanLatenessMs);
+    m.family("pxlcam_timelapse_deadlines_skipped_total", "counter", "Timelapse deadlines dropped as missed");
+    m.value("pxlcam_timelapse_deadlines_skipped_total", tl.deadlinesSkipped);
+#endif
+    
+    m.flush();
+}
+
+void WifiPreview::serveTrace(WiFiClient& client) {
+    if (!writeAll(client, "HTTP/1.1 200 OK\r\n"
+                          "Content-Type: application/json\r\n"
+                          "Connection: close\r\n\r\n",
+                  PXLCAM_STREAM_SEND_TIMEOUT_MS)) {
+        return;
+    }
+    trace::writeJson([](const char* data, size_t length, void* user) {
+        return writeAll(*static_cast<WiFiClient*>(user), reinterpret_cast<const uint8_t*>(data), length,
+                        PXLCAM_STREAM_SEND_TIMEOUT_MS);
+    }, &client);
 }
 
 void WifiPreview::handleStatus() {
     String json = "{";
     json += "\"streaming\":" + String(m_impl->streaming ? "true" : "false") + ",";
     json += "\"clients\":" + String(m_impl->status.clientCount) + ",";
-    json += "\"frames\":" + String(m_impl->status.framesServed) + ",";
-    json += "\"bytes\":" + String(m_impl->status.bytesServed) + ",";
-    json += "\"ip\":\"" + String(m_impl->status.ipAddress) + "\"";
+    json += "\"frames\":" + String(m_impl->framesServed.load()) + ",";
+    json += "\"bytes\":" + String(m_impl->bytesServed.load()) + ",";
+    json += "\"captured\":" + String(m_impl->ring.getPublished()) + ",";
+    json += "\"skipped\":" + String(m_impl->framesSkipped.load()) + ",";
+    json += "\"dropped\":" + String(m_impl->ring.getDropped()) + ",";
+    json += "\"stream_clients\":" + String(m_impl->streamClients.load()) + ",";
+    json += "\"ws_clients\":" + String(m_impl->wsClients.load()) + ",";
+    json += "\"stylized_clients\":" + String(m_impl->styledClients.load()) + ",";
+    json += "\"ws_raw_bytes\":" + String(m_impl->wsRawBytes.load()) + ",";
+    json += "\"ws_wire_bytes\":" + String(m_impl->wsWireBytes.load()) + ",";
+    json += "\"ws_port\":" + String(m_impl->wsServer ? m_impl->config.wsPort : 0) + ",";
+    json += "\"format\":\"" + String(m_impl->config.format == StreamFormat::MJPEG ? "mjpeg" : "ws") + "\",";
+    json += "\"stream_quality\":" + String(m_impl->streamQuality) + ",";
+    json += "\"idle\":" + String(m_impl->idle ? "true" : "false") + ",";
+    json += "\"pipeline\":" + String(m_impl->pipelineUp ? "true" : "false") + ",";
+    json += "\"tick_max_us\":" + String(m_impl->status.tickMaxUs) + ",";
+    json += "\"ip\":\"" + String(m_impl->status.ipAddress) + "\",";
+    json += "\"bench\":" + String(PXLCAM_FEATURE_BENCHMARK ? "true" : "false") + ",";
+    
+    // Capture stage profiler: rolling min/avg/p95 in microseconds
+    json += "\"capture_us\":{";
+    for (uint8_t i = 0; i < static_cast<uint8_t>(pxlcam::capture::CaptureStage::Count); i++) {
+        const auto stage = static_cast<pxlcam::capture::CaptureStage>(i);
+        pxlcam::capture::StageStats st;
+        pxlcam::capture::getStageStats(stage, st);
+        if (i > 0) json += ",";
+        json += "\"" + String(pxlcam::capture::getStageName(stage)) + "\":{";
+        json += "\"last\":" + String(pxlcam::capture::getLastTimings()[stage]) + ",";
+        json += "\"min\":" + String(st.minUs) + ",";
+        json += "\"avg\":" + String(st.avgUs) + ",";
+        json += "\"p95\":" + String(st.p95Us) + ",";
+        json += "\"n\":" + String(st.samples) + "}";
+    }
+    json += "},";
+    
+    // OLED preview frame timing: interval percentiles, jitter, stalls, stages
+    const auto& telemetry = pxlcam::preview::getFrameTelemetry();
+    pxlcam::util::TimingSummary ts;
+    telemetry.getFrameSummary(ts);
+    json += "\"preview_us\":{";
+    json += "\"p50\":" + String(ts.p50Us) + ",";
+    json += "\"p95\":" + String(ts.p95Us) + ",";
+    json += "\"p99\":" + String(ts.p99Us) + ",";
+    json += "\"max\":" + String(ts.maxUs) + ",";
+    json += "\"jitter\":" + String(telemetry.getJitterUs()) + ",";
+    json += "\"stalls\":" + String(telemetry.getStalls()) + ",";
+    json += "\"n\":" + String(ts.samples) + ",";
+    json += "\"stages\":{";
+    for (uint8_t i = 0; i < static_cast<uint8_t>(pxlcam::util::FrameStage::Count); i++) {
+        const auto stage = static_cast<pxlcam::util::FrameStage>(i);
+        telemetry.getStageSummary(stage, ts);
+        if (i > 0) json += ",";
+        json += "\"" + String(pxlcam::util::getFrameStageName(stage)) + "\":{";
+        json += "\"p50\":" + String(ts.p50Us) + ",";
+        json += "\"p95\":" + String(ts.p95Us) + ",";
+        json += "\"p99\":" + String(ts.p99Us) + "}";
+    }
+    json += "}}";
     json += "}";
     
     m_impl->server->send(200, "application/json", json);
@@ -398,9 +2255,16 @@ bool wifi_preview_start_ap(const char* ssid, const char* password) {
 }
 
 bool wifi_preview_start_sta(const char* ssid, const char* password) {
-    // TODO: Implement STA mode
-    PXLCAM_LOGW_TAG(kLogTag, "STA mode not yet implemented");
-    return false;
+    WifiPreviewConfig config;
+    config.mode = WifiMode::STA;
+    strncpy(config.ssid, ssid, sizeof(config.ssid) - 1);
+    strncpy(config.password, password, sizeof(config.password) - 1);
+    
+    if (!WifiPreview::instance().init(config)) {
+        return false;
+    }
+    
+    return WifiPreview::instance().start();
 }
 
 void wifi_preview_stop() {
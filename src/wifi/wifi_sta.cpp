@@ -0,0 +1,160 @@
+/**
+ * @file wifi_sta.cpp
+ * @brief Station mode bring-up with a fast-reconnect cache
+ */
+
+#include "wifi_sta.h"
+#include "logging.h"
+#include "nvs_store.h"
+#include "pxlcam_config.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <cstring>
+
+namespace pxlcam::sta {
+
+namespace {
+
+constexpr const char* kLogTag = "wifi_sta";
+
+/// Bumped when StaCache changes layout
+constexpr uint8_t kCacheVersion = 1;
+
+/// Status poll interval while associating (ms)
+constexpr uint32_t kPollMs = 10;
+
+/// What the last full connect learned (stored as one NVS blob)
+struct StaCache {
+    uint8_t version;
+    uint8_t channel;
+    uint8_t bssid[6];
+    uint32_t credentialHash;    ///< SSID + password: a change invalidates the cache
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+uint32_t g_lastConnectMs = 0;
+
+/// FNV-1a over SSID and password
+uint32_t credentialHash(const char* ssid, const char* password) {
+    uint32_t hash = 2166136261u;
+    for (const char* p = ssid; *p; p++) {
+        hash = (hash ^ static_cast<uint8_t>(*p)) * 16777619u;
+    }
+    hash *= 16777619u;      // Separator, so "ab"+"c" != "a"+"bc"
+    for (const char* p = password; *p; p++) {
+        hash = (hash ^ static_cast<uint8_t>(*p)) * 16777619u;
+    }
+    return hash;
+}
+
+bool waitConnected(uint32_t timeoutMs) {
+    const uint32_t start = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+        if (millis() - start >= timeoutMs) {
+            return false;
+        }
+        delay(kPollMs);
+    }
+    return true;
+}
+
+bool loadCache(uint32_t hash, StaCache& cache) {
+    if (!nvs::readBytes(nvs::keys::kWifiFastConnect, &cache, sizeof(cache))) {
+        return false;
+    }
+    return cache.version == kCacheVersion && cache.credentialHash == hash &&
+           cache.channel != 0 && cache.ip != 0;
+}
+
+void storeCache(uint32_t hash) {
+    StaCache cache = {};
+    cache.version = kCacheVersion;
+    cache.channel = static_cast<uint8_t>(WiFi.channel());
+    const uint8_t* bssid = WiFi.BSSID();
+    if (!bssid) {
+        return;
+    }
+    memcpy(cache.bssid, bssid, sizeof(cache.bssid));
+    cache.credentialHash = hash;
+    cache.ip = static_cast<uint32_t>(WiFi.localIP());
+    cache.gateway = static_cast<uint32_t>(WiFi.gatewayIP());
+    cache.subnet = static_cast<uint32_t>(WiFi.subnetMask());
+    cache.dns = static_cast<uint32_t>(WiFi.dnsIP());
+    nvs::writeBytes(nvs::keys::kWifiFastConnect, &cache, sizeof(cache));
+}
+
+}  // namespace
+
+ConnectResult connect(const char* ssid, const char* password) {
+    const uint32_t start = millis();
+    if (!password) {
+        password = "";
+    }
+
+    // The cache in NVS replaces the core's own credential store
+    WiFi.persistent(false);
+    if (WiFi.getMode() != WIFI_AP_STA) {
+        WiFi.mode(WIFI_STA);
+    }
+
+    const uint32_t hash = credentialHash(ssid, password);
+    StaCache cache;
+    if (loadCache(hash, cache)) {
+        // Known AP and lease: no scan, no DHCP
+        WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway),
+                    IPAddress(cache.subnet), IPAddress(cache.dns));
+        WiFi.begin(ssid, password, cache.channel, cache.bssid, true);
+        if (waitConnected(PXLCAM_WIFI_FAST_CONNECT_MS)) {
+            g_lastConnectMs = millis() - start;
+            PXLCAM_LOGI_TAG(kLogTag, "Fast reconnect to %s (ch %u) in %lu ms", ssid,
+                            cache.channel, static_cast<unsigned long>(g_lastConnectMs));
+            return ConnectResult::FastReconnect;
+        }
+
+        PXLCAM_LOGW_TAG(kLogTag, "Fast reconnect failed, scanning");
+        WiFi.disconnect();
+        forgetCache();
+
+        // All-zero config switches DHCP back on
+        WiFi.config(IPAddress(0u), IPAddress(0u), IPAddress(0u));
+    }
+
+    WiFi.begin(ssid, password);
+    if (!waitConnected(PXLCAM_WIFI_CONNECT_TIMEOUT_MS)) {
+        WiFi.disconnect();
+        g_lastConnectMs = millis() - start;
+        PXLCAM_LOGE_TAG(kLogTag, "Could not join %s (%lu ms)", ssid,
+                        static_cast<unsigned long>(g_lastConnectMs));
+        return ConnectResult::Failed;
+    }
+
+    g_lastConnectMs = millis() - start;
+    storeCache(hash);
+    PXLCAM_LOGI_TAG(kLogTag, "Joined %s (ch %ld) in %lu ms", ssid,
+                    static_cast<long>(WiFi.channel()), static_cast<unsigned long>(g_lastConnectMs));
+    return ConnectResult::FullConnect;
+}
+
+void forgetCache() {
+    if (nvs::exists(nvs::keys::kWifiFastConnect)) {
+        nvs::erase(nvs::keys::kWifiFastConnect);
+    }
+}
+
+uint32_t getLastConnectMs() {
+    return g_lastConnectMs;
+}
+
+const char* getResultName(ConnectResult result) {
+    switch (result) {
+        case ConnectResult::FastReconnect: return "fast";
+        case ConnectResult::FullConnect:   return "full";
+        default:                           return "failed";
+    }
+}
+
+}  // namespace pxlcam::sta
@@ -134,7 +134,7 @@ void drawMenu(Adafruit_SSD1306* disp) {
     disp->setCursor(2, kHintY);
     disp->print("Tap:nav  Hold:OK");
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 bool handleInput(uint32_t& pressStartMs, bool& wasPressed) {
@@ -163,7 +163,7 @@ bool handleInput(uint32_t& pressStartMs, bool& wasPressed) {
                 disp->fillRect(2, kHintY, 124, 10, SSD1306_BLACK);
                 disp->setCursor(2, kHintY);
                 disp->print("Selecionando...");
-                disp->display();
+                pxlcam::display::updateDisplay();
             }
         }
     }
@@ -252,7 +252,7 @@ WifiMenuResult showMenu() {
         disp->print(kMenuItems[g_currentIndex].label);
         disp->setCursor(52, 44);
         disp->print("[OK]");
-        disp->display();
+        pxlcam::display::updateDisplay();
         delay(400);
     }
     
@@ -293,7 +293,7 @@ void drawInfoScreen(const char* ssid, const char* password,
     disp->print("IP: ");
     disp->print(ipAddress);
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 void drawStatusOverlay(const char* ipAddress, uint8_t clientCount) {
@@ -310,7 +310,7 @@ void drawStatusOverlay(const char* ipAddress, uint8_t clientCount) {
     snprintf(buf, sizeof(buf), "WiFi:%s(%d)", ipAddress, clientCount);
     disp->print(buf);
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 void drawStartingScreen() {
@@ -326,7 +326,7 @@ void drawStartingScreen() {
     disp->setCursor(40, 36);
     disp->print("...");
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 void drawStoppedScreen() {
@@ -342,7 +342,7 @@ void drawStoppedScreen() {
     disp->setCursor(52, 40);
     disp->print("[OK]");
     
-    disp->display();
+    pxlcam::display::updateDisplay();
 }
 
 const char* getResultName(WifiMenuResult result) {
@@ -136,7 +136,7 @@ bool drawWifiQRCode(const char* ssid, const char* password, WifiAuthType authTyp
     disp->print("Pass: ");
     disp->print(password);
     
-    disp->display();
+    pxlcam::display::updateDisplay();
     
     g_qrActive = true;
     PXLCAM_LOGI_TAG(kLogTag, "QR code displayed for SSID: %s", ssid);
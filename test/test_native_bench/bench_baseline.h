@@ -0,0 +1,103 @@
+/**
+ * @file bench_baseline.h
+ * @brief Reference timings for the native benchmark suite
+ *
+ * Each entry is a kernel's time per pixel divided by the reference kernel
+ * (one table lookup per pixel) on the same fixture. After an intended speed
+ * change, paste in the table printed at the end of `pio test -e native`.
+ */
+
+#ifndef PXLCAM_BENCH_BASELINE_H
+#define PXLCAM_BENCH_BASELINE_H
+
+#include <cstring>
+
+struct BenchBaseline {
+    const char* kernel;
+    const char* fixture;
+    double ratio;       ///< ns/pixel over the reference kernel's ns/pixel
+};
+
+static const BenchBaseline kBenchBaseline[] = {
+    { "gray_rgb565", "64x64", 5.27 },
+    { "gray_yuv422", "64x64", 1.05 },
+    { "gray_rgb565", "qvga", 4.07 },
+    { "gray_yuv422", "qvga", 1.14 },
+    { "gray_rgb565", "vga", 4.36 },
+    { "gray_yuv422", "vga", 0.95 },
+    { "dither_ordered8", "64x64", 3.21 },
+    { "dither_ordered4", "64x64", 3.26 },
+    { "dither_floyd", "64x64", 16.21 },
+    { "dither_atkinson", "64x64", 14.33 },
+    { "dither_bluenoise", "64x64", 4.87 },
+    { "dither_ordered4_rgb888", "64x64", 6.67 },
+    { "dither_ordered8", "qvga", 3.06 },
+    { "dither_ordered4", "qvga", 3.38 },
+    { "dither_floyd", "qvga", 21.10 },
+    { "dither_atkinson", "qvga", 16.73 },
+    { "dither_bluenoise", "qvga", 3.82 },
+    { "dither_ordered4_rgb888", "qvga", 6.12 },
+    { "dither_ordered8", "vga", 2.84 },
+    { "dither_ordered4", "vga", 4.39 },
+    { "dither_floyd", "vga", 18.08 },
+    { "dither_atkinson", "vga", 13.14 },
+    { "dither_bluenoise", "vga", 3.56 },
+    { "dither_ordered4_rgb888", "vga", 6.71 },
+    { "indices_to_grayscale", "64x64", 1.23 },
+    { "indices_to_grayscale", "qvga", 1.21 },
+    { "indices_to_grayscale", "vga", 1.10 },
+    { "pp_gamma", "64x64", 1.66 },
+    { "pp_contrast", "64x64", 1.69 },
+    { "pp_brightness", "64x64", 1.63 },
+    { "pp_sharpen", "64x64", 5.89 },
+    { "pp_denoise", "64x64", 40.13 },
+    { "pp_histogram_eq", "64x64", 4.07 },
+    { "pp_night_enhance", "64x64", 1.37 },
+    { "pp_vignette", "64x64", 1.98 },
+    { "pp_grain", "64x64", 4.76 },
+    { "pp_chain", "64x64", 8.27 },
+    { "pp_gamma", "qvga", 1.22 },
+    { "pp_contrast", "qvga", 1.10 },
+    { "pp_brightness", "qvga", 1.08 },
+    { "pp_sharpen", "qvga", 5.76 },
+    { "pp_denoise", "qvga", 53.18 },
+    { "pp_histogram_eq", "qvga", 2.49 },
+    { "pp_night_enhance", "qvga", 1.01 },
+    { "pp_vignette", "qvga", 1.49 },
+    { "pp_grain", "qvga", 4.69 },
+    { "pp_chain", "qvga", 11.01 },
+    { "pp_gamma", "vga", 1.70 },
+    { "pp_contrast", "vga", 0.90 },
+    { "pp_brightness", "vga", 0.90 },
+    { "pp_sharpen", "vga", 5.04 },
+    { "pp_denoise", "vga", 47.51 },
+    { "pp_histogram_eq", "vga", 2.15 },
+    { "pp_night_enhance", "vga", 0.91 },
+    { "pp_vignette", "vga", 1.25 },
+    { "pp_grain", "vga", 3.89 },
+    { "pp_chain", "vga", 7.59 },
+    { "encode_png2", "64x64", 14.45 },
+    { "encode_jpeg_gray", "64x64", 18.58 },
+    { "encode_png2", "qvga", 15.97 },
+    { "encode_jpeg_gray", "qvga", 43.86 },
+    { "encode_png2", "vga", 13.12 },
+    { "encode_jpeg_gray", "vga", 44.07 },
+    { "downscale_gray", "64x64", 3.73 },
+    { "downscale_rgb565", "64x64", 6.89 },
+    { "downscale_gray", "qvga", 3.79 },
+    { "downscale_rgb565", "qvga", 7.08 },
+    { "downscale_gray", "vga", 2.63 },
+    { "downscale_rgb565", "vga", 5.03 },
+};
+
+/// Baseline entry for a kernel on a fixture, nullptr when none is stored
+inline const BenchBaseline* findBaseline(const char* kernel, const char* fixture) {
+    for (const BenchBaseline& entry : kBenchBaseline) {
+        if (strcmp(entry.kernel, kernel) == 0 && strcmp(entry.fixture, fixture) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+#endif // PXLCAM_BENCH_BASELINE_H
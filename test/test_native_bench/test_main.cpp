@@ -0,0 +1,464 @@
+/**
+ * @file test_main.cpp
+ * @brief PXLcam host benchmarks for the image kernels
+ *
+ * Runs each image kernel over deterministic 64x64, QVGA and VGA scenes and
+ * reports ns/pixel, so kernel changes can be measured without flashing:
+ *
+ *     pio test -e native
+ *
+ * Kernels: grayscale conversion (RGB565, YUV422), every DitherAlgorithm,
+ * indices_to_grayscale(), the postprocess filters, the 2-bit PNG and gray
+ * JPEG encoders, and the area downscale.
+ *
+ * Timings are divided by a reference kernel (a 256-entry table lookup per
+ * pixel) timed on the same scene, which cancels most of the difference
+ * between host machines. A kernel fails when that ratio grows beyond
+ * PXLCAM_BENCH_TOLERANCE times its entry in bench_baseline.h. Every run ends
+ * with a fresh table for that file, to paste in after an intended change.
+ *
+ * Uses Unity Test Framework (PlatformIO native)
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "filters/palette.h"
+#include "filters/dither_pipeline.h"
+#include "filters/postprocess.h"
+#include "filters/resample.h"
+#include "jpeg_gray_encoder.h"
+#include "luma_extract.h"
+#include "png_indexed_writer.h"
+
+#include "bench_baseline.h"
+
+/// Slowdown against bench_baseline.h that fails a kernel
+#ifndef PXLCAM_BENCH_TOLERANCE
+#define PXLCAM_BENCH_TOLERANCE 1.5
+#endif
+
+/// Smallest baseline ratio a kernel is held to: kernels about as cheap as the
+/// reference are memory bound and vary with code alignment from build to build
+#ifndef PXLCAM_BENCH_MIN_RATIO
+#define PXLCAM_BENCH_MIN_RATIO 2.0
+#endif
+
+/// Minimum time per measurement batch (ms); the best of kBenchBatches counts
+#ifndef PXLCAM_BENCH_BATCH_MS
+#define PXLCAM_BENCH_BATCH_MS 10
+#endif
+
+using namespace pxlcam::filters;
+
+namespace {
+
+constexpr int kBenchBatches = 9;
+constexpr int kBenchRetries = 3;    ///< Extra measurements before a slow kernel fails
+
+// =============================================================================
+// Fixtures
+// =============================================================================
+
+struct Fixture {
+    const char* name;
+    int w;
+    int h;
+    std::vector<uint8_t> gray;
+    std::vector<uint8_t> rgb888;
+    std::vector<uint8_t> rgb565;     ///< Sensor byte order (high byte first)
+    std::vector<uint8_t> yuv422;     ///< YUYV
+};
+
+/// Camera-like scene: lit gradient, a few hard-edged shapes, fine texture
+/// and sensor noise, so dithers and filters see both flat and busy areas
+Fixture makeFixture(const char* name, int w, int h) {
+    Fixture f = { name, w, h, {}, {}, {}, {} };
+    const size_t pixels = static_cast<size_t>(w) * h;
+    f.gray.resize(pixels);
+    f.rgb888.resize(pixels * 3);
+    f.rgb565.resize(pixels * 2);
+    f.yuv422.resize(pixels * 2);
+    
+    uint32_t noise = 0x9E3779B9u;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            noise ^= noise << 13;
+            noise ^= noise >> 17;
+            noise ^= noise << 5;
+            
+            const int dx = x - w / 3;
+            const int dy = y - h / 2;
+            int v = 40 + (150 * x) / w + (40 * y) / h;
+            if (dx * dx + dy * dy < (h * h) / 16) v = 230;         // Bright disc
+            if (x > (2 * w) / 3 && y > h / 4 && y < h / 2) v = 20;  // Dark block
+            if (((x >> 2) ^ (y >> 2)) & 1) v += 12;                 // Texture
+            v += static_cast<int>(noise & 15) - 8;                  // Noise
+            v = v < 0 ? 0 : (v > 255 ? 255 : v);
+            
+            const size_t i = static_cast<size_t>(y) * w + x;
+            const uint8_t r = static_cast<uint8_t>(v);
+            const uint8_t g = static_cast<uint8_t>((v * 7) / 8 + 16);
+            const uint8_t b = static_cast<uint8_t>((v * 3) / 4);
+            f.gray[i] = static_cast<uint8_t>(v);
+            f.rgb888[i * 3 + 0] = r;
+            f.rgb888[i * 3 + 1] = g;
+            f.rgb888[i * 3 + 2] = b;
+            const uint16_t rgb = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+            f.rgb565[i * 2 + 0] = static_cast<uint8_t>(rgb >> 8);
+            f.rgb565[i * 2 + 1] = static_cast<uint8_t>(rgb);
+            f.yuv422[i * 2 + 0] = static_cast<uint8_t>(v);
+            f.yuv422[i * 2 + 1] = 128;
+        }
+    }
+    return f;
+}
+
+std::vector<Fixture>& fixtures() {
+    static std::vector<Fixture> all;
+    if (all.empty()) {
+        all.push_back(makeFixture("64x64", 64, 64));
+        all.push_back(makeFixture("qvga", 320, 240));
+        all.push_back(makeFixture("vga", 640, 480));
+    }
+    return all;
+}
+
+// =============================================================================
+// Timing
+// =============================================================================
+
+/// Best ns/pixel of kBenchBatches batches of at least PXLCAM_BENCH_BATCH_MS
+/// @param prepare Run before every call, untimed (restores in-place inputs)
+template <typename Prepare, typename Kernel>
+double nsPerPixel(const Fixture& f, Prepare prepare, Kernel kernel) {
+    using Clock = std::chrono::steady_clock;
+    const double pixels = static_cast<double>(f.w) * f.h;
+    double best = 0;
+    
+    for (int batch = 0; batch < kBenchBatches; batch++) {
+        long long ns = 0;
+        int runs = 0;
+        while (ns < PXLCAM_BENCH_BATCH_MS * 1000000LL || runs < 3) {
+            prepare();
+            const Clock::time_point start = Clock::now();
+            kernel();
+            ns += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            runs++;
+        }
+        const double perPixel = static_cast<double>(ns) / runs / pixels;
+        if (batch == 0 || perPixel < best) {
+            best = perPixel;
+        }
+    }
+    return best;
+}
+
+template <typename Kernel>
+double nsPerPixel(const Fixture& f, Kernel kernel) {
+    return nsPerPixel(f, [] {}, kernel);
+}
+
+volatile uint32_t g_sink = 0;   ///< Keeps kernel results alive
+
+/// Reference cost on this machine: one table lookup per pixel
+/// @param remeasure Time it again (and keep that) instead of the first result
+double referenceNs(const Fixture& f, bool remeasure = false) {
+    static double cached[8] = {};
+    const size_t slot = &f - fixtures().data();
+    if (cached[slot] > 0 && !remeasure) {
+        return cached[slot];
+    }
+    
+    uint8_t lut[256];
+    for (int i = 0; i < 256; i++) {
+        lut[i] = static_cast<uint8_t>(255 - i);
+    }
+    std::vector<uint8_t> out(f.gray.size());
+    cached[slot] = nsPerPixel(f, [&] {
+        for (size_t i = 0; i < out.size(); i++) {
+            out[i] = lut[f.gray[i]];
+        }
+        g_sink += out[out.size() / 2];
+    });
+    return cached[slot];
+}
+
+// =============================================================================
+// Reporting
+// =============================================================================
+
+int g_failures = 0;
+std::string g_table;   ///< Measured ratios in bench_baseline.h form
+
+/// Time one kernel, report it, and count it failed if it regressed past the
+/// baseline. A slow result is measured again, next to a fresh reference,
+/// before it counts: a busy host stalls whole batches, a real regression
+/// stays slow.
+template <typename Prepare, typename Kernel>
+void bench(const char* kernel, const Fixture& f, Prepare prepare, Kernel run) {
+    const BenchBaseline* base = findBaseline(kernel, f.name);
+    const double limit = !base ? 0 :
+        (base->ratio > PXLCAM_BENCH_MIN_RATIO ? base->ratio : PXLCAM_BENCH_MIN_RATIO)
+        * PXLCAM_BENCH_TOLERANCE;
+    
+    double ns = nsPerPixel(f, prepare, run);
+    double ratio = ns / referenceNs(f);
+    for (int retry = 0; base && retry < kBenchRetries && ratio > limit; retry++) {
+        const double again = nsPerPixel(f, prepare, run);
+        if (again / referenceNs(f, true) < ratio) {
+            ns = again;
+            ratio = again / referenceNs(f);
+        }
+    }
+    
+    char row[96];
+    snprintf(row, sizeof(row), "    { \"%s\", \"%s\", %.2f },\n", kernel, f.name, ratio);
+    g_table += row;
+    
+    if (!base) {
+        printf("bench %-24s %-6s %8.3f ns/px %7.2fx ref  (no baseline)\n", kernel, f.name, ns, ratio);
+        return;
+    }
+    const bool regressed = ratio > limit;
+    printf("bench %-24s %-6s %8.3f ns/px %7.2fx ref  (baseline %.2fx)%s\n",
+           kernel, f.name, ns, ratio, base->ratio, regressed ? "  REGRESSION" : "");
+    if (regressed) {
+        g_failures++;
+    }
+}
+
+template <typename Kernel>
+void bench(const char* kernel, const Fixture& f, Kernel run) {
+    bench(kernel, f, [] {}, run);
+}
+
+/// Fail the running test if any kernel it reported regressed
+void checkRegressions(const char* what) {
+    char message[96];
+    snprintf(message, sizeof(message), "%d %s kernel(s) slower than the baseline allows",
+             g_failures, what);
+    const int failures = g_failures;
+    g_failures = 0;
+    TEST_ASSERT_TRUE_MESSAGE(failures == 0, message);
+}
+
+}  // namespace
+
+// =============================================================================
+// Benchmarks
+// =============================================================================
+
+void test_bench_grayscale_conversion() {
+    for (const Fixture& f : fixtures()) {
+        std::vector<uint8_t> gray(f.gray.size());
+        
+        bench("gray_rgb565", f, [&] {
+            for (int y = 0; y < f.h; y++) {
+                pxlcam::luma::rgb565Row(f.rgb565.data() + y * f.w * 2, gray.data() + y * f.w, f.w);
+            }
+            g_sink += gray[0];
+        });
+        
+        bench("gray_yuv422", f, [&] {
+            pxlcam::luma::extractPlane(f.yuv422.data(), static_cast<size_t>(f.w) * 2,
+                                       pxlcam::luma::kYuv422Step, gray.data(), f.w, f.w, f.h);
+            g_sink += gray[0];
+        });
+    }
+    checkRegressions("grayscale");
+}
+
+void test_bench_dither_algorithms() {
+    static const char* const kNames[] = {
+        "dither_ordered8", "dither_ordered4", "dither_floyd", "dither_atkinson", "dither_bluenoise"
+    };
+    static_assert(sizeof(kNames) / sizeof(kNames[0]) == static_cast<size_t>(DitherAlgorithm::COUNT),
+                  "One benchmark name per DitherAlgorithm");
+    
+    palette_init();
+    dither_init();
+    const Palette& palette = palette_get(PaletteType::GB_CLASSIC);
+    
+    for (const Fixture& f : fixtures()) {
+        std::vector<uint8_t> indices(f.gray.size());
+        for (uint8_t a = 0; a < static_cast<uint8_t>(DitherAlgorithm::COUNT); a++) {
+            const DitherAlgorithm algo = static_cast<DitherAlgorithm>(a);
+            bool ok = true;
+            bench(kNames[a], f, [&] {
+                ok &= apply_palette_dither(f.gray.data(), SourceFormat::GRAYSCALE, indices.data(),
+                                           f.w, f.h, palette, algo).success;
+            });
+            TEST_ASSERT_TRUE_MESSAGE(ok, kNames[a]);
+        }
+        
+        // RGB888 source: conversion fused into the dither
+        bool ok = true;
+        bench("dither_ordered4_rgb888", f, [&] {
+            ok &= apply_palette_dither(f.rgb888.data(), SourceFormat::RGB888, indices.data(),
+                                       f.w, f.h, palette, DitherAlgorithm::ORDERED_4X4).success;
+        });
+        TEST_ASSERT_TRUE(ok);
+    }
+    checkRegressions("dither");
+}
+
+void test_bench_indices_to_grayscale() {
+    palette_init();
+    const Palette& palette = palette_get(PaletteType::GB_CLASSIC);
+    
+    for (const Fixture& f : fixtures()) {
+        std::vector<uint8_t> indices(f.gray.size());
+        std::vector<uint8_t> gray(f.gray.size());
+        for (size_t i = 0; i < indices.size(); i++) {
+            indices[i] = f.gray[i] >> 6;
+        }
+        bench("indices_to_grayscale", f, [&] {
+            indices_to_grayscale(indices.data(), gray.data(), gray.size(), palette);
+            g_sink += gray[0];
+        });
+    }
+    checkRegressions("indices_to_grayscale");
+}
+
+void test_bench_postprocess_filters() {
+    postprocess_init();
+    
+    for (const Fixture& f : fixtures()) {
+        std::vector<uint8_t> image(f.gray.size());
+        auto restore = [&] { memcpy(image.data(), f.gray.data(), image.size()); };
+        uint8_t* px = image.data();
+        
+        bench("pp_gamma", f, restore, [&] { filter_gamma(px, f.w, f.h, 0.8f); });
+        bench("pp_contrast", f, restore, [&] { filter_contrast(px, f.w, f.h, 1.3f); });
+        bench("pp_brightness", f, restore, [&] { filter_brightness(px, f.w, f.h, 20); });
+        bench("pp_sharpen", f, restore, [&] { filter_sharpen(px, f.w, f.h, 0.5f); });
+        bench("pp_denoise", f, restore, [&] { filter_denoise(px, f.w, f.h, 1.0f); });
+        bench("pp_histogram_eq", f, restore, [&] { filter_histogram_eq(px, f.w, f.h); });
+        bench("pp_night_enhance", f, restore, [&] { filter_night_enhance(px, f.w, f.h); });
+        bench("pp_vignette", f, restore, [&] { filter_vignette(px, f.w, f.h, 0.5f, 0.5f); });
+        bench("pp_grain", f, restore, [&] { filter_grain(px, f.w, f.h, 0.3f); });
+        
+        // A typical chain, compiled: LUT run + sharpen + vignette
+        PostProcessConfig config;
+        config.filterCount = 4;
+        config.filters[0] = FilterParams(FilterType::GAMMA_CORRECTION, true, 1.0f);
+        config.filters[0].param1 = 0.8f;
+        config.filters[1] = FilterParams(FilterType::CONTRAST, true, 1.3f);
+        config.filters[2] = FilterParams(FilterType::SHARPEN, true, 0.5f);
+        config.filters[3] = FilterParams(FilterType::VIGNETTE, true, 0.5f);
+        config.filters[3].param1 = 0.5f;
+        postprocess_set_config(config);
+        bool ok = true;
+        bench("pp_chain", f, restore, [&] { ok &= apply_postprocess_chain(px, f.w, f.h); });
+        TEST_ASSERT_TRUE(ok);
+    }
+    checkRegressions("postprocess");
+}
+
+namespace {
+
+bool countSink(void* user, const uint8_t*, size_t len) {
+    *static_cast<size_t*>(user) += len;
+    return true;
+}
+
+}  // namespace
+
+void test_bench_encoders() {
+    palette_init();
+    const Palette& palette = palette_get(PaletteType::GB_CLASSIC);
+    pxlcam::jpeg::GrayJpegEncoder jpeg;
+    jpeg.begin(80);
+    
+    for (const Fixture& f : fixtures()) {
+        // 2-bit rows as the GameBoy capture writes them
+        DitherConfig config;
+        config.algorithm = DitherAlgorithm::ORDERED_8X8;
+        config.output = DitherOutput::PACKED_2BPP;
+        std::vector<uint8_t> packed(dither_output_size(config.output, f.w, f.h));
+        TEST_ASSERT_TRUE(apply_palette_dither_ex(f.gray.data(), SourceFormat::GRAYSCALE, packed.data(),
+                                                 f.w, f.h, palette, config).success);
+        
+        const size_t rowBytes = pxlcam::png::IndexedPngWriter::rowBytes(f.w, 2);
+        std::vector<pxlcam::png::IndexedPngWriter> writer(1);
+        size_t pngBytes = 0;
+        bool ok = true;
+        bench("encode_png2", f, [&] {
+            pngBytes = 0;
+            ok &= writer[0].begin(f.w, f.h, 2, palette.tones, PALETTE_TONE_COUNT, countSink, &pngBytes);
+            for (int y = 0; y < f.h; y++) {
+                writer[0].writeRow(packed.data() + y * rowBytes);
+            }
+            ok &= writer[0].finish();
+        });
+        TEST_ASSERT_TRUE(ok && pngBytes > 0);
+        
+        std::vector<uint8_t> out(pxlcam::jpeg::GrayJpegEncoder::worstCaseSize(f.w, f.h));
+        size_t jpegBytes = 0;
+        bench("encode_jpeg_gray", f, [&] {
+            jpegBytes = jpeg.encode(f.gray.data(), f.w, f.h, f.w, 1, out.data(), out.size());
+        });
+        TEST_ASSERT_TRUE(jpegBytes > 0);
+    }
+    checkRegressions("encoder");
+}
+
+void test_bench_downscale() {
+    for (const Fixture& f : fixtures()) {
+        const int dstW = f.w / 2 < RESAMPLE_MAX_DST_WIDTH ? f.w / 2 : RESAMPLE_MAX_DST_WIDTH;
+        const int dstH = (f.h * dstW) / f.w;
+        std::vector<uint8_t> out(static_cast<size_t>(dstW) * dstH);
+        std::vector<AreaResampler> resampler(1);
+        bool ok = true;
+        
+        bench("downscale_gray", f, [&] {
+            ok &= resampler[0].begin(f.w, f.h, ResampleFormat::GRAY, out.data(), dstW, dstH, dstW);
+            for (int y = 0; y < f.h; y++) {
+                resampler[0].push_row(f.gray.data() + y * f.w);
+            }
+            ok &= resampler[0].done();
+        });
+        
+        bench("downscale_rgb565", f, [&] {
+            ok &= resampler[0].begin(f.w, f.h, ResampleFormat::RGB565, out.data(), dstW, dstH, dstW);
+            for (int y = 0; y < f.h; y++) {
+                resampler[0].push_row(f.rgb565.data() + y * f.w * 2);
+            }
+            ok &= resampler[0].done();
+        });
+        TEST_ASSERT_TRUE(ok);
+    }
+    checkRegressions("downscale");
+}
+
+// =============================================================================
+// Test Runner
+// =============================================================================
+
+void setUp() {
+    // Called before each test
+}
+
+void tearDown() {
+    // Called after each test
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_bench_grayscale_conversion);
+    RUN_TEST(test_bench_dither_algorithms);
+    RUN_TEST(test_bench_indices_to_grayscale);
+    RUN_TEST(test_bench_postprocess_filters);
+    RUN_TEST(test_bench_encoders);
+    RUN_TEST(test_bench_downscale);
+    
+    printf("\nbench_baseline.h:\n%s", g_table.c_str());
+    return UNITY_END();
+}
@@ -25,6 +25,7 @@
 
 #include "filters/palette.h"
 #include "filters/dither_pipeline.h"
+#include "filters/resample.h"
 
 using namespace pxlcam::filters;
 
@@ -104,14 +105,15 @@ static bool validate_no_corruption(const uint8_t* data, size_t count) {
 // =============================================================================
 
 void test_DitherAlgorithmCount() {
-    // Verify enum COUNT matches expected 4 algorithms
-    TEST_ASSERT_EQUAL(4, static_cast<uint8_t>(DitherAlgorithm::COUNT));
+    // Verify enum COUNT matches expected 5 algorithms
+    TEST_ASSERT_EQUAL(5, static_cast<uint8_t>(DitherAlgorithm::COUNT));
     
     // Verify enum values
     TEST_ASSERT_EQUAL(0, static_cast<uint8_t>(DitherAlgorithm::ORDERED_8X8));
     TEST_ASSERT_EQUAL(1, static_cast<uint8_t>(DitherAlgorithm::ORDERED_4X4));
     TEST_ASSERT_EQUAL(2, static_cast<uint8_t>(DitherAlgorithm::FLOYD_STEINBERG));
     TEST_ASSERT_EQUAL(3, static_cast<uint8_t>(DitherAlgorithm::ATKINSON));
+    TEST_ASSERT_EQUAL(4, static_cast<uint8_t>(DitherAlgorithm::BLUE_NOISE));
 }
 
 // =============================================================================
@@ -143,17 +145,20 @@ void test_DitherAlgorithmNames() {
     const char* name4x4 = dither_get_algorithm_name(DitherAlgorithm::ORDERED_4X4);
     const char* nameFS = dither_get_algorithm_name(DitherAlgorithm::FLOYD_STEINBERG);
     const char* nameAtk = dither_get_algorithm_name(DitherAlgorithm::ATKINSON);
+    const char* nameBlue = dither_get_algorithm_name(DitherAlgorithm::BLUE_NOISE);
     
     TEST_ASSERT_NOT_NULL(name8x8);
     TEST_ASSERT_NOT_NULL(name4x4);
     TEST_ASSERT_NOT_NULL(nameFS);
     TEST_ASSERT_NOT_NULL(nameAtk);
+    TEST_ASSERT_NOT_NULL(nameBlue);
     
     // Check expected names
     TEST_ASSERT_EQUAL_STRING("Ordered 8x8", name8x8);
     TEST_ASSERT_EQUAL_STRING("Ordered 4x4", name4x4);
     TEST_ASSERT_EQUAL_STRING("Floyd-Steinberg", nameFS);
     TEST_ASSERT_EQUAL_STRING("Atkinson", nameAtk);
+    TEST_ASSERT_EQUAL_STRING("Blue Noise", nameBlue);
     
     // Invalid algorithm should return "Unknown"
     const char* nameInvalid = dither_get_algorithm_name(static_cast<DitherAlgorithm>(99));
@@ -220,6 +225,461 @@ void test_ApplyOrdered4x4_MapsIndices() {
     TEST_ASSERT_TRUE(validate_indices_range(s_outputIndices, TEST_PIXELS));
 }
 
+// =============================================================================
+// Test: Ordered Word Path Matches Scalar Path
+// =============================================================================
+
+void test_Ordered_WordPathMatchesScalar() {
+    palette_init();
+    dither_init();
+    
+    // 4 px per word on aligned rows; a +1 offset forces the per-pixel path
+    static const int W = 28;  // Not a multiple of 8: exercises the tails
+    static const int H = 9;
+    alignas(4) static uint8_t srcAligned[W * H];
+    alignas(4) static uint8_t dstAligned[W * H];
+    alignas(4) static uint8_t srcShifted[W * H + 1];
+    alignas(4) static uint8_t dstShifted[W * H + 1];
+    
+    for (int i = 0; i < W * H; ++i) {
+        srcAligned[i] = static_cast<uint8_t>((i * 37 + (i >> 3) * 11) & 0xFF);
+    }
+    memcpy(srcShifted + 1, srcAligned, W * H);
+    
+    const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
+    const uint8_t strengths[] = { 0, 77, 128, 255 };
+    
+    for (uint8_t strength : strengths) {
+        dither_ordered_8x8(srcAligned, dstAligned, W, H, pal, strength);
+        dither_ordered_8x8(srcShifted + 1, dstShifted + 1, W, H, pal, strength);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(dstAligned, dstShifted + 1, W * H);
+        
+        dither_ordered_4x4(srcAligned, dstAligned, W, H, pal, strength);
+        dither_ordered_4x4(srcShifted + 1, dstShifted + 1, W, H, pal, strength);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(dstAligned, dstShifted + 1, W * H);
+        
+        DitherConfig config(DitherAlgorithm::ORDERED_8X8);
+        config.strength = strength;
+        apply_palette_dither_ex(srcAligned, SourceFormat::GRAYSCALE, dstAligned, W, H, pal, config);
+        apply_palette_dither_ex(srcShifted + 1, SourceFormat::GRAYSCALE, dstShifted + 1, W, H, pal, config);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(dstAligned, dstShifted + 1, W * H);
+    }
+}
+
+// =============================================================================
+// Test: Threshold Cache Follows Strength Changes
+// =============================================================================
+
+void test_Ordered_StrengthChangeRebuildsThresholds() {
+    palette_init();
+    dither_init();
+    
+    generate_gradient_pattern();
+    const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
+    uint8_t out[TEST_PIXELS];
+    
+    // Fill the cache with strong offsets first
+    dither_ordered_8x8(s_grayGradient, out, TEST_WIDTH, TEST_HEIGHT, pal, 255);
+    dither_ordered_4x4(s_grayGradient, out, TEST_WIDTH, TEST_HEIGHT, pal, 255);
+    
+    // Strength 0 means zero offsets: plain nearest-tone quantization
+    dither_ordered_8x8(s_grayGradient, out, TEST_WIDTH, TEST_HEIGHT, pal, 0);
+    for (int i = 0; i < TEST_PIXELS; ++i) {
+        TEST_ASSERT_EQUAL_UINT8(palette_map_value(s_grayGradient[i], pal), out[i]);
+    }
+    
+    dither_set_config(DitherConfig(DitherAlgorithm::ORDERED_4X4));  // Back to 128
+    DitherConfig config(DitherAlgorithm::ORDERED_4X4);
+    config.strength = 0;
+    TEST_ASSERT_TRUE(apply_dither_ex(s_grayGradient, out, TEST_WIDTH, TEST_HEIGHT, pal, config));
+    for (int i = 0; i < TEST_PIXELS; ++i) {
+        TEST_ASSERT_EQUAL_UINT8(palette_map_value(s_grayGradient[i], pal), out[i]);
+    }
+}
+
+// =============================================================================
+// Test: Blue Noise
+// =============================================================================
+
+void test_BlueNoise_WordPathMatchesScalar() {
+    palette_init();
+    dither_init();
+    
+    // Wider than the 64-px tile so rows wrap; +1 offset forces the per-pixel path
+    static const int W = 70;
+    static const int H = 66;
+    alignas(4) static uint8_t srcAligned[W * H];
+    alignas(4) static uint8_t dstAligned[W * H];
+    alignas(4) static uint8_t srcShifted[W * H + 1];
+    alignas(4) static uint8_t dstShifted[W * H + 1];
+    
+    for (int i = 0; i < W * H; ++i) {
+        srcAligned[i] = static_cast<uint8_t>((i * 37 + (i >> 3) * 11) & 0xFF);
+    }
+    memcpy(srcShifted + 1, srcAligned, W * H);
+    
+    const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
+    const uint8_t strengths[] = { 0, 77, 128, 255 };
+    
+    for (uint8_t strength : strengths) {
+        dither_blue_noise(srcAligned, dstAligned, W, H, pal, strength);
+        dither_blue_noise(srcShifted + 1, dstShifted + 1, W, H, pal, strength);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(dstAligned, dstShifted + 1, W * H);
+    }
+    
+    // Strength 0: plain nearest-tone quantization
+    dither_blue_noise(srcAligned, dstAligned, W, H, pal, 0);
+    for (int i = 0; i < W * H; ++i) {
+        TEST_ASSERT_EQUAL_UINT8(palette_map_value(srcAligned[i], pal), dstAligned[i]);
+    }
+}
+
+void test_BlueNoise_FlatGrayMatchesBayerTone() {
+    palette_init();
+    dither_init();
+    
+    // Both tiles hold uniformly spread thresholds, so a flat gray must come
+    // out with the same average tone; only the dot placement differs
+    static const int W = 64;
+    static const int H = 64;
+    static uint8_t src[W * H];
+    static uint8_t bayerOut[W * H];
+    static uint8_t noiseOut[W * H];
+    
+    const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
+    
+    for (int level = 16; level < 256; level += 48) {
+        memset(src, level, sizeof(src));
+        TEST_ASSERT_TRUE(apply_palette_dither(src, SourceFormat::GRAYSCALE, bayerOut, W, H,
+                                              pal, DitherAlgorithm::ORDERED_8X8).success);
+        TEST_ASSERT_TRUE(apply_palette_dither(src, SourceFormat::GRAYSCALE, noiseOut, W, H,
+                                              pal, DitherAlgorithm::BLUE_NOISE).success);
+        
+        int bayerSum = 0;
+        int noiseSum = 0;
+        bool mixed = false;
+        for (int i = 0; i < W * H; ++i) {
+            TEST_ASSERT_LESS_THAN(PALETTE_TONE_COUNT, noiseOut[i]);
+            bayerSum += pal.tones[bayerOut[i]];
+            noiseSum += pal.tones[noiseOut[i]];
+            mixed = mixed || (noiseOut[i] != noiseOut[0]);
+        }
+        TEST_ASSERT_TRUE(mixed);
+        TEST_ASSERT_INT_WITHIN(4, bayerSum / (W * H), noiseSum / (W * H));
+    }
+}
+
+// =============================================================================
+// Test: Split-Frame Ordered Dithering Matches Serial
+// =============================================================================
+
+void test_Ordered_ParallelMatchesSerial() {
+    palette_init();
+    dither_init();
+    
+    // Tall enough to be split (odd height: uneven bands, Bayer phase at the seam)
+    static const int W = 36;
+    static const int H = 45;
+    static uint8_t src[W * H];
+    static uint8_t serialOut[W * H];
+    static uint8_t parallelOut[W * H];
+    
+    for (int i = 0; i < W * H; ++i) {
+        src[i] = static_cast<uint8_t>((i * 29 + (i / W) * 7) & 0xFF);
+    }
+    
+    const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
+    const DitherAlgorithm algos[] = {
+        DitherAlgorithm::ORDERED_8X8, DitherAlgorithm::ORDERED_4X4, DitherAlgorithm::BLUE_NOISE
+    };
+    
+    for (DitherAlgorithm algo : algos) {
+        DitherConfig config(algo);
+        config.parallel = false;
+        TEST_ASSERT_TRUE(apply_palette_dither_ex(src, SourceFormat::GRAYSCALE, serialOut, W, H, pal, config).success);
+        config.parallel = true;
+        TEST_ASSERT_TRUE(apply_palette_dither_ex(src, SourceFormat::GRAYSCALE, parallelOut, W, H, pal, config).success);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(serialOut, parallelOut, W * H);
+        
+        config.parallel = false;
+        TEST_ASSERT_TRUE(apply_dither_ex(src, serialOut, W, H, pal, config));
+        config.parallel = true;
+        TEST_ASSERT_TRUE(apply_dither_ex(src, parallelOut, W, H, pal, config));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(serialOut, parallelOut, W * H);
+    }
+}
+
+// =============================================================================
+// Test: Wavefront Error Diffusion Matches Serial
+// =============================================================================
+
+void test_ErrorDiffusion_ParallelMatchesSerial() {
+    palette_init();
+    dither_init();
+    
+    // Width not a multiple of the wavefront step; odd row count
+    static const int W = 37;
+    static const int H = 41;
+    static uint8_t src[W * H * 3];
+    static uint8_t serialOut[W * H];
+    static uint8_t parallelOut[W * H];
+    
+    for (int i = 0; i < W * H * 3; ++i) {
+        src[i] = static_cast<uint8_t>((i * 53 + (i / 7) * 13) & 0xFF);
+    }
+    
+    const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
+    const DitherAlgorithm algos[] = { DitherAlgorithm::FLOYD_STEINBERG, DitherAlgorithm::ATKINSON };
+    const SourceFormat formats[] = { SourceFormat::GRAYSCALE, SourceFormat::RGB888 };
+    
+    for (DitherAlgorithm algo : algos) {
+        DitherConfig config(algo);
+        config.serpentine = false;  // Wavefront needs every row left to right
+        
+        for (SourceFormat format : formats) {
+            config.parallel = false;
+            TEST_ASSERT_TRUE(apply_palette_dither_ex(src, format, serialOut, W, H, pal, config).success);
+            config.parallel = true;
+            TEST_ASSERT_TRUE(apply_palette_dither_ex(src, format, parallelOut, W, H, pal, config).success);
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(serialOut, parallelOut, W * H);
+        }
+        
+        config.parallel = false;
+        TEST_ASSERT_TRUE(apply_dither_ex(src, serialOut, W, H, pal, config));
+        config.parallel = true;
+        TEST_ASSERT_TRUE(apply_dither_ex(src, parallelOut, W, H, pal, config));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(serialOut, parallelOut, W * H);
+    }
+}
+
+// =============================================================================
+// Test: Packed Output Layouts
+// =============================================================================
+
+void test_Output_PackedMatchesIndices() {
+    palette_init();
+    dither_init();
+    
+    // Width leaves a partial byte in both packed layouts; height a partial page
+    static const int W = 37;
+    static const int H = 43;
+    static uint8_t src[W * H];
+    static uint8_t indices[W * H];
+    static uint8_t packed[W * H];
+    
+    for (int i = 0; i < W * H; ++i) {
+        src[i] = static_cast<uint8_t>((i * 41 + (i / W) * 11) & 0xFF);
+    }
+    
+    TEST_ASSERT_EQUAL(W * H, dither_output_size(DitherOutput::INDICES, W, H));
+    TEST_ASSERT_EQUAL(10 * H, dither_output_size(DitherOutput::PACKED_2BPP, W, H));
+    TEST_ASSERT_EQUAL(5 * H, dither_output_size(DitherOutput::PACKED_1BPP, W, H));
+    TEST_ASSERT_EQUAL(W * 6, dither_output_size(DitherOutput::SSD1306_PAGES, W, H));
+    
+    // 1-bit layouts dither between the end tones
+    const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
+    Palette ends = pal;
+    ends.tones[1] = pal.tones[0];
+    ends.tones[2] = pal.tones[3];
+    
+    for (uint8_t a = 0; a < static_cast<uint8_t>(DitherAlgorithm::COUNT); ++a) {
+        for (int parallel = 0; parallel < 2; ++parallel) {
+            DitherConfig config(static_cast<DitherAlgorithm>(a));
+            config.serpentine = false;
+            config.parallel = parallel != 0;
+            
+            TEST_ASSERT_TRUE(apply_palette_dither_ex(src, SourceFormat::GRAYSCALE, indices, W, H, pal, config).success);
+            config.output = DitherOutput::PACKED_2BPP;
+            DitherResult result = apply_palette_dither_ex(src, SourceFormat::GRAYSCALE, packed, W, H, pal, config);
+            TEST_ASSERT_TRUE(result.success);
+            TEST_ASSERT_EQUAL(10 * H, result.outputBytes);
+            for (int y = 0; y < H; ++y) {
+                for (int x = 0; x < W; ++x) {
+                    const uint8_t idx = (packed[y * 10 + x / 4] >> (6 - 2 * (x & 3))) & 0x03;
+                    TEST_ASSERT_EQUAL_UINT8(indices[y * W + x], idx);
+                }
+            }
+            
+            config.output = DitherOutput::INDICES;
+            TEST_ASSERT_TRUE(apply_palette_dither_ex(src, SourceFormat::GRAYSCALE, indices, W, H, ends, config).success);
+            config.output = DitherOutput::PACKED_1BPP;
+            TEST_ASSERT_TRUE(apply_palette_dither_ex(src, SourceFormat::GRAYSCALE, packed, W, H, pal, config).success);
+            for (int y = 0; y < H; ++y) {
+                for (int x = 0; x < W; ++x) {
+                    const uint8_t bit = (packed[y * 5 + x / 8] >> (7 - (x & 7))) & 1;
+                    TEST_ASSERT_EQUAL_UINT8(indices[y * W + x] >> 1, bit);
+                }
+            }
+            
+            memset(packed, 0xFF, sizeof(packed));
+            config.output = DitherOutput::SSD1306_PAGES;
+            TEST_ASSERT_TRUE(apply_palette_dither_ex(src, SourceFormat::GRAYSCALE, packed, W, H, pal, config).success);
+            for (int y = 0; y < H; ++y) {
+                for (int x = 0; x < W; ++x) {
+                    const uint8_t bit = (packed[(y / 8) * W + x] >> (y & 7)) & 1;
+                    TEST_ASSERT_EQUAL_UINT8(indices[y * W + x] >> 1, bit);
+                }
+            }
+            // Rows past the image in the last page stay dark
+            TEST_ASSERT_EQUAL_UINT8(0, packed[5 * W] >> (H & 7));
+        }
+    }
+}
+
+// =============================================================================
+// Test: Streaming API matches whole-frame output
+// =============================================================================
+
+struct StreamCapture {
+    uint8_t* dst;
+    size_t written;
+    int calls;
+    int abortAfter;   // Return false on this call (0 = never)
+};
+
+static bool stream_capture_sink(void* user, int, const uint8_t* data, size_t bytes) {
+    StreamCapture* cap = static_cast<StreamCapture*>(user);
+    memcpy(cap->dst + cap->written, data, bytes);
+    cap->written += bytes;
+    return ++cap->calls != cap->abortAfter;
+}
+
+void test_Stream_MatchesWholeFrame() {
+    palette_init();
+    dither_init();
+    
+    // Same odd size as the packed test: partial bytes and a partial page
+    static const int W = 37;
+    static const int H = 43;
+    static uint8_t src[W * H * 3];
+    static uint8_t frame[W * H];
+    static uint8_t streamed[W * H];
+    
+    for (int i = 0; i < W * H * 3; ++i) {
+        src[i] = static_cast<uint8_t>((i * 41 + (i / W) * 11) & 0xFF);
+    }
+    
+    const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
+    const SourceFormat formats[] = { SourceFormat::GRAYSCALE, SourceFormat::RGB888 };
+    
+    for (uint8_t a = 0; a < static_cast<uint8_t>(DitherAlgorithm::COUNT); ++a) {
+        for (uint8_t o = 0; o < static_cast<uint8_t>(DitherOutput::COUNT); ++o) {
+            for (int f = 0; f < 2; ++f) {
+                DitherConfig config(static_cast<DitherAlgorithm>(a));
+                config.serpentine = (o & 1) != 0;
+                config.output = static_cast<DitherOutput>(o);
+                
+                DitherResult expected = apply_palette_dither_ex(src, formats[f], frame, W, H, pal, config);
+                TEST_ASSERT_TRUE(expected.success);
+                
+                StreamCapture cap = { streamed, 0, 0, 0 };
+                TEST_ASSERT_TRUE(dither_begin(W, formats[f], pal, config, stream_capture_sink, &cap).success);
+                TEST_ASSERT_TRUE(dither_stream_active());
+                
+                const int stride = W * source_format_bpp(formats[f]);
+                for (int y = 0; y < H; ++y) {
+                    TEST_ASSERT_TRUE(dither_push_row(src + y * stride));
+                    // Carried error must not depend on whole-frame calls in between
+                    if (y == H / 2) {
+                        TEST_ASSERT_TRUE(apply_palette_dither_ex(src, formats[f], frame, W, H, pal, config).success);
+                    }
+                }
+                
+                DitherResult result = dither_end();
+                TEST_ASSERT_TRUE(result.success);
+                TEST_ASSERT_FALSE(dither_stream_active());
+                TEST_ASSERT_EQUAL(W * H, result.processedPixels);
+                TEST_ASSERT_EQUAL(expected.outputBytes, result.outputBytes);
+                TEST_ASSERT_EQUAL(expected.outputBytes, cap.written);
+                TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, streamed, expected.outputBytes);
+            }
+        }
+    }
+    
+    // A sink abort fails the remaining pushes and is reported by dither_end()
+    StreamCapture cap = { streamed, 0, 0, 3 };
+    DitherConfig config(DitherAlgorithm::FLOYD_STEINBERG);
+    TEST_ASSERT_TRUE(dither_begin(W, SourceFormat::GRAYSCALE, pal, config, stream_capture_sink, &cap).success);
+    TEST_ASSERT_FALSE(dither_begin(W, SourceFormat::GRAYSCALE, pal, config, stream_capture_sink, &cap).success);
+    TEST_ASSERT_TRUE(dither_push_row(src));
+    TEST_ASSERT_TRUE(dither_push_row(src + W));
+    TEST_ASSERT_FALSE(dither_push_row(src + 2 * W));
+    TEST_ASSERT_FALSE(dither_push_row(src + 3 * W));
+    TEST_ASSERT_EQUAL(3, cap.calls);
+    TEST_ASSERT_FALSE(dither_end().success);
+    TEST_ASSERT_FALSE(dither_end().success);
+}
+
+// =============================================================================
+// Test: Area Resampler
+// =============================================================================
+
+void test_Resample_FlatImageIsExact() {
+    // Non-integer ratios split source pixels between cells; a flat image must
+    // still come out exactly flat, in every source format
+    static uint8_t src[320 * 240 * 3];
+    static uint8_t dst[64 * 64];
+    const ResampleFormat formats[] = {
+        ResampleFormat::GRAY, ResampleFormat::YUV422, ResampleFormat::RGB888
+    };
+    const int sizes[][2] = { { 320, 240 }, { 317, 237 }, { 64, 64 }, { 100, 65 } };
+    
+    for (int f = 0; f < 3; ++f) {
+        for (int s = 0; s < 4; ++s) {
+            const int w = sizes[s][0];
+            const int h = sizes[s][1];
+            const int bpp = resample_bytes_per_pixel(formats[f]);
+            memset(src, 173, sizeof(src));
+            
+            TEST_ASSERT_TRUE(resample_area(src, w * bpp, formats[f], w, h, dst, 64, 64, 64));
+            for (int i = 0; i < 64 * 64; ++i) {
+                TEST_ASSERT_EQUAL_UINT8(173, dst[i]);
+            }
+        }
+    }
+    
+    // Upscaling and oversized destinations are rejected
+    TEST_ASSERT_FALSE(resample_area(src, 32, ResampleFormat::GRAY, 32, 32, dst, 64, 64, 64));
+    TEST_ASSERT_FALSE(resample_area(src, 317, ResampleFormat::GRAY, 317, 237, dst,
+                                    RESAMPLE_MAX_DST_WIDTH + 1, 1, RESAMPLE_MAX_DST_WIDTH + 1));
+}
+
+void test_Resample_KeepsRemainderRows() {
+    // 240 / 64 = 3.75: the bottom 48 rows used to be dropped by integer blocks
+    static uint8_t src[320 * 240];
+    static uint8_t dst[64 * 64];
+    memset(src, 0, sizeof(src));
+    memset(src + 236 * 320, 255, 4 * 320);  // Last 4 rows white
+    
+    TEST_ASSERT_TRUE(resample_area(src, 320, ResampleFormat::GRAY, 320, 240, dst, 64, 64, 64));
+    
+    // Destination row 63 covers source rows 236.25..240 (all white); row 62
+    // covers 232.5..236.25 and gets the shared quarter of row 236
+    for (int x = 0; x < 64; ++x) {
+        TEST_ASSERT_EQUAL_UINT8(255, dst[63 * 64 + x]);
+        TEST_ASSERT_EQUAL_UINT8(17, dst[62 * 64 + x]);   // 0.25 / 3.75 of 255
+        TEST_ASSERT_EQUAL_UINT8(0, dst[61 * 64 + x]);
+    }
+    
+    // Streaming rows gives the same result as the one-shot call
+    // ...and can histogram its output on the way
+    static uint8_t streamed[64 * 64];
+    static uint32_t hist[256];
+    AreaResampler rs;
+    rs.set_histogram(hist);
+    TEST_ASSERT_TRUE(rs.begin(320, 240, ResampleFormat::GRAY, streamed, 64, 64, 64));
+    for (int y = 0; y < 240; ++y) {
+        TEST_ASSERT_FALSE(rs.done());
+        TEST_ASSERT_TRUE(rs.push_row(src + y * 320));
+    }
+    TEST_ASSERT_TRUE(rs.done());
+    TEST_ASSERT_FALSE(rs.push_row(src));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(dst, streamed, sizeof(dst));
+    TEST_ASSERT_EQUAL_UINT32(62 * 64, hist[0]);
+    TEST_ASSERT_EQUAL_UINT32(64, hist[17]);
+    TEST_ASSERT_EQUAL_UINT32(64, hist[255]);
+}
+
 // =============================================================================
 // Test: Floyd-Steinberg Stability
 // =============================================================================
@@ -303,6 +763,76 @@ void test_ApplyDither_RGB888Format() {
     TEST_ASSERT_TRUE(validate_indices_range(s_outputIndices, TEST_PIXELS));
 }
 
+// =============================================================================
+// Test: YUV422 Format (native sensor luma)
+// =============================================================================
+
+void test_ApplyDither_YUV422MatchesGrayscale() {
+    palette_init();
+    dither_init();
+    
+    generate_gradient_pattern();
+    
+    // Interleave Y0 U Y1 V with chroma that must be ignored
+    static uint8_t yuv[TEST_PIXELS * 2];
+    for (int i = 0; i < TEST_PIXELS; ++i) {
+        yuv[i * 2 + 0] = s_grayGradient[i];
+        yuv[i * 2 + 1] = (i & 1) ? 0xF0 : 0x10;
+    }
+    
+    const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
+    static uint8_t grayIndices[TEST_PIXELS];
+    
+    DitherResult grayResult = apply_palette_dither(
+        s_grayGradient, SourceFormat::GRAYSCALE,
+        grayIndices, TEST_WIDTH, TEST_HEIGHT,
+        pal, DitherAlgorithm::ORDERED_8X8
+    );
+    DitherResult yuvResult = apply_palette_dither(
+        yuv, SourceFormat::YUV422,
+        s_outputIndices, TEST_WIDTH, TEST_HEIGHT,
+        pal, DitherAlgorithm::ORDERED_8X8
+    );
+    
+    TEST_ASSERT_TRUE(grayResult.success);
+    TEST_ASSERT_TRUE(yuvResult.success);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(grayIndices, s_outputIndices, TEST_PIXELS);
+}
+
+void test_ApplyDither_RGB565SensorOrderMatchesNative() {
+    palette_init();
+    dither_init();
+    
+    // Same pixels as native uint16_t and as camera bytes (high byte first)
+    static uint16_t native[TEST_PIXELS];
+    static uint8_t sensor[TEST_PIXELS * 2];
+    for (int i = 0; i < TEST_PIXELS; ++i) {
+        const uint16_t px = static_cast<uint16_t>(i * 2654435761u >> 16);
+        native[i] = px;
+        sensor[i * 2 + 0] = static_cast<uint8_t>(px >> 8);
+        sensor[i * 2 + 1] = static_cast<uint8_t>(px & 0xFF);
+    }
+    
+    const Palette& pal = palette_get(PaletteType::GB_CLASSIC);
+    static uint8_t nativeIndices[TEST_PIXELS];
+    const DitherAlgorithm algos[] = { DitherAlgorithm::ORDERED_8X8, DitherAlgorithm::ATKINSON };
+    
+    for (DitherAlgorithm algo : algos) {
+        DitherResult nativeResult = apply_palette_dither(
+            reinterpret_cast<const uint8_t*>(native), SourceFormat::RGB565,
+            nativeIndices, TEST_WIDTH, TEST_HEIGHT, pal, algo
+        );
+        DitherResult sensorResult = apply_palette_dither(
+            sensor, SourceFormat::RGB565_BE,
+            s_outputIndices, TEST_WIDTH, TEST_HEIGHT, pal, algo
+        );
+        
+        TEST_ASSERT_TRUE(nativeResult.success);
+        TEST_ASSERT_TRUE(sensorResult.success);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(nativeIndices, s_outputIndices, TEST_PIXELS);
+    }
+}
+
 // =============================================================================
 // Test: Parameter Validation
 // =============================================================================
@@ -377,13 +907,17 @@ void test_IndicesToGrayscale() {
 void test_SourceFormatBpp() {
     TEST_ASSERT_EQUAL(1, source_format_bpp(SourceFormat::GRAYSCALE));
     TEST_ASSERT_EQUAL(2, source_format_bpp(SourceFormat::RGB565));
+    TEST_ASSERT_EQUAL(2, source_format_bpp(SourceFormat::RGB565_BE));
     TEST_ASSERT_EQUAL(3, source_format_bpp(SourceFormat::RGB888));
+    TEST_ASSERT_EQUAL(2, source_format_bpp(SourceFormat::YUV422));
 }
 
 void test_SourceFormatName() {
     TEST_ASSERT_EQUAL_STRING("Grayscale", source_format_name(SourceFormat::GRAYSCALE));
     TEST_ASSERT_EQUAL_STRING("RGB565", source_format_name(SourceFormat::RGB565));
+    TEST_ASSERT_EQUAL_STRING("RGB565 BE", source_format_name(SourceFormat::RGB565_BE));
     TEST_ASSERT_EQUAL_STRING("RGB888", source_format_name(SourceFormat::RGB888));
+    TEST_ASSERT_EQUAL_STRING("YUV422", source_format_name(SourceFormat::YUV422));
 }
 
 // =============================================================================
@@ -448,10 +982,11 @@ void test_AllAlgorithms_ProduceValidOutput() {
         DitherAlgorithm::ORDERED_8X8,
         DitherAlgorithm::ORDERED_4X4,
         DitherAlgorithm::FLOYD_STEINBERG,
-        DitherAlgorithm::ATKINSON
+        DitherAlgorithm::ATKINSON,
+        DitherAlgorithm::BLUE_NOISE
     };
     
-    for (int i = 0; i < 4; ++i) {
+    for (int i = 0; i < 5; ++i) {
         memset(s_outputIndices, 0xFF, sizeof(s_outputIndices));
         
         DitherResult result = apply_palette_dither(
@@ -497,6 +1032,16 @@ void setup() {
     // Ordered dithering tests
     RUN_TEST(test_ApplyOrdered8x8_MapsIndices);
     RUN_TEST(test_ApplyOrdered4x4_MapsIndices);
+    RUN_TEST(test_Ordered_WordPathMatchesScalar);
+    RUN_TEST(test_Ordered_StrengthChangeRebuildsThresholds);
+    RUN_TEST(test_BlueNoise_WordPathMatchesScalar);
+    RUN_TEST(test_BlueNoise_FlatGrayMatchesBayerTone);
+    RUN_TEST(test_Ordered_ParallelMatchesSerial);
+    RUN_TEST(test_ErrorDiffusion_ParallelMatchesSerial);
+    RUN_TEST(test_Output_PackedMatchesIndices);
+    RUN_TEST(test_Stream_MatchesWholeFrame);
+    RUN_TEST(test_Resample_FlatImageIsExact);
+    RUN_TEST(test_Resample_KeepsRemainderRows);
     
     // Error diffusion stability tests
     RUN_TEST(test_ApplyFloydSteinberg_Stability);
@@ -504,6 +1049,8 @@ void setup() {
     
     // Format conversion test
     RUN_TEST(test_ApplyDither_RGB888Format);
+    RUN_TEST(test_ApplyDither_YUV422MatchesGrayscale);
+    RUN_TEST(test_ApplyDither_RGB565SensorOrderMatchesNative);
     
     // Parameter validation tests
     RUN_TEST(test_ApplyDither_NullSrc);
@@ -539,9 +1086,21 @@ int main(int argc, char** argv) {
     RUN_TEST(test_DitherAlgorithmNames);
     RUN_TEST(test_ApplyOrdered8x8_MapsIndices);
     RUN_TEST(test_ApplyOrdered4x4_MapsIndices);
+    RUN_TEST(test_Ordered_WordPathMatchesScalar);
+    RUN_TEST(test_Ordered_StrengthChangeRebuildsThresholds);
+    RUN_TEST(test_BlueNoise_WordPathMatchesScalar);
+    RUN_TEST(test_BlueNoise_FlatGrayMatchesBayerTone);
+    RUN_TEST(test_Ordered_ParallelMatchesSerial);
+    RUN_TEST(test_ErrorDiffusion_ParallelMatchesSerial);
+    RUN_TEST(test_Output_PackedMatchesIndices);
+    RUN_TEST(test_Stream_MatchesWholeFrame);
+    RUN_TEST(test_Resample_FlatImageIsExact);
+    RUN_TEST(test_Resample_KeepsRemainderRows);
     RUN_TEST(test_ApplyFloydSteinberg_Stability);
     RUN_TEST(test_ApplyAtkinson_Stability);
     RUN_TEST(test_ApplyDither_RGB888Format);
+    RUN_TEST(test_ApplyDither_YUV422MatchesGrayscale);
+    RUN_TEST(test_ApplyDither_RGB565SensorOrderMatchesNative);
     RUN_TEST(test_ApplyDither_NullSrc);
     RUN_TEST(test_ApplyDither_NullDst);
     RUN_TEST(test_ApplyDither_InvalidDimensions);
@@ -121,8 +121,8 @@ void test_timelapse_presets() {
 // =============================================================================
 
 void test_dither_algorithm_count() {
-    // DitherAlgorithm enum: ORDERED_8X8, ORDERED_4X4, FLOYD_STEINBERG, ATKINSON, COUNT=4
-    TEST_ASSERT_EQUAL(4, static_cast<uint8_t>(pxlcam::filters::DitherAlgorithm::COUNT));
+    // DitherAlgorithm enum: ORDERED_8X8, ORDERED_4X4, FLOYD_STEINBERG, ATKINSON, BLUE_NOISE, COUNT=5
+    TEST_ASSERT_EQUAL(5, static_cast<uint8_t>(pxlcam::filters::DitherAlgorithm::COUNT));
 }
 
 void test_dither_config_defaults() {
@@ -158,6 +158,106 @@ void test_postprocess_filter_name() {
     TEST_ASSERT_NOT_NULL(name);
 }
 
+void test_postprocess_chain_fuses_pointwise_filters() {
+    using namespace pxlcam::filters;
+    postprocess_init();
+    
+    PostProcessConfig config;
+    config.filterCount = 3;
+    config.filters[0] = FilterParams(FilterType::GAMMA_CORRECTION, true, 1.0f);
+    config.filters[0].param1 = 0.8f;
+    config.filters[1] = FilterParams(FilterType::CONTRAST, true, 1.3f);
+    config.filters[2] = FilterParams(FilterType::HISTOGRAM_EQ, true, 1.0f);
+    
+    // The whole chain is one table, finished from the frame histogram
+    const ChainProgram& program = postprocess_compile(config);
+    TEST_ASSERT_EQUAL(1, program.stepCount);
+    TEST_ASSERT_TRUE(program.steps[0].lut);
+    TEST_ASSERT_TRUE(program.steps[0].needsHistogram);
+    
+    uint8_t fused[256];
+    uint8_t separate[256];
+    for (int i = 0; i < 256; i++) {
+        fused[i] = separate[i] = (uint8_t)((i * 7) / 9);
+    }
+    postprocess_set_config(config);
+    TEST_ASSERT_TRUE(apply_postprocess_chain(fused, 16, 16));
+    
+    filter_gamma(separate, 16, 16, 0.8f);
+    filter_contrast(separate, 16, 16, 1.3f);
+    filter_histogram_eq(separate, 16, 16);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(separate, fused, 256);
+}
+
+void test_postprocess_denoise_removes_impulses() {
+    using namespace pxlcam::filters;
+    
+    // Salt pixels, one in a corner: a 3x3 median takes all of them out
+    uint8_t image[8 * 6];
+    memset(image, 100, sizeof(image));
+    image[0] = 255;
+    image[2 * 8 + 3] = 0;
+    image[5 * 8 + 7] = 255;
+    filter_denoise(image, 8, 6, 1.0f);
+    for (size_t i = 0; i < sizeof(image); i++) {
+        TEST_ASSERT_EQUAL_UINT8(100, image[i]);
+    }
+}
+
+struct ChainRows {
+    uint8_t* image;
+    int w;
+    int next;       // Rows must come out in order
+};
+
+static bool collectChainRow(void* user, const uint8_t* row, int y) {
+    ChainRows* rows = static_cast<ChainRows*>(user);
+    if (y != rows->next++) return false;
+    memcpy(rows->image + y * rows->w, row, rows->w);
+    return true;
+}
+
+void test_postprocess_row_chain_matches_frame_chain() {
+    using namespace pxlcam::filters;
+    postprocess_init();
+    
+    PostProcessConfig config;
+    config.filterCount = 4;
+    config.filters[0] = FilterParams(FilterType::SHARPEN, true, 0.5f);
+    config.filters[1] = FilterParams(FilterType::GAMMA_CORRECTION, true, 1.0f);
+    config.filters[1].param1 = 0.8f;
+    config.filters[2] = FilterParams(FilterType::DENOISE, true, 1.0f);
+    config.filters[3] = FilterParams(FilterType::VIGNETTE, true, 0.5f);
+    config.filters[3].param1 = 0.5f;
+    
+    const int w = 12;
+    const int h = 9;
+    uint8_t source[w * h];
+    for (int i = 0; i < w * h; i++) {
+        source[i] = (uint8_t)((i * 37) ^ (i >> 2));
+    }
+    uint8_t frame[w * h];
+    memcpy(frame, source, sizeof(frame));
+    postprocess_set_config(config);
+    TEST_ASSERT_TRUE(apply_postprocess_chain(frame, w, h));
+    
+    // Two windows: every row comes out two rows after it went in
+    uint8_t storage[512];
+    TEST_ASSERT_TRUE(RowChain::storage_bytes(config, w) <= sizeof(storage));
+    uint8_t streamed[w * h];
+    ChainRows rows = {streamed, w, 0};
+    RowChain chain;
+    TEST_ASSERT_TRUE(chain.begin(config, w, h, storage, sizeof(storage), nullptr, 0,
+                                 collectChainRow, &rows));
+    TEST_ASSERT_EQUAL(2, chain.latency());
+    for (int y = 0; y < h; y++) {
+        TEST_ASSERT_TRUE(chain.push(source + y * w));
+    }
+    TEST_ASSERT_TRUE(chain.finish());
+    TEST_ASSERT_EQUAL(h, rows.next);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, streamed, w * h);
+}
+
 // =============================================================================
 // Test Runner
 // =============================================================================
@@ -196,6 +296,9 @@ void setup() {
     // PostProcess tests
     RUN_TEST(test_postprocess_init);
     RUN_TEST(test_postprocess_filter_name);
+    RUN_TEST(test_postprocess_chain_fuses_pointwise_filters);
+    RUN_TEST(test_postprocess_denoise_removes_impulses);
+    RUN_TEST(test_postprocess_row_chain_matches_frame_chain);
     
     UNITY_END();
 }
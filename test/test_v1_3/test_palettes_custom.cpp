@@ -400,6 +400,38 @@ void test_MapIndex_ReturnsCorrectIndex(void) {
     TEST_ASSERT_EQUAL_UINT8(1, palette_map_index(0x55, pal));
 }
 
+/**
+ * @brief Test cached LUTs match the distance search and follow custom edits
+ */
+void test_PaletteLut_MatchesSearchAndRebuilds(void) {
+    palette_init();
+    
+    PaletteLut scratch;
+    for (uint8_t p = 0; p < palette_get_count(); ++p) {
+        const Palette& pal = palette_get_by_index(p);
+        const PaletteLut& lut = palette_lut(pal, scratch);
+        TEST_ASSERT_TRUE(&lut != &scratch);  // Registry palettes are cached
+        
+        // A local copy is not cached, so it maps by distance search
+        const Palette copy = pal;
+        for (int v = 0; v < 256; ++v) {
+            TEST_ASSERT_EQUAL_UINT8(palette_map_index(v, copy), lut.index[v]);
+            TEST_ASSERT_EQUAL_UINT8(palette_map_value(v, copy), lut.tone[v]);
+        }
+    }
+    
+    uint8_t tones[PALETTE_TONE_COUNT] = { 10, 50, 100, 200 };
+    TEST_ASSERT_TRUE(palette_set_custom(PaletteType::CUSTOM_2, tones, "LutTest"));
+    
+    const Palette& custom = palette_get(PaletteType::CUSTOM_2);
+    TEST_ASSERT_EQUAL_UINT8(3, palette_map_index(255, custom));
+    TEST_ASSERT_EQUAL_UINT8(200, palette_map_value(255, custom));
+    TEST_ASSERT_EQUAL_UINT8(1, palette_map_index(70, custom));
+    TEST_ASSERT_EQUAL_UINT8(50, palette_lut(custom, scratch).tone[74]);
+    
+    palette_reset_custom(PaletteType::CUSTOM_2);
+}
+
 // =============================================================================
 // JSON Parsing Edge Cases (simulation)
 // =============================================================================
@@ -487,6 +519,7 @@ int main(int argc, char** argv) {
     // Tone mapping
     RUN_TEST(test_MapValue_FindsClosestTone);
     RUN_TEST(test_MapIndex_ReturnsCorrectIndex);
+    RUN_TEST(test_PaletteLut_MatchesSearchAndRebuilds);
     
     // Edge cases
     RUN_TEST(test_CustomPalette_EdgeCaseTones);